@@ -5,6 +5,8 @@ layout(location = 1) in vec3 a_Normal;
 layout(location = 2) in vec2 a_TexCoord; 
 layout(location = 3) in vec3 a_Tangent;  
 
+#include "vertex_decode.glsl"
+
 struct PerDrawData 
 {
     mat4 modelMatrix;
@@ -33,13 +35,14 @@ flat out uint v_MaterialIndex;
 
 void main() 
 {
-    PerDrawData data = perDrawData[gl_DrawID];
+    PerDrawData data = perDrawData[gl_BaseInstance + gl_InstanceID];
     mat4 modelMatrix = data.modelMatrix;
     v_MaterialIndex = data.materialIndex;
 
     mat3 normalMatrix = mat3(transpose(inverse(modelMatrix)));
 
-    v_Normal = normalize(normalMatrix * a_Normal);
+    vec3 normal = u_CompactVertices ? OctahedralDecode(a_Normal.xy) : a_Normal;
+    v_Normal = normalize(normalMatrix * normal);
     v_CameraPos = cameraPosition.xyz;
     v_TexCoord = a_TexCoord;
 
@@ -0,0 +1,76 @@
+// Baked animation palettes for crowds, written by AnimationBaker. Define BAKED_CLIPS_BINDING and
+// BAKED_PALETTES_BINDING before including. Every joint matrix is stored as the top three rows of
+// the affine transform, as floats or as half floats packed in pairs
+
+struct BakedClip
+{
+    uint firstWord;
+    uint frameCount;
+    uint jointCount;
+    uint format;        // 0 float rows, 1 half float rows
+    float frameRate;
+    float duration;
+    uint pad0;
+    uint pad1;
+};
+
+layout(std430, binding = BAKED_CLIPS_BINDING) readonly buffer BakedClips 
+{
+    BakedClip bakedClips[];
+};
+
+layout(std430, binding = BAKED_PALETTES_BINDING) readonly buffer BakedPalettes 
+{
+    uint bakedPalettes[];
+};
+
+void BakedRows(BakedClip clip, uint frame, uint joint, out vec4 r0, out vec4 r1, out vec4 r2)
+{
+    if (clip.format == 1u)
+    {
+        uint base = clip.firstWord + (frame * clip.jointCount + joint) * 6u;
+        r0 = vec4(unpackHalf2x16(bakedPalettes[base + 0u]), unpackHalf2x16(bakedPalettes[base + 1u]));
+        r1 = vec4(unpackHalf2x16(bakedPalettes[base + 2u]), unpackHalf2x16(bakedPalettes[base + 3u]));
+        r2 = vec4(unpackHalf2x16(bakedPalettes[base + 4u]), unpackHalf2x16(bakedPalettes[base + 5u]));
+    }
+    else
+    {
+        uint base = clip.firstWord + (frame * clip.jointCount + joint) * 12u;
+        r0 = uintBitsToFloat(uvec4(bakedPalettes[base + 0u], bakedPalettes[base + 1u], bakedPalettes[base + 2u], bakedPalettes[base + 3u]));
+        r1 = uintBitsToFloat(uvec4(bakedPalettes[base + 4u], bakedPalettes[base + 5u], bakedPalettes[base + 6u], bakedPalettes[base + 7u]));
+        r2 = uintBitsToFloat(uvec4(bakedPalettes[base + 8u], bakedPalettes[base + 9u], bakedPalettes[base + 10u], bakedPalettes[base + 11u]));
+    }
+}
+
+// Weighted skinning matrix for four joints, blending the two baked frames either side of time.
+// Matches AnimationBaker::Sample
+mat4 BakedSkinningMatrix(uint clipIndex, float time, ivec4 joints, vec4 weights)
+{
+    BakedClip clip = bakedClips[clipIndex];
+
+    float frame = 0.0;
+    if (clip.frameCount > 1u && clip.duration > 0.0)
+        frame = mod(time, clip.duration) * clip.frameRate;
+
+    uint f0 = min(uint(frame), clip.frameCount - 1u);
+    uint f1 = min(f0 + 1u, clip.frameCount - 1u);
+    float blend = frame - float(f0);
+
+    vec4 r0 = vec4(0.0), r1 = vec4(0.0), r2 = vec4(0.0);
+    for (int i = 0; i < 4; ++i)
+    {
+        vec4 a0, a1, a2, b0, b1, b2;
+        BakedRows(clip, f0, uint(joints[i]), a0, a1, a2);
+        BakedRows(clip, f1, uint(joints[i]), b0, b1, b2);
+        r0 += weights[i] * mix(a0, b0, blend);
+        r1 += weights[i] * mix(a1, b1, blend);
+        r2 += weights[i] * mix(a2, b2, blend);
+    }
+
+    // rows to glsl's column major matrix
+    return mat4(
+        vec4(r0.x, r1.x, r2.x, 0.0),
+        vec4(r0.y, r1.y, r2.y, 0.0),
+        vec4(r0.z, r1.z, r2.z, 0.0),
+        vec4(r0.w, r1.w, r2.w, 1.0));
+}
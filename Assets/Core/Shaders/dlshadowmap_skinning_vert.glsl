@@ -12,6 +12,8 @@ struct SkinnedMeshPerDrawData
     mat4 modelMatrix;
     uint materialIndex;
     uint baseJointIndex;
+    uint bakedClip;         // 1 + baked clip index, 0 uses the joint palette
+    float bakedTimeOffset;
 };
 
 layout(std430, binding = 0) readonly buffer SkinnedMeshPerDrawDataBuffer 
@@ -24,21 +26,34 @@ layout(std430, binding = 1) readonly buffer GlobalTransforms
     mat4 globalTransforms[];
 };
 
+#define BAKED_CLIPS_BINDING 2
+#define BAKED_PALETTES_BINDING 3
+#include "baked_skinning.glsl"
+
 uniform mat4 u_LightSpaceMatrix;
+uniform float u_Time;
 
 void main() 
 {
-    SkinnedMeshPerDrawData data = perDrawData[gl_DrawID + gl_InstanceID];
+    SkinnedMeshPerDrawData data = perDrawData[gl_BaseInstance + gl_InstanceID];
     mat4 modelMatrix = data.modelMatrix;
 
     float weightSum = a_Weights.x + a_Weights.y + a_Weights.z + a_Weights.w;
     vec4 normalizedWeights = a_Weights / weightSum;
 
-    mat4 skinningMatrix =
-        normalizedWeights.x * globalTransforms[data.baseJointIndex + a_Joints.x] +
-        normalizedWeights.y * globalTransforms[data.baseJointIndex + a_Joints.y] +
-        normalizedWeights.z * globalTransforms[data.baseJointIndex + a_Joints.z] +
-        normalizedWeights.w * globalTransforms[data.baseJointIndex + a_Joints.w];
+    mat4 skinningMatrix;
+    if (data.bakedClip != 0u)
+    {
+        skinningMatrix = BakedSkinningMatrix(data.bakedClip - 1u, u_Time + data.bakedTimeOffset, a_Joints, normalizedWeights);
+    }
+    else
+    {
+        skinningMatrix =
+            normalizedWeights.x * globalTransforms[data.baseJointIndex + a_Joints.x] +
+            normalizedWeights.y * globalTransforms[data.baseJointIndex + a_Joints.y] +
+            normalizedWeights.z * globalTransforms[data.baseJointIndex + a_Joints.z] +
+            normalizedWeights.w * globalTransforms[data.baseJointIndex + a_Joints.w];
+    }
 
     vec4 worldPosition = skinningMatrix * vec4(a_Position, 1.0);
 
@@ -17,7 +17,8 @@ uniform mat4 u_LightSpaceMatrix;
 
 void main() 
 {
-    PerDrawData data = perDrawData[gl_DrawID + gl_InstanceID];
+    // baseInstance carries the per draw index so culled command lists can be compacted
+    PerDrawData data = perDrawData[gl_BaseInstance + gl_InstanceID];
     mat4 modelMatrix = data.modelMatrix;
 
     gl_Position = u_LightSpaceMatrix * modelMatrix * vec4(a_Position, 1.0);
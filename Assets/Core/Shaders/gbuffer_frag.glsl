@@ -89,8 +89,9 @@ vec3 getNormal(MaterialGPU material)
     bool hasTex = (material.normalHandle.x != 0 || material.normalHandle.y != 0);
     if (hasTex) 
     {
-        vec3 normalTex = texture(sampler2D(material.normalHandle), v_TexCoord).rgb;
-        normalTex = normalTex * 2.0 - 1.0; // Map [0, 1] to [-1, 1]
+        // z is rebuilt from xy so two channel (BC5) normal maps read the same as RGB ones
+        vec2 normalXY = texture(sampler2D(material.normalHandle), v_TexCoord).rg * 2.0 - 1.0; // Map [0, 1] to [-1, 1]
+        vec3 normalTex = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
         mat3 TBN = mat3(normalize(v_Tangent), normalize(v_Bitangent), normalize(v_Normal));
         return normalize(TBN * normalTex);
     }
@@ -7,6 +7,8 @@ layout(location = 1) in vec3 a_Normal;
 layout(location = 2) in vec2 a_TexCoord; 
 layout(location = 3) in vec3 a_Tangent;  
 
+#include "vertex_decode.glsl"
+
 struct MaterialGPU 
 {
     vec4 baseColorFactor;
@@ -77,7 +79,8 @@ flat out uint v_MaterialIndex;
 
 void main() 
 {
-    PerDrawData data = perDrawData[gl_DrawID + gl_InstanceID];
+    // baseInstance carries the per draw index so culled command lists can be compacted
+    PerDrawData data = perDrawData[gl_BaseInstance + gl_InstanceID];
     mat4 modelMatrix = data.modelMatrix;
     v_MaterialIndex = data.materialIndex;
 
@@ -86,8 +89,16 @@ void main()
 
     mat3 normalMatrix = mat3(transpose(inverse(modelMatrix)));
 
-    v_Normal = normalize(normalMatrix * a_Normal);
-    v_Tangent = normalize(normalMatrix  * a_Tangent);
+    vec3 normal = a_Normal;
+    vec3 tangent = a_Tangent;
+    if (u_CompactVertices)
+    {
+        normal = OctahedralDecode(a_Normal.xy);
+        tangent = DecodeCompactTangent(a_Tangent.xy).xyz;
+    }
+
+    v_Normal = normalize(normalMatrix * normal);
+    v_Tangent = normalize(normalMatrix  * tangent);
     v_Bitangent = normalize(cross(v_Normal, v_Tangent)); 
 
     v_TexCoord = a_TexCoord;
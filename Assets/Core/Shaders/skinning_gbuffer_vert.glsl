@@ -12,6 +12,8 @@ struct SkinnedMeshPerDrawData
     mat4 modelMatrix;
     uint materialIndex;
     uint baseJointIndex;
+    uint bakedClip;         // 1 + baked clip index, 0 uses the joint palette
+    float bakedTimeOffset;
 };
 
 layout(std430, binding = 1) readonly buffer SkinnedMeshPerDrawDataBuffer 
@@ -35,6 +37,10 @@ layout(std140, binding = 2) uniform ShaderGlobalData
     int frameCount;
 };
 
+#define BAKED_CLIPS_BINDING 4
+#define BAKED_PALETTES_BINDING 5
+#include "baked_skinning.glsl"
+
 out vec3 v_WorldPos;
 out vec3 v_Normal;
 out vec2 v_TexCoord;
@@ -45,7 +51,7 @@ flat out uint v_MaterialIndex;
 
 void main() 
 {
-    SkinnedMeshPerDrawData data = perDrawData[gl_DrawID + gl_InstanceID];
+    SkinnedMeshPerDrawData data = perDrawData[gl_BaseInstance + gl_InstanceID];
     mat4 modelMatrix = data.modelMatrix;
     v_MaterialIndex = data.materialIndex;
 
@@ -61,12 +67,21 @@ void main()
         return;
     }
 
-    // use the per draw data baseJointIndex to offset into the joint array
-    mat4 skinningMatrix =
-        normalizedWeights.x * globalTransforms[data.baseJointIndex + a_Joints.x] +
-        normalizedWeights.y * globalTransforms[data.baseJointIndex + a_Joints.y] +
-        normalizedWeights.z * globalTransforms[data.baseJointIndex + a_Joints.z] +
-        normalizedWeights.w * globalTransforms[data.baseJointIndex + a_Joints.w];
+    mat4 skinningMatrix;
+    if (data.bakedClip != 0u)
+    {
+        // crowd instance, timeInfo.y is the global time
+        skinningMatrix = BakedSkinningMatrix(data.bakedClip - 1u, timeInfo.y + data.bakedTimeOffset, a_Joints, normalizedWeights);
+    }
+    else
+    {
+        // use the per draw data baseJointIndex to offset into the joint array
+        skinningMatrix =
+            normalizedWeights.x * globalTransforms[data.baseJointIndex + a_Joints.x] +
+            normalizedWeights.y * globalTransforms[data.baseJointIndex + a_Joints.y] +
+            normalizedWeights.z * globalTransforms[data.baseJointIndex + a_Joints.z] +
+            normalizedWeights.w * globalTransforms[data.baseJointIndex + a_Joints.w];
+    }
 
     vec4 worldPosition = skinningMatrix * vec4(a_Position, 1.0);
     v_WorldPos = (modelMatrix * worldPosition).xyz;
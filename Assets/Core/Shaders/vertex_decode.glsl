@@ -0,0 +1,21 @@
+// Decode for vertices in the compact format, see VertexQuantization. Normals and tangents arrive
+// as normalized GL_SHORT pairs holding octahedral coordinates, the half float texture coordinates
+// need nothing. Shaders that draw both formats switch on u_CompactVertices
+
+uniform bool u_CompactVertices;
+
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec4 DecodeCompactTangent(vec2 e)
+{
+    // the handedness is the lowest bit of the second snorm value
+    int y = int(round(e.y * 32767.0));
+    return vec4(OctahedralDecode(e), (y & 1) != 0 ? -1.0 : 1.0);
+}
@@ -2,6 +2,7 @@
 #define ANIM_DATA_H
 
 #include "Resource.h"
+#include "KeyframeSampler.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
@@ -12,25 +13,14 @@
 
 namespace JLEngine
 {
-    enum TargetPath
-    {
-        TRANSLATION,
-        ROTATION,
-        SCALE
-    };
-
-    enum class InterpolationType
-    {
-        LINEAR = 0,
-        CUBIC = 1,
-    };
-
     static InterpolationType InterpolationFromString(const std::string& interpolation)
     {
         if (interpolation == "LINEAR")
             return InterpolationType::LINEAR;
-        if (interpolation == "CUBIC")
-            return InterpolationType::CUBIC;
+        if (interpolation == "STEP")
+            return InterpolationType::STEP;
+        if (interpolation == "CUBICSPLINE")
+            return InterpolationType::CUBICSPLINE;
         else
             return InterpolationType::LINEAR;
     }
@@ -68,9 +58,17 @@ namespace JLEngine
         const std::vector<float>& GetTimes() const { return m_times; }
         const std::vector<glm::vec4>& GetValues() const { return m_values; }
         const InterpolationType GetInterpolation() const { return m_interpolation; }
+        // CUBICSPLINE only, one per key
+        const std::vector<glm::vec4>& GetInTangents() const { return m_inTangents; }
+        const std::vector<glm::vec4>& GetOutTangents() const { return m_outTangents; }
 
         void SetTimes(std::vector<float>&& inputTimes) { m_times = std::move(inputTimes); }
         void SetValues(std::vector<glm::vec4>&& outputValues) { m_values = std::move(outputValues); }
+        void SetTangents(std::vector<glm::vec4>&& inTangents, std::vector<glm::vec4>&& outTangents)
+        {
+            m_inTangents = std::move(inTangents);
+            m_outTangents = std::move(outTangents);
+        }
         void SetInterpolation(const InterpolationType interpolation) { m_interpolation = interpolation; }
 
     private:
@@ -78,6 +76,8 @@ namespace JLEngine
         int m_currentIndex = 0;
         std::vector<float> m_times;         
         std::vector<glm::vec4> m_values;   
+        std::vector<glm::vec4> m_inTangents;
+        std::vector<glm::vec4> m_outTangents;
         InterpolationType m_interpolation = InterpolationType::LINEAR;
     };
 
@@ -120,6 +120,8 @@ namespace JLEngine
 
         void CalcDuration()
         {
+            if (m_sourceReleased) return;
+
             float maxTime = 0.0f;
             for (const auto& sampler : GetSamplers())
             {
@@ -131,16 +133,42 @@ namespace JLEngine
             m_duration = maxTime;
         }
         float GetDuration() { return m_duration; }
+        // For animations restored with SetKeyframes, CalcDuration has no keys to read then
+        void SetDuration(float duration) { m_duration = duration; }
 
         void PrecomputeSamplers()
         {
+            if (m_sourceReleased) return;
+
             m_precomputedSamplers.clear();
             m_precomputedSamplers.reserve(m_channels.size());
+            m_keyframes.Clear();
             for (const auto& channel : m_channels)
             {
-                m_precomputedSamplers.push_back(&m_samplers[channel.GetSamplerIndex()]);
+                const auto& sampler = m_samplers[channel.GetSamplerIndex()];
+                m_precomputedSamplers.push_back(&sampler);
+                m_keyframes.AddChannel(channel.GetTargetPath(), sampler.GetInterpolation(), sampler.GetTimes(),
+                    sampler.GetValues(), sampler.GetInTangents(), sampler.GetOutTangents());
+            }
+        }
+
+        // Every channel's keys packed for sampling, in channel order. Built by PrecomputeSamplers
+        const KeyframeSampler& GetKeyframes() const { return m_keyframes; }
+        void SetKeyframes(KeyframeSampler&& keyframes) { m_keyframes = std::move(keyframes); }
+
+        // Drops the samplers' keys once the keyframes are built (and usually compressed), leaving the
+        // keyframes as the only copy. PrecomputeSamplers and CalcDuration keep what they have from then on
+        void ReleaseSourceKeys()
+        {
+            for (auto& sampler : m_samplers)
+            {
+                sampler.SetTimes({});
+                sampler.SetValues({});
+                sampler.SetTangents({}, {});
             }
+            m_sourceReleased = true;
         }
+        bool IsSourceReleased() const { return m_sourceReleased; }
 
         const std::vector<const AnimationSampler*>& GetPrecomputedSamplers() const
         {
@@ -167,6 +195,8 @@ namespace JLEngine
 
     private:
         std::vector<const AnimationSampler*> m_precomputedSamplers;
+        KeyframeSampler m_keyframes;
+        bool m_sourceReleased = false;
         float m_duration = 0.0f;
         std::string m_name;                           // Animation name
         std::vector<AnimationSampler> m_samplers;     // List of samplers
@@ -2,9 +2,30 @@
 #define ANIM_HELPERS_H
 
 #include "AnimData.h"
+#include "AnimationController.h"
+#include "Node.h"
+
+#include <algorithm>
 
 namespace JLEngine
 {
+	// Working memory for evaluating one skeleton, keep one per thread and reuse it across frames
+	struct AnimationScratch
+	{
+		std::vector<glm::vec3> translations;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::vec3> scales;
+		std::vector<glm::mat4> localTransforms;
+		std::vector<glm::mat4> globalTransforms;
+		KeyframeSampleScratch keyframes;
+		std::vector<glm::vec4> samples;
+		// one layer's clips summed per joint before it is applied, weights are per path (t, r, s)
+		std::vector<glm::vec3> accumTranslations;
+		std::vector<glm::vec4> accumRotations;
+		std::vector<glm::vec3> accumScales;
+		std::vector<glm::vec3> accumWeights;
+	};
+
 	class AnimHelpers
 	{
     public:
@@ -45,49 +66,175 @@ namespace JLEngine
             float currTime,
             std::vector<glm::mat4>& nodeTransforms,
             const std::vector<size_t>& keyframeIndices)
+        {
+            AnimationScratch scratch;
+            EvaluateAnimation(animation, currTime, nodeTransforms, keyframeIndices, scratch);
+        }
+
+        // Same as above with the TRS arrays taken from scratch, no allocation once it has grown to the skeleton
+        static void EvaluateAnimation(Animation& animation,
+            float currTime,
+            std::vector<glm::mat4>& nodeTransforms,
+            const std::vector<size_t>& keyframeIndices,
+            AnimationScratch& scratch)
         {
             const auto& channels = animation.GetChannels();
-            const auto& samplers = animation.GetSamplers();
+            const auto& keyframes = animation.GetKeyframes();
 
-            std::vector<glm::vec3> translations(nodeTransforms.size(), glm::vec3(0.0f));
-            std::vector<glm::quat> rotations(nodeTransforms.size(), glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
-            std::vector<glm::vec3> scales(nodeTransforms.size(), glm::vec3(1.0f));
+            auto& translations = scratch.translations;
+            auto& rotations = scratch.rotations;
+            auto& scales = scratch.scales;
+            translations.assign(nodeTransforms.size(), glm::vec3(0.0f));
+            rotations.assign(nodeTransforms.size(), glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+            scales.assign(nodeTransforms.size(), glm::vec3(1.0f));
 
-            for (size_t channelIndex = 0; channelIndex < channels.size(); ++channelIndex)
+            // every channel sampled in one pass, PrecomputeSamplers builds the keyframes
+            if (keyframes.ChannelCount() == channels.size())
             {
-                const auto& channel = channels[channelIndex];
-                const auto& sampler = samplers[channel.GetSamplerIndex()];
-                const auto& outputValues = sampler.GetValues();
-                const auto& inputTimes = sampler.GetTimes();
-
-                size_t currentIndex = keyframeIndices[channelIndex];
-                size_t nextIndex = (currentIndex + 1 < inputTimes.size()) ? currentIndex + 1 : 0;
+                scratch.samples.resize(channels.size());
+                keyframes.Sample(currTime, keyframeIndices, scratch.keyframes, scratch.samples.data());
 
-                float timeStart = inputTimes[currentIndex];
-                float timeEnd = inputTimes[nextIndex];
-
-                if (nextIndex == 0)
+                for (size_t channelIndex = 0; channelIndex < channels.size(); ++channelIndex)
                 {
-                    timeEnd = inputTimes[nextIndex] + animation.GetDuration();
+                    int targetNode = channels[channelIndex].GetTargetNode();
+                    if (targetNode < 0 || targetNode >= static_cast<int>(nodeTransforms.size())) continue;
+
+                    ApplyKeyframe(channels[channelIndex], scratch.samples[channelIndex], translations, rotations, scales);
                 }
+            }
 
-                float factor = (timeEnd > timeStart) ? (currTime - timeStart) / (timeEnd - timeStart) : 0.0f;
+            for (size_t i = 0; i < nodeTransforms.size(); ++i)
+            {
+                nodeTransforms[i] = glm::translate(glm::mat4(1.0f), translations[i]) *
+                    glm::mat4_cast(rotations[i]) *
+                    glm::scale(glm::mat4(1.0f), scales[i]);
+            }
+        }
 
-                if (nextIndex == currentIndex) 
+        // Skinning palette for one skeleton written straight to jointMatrices (jointCount entries, extra joints are dropped)
+        static void EvaluateJointMatrices(Animation& animation,
+            float currTime,
+            const std::vector<size_t>& keyframeIndices,
+            const Skeleton& skeleton,
+            const std::vector<glm::mat4>& inverseBindMatrices,
+            AnimationScratch& scratch,
+            glm::mat4* jointMatrices,
+            size_t jointCount)
+        {
+            scratch.localTransforms.resize(skeleton.joints.size());
+            EvaluateAnimation(animation, currTime, scratch.localTransforms, keyframeIndices, scratch);
+            ComputeGlobalTransforms(skeleton, scratch.localTransforms, scratch.globalTransforms);
+
+            size_t count = std::min({ jointCount, scratch.globalTransforms.size(), inverseBindMatrices.size() });
+            for (size_t i = 0; i < count; ++i)
+            {
+                jointMatrices[i] = scratch.globalTransforms[i] * inverseBindMatrices[i];
+            }
+        }
+
+        // Layer mask covering rootJoint and every joint below it, for upper body layers.
+        // Parents come before their children, as in ComputeGlobalTransforms
+        static std::vector<float> BuildJointMask(const Skeleton& skeleton, int rootJoint, float weight = 1.0f)
+        {
+            std::vector<float> mask(skeleton.joints.size(), 0.0f);
+            for (size_t i = 0; i < skeleton.joints.size(); ++i)
+            {
+                int parent = skeleton.joints[i].parentIndex;
+                if (static_cast<int>(i) == rootJoint || (parent >= 0 && mask[parent] > 0.0f))
+                    mask[i] = weight;
+            }
+            return mask;
+        }
+
+        // Every layer and clip of the controller blended into scratch's TRS arrays. Clips are sampled
+        // straight into per joint accumulators and each layer is folded into the pose in one pass over
+        // the joints, no matrices are built until the pose is final
+        static void EvaluateBlendedPose(const AnimationController& controller, size_t jointCount, AnimationScratch& scratch)
+        {
+            scratch.translations.assign(jointCount, glm::vec3(0.0f));
+            scratch.rotations.assign(jointCount, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+            scratch.scales.assign(jointCount, glm::vec3(1.0f));
+
+            const auto& layers = controller.GetLayers();
+            for (size_t layerIndex = 0; layerIndex < layers.size(); ++layerIndex)
+            {
+                const auto& layer = layers[layerIndex];
+                float layerWeight = layerIndex == 0 ? 1.0f : layer.weight;
+                if (layerWeight <= 0.0f) continue;
+
+                bool additive = layer.blendMode == AnimationBlendMode::Additive;
+                scratch.accumTranslations.assign(jointCount, glm::vec3(0.0f));
+                scratch.accumRotations.assign(jointCount, additive ? glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) : glm::vec4(0.0f));
+                scratch.accumScales.assign(jointCount, glm::vec3(additive ? 1.0f : 0.0f));
+                scratch.accumWeights.assign(jointCount, glm::vec3(0.0f));
+
+                bool sampled = false;
+                for (const auto& clip : layer.clips)
                 {
-                    ApplyKeyframe(channel, outputValues[currentIndex], translations, rotations, scales);
+                    if (clip.weight <= 0.0f || clip.animation == nullptr) continue;
+                    sampled |= AccumulateClip(clip, additive, jointCount, scratch);
                 }
-                else
+                if (!sampled) continue;
+
+                for (size_t joint = 0; joint < jointCount; ++joint)
                 {
-                    InterpolateKeyframes(channel, outputValues[currentIndex], outputValues[nextIndex], factor, translations, rotations, scales);
+                    float weight = layerWeight;
+                    if (!layer.jointMask.empty())
+                        weight *= joint < layer.jointMask.size() ? layer.jointMask[joint] : 0.0f;
+                    if (weight <= 0.0f) continue;
+
+                    const glm::vec3& contributed = scratch.accumWeights[joint];
+                    glm::vec4 rotation(scratch.rotations[joint].x, scratch.rotations[joint].y, scratch.rotations[joint].z, scratch.rotations[joint].w);
+
+                    if (additive)
+                    {
+                        if (contributed.x > 0.0f)
+                            scratch.translations[joint] += weight * scratch.accumTranslations[joint];
+                        if (contributed.y > 0.0f)
+                            rotation = QuatMultiply(rotation, Nlerp(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), scratch.accumRotations[joint], weight));
+                        if (contributed.z > 0.0f)
+                            scratch.scales[joint] *= glm::mix(glm::vec3(1.0f), scratch.accumScales[joint], weight);
+                    }
+                    else
+                    {
+                        // override clips are normalized by the weight of the clips that animate the joint,
+                        // so a joint only one clip touches isn't pulled towards the rest pose
+                        if (contributed.x > 0.0f)
+                            scratch.translations[joint] = glm::mix(scratch.translations[joint], scratch.accumTranslations[joint] / contributed.x, weight);
+                        if (contributed.y > 0.0f)
+                            rotation = Nlerp(rotation, scratch.accumRotations[joint], weight);
+                        if (contributed.z > 0.0f)
+                            scratch.scales[joint] = glm::mix(scratch.scales[joint], scratch.accumScales[joint] / contributed.z, weight);
+                    }
+
+                    scratch.rotations[joint] = glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
                 }
             }
+        }
 
-            for (size_t i = 0; i < nodeTransforms.size(); ++i)
+        // EvaluateJointMatrices for a controller, blending its layers when it has more than one clip
+        static void EvaluateBlendedJointMatrices(const AnimationController& controller,
+            const Skeleton& skeleton,
+            const std::vector<glm::mat4>& inverseBindMatrices,
+            AnimationScratch& scratch,
+            glm::mat4* jointMatrices,
+            size_t jointCount)
+        {
+            EvaluateBlendedPose(controller, skeleton.joints.size(), scratch);
+
+            scratch.localTransforms.resize(skeleton.joints.size());
+            for (size_t i = 0; i < scratch.localTransforms.size(); ++i)
             {
-                nodeTransforms[i] = glm::translate(glm::mat4(1.0f), translations[i]) *
-                    glm::mat4_cast(rotations[i]) *
-                    glm::scale(glm::mat4(1.0f), scales[i]);
+                scratch.localTransforms[i] = glm::translate(glm::mat4(1.0f), scratch.translations[i]) *
+                    glm::mat4_cast(scratch.rotations[i]) *
+                    glm::scale(glm::mat4(1.0f), scratch.scales[i]);
+            }
+            ComputeGlobalTransforms(skeleton, scratch.localTransforms, scratch.globalTransforms);
+
+            size_t count = std::min({ jointCount, scratch.globalTransforms.size(), inverseBindMatrices.size() });
+            for (size_t i = 0; i < count; ++i)
+            {
+                jointMatrices[i] = scratch.globalTransforms[i] * inverseBindMatrices[i];
             }
         }
 
@@ -95,44 +242,21 @@ namespace JLEngine
             const std::vector<size_t>& keyframeIndices)
         {
             const auto& channels = anim.GetChannels();
-            const auto& samplers = anim.GetSamplers();
+            const auto& keyframes = anim.GetKeyframes();
 
-            if (keyframeIndices.size() < channels.size())
+            if (keyframeIndices.size() < channels.size() || keyframes.ChannelCount() != channels.size())
                 return; // Prevent out-of-bounds access
 
             glm::vec3 translation(0.0f);
             glm::quat rotation = glm::identity<glm::quat>();
             glm::vec3 scale(1.0f);
 
+            // a handful of channels per node, sampled one at a time so nothing is allocated.
+            // Sampling holds the last key rather than blending back to the first, looping restarts the clip
             for (size_t channelIndex = 0; channelIndex < channels.size(); ++channelIndex)
             {
-                const auto& channel = channels[channelIndex];
-                const auto& sampler = samplers[channel.GetSamplerIndex()];
-                const auto& inputTimes = sampler.GetTimes();
-                const auto& outputValues = sampler.GetValues();
-
-                if (inputTimes.empty() || channelIndex >= keyframeIndices.size())
-                    continue;
-
-                size_t currentIndex = keyframeIndices[channelIndex];
-                size_t nextIndex = (currentIndex + 1) % inputTimes.size();
-
-                //std::cout << currentIndex << " : " << nextIndex << std::endl;
-
-                float timeStart = inputTimes[currentIndex];
-                float timeEnd = inputTimes[nextIndex];
-
-                if (looping && nextIndex == 0)
-                {
-                    timeEnd += anim.GetDuration();
-                }
-
-                constexpr float epsilon = 1e-6f;
-                float deltaT = timeEnd - timeStart;
-                float factor = (deltaT > epsilon) ? (currTime - timeStart) / deltaT : 0.0f;
-
-                // Interpolate keyframes safely
-                InterpolateKeyframes(channel, outputValues[currentIndex], outputValues[nextIndex], factor, translation, rotation, scale);
+                glm::vec4 value = keyframes.SampleChannel(channelIndex, currTime, keyframeIndices[channelIndex]);
+                ApplyKeyframe(channels[channelIndex], value, translation, rotation, scale);
             }
 
             node.SetTRS(translation, rotation, scale);
@@ -233,6 +357,100 @@ namespace JLEngine
                 scales[targetNode] = glm::vec3(keyframeValue);
             }
         }
+
+    private:
+        // Samples one clip and adds it to the layer accumulators, false if the clip has no packed keyframes
+        static bool AccumulateClip(const AnimationClipState& clip, bool additive, size_t jointCount, AnimationScratch& scratch)
+        {
+            const auto& channels = clip.animation->GetChannels();
+            const auto& keyframes = clip.animation->GetKeyframes();
+            if (keyframes.ChannelCount() != channels.size()) return false;
+            if (additive && clip.referenceValues.size() != channels.size()) return false;
+
+            scratch.samples.resize(channels.size());
+            keyframes.Sample(clip.time, clip.keyframeIndices, scratch.keyframes, scratch.samples.data());
+
+            float w = clip.weight;
+            for (size_t channelIndex = 0; channelIndex < channels.size(); ++channelIndex)
+            {
+                int targetNode = channels[channelIndex].GetTargetNode();
+                if (targetNode < 0 || targetNode >= static_cast<int>(jointCount)) continue;
+
+                const glm::vec4& value = scratch.samples[channelIndex];
+                auto& contributed = scratch.accumWeights[targetNode];
+
+                switch (channels[channelIndex].GetTargetPath())
+                {
+                case TargetPath::TRANSLATION:
+                {
+                    glm::vec3 translation(value);
+                    if (additive) translation -= glm::vec3(clip.referenceValues[channelIndex]);
+                    scratch.accumTranslations[targetNode] += w * translation;
+                    contributed.x += w;
+                    break;
+                }
+                case TargetPath::ROTATION:
+                {
+                    auto& accum = scratch.accumRotations[targetNode];
+                    if (additive)
+                    {
+                        // difference from the reference frame, inverse(reference) * value
+                        const glm::vec4& reference = clip.referenceValues[channelIndex];
+                        glm::vec4 delta = QuatMultiply(glm::vec4(-reference.x, -reference.y, -reference.z, reference.w), value);
+                        accum = QuatMultiply(accum, Nlerp(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), delta, w));
+                    }
+                    else
+                    {
+                        // keep every clip on the same hemisphere as the first so the sum doesn't cancel out
+                        accum += glm::dot(accum, value) < 0.0f ? -w * value : w * value;
+                    }
+                    contributed.y += w;
+                    break;
+                }
+                case TargetPath::SCALE:
+                {
+                    if (additive)
+                    {
+                        glm::vec3 reference(clip.referenceValues[channelIndex]);
+                        glm::vec3 ratio(1.0f);
+                        for (int i = 0; i < 3; ++i)
+                        {
+                            if (std::abs(reference[i]) > 1e-6f) ratio[i] = value[i] / reference[i];
+                        }
+                        scratch.accumScales[targetNode] *= glm::mix(glm::vec3(1.0f), ratio, w);
+                    }
+                    else
+                    {
+                        scratch.accumScales[targetNode] += w * glm::vec3(value);
+                    }
+                    contributed.z += w;
+                    break;
+                }
+                }
+            }
+            return true;
+        }
+
+        // Quaternions as (x, y, z, w) vec4s so accumulating them is plain vector math
+        static glm::vec4 QuatMultiply(const glm::vec4& a, const glm::vec4& b)
+        {
+            return glm::vec4(
+                a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+        }
+
+        // Normalized lerp along the shortest path, b doesn't need to be normalized
+        static glm::vec4 Nlerp(const glm::vec4& a, glm::vec4 b, float t)
+        {
+            float length = glm::length(b);
+            if (length <= 0.0f) return a;
+            b = b / length;
+            if (glm::dot(a, b) < 0.0f) b = -b;
+            if (t >= 1.0f) return b;
+            return glm::normalize(glm::mix(a, b, t));
+        }
 	};
 }
 
@@ -0,0 +1,301 @@
+#include "AnimationBaker.h"
+#include "AnimHelpers.h"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <glm/gtc/packing.hpp>
+
+namespace JLEngine
+{
+	namespace
+	{
+		constexpr char CacheMagic[4] = { 'J', 'L', 'B', 'K' };
+		// bump when the bake or the file layout changes, old caches are then rebaked
+		constexpr uint32_t CacheVersion = 1;
+
+		// FNV-1a, only has to tell bakes apart, not resist anyone
+		struct Hasher
+		{
+			uint64_t value = 14695981039346656037ull;
+
+			void Bytes(const void* data, size_t size)
+			{
+				auto bytes = static_cast<const uint8_t*>(data);
+				for (size_t i = 0; i < size; ++i)
+				{
+					value ^= bytes[i];
+					value *= 1099511628211ull;
+				}
+			}
+
+			template <typename T>
+			void Value(const T& v) { Bytes(&v, sizeof(T)); }
+
+			template <typename T>
+			void Vector(const std::vector<T>& v)
+			{
+				Value(static_cast<uint64_t>(v.size()));
+				if (!v.empty()) Bytes(v.data(), v.size() * sizeof(T));
+			}
+		};
+
+		uint32_t FloatBits(float f)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &f, sizeof(bits));
+			return bits;
+		}
+
+		float BitsFloat(uint32_t bits)
+		{
+			float f;
+			std::memcpy(&f, &bits, sizeof(f));
+			return f;
+		}
+
+		// file names from animation names like "Anim_Skeleton_idx:0"
+		std::string SafeFileName(const std::string& name)
+		{
+			std::string result = name.empty() ? "anim" : name;
+			for (char& c : result)
+			{
+				bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+				if (!keep) c = '_';
+			}
+			return result;
+		}
+	}
+
+	glm::mat4 BakedAnimation::GetMatrix(uint32_t frame, uint32_t joint) const
+	{
+		const uint32_t* src = words.data() + (static_cast<size_t>(frame) * jointCount + joint) * WordsPerMatrix();
+
+		float rows[12];
+		if (format == BakedPaletteFormat::Half3x4)
+		{
+			for (int i = 0; i < 6; ++i)
+			{
+				glm::vec2 pair = glm::unpackHalf2x16(src[i]);
+				rows[i * 2 + 0] = pair.x;
+				rows[i * 2 + 1] = pair.y;
+			}
+		}
+		else
+		{
+			for (int i = 0; i < 12; ++i) rows[i] = BitsFloat(src[i]);
+		}
+
+		glm::mat4 m(1.0f);
+		for (int c = 0; c < 4; ++c)
+		{
+			for (int r = 0; r < 3; ++r)
+			{
+				m[c][r] = rows[r * 4 + c];
+			}
+		}
+		return m;
+	}
+
+	uint64_t AnimationBaker::HashSource(Animation& animation, const Skeleton& skeleton, const std::vector<glm::mat4>& inverseBindMatrices,
+		float frameRate, BakedPaletteFormat format)
+	{
+		Hasher hash;
+		hash.Value(CacheVersion);
+		hash.Value(frameRate);
+		hash.Value(format);
+
+		// the keyframes are what plays, and the only copy left once an animation is compressed
+		hash.Value(animation.GetKeyframes().Fingerprint());
+
+		const auto& samplers = animation.GetSamplers();
+		for (const auto& channel : animation.GetChannels())
+		{
+			hash.Value(channel.GetTargetNode());
+			hash.Value(channel.GetTargetPath());
+
+			const auto& sampler = samplers[channel.GetSamplerIndex()];
+			hash.Value(sampler.GetInterpolation());
+			hash.Vector(sampler.GetTimes());
+			hash.Vector(sampler.GetValues());
+			hash.Vector(sampler.GetInTangents());
+			hash.Vector(sampler.GetOutTangents());
+		}
+
+		for (const auto& joint : skeleton.joints)
+		{
+			hash.Value(joint.parentIndex);
+		}
+		hash.Vector(inverseBindMatrices);
+		return hash.value;
+	}
+
+	bool AnimationBaker::Bake(Animation& animation, const Skeleton& skeleton, const std::vector<glm::mat4>& inverseBindMatrices,
+		float frameRate, BakedPaletteFormat format, BakedAnimation& out)
+	{
+		if (frameRate <= 0.0f || skeleton.joints.empty())
+		{
+			std::cerr << "AnimationBaker: nothing to bake for " << animation.GetName() << std::endl;
+			return false;
+		}
+
+		float duration = animation.GetDuration();
+		uint32_t frameCount = duration > 0.0f ? std::max(2u, static_cast<uint32_t>(std::ceil(duration * frameRate)) + 1) : 1u;
+
+		out.sourceHash = HashSource(animation, skeleton, inverseBindMatrices, frameRate, format);
+		out.duration = duration;
+		out.frameCount = frameCount;
+		// the requested rate stretched slightly so the last frame lands on duration
+		out.frameRate = frameCount > 1 ? static_cast<float>(frameCount - 1) / duration : 0.0f;
+		out.jointCount = static_cast<uint32_t>(skeleton.joints.size());
+		out.format = format;
+		out.words.resize(static_cast<size_t>(frameCount) * out.jointCount * out.WordsPerMatrix());
+
+		AnimationScratch scratch;
+		std::vector<glm::mat4> palette(out.jointCount);
+		std::vector<size_t> keyframeIndices(animation.GetChannels().size(), 0);
+
+		uint32_t* dst = out.words.data();
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			float time = frameCount > 1 ? std::min(duration, frame / out.frameRate) : 0.0f;
+
+			// joints without an inverse bind matrix stay at identity
+			std::fill(palette.begin(), palette.end(), glm::mat4(1.0f));
+			AnimHelpers::EvaluateJointMatrices(animation, time, keyframeIndices, skeleton, inverseBindMatrices, scratch, palette.data(), palette.size());
+
+			for (const auto& m : palette)
+			{
+				float rows[12];
+				for (int r = 0; r < 3; ++r)
+				{
+					for (int c = 0; c < 4; ++c)
+					{
+						rows[r * 4 + c] = m[c][r];
+					}
+				}
+
+				if (format == BakedPaletteFormat::Half3x4)
+				{
+					for (int i = 0; i < 6; ++i) *dst++ = glm::packHalf2x16(glm::vec2(rows[i * 2], rows[i * 2 + 1]));
+				}
+				else
+				{
+					for (int i = 0; i < 12; ++i) *dst++ = FloatBits(rows[i]);
+				}
+			}
+		}
+		return true;
+	}
+
+	bool AnimationBaker::BakeCached(const std::string& cacheFolder, Animation& animation, const Skeleton& skeleton,
+		const std::vector<glm::mat4>& inverseBindMatrices, float frameRate, BakedPaletteFormat format, BakedAnimation& out)
+	{
+		uint64_t hash = HashSource(animation, skeleton, inverseBindMatrices, frameRate, format);
+		std::string path = (std::filesystem::path(cacheFolder) / (SafeFileName(animation.GetName()) + "_" + std::to_string(hash) + ".jlbake")).string();
+
+		if (LoadCache(path, hash, out)) return true;
+		if (!Bake(animation, skeleton, inverseBindMatrices, frameRate, format, out)) return false;
+
+		std::error_code error;
+		std::filesystem::create_directories(cacheFolder, error);
+		if (!SaveCache(path, out))
+			std::cerr << "AnimationBaker: could not write " << path << ", the bake will be repeated next run" << std::endl;
+		return true;
+	}
+
+	bool AnimationBaker::SaveCache(const std::string& path, const BakedAnimation& baked)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) return false;
+
+		uint32_t format = static_cast<uint32_t>(baked.format);
+		uint64_t wordCount = baked.words.size();
+		file.write(CacheMagic, sizeof(CacheMagic));
+		file.write(reinterpret_cast<const char*>(&CacheVersion), sizeof(CacheVersion));
+		file.write(reinterpret_cast<const char*>(&baked.sourceHash), sizeof(baked.sourceHash));
+		file.write(reinterpret_cast<const char*>(&baked.frameRate), sizeof(baked.frameRate));
+		file.write(reinterpret_cast<const char*>(&baked.duration), sizeof(baked.duration));
+		file.write(reinterpret_cast<const char*>(&baked.frameCount), sizeof(baked.frameCount));
+		file.write(reinterpret_cast<const char*>(&baked.jointCount), sizeof(baked.jointCount));
+		file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+		file.write(reinterpret_cast<const char*>(&wordCount), sizeof(wordCount));
+		file.write(reinterpret_cast<const char*>(baked.words.data()), wordCount * sizeof(uint32_t));
+		return static_cast<bool>(file);
+	}
+
+	bool AnimationBaker::LoadCache(const std::string& path, uint64_t expectedHash, BakedAnimation& out)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+
+		char magic[4];
+		uint32_t version = 0, format = 0;
+		uint64_t wordCount = 0;
+		BakedAnimation baked;
+		file.read(magic, sizeof(magic));
+		file.read(reinterpret_cast<char*>(&version), sizeof(version));
+		file.read(reinterpret_cast<char*>(&baked.sourceHash), sizeof(baked.sourceHash));
+		file.read(reinterpret_cast<char*>(&baked.frameRate), sizeof(baked.frameRate));
+		file.read(reinterpret_cast<char*>(&baked.duration), sizeof(baked.duration));
+		file.read(reinterpret_cast<char*>(&baked.frameCount), sizeof(baked.frameCount));
+		file.read(reinterpret_cast<char*>(&baked.jointCount), sizeof(baked.jointCount));
+		file.read(reinterpret_cast<char*>(&format), sizeof(format));
+		file.read(reinterpret_cast<char*>(&wordCount), sizeof(wordCount));
+
+		if (!file || std::memcmp(magic, CacheMagic, sizeof(magic)) != 0 || version != CacheVersion || baked.sourceHash != expectedHash)
+			return false;
+		if (format > static_cast<uint32_t>(BakedPaletteFormat::Half3x4)) return false;
+
+		baked.format = static_cast<BakedPaletteFormat>(format);
+		if (wordCount != static_cast<uint64_t>(baked.frameCount) * baked.jointCount * baked.WordsPerMatrix()) return false;
+
+		baked.words.resize(wordCount);
+		file.read(reinterpret_cast<char*>(baked.words.data()), wordCount * sizeof(uint32_t));
+		if (!file) return false;
+
+		out = std::move(baked);
+		return true;
+	}
+
+	void AnimationBaker::Sample(const BakedAnimation& baked, float time, glm::mat4* jointMatrices)
+	{
+		if (baked.frameCount == 0) return;
+
+		float frame = 0.0f;
+		if (baked.frameCount > 1 && baked.duration > 0.0f)
+		{
+			float wrapped = std::fmod(time, baked.duration);
+			if (wrapped < 0.0f) wrapped += baked.duration;
+			frame = wrapped * baked.frameRate;
+		}
+
+		uint32_t f0 = std::min(static_cast<uint32_t>(frame), baked.frameCount - 1);
+		uint32_t f1 = std::min(f0 + 1, baked.frameCount - 1);
+		float blend = frame - static_cast<float>(f0);
+
+		for (uint32_t joint = 0; joint < baked.jointCount; ++joint)
+		{
+			glm::mat4 a = baked.GetMatrix(f0, joint);
+			glm::mat4 b = baked.GetMatrix(f1, joint);
+			for (int c = 0; c < 4; ++c)
+			{
+				jointMatrices[joint][c] = glm::mix(a[c], b[c], blend);
+			}
+		}
+	}
+
+	BakedClipGPU AnimationBaker::MakeGPUClip(const BakedAnimation& baked, uint32_t firstWord)
+	{
+		BakedClipGPU clip{};
+		clip.firstWord = firstWord;
+		clip.frameCount = baked.frameCount;
+		clip.jointCount = baked.jointCount;
+		clip.format = static_cast<uint32_t>(baked.format);
+		clip.frameRate = baked.frameRate;
+		clip.duration = baked.duration;
+		return clip;
+	}
+}
\ No newline at end of file
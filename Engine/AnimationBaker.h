@@ -0,0 +1,76 @@
+#ifndef ANIMATION_BAKER_H
+#define ANIMATION_BAKER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AnimData.h"
+
+namespace JLEngine
+{
+	enum class BakedPaletteFormat : uint32_t
+	{
+		Float3x4 = 0,	// 12 floats per joint
+		Half3x4 = 1		// 12 half floats packed in pairs, half the size
+	};
+
+	// One animation sampled at a fixed rate into skinning matrices (joint global * inverse bind) for every
+	// frame. Each matrix is stored as the top three rows of the affine transform, frames are evenly
+	// spaced over [0, duration] with the last frame on duration so a looping clip wraps cleanly
+	struct BakedAnimation
+	{
+		uint64_t sourceHash = 0;
+		float frameRate = 0.0f;			// frames per second between frame 0 and the last frame
+		float duration = 0.0f;
+		uint32_t frameCount = 0;
+		uint32_t jointCount = 0;
+		BakedPaletteFormat format = BakedPaletteFormat::Float3x4;
+		std::vector<uint32_t> words;	// frameCount * jointCount matrices of WordsPerMatrix()
+
+		uint32_t WordsPerMatrix() const { return format == BakedPaletteFormat::Half3x4 ? 6u : 12u; }
+		glm::mat4 GetMatrix(uint32_t frame, uint32_t joint) const;
+	};
+
+	// Mirrors BakedClip in baked_skinning.glsl, one per baked animation
+	struct alignas(16) BakedClipGPU
+	{
+		uint32_t firstWord;		// into the shared palette buffer
+		uint32_t frameCount;
+		uint32_t jointCount;
+		uint32_t format;
+		float frameRate;
+		float duration;
+		uint32_t pad0, pad1;
+	};
+
+	// Bakes animations for crowds that only need a frame index and a time offset per instance. Bakes are
+	// keyed by a hash of everything they depend on and can be cached on disk so startup doesn't repeat them
+	class AnimationBaker
+	{
+	public:
+		static constexpr float DefaultFrameRate = 30.0f;
+
+		static uint64_t HashSource(Animation& animation, const Skeleton& skeleton, const std::vector<glm::mat4>& inverseBindMatrices,
+			float frameRate, BakedPaletteFormat format);
+
+		static bool Bake(Animation& animation, const Skeleton& skeleton, const std::vector<glm::mat4>& inverseBindMatrices,
+			float frameRate, BakedPaletteFormat format, BakedAnimation& out);
+
+		// Loads cacheFolder/<name>_<hash>.jlbake when it exists and matches, otherwise bakes and writes it
+		static bool BakeCached(const std::string& cacheFolder, Animation& animation, const Skeleton& skeleton,
+			const std::vector<glm::mat4>& inverseBindMatrices, float frameRate, BakedPaletteFormat format, BakedAnimation& out);
+
+		static bool SaveCache(const std::string& path, const BakedAnimation& baked);
+		// false if the file is missing, damaged or was baked from different data
+		static bool LoadCache(const std::string& path, uint64_t expectedHash, BakedAnimation& out);
+
+		// What the skinning shader does: wrap time into the clip and blend the two nearest frames
+		static void Sample(const BakedAnimation& baked, float time, glm::mat4* jointMatrices);
+
+		static BakedClipGPU MakeGPUClip(const BakedAnimation& baked, uint32_t firstWord);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "AnimationCompressor.h"
+#include "AnimData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/quaternion.hpp>
+
+namespace JLEngine
+{
+	namespace
+	{
+		// bounds the greedy search on long flat stretches, each extra key costs a pass over the segment
+		constexpr size_t MaxSegmentKeys = 256;
+
+		float Tolerance(TargetPath path, const KeyframeCompressionSettings& settings)
+		{
+			if (path == TargetPath::ROTATION) return settings.rotationTolerance;
+			if (path == TargetPath::SCALE) return settings.scaleTolerance;
+			return settings.translationTolerance;
+		}
+
+		// matches KeyframeSampler::SampleChannel for LINEAR
+		glm::vec4 Interpolate(TargetPath path, const glm::vec4& a, const glm::vec4& b, float s)
+		{
+			if (path != TargetPath::ROTATION)
+				return glm::mix(a, b, s);
+
+			glm::quat q = glm::normalize(glm::slerp(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), s));
+			return glm::vec4(q.x, q.y, q.z, q.w);
+		}
+	}
+
+	float AnimationCompressor::KeyError(TargetPath path, const glm::vec4& a, const glm::vec4& b)
+	{
+		if (path == TargetPath::ROTATION)
+		{
+			// the chord between unit quaternions is 2 sin(angle / 4), acos of a dot product loses
+			// too much precision at the angles that matter here
+			float chord = std::min(glm::length(a - b), glm::length(a + b));
+			return 4.0f * std::asin(std::min(1.0f, 0.5f * chord));
+		}
+
+		glm::vec3 difference = glm::vec3(a) - glm::vec3(b);
+		if (path == TargetPath::SCALE)
+			return std::max(std::abs(difference.x), std::max(std::abs(difference.y), std::abs(difference.z)));
+		return glm::length(difference);
+	}
+
+	bool AnimationCompressor::SegmentFits(TargetPath path, const std::vector<float>& times, const std::vector<glm::vec4>& values,
+		size_t first, size_t last, float tolerance)
+	{
+		float span = times[last] - times[first];
+		for (size_t i = first + 1; i < last; ++i)
+		{
+			float s = span > 0.0f ? (times[i] - times[first]) / span : 1.0f;
+			if (KeyError(path, Interpolate(path, values[first], values[last], s), values[i]) > tolerance)
+				return false;
+		}
+		return true;
+	}
+
+	std::vector<size_t> AnimationCompressor::ReduceKeys(TargetPath path, InterpolationType interpolation, const std::vector<float>& times,
+		const std::vector<glm::vec4>& values, float tolerance)
+	{
+		size_t count = std::min(times.size(), values.size());
+		std::vector<size_t> kept;
+		if (count == 0) return kept;
+
+		kept.push_back(0);
+		bool constant = true;
+		for (size_t i = 1; i < count && constant; ++i)
+		{
+			constant = KeyError(path, values[i], values[0]) <= tolerance;
+		}
+		if (constant) return kept;
+
+		if (interpolation == InterpolationType::CUBICSPLINE)
+		{
+			for (size_t i = 1; i < count; ++i) kept.push_back(i);
+			return kept;
+		}
+
+		if (interpolation == InterpolationType::STEP)
+		{
+			// a held value only needs a key where it changes
+			for (size_t i = 1; i < count; ++i)
+			{
+				if (KeyError(path, values[i], values[kept.back()]) > tolerance)
+					kept.push_back(i);
+			}
+			return kept;
+		}
+
+		// greedy: stretch each segment from the last kept key while interpolating across it stays
+		// within tolerance at every key it skips. Error between the source keys is linear so checking
+		// at the keys is enough for translation and scale
+		size_t anchor = 0;
+		while (anchor + 1 < count)
+		{
+			size_t end = anchor + 1;
+			for (size_t candidate = anchor + 2; candidate < count && candidate - anchor <= MaxSegmentKeys; ++candidate)
+			{
+				if (!SegmentFits(path, times, values, anchor, candidate, tolerance))
+					break;
+				end = candidate;
+			}
+			kept.push_back(end);
+			anchor = end;
+		}
+		return kept;
+	}
+
+	KeyframeSampler AnimationCompressor::Compress(const KeyframeSampler& source, const KeyframeCompressionSettings& settings,
+		KeyframeCompressionStats* stats)
+	{
+		KeyframeSampler compressed;
+		std::vector<float> times, keptTimes;
+		std::vector<glm::vec4> values, keptValues, inTangents, outTangents;
+
+		for (size_t c = 0; c < source.ChannelCount(); ++c)
+		{
+			TargetPath path = source.GetPath(c);
+			InterpolationType interpolation = source.GetInterpolation(c);
+			source.GetChannelKeys(c, times, values, inTangents, outTangents);
+
+			if (!settings.reduceKeys || interpolation == InterpolationType::CUBICSPLINE)
+			{
+				compressed.AddChannel(path, interpolation, times, values, inTangents, outTangents);
+				continue;
+			}
+
+			keptTimes.clear();
+			keptValues.clear();
+			for (size_t key : ReduceKeys(path, interpolation, times, values, Tolerance(path, settings)))
+			{
+				keptTimes.push_back(times[key]);
+				keptValues.push_back(values[key]);
+			}
+			compressed.AddChannel(path, interpolation, keptTimes, keptValues);
+		}
+
+		if (settings.quantize)
+			compressed.Quantize();
+
+		if (stats)
+		{
+			*stats = KeyframeCompressionStats{};
+			for (size_t c = 0; c < source.ChannelCount(); ++c)
+			{
+				stats->keysBefore += source.KeyCount(c);
+				stats->keysAfter += compressed.KeyCount(c);
+			}
+			stats->bytesBefore = source.MemoryBytes();
+			stats->bytesAfter = compressed.MemoryBytes();
+			MeasureError(source, compressed, *stats);
+		}
+		return compressed;
+	}
+
+	KeyframeCompressionStats AnimationCompressor::Compress(Animation& animation, const KeyframeCompressionSettings& settings)
+	{
+		KeyframeCompressionStats stats;
+		animation.SetKeyframes(Compress(animation.GetKeyframes(), settings, &stats));
+		animation.ReleaseSourceKeys();
+		return stats;
+	}
+
+	void AnimationCompressor::MeasureError(const KeyframeSampler& source, const KeyframeSampler& compressed, KeyframeCompressionStats& stats)
+	{
+		std::vector<float> times;
+		std::vector<glm::vec4> values, inTangents, outTangents;
+
+		for (size_t c = 0; c < source.ChannelCount() && c < compressed.ChannelCount(); ++c)
+		{
+			TargetPath path = source.GetPath(c);
+			source.GetChannelKeys(c, times, values, inTangents, outTangents);
+
+			float error = 0.0f;
+			size_t hint = 0;
+			for (size_t k = 0; k < times.size(); ++k)
+			{
+				float t = times[k];
+				hint = compressed.FindKey(c, t, hint);
+				error = std::max(error, KeyError(path, source.SampleChannel(c, t, k), compressed.SampleChannel(c, t, hint)));
+
+				// slerp and Hermite curves bend between keys
+				if (k + 1 < times.size())
+				{
+					float mid = 0.5f * (t + times[k + 1]);
+					error = std::max(error, KeyError(path, source.SampleChannel(c, mid, k), compressed.SampleChannel(c, mid, hint)));
+				}
+			}
+
+			if (path == TargetPath::ROTATION) stats.maxRotationError = std::max(stats.maxRotationError, error);
+			else if (path == TargetPath::SCALE) stats.maxScaleError = std::max(stats.maxScaleError, error);
+			else stats.maxTranslationError = std::max(stats.maxTranslationError, error);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#ifndef ANIMATION_COMPRESSOR_H
+#define ANIMATION_COMPRESSOR_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "KeyframeSampler.h"
+
+namespace JLEngine
+{
+	class Animation;
+
+	struct KeyframeCompressionSettings
+	{
+		// largest change a removed key may make to its channel, rotations in radians
+		float rotationTolerance = 0.001f;
+		float translationTolerance = 0.0005f;
+		float scaleTolerance = 0.0005f;
+		bool reduceKeys = true;
+		bool quantize = true;
+	};
+
+	struct KeyframeCompressionStats
+	{
+		size_t keysBefore = 0;
+		size_t keysAfter = 0;
+		size_t bytesBefore = 0;
+		size_t bytesAfter = 0;
+		// worst difference from the source at every source key time and halfway between them,
+		// per joint in local space
+		float maxRotationError = 0.0f;		// radians
+		float maxTranslationError = 0.0f;
+		float maxScaleError = 0.0f;
+
+		float Ratio() const { return bytesAfter > 0 ? static_cast<float>(bytesBefore) / bytesAfter : 0.0f; }
+	};
+
+	// Import time compression of keyframes: keys that interpolating their neighbours reproduces within
+	// a tolerance are dropped, then the values are quantized to 48 bits (see KeyframeSampler::Quantize).
+	// CUBICSPLINE channels keep every key since their tangents are fitted to them
+	class AnimationCompressor
+	{
+	public:
+		static KeyframeSampler Compress(const KeyframeSampler& source, const KeyframeCompressionSettings& settings,
+			KeyframeCompressionStats* stats = nullptr);
+
+		// Replaces the animation's keyframes with a compressed copy and frees the source keys
+		static KeyframeCompressionStats Compress(Animation& animation, const KeyframeCompressionSettings& settings);
+
+		// Indices of the keys to keep, always the first. A channel that stays within tolerance of its first
+		// key keeps only that one
+		static std::vector<size_t> ReduceKeys(TargetPath path, InterpolationType interpolation, const std::vector<float>& times,
+			const std::vector<glm::vec4>& values, float tolerance);
+
+		static void MeasureError(const KeyframeSampler& source, const KeyframeSampler& compressed, KeyframeCompressionStats& stats);
+
+		// Radians between rotations, distance between translations, largest axis difference between scales
+		static float KeyError(TargetPath path, const glm::vec4& a, const glm::vec4& b);
+
+	private:
+		static bool SegmentFits(TargetPath path, const std::vector<float>& times, const std::vector<glm::vec4>& values,
+			size_t first, size_t last, float tolerance);
+	};
+}
+
+#endif
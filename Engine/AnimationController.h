@@ -1,6 +1,7 @@
 #ifndef ANIMATION_CONTROLLER_H
 #define ANIMATION_CONTROLLER_H
 
+#include <cmath>
 #include <memory>
 #include <unordered_map>
 #include <algorithm>
@@ -9,31 +10,63 @@
 
 namespace JLEngine
 {
+	enum class AnimationBlendMode
+	{
+		Override,	// replaces the pose below it by the layer weight
+		Additive	// adds each clip's difference from its first frame on top of the pose below it
+	};
+
+	// One clip playing in a layer, weight fades towards targetWeight at fadeSpeed per second
+	struct AnimationClipState
+	{
+		Animation* animation = nullptr;
+		float time = 0.0f;
+		float speed = 1.0f;
+		float weight = 0.0f;
+		float targetWeight = 0.0f;
+		float fadeSpeed = 0.0f;
+		std::vector<size_t> keyframeIndices;
+		// additive layers only, each channel sampled at the start of the clip
+		std::vector<glm::vec4> referenceValues;
+	};
+
+	// Weighted clips blended together in local TRS space, then applied over the layers below.
+	// Layer 0 is the base pose and always applies at full weight
+	struct AnimationLayer
+	{
+		std::vector<AnimationClipState> clips;
+		// per joint 0..1 scale of the layer weight, joints past the end get 0. Empty covers every joint
+		std::vector<float> jointMask;
+		AnimationBlendMode blendMode = AnimationBlendMode::Override;
+		float weight = 1.0f;
+		// clips share one normalized phase so cycles of different lengths (walk/run) stay in step
+		bool synchronized = false;
+		float phase = 0.0f;
+	};
+
 	class AnimationController
 	{
-	public: 
-		AnimationController() 
-			: m_currAnimation(nullptr), m_currTime(0.0f), m_playbackSpeed(1.0f), m_looping(true) {}
+	public:
+		AnimationController()
+			: m_playbackSpeed(1.0f), m_looping(true)
+		{
+			m_layers.resize(1);
+		}
 
+		// Snaps the base layer to a single clip from time zero, CrossFade blends into it instead
 		void SetCurrentAnimation(Animation* anim)
 		{
-			m_currAnimation = anim;
-			m_currTime = 0.0f;
-
-			if (m_currAnimation)
+			auto& clips = m_layers[0].clips;
+			clips.clear();
+			if (anim)
 			{
-				m_channelKeyframeIndices.resize(m_currAnimation->GetChannels().size(), 0);
+				AddClip(0, anim, 1.0f);
 			}
 		}
 
 		void SetCurrentAnimation(std::string&& name)
 		{
-			m_currTime = 0.0f;
-			m_currAnimation = m_animations[name];
-			if (m_currAnimation)
-			{
-				m_channelKeyframeIndices.resize(m_currAnimation->GetChannels().size(), 0);
-			}
+			SetCurrentAnimation(FindAnimation(name));
 		}
 
 		void AddAnimation(Animation* anim)
@@ -41,92 +74,246 @@ namespace JLEngine
 			m_animations[anim->GetName()] = anim;
 		}
 
-		Animation* CurrAnim() { return m_currAnimation; }
+		Animation* FindAnimation(const std::string& name) const
+		{
+			auto it = m_animations.find(name);
+			return it != m_animations.end() ? it->second : nullptr;
+		}
 
-		void Update(float deltaTime)
+		// Fades every other clip in the layer out and anim in over duration seconds. A clip already
+		// playing keeps its time, a new one starts from zero
+		void CrossFade(Animation* anim, float duration, size_t layer = 0)
 		{
-			if (!m_currAnimation)
-				return;
+			if (anim == nullptr || layer >= m_layers.size()) return;
 
-			m_currTime = std::max(0.0f, m_currTime + deltaTime * m_playbackSpeed);
-			float animDuration = m_currAnimation->GetDuration();
+			auto& clips = m_layers[layer].clips;
+			bool found = false;
+			for (auto& clip : clips)
+			{
+				found |= clip.animation == anim;
+				clip.targetWeight = clip.animation == anim ? 1.0f : 0.0f;
+				clip.fadeSpeed = duration > 0.0f ? 1.0f / duration : 0.0f;
+				if (duration <= 0.0f) clip.weight = clip.targetWeight;
+			}
 
-			if (m_currTime > animDuration)
+			if (!found)
 			{
-				m_currTime = 0.0f;
+				auto& clip = AddClip(layer, anim, duration > 0.0f ? 0.0f : 1.0f);
+				clip.targetWeight = 1.0f;
+				clip.fadeSpeed = duration > 0.0f ? 1.0f / duration : 0.0f;
 			}
+		}
 
-			UpdateKeyframeIndices();
+		void CrossFade(const std::string& name, float duration, size_t layer = 0)
+		{
+			CrossFade(FindAnimation(name), duration, layer);
 		}
 
-		float GetTime() const
+		// Sets a clip's weight directly for blend spaces (walk/run by speed), adding the clip if needed.
+		// Weights in an override layer are normalized so they don't need to sum to 1
+		void SetClipWeight(Animation* anim, float weight, size_t layer = 0)
 		{
-			if (!m_currAnimation || m_currAnimation->GetDuration() <= 0.0f)
-				return 0.0f;
+			if (anim == nullptr || layer >= m_layers.size()) return;
 
-			float animDuration = m_currAnimation->GetDuration();			
+			for (auto& clip : m_layers[layer].clips)
+			{
+				if (clip.animation != anim) continue;
+				clip.weight = clip.targetWeight = weight;
+				clip.fadeSpeed = 0.0f;
+				return;
+			}
+			AddClip(layer, anim, weight);
+		}
 
-			float finalTime = std::clamp(m_currTime, 0.0f, animDuration);
+		// Returns the new layer's index, layers are applied in the order they are added
+		size_t AddLayer(AnimationBlendMode blendMode, float weight = 1.0f, std::vector<float> jointMask = {})
+		{
+			AnimationLayer layer;
+			layer.blendMode = blendMode;
+			layer.weight = weight;
+			layer.jointMask = std::move(jointMask);
+			m_layers.push_back(std::move(layer));
+			return m_layers.size() - 1;
+		}
 
-			//std::cout << finalTime << std::endl;
+		void SetLayerWeight(size_t layer, float weight) { if (layer < m_layers.size()) m_layers[layer].weight = weight; }
+		void SetLayerMask(size_t layer, std::vector<float> jointMask) { if (layer < m_layers.size()) m_layers[layer].jointMask = std::move(jointMask); }
+		void SetLayerSynchronized(size_t layer, bool synchronized) { if (layer < m_layers.size()) m_layers[layer].synchronized = synchronized; }
 
-			return finalTime;
+		const std::vector<AnimationLayer>& GetLayers() const { return m_layers; }
+
+		// False when the pose is a single clip at full weight and can be sampled directly
+		bool IsBlending() const
+		{
+			size_t active = 0;
+			for (size_t i = 0; i < m_layers.size(); ++i)
+			{
+				for (const auto& clip : m_layers[i].clips)
+				{
+					if (clip.weight <= 0.0f) continue;
+					if (i > 0 || clip.weight < 1.0f) return true;
+					active++;
+				}
+			}
+			return active > 1;
+		}
+
+		// The base layer clip being faded to, or the heaviest one. Rigid animation and the
+		// single clip path only play this one
+		Animation* CurrAnim()
+		{
+			const auto* clip = DominantClip();
+			return clip ? clip->animation : nullptr;
 		}
 
-		const std::vector<size_t>& GetKeyframeIndices() const { return m_channelKeyframeIndices; }
+		void Update(float deltaTime)
+		{
+			// the GPU plays baked clips from the global time, the current time is only the instance's offset
+			if (m_bakedPlayback)
+				return;
 
-		float GetCurrentTime() const { return m_currTime; }
+			for (auto& layer : m_layers)
+			{
+				UpdateLayer(layer, deltaTime * m_playbackSpeed);
+			}
+		}
+
+		float GetTime() const
+		{
+			const auto* clip = DominantClip();
+			if (!clip || clip->animation->GetDuration() <= 0.0f)
+				return 0.0f;
+
+			return std::clamp(clip->time, 0.0f, clip->animation->GetDuration());
+		}
+
+		const std::vector<size_t>& GetKeyframeIndices() const
+		{
+			const auto* clip = DominantClip();
+			return clip ? clip->keyframeIndices : m_noKeyframes;
+		}
+
+		float GetCurrentTime() const
+		{
+			const auto* clip = DominantClip();
+			return clip ? clip->time : 0.0f;
+		}
 		float GetPlaybackSpeed() const { return m_playbackSpeed; }
 		bool IsLooping() const { return m_looping; }
 
 		void SetPlaybackSpeed(float speed) { m_playbackSpeed = speed; }
 		void SetLooping(bool looping) { m_looping = looping; }
 
+		// Background crowds: the renderer plays CurrAnim from a baked palette, looping, starting at
+		// GetCurrentTime. Update does nothing and layers, blending and playback speed are ignored
+		void SetBakedPlayback(bool baked) { m_bakedPlayback = baked; }
+		bool UsesBakedPlayback() const { return m_bakedPlayback; }
+
 	private:
 
-		void UpdateKeyframeIndices()
+		AnimationClipState& AddClip(size_t layer, Animation* anim, float weight)
 		{
-			if (!m_currAnimation)
-				return;
+			auto& clips = m_layers[layer].clips;
+			clips.emplace_back();
+
+			auto& clip = clips.back();
+			clip.animation = anim;
+			clip.weight = clip.targetWeight = weight;
+			clip.keyframeIndices.assign(anim->GetChannels().size(), 0);
+			if (m_layers[layer].synchronized)
+				clip.time = m_layers[layer].phase * anim->GetDuration();
 
-			const auto& precomputedSamplers = m_currAnimation->GetPrecomputedSamplers();
-			if (m_channelKeyframeIndices.size() < precomputedSamplers.size())
+			if (m_layers[layer].blendMode == AnimationBlendMode::Additive)
 			{
-				m_channelKeyframeIndices.resize(precomputedSamplers.size(), 0);
+				const auto& keyframes = anim->GetKeyframes();
+				clip.referenceValues.resize(keyframes.ChannelCount());
+				keyframes.SampleScalar(0.0f, {}, clip.referenceValues.data());
 			}
 
-			for (size_t i = 0; i < precomputedSamplers.size(); ++i)
+			UpdateKeyframeIndices(clip);
+			return clip;
+		}
+
+		const AnimationClipState* DominantClip() const
+		{
+			const AnimationClipState* dominant = nullptr;
+			for (const auto& clip : m_layers[0].clips)
 			{
-				if (!precomputedSamplers[i])
-					continue;
+				if (dominant == nullptr || clip.targetWeight > dominant->targetWeight ||
+					(clip.targetWeight == dominant->targetWeight && clip.weight >= dominant->weight))
+				{
+					dominant = &clip;
+				}
+			}
+			return dominant;
+		}
+
+		float WrapTime(float time, float duration) const
+		{
+			if (duration <= 0.0f) return 0.0f;
+			if (!m_looping) return std::clamp(time, 0.0f, duration);
+
+			time = std::fmod(time, duration);
+			return time < 0.0f ? time + duration : time;
+		}
 
-				const auto& inputTimes = precomputedSamplers[i]->GetTimes();
-				size_t& currentIndex = m_channelKeyframeIndices[i];
+		void UpdateLayer(AnimationLayer& layer, float deltaTime)
+		{
+			auto& clips = layer.clips;
+			for (auto& clip : clips)
+			{
+				if (clip.weight < clip.targetWeight)
+					clip.weight = std::min(clip.targetWeight, clip.weight + clip.fadeSpeed * std::abs(deltaTime));
+				else if (clip.weight > clip.targetWeight)
+					clip.weight = std::max(clip.targetWeight, clip.weight - clip.fadeSpeed * std::abs(deltaTime));
+			}
 
-				if (inputTimes.empty())
-					continue;
+			// faded out clips are dropped, erase only moves the survivors so this never allocates
+			clips.erase(std::remove_if(clips.begin(), clips.end(), [](const AnimationClipState& clip)
+				{
+					return clip.weight <= 0.0f && clip.targetWeight <= 0.0f;
+				}), clips.end());
 
-				// Step forward through keyframes
-				while (currentIndex < inputTimes.size() - 1 && m_currTime >= inputTimes[currentIndex + 1])
+			if (layer.synchronized)
+			{
+				// the phase moves at the rate of the weighted average cycle length
+				float weightSum = 0.0f, duration = 0.0f;
+				for (const auto& clip : clips)
 				{
-					currentIndex++;
+					weightSum += clip.weight;
+					duration += clip.weight * clip.animation->GetDuration();
 				}
+				if (weightSum > 0.0f && duration > 0.0f)
+					layer.phase = WrapTime(layer.phase + deltaTime * weightSum / duration, 1.0f);
 
-				// Step backward through keyframes if needed
-				while (currentIndex > 0 && m_currTime < inputTimes[currentIndex])
+				for (auto& clip : clips)
 				{
-					currentIndex--;
+					clip.time = layer.phase * clip.animation->GetDuration();
+					UpdateKeyframeIndices(clip);
 				}
+				return;
+			}
+
+			for (auto& clip : clips)
+			{
+				clip.time = WrapTime(clip.time + deltaTime * clip.speed, clip.animation->GetDuration());
+				UpdateKeyframeIndices(clip);
 			}
 		}
 
-		std::vector<size_t> m_channelKeyframeIndices;
+		// the cursors gallop from where they were, so loop wraps and seeks cost O(log keys) per timeline
+		static void UpdateKeyframeIndices(AnimationClipState& clip)
+		{
+			clip.animation->GetKeyframes().Seek(clip.time, clip.keyframeIndices);
+		}
+
+		std::vector<AnimationLayer> m_layers;
+		std::vector<size_t> m_noKeyframes;
 		std::shared_ptr<Skeleton> m_skeleton;
-		Animation* m_currAnimation;
 		std::unordered_map<std::string, Animation*> m_animations;
-		float m_currTime = 0.0f;
 		float m_playbackSpeed;
 		bool m_looping;
+		bool m_bakedPlayback = false;
 	};
 }
 
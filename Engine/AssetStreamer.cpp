@@ -0,0 +1,126 @@
+#include "AssetStreamer.h"
+
+#include "DeferredRenderer.h"
+#include "GLBLoader.h"
+#include "Node.h"
+#include "ResourceLoader.h"
+
+#include <chrono>
+#include <filesystem>
+
+namespace JLEngine
+{
+	AssetStreamer::AssetStreamer(ResourceLoader* resourceLoader, DeferredRenderer* renderer, JobSystem& jobs)
+		: m_resourceLoader(resourceLoader), m_renderer(renderer), m_jobs(jobs)
+	{
+	}
+
+	AssetStreamer::~AssetStreamer()
+	{
+		m_jobs.Wait(m_inFlight);
+	}
+
+	std::shared_ptr<AssetLoadHandle> AssetStreamer::Load(const std::string& fileName, std::shared_ptr<Node> placeholder, AssetLoadCallback onLoaded)
+	{
+		if (placeholder == nullptr)
+		{
+			placeholder = std::make_shared<Node>(std::filesystem::path(fileName).stem().string());
+			m_renderer->GetSceneManager().AddNode(placeholder);
+		}
+
+		auto request = std::make_shared<Request>();
+		request->handle = std::make_shared<AssetLoadHandle>();
+		request->handle->m_fileName = fileName;
+		request->handle->m_placeholder = placeholder;
+		request->onLoaded = std::move(onLoaded);
+
+		// the settings are taken here on the render thread, the worker only reads the import
+		request->import = m_resourceLoader->CreateGLBImport(fileName);
+		GLBLoader* loader = m_resourceLoader->GetGLBLoader();
+		JobSystem* jobs = &m_jobs;
+		m_requests.push_back(request);
+
+		m_jobs.SubmitBackground([loader, jobs, request]()
+			{
+				request->succeeded = loader->Import(*request->import, *jobs);
+				request->imported.store(true, std::memory_order_release);
+			}, &m_inFlight);
+
+		return request->handle;
+	}
+
+	void AssetStreamer::Update()
+	{
+		Update(FrameBudgetMs);
+	}
+
+	void AssetStreamer::Update(double budgetMs)
+	{
+		auto start = std::chrono::steady_clock::now();
+		GLBLoader* loader = m_resourceLoader->GetGLBLoader();
+
+		while (!m_requests.empty())
+		{
+			auto request = m_requests.front();
+
+			// later files wait for this one, two merges at once could both create a mesh of the same name
+			if (!request->imported.load(std::memory_order_acquire)) return;
+
+			bool finished = true;
+			if (request->succeeded)
+			{
+				request->handle->m_state = AssetLoadState::Merging;
+				finished = loader->MergeStep(*request->import);
+			}
+
+			if (finished)
+			{
+				m_requests.pop_front();
+				Finish(*request);
+			}
+
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			if (elapsed.count() >= budgetMs) return;
+		}
+	}
+
+	void AssetStreamer::Finish(Request& request)
+	{
+		AssetLoadHandle& handle = *request.handle;
+		std::shared_ptr<GLBImport> import = std::move(request.import);
+
+		if (!request.succeeded || import->root == nullptr)
+		{
+			handle.m_state = AssetLoadState::Failed;
+		}
+		else
+		{
+			// batches the file started need GPU objects, the ones that existed just have new ranges
+			GLBLoader* loader = m_resourceLoader->GetGLBLoader();
+			m_renderer->AddStreamedVAOs(VAOType::STATIC, loader->GetStaticVAOs());
+			m_renderer->AddStreamedVAOs(VAOType::JL_TRANSPARENT, loader->GetTransparentVAOs());
+			m_renderer->AddStreamedVAOs(VAOType::DYNAMIC, loader->GetDynamicVAOs());
+
+			m_renderer->GetSceneManager().AddNode(import->root, handle.m_placeholder.get());
+			handle.m_root = import->root;
+			handle.m_state = AssetLoadState::Ready;
+
+			// first import of the file, cook it off the render thread. The job keeps the import alive
+			if (!import->cacheHit && !import->cachePath.empty())
+			{
+				// WriteCache only reads the scene and the animation copies. The nodes and resources are let go
+				// of here, a worker dropping the last reference would destroy them off the render thread
+				import->root = nullptr;
+				import->nodeMapping.clear();
+				import->meshCache.clear();
+				import->materialCache.clear();
+				import->textureCache.clear();
+				import->animations.clear();
+				m_jobs.SubmitBackground([import]() { GLBLoader::WriteCache(*import); }, &m_inFlight);
+			}
+		}
+
+		if (request.onLoaded)
+			request.onLoaded(handle);
+	}
+}
@@ -0,0 +1,103 @@
+#ifndef ASSET_STREAMER_H
+#define ASSET_STREAMER_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "JobSystem.h"
+
+namespace JLEngine
+{
+	class Node;
+	class ResourceLoader;
+	class DeferredRenderer;
+	struct GLBImport;
+
+	enum class AssetLoadState
+	{
+		Importing,	// parsed and prepared on a worker
+		Merging,	// resources being created on the render thread
+		Ready,
+		Failed
+	};
+
+	// What a streamed load hands back. The placeholder is in the scene from the start, the file's
+	// nodes are added under it once the load is Ready. Only touched on the render thread
+	class AssetLoadHandle
+	{
+	public:
+		AssetLoadState GetState() const { return m_state; }
+		bool IsDone() const { return m_state == AssetLoadState::Ready || m_state == AssetLoadState::Failed; }
+
+		const std::string& GetFileName() const { return m_fileName; }
+		const std::shared_ptr<Node>& GetPlaceholder() const { return m_placeholder; }
+		// The file's root node, null until Ready
+		const std::shared_ptr<Node>& GetRoot() const { return m_root; }
+
+	private:
+		friend class AssetStreamer;
+
+		AssetLoadState m_state = AssetLoadState::Importing;
+		std::string m_fileName;
+		std::shared_ptr<Node> m_placeholder;
+		std::shared_ptr<Node> m_root;
+	};
+
+	using AssetLoadCallback = std::function<void(AssetLoadHandle& handle)>;
+
+	// Loads GLB files while the scene keeps rendering. Parsing, image decodes, submesh preparation
+	// and animation compression run as background jobs, Update then does the render thread half
+	// (textures and materials, adding the geometry to the batched VAOs, building the nodes) a step at
+	// a time until the frame's budget is spent. The nodes are attached through the SceneManager so
+	// their draws are registered the frame they appear, and the mesh cache of a first import is
+	// written by a background job afterwards
+	class AssetStreamer
+	{
+	public:
+		AssetStreamer(ResourceLoader* resourceLoader, DeferredRenderer* renderer, JobSystem& jobs);
+		// Waits for imports and cache writes still running, they point into this and the loader
+		~AssetStreamer();
+
+		AssetStreamer(const AssetStreamer&) = delete;
+		AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+		// placeholder should already be in the scene, the file's root is added under it. onLoaded
+		// runs from Update once the load is Ready or Failed
+		std::shared_ptr<AssetLoadHandle> Load(const std::string& fileName, std::shared_ptr<Node> placeholder, AssetLoadCallback onLoaded = nullptr);
+
+		// Render thread, once a frame before the transforms are resolved. At least one merge step runs
+		// when one is waiting so a slow texture can't stall a load
+		void Update();
+		void Update(double budgetMs);
+
+		size_t GetPendingCount() const { return m_requests.size(); }
+
+		// Render thread time per frame spent creating resources for streamed loads
+		double FrameBudgetMs = 2.0;
+
+	private:
+		struct Request
+		{
+			std::shared_ptr<AssetLoadHandle> handle;
+			std::shared_ptr<GLBImport> import;
+			AssetLoadCallback onLoaded;
+			std::atomic<bool> imported{ false };
+			bool succeeded = false;
+		};
+
+		void Finish(Request& request);
+
+		ResourceLoader* m_resourceLoader;
+		DeferredRenderer* m_renderer;
+		JobSystem& m_jobs;
+
+		// in request order, merged one at a time so files appear in the order they were asked for
+		std::deque<std::shared_ptr<Request>> m_requests;
+		JobCounter m_inFlight;
+	};
+}
+
+#endif
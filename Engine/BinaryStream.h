@@ -0,0 +1,162 @@
+#ifndef BINARY_STREAM_H
+#define BINARY_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace JLEngine
+{
+	// Raw little endian writes for the engine's cache files. Only trivially copyable types go
+	// through Value/Vector, the files are read back by the same build on the same platform
+	class BinaryWriter
+	{
+	public:
+		explicit BinaryWriter(std::ostream& stream) : m_stream(stream) {}
+
+		void Bytes(const void* data, size_t size)
+		{
+			if (size > 0) m_stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			m_offset += size;
+		}
+
+		template <typename T>
+		void Value(const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "BinaryWriter only writes trivially copyable types");
+			Bytes(&value, sizeof(T));
+		}
+
+		template <typename T>
+		void Vector(const std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "BinaryWriter only writes trivially copyable types");
+			Value(static_cast<uint64_t>(values.size()));
+			Bytes(values.data(), values.size() * sizeof(T));
+		}
+
+		void String(const std::string& value)
+		{
+			Value(static_cast<uint32_t>(value.size()));
+			Bytes(value.data(), value.size());
+		}
+
+		// Zero pads up to a multiple of alignment from the start of the file, so a blob written next
+		// can be used in place once the file is mapped
+		void Align(size_t alignment)
+		{
+			static const char zeros[16] = {};
+			size_t padding = (alignment - m_offset % alignment) % alignment;
+			while (padding > 0)
+			{
+				size_t count = padding < sizeof(zeros) ? padding : sizeof(zeros);
+				Bytes(zeros, count);
+				padding -= count;
+			}
+		}
+
+		size_t Offset() const { return m_offset; }
+		bool Good() const { return static_cast<bool>(m_stream); }
+
+	private:
+		std::ostream& m_stream;
+		size_t m_offset = 0;
+	};
+
+	// Reads what BinaryWriter wrote out of memory, usually a MappedFile. Running past the end fails
+	// the reader and every read after it, so a truncated file is caught by one Good() at the end
+	class BinaryReader
+	{
+	public:
+		BinaryReader(const std::byte* data, size_t size) : m_data(data), m_size(size) {}
+
+		// The next size bytes in place, nullptr once the reader has failed
+		const std::byte* Bytes(size_t size)
+		{
+			if (m_failed || size > m_size - m_offset)
+			{
+				m_failed = true;
+				return nullptr;
+			}
+			const std::byte* bytes = m_data + m_offset;
+			m_offset += size;
+			return bytes;
+		}
+
+		template <typename T>
+		bool Value(T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "BinaryReader only reads trivially copyable types");
+			const std::byte* bytes = Bytes(sizeof(T));
+			if (bytes == nullptr) return false;
+			std::memcpy(&value, bytes, sizeof(T));
+			return true;
+		}
+
+		template <typename T>
+		T Value()
+		{
+			T value{};
+			Value(value);
+			return value;
+		}
+
+		// count elements in place, the caller has aligned the reader for T
+		template <typename T>
+		const T* Array(size_t count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "BinaryReader only reads trivially copyable types");
+			if (count > (m_size - m_offset) / sizeof(T))
+			{
+				m_failed = true;
+				return nullptr;
+			}
+			return reinterpret_cast<const T*>(Bytes(count * sizeof(T)));
+		}
+
+		template <typename T>
+		bool Vector(std::vector<T>& values)
+		{
+			uint64_t count = Value<uint64_t>();
+			if (m_failed || count > (m_size - m_offset) / sizeof(T))
+			{
+				m_failed = true;
+				return false;
+			}
+			values.resize(static_cast<size_t>(count));
+			if (!values.empty())
+				std::memcpy(values.data(), Bytes(values.size() * sizeof(T)), values.size() * sizeof(T));
+			return true;
+		}
+
+		bool String(std::string& value)
+		{
+			uint32_t length = Value<uint32_t>();
+			const std::byte* bytes = Bytes(length);
+			if (bytes == nullptr) return false;
+			value.assign(reinterpret_cast<const char*>(bytes), length);
+			return true;
+		}
+
+		void Align(size_t alignment)
+		{
+			size_t padding = (alignment - m_offset % alignment) % alignment;
+			Bytes(padding);
+		}
+
+		size_t Offset() const { return m_offset; }
+		bool Good() const { return !m_failed; }
+
+	private:
+		const std::byte* m_data;
+		size_t m_size;
+		size_t m_offset = 0;
+		bool m_failed = false;
+	};
+}
+
+#endif
@@ -0,0 +1,147 @@
+#include "BufferSuballocator.h"
+
+#include <iterator>
+
+namespace JLEngine
+{
+	uint32_t BufferSuballocator::Allocate(uint32_t size)
+	{
+		if (size == 0) return InvalidOffset;
+
+		// best fit, the smallest block that holds the request
+		auto fit = m_freeBySize.lower_bound(size);
+		if (fit != m_freeBySize.end())
+		{
+			uint32_t offset = fit->second;
+			Claim(offset, size);
+			m_used += size;
+			return offset;
+		}
+
+		// nothing fits, grow at the tail and absorb a trailing free block so the buffer grows as little as possible
+		uint32_t offset = m_capacity;
+		if (!m_freeByOffset.empty())
+		{
+			auto last = std::prev(m_freeByOffset.end());
+			if (last->first + last->second == m_capacity)
+			{
+				offset = last->first;
+				EraseFree(last);
+			}
+		}
+		m_capacity = offset + size;
+		m_used += size;
+		return offset;
+	}
+
+	void BufferSuballocator::Free(uint32_t offset, uint32_t size)
+	{
+		if (offset == InvalidOffset || size == 0) return;
+
+		m_used -= size;
+		InsertFree(offset, size);
+	}
+
+	bool BufferSuballocator::Move(uint32_t from, uint32_t size, uint32_t to)
+	{
+		if (from == to || size == 0) return true;
+
+		// free first so a destination overlapping the source (sliding into an adjacent hole) is one block
+		Free(from, size);
+		if (Claim(to, size))
+		{
+			m_used += size;
+			return true;
+		}
+
+		// destination wasn't free, put the range back where it was
+		Claim(from, size);
+		m_used += size;
+		return false;
+	}
+
+	void BufferSuballocator::Clear()
+	{
+		m_freeByOffset.clear();
+		m_freeBySize.clear();
+		m_capacity = 0;
+		m_used = 0;
+	}
+
+	bool BufferSuballocator::FirstFreeBlock(uint32_t& offset, uint32_t& size) const
+	{
+		if (m_freeByOffset.empty()) return false;
+
+		offset = m_freeByOffset.begin()->first;
+		size = m_freeByOffset.begin()->second;
+		return true;
+	}
+
+	bool BufferSuballocator::TrimTail()
+	{
+		if (m_freeByOffset.empty()) return false;
+
+		auto last = std::prev(m_freeByOffset.end());
+		if (last->first + last->second != m_capacity) return false;
+
+		m_capacity = last->first;
+		EraseFree(last);
+		return true;
+	}
+
+	void BufferSuballocator::InsertFree(uint32_t offset, uint32_t size)
+	{
+		// coalesce with the blocks either side
+		auto next = m_freeByOffset.lower_bound(offset);
+		if (next != m_freeByOffset.begin())
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset)
+			{
+				offset = prev->first;
+				size += prev->second;
+				EraseFree(prev);
+			}
+		}
+		if (next != m_freeByOffset.end() && offset + size == next->first)
+		{
+			size += next->second;
+			EraseFree(next);
+		}
+
+		m_freeByOffset.emplace(offset, size);
+		m_freeBySize.emplace(size, offset);
+	}
+
+	void BufferSuballocator::EraseFree(std::map<uint32_t, uint32_t>::iterator it)
+	{
+		auto range = m_freeBySize.equal_range(it->second);
+		for (auto sized = range.first; sized != range.second; ++sized)
+		{
+			if (sized->second == it->first)
+			{
+				m_freeBySize.erase(sized);
+				break;
+			}
+		}
+		m_freeByOffset.erase(it);
+	}
+
+	bool BufferSuballocator::Claim(uint32_t offset, uint32_t size)
+	{
+		auto it = m_freeByOffset.upper_bound(offset);
+		if (it == m_freeByOffset.begin()) return false;
+		--it;
+
+		uint32_t blockOffset = it->first;
+		uint32_t blockSize = it->second;
+		if (offset + size > blockOffset + blockSize) return false;
+
+		EraseFree(it);
+		if (offset > blockOffset)
+			InsertFree(blockOffset, offset - blockOffset);
+		if (offset + size < blockOffset + blockSize)
+			InsertFree(offset + size, blockOffset + blockSize - (offset + size));
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef BUFFER_SUBALLOCATOR_H
+#define BUFFER_SUBALLOCATOR_H
+
+#include <cstdint>
+#include <map>
+
+namespace JLEngine
+{
+	// Offset allocator for carving ranges out of one large buffer, units are whatever the caller
+	// indexes the buffer by (vertices, indices). Free blocks are kept by offset so neighbours
+	// coalesce on free, and by size so allocation is best fit. Running out of free space grows
+	// the capacity at the tail, reusing a trailing free block if there is one.
+	class BufferSuballocator
+	{
+	public:
+		static constexpr uint32_t InvalidOffset = UINT32_MAX;
+
+		// Offset of size contiguous units, InvalidOffset for a size of 0
+		uint32_t Allocate(uint32_t size);
+		void Free(uint32_t offset, uint32_t size);
+		// Relocates a live range, the destination must be free apart from any overlap with the source
+		bool Move(uint32_t from, uint32_t size, uint32_t to);
+		void Clear();
+
+		// Lowest free block, the next hole a compaction pass should fill
+		bool FirstFreeBlock(uint32_t& offset, uint32_t& size) const;
+		// Drops a free block at the end of the buffer from the capacity, returns true if the capacity shrank
+		bool TrimTail();
+
+		uint32_t Capacity() const { return m_capacity; }
+		uint32_t UsedSize() const { return m_used; }
+		uint32_t FreeSize() const { return m_capacity - m_used; }
+		size_t FreeBlockCount() const { return m_freeByOffset.size(); }
+		uint32_t LargestFreeBlock() const { return m_freeBySize.empty() ? 0 : m_freeBySize.rbegin()->first; }
+
+	private:
+		void InsertFree(uint32_t offset, uint32_t size);
+		void EraseFree(std::map<uint32_t, uint32_t>::iterator it);
+		// Marks [offset, offset + size) as used, it must lie inside one free block
+		bool Claim(uint32_t offset, uint32_t size);
+
+		std::map<uint32_t, uint32_t> m_freeByOffset;		// offset -> size
+		std::multimap<uint32_t, uint32_t> m_freeBySize;		// size -> offset
+		uint32_t m_capacity = 0;
+		uint32_t m_used = 0;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -44,19 +44,26 @@ namespace JLEngine
 			point.z >= worldMin.z && point.z <= worldMax.z;
 	}
 
-	Plane::Plane( glm::vec3& v0, glm::vec3& v1, glm::vec3& v2 )
+	Plane::Plane( const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2 )
 	{
 		m_normal = v1 - v0;
-		m_normal = glm::cross(m_normal, v2 - v0);
-		glm::normalize(m_normal);
+		m_normal = glm::normalize(glm::cross(m_normal, v2 - v0));
 		m_distance = -glm::dot(m_normal, v0);
 	}
 
+	Plane::Plane( const glm::vec4& coefficients )
+	{
+		glm::vec3 normal = glm::vec3(coefficients);
+		float length = glm::length(normal);
+		m_normal = normal / length;
+		m_distance = coefficients.w / length;
+	}
+
 	Plane::~Plane()
 	{
 	}
 
-	float Plane::DistanceToPoint( glm::vec3& point )
+	float Plane::DistanceToPoint( const glm::vec3& point ) const
 	{
 		return glm::dot(m_normal, point) + m_distance;
 	}
@@ -81,4 +88,18 @@ namespace JLEngine
 
 		return { min, max };
 	}
+
+	AABB TransformAABB(const AABB& box, const glm::mat4& transform)
+	{
+		glm::vec3 center = (box.min + box.max) * 0.5f;
+		glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+		glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+		glm::vec3 worldExtent =
+			glm::abs(glm::vec3(transform[0])) * extent.x +
+			glm::abs(glm::vec3(transform[1])) * extent.y +
+			glm::abs(glm::vec3(transform[2])) * extent.z;
+
+		return { worldCenter - worldExtent, worldCenter + worldExtent };
+	}
 }
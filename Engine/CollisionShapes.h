@@ -21,16 +21,20 @@ namespace JLEngine
 	struct Plane
 	{
 		Plane() : m_distance(0.0f), m_normal(0.0f) {}
-		Plane(glm::vec3& v0, glm::vec3& v1, glm::vec3& v2);
+		Plane(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+		// Plane from (a, b, c, d) coefficients, normalized so DistanceToPoint returns true distances
+		Plane(const glm::vec4& coefficients);
 		~Plane();
 
-		float DistanceToPoint(glm::vec3& point);
+		float DistanceToPoint(const glm::vec3& point) const;
 
 		float m_distance;
 		glm::vec3 m_normal;
 	};
 
 	AABB CalculateAABB(const std::vector<float>& positions);
+	// Bounds of the box after transformation, uses the absolute matrix so it doesn't need all 8 corners
+	AABB TransformAABB(const AABB& box, const glm::mat4& transform);
 }
 
 #endif
\ No newline at end of file
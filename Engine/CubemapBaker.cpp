@@ -4,6 +4,7 @@
 #include "Geometry.h"
 #include "TextureWriter.h"
 #include "TextureReader.h"
+#include "MeshCache.h"
 
 #include <stb_image.h>
 #include <stb_image_write.h>
@@ -11,6 +12,7 @@
 #include <memory>
 #include <glad/glad.h>
 #include <algorithm>
+#include <filesystem>
 
 namespace JLEngine
 {
@@ -445,6 +447,57 @@ namespace JLEngine
         return brdfLUTTexture;
     }
 
+    std::string CubemapBaker::BakeCachePath(const std::string& cacheFolder, const std::string& name, const std::vector<std::string>& sources, uint64_t settingsHash)
+    {
+        // chained through the mesh cache's source hash, an edited shader or image makes a new file
+        uint64_t hash = settingsHash;
+        for (const auto& source : sources)
+        {
+            hash = MeshCache::HashSource(source, hash);
+            if (hash == 0) return "";
+        }
+        return (std::filesystem::path(cacheFolder) / (name + "_" + std::to_string(hash) + ".ktx2")).string();
+    }
+
+    std::string CubemapBaker::BRDFLUTCachePath(const std::string& assetPath, int lutSize, int numSamples)
+    {
+        uint64_t settings = (static_cast<uint64_t>(lutSize) << 32) | static_cast<uint32_t>(numSamples);
+        return BakeCachePath(assetPath + "Cache/Textures/", "brdf_lut",
+            { assetPath + "Core/Shaders/Baking/generate_brdf_lut_frag.glsl" }, settings);
+    }
+
+    uint32_t CubemapBaker::LoadBake(const std::string& path)
+    {
+        if (path.empty()) return 0;
+
+        KTX2File file;
+        if (!file.Open(path)) return 0;
+        uint32_t texture = Graphics::CreateKTX2Texture(file.GetImage(), std::filesystem::path(path).stem().string());
+        if (texture != 0)
+        {
+            // lookup tables as well as cube maps, none of them wrap
+            Graphics::API()->TextureParameter(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            Graphics::API()->TextureParameter(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            Graphics::API()->TextureParameter(texture, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        }
+        return texture;
+    }
+
+    bool CubemapBaker::SaveBake(uint32_t texture, KTX2Format format, const std::string& path)
+    {
+        if (path.empty()) return false;
+
+        KTX2Image image;
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+        if (!Graphics::ReadKTX2Texture(texture, format, image) || !KTX2File::Write(path, image))
+        {
+            std::cerr << "CubemapBaker: could not write " << path << ", it will be baked again next run" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
     uint32_t CubemapBaker::CreateEmptyCubemap(int cubeMapSize)
     {
         GLuint cubemapID;
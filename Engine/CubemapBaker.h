@@ -3,6 +3,7 @@
 
 #include "Types.h"
 #include "ResourceLoader.h"
+#include "KTX2File.h"
 
 #include <string>
 
@@ -24,6 +25,15 @@ namespace JLEngine
 		uint32_t GenerateBRDFLUT(int lutSize = 512, int numSamples = 1024);
 		static uint32_t CreateBRDFLUT(ShaderProgram* brdfShader, int lutSize = 512, int numSamples = 1024);
 
+		// --- CACHE --- //
+		// Bakes are kept as KTX2 files named by a hash of their source files and settings, a hit is
+		// a mapped upload instead of a render. The paths are empty when a source can't be read
+		static std::string BakeCachePath(const std::string& cacheFolder, const std::string& name, const std::vector<std::string>& sources, uint64_t settingsHash);
+		static std::string BRDFLUTCachePath(const std::string& assetPath, int lutSize, int numSamples);
+		// 0 on a miss
+		static uint32_t LoadBake(const std::string& path);
+		static bool SaveBake(uint32_t texture, KTX2Format format, const std::string& path);
+
 		void CleanupInternals();
 
 	private: 
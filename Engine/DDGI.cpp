@@ -15,7 +15,7 @@ JLEngine::DDGI::~DDGI()
     m_resourceLoader->DeleteShader("DDGIProbeUpdate");
 }
 
-void JLEngine::DDGI::GenerateProbes(const std::vector<std::pair<JLEngine::SubMesh, Node*>>& aabbs)
+void JLEngine::DDGI::GenerateProbes(const SceneBVH& sceneBVH)
 {
 	auto& probeData = m_probeSSBO.GetDataMutable();
 
@@ -39,17 +39,7 @@ void JLEngine::DDGI::GenerateProbes(const std::vector<std::pair<JLEngine::SubMes
 				glm::vec3 localOffset = glm::vec3(x, y, z) * m_probeSpacing;
 				glm::vec3 worldPos = m_gridOrigin + localOffset - halfGrid;
 
-				bool intersects = false;
-				for (const auto& [submesh, node] : aabbs)
-				{
-					const glm::mat4 worldTransform = node->GetGlobalTransform();
-
-					if (submesh.aabb.ContainsPoint(worldPos, worldTransform))
-					{
-						intersects = true;
-						break;
-					}
-				}
+				bool intersects = sceneBVH.AnyContainsPoint(worldPos);
 
 				if (intersects)
 				{
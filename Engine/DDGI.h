@@ -6,6 +6,7 @@
 #include "ShaderStorageBuffer.h"
 #include "ResourceLoader.h"
 #include "VoxelGrid.h"
+#include "SceneBVH.h"
 
 namespace JLEngine
 {
@@ -57,7 +58,8 @@ namespace JLEngine
         float& GetSkyLightColBlendFacMutable() { return m_skyLightColBlendFac; }
         float& GetRayLengthMutable() { return m_maxDistance; }
 
-        void GenerateProbes(const std::vector<std::pair<JLEngine::SubMesh, Node*>>& aabbs);
+        // Probes inside any submesh bounds are flagged as disabled
+        void GenerateProbes(const SceneBVH& sceneBVH);
         void Update(float dt, 
             UniformBuffer* shaderGlobaldata, 
             glm::vec3& dirLightCol,
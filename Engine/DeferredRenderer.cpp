@@ -11,6 +11,7 @@
 #include <glm/gtx/string_cast.hpp>
 #include <imgui.h>
 #include <type_traits>
+#include <unordered_set>
 
 #include "ImageHelpers.h"
 #include "AnimHelpers.h"
@@ -19,6 +20,8 @@
 #include "PhysicallyBasedSky.h"
 #include "SkyProbe.h"
 #include "JLMath.h"
+#include "TransformHierarchy.h"
+#include "TextureStreamer.h"
 
 namespace JLEngine
 {
@@ -72,11 +75,19 @@ namespace JLEngine
 
     DeferredRenderer::~DeferredRenderer() 
     {
+        // the bake jobs read the animations and meshes
+        JobSystem::Global().Wait(m_bakeJobsInFlight);
+
         Graphics::DisposeVertexArray(&m_triangleVAO);
 
         for (auto& [attrib, vaoRes] : m_staticResources)
         {
             Graphics::DisposeGPUBuffer(&vaoRes.drawBuffer->GetGPUBuffer());
+            Graphics::DisposeGPUBuffer(&vaoRes.visibleDrawBuffer->GetGPUBuffer());
+            for (auto& shadowBuffer : vaoRes.shadowDrawBuffers)
+            {
+                Graphics::DisposeGPUBuffer(&shadowBuffer->GetGPUBuffer());
+            }
         }
 
         for (auto& [attrib, vaoRes] : m_transparentResources)
@@ -85,6 +96,23 @@ namespace JLEngine
         }
 
         Graphics::DisposeGPUBuffer(&m_skinnedMeshResources.second.drawBuffer->GetGPUBuffer());
+        for (auto& shadowBuffer : m_skinnedMeshResources.second.shadowDrawBuffers)
+        {
+            Graphics::DisposeGPUBuffer(&shadowBuffer->GetGPUBuffer());
+        }
+
+        if (m_preskinnedResource.vao)
+        {
+            // the VAO only borrows the output and skinned index buffers
+            Graphics::API()->DeleteVertexArray(m_preskinnedResource.vao->GetGPUID());
+            Graphics::DisposeGPUBuffer(&m_preskinnedResource.drawBuffer->GetGPUBuffer());
+            for (auto& shadowBuffer : m_preskinnedResource.shadowDrawBuffers)
+            {
+                Graphics::DisposeGPUBuffer(&shadowBuffer->GetGPUBuffer());
+            }
+        }
+        Graphics::DisposeGPUBuffer(&m_preskinnedVertices);
+        Graphics::DisposeGPUBuffer(&m_ssboSkinJobs.GetGPUBuffer());
 
         Graphics::DisposeGPUBuffer(&m_ssboStaticPerDraw.GetGPUBuffer());
         Graphics::DisposeGPUBuffer(&m_ssboInstancedPerDraw.GetGPUBuffer());
@@ -93,6 +121,9 @@ namespace JLEngine
         Graphics::DisposeGPUBuffer(&m_ssboMaterials.GetGPUBuffer());
         Graphics::DisposeGPUBuffer(&m_ssboJointMatrices.GetGPUBuffer());
         Graphics::DisposeGPUBuffer(&m_ssboGlobalTransforms.GetGPUBuffer());
+        Graphics::DisposeGPUBuffer(&m_ssboBakedClips.GetGPUBuffer());
+        Graphics::DisposeGPUBuffer(&m_ssboBakedPalettes.GetGPUBuffer());
+        m_frameRing.Dispose();
 
         delete m_pbSky;
         delete m_skyProbe;  
@@ -112,6 +143,11 @@ namespace JLEngine
         Graphics::CreateGPUBuffer(m_gShaderData.GetGPUBuffer());
         Graphics::API()->DebugLabelObject(GL_BUFFER, m_gShaderData.GetGPUBuffer().GetGPUID(), "ShaderGlobalData");
 
+        // --- PER FRAME UPLOADS ---
+        // grown by ReserveFrameUploads once the scene is known
+        m_frameRing.Create(Graphics::API(), 1024 * 1024, Graphics::API()->GetBufferOffsetAlignment());
+        Graphics::API()->DebugLabelObject(GL_BUFFER, m_frameRing.GetGPUBuffer().GetGPUID(), "FrameRing");
+
         auto shaderAssetPath = m_assetFolder + "Core/Shaders/";
         auto textureAssetPath = m_assetFolder + "HDRI/";
         
@@ -151,14 +187,21 @@ namespace JLEngine
         m_jointTransformCompute = m_resourceLoader->CreateComputeFromFile("AnimJointTransforms", "joint_transform.compute", shaderAssetPath + "Compute/").get();
 
         // --- PB SKY ---
-        auto bakingPath = shaderAssetPath + "Baking/";
-        auto brdfShader = m_resourceLoader->CreateShaderFromFile(
-            "BRDFLUTShader",
-            "generate_brdf_lut_vert.glsl",
-            "generate_brdf_lut_frag.glsl",
-            bakingPath);
-        m_brdfLUT = CubemapBaker::CreateBRDFLUT(brdfShader.get(), 512, 1024);
-        m_resourceLoader->DeleteShader("BRDFLUTShader");
+        // the LUT only changes with its shader, later runs load it from the bake cache
+        auto brdfCachePath = CubemapBaker::BRDFLUTCachePath(m_assetFolder, 512, 1024);
+        m_brdfLUT = CubemapBaker::LoadBake(brdfCachePath);
+        if (m_brdfLUT == 0)
+        {
+            auto bakingPath = shaderAssetPath + "Baking/";
+            auto brdfShader = m_resourceLoader->CreateShaderFromFile(
+                "BRDFLUTShader",
+                "generate_brdf_lut_vert.glsl",
+                "generate_brdf_lut_frag.glsl",
+                bakingPath);
+            m_brdfLUT = CubemapBaker::CreateBRDFLUT(brdfShader.get(), 512, 1024);
+            m_resourceLoader->DeleteShader("BRDFLUTShader");
+            CubemapBaker::SaveBake(m_brdfLUT, KTX2Format::RG16_SFLOAT, brdfCachePath);
+        }
 
         m_atmosphereParams = AtmosphereParams::DayTime();
         m_pbSky = new PhysicallyBasedSky(m_resourceLoader, m_assetFolder);
@@ -177,7 +220,8 @@ namespace JLEngine
         // --- GLOBAL ILLUMINATION ---
         if (m_ddgi == nullptr)
             m_ddgi = new DDGI(m_resourceLoader, m_assetFolder);
-        m_ddgi->GenerateProbes(m_sceneManager.GetSubmeshes());
+        UpdateSceneBVH();
+        m_ddgi->GenerateProbes(m_sceneBVH);
 
         // --- POST PROCESSING ---
         m_postProcessing = new PostProcessing(m_resourceLoader, m_assetFolder);
@@ -222,85 +266,320 @@ namespace JLEngine
  
     void DeferredRenderer::UpdateRigidAnimations()
     {
-        const size_t nonInstancedStaticCount = m_sceneManager.GetNonInstancedStatic().size();
-        auto& rigidAnimationNodes = m_sceneManager.GetRigidAnimated();
+        auto& registry = m_sceneManager.GetRegistry();
+        auto& rigidItems = registry.GetBucketItems(SceneBucket::RigidAnimated);
         auto& dataMutable = m_ssboStaticPerDraw.GetDataMutable();
 
-        for (int i = 0; i < rigidAnimationNodes.size(); i++)
+        for (SceneItemID id : rigidItems)
         {
-            auto& node = rigidAnimationNodes[i].second;
+            auto node = registry.GetItem(id).node;
             auto& controller = node->animController;
+            if (controller->CurrAnim() == nullptr) continue; // every clip faded out
 
             AnimHelpers::EvaluateRigidAnimation(*controller->CurrAnim(), *node, controller->GetTime(), controller->IsLooping(), controller->GetKeyframeIndices());
-
-            size_t perDrawDataIndex = i + nonInstancedStaticCount;
-            dataMutable.at(perDrawDataIndex).modelMatrix = node->GetGlobalTransform();
         }
 
-        GPUBuffer& gpuBuffer = m_ssboStaticPerDraw.GetGPUBuffer();
-
-        if (nonInstancedStaticCount >= dataMutable.size()) return;
+        // Evaluate everything first so the hierarchy is resolved once rather than per node
+        TransformHierarchy::Global().Update();
 
-        size_t perDrawDataSize = sizeof(PerDrawData);
-        size_t offset = nonInstancedStaticCount * perDrawDataSize;
-        size_t count = dataMutable.size() - nonInstancedStaticCount;
-        size_t size = count * perDrawDataSize; 
+        // each rigid submesh owns a static per draw slot, spawned ones can be anywhere in the buffer
+        m_rigidSlots.clear();
+        for (SceneItemID id : rigidItems)
+        {
+            auto& item = registry.GetItem(id);
+            if (item.slot >= dataMutable.size()) continue; // not picked up by ApplySceneChanges yet
 
-        void* dataPtr = dataMutable.data() + nonInstancedStaticCount;
+            dataMutable[item.slot].modelMatrix = item.node->GetGlobalTransform();
+            m_rigidSlots.push_back(item.slot);
+        }
 
-        Graphics::API()->NamedBufferSubData(gpuBuffer.GetGPUID(), offset, size, dataPtr);
+        if (!m_gpuBuffersGenerated) return;
+        // staged through the ring and copied on the GPU, the per draw buffer is read by draws still in flight
+        Graphics::UploadGPUBufferElements(m_ssboStaticPerDraw.GetGPUBuffer(), m_ssboStaticPerDraw.GetDataImmutable(), m_rigidSlots, m_frameRing);
     }
 
     void DeferredRenderer::UpdateSkinnedAnimations()
     {
-        m_jointMatrices.clear();
-        auto& skinnedMeshData = m_sceneManager.GetNonInstancedDynamic();
-        for (auto& smd : skinnedMeshData)
+        auto& registry = m_sceneManager.GetRegistry();
+        m_jointMatrices.resize(registry.GetJointSlots().Capacity());
+
+        // gather on this thread, the jobs only read animation data and write their own palette slice.
+        // Non instanced and instanced skinned meshes are evaluated the same way, instances share the palette
+        m_skinningTasks.clear();
+        auto gather = [&](const SceneItem& item)
         {
-            auto& mesh = smd.second->mesh;
-            auto& skeleton = smd.second->mesh->GetSkeleton();
+            if (item.jointCount == 0) return;
+
+            auto& mesh = item.node->mesh;
             auto& controller = mesh->node->animController;
-            float currentTime = controller->GetTime();
-            auto& keyframeIndices = controller->GetKeyframeIndices();
+            if (controller == nullptr || controller->CurrAnim() == nullptr || mesh->GetSkeleton() == nullptr) return;
+            // played from a baked palette on the GPU
+            if (controller->UsesBakedPlayback()) return;
+
+            SkinningTask task;
+            task.animation = controller->CurrAnim();
+            task.time = controller->GetTime();
+            task.keyframeIndices = &controller->GetKeyframeIndices();
+            task.skeleton = mesh->GetSkeleton().get();
+            task.inverseBindMatrices = &mesh->GetInverseBindMatrices();
+            task.jointSlot = item.jointSlot;
+            task.jointCount = item.jointCount;
+            task.controller = controller.get();
+            m_skinningTasks.push_back(task);
+        };
+
+        for (SceneItemID id : registry.GetBucketItems(SceneBucket::Skinned))
+        {
+            gather(registry.GetItem(id));
+        }
+        for (SceneItemID id : registry.GetBucketItems(SceneBucket::InstancedSkinned))
+        {
+            gather(registry.GetItem(id));
+        }
+
+        m_skinningEvaluator.Evaluate(m_skinningTasks, m_jointMatrices, JobSystem::Global());
 
-            std::vector<glm::mat4> nodeTransforms(skeleton->joints.size(), glm::mat4(1.0f));
+        m_frameJointMatrices = {};
+        if (m_jointMatrices.empty()) return;
 
-            AnimHelpers::EvaluateAnimation(*controller->CurrAnim(), currentTime, nodeTransforms, keyframeIndices);
+        m_frameJointMatrices = m_frameRing.Upload(m_jointMatrices);
+        if (!m_frameJointMatrices)
+            Graphics::UploadToGPUBuffer(m_ssboGlobalTransforms.GetGPUBuffer(), m_jointMatrices);
+    }
+
+    bool DeferredRenderer::ClaimPreskinnedGeometry(const SceneItem& item)
+    {
+        if (!m_enablePreskinning || !m_preskinnedResource.vao || item.bucket != SceneBucket::Skinned) return false;
+        if (item.submesh.geometry == InvalidGeometry) return false;
+
+        auto skinnedVAO = m_skinnedMeshResources.second.vao.get();
+        if (!SkinnedVertexLayout::FromAttribKey(skinnedVAO->GetAttribKey(), skinnedVAO->GetPosCount()).CanSkin()) return false;
+
+        // the first draw of a geometry gets it, later ones keep skinning in the vertex shader
+        return m_preskinnedGeometry.emplace(item.submesh.geometry, item.slot).second;
+    }
+
+    bool DeferredRenderer::UsesPreskinning(const SceneItem& item) const
+    {
+        if (item.bucket != SceneBucket::Skinned) return false;
+
+        auto it = m_preskinnedGeometry.find(item.submesh.geometry);
+        return it != m_preskinnedGeometry.end() && it->second == item.slot;
+    }
+
+    void DeferredRenderer::BuildSkinJobs()
+    {
+        m_skinJobs.clear();
+        if (m_preskinnedGeometry.empty() || m_skinnedMeshResources.first == 0) return;
 
-            std::vector<glm::mat4> globalTransforms;
-            AnimHelpers::ComputeGlobalTransforms(*skeleton, nodeTransforms, globalTransforms);
+        // after this frame's scene changes and compaction, so the ranges are where the draws read them
+        auto& registry = m_sceneManager.GetRegistry();
+        auto& geometry = m_skinnedMeshResources.second.vao->GetGeometry();
+        for (SceneItemID id : registry.GetBucketItems(SceneBucket::Skinned))
+        {
+            auto& item = registry.GetItem(id);
+            if (!UsesPreskinning(item)) continue;
 
-            std::vector<glm::mat4> jointMatrices;
-            AnimHelpers::ComputeJointMatrices(globalTransforms, mesh->GetInverseBindMatrices(), jointMatrices);
+            auto& range = geometry.GetRange(item.submesh.geometry);
+            for (uint32_t first = 0; first < range.vertexCount; first += VertexSkinning::WorkgroupSize)
+            {
+                uint32_t count = std::min(VertexSkinning::WorkgroupSize, range.vertexCount - first);
+                m_skinJobs.push_back({ range.baseVertex + first, count, item.slot, 0 });
+            }
+        }
+    }
+
+    void DeferredRenderer::PreskinVertices()
+    {
+        if (m_skinJobs.empty() || m_jointTransformCompute == nullptr) return;
 
-            m_jointMatrices.insert(m_jointMatrices.end(), jointMatrices.begin(), jointMatrices.end());
+        auto skinnedVAO = m_skinnedMeshResources.second.vao.get();
+        if (skinnedVAO->GetGPUID() == 0) return;
+
+        // --- OUTPUT, ONE STATIC FORMAT VERTEX PER SKINNED VERTEX ---
+        uint32_t sourceStride = CalculateStrideInBytes(skinnedVAO);
+        size_t vertexCount = skinnedVAO->GetVBO().GetDataImmutable().size() / sourceStride;
+        Graphics::ReserveGPUBuffer(m_preskinnedVertices, vertexCount * sizeof(PreskinnedVertex));
+
+        // growing either buffer gives it a new id
+        uint32_t vertexBuffer = m_preskinnedVertices.GetGPUID();
+        uint32_t indexBuffer = skinnedVAO->GetIBO().GetGPUBuffer().GetGPUID();
+        if (vertexBuffer != m_preskinnedVBO || indexBuffer != m_preskinnedIBO)
+        {
+            Graphics::AttachVertexArrayBuffers(m_preskinnedResource.vao.get(), vertexBuffer, indexBuffer);
+            m_preskinnedVBO = vertexBuffer;
+            m_preskinnedIBO = indexBuffer;
         }
 
-        auto& instancedSkinnedMeshData = m_sceneManager.GetInstancedDynamic();
-        for (auto& ismd : instancedSkinnedMeshData)
+        // --- DISPATCH ---
+        Graphics::API()->BindShader(m_jointTransformCompute->GetProgramId());
+
+        auto jobs = m_frameRing.Upload(m_skinJobs);
+        if (jobs)
         {
-            auto& mesh = ismd.second.second->mesh;
-            auto& skeleton = mesh->GetSkeleton();
-            auto& controller = mesh->node->animController;
+            Graphics::BindTransient(GL_SHADER_STORAGE_BUFFER, 6, jobs);
+        }
+        else
+        {
+            Graphics::UploadToGPUBuffer(m_ssboSkinJobs.GetGPUBuffer(), m_skinJobs);
+            Graphics::BindGPUBuffer(m_ssboSkinJobs.GetGPUBuffer(), 6);
+        }
+
+        Graphics::BindGPUBuffer(skinnedVAO->GetVBO().GetGPUBuffer(), 0);
+        Graphics::BindGPUBuffer(m_ssboDynamicPerDraw.GetGPUBuffer(), 1);
+        Graphics::BindGPUBuffer(m_preskinnedVertices, 2);
+        BindJointMatrices(3);
+        BindBakedClips(4, 5);
+
+        // offsets in words, a missing attribute arrives as -1
+        auto layout = SkinnedVertexLayout::FromAttribKey(skinnedVAO->GetAttribKey(), skinnedVAO->GetPosCount());
+        auto words = [](uint32_t offset) { return offset == SkinnedVertexLayout::NoAttribute ? offset : offset / 4; };
+        m_jointTransformCompute->SetUniformi("u_Stride", layout.stride / 4);
+        m_jointTransformCompute->SetUniformi("u_Position", words(layout.position));
+        m_jointTransformCompute->SetUniformi("u_Normal", words(layout.normal));
+        m_jointTransformCompute->SetUniformi("u_TexCoord", words(layout.texCoord));
+        m_jointTransformCompute->SetUniformi("u_Tangent", words(layout.tangent));
+        m_jointTransformCompute->SetUniformi("u_Joints", words(layout.joints));
+        m_jointTransformCompute->SetUniformi("u_Weights", words(layout.weights));
+        m_jointTransformCompute->SetUniformi("u_JobCount", static_cast<uint32_t>(m_skinJobs.size()));
+        m_jointTransformCompute->SetUniformf("u_Time", m_shaderTime);
+
+        // one workgroup per job, wrapped into rows past the dispatch size limit
+        auto jobCount = static_cast<uint32_t>(m_skinJobs.size());
+        uint32_t groupsX = std::min(jobCount, MaxComputeGroups);
+        Graphics::API()->DispatchCompute(groupsX, (jobCount + groupsX - 1) / groupsX, 1);
+
+        // the shadow and G-buffer passes fetch the output as vertex attributes
+        Graphics::API()->SyncVertexAttribBarrier();
+    }
+
+    void DeferredRenderer::ReserveFrameUploads()
+    {
+        auto& registry = m_sceneManager.GetRegistry();
+        size_t alignment = m_frameRing.GetAlignment();
+
+        // worst case for the rigid runs is one run per slot, each aligned
+        size_t rigidCount = registry.GetBucketItems(SceneBucket::RigidAnimated).size();
+        size_t bytes = sizeof(ShaderGlobalData) + alignment;
+        bytes += registry.GetJointSlots().Capacity() * sizeof(glm::mat4) + alignment;
+        bytes += rigidCount * (sizeof(PerDrawData) + alignment);
+        bytes += m_skinJobs.size() * sizeof(SkinJobGPU) + alignment;
+
+        m_frameRing.Reserve(bytes);
+    }
+
+    void DeferredRenderer::BindShaderGlobalData(int bindPoint)
+    {
+        if (m_frameShaderData)
+            Graphics::BindTransient(GL_UNIFORM_BUFFER, bindPoint, m_frameShaderData);
+        else
+            Graphics::BindGPUBuffer(m_gShaderData.GetGPUBuffer(), bindPoint);
+    }
 
-            std::vector<glm::mat4> nodeTransforms(skeleton->joints.size(), glm::mat4(1.0f));
+    void DeferredRenderer::BindJointMatrices(int bindPoint)
+    {
+        if (m_frameJointMatrices)
+            Graphics::BindTransient(GL_SHADER_STORAGE_BUFFER, bindPoint, m_frameJointMatrices);
+        else
+            Graphics::BindGPUBuffer(m_ssboGlobalTransforms.GetGPUBuffer(), bindPoint);
+    }
 
-            float currentTime = controller->GetTime();
-            auto& keyframeIndices = controller->GetKeyframeIndices();
-            AnimHelpers::EvaluateAnimation(*controller->CurrAnim(), currentTime, nodeTransforms, keyframeIndices);
+    AnimationController* DeferredRenderer::GetBakedController(const SceneItem& item, uint32_t instance)
+    {
+        bool instanced = item.bucket == SceneBucket::InstancedSkinned;
+        Node* owner = instanced ? item.submesh.instanceTransforms->at(instance) : item.node;
+        Node* meshNode = item.node->mesh->node;
+        auto* controller = owner->animController ? owner->animController.get() : (meshNode ? meshNode->animController.get() : nullptr);
+        if (controller == nullptr || !controller->UsesBakedPlayback() || controller->CurrAnim() == nullptr) return nullptr;
+        return controller;
+    }
 
-            std::vector<glm::mat4> globalTransforms;
-            AnimHelpers::ComputeGlobalTransforms(*skeleton, nodeTransforms, globalTransforms);
+    void DeferredRenderer::RequestBakedClips(const SceneItem& item)
+    {
+        if (SceneRegistry::GetPerDrawSpace(item.bucket) != PerDrawSpace::Skinned) return;
 
-            std::vector<glm::mat4> jointMatrices;
-            AnimHelpers::ComputeJointMatrices(globalTransforms, mesh->GetInverseBindMatrices(), jointMatrices);
+        const auto& mesh = item.node->mesh;
+        auto skeleton = mesh->GetSkeleton();
+        if (skeleton == nullptr) return;
 
-            m_jointMatrices.insert(m_jointMatrices.end(), jointMatrices.begin(), jointMatrices.end());
+        for (uint32_t i = 0; i < item.slotCount; ++i)
+        {
+            AnimationController* controller = GetBakedController(item, i);
+            if (controller == nullptr) continue;
+
+            Animation* animation = controller->CurrAnim();
+            std::pair<const Animation*, const Mesh*> key(animation, mesh.get());
+            if (m_bakedClipIndices.count(key) || m_bakeJobs.count(key)) continue;
+
+            // baked once per animation and skeleton, and cached on disk for the next run. The file I/O and a
+            // bake on a cache miss stay off the render thread, the draws play live until it has finished
+            auto job = std::make_shared<BakeJob>();
+            m_bakeJobs.emplace(key, job);
+            JobSystem::Global().SubmitBackground([job, animation, skeleton, inverseBind = mesh->GetInverseBindMatrices(),
+                folder = m_assetFolder + "Cache/Animations/", frameRate = m_bakedFrameRate, format = m_bakedFormat]()
+                {
+                    job->succeeded = AnimationBaker::BakeCached(folder, *animation, *skeleton, inverseBind, frameRate, format, job->baked);
+                    job->done.store(true, std::memory_order_release);
+                }, &m_bakeJobsInFlight);
         }
+    }
 
-        if (skinnedMeshData.size() > 0 || instancedSkinnedMeshData.size() > 0)
-            Graphics::UploadToGPUBuffer(m_ssboGlobalTransforms.GetGPUBuffer(), m_jointMatrices);
-        
+    bool DeferredRenderer::CollectBakedClips()
+    {
+        bool finished = false;
+        for (auto it = m_bakeJobs.begin(); it != m_bakeJobs.end();)
+        {
+            BakeJob& job = *it->second;
+            if (!job.done.load(std::memory_order_acquire))
+            {
+                ++it;
+                continue;
+            }
+
+            uint32_t clip = 0;
+            if (job.succeeded)
+            {
+                auto& palettes = m_ssboBakedPalettes.GetDataMutable();
+                auto& clips = m_ssboBakedClips.GetDataMutable();
+                clips.push_back(AnimationBaker::MakeGPUClip(job.baked, static_cast<uint32_t>(palettes.size())));
+                palettes.insert(palettes.end(), job.baked.words.begin(), job.baked.words.end());
+                clip = static_cast<uint32_t>(clips.size());
+                m_bakedClipsDirty = true;
+            }
+
+            m_bakedClipIndices.emplace(it->first, clip);
+            it = m_bakeJobs.erase(it);
+            finished = true;
+        }
+        return finished;
+    }
+
+    uint32_t DeferredRenderer::GetBakedClip(const Animation* animation, const Mesh* mesh) const
+    {
+        auto found = m_bakedClipIndices.find(std::make_pair(animation, mesh));
+        return found != m_bakedClipIndices.end() ? found->second : 0;
+    }
+
+    void DeferredRenderer::UploadBakedClips()
+    {
+        if (!m_bakedClipsDirty) return;
+
+        // clips are only ever appended, growing keeps what is already there
+        auto& clips = m_ssboBakedClips.GetDataImmutable();
+        auto& palettes = m_ssboBakedPalettes.GetDataImmutable();
+        Graphics::ReserveGPUBuffer(m_ssboBakedClips.GetGPUBuffer(), clips.size() * sizeof(BakedClipGPU));
+        Graphics::ReserveGPUBuffer(m_ssboBakedPalettes.GetGPUBuffer(), palettes.size() * sizeof(uint32_t));
+        Graphics::UploadToGPUBuffer(m_ssboBakedClips.GetGPUBuffer(), clips);
+        Graphics::UploadToGPUBuffer(m_ssboBakedPalettes.GetGPUBuffer(), palettes);
+        m_bakedClipsDirty = false;
+    }
+
+    void DeferredRenderer::BindBakedClips(int clipsBindPoint, int palettesBindPoint)
+    {
+        if (m_ssboBakedClips.GetDataImmutable().empty()) return;
+
+        Graphics::BindGPUBuffer(m_ssboBakedClips.GetGPUBuffer(), clipsBindPoint);
+        Graphics::BindGPUBuffer(m_ssboBakedPalettes.GetGPUBuffer(), palettesBindPoint);
     }
 
     void DeferredRenderer::DirectionalShadowMapPass(FrameRenderData& frd)
@@ -308,6 +587,7 @@ namespace JLEngine
         glm::vec3 currentSunDir = m_atmosphereParams.sunDir;
 
         m_dlShadowMap->UpdateCascades(frd.viewMatrix, frd.projMatrix, currentSunDir, frd.nearClip, frd.fovRad, frd.aspect);
+        CullShadowCasters();
 
         ShaderProgram* shadowMapShader = m_dlShadowMap->GetShadowMapShader();
         ShaderProgram* shadowMapSkinningShader = m_dlShadowMap->GetShadowMapSkinningShader();
@@ -327,7 +607,14 @@ namespace JLEngine
             {
                 if (resource.vao->GetGPUID() == 0) continue;
 
-                DrawGeometry(resource, stride);
+                DrawShadowCasters(resource, cascadeIdx, stride);
+            }
+
+            // --- PRE-SKINNED MESHES, STATIC FORMAT ---
+            if (!m_skinJobs.empty() && m_preskinnedResource.vao->GetGPUID() != 0)
+            {
+                Graphics::BindGPUBuffer(m_ssboDynamicPerDraw.GetGPUBuffer(), 0);
+                DrawShadowCasters(m_preskinnedResource, cascadeIdx, stride);
             }
 
             // --- DYNAMIC MESHES --- 
@@ -335,9 +622,11 @@ namespace JLEngine
             {
                 Graphics::API()->BindShader(shadowMapSkinningShader->GetProgramId());
                 shadowMapSkinningShader->SetUniform("u_LightSpaceMatrix", m_dlShadowMap->GetCascadeLightSpaceMatrices()[cascadeIdx]);
+                shadowMapSkinningShader->SetUniform("u_Time", m_shaderTime);
                 Graphics::BindGPUBuffer(m_ssboDynamicPerDraw.GetGPUBuffer(), 0);
-                Graphics::BindGPUBuffer(m_ssboGlobalTransforms.GetGPUBuffer(), 1);
-                DrawGeometry(m_skinnedMeshResources.second, stride);
+                BindJointMatrices(1);
+                BindBakedClips(2, 3);
+                DrawShadowCasters(m_skinnedMeshResources.second, cascadeIdx, stride);
             }
         }
 
@@ -361,29 +650,25 @@ namespace JLEngine
 
         Graphics::BindGPUBuffer(m_ssboMaterials.GetGPUBuffer(), 0);
         Graphics::BindGPUBuffer(m_ssboStaticPerDraw.GetGPUBuffer(), 1);
-        Graphics::BindGPUBuffer(m_gShaderData.GetGPUBuffer(), 2);
+        BindShaderGlobalData(2);
 
         // --- STATIC MESHES ---
         for (const auto& [key, resource] : m_staticResources)
         {
             if (resource.vao->GetGPUID() == 0) continue;
 
-            DrawGeometry(resource, stride);
+            m_gBufferShader->SetUniformi("u_CompactVertices", IsCompactVertexFormat(key));
+            DrawVisibleGeometry(resource, stride);
         }
 
-        // --- SKINNING SETUP FOR DYNAMIC MESHES ---
-        //int numJoints = (int)m_ssboJointMatrices.GetDataImmutable().size();
-        //int workGroupSize = 32; 
-        //int numWorkGroups = (numJoints + workGroupSize - 1) / workGroupSize;
-        //
-        //Graphics::API()->BindShader(m_jointTransformCompute->GetProgramId());
-        //Graphics::BindGPUBuffer(m_ssboJointMatrices.GetGPUBuffer(), 0);
-        //Graphics::BindGPUBuffer(m_globalTransforms.GetGPUBuffer(), 1);
-        //Graphics::API()->BindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
-        //Graphics::API()->BindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, 0);
-        //Graphics::API()->DispatchCompute(numWorkGroups, 1, 1);
-        //Graphics::API()->SyncCompute();
-        //Graphics::API()->SyncSSBO();
+        // --- PRE-SKINNED MESHES ---
+        // skinned by PreskinVertices, only the per draw data differs from a static mesh
+        if (!m_skinJobs.empty() && m_preskinnedResource.vao->GetGPUID() != 0)
+        {
+            m_gBufferShader->SetUniformi("u_CompactVertices", 0);
+            Graphics::BindGPUBuffer(m_ssboDynamicPerDraw.GetGPUBuffer(), 1);
+            DrawGeometry(m_preskinnedResource, stride);
+        }
 
         if (m_skinnedMeshResources.first == 0) return;
         if (m_skinnedMeshResources.second.vao->GetGPUID() != 0)
@@ -392,8 +677,9 @@ namespace JLEngine
             Graphics::API()->BindShader(m_skinningGBufferShader->GetProgramId());
             Graphics::BindGPUBuffer(m_ssboMaterials.GetGPUBuffer(), 0);
             Graphics::BindGPUBuffer(m_ssboDynamicPerDraw.GetGPUBuffer(), 1);
-            Graphics::BindGPUBuffer(m_gShaderData.GetGPUBuffer(), 2);
-            Graphics::BindGPUBuffer(m_ssboGlobalTransforms.GetGPUBuffer(), 3);
+            BindShaderGlobalData(2);
+            BindJointMatrices(3);
+            BindBakedClips(4, 5);
 
             if (m_skinnedMeshResources.second.vao->GetGPUID() != 0)
                 DrawGeometry(m_skinnedMeshResources.second, stride);
@@ -402,6 +688,9 @@ namespace JLEngine
 
     void DeferredRenderer::Render(FlyCamera& camera, double dt)
     {
+        // waits only if the GPU is still reading the partition from frameCount frames ago
+        m_frameRing.BeginFrame();
+
         auto viewFrustum = camera.GetViewFrustum();
         FrameRenderData frd{};
         frd.viewMatrix = camera.GetViewMatrix();
@@ -422,19 +711,33 @@ namespace JLEngine
         gShaderData.camDir = glm::vec4(frd.eyeDir, 1.0f);
         double time = static_cast<float>(glfwGetTime());
         gShaderData.timeInfo = glm::vec2(dt, time);
+        m_shaderTime = static_cast<float>(time);
         gShaderData.windowSize = glm::vec2(m_width, m_height);
         gShaderData.frameCount = m_frameCount;
 
-        // update camera info
-        Graphics::UploadToGPUBuffer(m_gShaderData.GetGPUBuffer(), gShaderData, 0);
-
         // prepare the default framebuffer
         Graphics::API()->BindFrameBuffer(0);
         Graphics::API()->ClearColour(0.0f, 0.0f, 0.0f, 0.0f);
         Graphics::API()->Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        ApplySceneChanges();
+        UpdateGeometryBatches();
+        BuildSkinJobs();
+        // before any of this frame's ring allocations, growing the ring drops them
+        ReserveFrameUploads();
+
+        // update camera info, the UBO is only used if the ring is full
+        m_frameShaderData = m_frameRing.Upload(&gShaderData, sizeof(ShaderGlobalData));
+        if (!m_frameShaderData)
+            Graphics::UploadToGPUBuffer(m_gShaderData.GetGPUBuffer(), gShaderData, 0);
+
         UpdateRigidAnimations();
         UpdateSkinnedAnimations();
+        PreskinVertices();
+
+        viewFrustum.ExtractPlanes(frd.projMatrix * frd.viewMatrix);
+        CullStaticGeometry(viewFrustum);
+        UpdateTextureStreaming(frd);
 
         DirectionalShadowMapPass(frd);
         GBufferPass(frd.viewMatrix, frd.projMatrix);
@@ -492,6 +795,8 @@ namespace JLEngine
         DrawUI();
         RenderDebugTools(frd);
 
+        m_frameRing.EndFrame();
+
         m_lastEyePos = frd.eyePos;
         m_frameCount++;
 
@@ -519,7 +824,7 @@ namespace JLEngine
         Graphics::API()->Clear(GL_COLOR_BUFFER_BIT);
         Graphics::API()->SetViewport(0, 0, m_width, m_height);
 
-        Graphics::BindGPUBuffer(m_gShaderData.GetGPUBuffer(), 4);
+        BindShaderGlobalData(4);
         Graphics::BindGPUBuffer(m_ddgi->GetProbeSSBO().GetGPUBuffer(), 7);
         Graphics::BindGPUBuffer(m_lights.GetGPUBuffer(), 8);
 
@@ -638,11 +943,12 @@ namespace JLEngine
         Graphics::API()->BindTextures(0, 1, textures);
 
         auto stride = static_cast<uint32_t>(sizeof(JLEngine::DrawIndirectCommand));
-        auto& vaoRes = m_transparentResources.begin()->second;
+        auto& [vaoKey, vaoRes] = *m_transparentResources.begin();
+        m_blendShader->SetUniformi("u_CompactVertices", IsCompactVertexFormat(vaoKey));
 
         Graphics::BindGPUBuffer(m_ssboMaterials.GetGPUBuffer(), 0);
         Graphics::BindGPUBuffer(m_ssboTransparentPerDraw.GetGPUBuffer(), 1);
-        Graphics::BindGPUBuffer(m_gShaderData.GetGPUBuffer(), 2);
+        BindShaderGlobalData(2);
 
         if (m_lastEyePos != frd.eyePos) // dont need to sort until we move
             m_sceneManager.SortTransparentBackToFront(frd.eyePos);
@@ -951,40 +1257,36 @@ namespace JLEngine
         Graphics::API()->UnmapNamedBuffer(dataSSBO.GetGPUBuffer().GetGPUID());
     }
 
-    void DeferredRenderer::DebugAABB()
+    void DeferredRenderer::UpdateSceneBVH()
     {
-        const auto& submeshNodes = m_sceneManager.GetSubmeshes();
+        auto& submeshNodes = m_sceneManager.GetSubmeshes();
+        SceneBVH::GatherWorldBounds(submeshNodes, m_sceneBounds);
 
-        Im3d::PushColor(Im3d::Color_Yellow);
+        // topology only changes when submeshes are added or removed, otherwise moved nodes just refit
+        if (m_sceneBVH.GetPrimitiveCount() != m_sceneBounds.size() || m_sceneBVH.Empty())
+            m_sceneBVH.Build(m_sceneBounds);
+        else
+            m_sceneBVH.Refit(m_sceneBounds);
+    }
 
-        for (const auto& smNodePair : submeshNodes)
-        {
-            auto& localAABB = smNodePair.first.aabb;
-            auto worldTransform = smNodePair.second->GetGlobalTransform();
-            glm::vec3 corners[8] =
-            {
-                { localAABB.min.x, localAABB.min.y, localAABB.min.z },
-                { localAABB.min.x, localAABB.min.y, localAABB.max.z },
-                { localAABB.min.x, localAABB.max.y, localAABB.min.z },
-                { localAABB.min.x, localAABB.max.y, localAABB.max.z },
-                { localAABB.max.x, localAABB.min.y, localAABB.min.z },
-                { localAABB.max.x, localAABB.min.y, localAABB.max.z },
-                { localAABB.max.x, localAABB.max.y, localAABB.min.z },
-                { localAABB.max.x, localAABB.max.y, localAABB.max.z }
-            };
+    void DeferredRenderer::DebugAABB(FrameRenderData& frd)
+    {
+        UpdateSceneBVH();
 
-            glm::vec3 transformedMin = glm::vec3(worldTransform * glm::vec4(corners[0], 1.0f));
-            glm::vec3 transformedMax = transformedMin;
+        ViewFrustum frustum;
+        frustum.ExtractPlanes(frd.projMatrix * frd.viewMatrix);
 
-            for (int i = 1; i < 8; ++i)
-            {
-                glm::vec3 transformed = glm::vec3(worldTransform * glm::vec4(corners[i], 1.0f));
-                transformedMin = glm::min(transformedMin, transformed);
-                transformedMax = glm::max(transformedMax, transformed);
-            }
+        std::vector<uint32_t> visibleBoxes;
+        m_sceneBVH.QueryFrustum(frustum.GetPlanes(), visibleBoxes);
 
-            glm::vec3 center = (transformedMin + transformedMax) * 0.5f;
-            glm::vec3 halfExtents = (transformedMax - transformedMin) * 0.5f;
+        Im3d::PushColor(Im3d::Color_Yellow);
+
+        for (uint32_t primitive : visibleBoxes)
+        {
+            const AABB& worldAABB = m_sceneBVH.GetPrimitiveBounds(primitive);
+
+            glm::vec3 center = (worldAABB.min + worldAABB.max) * 0.5f;
+            glm::vec3 halfExtents = (worldAABB.max - worldAABB.min) * 0.5f;
 
             m_im3dManager->DrawBox(center, halfExtents, Im3d::Color_Red);
         }
@@ -1029,7 +1331,7 @@ namespace JLEngine
         ImGui::End();
 
         if (m_showDDGI) { DebugDDGI(); }
-        if (m_showAABB) { DebugAABB(); }
+        if (m_showAABB) { DebugAABB(frd); }
         if (m_showDDGIRays) { DebugDDGIRays(); }
 
         // render im3d here
@@ -1089,7 +1391,8 @@ namespace JLEngine
         auto resource = VAOResource
         {
             vao,
-            std::make_shared<IndirectDrawBuffer>() 
+            std::make_shared<IndirectDrawBuffer>(),
+            std::make_shared<IndirectDrawBuffer>()
         };
 
         if (vaoType == VAOType::STATIC)
@@ -1099,6 +1402,17 @@ namespace JLEngine
         else if (vaoType == VAOType::DYNAMIC)
         {
             m_skinnedMeshResources = std::make_pair(key, resource);
+
+            // static format view of the compute skinned vertices, drawn with the skinned index buffer
+            auto preskinnedVAO = std::make_shared<VertexArrayObject>("Preskinned");
+            preskinnedVAO->SetVertexAttribKey(VertexSkinning::PreskinnedAttribKey);
+            m_preskinnedResource = VAOResource
+            {
+                preskinnedVAO,
+                std::make_shared<IndirectDrawBuffer>(),
+                std::make_shared<IndirectDrawBuffer>()
+            };
+            m_preskinnedVBO = m_preskinnedIBO = 0;
         }
         else if (vaoType == VAOType::JL_TRANSPARENT)
         {
@@ -1113,6 +1427,7 @@ namespace JLEngine
             auto resource = VAOResource
             {
                 vao,
+                std::make_shared<IndirectDrawBuffer>(),
                 std::make_shared<IndirectDrawBuffer>()
             };
 
@@ -1127,6 +1442,50 @@ namespace JLEngine
         }
     }
     
+    void DeferredRenderer::AddStreamedVAOs(VAOType vaoType, std::unordered_map<VertexAttribKey, std::shared_ptr<VertexArrayObject>>& vaos)
+    {
+        for (auto& [key, vao] : vaos)
+        {
+            VAOResource* resource = nullptr;
+            if (vaoType == VAOType::STATIC)
+            {
+                if (m_staticResources.find(key) != m_staticResources.end()) continue;
+                AddVAO(vaoType, key, vao);
+                resource = &m_staticResources[key];
+            }
+            else if (vaoType == VAOType::JL_TRANSPARENT)
+            {
+                if (m_transparentResources.find(key) != m_transparentResources.end()) continue;
+                AddVAO(vaoType, key, vao);
+                resource = &m_transparentResources[key];
+            }
+            else if (vaoType == VAOType::DYNAMIC)
+            {
+                // every skinned mesh draws from the one skinned vertex array, like FinalizeLoading sets up
+                if (m_skinnedMeshResources.first != 0) continue;
+                AddVAO(vaoType, key, vao);
+                resource = &m_skinnedMeshResources.second;
+            }
+
+            if (resource == nullptr || !m_gpuBuffersGenerated) continue;
+
+            // what GenerateGPUBuffers would have made, the draw lists fill in as the nodes are added
+            Graphics::CreateVertexArray(vao.get());
+            Graphics::CreateIndirectDrawBuffer(resource->drawBuffer.get());
+            if (vaoType == VAOType::STATIC)
+            {
+                Graphics::CreateIndirectDrawBuffer(resource->visibleDrawBuffer.get());
+                CreateShadowDrawBuffers(*resource);
+            }
+            else if (vaoType == VAOType::DYNAMIC)
+            {
+                CreateShadowDrawBuffers(*resource);
+                Graphics::CreateIndirectDrawBuffer(m_preskinnedResource.drawBuffer.get());
+                CreateShadowDrawBuffers(m_preskinnedResource);
+            }
+        }
+    }
+
     void DeferredRenderer::CycleDebugMode()
     {
         static DebugModes modes[4] = 
@@ -1171,6 +1530,42 @@ namespace JLEngine
         m_dlShadowMap->DrawDebugUI();
         m_postProcessing->DrawDebugUI();
 
+        ImGui::Begin("Culling");
+        ImGui::Checkbox("Frustum Culling", &m_enableFrustumCulling);
+        ImGui::Text("Static draws: %u visible, %u culled (of %u)", m_cullingStats.visible, m_cullingStats.culled, m_cullingStats.tested);
+        ImGui::Checkbox("Shadow Caster Culling", &m_enableShadowCasterCulling);
+        for (size_t cascade = 0; cascade < m_shadowCasterCuller.GetCascadeCount(); ++cascade)
+        {
+            const auto& stats = m_shadowCasterCuller.GetStats(cascade);
+            ImGui::Text("Cascade %zu casters: %u visible, %u culled (of %u)", cascade, stats.visible, stats.culled, stats.tested);
+        }
+        ImGui::End();
+
+        ImGui::Begin("Geometry Batches");
+        ImGui::Checkbox("Defragment", &m_enableGeometryDefrag);
+        for (auto& [key, resource] : m_staticResources)
+        {
+            auto& vertices = resource.vao->GetGeometry().GetVertexAllocator();
+            ImGui::Text("Static %u: %u/%u vertices, %zu holes", key, vertices.UsedSize(), vertices.Capacity(), vertices.FreeBlockCount());
+        }
+        ImGui::End();
+
+        ImGui::Begin("Frame Uploads");
+        const auto& ringStats = m_frameRing.GetStats();
+        ImGui::Text("Ring: %zu KB x %u frames", m_frameRing.GetBytesPerFrame() / 1024, m_frameRing.GetFrameCount());
+        ImGui::Text("This frame: %zu KB, peak %zu KB", ringStats.frameBytes / 1024, ringStats.peakFrameBytes / 1024);
+        ImGui::Text("Fence waits: %u, overflows: %u, reallocations: %u", ringStats.fenceWaits, ringStats.overflows, ringStats.reallocations);
+        ImGui::End();
+
+        ImGui::Begin("Texture Streaming");
+        TextureStreamer* streamer = m_resourceLoader->GetTextureStreamer();
+        const auto& residency = streamer->GetResidency();
+        ImGui::Checkbox("Stream New Textures", &streamer->Enabled);
+        ImGui::Text("Textures: %zu", residency.GetCount());
+        ImGui::Text("Resident: %llu / %llu MB", static_cast<unsigned long long>(residency.GetUsedBytes() >> 20),
+            static_cast<unsigned long long>(residency.GetBudget() >> 20));
+        ImGui::End();
+
         ImGui::Begin("Light Settings");
         ImGui::SliderFloat("Specular Factor", &m_specularIndirectFactor, 0.1f, 3.0f);
         ImGui::SliderFloat("Diffuse Factor", &m_diffuseIndirectFactor, 0.1f, 3.0f);
@@ -1198,6 +1593,231 @@ namespace JLEngine
         m_graphics->MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, size, stride);
     }
 
+    void DeferredRenderer::DrawVisibleGeometry(const VAOResource& vaoResource, uint32_t stride)
+    {
+        auto& drawBuffer = vaoResource.visibleDrawBuffer;
+        auto size = static_cast<uint32_t>(drawBuffer->GetDataImmutable().size());
+        if (size == 0) return;
+
+        m_graphics->BindBuffer(GL_DRAW_INDIRECT_BUFFER, drawBuffer->GetGPUBuffer().GetGPUID());
+        m_graphics->BindVertexArray(vaoResource.vao->GetGPUID());
+        m_graphics->MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, size, stride);
+    }
+
+    void DeferredRenderer::CullStaticGeometry(const ViewFrustum& frustum)
+    {
+        auto& registry = m_sceneManager.GetRegistry();
+
+        // slots are the static per draw slots, sized when the scene changes are recorded
+        size_t slotCount = registry.GetSlots(PerDrawSpace::Static).Capacity();
+        if (m_frustumCuller.Size() != slotCount) return;
+
+        // --- WORLD SPACE BOUNDS AT EACH ITEM'S SLOT ---
+        // instanced and freed slots keep whatever they had, nothing draws from their visibility
+        for (SceneItemID id : registry.GetBucketItems(SceneBucket::Static))
+        {
+            auto& item = registry.GetItem(id);
+            m_frustumCuller.SetBounds(item.slot, item.submesh.aabb, item.node->GetGlobalTransform());
+        }
+        for (SceneItemID id : registry.GetBucketItems(SceneBucket::RigidAnimated))
+        {
+            auto& item = registry.GetItem(id);
+            m_frustumCuller.SetBounds(item.slot, item.submesh.aabb, item.node->GetGlobalTransform());
+        }
+
+        if (m_enableFrustumCulling)
+        {
+            m_cullingStats = m_frustumCuller.Cull(frustum.GetPlanes(), m_visibility);
+        }
+        else
+        {
+            m_visibility.assign(slotCount, 1);
+            m_cullingStats = { static_cast<uint32_t>(slotCount), static_cast<uint32_t>(slotCount), 0 };
+        }
+
+        // --- COMPACT THE DRAW COMMANDS PER VAO ---
+        for (auto& [key, resource] : m_staticResources)
+        {
+            auto& allCommands = resource.drawBuffer->GetDataImmutable();
+            auto& visibleCommands = resource.visibleDrawBuffer->GetDataMutable();
+            visibleCommands.clear();
+
+            for (size_t i = 0; i < allCommands.size(); ++i)
+            {
+                uint32_t cullSlot = resource.cullSlots[i];
+                if (cullSlot == VAOResource::NoCullSlot || m_visibility[cullSlot])
+                {
+                    visibleCommands.push_back(allCommands[i]);
+                }
+            }
+
+            if (!visibleCommands.empty())
+            {
+                Graphics::UploadToGPUBuffer(resource.visibleDrawBuffer->GetGPUBuffer(), visibleCommands);
+            }
+        }
+    }
+
+    void DeferredRenderer::UpdateTextureStreaming(const FrameRenderData& frd)
+    {
+        TextureStreamer* streamer = m_resourceLoader->GetTextureStreamer();
+        auto* materialManager = m_resourceLoader->GetMaterialManager();
+        auto& registry = m_sceneManager.GetRegistry();
+
+        // --- REQUESTS FROM THIS FRAME'S DRAWS ---
+        // every drawn submesh asks for its material's textures at the size its bounds cover on screen,
+        // static draws the frustum culled ask for nothing
+        streamer->BeginFrame();
+        for (size_t bucketIndex = 0; bucketIndex < static_cast<size_t>(SceneBucket::Count); ++bucketIndex)
+        {
+            auto bucket = static_cast<SceneBucket>(bucketIndex);
+            if (bucket == SceneBucket::None) continue;
+            bool culled = bucket == SceneBucket::Static || bucket == SceneBucket::RigidAnimated;
+
+            for (SceneItemID id : registry.GetBucketItems(bucket))
+            {
+                auto& item = registry.GetItem(id);
+                if (culled && item.slot < m_visibility.size() && !m_visibility[item.slot]) continue;
+
+                auto material = materialManager->Get(item.submesh.materialHandle);
+                if (material == nullptr) continue;
+
+                const glm::mat4& world = item.node->GetGlobalTransform();
+                const AABB& aabb = item.submesh.aabb;
+                glm::vec3 center = glm::vec3(world * glm::vec4((aabb.min + aabb.max) * 0.5f, 1.0f));
+                float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2])) });
+                float radius = glm::length(aabb.max - aabb.min) * 0.5f * scale;
+                float pixels = TextureResidency::ScreenSize(radius, glm::distance(center, frd.eyePos), frd.fovRad, static_cast<float>(m_height));
+
+                for (const auto* texture : { &material->baseColorTexture, &material->metallicRoughnessTexture,
+                    &material->normalTexture, &material->occlusionTexture, &material->emissiveTexture })
+                {
+                    if (*texture) streamer->Request(texture->get(), pixels);
+                }
+            }
+        }
+        streamer->Update();
+
+        // --- PATCH THE MATERIALS ---
+        // the swapped textures have new bindless handles, only the materials using them are rewritten
+        const auto& changed = streamer->GetChangedTextures();
+        if (changed.empty() || !m_gpuBuffersGenerated) return;
+
+        std::unordered_set<const Texture*> changedTextures(changed.begin(), changed.end());
+        auto uses = [&changedTextures](const std::shared_ptr<Texture>& texture) { return texture && changedTextures.count(texture.get()); };
+
+        auto& materials = m_ssboMaterials.GetDataMutable();
+        std::vector<uint32_t> patched;
+        for (const auto& [materialHandle, materialID] : m_materialIDMap)
+        {
+            auto material = materialManager->Get(materialHandle);
+            if (material == nullptr || materialID >= materials.size()) continue;
+            if (uses(material->baseColorTexture) || uses(material->metallicRoughnessTexture) || uses(material->normalTexture) ||
+                uses(material->occlusionTexture) || uses(material->emissiveTexture))
+            {
+                materials[materialID] = MakeMaterialGPU(*material);
+                patched.push_back(static_cast<uint32_t>(materialID));
+            }
+        }
+        Graphics::UploadGPUBufferElements(m_ssboMaterials.GetGPUBuffer(), materials, patched);
+    }
+
+    void DeferredRenderer::DrawShadowCasters(const VAOResource& vaoResource, int cascadeIdx, uint32_t stride)
+    {
+        // no per cascade buffers yet (GenerateGPUBuffers hasn't run), draw everything
+        if (static_cast<size_t>(cascadeIdx) >= vaoResource.shadowDrawBuffers.size())
+        {
+            DrawGeometry(vaoResource, stride);
+            return;
+        }
+
+        if (vaoResource.shadowCasterCounts[cascadeIdx] == 0) return;
+
+        auto& drawBuffer = vaoResource.shadowDrawBuffers[cascadeIdx];
+        auto size = static_cast<uint32_t>(drawBuffer->GetDataImmutable().size());
+        m_graphics->BindBuffer(GL_DRAW_INDIRECT_BUFFER, drawBuffer->GetGPUBuffer().GetGPUID());
+        m_graphics->BindVertexArray(vaoResource.vao->GetGPUID());
+        m_graphics->MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, size, stride);
+    }
+
+    void DeferredRenderer::CullShadowCasters()
+    {
+        auto& cascadeMatrices = m_dlShadowMap->GetCascadeLightSpaceMatrices();
+        auto& registry = m_sceneManager.GetRegistry();
+        size_t staticSlots = registry.GetSlots(PerDrawSpace::Static).Capacity();
+        size_t skinnedSlots = registry.GetSlots(PerDrawSpace::Skinned).Capacity();
+
+        // static bounds were written by CullStaticGeometry earlier in the frame, skinned ones are set here
+        bool staticReady = m_frustumCuller.Size() == staticSlots;
+        bool skinnedReady = m_skinnedBounds.Size() == skinnedSlots;
+
+        if (skinnedReady)
+        {
+            // bind pose bounds don't follow the animation, pad them so moving limbs aren't culled
+            for (SceneItemID id : registry.GetBucketItems(SceneBucket::Skinned))
+            {
+                auto& item = registry.GetItem(id);
+                glm::vec3 padding = (item.submesh.aabb.max - item.submesh.aabb.min) * 0.5f;
+                AABB padded = { item.submesh.aabb.min - padding, item.submesh.aabb.max + padding };
+                m_skinnedBounds.SetBounds(item.slot, padded, item.node->GetGlobalTransform());
+            }
+        }
+
+        if (m_enableShadowCasterCulling && staticReady)
+            m_shadowCasterCuller.Cull(m_frustumCuller, cascadeMatrices);
+        else
+            m_shadowCasterCuller.SetAllVisible(staticSlots, cascadeMatrices.size());
+
+        if (m_enableShadowCasterCulling && skinnedReady)
+            m_skinnedCasterCuller.Cull(m_skinnedBounds, cascadeMatrices);
+        else
+            m_skinnedCasterCuller.SetAllVisible(skinnedSlots, cascadeMatrices.size());
+
+        // --- BUILD THE PER CASCADE DRAW COMMANDS ---
+        auto buildCommands = [&cascadeMatrices](VAOResource& resource, const ShadowCasterCuller& culler)
+        {
+            if (resource.shadowDrawBuffers.size() != cascadeMatrices.size()) return;
+
+            auto& allCommands = resource.drawBuffer->GetDataImmutable();
+            for (size_t cascade = 0; cascade < cascadeMatrices.size(); ++cascade)
+            {
+                auto& cascadeCommands = resource.shadowDrawBuffers[cascade]->GetDataMutable();
+                resource.shadowCasterCounts[cascade] = ShadowCasterCuller::BuildCascadeCommands(allCommands,
+                    resource.cullSlots, culler.GetVisibility(cascade), cascadeCommands);
+
+                if (resource.shadowCasterCounts[cascade] > 0)
+                {
+                    Graphics::UploadToGPUBuffer(resource.shadowDrawBuffers[cascade]->GetGPUBuffer(), cascadeCommands);
+                }
+            }
+        };
+
+        for (auto& [key, resource] : m_staticResources)
+        {
+            buildCommands(resource, m_shadowCasterCuller);
+        }
+
+        if (m_skinnedMeshResources.first != 0)
+        {
+            buildCommands(m_skinnedMeshResources.second, m_skinnedCasterCuller);
+            buildCommands(m_preskinnedResource, m_skinnedCasterCuller);
+        }
+    }
+
+    void DeferredRenderer::CreateShadowDrawBuffers(VAOResource& vaoResource)
+    {
+        int numCascades = m_dlShadowMap->GetNumCascades();
+        vaoResource.shadowDrawBuffers.resize(numCascades);
+        vaoResource.shadowCasterCounts.assign(numCascades, 0);
+
+        for (auto& shadowBuffer : vaoResource.shadowDrawBuffers)
+        {
+            shadowBuffer = std::make_shared<IndirectDrawBuffer>();
+            shadowBuffer->GetDataMutable() = vaoResource.drawBuffer->GetDataImmutable();
+            Graphics::CreateIndirectDrawBuffer(shadowBuffer.get());
+        }
+    }
+
     void DeferredRenderer::DebugPass(FrameRenderData& frd)
     {
         std::string debugString;
@@ -1276,170 +1896,434 @@ namespace JLEngine
         Graphics::CreateGPUBuffer<MaterialGPU>(m_ssboMaterials.GetGPUBuffer(), m_ssboMaterials.GetDataImmutable());
 
         // --- CONVERT SCENE GRAPH DATA TO RENDER FRIENDLY DATA
+        // every submesh is registered again and then goes through the same path as a runtime spawn,
+        // so the draw lists and per draw data are rebuilt rather than appended to
         m_sceneManager.ForceUpdate();
-        auto& nonInstancedStatic = m_sceneManager.GetNonInstancedStatic();
-        auto& nonInstancedDynamic = m_sceneManager.GetNonInstancedDynamic();
-        auto& transparentItems = m_sceneManager.GetTransparent();
-        auto& instancedStaticItems = m_sceneManager.GetInstancedStatic();
-        auto& instancedDynamicItems = m_sceneManager.GetInstancedDynamic();
-        auto& rigidAnimationItems = m_sceneManager.GetRigidAnimated();
 
-        // --- STATIC MESHES --- 
-        //int perDrawDataIndex = 0;
-        for (auto& item : nonInstancedStatic)
+        for (auto& [vertexAttrib, vaoresource] : m_staticResources)
         {
-            PerDrawData pdd{};
-            pdd.materialID = static_cast<uint32_t>(m_materialIDMap[item.first.materialHandle]);
-            pdd.modelMatrix = item.second->GetGlobalTransform();
+            vaoresource.drawBuffer->ClearCommands();
+            vaoresource.cullSlots.clear();
+        }
+        if (m_skinnedMeshResources.first != 0)
+        {
+            m_skinnedMeshResources.second.drawBuffer->ClearCommands();
+            m_skinnedMeshResources.second.cullSlots.clear();
+            m_preskinnedResource.drawBuffer->ClearCommands();
+            m_preskinnedResource.cullSlots.clear();
+        }
+        m_preskinnedGeometry.clear();
+        for (auto& [vertexAttrib, vaoresource] : m_transparentResources)
+        {
+            vaoresource.drawBuffer->ClearCommands();
+            vaoresource.cullSlots.clear();
+        }
+        m_ssboStaticPerDraw.GetDataMutable().clear();
+        m_ssboDynamicPerDraw.GetDataMutable().clear();
+        m_ssboTransparentPerDraw.GetDataMutable().clear();
+        m_ssboJointMatrices.GetDataMutable().clear();
+        m_lights.GetDataMutable().clear();
+        for (auto& slotCommands : m_slotCommands) slotCommands.clear();
 
-            //item.second->perDrawDataIndex = perDrawDataIndex++;
-            m_ssboStaticPerDraw.AddData(pdd);
-            m_staticResources[item.first.attribKey].drawBuffer->AddDrawCommand(item.first.command);
+        m_sceneManager.TakeChanges(m_sceneChanges);
+        RecordSceneChanges(m_sceneChanges);
 
-            m_staticRigidAnimationIndex++;
-        }
-        // add the rigid animations to the back of the vao
-        // do not reset perDrawDataIndex as they should follow on
-        for (auto& item : rigidAnimationItems)
+        // --- CREATE THE GPU DRAW BUFFERS ---
+        for (auto& [vertexAttrib, vaoresource] : m_staticResources)
         {
-            PerDrawData pdd{};
-            pdd.materialID = static_cast<uint32_t>(m_materialIDMap[item.first.materialHandle]);
-            pdd.modelMatrix = item.second->GetGlobalTransform();
+            Graphics::CreateIndirectDrawBuffer(vaoresource.drawBuffer.get());
 
-            m_staticRigidAnimationIndex++;
-            //item.second->perDrawDataIndex = perDrawDataIndex++;
-            m_ssboStaticPerDraw.AddData(pdd);
-            m_staticResources[item.first.attribKey].drawBuffer->AddDrawCommand(item.first.command);
+            // sized for every command, culling only ever uploads a prefix of it
+            vaoresource.visibleDrawBuffer->GetDataMutable() = vaoresource.drawBuffer->GetDataImmutable();
+            Graphics::CreateIndirectDrawBuffer(vaoresource.visibleDrawBuffer.get());
+
+            CreateShadowDrawBuffers(vaoresource);
         }
 
-        // --- INSTANCED STATIC MESHES --- 
-        // perDrawDataIndex = 0;
-        uint32_t baseInstance = 0;
-        for (auto& item : instancedStaticItems)
+        if (m_skinnedMeshResources.first != 0)
         {
-            auto& submesh = item.second.first;
-            auto& node = item.second.second;
-            auto& transforms = submesh.instanceTransforms;
+            Graphics::CreateIndirectDrawBuffer(m_skinnedMeshResources.second.drawBuffer.get());
+            CreateShadowDrawBuffers(m_skinnedMeshResources.second);
+            Graphics::CreateIndirectDrawBuffer(m_preskinnedResource.drawBuffer.get());
+            CreateShadowDrawBuffers(m_preskinnedResource);
+        }
 
-            int numTransforms = static_cast<int>(transforms->size());
-            submesh.command.instanceCount = numTransforms;
-            submesh.command.baseInstance = baseInstance;
+        for (auto& [vertexAttrib, vaoresource] : m_transparentResources)
+        {
+            Graphics::CreateIndirectDrawBuffer(vaoresource.drawBuffer.get());
+        }
 
-            m_staticResources[submesh.attribKey].drawBuffer->AddDrawCommand(submesh.command);
+        m_ssboGlobalTransforms.GetGPUBuffer().SetSizeInBytes(m_ssboJointMatrices.GetDataImmutable().size() * sizeof(glm::mat4));
+        Graphics::CreateGPUBuffer(m_ssboJointMatrices.GetGPUBuffer(), m_ssboJointMatrices.GetDataImmutable());
+        Graphics::CreateGPUBuffer(m_ssboGlobalTransforms.GetGPUBuffer());
+        
+        Graphics::CreateGPUBuffer(m_lights.GetGPUBuffer(), m_lights.GetDataImmutable());
+        UploadBakedClips();
 
-            for (auto i = 0; i < transforms->size(); i++)
+        Graphics::CreateGPUBuffer<PerDrawData>(m_ssboStaticPerDraw.GetGPUBuffer(), m_ssboStaticPerDraw.GetDataImmutable());
+        Graphics::CreateGPUBuffer<SkinnedMeshPerDrawData>(m_ssboDynamicPerDraw.GetGPUBuffer(), m_ssboDynamicPerDraw.GetDataImmutable());
+        Graphics::CreateGPUBuffer<PerDrawData>(m_ssboTransparentPerDraw.GetGPUBuffer(), m_ssboTransparentPerDraw.GetDataImmutable());
+
+        // everything was just created from the CPU copies
+        for (auto& dirtySlots : m_dirtySlots) dirtySlots.clear();
+        m_dirtyJointSlots.clear();
+        m_dirtyDrawLists.clear();
+        m_lightsDirty = false;
+        m_gpuBuffersGenerated = true;
+    }
+
+    void DeferredRenderer::ApplySceneChanges()
+    {
+        // GenerateGPUBuffers does a full rebuild and consumes everything queued before it
+        if (!m_gpuBuffersGenerated) return;
+
+        m_sceneManager.TakeChanges(m_sceneChanges);
+        bool bakesFinished = CollectBakedClips();
+        if (m_sceneChanges.Empty() && !bakesFinished) return;
+
+        RecordSceneChanges(m_sceneChanges);
+
+        // the skinned draws were written without the clips that just finished baking
+        if (bakesFinished)
+        {
+            auto& registry = m_sceneManager.GetRegistry();
+            for (SceneBucket bucket : { SceneBucket::Skinned, SceneBucket::InstancedSkinned })
             {
-                PerDrawData pdd{};
-                pdd.materialID = static_cast<uint32_t>(m_materialIDMap[submesh.materialHandle]);
-                //transforms->at(i)->perDrawDataIndex = perDrawDataIndex++;
-                transforms->at(i)->UpdateHierarchy();
-                pdd.modelMatrix = transforms->at(i)->GetGlobalTransform();
-                m_ssboStaticPerDraw.AddData(pdd);
+                for (SceneItemID id : registry.GetBucketItems(bucket))
+                    WritePerDrawData(registry.GetItem(id));
             }
-            baseInstance += numTransforms;
         }
+        UploadSceneChanges();
+    }
 
-        // --- INSTANCED SKINNED MESHES --- 
-        baseInstance = 0;
-        //perDrawDataIndex = 0;
-        uint32_t instancedJointCount = 0;
-        for (auto& item : instancedDynamicItems)
+    void DeferredRenderer::RecordSceneChanges(const SceneChanges& changes)
+    {
+        auto& registry = m_sceneManager.GetRegistry();
+
+        // removals first, an added item may have been given a slot freed this frame
+        for (auto& item : changes.removed)
+        {
+            RemoveSceneItem(item);
+        }
+
+        // --- GROW THE CPU COPIES TO THE SLOT HIGH WATER MARKS ---
+        size_t staticSlots = registry.GetSlots(PerDrawSpace::Static).Capacity();
+        size_t skinnedSlots = registry.GetSlots(PerDrawSpace::Skinned).Capacity();
+        size_t transparentSlots = registry.GetSlots(PerDrawSpace::Transparent).Capacity();
+        size_t jointSlots = registry.GetJointSlots().Capacity();
+
+        if (m_ssboStaticPerDraw.GetDataImmutable().size() < staticSlots) m_ssboStaticPerDraw.GetDataMutable().resize(staticSlots);
+        if (m_ssboDynamicPerDraw.GetDataImmutable().size() < skinnedSlots) m_ssboDynamicPerDraw.GetDataMutable().resize(skinnedSlots);
+        if (m_ssboTransparentPerDraw.GetDataImmutable().size() < transparentSlots) m_ssboTransparentPerDraw.GetDataMutable().resize(transparentSlots);
+        if (m_ssboJointMatrices.GetDataImmutable().size() < jointSlots) m_ssboJointMatrices.GetDataMutable().resize(jointSlots);
+
+        size_t capacities[] = { staticSlots, skinnedSlots, transparentSlots };
+        for (size_t space = 0; space < static_cast<size_t>(PerDrawSpace::Count); ++space)
         {
-            auto& submesh = item.second.first;
-            auto node = item.second.second;
-            auto& skeleton = node->mesh->GetSkeleton();
-            auto& transforms = submesh.instanceTransforms;
+            if (m_slotCommands[space].size() < capacities[space]) m_slotCommands[space].resize(capacities[space], NoCommand);
+        }
 
-            int numTransforms = static_cast<int>(transforms->size());
-            submesh.command.instanceCount = numTransforms;
-            submesh.command.baseInstance = baseInstance;
+        for (SceneItemID id : changes.added)
+        {
+            RequestBakedClips(registry.GetItem(id));
+            AddSceneItem(registry.GetItem(id));
+        }
 
-            m_skinnedMeshResources.second.drawBuffer->AddDrawCommand(submesh.command);
+        for (SceneItemID id : changes.dirty)
+        {
+            RequestBakedClips(registry.GetItem(id));
+            WritePerDrawData(registry.GetItem(id));
+        }
 
-            for (auto& joint : skeleton->joints)
+        if (changes.lightsChanged)
+        {
+            auto& lights = m_lights.GetDataMutable();
+            lights.clear();
+            for (auto& lightNode : m_sceneManager.GetLightNodes())
             {
-                m_ssboJointMatrices.AddData(joint);
+                lightNode.second->light.position = lightNode.second->GetTranslation(); // update position to the nodes pos
+                lights.push_back(lightNode.second->light);
             }
+            m_lightsDirty = true;
+        }
+
+        // culling slots are the static/skinned per draw slots, the cullers keep existing boxes when they grow
+        if (m_frustumCuller.Size() != staticSlots) m_frustumCuller.Resize(staticSlots);
+        if (m_skinnedBounds.Size() != skinnedSlots) m_skinnedBounds.Resize(skinnedSlots);
+    }
+
+    void DeferredRenderer::AddSceneItem(const SceneItem& item)
+    {
+        // an instanced submesh with no instances has nothing to draw
+        if (item.slot == SlotAllocator::InvalidSlot) return;
+
+        WritePerDrawData(item);
+        ClaimPreskinnedGeometry(item);
+
+        PerDrawSpace space = SceneRegistry::GetPerDrawSpace(item.bucket);
+        VAOResource* resource = GetSceneItemResource(item);
+        if (resource == nullptr)
+        {
+            std::cerr << "DeferredRenderer: no vertex array for a submesh of " << item.node->name << ", it won't be drawn" << std::endl;
+            return;
+        }
+
+        // baseInstance holds the per draw data slot so the command list can be compacted after culling
+        bool instanced = item.bucket == SceneBucket::InstancedStatic || item.bucket == SceneBucket::InstancedSkinned;
+        auto command = item.submesh.command;
+        command.baseInstance = item.slot;
+        if (instanced) command.instanceCount = item.slotCount;
+
+        // instances and transparent draws are not culled individually
+        uint32_t cullSlot = (instanced || space == PerDrawSpace::Transparent) ? VAOResource::NoCullSlot : item.slot;
+
+        auto& commands = resource->drawBuffer->GetDataMutable();
+        m_slotCommands[static_cast<size_t>(space)][item.slot] = static_cast<uint32_t>(commands.size());
+        commands.push_back(command);
+        resource->cullSlots.push_back(cullSlot);
+
+        if (std::find(m_dirtyDrawLists.begin(), m_dirtyDrawLists.end(), resource) == m_dirtyDrawLists.end())
+            m_dirtyDrawLists.push_back(resource);
 
-            for (auto i = 0; i < transforms->size(); i++)
+        // bind pose joints, the animated palette is written every frame by UpdateSkinnedAnimations
+        if (space == PerDrawSpace::Skinned && item.jointCount > 0)
+        {
+            auto& joints = item.node->mesh->GetSkeleton()->joints;
+            auto& jointData = m_ssboJointMatrices.GetDataMutable();
+            for (uint32_t i = 0; i < item.jointCount; ++i)
             {
-                SkinnedMeshPerDrawData pdd{};
-                pdd.baseJointIndex = instancedJointCount; // all instances will share the same joint data
-                pdd.materialID = static_cast<uint32_t>(m_materialIDMap[submesh.materialHandle]);
-                //transforms->at(i)->perDrawDataIndex = perDrawDataIndex++;
-                transforms->at(i)->UpdateHierarchy();
-                pdd.modelMatrix = transforms->at(i)->GetGlobalTransform();
-                m_ssboDynamicPerDraw.AddData(pdd);
+                jointData[item.jointSlot + i] = joints[i];
+                m_dirtyJointSlots.push_back(item.jointSlot + i);
             }
-            baseInstance += numTransforms;
-            instancedJointCount += static_cast<int>(skeleton->joints.size());
         }
+    }
 
-        // --- SKINNED MESHES --- 
-        uint32_t jointCount = 0;
-        //perDrawDataIndex = 0;
-        for (auto& item : nonInstancedDynamic)
+    void DeferredRenderer::RemoveSceneItem(const SceneItem& item)
+    {
+        PerDrawSpace space = SceneRegistry::GetPerDrawSpace(item.bucket);
+        if (space == PerDrawSpace::None || item.slot == SlotAllocator::InvalidSlot) return;
+
+        auto& slotCommands = m_slotCommands[static_cast<size_t>(space)];
+        VAOResource* resource = GetSceneItemResource(item);
+        if (resource == &m_preskinnedResource)
+            m_preskinnedGeometry.erase(item.submesh.geometry);
+        if (resource == nullptr || item.slot >= slotCommands.size() || slotCommands[item.slot] == NoCommand) return;
+
+        // swap the last command into the gap, its baseInstance says which slot to repoint
+        uint32_t index = slotCommands[item.slot];
+        auto& commands = resource->drawBuffer->GetDataMutable();
+        uint32_t last = static_cast<uint32_t>(commands.size() - 1);
+        if (index != last)
         {
-            SkinnedMeshPerDrawData pdd{};
-            pdd.materialID = static_cast<uint32_t>(m_materialIDMap[item.first.materialHandle]);
-            pdd.modelMatrix = item.second->GetGlobalTransform();
-            pdd.baseJointIndex = jointCount;
+            commands[index] = commands[last];
+            resource->cullSlots[index] = resource->cullSlots[last];
+            slotCommands[commands[index].baseInstance] = index;
+        }
+        commands.pop_back();
+        resource->cullSlots.pop_back();
+        slotCommands[item.slot] = NoCommand;
 
-            //item.second->perDrawDataIndex = perDrawDataIndex++;
-            m_ssboDynamicPerDraw.AddData(pdd);
-            m_skinnedMeshResources.second.drawBuffer->AddDrawCommand(item.first.command);
+        if (std::find(m_dirtyDrawLists.begin(), m_dirtyDrawLists.end(), resource) == m_dirtyDrawLists.end())
+            m_dirtyDrawLists.push_back(resource);
+    }
 
-            auto& mesh = item.second->mesh;
-            for (auto& joint : mesh->GetSkeleton()->joints)
+    void DeferredRenderer::WritePerDrawData(const SceneItem& item)
+    {
+        PerDrawSpace space = SceneRegistry::GetPerDrawSpace(item.bucket);
+        if (space == PerDrawSpace::None || item.slot == SlotAllocator::InvalidSlot) return;
+
+        bool instanced = item.bucket == SceneBucket::InstancedStatic || item.bucket == SceneBucket::InstancedSkinned;
+        auto materialID = GetMaterialID(item.submesh.materialHandle);
+        auto& dirtySlots = m_dirtySlots[static_cast<size_t>(space)];
+
+        for (uint32_t i = 0; i < item.slotCount; ++i)
+        {
+            glm::mat4 modelMatrix;
+            if (instanced)
+            {
+                auto& instance = item.submesh.instanceTransforms->at(i);
+                instance->UpdateHierarchy();
+                modelMatrix = instance->GetGlobalTransform();
+            }
+            else
             {
-                m_ssboJointMatrices.AddData(joint);
+                modelMatrix = item.node->GetGlobalTransform();
             }
 
-            jointCount += static_cast<int>(mesh->GetSkeleton()->joints.size());
+            uint32_t slot = item.slot + i;
+            if (space == PerDrawSpace::Skinned)
+            {
+                SkinnedMeshPerDrawData pdd{};
+                pdd.materialID = materialID;
+                pdd.modelMatrix = modelMatrix;
+                // all instances share the same joint data
+                pdd.baseJointIndex = item.jointCount > 0 ? item.jointSlot : 0;
+
+                // unless their own controller plays a baked clip, then only its start time is per instance
+                if (auto* controller = GetBakedController(item, i))
+                {
+                    pdd.bakedClip = GetBakedClip(controller->CurrAnim(), item.node->mesh.get());
+                    pdd.bakedTimeOffset = controller->GetCurrentTime();
+                }
+                m_ssboDynamicPerDraw.GetDataMutable()[slot] = pdd;
+            }
+            else
+            {
+                PerDrawData pdd{};
+                pdd.materialID = materialID;
+                pdd.modelMatrix = modelMatrix;
+                auto& ssbo = space == PerDrawSpace::Static ? m_ssboStaticPerDraw : m_ssboTransparentPerDraw;
+                ssbo.GetDataMutable()[slot] = pdd;
+            }
+            dirtySlots.push_back(slot);
         }
+    }
+
+    uint32_t DeferredRenderer::GetMaterialID(uint32_t materialHandle)
+    {
+        auto it = m_materialIDMap.find(materialHandle);
+        if (it != m_materialIDMap.end()) return static_cast<uint32_t>(it->second);
+
+        auto material = m_resourceLoader->GetMaterialManager()->Get(materialHandle);
+        if (material == nullptr || !m_gpuBuffersGenerated) return 0;
+
+        // created after the material buffer was built, e.g. by a streamed load
+        auto& materials = m_ssboMaterials.GetDataMutable();
+        size_t materialID = materials.size();
+        materials.push_back(MakeMaterialGPU(*material));
+        m_materialIDMap[materialHandle] = materialID;
+        m_materialsDirty = true;
+        return static_cast<uint32_t>(materialID);
+    }
 
-        // --- TRANSPARENT MESHES --- 
-        //perDrawDataIndex = 0;
-        for (auto& item : transparentItems)
+    VAOResource* DeferredRenderer::GetSceneItemResource(const SceneItem& item)
+    {
+        switch (SceneRegistry::GetPerDrawSpace(item.bucket))
+        {
+        case PerDrawSpace::Static:
+        {
+            auto it = m_staticResources.find(item.submesh.attribKey);
+            return it != m_staticResources.end() ? &it->second : nullptr;
+        }
+        case PerDrawSpace::Skinned:
+            // every skinned mesh shares the one skinned vertex array, the compute skinned ones draw its output
+            if (UsesPreskinning(item)) return &m_preskinnedResource;
+            return m_skinnedMeshResources.first != 0 ? &m_skinnedMeshResources.second : nullptr;
+        case PerDrawSpace::Transparent:
         {
-            PerDrawData pdd{};
-            pdd.materialID = static_cast<uint32_t>(m_materialIDMap[item.first.materialHandle]);
-            pdd.modelMatrix = item.second->GetGlobalTransform();
-            //item.second->perDrawDataIndex = perDrawDataIndex++;
-            m_ssboTransparentPerDraw.AddData(pdd);
-            m_transparentResources[item.first.attribKey].drawBuffer->AddDrawCommand(item.first.command);
+            auto it = m_transparentResources.find(item.submesh.attribKey);
+            return it != m_transparentResources.end() ? &it->second : nullptr;
         }
+        default:
+            return nullptr;
+        }
+    }
 
-        // --- CREATE THE GPU DRAW BUFFERS ---
-        for (auto& [vertexAttrib, vaoresource] : m_staticResources)
+    void DeferredRenderer::UploadSceneChanges()
+    {
+        // only the slots written this frame, merged into contiguous runs
+        Graphics::UploadGPUBufferElements(m_ssboStaticPerDraw.GetGPUBuffer(), m_ssboStaticPerDraw.GetDataImmutable(),
+            m_dirtySlots[static_cast<size_t>(PerDrawSpace::Static)]);
+        Graphics::UploadGPUBufferElements(m_ssboDynamicPerDraw.GetGPUBuffer(), m_ssboDynamicPerDraw.GetDataImmutable(),
+            m_dirtySlots[static_cast<size_t>(PerDrawSpace::Skinned)]);
+        Graphics::UploadGPUBufferElements(m_ssboTransparentPerDraw.GetGPUBuffer(), m_ssboTransparentPerDraw.GetDataImmutable(),
+            m_dirtySlots[static_cast<size_t>(PerDrawSpace::Transparent)]);
+        Graphics::UploadGPUBufferElements(m_ssboJointMatrices.GetGPUBuffer(), m_ssboJointMatrices.GetDataImmutable(), m_dirtyJointSlots);
+        UploadBakedClips();
+
+        // the static lists are compacted into the visible/shadow buffers every frame, skinned and transparent draw from these
+        for (VAOResource* resource : m_dirtyDrawLists)
         {
-            Graphics::CreateIndirectDrawBuffer(vaoresource.drawBuffer.get());
+            auto& commands = resource->drawBuffer->GetDataImmutable();
+            if (!commands.empty())
+                Graphics::UploadToGPUBuffer(resource->drawBuffer->GetGPUBuffer(), commands);
         }
 
-        if (m_skinnedMeshResources.first != 0)
-            Graphics::CreateIndirectDrawBuffer(m_skinnedMeshResources.second.drawBuffer.get());
+        if (m_lightsDirty && !m_lights.GetDataImmutable().empty())
+            Graphics::UploadToGPUBuffer(m_lights.GetGPUBuffer(), m_lights.GetDataImmutable());
+
+        if (m_materialsDirty)
+            Graphics::UploadToGPUBuffer(m_ssboMaterials.GetGPUBuffer(), m_ssboMaterials.GetDataImmutable());
+
+        for (auto& dirtySlots : m_dirtySlots) dirtySlots.clear();
+        m_dirtyJointSlots.clear();
+        m_dirtyDrawLists.clear();
+        m_lightsDirty = false;
+        m_materialsDirty = false;
+    }
+
+    void DeferredRenderer::UpdateGeometryBatches()
+    {
+        if (!m_gpuBuffersGenerated) return;
+
+        auto update = [this](VAOResource& resource)
+            {
+                auto vao = resource.vao.get();
+                if (vao == nullptr) return;
+
+                if (m_enableGeometryDefrag)
+                {
+                    m_geometryMoves.clear();
+                    vao->DefragmentGeometry(m_geometryDefragBudget, m_geometryMoves);
+                    for (auto& move : m_geometryMoves)
+                    {
+                        PatchGeometryMove(move);
+                    }
+                }
+
+                // new meshes streamed in and the ranges compaction just wrote
+                Graphics::UploadGeometryChanges(vao);
+            };
 
+        for (auto& [vertexAttrib, vaoresource] : m_staticResources)
+        {
+            update(vaoresource);
+        }
+        if (m_skinnedMeshResources.first != 0)
+            update(m_skinnedMeshResources.second);
         for (auto& [vertexAttrib, vaoresource] : m_transparentResources)
         {
-            Graphics::CreateIndirectDrawBuffer(vaoresource.drawBuffer.get());
+            update(vaoresource);
         }
 
-        m_ssboGlobalTransforms.GetGPUBuffer().SetSizeInBytes((jointCount + instancedJointCount) * sizeof(glm::mat4));
-        Graphics::CreateGPUBuffer(m_ssboJointMatrices.GetGPUBuffer(), m_ssboJointMatrices.GetDataImmutable());
-        Graphics::CreateGPUBuffer(m_ssboGlobalTransforms.GetGPUBuffer());
-        
-        auto& lightNodes = m_sceneManager.GetLightNodes();
-        for (auto& lightNode : lightNodes)
+        // the patched draw commands, nothing else is dirty at this point in the frame
+        if (!m_dirtyDrawLists.empty())
+            UploadSceneChanges();
+    }
+
+    void DeferredRenderer::PatchGeometryMove(const GeometryMove& move)
+    {
+        if (move.owner == nullptr) return;
+
+        // the mesh is the source for any later registration, the registry and our draw lists hold copies
+        auto& submesh = move.owner->GetSubmesh(move.submeshIndex);
+        submesh.command.firstIndex = move.range.firstIndex;
+        submesh.command.baseVertex = move.range.baseVertex;
+
+        m_patchedItems.clear();
+        auto& registry = m_sceneManager.GetRegistry();
+        registry.PatchSubmeshGeometry(move.owner, move.submeshIndex, move.range.firstIndex, move.range.baseVertex, m_patchedItems);
+
+        for (SceneItemID id : m_patchedItems)
         {
-            lightNode.second->light.position = lightNode.second->translation; // update position to the nodes pos
-            m_lights.AddData(lightNode.second->light);
-        }
-        Graphics::CreateGPUBuffer(m_lights.GetGPUBuffer(), m_lights.GetDataImmutable());
+            auto& item = registry.GetItem(id);
+            PerDrawSpace space = SceneRegistry::GetPerDrawSpace(item.bucket);
+            if (space == PerDrawSpace::None || item.slot == SlotAllocator::InvalidSlot) continue;
 
-        Graphics::CreateGPUBuffer<PerDrawData>(m_ssboStaticPerDraw.GetGPUBuffer(), m_ssboStaticPerDraw.GetDataImmutable());
-        Graphics::CreateGPUBuffer<SkinnedMeshPerDrawData>(m_ssboDynamicPerDraw.GetGPUBuffer(), m_ssboDynamicPerDraw.GetDataImmutable());
-        Graphics::CreateGPUBuffer<PerDrawData>(m_ssboTransparentPerDraw.GetGPUBuffer(), m_ssboTransparentPerDraw.GetDataImmutable());
-        
+            // pending adds pick the patched command up when they are added
+            auto& slotCommands = m_slotCommands[static_cast<size_t>(space)];
+            if (item.slot >= slotCommands.size() || slotCommands[item.slot] == NoCommand) continue;
+
+            VAOResource* resource = GetSceneItemResource(item);
+            if (resource == nullptr) continue;
+
+            auto& command = resource->drawBuffer->GetDataMutable()[slotCommands[item.slot]];
+            command.firstIndex = move.range.firstIndex;
+            command.baseVertex = move.range.baseVertex;
+
+            if (std::find(m_dirtyDrawLists.begin(), m_dirtyDrawLists.end(), resource) == m_dirtyDrawLists.end())
+                m_dirtyDrawLists.push_back(resource);
+        }
     }
 
     void DeferredRenderer::ExtractSceneTriangles()
@@ -1646,51 +2530,37 @@ namespace JLEngine
         std::vector<MaterialGPU>& materialBuffer, 
         std::unordered_map<uint32_t, size_t>& materialIDMap)
     {
-        // Map Texture GPUID to indices
-        std::unordered_map<uint32_t, uint64_t> textureIDMap;
-        size_t textureIndex = 0;
-
-        for (const auto& [id, texture] : textureManager.GetResources())
-        {
-            textureIDMap[texture->GetGPUID()] = texture->Bindless();
-        }
-
         // Map Material GPUID to indices and build MaterialGPU array
         size_t materialIndex = 0;
         
         for (const auto& [id, material] : materialManager.GetResources())
         {
-            MaterialGPU matGPU{};
-            matGPU.baseColorFactor = material->baseColorFactor;
-            matGPU.emissiveFactor = glm::vec4(material->emissiveFactor, material->emissiveStrength);
-            matGPU.metallicFactor = material->metallicFactor;
-            matGPU.roughnessFactor = material->roughnessFactor;
-            matGPU.alphaCutoff = material->alphaCutoff;
-            matGPU.receiveShadows = material->receiveShadows ? 1 : 0;
-
-            // Map textures by ID
-            matGPU.baseColorHandle = material->baseColorTexture ?
-                textureIDMap[material->baseColorTexture->GetGPUID()] : 0;
-
-            matGPU.metallicRoughnessHandle = material->metallicRoughnessTexture ?
-                textureIDMap[material->metallicRoughnessTexture->GetGPUID()] : 0;
-
-            matGPU.normalHandle = material->normalTexture ?
-                textureIDMap[material->normalTexture->GetGPUID()] : 0;
-
-            matGPU.occlusionHandle = material->occlusionTexture ?
-                textureIDMap[material->occlusionTexture->GetGPUID()] : 0;
-
-            matGPU.emissiveHandle = material->emissiveTexture ?
-                textureIDMap[material->emissiveTexture->GetGPUID()] : 0;
-
-            matGPU.alphaMode = static_cast<int>(material->alphaMode);
-
-            materialBuffer.push_back(matGPU);
+            materialBuffer.push_back(MakeMaterialGPU(*material));
             materialIDMap[id] = materialIndex++;
         }
     }
 
+    MaterialGPU DeferredRenderer::MakeMaterialGPU(const Material& material)
+    {
+        MaterialGPU matGPU{};
+        matGPU.baseColorFactor = material.baseColorFactor;
+        matGPU.emissiveFactor = glm::vec4(material.emissiveFactor, material.emissiveStrength);
+        matGPU.metallicFactor = material.metallicFactor;
+        matGPU.roughnessFactor = material.roughnessFactor;
+        matGPU.alphaCutoff = material.alphaCutoff;
+        matGPU.receiveShadows = material.receiveShadows ? 1 : 0;
+
+        // bindless handles, 0 for an empty slot
+        matGPU.baseColorHandle = material.baseColorTexture ? material.baseColorTexture->Bindless() : 0;
+        matGPU.metallicRoughnessHandle = material.metallicRoughnessTexture ? material.metallicRoughnessTexture->Bindless() : 0;
+        matGPU.normalHandle = material.normalTexture ? material.normalTexture->Bindless() : 0;
+        matGPU.occlusionHandle = material.occlusionTexture ? material.occlusionTexture->Bindless() : 0;
+        matGPU.emissiveHandle = material.emissiveTexture ? material.emissiveTexture->Bindless() : 0;
+
+        matGPU.alphaMode = static_cast<int>(material.alphaMode);
+        return matGPU;
+    }
+
     void DeferredRenderer::Resize(int width, int height) 
     {
         if (width == m_width && height == m_height)
@@ -1,6 +1,8 @@
 #ifndef DEFERRED_RENDERER_H
 #define DEFERRED_RENDERER_H
 
+#include <atomic>
+#include <map>
 #include <vector>
 #include <string>
 #include <glm/glm.hpp>
@@ -20,6 +22,13 @@
 #include "AtmosphereParameters.h"
 #include "VoxelGrid.h"
 #include "FlyCamera.h"
+#include "FrustumCuller.h"
+#include "ShadowCasterCuller.h"
+#include "SceneBVH.h"
+#include "SkinningEvaluator.h"
+#include "AnimationBaker.h"
+#include "JobSystem.h"
+#include "VertexSkinning.h"
 
 namespace JLEngine
 {
@@ -79,8 +88,17 @@ namespace JLEngine
 
         void AddVAO(VAOType vaoType, VertexAttribKey key, std::shared_ptr<VertexArrayObject>& vao);
         void AddVAOs(VAOType vaoType, std::unordered_map<VertexAttribKey, std::shared_ptr<VertexArrayObject>>& vaos);
+        // Vertex arrays a streamed load created, keys already known are skipped. After GenerateGPUBuffers
+        // the new ones get their GPU objects here, before it the full build makes them with the rest
+        void AddStreamedVAOs(VAOType vaoType, std::unordered_map<VertexAttribKey, std::shared_ptr<VertexArrayObject>>& vaos);
 
         void GenerateGPUBuffers();
+        // Mirrors nodes added, removed or changed through the SceneManager since the last call,
+        // only the affected per draw slots and draw lists are touched. Called at the start of Render
+        void ApplySceneChanges();
+        // Compacts the batched VAOs a little each frame, patches the draw commands of whatever moved
+        // and uploads only the vertex/index ranges written since the last frame
+        void UpdateGeometryBatches();
 
         void ExtractSceneTriangles();
 
@@ -101,6 +119,14 @@ namespace JLEngine
         void DrawUI();        
         void DrawSky(FrameRenderData& frd);
         void DrawGeometry(const VAOResource& vaoResource, uint32_t stride);
+        void DrawVisibleGeometry(const VAOResource& vaoResource, uint32_t stride);
+        void CullStaticGeometry(const ViewFrustum& frustum);
+        // Asks the texture streamer for the mips this frame's draws need and patches the material
+        // entries of the textures it swapped
+        void UpdateTextureStreaming(const FrameRenderData& frd);
+        void CullShadowCasters();
+        void DrawShadowCasters(const VAOResource& vaoResource, int cascadeIdx, uint32_t stride);
+        void CreateShadowDrawBuffers(VAOResource& vaoResource);
         void CombinePass(FrameRenderData& frd);
         void LightPass(FrameRenderData& frd);
         void TransparencyPass(FrameRenderData& frd);
@@ -111,7 +137,17 @@ namespace JLEngine
         void DebugDirectionalLightShadows(float nearVal, float farVal);
         void DebugDDGI();
         void DebugDDGIRays();
-        void DebugAABB();
+        void DebugAABB(FrameRenderData& frd);
+        void UpdateSceneBVH();
+        void RecordSceneChanges(const SceneChanges& changes);
+        void AddSceneItem(const SceneItem& item);
+        void RemoveSceneItem(const SceneItem& item);
+        void WritePerDrawData(const SceneItem& item);
+        VAOResource* GetSceneItemResource(const SceneItem& item);
+        // Index into the material buffer, materials created after GenerateGPUBuffers are appended to it
+        uint32_t GetMaterialID(uint32_t materialHandle);
+        void UploadSceneChanges();
+        void PatchGeometryMove(const GeometryMove& move);
         void RenderDebugTools(FrameRenderData& frd);
         void DebugHDRISky(const glm::mat4& viewMatrix, const glm::mat4& projMatrix);
         void DebugPbrSky(const glm::vec3& eyePos);
@@ -119,6 +155,23 @@ namespace JLEngine
         void SetupGBuffer();
         void UpdateRigidAnimations();
         void UpdateSkinnedAnimations();
+        bool ClaimPreskinnedGeometry(const SceneItem& item);
+        bool UsesPreskinning(const SceneItem& item) const;
+        void BuildSkinJobs();
+        void PreskinVertices();
+        void ReserveFrameUploads();
+        void BindShaderGlobalData(int bindPoint);
+        void BindJointMatrices(int bindPoint);
+        // The controller whose baked clip the instance plays, null when it plays live
+        static AnimationController* GetBakedController(const SceneItem& item, uint32_t instance);
+        // Starts bakes on a worker for the baked clips the item's instances play
+        void RequestBakedClips(const SceneItem& item);
+        // Adds the finished bakes to the clip buffers, true if any finished
+        bool CollectBakedClips();
+        // Clip index for the per draw data, 0 until the bake has finished or if it failed
+        uint32_t GetBakedClip(const Animation* animation, const Mesh* mesh) const;
+        void UploadBakedClips();
+        void BindBakedClips(int clipsBindPoint, int palettesBindPoint);
         void DirectionalShadowMapPass(FrameRenderData& frd);
         void RenderScreenSpaceTriangle();
         glm::mat4 GetDirectionalLightSpaceMatrix(
@@ -132,6 +185,7 @@ namespace JLEngine
             ResourceManager<JLEngine::Texture>& textureManager,
             std::vector<MaterialGPU>& materialBuffer,
             std::unordered_map<uint32_t, size_t>& materialIDMap);
+        static MaterialGPU MakeMaterialGPU(const Material& material);
 
         GraphicsAPI* m_graphics;
         ResourceLoader* m_resourceLoader;
@@ -186,13 +240,92 @@ namespace JLEngine
         ShaderStorageBuffer<glm::mat4> m_ssboGlobalTransforms;
         ShaderStorageBuffer<LightGPU> m_lights;
 
-        int m_staticRigidAnimationIndex = -1;
         std::unordered_map<VertexAttribKey, VAOResource> m_staticResources;
         std::pair<VertexAttribKey, VAOResource> m_skinnedMeshResources;
         std::unordered_map<VertexAttribKey, VAOResource> m_transparentResources;
 
+        // --- FRUSTUM CULLING --- //
+        FrustumCuller m_frustumCuller;
+        std::vector<uint8_t> m_visibility;
+        CullingStats m_cullingStats;
+        bool m_enableFrustumCulling = true;
+
+        // --- SHADOW CASTER CULLING --- //
+        ShadowCasterCuller m_shadowCasterCuller;
+        ShadowCasterCuller m_skinnedCasterCuller;
+        FrustumCuller m_skinnedBounds;
+        bool m_enableShadowCasterCulling = true;
+
+        // --- SPATIAL QUERIES --- //
+        SceneBVH m_sceneBVH;
+        std::vector<AABB> m_sceneBounds;
+
+        // --- INCREMENTAL SCENE UPDATES --- //
+        SceneChanges m_sceneChanges;
+        // per draw slot -> index of its command in the owning VAO's draw buffer, one table per PerDrawSpace
+        std::vector<uint32_t> m_slotCommands[static_cast<size_t>(PerDrawSpace::Count)];
+        std::vector<uint32_t> m_dirtySlots[static_cast<size_t>(PerDrawSpace::Count)];
+        std::vector<uint32_t> m_dirtyJointSlots;
+        std::vector<VAOResource*> m_dirtyDrawLists;
+        std::vector<uint32_t> m_rigidSlots;
+        bool m_lightsDirty = false;
+        bool m_materialsDirty = false;
+        bool m_gpuBuffersGenerated = false;
+        static constexpr uint32_t NoCommand = UINT32_MAX;
+
+        // --- GEOMETRY BATCHES --- //
+        std::vector<GeometryMove> m_geometryMoves;
+        std::vector<SceneItemID> m_patchedItems;
+        size_t m_geometryDefragBudget = 4 * 1024 * 1024; // bytes moved per frame
+        bool m_enableGeometryDefrag = true;
+
+        // --- PER FRAME UPLOADS --- //
+        FrameRingBuffer m_frameRing;
+        // this frame's slices, empty when the ring overflowed and the fallback buffers were used
+        TransientAllocation m_frameShaderData;
+        TransientAllocation m_frameJointMatrices;
+
+        // --- BAKED CROWD ANIMATION --- //
+        ShaderStorageBuffer<BakedClipGPU> m_ssboBakedClips;
+        ShaderStorageBuffer<uint32_t> m_ssboBakedPalettes;
+        // (animation, mesh) -> the bakedClip value written to per draw data, 0 if it couldn't be baked
+        std::map<std::pair<const Animation*, const Mesh*>, uint32_t> m_bakedClipIndices;
+        struct BakeJob
+        {
+            BakedAnimation baked;
+            std::atomic<bool> done{ false };
+            bool succeeded = false;
+        };
+        // bakes running on the workers, loading the cache file or baking and writing it
+        std::map<std::pair<const Animation*, const Mesh*>, std::shared_ptr<BakeJob>> m_bakeJobs;
+        JobCounter m_bakeJobsInFlight;
+        float m_bakedFrameRate = AnimationBaker::DefaultFrameRate;
+        BakedPaletteFormat m_bakedFormat = BakedPaletteFormat::Half3x4;
+        bool m_bakedClipsDirty = false;
+        // global time the baked clips are played from, timeInfo.y in the shaders
+        float m_shaderTime = 0.0f;
+
+        // --- GPU PRE-SKINNING --- //
+        // non instanced skinned meshes are skinned once a frame by m_jointTransformCompute into
+        // m_preskinnedVertices and drawn through m_preskinnedResource with the static shaders,
+        // instanced ones stay on vertex shader skinning
+        VAOResource m_preskinnedResource;
+        GPUBuffer m_preskinnedVertices;
+        ShaderStorageBuffer<SkinJobGPU> m_ssboSkinJobs;
+        std::vector<SkinJobGPU> m_skinJobs;
+        // geometry -> skinned slot of the draw that owns it. Output vertices mirror the source vertices,
+        // so a second draw of the same geometry (another pose) has to stay on vertex shader skinning
+        std::unordered_map<GeometryID, uint32_t> m_preskinnedGeometry;
+        // the buffers the preskinned VAO was last pointed at
+        uint32_t m_preskinnedVBO = 0;
+        uint32_t m_preskinnedIBO = 0;
+        bool m_enablePreskinning = true;
+        static constexpr uint32_t MaxComputeGroups = 65535; // the minimum GL guarantees per dimension
+
         std::unordered_map<uint32_t, size_t> m_materialIDMap;
         std::vector<glm::mat4> m_jointMatrices;
+        std::vector<SkinningTask> m_skinningTasks;
+        SkinningEvaluator m_skinningEvaluator;
 
         SceneManager m_sceneManager;
 
@@ -0,0 +1,179 @@
+#include "FrustumCuller.h"
+
+#include <cmath>
+
+#if defined(__AVX__)
+#define JL_CULL_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JL_CULL_SSE
+#include <emmintrin.h>
+#endif
+
+namespace JLEngine
+{
+	void FrustumCuller::Resize(size_t count)
+	{
+		m_count = count;
+		size_t padded = (count + 7) & ~size_t(7);
+
+		// existing boxes are kept so slots can be added without rewriting everything
+		m_centerX.resize(padded, 0.0f);
+		m_centerY.resize(padded, 0.0f);
+		m_centerZ.resize(padded, 0.0f);
+		m_extentX.resize(padded, 0.0f);
+		m_extentY.resize(padded, 0.0f);
+		m_extentZ.resize(padded, 0.0f);
+	}
+
+	void FrustumCuller::SetBounds(size_t index, const AABB& localBox, const glm::mat4& worldTransform)
+	{
+		SetWorldBounds(index, TransformAABB(localBox, worldTransform));
+	}
+
+	void FrustumCuller::SetWorldBounds(size_t index, const AABB& worldBox)
+	{
+		glm::vec3 center = (worldBox.min + worldBox.max) * 0.5f;
+		glm::vec3 extent = (worldBox.max - worldBox.min) * 0.5f;
+
+		m_centerX[index] = center.x;
+		m_centerY[index] = center.y;
+		m_centerZ[index] = center.z;
+		m_extentX[index] = extent.x;
+		m_extentY[index] = extent.y;
+		m_extentZ[index] = extent.z;
+	}
+
+	void FrustumCuller::CullRangeScalar(const Plane* planes, size_t begin, size_t end, uint8_t* visibility) const
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			bool inside = true;
+			for (int p = 0; p < 6 && inside; ++p)
+			{
+				const glm::vec3& n = planes[p].m_normal;
+				// same evaluation order as the SIMD paths so both give identical results on the boundary
+				float distance = (n.x * m_centerX[i] + n.y * m_centerY[i]) + (n.z * m_centerZ[i] + planes[p].m_distance);
+				float radius = (std::abs(n.x) * m_extentX[i] + std::abs(n.y) * m_extentY[i]) + std::abs(n.z) * m_extentZ[i];
+				inside = distance + radius >= 0.0f;
+			}
+			visibility[i] = inside ? 1 : 0;
+		}
+	}
+
+	CullingStats FrustumCuller::CullScalar(const Plane* planes, std::vector<uint8_t>& visibility) const
+	{
+		visibility.resize(m_count);
+		CullRangeScalar(planes, 0, m_count, visibility.data());
+
+		CullingStats stats;
+		stats.tested = static_cast<uint32_t>(m_count);
+		for (size_t i = 0; i < m_count; ++i)
+		{
+			stats.visible += visibility[i];
+		}
+		stats.culled = stats.tested - stats.visible;
+		return stats;
+	}
+
+	CullingStats FrustumCuller::Cull(const Plane* planes, std::vector<uint8_t>& visibility) const
+	{
+		visibility.resize(m_count);
+		uint8_t* out = visibility.data();
+		size_t i = 0;
+
+#if defined(JL_CULL_AVX)
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+		__m256 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			nx[p] = _mm256_set1_ps(planes[p].m_normal.x);
+			ny[p] = _mm256_set1_ps(planes[p].m_normal.y);
+			nz[p] = _mm256_set1_ps(planes[p].m_normal.z);
+			ax[p] = _mm256_andnot_ps(signMask, nx[p]);
+			ay[p] = _mm256_andnot_ps(signMask, ny[p]);
+			az[p] = _mm256_andnot_ps(signMask, nz[p]);
+			d[p] = _mm256_set1_ps(planes[p].m_distance);
+		}
+
+		const __m256 zero = _mm256_setzero_ps();
+		for (; i + 8 <= m_count; i += 8)
+		{
+			__m256 cx = _mm256_loadu_ps(&m_centerX[i]);
+			__m256 cy = _mm256_loadu_ps(&m_centerY[i]);
+			__m256 cz = _mm256_loadu_ps(&m_centerZ[i]);
+			__m256 ex = _mm256_loadu_ps(&m_extentX[i]);
+			__m256 ey = _mm256_loadu_ps(&m_extentY[i]);
+			__m256 ez = _mm256_loadu_ps(&m_extentZ[i]);
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int p = 0; p < 6; ++p)
+			{
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)),
+					_mm256_add_ps(_mm256_mul_ps(nz[p], cz), d[p]));
+				__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)),
+					_mm256_mul_ps(az[p], ez));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(inside);
+			for (int k = 0; k < 8; ++k)
+			{
+				out[i + k] = static_cast<uint8_t>((mask >> k) & 1);
+			}
+		}
+#elif defined(JL_CULL_SSE)
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		__m128 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			nx[p] = _mm_set1_ps(planes[p].m_normal.x);
+			ny[p] = _mm_set1_ps(planes[p].m_normal.y);
+			nz[p] = _mm_set1_ps(planes[p].m_normal.z);
+			ax[p] = _mm_andnot_ps(signMask, nx[p]);
+			ay[p] = _mm_andnot_ps(signMask, ny[p]);
+			az[p] = _mm_andnot_ps(signMask, nz[p]);
+			d[p] = _mm_set1_ps(planes[p].m_distance);
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= m_count; i += 4)
+		{
+			__m128 cx = _mm_loadu_ps(&m_centerX[i]);
+			__m128 cy = _mm_loadu_ps(&m_centerY[i]);
+			__m128 cz = _mm_loadu_ps(&m_centerZ[i]);
+			__m128 ex = _mm_loadu_ps(&m_extentX[i]);
+			__m128 ey = _mm_loadu_ps(&m_extentY[i]);
+			__m128 ez = _mm_loadu_ps(&m_extentZ[i]);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < 6; ++p)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)),
+					_mm_add_ps(_mm_mul_ps(nz[p], cz), d[p]));
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)),
+					_mm_mul_ps(az[p], ez));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			out[i + 0] = static_cast<uint8_t>(mask & 1);
+			out[i + 1] = static_cast<uint8_t>((mask >> 1) & 1);
+			out[i + 2] = static_cast<uint8_t>((mask >> 2) & 1);
+			out[i + 3] = static_cast<uint8_t>((mask >> 3) & 1);
+		}
+#endif
+
+		// remainder (or everything when no SIMD path is available)
+		CullRangeScalar(planes, i, m_count, out);
+
+		CullingStats stats;
+		stats.tested = static_cast<uint32_t>(m_count);
+		for (size_t k = 0; k < m_count; ++k)
+		{
+			stats.visible += out[k];
+		}
+		stats.culled = stats.tested - stats.visible;
+		return stats;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "CollisionShapes.h"
+
+namespace JLEngine
+{
+	struct CullingStats
+	{
+		uint32_t tested = 0;
+		uint32_t visible = 0;
+		uint32_t culled = 0;
+	};
+
+	// World space bounds stored as SoA centre/extent arrays so the plane tests
+	// can run over 8 (AVX) or 4 (SSE) boxes per iteration
+	class FrustumCuller
+	{
+	public:
+		FrustumCuller() = default;
+
+		void Resize(size_t count);
+		size_t Size() const { return m_count; }
+
+		// Local box under worldTransform, stored as its world space AABB
+		void SetBounds(size_t index, const AABB& localBox, const glm::mat4& worldTransform);
+		void SetWorldBounds(size_t index, const AABB& worldBox);
+
+		// Writes 1 (visible) or 0 (culled) per box, planes must point inwards (see ViewFrustum::ExtractPlanes)
+		CullingStats Cull(const Plane* planes, std::vector<uint8_t>& visibility) const;
+
+		// Reference implementation, one box at a time
+		CullingStats CullScalar(const Plane* planes, std::vector<uint8_t>& visibility) const;
+
+	private:
+		void CullRangeScalar(const Plane* planes, size_t begin, size_t end, uint8_t* visibility) const;
+
+		size_t m_count = 0;
+
+		// padded to a multiple of 8 so the wide loops never need a partial load
+		std::vector<float> m_centerX, m_centerY, m_centerZ;
+		std::vector<float> m_extentX, m_extentY, m_extentZ;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,419 @@
+#include "GLBImporter.h"
+#include "JobSystem.h"
+
+#include <iostream>
+#include <glm/gtx/matrix_decompose.hpp>
+
+#undef APIENTRY
+#define TINYGLTF_IMPLEMENTATION
+#include <tiny_gltf.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+namespace JLEngine
+{
+	bool GLBImporter::Parse(const std::string& fileName, std::string& err, std::string& warn)
+	{
+		Clear();
+
+		size_t dotPos = fileName.find_last_of(".");
+		if (dotPos == std::string::npos)
+		{
+			err = "Extension missing";
+			return false;
+		}
+		auto extension = fileName.substr(dotPos + 1);
+
+		tinygltf::TinyGLTF loader;
+		loader.SetImageLoader(&GLBImporter::DeferImage, this);
+
+		if (extension == "glb")
+			return loader.LoadBinaryFromFile(&m_model, &err, &warn, fileName);
+		if (extension == "gltf")
+			return loader.LoadASCIIFromFile(&m_model, &err, &warn, fileName);
+
+		err = "Unsupported extension " + extension;
+		return false;
+	}
+
+	bool GLBImporter::DeferImage(tinygltf::Image* image, const int imageIndex, std::string* err, std::string* warn,
+		int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData)
+	{
+		auto* importer = static_cast<GLBImporter*>(userData);
+
+		PendingImage pending;
+		pending.imageIndex = imageIndex;
+		pending.requiredWidth = requiredWidth;
+		pending.requiredHeight = requiredHeight;
+		pending.bytes.assign(bytes, bytes + size);
+		importer->m_pendingImages.push_back(std::move(pending));
+		return true;
+	}
+
+	void GLBImporter::DecodeImage(PendingImage& pending)
+	{
+		// same options tinygltf uses when it decodes while parsing, expanded to RGBA
+		tinygltf::LoadImageDataOption option;
+		auto& image = m_model.images[pending.imageIndex];
+		pending.decoded = tinygltf::LoadImageData(&image, pending.imageIndex, &pending.err, &pending.warn,
+			pending.requiredWidth, pending.requiredHeight, pending.bytes.data(), static_cast<int>(pending.bytes.size()), &option);
+
+		pending.bytes.clear();
+		pending.bytes.shrink_to_fit();
+	}
+
+	void GLBImporter::SubmitImageDecodes(JobSystem& jobs, JobCounter& counter)
+	{
+		for (auto& pending : m_pendingImages)
+		{
+			PendingImage* image = &pending;
+			jobs.Submit([this, image]() { DecodeImage(*image); }, &counter);
+		}
+	}
+
+	bool GLBImporter::FinishImages(std::string& err, std::string& warn)
+	{
+		bool success = true;
+		for (auto& pending : m_pendingImages)
+		{
+			warn += pending.warn;
+			if (!pending.decoded)
+			{
+				err += pending.err;
+				success = false;
+			}
+		}
+		m_pendingImages.clear();
+		return success;
+	}
+
+	bool GLBImporter::Load(const std::string& fileName, JobSystem& jobs, std::string& err, std::string& warn)
+	{
+		if (!Parse(fileName, err, warn))
+			return false;
+
+		JobCounter counter;
+		SubmitImageDecodes(jobs, counter);
+		jobs.Wait(counter);
+		return FinishImages(err, warn);
+	}
+
+	void GLBImporter::Clear()
+	{
+		m_model = tinygltf::Model();
+		m_pendingImages.clear();
+		m_scene.Clear();
+	}
+
+	void GLBImporter::ParseMaterials(JobSystem& jobs)
+	{
+		m_scene.materials.resize(m_model.materials.size());
+		jobs.ParallelFor(m_model.materials.size(), 4, [this](size_t begin, size_t end, unsigned)
+			{
+				for (size_t i = begin; i < end; ++i)
+					m_scene.materials[i] = ParseMaterial(m_model.materials[i]);
+			});
+	}
+
+	GLBMaterialDesc GLBImporter::ParseMaterial(const tinygltf::Material& gltfMaterial)
+	{
+		GLBMaterialDesc desc;
+		desc.name = gltfMaterial.name;
+
+		// Parse base color factor
+		constexpr const char* BASE_COLOR_FACTOR = "baseColorFactor";
+		if (gltfMaterial.values.find(BASE_COLOR_FACTOR) != gltfMaterial.values.end())
+		{
+			const auto& factor = gltfMaterial.values.at(BASE_COLOR_FACTOR).ColorFactor();
+			desc.baseColorFactor = glm::vec4(factor[0], factor[1], factor[2], factor[3]);
+			if (desc.baseColorFactor.w > 0.0f && desc.baseColorFactor.w < 1.0f)
+			{
+				desc.useTransparency = true;
+			}
+		}
+
+		// Parse base color texture and its KHR_texture_transform
+		constexpr const char* BASE_COLOR_TEXTURE = "baseColorTexture";
+		if (gltfMaterial.values.find(BASE_COLOR_TEXTURE) != gltfMaterial.values.end())
+		{
+			desc.baseColorTexture = gltfMaterial.values.at(BASE_COLOR_TEXTURE).TextureIndex();
+
+			auto& extensions = gltfMaterial.pbrMetallicRoughness.baseColorTexture.extensions;
+			if (extensions.find("KHR_texture_transform") != extensions.end())
+			{
+				const tinygltf::Value& transform = extensions.at("KHR_texture_transform");
+				if (transform.Has("scale") && transform.Get("scale").IsArray())
+				{
+					const auto& scaleArray = transform.Get("scale");
+					desc.scale = glm::vec2(
+						static_cast<float>(scaleArray.Get(0).GetNumberAsDouble()),
+						static_cast<float>(scaleArray.Get(1).GetNumberAsDouble()));
+				}
+			}
+		}
+
+		// Parse metallic and roughness factors
+		constexpr const char* METALLIC_FACTOR = "metallicFactor";
+		if (gltfMaterial.values.find(METALLIC_FACTOR) != gltfMaterial.values.end())
+		{
+			const auto& param = gltfMaterial.values.at(METALLIC_FACTOR);
+			if (param.has_number_value)
+				desc.metallicFactor = static_cast<float>(param.Factor());
+		}
+
+		constexpr const char* ROUGHNESS_FACTOR = "roughnessFactor";
+		if (gltfMaterial.values.find(ROUGHNESS_FACTOR) != gltfMaterial.values.end())
+		{
+			const auto& param = gltfMaterial.values.at(ROUGHNESS_FACTOR);
+			if (param.has_number_value)
+				desc.roughnessFactor = static_cast<float>(param.Factor());
+		}
+
+		constexpr const char* METALLIC_ROUGHNESS_TEXTURE = "metallicRoughnessTexture";
+		if (gltfMaterial.values.find(METALLIC_ROUGHNESS_TEXTURE) != gltfMaterial.values.end())
+		{
+			desc.metallicRoughnessTexture = gltfMaterial.values.at(METALLIC_ROUGHNESS_TEXTURE).TextureIndex();
+		}
+
+		// Parse normal, occlusion and emissive textures
+		constexpr const char* NORMAL_TEXTURE = "normalTexture";
+		if (gltfMaterial.additionalValues.find(NORMAL_TEXTURE) != gltfMaterial.additionalValues.end())
+		{
+			desc.normalTexture = gltfMaterial.additionalValues.at(NORMAL_TEXTURE).TextureIndex();
+		}
+
+		constexpr const char* OCCLUSION_TEXTURE = "occlusionTexture";
+		if (gltfMaterial.additionalValues.find(OCCLUSION_TEXTURE) != gltfMaterial.additionalValues.end())
+		{
+			desc.occlusionTexture = gltfMaterial.additionalValues.at(OCCLUSION_TEXTURE).TextureIndex();
+		}
+
+		constexpr const char* EMISSIVE_TEXTURE = "emissiveTexture";
+		if (gltfMaterial.additionalValues.find(EMISSIVE_TEXTURE) != gltfMaterial.additionalValues.end())
+		{
+			desc.emissiveTexture = gltfMaterial.additionalValues.at(EMISSIVE_TEXTURE).TextureIndex();
+		}
+
+		// Parse emissive factor and strength
+		constexpr const char* EMISSIVE_FACTOR = "emissiveFactor";
+		if (gltfMaterial.additionalValues.find(EMISSIVE_FACTOR) != gltfMaterial.additionalValues.end())
+		{
+			const auto& factor = gltfMaterial.additionalValues.at(EMISSIVE_FACTOR).ColorFactor();
+			desc.emissiveFactor = glm::vec3(factor[0], factor[1], factor[2]);
+		}
+
+		constexpr const char* KHR_materials_emissive_strength = "KHR_materials_emissive_strength";
+		if (gltfMaterial.extensions.find(KHR_materials_emissive_strength) != gltfMaterial.extensions.end())
+		{
+			const tinygltf::Value& emissionStr = gltfMaterial.extensions.at(KHR_materials_emissive_strength);
+			if (emissionStr.Has("emissiveStrength"))
+			{
+				desc.hasEmissiveStrength = true;
+				desc.emissiveStrength = static_cast<float>(emissionStr.Get("emissiveStrength").GetNumberAsDouble());
+			}
+		}
+
+		// Parse KHR_materials_transmission
+		constexpr const char* KHR_MATERIALS_TRANSMISSION = "KHR_materials_transmission";
+		if (gltfMaterial.extensions.find(KHR_MATERIALS_TRANSMISSION) != gltfMaterial.extensions.end())
+		{
+			const tinygltf::Value& transmission = gltfMaterial.extensions.at(KHR_MATERIALS_TRANSMISSION);
+			if (transmission.Has("transmissionFactor") && transmission.Get("transmissionFactor").IsNumber())
+			{
+				desc.transmissionFactor = static_cast<float>(transmission.Get("transmissionFactor").GetNumberAsDouble());
+				if (desc.transmissionFactor)
+					desc.useTransparency = true;
+			}
+		}
+
+		// Parse KHR_materials_volume
+		constexpr const char* KHR_MATERIALS_VOLUME = "KHR_materials_volume";
+		if (gltfMaterial.extensions.find(KHR_MATERIALS_VOLUME) != gltfMaterial.extensions.end())
+		{
+			const tinygltf::Value& volume = gltfMaterial.extensions.at(KHR_MATERIALS_VOLUME);
+
+			if (volume.Has("thicknessFactor") && volume.Get("thicknessFactor").IsNumber())
+			{
+				desc.thickness = static_cast<float>(volume.Get("thicknessFactor").GetNumberAsDouble());
+			}
+
+			if (volume.Has("attenuationColor") && volume.Get("attenuationColor").IsArray())
+			{
+				const auto& colorArray = volume.Get("attenuationColor");
+				desc.attenuationColor = glm::vec3(
+					static_cast<float>(colorArray.Get(0).GetNumberAsDouble()),
+					static_cast<float>(colorArray.Get(1).GetNumberAsDouble()),
+					static_cast<float>(colorArray.Get(2).GetNumberAsDouble()));
+			}
+
+			if (volume.Has("attenuationDistance") && volume.Get("attenuationDistance").IsNumber())
+			{
+				desc.attenuationDistance = static_cast<float>(volume.Get("attenuationDistance").GetNumberAsDouble());
+			}
+		}
+
+		// Refraction Index (KHR_materials_ior)
+		constexpr const char* KHR_MATERIALS_IOR = "KHR_materials_ior";
+		if (gltfMaterial.extensions.find(KHR_MATERIALS_IOR) != gltfMaterial.extensions.end())
+		{
+			const tinygltf::Value& ior = gltfMaterial.extensions.at(KHR_MATERIALS_IOR);
+			if (ior.Has("ior") && ior.Get("ior").IsNumber())
+			{
+				desc.refractionIndex = static_cast<float>(ior.Get("ior").GetNumberAsDouble());
+			}
+		}
+
+		// Alpha properties
+		desc.alphaMode = gltfMaterial.alphaMode;
+		desc.alphaCutoff = static_cast<float>(gltfMaterial.alphaCutoff);
+		desc.doubleSided = gltfMaterial.doubleSided;
+
+		return desc;
+	}
+
+	void GLBImporter::BuildScene()
+	{
+		if (!m_model.scenes.empty())
+		{
+			const auto& scene = m_model.scenes[m_model.defaultScene >= 0 ? m_model.defaultScene : 0];
+			m_scene.rootNodes = scene.nodes;
+		}
+
+		m_scene.nodes.clear();
+		m_scene.nodes.reserve(m_model.nodes.size());
+		for (const auto& node : m_model.nodes)
+		{
+			m_scene.nodes.push_back(ParseNode(node));
+		}
+
+		m_scene.meshes.resize(m_model.meshes.size());
+		for (size_t i = 0; i < m_model.meshes.size(); ++i)
+		{
+			m_scene.meshes[i].name = m_model.meshes[i].name;
+		}
+
+		m_scene.skins.clear();
+		for (const auto& skin : m_model.skins)
+		{
+			m_scene.skins.push_back(ParseSkin(m_model, skin));
+		}
+
+		m_scene.hasLights = m_model.extensions.find("KHR_lights_punctual") != m_model.extensions.end();
+		m_scene.lights.clear();
+		for (const auto& light : m_model.lights)
+		{
+			GLBLightDesc desc;
+			desc.type = light.type;
+			if (light.color.size() >= 3)
+				desc.color = glm::vec3(light.color[0], light.color[1], light.color[2]);
+			desc.intensity = static_cast<float>(light.intensity);
+			desc.range = static_cast<float>(light.range);
+			desc.innerConeAngle = static_cast<float>(light.spot.innerConeAngle);
+			desc.outerConeAngle = static_cast<float>(light.spot.outerConeAngle);
+			m_scene.lights.push_back(desc);
+		}
+
+		m_scene.textureImages.clear();
+		for (const auto& texture : m_model.textures)
+		{
+			m_scene.textureImages.push_back(texture.source);
+		}
+
+		m_scene.images.clear();
+		for (const auto& image : m_model.images)
+		{
+			GLBImageView view;
+			view.width = image.width;
+			view.height = image.height;
+			view.component = image.component;
+			view.bits = image.bits;
+			view.pixels = image.image.data();
+			view.size = image.image.size();
+			m_scene.images.push_back(view);
+		}
+	}
+
+	GLBNodeDesc GLBImporter::ParseNode(const tinygltf::Node& gltfNode)
+	{
+		GLBNodeDesc desc;
+		desc.name = gltfNode.name;
+		desc.mesh = gltfNode.mesh;
+		desc.skin = gltfNode.skin;
+		desc.camera = gltfNode.camera;
+		desc.light = gltfNode.light;
+		desc.children = gltfNode.children;
+
+		if (!gltfNode.matrix.empty() && gltfNode.matrix.size() == 16)
+		{
+			// Load the matrix directly
+			glm::mat4 matrix(1.0f);
+			for (int i = 0; i < 16; ++i) {
+				matrix[i / 4][i % 4] = static_cast<float>(gltfNode.matrix[i]);
+			}
+
+			// Decompose the matrix into T/R/S
+			glm::vec3 skew;
+			glm::vec4 perspective;
+			if (!glm::decompose(matrix, desc.scale, desc.rotation, desc.translation, skew, perspective))
+			{
+				std::cerr << "Error: Failed to decompose matrix in GLTF node." << std::endl;
+				desc.translation = glm::vec3(0.0f);
+				desc.rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+				desc.scale = glm::vec3(1.0f);
+			}
+			return desc;
+		}
+
+		// Parse translation
+		if (!gltfNode.translation.empty() && gltfNode.translation.size() == 3)
+		{
+			desc.translation = glm::vec3(
+				gltfNode.translation[0],
+				gltfNode.translation[1],
+				gltfNode.translation[2]);
+		}
+
+		// Parse rotation (GLTF quaternion format: x, y, z, w)
+		if (!gltfNode.rotation.empty() && gltfNode.rotation.size() == 4)
+		{
+			desc.rotation = glm::quat(
+				static_cast<float>(gltfNode.rotation[3]), // w
+				static_cast<float>(gltfNode.rotation[0]), // x
+				static_cast<float>(gltfNode.rotation[1]), // y
+				static_cast<float>(gltfNode.rotation[2])); // z
+		}
+
+		// Parse scale
+		if (!gltfNode.scale.empty() && gltfNode.scale.size() == 3)
+		{
+			desc.scale = glm::vec3(
+				gltfNode.scale[0],
+				gltfNode.scale[1],
+				gltfNode.scale[2]);
+		}
+
+		return desc;
+	}
+
+	GLBSkinDesc GLBImporter::ParseSkin(const tinygltf::Model& model, const tinygltf::Skin& skin)
+	{
+		GLBSkinDesc desc;
+		desc.name = skin.name;
+		desc.skeleton = skin.skeleton;
+		desc.joints = skin.joints;
+
+		if (skin.inverseBindMatrices >= 0)
+		{
+			const auto& accessor = model.accessors[skin.inverseBindMatrices];
+			const auto& bufferView = model.bufferViews[accessor.bufferView];
+			const auto& buffer = model.buffers[bufferView.buffer];
+
+			const glm::mat4* data = reinterpret_cast<const glm::mat4*>(
+				&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
+			desc.inverseBindMatrices.assign(data, data + accessor.count);
+		}
+
+		return desc;
+	}
+}
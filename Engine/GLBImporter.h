@@ -0,0 +1,189 @@
+#ifndef GLB_IMPORTER_H
+#define GLB_IMPORTER_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <tiny_gltf.h>
+
+#include "CollisionShapes.h"
+#include "VertexStructures.h"
+
+namespace JLEngine
+{
+	class JobSystem;
+	struct JobCounter;
+
+	// Everything GLBLoader reads from a glTF material, parsed on a worker so the main thread only has
+	// to create the Material and its textures. Texture slots are glTF texture indices, -1 when unused
+	struct GLBMaterialDesc
+	{
+		std::string name;
+
+		glm::vec4 baseColorFactor = glm::vec4(1.0f);
+		float metallicFactor = 1.0f;
+		float roughnessFactor = 1.0f;
+		glm::vec3 emissiveFactor = glm::vec3(0.0f);
+		bool hasEmissiveStrength = false;
+		float emissiveStrength = 1.0f;		// before EmissionStrengthMultiplier
+
+		float transmissionFactor = 0.0f;
+		float refractionIndex = 1.5f;		// default IOR for glass
+		float thickness = 0.0f;
+		glm::vec3 attenuationColor = glm::vec3(1.0f);
+		float attenuationDistance = std::numeric_limits<float>::max();
+
+		std::string alphaMode;
+		float alphaCutoff = 0.5f;
+		bool doubleSided = false;
+		bool useTransparency = false;
+
+		glm::vec2 scale = glm::vec2(1.0f);	// KHR_texture_transform on the base colour texture
+
+		int baseColorTexture = -1;
+		int metallicRoughnessTexture = -1;
+		int normalTexture = -1;
+		int occlusionTexture = -1;
+		int emissiveTexture = -1;
+	};
+
+	// A glTF node's indices and local transform, a matrix is decomposed into T/R/S when it is parsed
+	struct GLBNodeDesc
+	{
+		std::string name;
+		int mesh = -1;
+		int skin = -1;
+		int camera = -1;
+		int light = -1;
+
+		glm::vec3 translation = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 scale = glm::vec3(1.0f);
+
+		std::vector<int> children;
+	};
+
+	struct GLBSkinDesc
+	{
+		std::string name;
+		int skeleton = -1;
+		std::vector<int> joints;						// node indices
+		std::vector<glm::mat4> inverseBindMatrices;		// empty when the skin has none
+	};
+
+	// KHR_lights_punctual values as glTF stores them
+	struct GLBLightDesc
+	{
+		std::string type;
+		glm::vec3 color = glm::vec3(1.0f);
+		float intensity = 1.0f;
+		float range = 0.0f;
+		float innerConeAngle = 0.0f;
+		float outerConeAngle = 0.7853981634f;
+	};
+
+	// Decoded pixels, owned by the glTF model or the mapped cache file the scene came from
+	struct GLBImageView
+	{
+		int width = 0;
+		int height = 0;
+		int component = 0;
+		int bits = 8;
+		const unsigned char* pixels = nullptr;
+		size_t size = 0;
+	};
+
+	// One submesh ready for a batched VAO, vertices interleaved for attribKey and indices local to them
+	struct GLBSubMeshView
+	{
+		int materialIndex = -1;
+		VertexAttribKey attribKey = 0;
+		AABB aabb{};
+		const std::byte* vertices = nullptr;
+		size_t vertexBytes = 0;
+		const uint32_t* indices = nullptr;
+		size_t indexCount = 0;
+	};
+
+	struct GLBMeshDesc
+	{
+		std::string name;
+		bool prepared = false;		// submeshes have been filled in
+		std::vector<GLBSubMeshView> submeshes;
+	};
+
+	// Everything GLBLoader's merge reads, without any tinygltf types so it can come from a parsed model
+	// or a cooked mesh cache. Pixels and geometry are views, their owner has to outlive the merge
+	struct GLBScene
+	{
+		std::vector<int> rootNodes;
+		std::vector<GLBNodeDesc> nodes;
+		std::vector<GLBMeshDesc> meshes;
+		std::vector<GLBSkinDesc> skins;
+		std::vector<GLBLightDesc> lights;
+		bool hasLights = false;				// the file declares KHR_lights_punctual
+		std::vector<GLBMaterialDesc> materials;
+		std::vector<int> textureImages;		// image index of each glTF texture
+		std::vector<GLBImageView> images;
+
+		void Clear() { *this = GLBScene(); }
+	};
+
+	// CPU half of a GLB import, nothing here touches GL or the resource managers. tinygltf only copies
+	// the embedded PNG/JPEG bytes while parsing, stb decodes them later as one job per image, and the
+	// materials are parsed in parallel, so GLBLoader can run both alongside its own geometry jobs and
+	// keep the main thread for the final merge into the batched VAOs
+	class GLBImporter
+	{
+	public:
+		// .glb or .gltf, images are left encoded until SubmitImageDecodes
+		bool Parse(const std::string& fileName, std::string& err, std::string& warn);
+
+		// One job per image against counter, call FinishImages after waiting on it
+		void SubmitImageDecodes(JobSystem& jobs, JobCounter& counter);
+		// Reports the images that failed to decode, a failure fails the import like tinygltf would
+		bool FinishImages(std::string& err, std::string& warn);
+		// Parse, decode and wait in one call
+		bool Load(const std::string& fileName, JobSystem& jobs, std::string& err, std::string& warn);
+		// Frees the model and its decoded images once they have been merged
+		void Clear();
+
+		void ParseMaterials(JobSystem& jobs);
+		static GLBMaterialDesc ParseMaterial(const tinygltf::Material& gltfMaterial);
+
+		// Fills the scene from the model, after FinishImages so the image views point at decoded pixels.
+		// Meshes only get their names, the submeshes are prepared by GLBLoader
+		void BuildScene();
+		static GLBNodeDesc ParseNode(const tinygltf::Node& gltfNode);
+		static GLBSkinDesc ParseSkin(const tinygltf::Model& model, const tinygltf::Skin& skin);
+
+		tinygltf::Model& GetModel() { return m_model; }
+		const tinygltf::Model& GetModel() const { return m_model; }
+		GLBScene& GetScene() { return m_scene; }
+		const std::vector<GLBMaterialDesc>& GetMaterials() const { return m_scene.materials; }
+
+	private:
+		struct PendingImage
+		{
+			int imageIndex;
+			int requiredWidth;
+			int requiredHeight;
+			std::vector<unsigned char> bytes;	// tinygltf frees its copy of a data uri or external file
+			std::string err, warn;
+			bool decoded = false;
+		};
+
+		static bool DeferImage(tinygltf::Image* image, const int imageIndex, std::string* err, std::string* warn,
+			int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData);
+		void DecodeImage(PendingImage& pending);
+
+		tinygltf::Model m_model;
+		std::vector<PendingImage> m_pendingImages;
+		GLBScene m_scene;
+	};
+}
+
+#endif
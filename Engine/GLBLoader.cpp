@@ -7,13 +7,18 @@
 #include "GraphicsAPI.h"
 #include "ResourceLoader.h"
 #include "JLHelpers.h"
+#include "JobSystem.h"
 
 #include <tiny_gltf.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 #include "Geometry.h"
+#include "VertexQuantization.h"
 #include <glm/gtx/string_cast.hpp>
+#include <filesystem>
 #include <unordered_set>
+#include <atomic>
+#include <cstring>
 
 namespace JLEngine
 {
@@ -22,73 +27,493 @@ namespace JLEngine
     {
     }
 
-	std::shared_ptr<Node> GLBLoader::LoadGLB(const std::string& fileName)
+	namespace
 	{
-		std::cout << "Loading GLB: " << fileName << std::endl;
-
-		// Load GLB file using tinygltf
-		tinygltf::TinyGLTF loader;
-		tinygltf::Model model;
-		std::string err, warn;
+		// the slot names ParseMaterial passes to ParseTexture
+		const char* SlotName(TextureUsage usage)
+		{
+			switch (usage)
+			{
+			case TextureUsage::BaseColor: return "baseColorTexture";
+			case TextureUsage::MetallicRoughness: return "metallicRoughnessTexture";
+			case TextureUsage::Normal: return "normalTexture";
+			case TextureUsage::Occlusion: return "occlusionTexture";
+			case TextureUsage::Emissive: return "emissiveTexture";
+			}
+			return "";
+		}
 
-		bool ret = false;
+		// Only base color of alpha tested materials keeps its coverage down the mips
+		float AlphaCutoff(const GLBMaterialDesc& material, TextureUsage usage)
+		{
+			return usage == TextureUsage::BaseColor && material.alphaMode == "MASK" ? material.alphaCutoff : -1.0f;
+		}
 
-		size_t dotPos = fileName.find_last_of(".");
-		if (dotPos == std::string::npos)
+		// The chain as an uncompressed KTX2 image, in the format the decoded image would upload as
+		std::shared_ptr<KTX2Image> ToKTX2(const MipChain& chain, bool srgb)
 		{
-			std::cout << "Extension missing" << std::endl;
-			return nullptr;
+			KTX2Format formats[] = { KTX2Format::R8_UNORM, KTX2Format::RG8_UNORM,
+				srgb ? KTX2Format::RGB8_SRGB : KTX2Format::RGB8_UNORM, srgb ? KTX2Format::RGBA8_SRGB : KTX2Format::RGBA8_UNORM };
+
+			auto image = std::make_shared<KTX2Image>();
+			image->Allocate(formats[chain.channels - 1], chain.width, chain.height, static_cast<uint32_t>(chain.levels.size()));
+			for (size_t level = 0; level < chain.levels.size(); ++level)
+				std::memcpy(image->MutableImageData(level, 0, 0), chain.LevelData(level), chain.levels[level].size);
+			return image;
 		}
-		auto extension = fileName.substr(dotPos + 1);
+	}
+
+	std::shared_ptr<Node> GLBLoader::LoadGLB(const std::string& fileName)
+	{
+		// the same parts AssetStreamer runs, all on the calling thread
+		auto import = CreateImport(fileName);
+		if (!Import(*import, JobSystem::Global()))
+			return nullptr;
 
-		if (extension == "glb")
-			ret = loader.LoadBinaryFromFile(&model, &err, &warn, fileName);
-		else if (extension == "gltf")
-			ret = loader.LoadASCIIFromFile(&model, &err, &warn, fileName);
+		while (!MergeStep(*import)) {}
+		WriteCache(*import);
 
-		if (!warn.empty())
+		return import->root;
+	}
+
+	std::shared_ptr<GLBImport> GLBLoader::CreateImport(const std::string& fileName) const
+	{
+		auto import = std::make_shared<GLBImport>();
+		import->fileName = fileName;
+		import->compressAnimations = CompressAnimations;
+		import->compression = AnimationCompression;
+		import->settingsHash = SettingsHash();
+		import->compactVertices = Settings.CompactVertices;
+		import->optimizeMeshes = Settings.OptimizeMeshes;
+		import->compressTextures = CompressTextures;
+		import->textureCompression = TextureCompression;
+		import->mipmapTextures = MipmapTextures;
+		import->cacheFolder = CacheFolder;
+		return import;
+	}
+
+	bool GLBLoader::Import(GLBImport& import, JobSystem& jobs)
+	{
+		std::cout << "Loading GLB: " << import.fileName << std::endl;
+
+		// --- MESH CACHE --- //
+		// a cooked copy of an unchanged file only has to be mapped and merged
+		if (!import.cacheFolder.empty())
 		{
-			std::cerr << "GLBLoader Warning: " << warn << std::endl;
+			import.cacheHash = MeshCache::HashSource(import.fileName, import.settingsHash);
+			if (import.cacheHash != 0)
+			{
+				import.cachePath = MeshCache::CachePath(import.cacheFolder, import.fileName, import.cacheHash);
+				if (import.cookedCache.Open(import.cachePath, import.cacheHash))
+				{
+					std::cout << "Using mesh cache: " << import.cachePath << std::endl;
+					LoadCachedAnimations(import);
+					import.cacheHit = true;
+					import.scene = &import.cookedCache.GetScene();
+					CookTextures(import, jobs);
+					GenerateTextureMips(import, jobs);
+					import.stage = GLBImport::Stage::Animations;
+					return true;
+				}
+			}
 		}
 
-		if (!ret)
+		GLBImporter& importer = import.importer;
+		std::string err, warn;
+		if (!importer.Parse(import.fileName, err, warn))
 		{
+			if (!warn.empty())
+				std::cerr << "GLBLoader Warning: " << warn << std::endl;
 			std::cerr << "GLBLoader Error: Failed to load GLB file: " << err << std::endl;
-			return nullptr;
+			import.stage = GLBImport::Stage::Failed;
+			return false;
 		}
 
+		const tinygltf::Model& model = importer.GetModel();
 		if (model.scenes.empty())
 		{
 			std::cerr << "GLBLoader Error: No scenes found in GLB file." << std::endl;
-			return nullptr;
+			importer.Clear();
+			import.stage = GLBImport::Stage::Failed;
+			return false;
 		}
 
 		// Retrieve the default scene or the first scene
-		const tinygltf::Scene& scene = model.scenes[model.defaultScene >= 0 ? model.defaultScene : 0];
-		auto rootNode = std::make_shared<Node>("RootNode");
-		rootNode->SetTag(NodeTag::Default);
+		const tinygltf::Scene& gltfScene = model.scenes[model.defaultScene >= 0 ? model.defaultScene : 0];
+
+		// --- WORKER STAGE --- //
+		// image decodes and submesh preparation only read the model, the geometry jobs need the
+		// material texture transforms so the materials are parsed first
+		importer.ParseMaterials(jobs);
+
+		JobCounter counter;
+		importer.SubmitImageDecodes(jobs, counter);
+		PrepareMeshes(import, gltfScene, jobs, counter);
 
+		// animations are parsed and compressed here while the workers run, the merge publishes them
 		for (auto i = 0; i < model.animations.size(); i++)
 		{
 			const auto& gltfAnim = model.animations[i];
-			ParseAnimation(i, model, gltfAnim);
+			import.animations.push_back(ParseAnimation(import, i, model, gltfAnim));
 		}
 
-		// Parse all nodes in the scene
-		for (int nodeIndex : scene.nodes)
+		jobs.Wait(counter);
+
+		if (import.optimizeMeshes)
 		{
-			if (nodeIndex < 0 || nodeIndex >= model.nodes.size())
+			MeshOptimizationStats optimization;
+			for (const auto& [meshIndex, submeshes] : import.preparedMeshes)
+			{
+				for (const auto& submesh : submeshes)
+					optimization += submesh.optimization;
+			}
+			std::cout << "Mesh optimization " << import.fileName << ": " << optimization.verticesBefore << " -> " << optimization.verticesAfter
+				<< " vertices, ACMR " << optimization.AcmrBefore() << " -> " << optimization.AcmrAfter()
+				<< ", ATVR " << optimization.AtvrBefore() << " -> " << optimization.AtvrAfter() << std::endl;
+		}
+
+		bool imagesDecoded = importer.FinishImages(err, warn);
+		if (!warn.empty())
+		{
+			std::cerr << "GLBLoader Warning: " << warn << std::endl;
+		}
+
+		if (!imagesDecoded)
+		{
+			std::cerr << "GLBLoader Error: Failed to load GLB file: " << err << std::endl;
+			import.preparedMeshes.clear();
+			import.animations.clear();
+			importer.Clear();
+			import.stage = GLBImport::Stage::Failed;
+			return false;
+		}
+
+		// the merge reads the scene, its submeshes point at the prepared geometry
+		importer.BuildScene();
+		GLBScene& scene = importer.GetScene();
+		for (const auto& [meshIndex, submeshes] : import.preparedMeshes)
+		{
+			auto& mesh = scene.meshes[meshIndex];
+			mesh.prepared = true;
+			for (const auto& submesh : submeshes)
+				mesh.submeshes.push_back(submesh.View());
+		}
+
+		import.scene = &scene;
+		CookTextures(import, jobs);
+		GenerateTextureMips(import, jobs);
+		import.stage = GLBImport::Stage::Animations;
+		return true;
+	}
+
+	void GLBLoader::CookTextures(GLBImport& import, JobSystem& jobs)
+	{
+		// the cooked textures are keyed off the mesh cache's source hash
+		if (!import.compressTextures || import.cacheHash == 0)
+			return;
+
+		const GLBScene& scene = *import.scene;
+		for (const auto& material : scene.materials)
+		{
+			// the same order ParseMaterial reads the slots in
+			const std::pair<int, TextureUsage> slots[] = {
+				{ material.baseColorTexture, TextureUsage::BaseColor },
+				{ material.metallicRoughnessTexture, TextureUsage::MetallicRoughness },
+				{ material.normalTexture, TextureUsage::Normal },
+				{ material.occlusionTexture, TextureUsage::Occlusion },
+				{ material.emissiveTexture, TextureUsage::Emissive } };
+
+			for (const auto& [textureIndex, usage] : slots)
+			{
+				if (textureIndex < 0 || textureIndex >= scene.textureImages.size() || import.cookedTextures.count(textureIndex))
+					continue;
+				int source = scene.textureImages[textureIndex];
+				if (source < 0 || source >= scene.images.size() || scene.images[source].bits != 8)
+					continue;
+
+				auto cooked = std::make_unique<CookedTexture>();
+				cooked->usage = usage;
+				cooked->image = source;
+				cooked->alphaCutoff = AlphaCutoff(material, usage);
+				import.cookedTextures[textureIndex] = std::move(cooked);
+			}
+		}
+
+		if (import.cookedTextures.empty())
+			return;
+
+		std::error_code error;
+		std::filesystem::create_directories(import.cacheFolder, error);
+
+		// textures sharing an image and slot share the file, each file is cooked once
+		std::unordered_map<uint64_t, std::vector<CookedTexture*>> misses;
+		for (auto& [textureIndex, cooked] : import.cookedTextures)
+		{
+			uint64_t hash = TextureCache::Hash(import.cacheHash, cooked->image, cooked->usage, import.textureCompression, cooked->alphaCutoff);
+			cooked->cachePath = TextureCache::CachePath(import.cacheFolder, hash);
+			cooked->cacheHash = hash;
+			if (!cooked->cache.Open(cooked->cachePath, hash))
+				misses[hash].push_back(cooked.get());
+		}
+
+		// each miss is its own job and spreads its block rows over the pool as well
+		JobCounter counter;
+		std::atomic<int> failed = 0;
+		for (const auto& [hash, targets] : misses)
+		{
+			const GLBImageView* image = &scene.images[targets.front()->image];
+			std::string path = TextureCache::CachePath(import.cacheFolder, hash);
+			jobs.Submit([&import, &jobs, &failed, &targets, image, hash, path]()
+				{
+					auto compressed = TextureCooker::Cook(image->pixels, image->width, image->height, image->component,
+						targets.front()->usage, import.textureCompression, &jobs, targets.front()->alphaCutoff);
+					bool written = TextureCache::Write(path, hash, compressed);
+					for (CookedTexture* target : targets)
+						written = written && target->cache.Open(path, hash);
+					if (!written)
+					{
+						std::cerr << "GLBLoader: could not cook " << path << ", the texture is uploaded uncompressed" << std::endl;
+						failed++;
+					}
+				}, &counter);
+		}
+		jobs.Wait(counter);
+
+		std::cout << "Compressed textures " << import.fileName << ": " << misses.size() - failed << " cooked, "
+			<< import.cookedTextures.size() - misses.size() << " from the cache" << std::endl;
+	}
+
+	void GLBLoader::GenerateTextureMips(GLBImport& import, JobSystem& jobs)
+	{
+		if (!import.mipmapTextures)
+			return;
+
+		const GLBScene& scene = *import.scene;
+		for (const auto& material : scene.materials)
+		{
+			const std::pair<int, TextureUsage> slots[] = {
+				{ material.baseColorTexture, TextureUsage::BaseColor },
+				{ material.metallicRoughnessTexture, TextureUsage::MetallicRoughness },
+				{ material.normalTexture, TextureUsage::Normal },
+				{ material.occlusionTexture, TextureUsage::Occlusion },
+				{ material.emissiveTexture, TextureUsage::Emissive } };
+
+			for (const auto& [textureIndex, usage] : slots)
+			{
+				if (textureIndex < 0 || textureIndex >= scene.textureImages.size() ||
+					import.cookedTextures.count(textureIndex) || import.mipmappedTextures.count(textureIndex))
+					continue;
+				int source = scene.textureImages[textureIndex];
+				if (source < 0 || source >= scene.images.size() || scene.images[source].bits != 8 ||
+					scene.images[source].component < 1 || scene.images[source].component > 4)
+					continue;
+
+				auto mipmapped = std::make_unique<MipmappedTexture>();
+				mipmapped->usage = usage;
+				mipmapped->image = source;
+				mipmapped->settings = TextureCooker::MipSettingsFor(usage, AlphaCutoff(material, usage));
+				import.mipmappedTextures[textureIndex] = std::move(mipmapped);
+			}
+		}
+
+		if (import.mipmappedTextures.empty())
+			return;
+
+		// the chains are keyed like the cooked textures, without a cache the key only groups the slots
+		bool useCache = import.cacheHash != 0 && !import.cacheFolder.empty();
+		if (useCache)
+		{
+			std::error_code error;
+			std::filesystem::create_directories(import.cacheFolder, error);
+		}
+
+		std::unordered_map<uint64_t, std::vector<MipmappedTexture*>> misses;
+		for (auto& [textureIndex, mipmapped] : import.mipmappedTextures)
+		{
+			uint64_t hash = MipGenerator::CacheHash(import.cacheHash, mipmapped->image, mipmapped->settings);
+			if (useCache && mipmapped->file.Open(MipGenerator::CachePath(import.cacheFolder, hash)))
+				mipmapped->cachePath = MipGenerator::CachePath(import.cacheFolder, hash);
+			else
+				misses[hash].push_back(mipmapped.get());
+		}
+
+		// one job per chain, each level's rows spread over the pool as well
+		JobCounter counter;
+		for (const auto& [hash, targets] : misses)
+		{
+			const GLBImageView* image = &scene.images[targets.front()->image];
+			std::string path = useCache ? MipGenerator::CachePath(import.cacheFolder, hash) : std::string();
+			jobs.Submit([&jobs, &targets, image, path]()
+				{
+					const MipSettings& settings = targets.front()->settings;
+					auto chain = MipGenerator::Generate(image->pixels, image->width, image->height, image->component, settings, &jobs);
+					auto generated = ToKTX2(chain, settings.srgb);
+					for (MipmappedTexture* target : targets)
+						target->generated = generated;
+
+					if (!path.empty() && !KTX2File::Write(path, *generated))
+						std::cerr << "GLBLoader: could not write " << path << ", the mips are rebuilt next load" << std::endl;
+					else if (!path.empty())
+					{
+						for (MipmappedTexture* target : targets)
+							target->cachePath = path;
+					}
+				}, &counter);
+		}
+		jobs.Wait(counter);
+
+		std::cout << "Mipmapped textures " << import.fileName << ": " << misses.size() << " generated, "
+			<< import.mipmappedTextures.size() - misses.size() << " from the cache" << std::endl;
+	}
+
+	bool GLBLoader::MergeStep(GLBImport& import)
+	{
+		m_merge = &import;
+		const GLBScene& scene = *import.scene;
+
+		// --- MERGE --- //
+		// single threaded, creates the resources and adds the prepared geometry to the batches.
+		// Materials (and their textures) and meshes go one per step, they are what costs
+		switch (import.stage)
+		{
+		case GLBImport::Stage::Animations:
+		{
+			PublishAnimations(import);
+
+			std::vector<int> meshes;
+			CollectMergeItems(import, import.mergeItems, meshes);
+			import.mergeCursor = 0;
+			import.stage = GLBImport::Stage::Materials;
+			break;
+		}
+		case GLBImport::Stage::Materials:
+		{
+			if (import.mergeCursor < import.mergeItems.size())
+			{
+				ParseMaterial(scene, import.mergeItems[import.mergeCursor++]);
+				break;
+			}
+
+			std::vector<int> materials;
+			CollectMergeItems(import, materials, import.mergeItems);
+			import.mergeCursor = 0;
+			import.stage = GLBImport::Stage::Meshes;
+			break;
+		}
+		case GLBImport::Stage::Meshes:
+		{
+			if (import.mergeCursor < import.mergeItems.size())
+			{
+				ParseMesh(scene, import.mergeItems[import.mergeCursor++]);
+				break;
+			}
+
+			import.mergeItems.clear();
+			import.stage = GLBImport::Stage::Nodes;
+			break;
+		}
+		case GLBImport::Stage::Nodes:
+		{
+			import.root = MergeScene(scene);
+
+			// the channels are retargeted now, copy them for a cache written after the merge
+			if (!import.cacheHit && !import.cachePath.empty())
+			{
+				for (auto& animation : import.animations)
+				{
+					import.cacheAnimations.push_back(MeshCache::Snapshot(*animation));
+				}
+			}
+			import.stage = GLBImport::Stage::Done;
+			break;
+		}
+		default:
+			break;
+		}
+
+		m_merge = nullptr;
+		return import.stage == GLBImport::Stage::Done || import.stage == GLBImport::Stage::Failed;
+	}
+
+	bool GLBLoader::WriteCache(const GLBImport& import)
+	{
+		if (import.cacheHit || import.cachePath.empty() || import.scene == nullptr || import.stage != GLBImport::Stage::Done)
+			return false;
+
+		std::error_code error;
+		std::filesystem::create_directories(import.cacheFolder, error);
+		if (!MeshCache::WriteSnapshots(import.cachePath, import.cacheHash, *import.scene, import.cacheAnimations))
+		{
+			std::cerr << "GLBLoader: could not write " << import.cachePath << ", the file will be imported again next run" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	void GLBLoader::PublishAnimations(GLBImport& import)
+	{
+		// names are shared across files, a file brings in only the animations nothing has loaded yet
+		auto animManager = m_resourceLoader->GetAnimationManager();
+		for (auto& animation : import.animations)
+		{
+			auto existing = animManager->Get(animation->GetName());
+			if (existing != nullptr)
+			{
+				animation = existing;
+				continue;
+			}
+			animManager->Add(animation->GetName(), animation);
+		}
+	}
+
+	void GLBLoader::CollectMergeItems(GLBImport& import, std::vector<int>& materials, std::vector<int>& meshes)
+	{
+		const GLBScene& scene = *import.scene;
+		materials.clear();
+		meshes.clear();
+
+		// only meshes ParseNode would create rather than instance, an existing name makes the nodes
+		// instances of an earlier file's mesh and unnamed meshes are left to the node pass
+		std::unordered_set<int> usedMaterials;
+		for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
+		{
+			const auto& mesh = scene.meshes[meshIndex];
+			if (!mesh.prepared || mesh.name.empty() || m_resourceLoader->Get<Mesh>(mesh.name) != nullptr)
+				continue;
+
+			meshes.push_back(static_cast<int>(meshIndex));
+			for (const auto& submesh : mesh.submeshes)
+			{
+				if (submesh.materialIndex >= 0 && submesh.materialIndex < scene.materials.size() && usedMaterials.insert(submesh.materialIndex).second)
+					materials.push_back(submesh.materialIndex);
+			}
+		}
+	}
+
+	std::shared_ptr<Node> GLBLoader::MergeScene(const GLBScene& scene)
+	{
+		// --- MERGE --- //
+		// single threaded, creates the resources and adds the prepared geometry to the batches
+		auto rootNode = std::make_shared<Node>("RootNode");
+		rootNode->SetTag(NodeTag::Default);
+
+		std::shared_ptr<Node> result = rootNode;
+		for (int nodeIndex : scene.rootNodes)
+		{
+			if (nodeIndex < 0 || nodeIndex >= scene.nodes.size())
 			{
 				std::cerr << "GLBLoader Warning: Invalid node index in scene." << std::endl;
 				continue;
 			}
 
-			const tinygltf::Node& gltfNode = model.nodes[nodeIndex];
-			auto childNode = ParseNode(model, gltfNode, nodeIndex); 
-			childNode->name = gltfNode.name;
+			auto childNode = ParseNode(scene, nodeIndex); 
+			childNode->name = scene.nodes[nodeIndex].name;
 
-			if (scene.nodes.size() == 1)
-				return childNode;
+			if (scene.rootNodes.size() == 1)
+			{
+				result = childNode;
+				break;
+			}
 
 			if (childNode)
 			{
@@ -96,25 +521,29 @@ namespace JLEngine
 			}
 		}
 
-		return rootNode;
+		return result;
 	}
 
-	std::shared_ptr<Node> GLBLoader::ParseNode(const tinygltf::Model& model, const tinygltf::Node& gltfNode, int nodeIndex)
+	std::shared_ptr<Node> GLBLoader::ParseNode(const GLBScene& scene, int nodeIndex)
 	{
+		const GLBNodeDesc& gltfNode = scene.nodes[nodeIndex];
 		auto node = std::make_shared<Node>(gltfNode.name.empty() ? "UnnamedNode" : gltfNode.name);
-		nodeMapping[nodeIndex] = node;
+		m_merge->nodeMapping[nodeIndex] = node;
 
-		bool found = AssociateAnimationWithNode(model, nodeIndex, node.get());
+		bool found = AssociateAnimationWithNode(nodeIndex, node.get());
 
-		ParseTransform(node, gltfNode);
+		node->SetTRS(gltfNode.translation, gltfNode.rotation, gltfNode.scale);
 
 		// Handle mesh
 		if (gltfNode.mesh >= 0)
 		{
 			node->SetTag(NodeTag::Mesh);
 
-			auto& meshName = model.meshes[gltfNode.mesh].name;
-			auto existingMesh = m_resourceLoader->Get<Mesh>(meshName);
+			// a mesh MergeStep created ahead of the nodes is this file's own until a node owns it
+			auto& meshName = scene.meshes[gltfNode.mesh].name;
+			auto parsedAhead = m_merge->meshCache.find(gltfNode.mesh);
+			bool unowned = parsedAhead != m_merge->meshCache.end() && parsedAhead->second->node == nullptr;
+			auto existingMesh = unowned ? nullptr : m_resourceLoader->Get<Mesh>(meshName);
 
 			// Check if it's an instance (i.e. if the mesh has been referenced before)
 			if (existingMesh != nullptr)
@@ -148,15 +577,15 @@ namespace JLEngine
 			}
 			else
 			{
-				node->mesh = ParseMesh(model, gltfNode.mesh);
+				node->mesh = ParseMesh(scene, gltfNode.mesh);
 				node->mesh->node = node.get(); // set the node to the "owner" node
 
 				if (found)
 					node->mesh->GetSubmesh(0).flags |= SubmeshFlags::ANIMATED;
 				if (gltfNode.skin >= 0)
 				{
-					const auto& skin = model.skins[gltfNode.skin];
-					ParseSkin(model, skin, *node->mesh);
+					const auto& skin = scene.skins[gltfNode.skin];
+					ParseSkin(scene, skin, *node->mesh);
 					
 					node->mesh->GetSubmesh(0).flags |= SubmeshFlags::SKINNED;
 					if (node->animController == nullptr)
@@ -173,8 +602,8 @@ namespace JLEngine
 		else if (gltfNode.light >= 0)
 		{
 			node->SetTag(NodeTag::Light);
-			LightGPU light = ParseLight(model, gltfNode.light);
-			light.position = node->translation;
+			LightGPU light = ParseLight(scene, gltfNode.light);
+			light.position = node->GetTranslation();
 			node->light = light;
 		}
 		else
@@ -185,14 +614,13 @@ namespace JLEngine
 		// Recursively parse child nodes
 		for (int childIndex : gltfNode.children)
 		{
-			if (childIndex < 0 || childIndex >= model.nodes.size())
+			if (childIndex < 0 || childIndex >= scene.nodes.size())
 			{
 				std::cerr << "Warning: Invalid child index in node " << node->name << std::endl;
 				continue;
 			}
 
-			const tinygltf::Node& childGltfNode = model.nodes[childIndex];
-			auto childNode = ParseNode(model, childGltfNode, childIndex);
+			auto childNode = ParseNode(scene, childIndex);
 			if (childNode)
 			{
 				node->AddChild(childNode);
@@ -202,33 +630,120 @@ namespace JLEngine
 		return node;
 	}
 
-	std::shared_ptr<Mesh> GLBLoader::ParseMesh(const tinygltf::Model& model, int meshIndex)
+	std::shared_ptr<Mesh> GLBLoader::ParseMesh(const GLBScene& scene, int meshIndex)
 	{
 		// Check if the mesh is already cached
-		auto it = meshCache.find(meshIndex);
-		if (it != meshCache.end())
+		auto it = m_merge->meshCache.find(meshIndex);
+		if (it != m_merge->meshCache.end())
 		{
 			return it->second; 
 		}
 
-		if (meshIndex < 0 || meshIndex >= model.meshes.size())
+		if (meshIndex < 0 || meshIndex >= scene.meshes.size())
 		{
 			std::cerr << "GLBLoader Error: Invalid mesh index " << meshIndex << "." << std::endl;
 			return nullptr;
 		}
 
-		const tinygltf::Mesh& gltfMesh = model.meshes[meshIndex];
+		const GLBMeshDesc& gltfMesh = scene.meshes[meshIndex];
 		
 		// Create a new Mesh object
 		auto mesh = m_resourceLoader->CreateMesh(gltfMesh.name.empty() ? "UnnamedMesh" : gltfMesh.name);
 
-		std::cout << "Mesh name: " << model.meshes[meshIndex].name << std::endl;
+		std::cout << "Mesh name: " << gltfMesh.name << std::endl;
 
 		if (mesh->GetName() == "UnnamedMesh")
 		{
 			std::cout << "Warning: Mesh doesn't have a name. Could lead to duplicates" << std::endl;
 		}
 
+		// prepared by the workers during LoadGLB, or read from the mesh cache
+		if (!gltfMesh.prepared)
+		{
+			std::cerr << "GLBLoader Error: Mesh " << gltfMesh.name << " has no prepared geometry." << std::endl;
+		}
+
+		for (const auto& preparedSubMesh : gltfMesh.submeshes)
+		{
+			// if its got joint attrib we can assume it has skinning vertex data
+			bool skinnedMesh = HasVertexAttribKey(preparedSubMesh.attribKey, AttributeType::JOINT_0);
+			SubMesh submesh;
+			if (skinnedMesh)
+			{
+				submesh = CreateSubMeshAnim(scene, preparedSubMesh);
+			}
+			else
+			{
+				submesh = CreateSubMesh(scene, preparedSubMesh);
+			}
+			mesh->AddSubmesh(submesh);
+
+			// lets the renderer patch this submesh's draw command when the batch is defragmented
+			if (auto vao = GetSubmeshVAO(submesh))
+				vao->GetGeometry().SetOwner(submesh.geometry, mesh.get(), static_cast<uint32_t>(mesh->GetSubmeshes().size() - 1));
+		}
+		m_merge->meshCache[meshIndex] = mesh;
+
+		return mesh;
+	}
+
+	void GLBLoader::PrepareMeshes(GLBImport& import, const tinygltf::Scene& scene, JobSystem& jobs, JobCounter& counter)
+	{
+		const GLBImporter& importer = import.importer;
+		const tinygltf::Model& model = importer.GetModel();
+		import.preparedMeshes.clear();
+
+		std::unordered_set<int> meshes;
+		std::unordered_set<std::string> names;
+		for (int nodeIndex : scene.nodes)
+		{
+			CollectMeshes(model, nodeIndex, meshes, names);
+		}
+
+		// the map is filled before any job starts so the submeshes don't move under the workers
+		for (int meshIndex : meshes)
+		{
+			import.preparedMeshes.emplace(meshIndex, GroupPrimitives(model, meshIndex, import.compactVertices));
+		}
+
+		for (auto& [meshIndex, submeshes] : import.preparedMeshes)
+		{
+			for (auto& submesh : submeshes)
+			{
+				PreparedSubMesh* prepared = &submesh;
+				bool optimize = import.optimizeMeshes;
+				jobs.Submit([this, &importer, prepared, optimize]() { PrepareSubMesh(importer, *prepared, optimize); }, &counter);
+			}
+		}
+	}
+
+	void GLBLoader::CollectMeshes(const tinygltf::Model& model, int nodeIndex, std::unordered_set<int>& meshes, std::unordered_set<std::string>& names)
+	{
+		if (nodeIndex < 0 || nodeIndex >= model.nodes.size())
+			return;
+
+		const auto& gltfNode = model.nodes[nodeIndex];
+		if (gltfNode.mesh >= 0 && gltfNode.mesh < model.meshes.size())
+		{
+			// ParseNode instances meshes by name, only the first mesh with a name gets parsed. Meshes another
+			// file already loaded are still prepared so the mesh cache doesn't depend on the load order
+			auto& meshName = model.meshes[gltfNode.mesh].name;
+			if (meshName.empty() || names.insert(meshName).second)
+			{
+				meshes.insert(gltfNode.mesh);
+			}
+		}
+
+		for (int childIndex : gltfNode.children)
+		{
+			CollectMeshes(model, childIndex, meshes, names);
+		}
+	}
+
+	std::vector<PreparedSubMesh> GLBLoader::GroupPrimitives(const tinygltf::Model& model, int meshIndex, bool compactVertices)
+	{
+		const tinygltf::Mesh& gltfMesh = model.meshes[meshIndex];
+
 		// Group primitives by material and attributes
 		std::unordered_map<MaterialVertexAttributeKey, std::vector<const tinygltf::Primitive*>> groups;
 		for (const auto& primitive : gltfMesh.primitives)
@@ -251,32 +766,59 @@ namespace JLEngine
 			{
 				RemoveFromVertexAttribKey(vertexAttribKey, AttributeType::TEX_COORD_1);
 			}
+			if (compactVertices && !HasVertexAttribKey(vertexAttribKey, AttributeType::JOINT_0))
+			{
+				vertexAttribKey |= CompactVertexFormat;
+			}
 			MaterialVertexAttributeKey key(primitive.material, vertexAttribKey);
 			groups[key].push_back(&primitive);
 		}
-		
-		for (const auto& [key, primitives] : groups)
+
+		std::vector<PreparedSubMesh> submeshes;
+		submeshes.reserve(groups.size());
+		for (auto& [key, primitives] : groups)
 		{
-			// if its got joint attrib we can assume it has skinning vertex data
-			bool skinnedMesh = HasVertexAttribKey(key.attributesKey, AttributeType::JOINT_0);
-			SubMesh submesh;
-			if (skinnedMesh)
-			{
-				submesh = CreateSubMeshAnim(model, primitives, key);
-			}
-			else
-			{
-				submesh = CreateSubMesh(model, primitives, key);
-			}
-			mesh->AddSubmesh(submesh);
+			submeshes.emplace_back(key);
+			submeshes.back().primitives = std::move(primitives);
 		}
+		return submeshes;
+	}
 
-		meshCache[meshIndex] = mesh;
+	void GLBLoader::PrepareSubMesh(const GLBImporter& importer, PreparedSubMesh& prepared, bool optimize)
+	{
+		const tinygltf::Model& model = importer.GetModel();
+		std::vector<float> positions, normals, texCoords, tangents, texCoords2, weights;
+		std::vector<uint16_t> joints;
+		auto key = prepared.key;
 
-		return mesh;
+		uint32_t indexOffset = 0;
+		BatchLoadAttributes(model, prepared.primitives, positions, normals, texCoords, texCoords2, tangents, weights, joints, prepared.indices, indexOffset, key.attributesKey);
+
+		GenerateMissingAttributes(positions, normals, texCoords, tangents, prepared.indices, key.attributesKey);
+
+		// the parsed material is all that's needed for the texture transform, the Material is created in the merge
+		const auto& materials = importer.GetMaterials();
+		if (key.materialIndex >= 0 && key.materialIndex < materials.size())
+		{
+			UpdateUVsFromScaleOffset(texCoords, materials[key.materialIndex].scale, glm::vec2(0.0f));
+		}
+
+		// Interleave vertex data
+		if (HasVertexAttribKey(key.attributesKey, AttributeType::JOINT_0))
+			Geometry::GenerateInterleavedVertexData(positions, normals, texCoords, tangents, weights, joints, prepared.vertexData);
+		else if (IsCompactVertexFormat(key.attributesKey))
+			VertexQuantization::InterleaveCompact(positions, normals, texCoords, texCoords2, tangents, prepared.vertexData);
+		else
+			Geometry::GenerateInterleavedVertexData(positions, normals, texCoords, texCoords2, tangents, prepared.vertexData);
+
+		// only the order changes, the positions and so the bounds stay the same
+		if (optimize)
+			prepared.optimization = MeshOptimizer::Optimize(prepared.vertexData, CalculateStrideInBytes(key.attributesKey), prepared.indices);
+
+		prepared.aabb = CalculateAABB(positions);
 	}
 
-	std::shared_ptr<Animation> GLBLoader::ParseAnimation(int animIdx, const tinygltf::Model& model, const tinygltf::Animation& gltfAnimation)
+	std::shared_ptr<Animation> GLBLoader::ParseAnimation(const GLBImport& import, int animIdx, const tinygltf::Model& model, const tinygltf::Animation& gltfAnimation)
 	{
 		std::string animName;
 		std::string nodeName;
@@ -291,13 +833,8 @@ namespace JLEngine
 		else
 			animName = gltfAnimation.name;
 
-		auto cachedAnim = m_resourceLoader->Get<Animation>(animName);
-		if (cachedAnim != nullptr)
-		{
-			return cachedAnim;
-		}
-
-		auto animation = m_resourceLoader->CreateAnimation(animName);
+		// may run on a worker, PublishAnimations swaps in an already loaded animation of the same name
+		auto animation = std::make_shared<Animation>(animName);
 
 		// Parse samplers
 		for (const auto& sampler : gltfAnimation.samplers)
@@ -306,16 +843,36 @@ namespace JLEngine
 
 			auto inputTimes = GetKeyframeTimes(model, sampler.input);
 			auto outputValues = GetKeyframeValues(model, sampler.output);
+			auto interpolation = sampler.interpolation.empty() ? 
+				InterpolationType::LINEAR : InterpolationFromString(sampler.interpolation);
 
-			if (inputTimes.size() != outputValues.size())
+			if (interpolation == InterpolationType::CUBICSPLINE)
+			{
+				// cubic spline outputs are (in tangent, value, out tangent) per key
+				if (outputValues.size() != inputTimes.size() * 3)
+				{
+					std::cerr << "Cubic spline sampler output size mismatch\n";
+				}
+
+				size_t keyCount = std::min(inputTimes.size(), outputValues.size() / 3);
+				std::vector<glm::vec4> inTangents(keyCount), values(keyCount), outTangents(keyCount);
+				for (size_t i = 0; i < keyCount; ++i)
+				{
+					inTangents[i] = outputValues[i * 3 + 0];
+					values[i] = outputValues[i * 3 + 1];
+					outTangents[i] = outputValues[i * 3 + 2];
+				}
+				outputValues = std::move(values);
+				animSampler.SetTangents(std::move(inTangents), std::move(outTangents));
+			}
+			else if (inputTimes.size() != outputValues.size())
 			{
 				std::cerr << "Sampler input/output size mismatch\n";
 			}
 
 			animSampler.SetTimes(std::move(inputTimes));
 			animSampler.SetValues(std::move(outputValues));
-			animSampler.SetInterpolation(sampler.interpolation.empty() ? 
-				InterpolationType::LINEAR : InterpolationFromString(sampler.interpolation));
+			animSampler.SetInterpolation(interpolation);
 
 			animation->AddSampler(animSampler);
 		}
@@ -336,29 +893,85 @@ namespace JLEngine
 		animation->PrecomputeSamplers();
 		animation->CalcDuration();
 
+		if (import.compressAnimations)
+		{
+			auto stats = AnimationCompressor::Compress(*animation, import.compression);
+			std::cout << "Animation " << animName << ": " << stats.keysBefore << " -> " << stats.keysAfter << " keys, "
+				<< stats.bytesBefore / 1024.0f << " -> " << stats.bytesAfter / 1024.0f << " KB (" << stats.Ratio() << "x), max error "
+				<< glm::degrees(stats.maxRotationError) << " deg / " << stats.maxTranslationError << " / " << stats.maxScaleError << std::endl;
+		}
+
 		return animation;
 	}
 
-	void GLBLoader::ParseSkin(const tinygltf::Model& model, const tinygltf::Skin& skin, Mesh& mesh)
+	void GLBLoader::LoadCachedAnimations(GLBImport& import)
+	{
+		for (auto& cached : import.cookedCache.GetAnimations())
+		{
+			auto animation = std::make_shared<Animation>(cached.name);
+			for (auto interpolation : cached.samplers)
+			{
+				AnimationSampler sampler;
+				sampler.SetInterpolation(interpolation);
+				animation->AddSampler(sampler);
+			}
+
+			for (auto& channel : cached.channels)
+			{
+				AnimationChannel animChannel(channel.samplerIndex, channel.targetNode, channel.path);
+				animChannel.SetNodeName(channel.nodeName);
+				// already mapped to a joint, ParseSkin leaves it alone
+				if (channel.updated)
+					animChannel.UpdateTargetNode(channel.targetNode);
+				animation->AddChannel(animChannel);
+			}
+
+			// the cooked keyframes are the only copy, as they are for a compressed animation
+			animation->SetKeyframes(std::move(cached.keyframes));
+			animation->ReleaseSourceKeys();
+			animation->SetDuration(cached.duration);
+			import.animations.push_back(animation);
+		}
+	}
+
+	uint64_t GLBLoader::SettingsHash() const
+	{
+		// everything that changes what an import produces, FNV-1a like the source hash
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [&hash](const void* data, size_t size)
+			{
+				auto bytes = static_cast<const uint8_t*>(data);
+				for (size_t i = 0; i < size; ++i)
+				{
+					hash ^= bytes[i];
+					hash *= 1099511628211ull;
+				}
+			};
+
+		mix(&Settings.GenerateNormals, sizeof(Settings.GenerateNormals));
+		mix(&Settings.GenerateTangents, sizeof(Settings.GenerateTangents));
+		mix(&Settings.NormalGenType, sizeof(Settings.NormalGenType));
+		mix(&Settings.CompactVertices, sizeof(Settings.CompactVertices));
+		mix(&Settings.OptimizeMeshes, sizeof(Settings.OptimizeMeshes));
+		mix(&CompressAnimations, sizeof(CompressAnimations));
+		mix(&AnimationCompression.rotationTolerance, sizeof(AnimationCompression.rotationTolerance));
+		mix(&AnimationCompression.translationTolerance, sizeof(AnimationCompression.translationTolerance));
+		mix(&AnimationCompression.scaleTolerance, sizeof(AnimationCompression.scaleTolerance));
+		mix(&AnimationCompression.reduceKeys, sizeof(AnimationCompression.reduceKeys));
+		mix(&AnimationCompression.quantize, sizeof(AnimationCompression.quantize));
+		return hash;
+	}
+
+	void GLBLoader::ParseSkin(const GLBScene& scene, const GLBSkinDesc& skin, Mesh& mesh)
 	{
 		auto& inverseBindMatrices = mesh.GetInverseBindMatrices();
 
 		// Load inverse bind matrices
-		if (skin.inverseBindMatrices >= 0)
+		if (!skin.inverseBindMatrices.empty())
 		{
-			const auto& accessor = model.accessors[skin.inverseBindMatrices];
-			const auto& bufferView = model.bufferViews[accessor.bufferView];
-			const auto& buffer = model.buffers[bufferView.buffer];
-
-			const glm::mat4* data = reinterpret_cast<const glm::mat4*>(
-				&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
-			size_t count = accessor.count;
-
 			// Ensure the count matches the number of joints
-			assert(count == skin.joints.size());
-
-			inverseBindMatrices.resize(count);
-			std::copy(data, data + count, inverseBindMatrices.begin());
+			assert(skin.inverseBindMatrices.size() == skin.joints.size());
+			inverseBindMatrices = skin.inverseBindMatrices;
 		}
 
 		// Create skeleton and initialize joints
@@ -368,9 +981,9 @@ namespace JLEngine
 
 		// Precompute parent-child relationships
 		std::unordered_map<int, int> nodeToParent;
-		for (size_t i = 0; i < model.nodes.size(); ++i)
+		for (size_t i = 0; i < scene.nodes.size(); ++i)
 		{
-			const auto& node = model.nodes[i];
+			const auto& node = scene.nodes[i];
 			for (int child : node.children)
 			{
 				nodeToParent[child] = static_cast<int>(i);
@@ -381,7 +994,7 @@ namespace JLEngine
 		for (size_t i = 0; i < skin.joints.size(); ++i)
 		{
 			int jointIndex = skin.joints[i];
-			const auto& jointNode = model.nodes[jointIndex];
+			const auto& jointNode = scene.nodes[jointIndex];
 
 			Skeleton::Joint joint{};
 
@@ -401,21 +1014,9 @@ namespace JLEngine
 			}
 
 			// Compute local transform
-			glm::vec3 translation = jointNode.translation.empty()
-				? glm::vec3(0.0f)
-				: glm::vec3(glm::make_vec3(jointNode.translation.data())); 
-			glm::quat rotation = jointNode.rotation.empty()
-				? glm::quat_identity<float, glm::defaultp>()
-				: glm::quat(static_cast<float>(jointNode.rotation[3]), // w
-					static_cast<float>(jointNode.rotation[0]), // x
-					static_cast<float>(jointNode.rotation[1]), // y
-					static_cast<float>(jointNode.rotation[2])); // z
-			glm::vec3 scale = jointNode.scale.empty()
-				? glm::vec3(1.0f)
-				: glm::vec3(glm::make_vec3(jointNode.scale.data()));
-			glm::mat4 localTransform = glm::translate(glm::mat4(1.0f), translation) *
-				glm::mat4_cast(rotation) *
-				glm::scale(glm::mat4(1.0f), scale);
+			glm::mat4 localTransform = glm::translate(glm::mat4(1.0f), jointNode.translation) *
+				glm::mat4_cast(jointNode.rotation) *
+				glm::scale(glm::mat4(1.0f), jointNode.scale);
 
 			joint.localTransform = localTransform;
 			skeleton.joints[i] = joint;
@@ -505,39 +1106,19 @@ namespace JLEngine
 		return values;
 	}
 
-	SubMesh GLBLoader::CreateSubMesh(const tinygltf::Model& model, 
-		const std::vector<const tinygltf::Primitive*>& primitives, MaterialVertexAttributeKey key)
-	{		
-		std::vector<float> positions, normals, texCoords, tangents, texCoords2, weights;
-		std::vector<uint32_t> indices;
-		std::vector< uint16_t> joints;
-
-		uint32_t indexOffset = 0;
-		BatchLoadAttributes(model, primitives, positions, normals, texCoords, texCoords2, tangents, weights, joints, indices, indexOffset, key.attributesKey);
-
-		GenerateMissingAttributes(positions, normals, texCoords, tangents, indices, key.attributesKey);
-
-		Material* material;
-		if (!model.materials.empty())
-		{
-			if (key.materialIndex < 0)
-			{
-				material = m_resourceLoader->GetDefaultMaterial();
-			}
-			else
-			{
-				material = ParseMaterial(model, model.materials[key.materialIndex], key.materialIndex).get();
-				UpdateUVsFromScaleOffset(texCoords, material->scale, material->offset);
-			}
-		}
-		else
+	Material* GLBLoader::GetSubMeshMaterial(const GLBScene& scene, int materialIndex)
+	{
+		if (scene.materials.empty() || materialIndex < 0)
 		{
-			material = m_resourceLoader->GetDefaultMaterial();
+			return m_resourceLoader->GetDefaultMaterial();
 		}
+		return ParseMaterial(scene, materialIndex).get();
+	}
 
-		// Interleave vertex data
-		std::vector<std::byte> interleavedVertexData;
-		Geometry::GenerateInterleavedVertexData(positions, normals, texCoords, texCoords2, tangents, interleavedVertexData);
+	SubMesh GLBLoader::CreateSubMesh(const GLBScene& scene, const GLBSubMeshView& prepared)
+	{
+		MaterialVertexAttributeKey key(prepared.materialIndex, prepared.attribKey);
+		Material* material = GetSubMeshMaterial(scene, key.materialIndex);
 
 		auto& vao = material->useTransparency ? m_transparentVAOs[key.attributesKey] : m_staticVAOs[key.attributesKey];
 		if (!vao)
@@ -556,31 +1137,26 @@ namespace JLEngine
 			vao->SetVertexAttribKey(key.attributesKey);
 		}
 
-		auto& vbo = vao->GetVBO();
-		auto& vdata = vbo.GetDataMutable();
-		uint32_t vertexOffset = (uint32_t)vdata.size() / (CalculateStrideInBytes(key.attributesKey));
-		vdata.insert(vdata.end(), interleavedVertexData.begin(), interleavedVertexData.end());
-
-		auto& ibo = vao->GetIBO();
-		auto& idata = ibo.GetDataMutable();
-		uint32_t indexBase = (uint32_t)idata.size();
-		idata.insert(idata.end(), indices.begin(), indices.end());
+		// placed by the batch, freed ranges from unloaded meshes are reused before the buffers grow
+		auto geometry = vao->AddGeometry(prepared.vertices, prepared.vertexBytes, prepared.indices, prepared.indexCount);
+		auto& range = vao->GetGeometry().GetRange(geometry);
 
 		SubMesh submesh;
 		submesh.flags |= SubmeshFlags::STATIC;
 		if (material->useTransparency)
 			submesh.flags |= SubmeshFlags::USES_TRANSPARENCY;
-		submesh.aabb = CalculateAABB(positions);
+		submesh.aabb = prepared.aabb;
 		submesh.attribKey = key.attributesKey;
 		submesh.materialHandle = material->GetHandle();
 		submesh.command = 
 		{
-			.count = static_cast<uint32_t>(indices.size()),
+			.count = static_cast<uint32_t>(prepared.indexCount),
 			.instanceCount = 1,
-			.firstIndex = indexBase,
-			.baseVertex = vertexOffset,
+			.firstIndex = range.firstIndex,
+			.baseVertex = range.baseVertex,
 			.baseInstance = 0
 		};
+		submesh.geometry = geometry;
 
 		return submesh;
 	}
@@ -596,263 +1172,118 @@ namespace JLEngine
 		}
 	}
 
-	std::shared_ptr<Material> GLBLoader::ParseMaterial(const tinygltf::Model& model, const tinygltf::Material& gltfMaterial, int matIdx)
+	std::shared_ptr<Material> GLBLoader::ParseMaterial(const GLBScene& scene, int matIdx)
 	{
 		// Check cache
-		auto it = materialCache.find(matIdx);
-		if (it != materialCache.end())
+		auto it = m_merge->materialCache.find(matIdx);
+		if (it != m_merge->materialCache.end())
 		{
 			//std::cout << "Using cached material for index: " << matIdx << std::endl;
 			return it->second;
 		}
 
-		auto material = m_resourceLoader->CreateMaterial(gltfMaterial.name.empty() ? "UnnamedMat" : gltfMaterial.name);
+		// the properties were parsed by GLBImporter on a worker, this creates the resources
+		const GLBMaterialDesc& desc = scene.materials[matIdx];
+		auto material = m_resourceLoader->CreateMaterial(desc.name.empty() ? "UnnamedMat" : desc.name);
+
+		material->baseColorFactor = desc.baseColorFactor;
+		material->metallicFactor = desc.metallicFactor;
+		material->roughnessFactor = desc.roughnessFactor;
+		material->emissiveFactor = desc.emissiveFactor;
+		if (desc.hasEmissiveStrength)
+			material->emissiveStrength = desc.emissiveStrength * EmissionStrengthMultiplier;
+		material->useTransparency = desc.useTransparency;
+		material->transmissionFactor = desc.transmissionFactor;
+		material->thickness = desc.thickness;
+		material->attenuationColor = desc.attenuationColor;
+		material->attenuationDistance = desc.attenuationDistance;
+		material->refractionIndex = desc.refractionIndex;
+		material->scale = desc.scale;
+
+		// Textures, named after the material in the order they were always parsed
 		int texId = 0;
-
-		// Parse base color factor
-		constexpr const char* BASE_COLOR_FACTOR = "baseColorFactor";
-		if (gltfMaterial.values.find(BASE_COLOR_FACTOR) != gltfMaterial.values.end())
-		{
-			const auto& factor = gltfMaterial.values.at(BASE_COLOR_FACTOR).ColorFactor();
-			material->baseColorFactor = glm::vec4(factor[0], factor[1], factor[2], factor[3]);
-			if (material->baseColorFactor.a > 0.0f && material->baseColorFactor.a < 1.0f)
-			{
-				material->useTransparency = true;
-			}
-		}
-		else
-		{
-			material->baseColorFactor = glm::vec4(1.0f);
-		}
-
-		// Parse base color texture
-		constexpr const char* BASE_COLOR_TEXTURE = "baseColorTexture";
-		if (gltfMaterial.values.find(BASE_COLOR_TEXTURE) != gltfMaterial.values.end())
-		{
-			int textureIndex = gltfMaterial.values.at(BASE_COLOR_TEXTURE).TextureIndex();
-			auto texName = gltfMaterial.name + std::to_string(texId++);
-			TexParams params = Texture::EmptyParams();
-			material->baseColorTexture = ParseTexture(model, texName, std::string(BASE_COLOR_TEXTURE), textureIndex, params);
-
-			loadKHRTextureTransform(gltfMaterial, material);
-		}
-
-		// Parse metallic factor
-		constexpr const char* METALLIC_FACTOR = "metallicFactor";
-		if (gltfMaterial.values.find(METALLIC_FACTOR) != gltfMaterial.values.end())
-		{
-			const auto& param = gltfMaterial.values.at(METALLIC_FACTOR);
-			if (param.has_number_value) // Check for valid numeric value
-			{
-				material->metallicFactor = static_cast<float>(param.Factor());
-			}
-		}
-		else
-		{
-			material->metallicFactor = 1.0f;
-		}
-
-		// Parse roughness factor
-		constexpr const char* ROUGHNESS_FACTOR = "roughnessFactor";
-		if (gltfMaterial.values.find(ROUGHNESS_FACTOR) != gltfMaterial.values.end())
-		{
-			const auto& param = gltfMaterial.values.at(ROUGHNESS_FACTOR);
-			if (param.has_number_value)
-			{
-				material->roughnessFactor = static_cast<float>(param.Factor());
-			}
-		}
-		else
-		{
-			material->roughnessFactor = 1.0f;
-		}
-
-		// Parse metallic-roughness texture
-		constexpr const char* METALLIC_ROUGHNESS_TEXTURE = "metallicRoughnessTexture";
-		if (gltfMaterial.values.find(METALLIC_ROUGHNESS_TEXTURE) != gltfMaterial.values.end())
-		{
-			int textureIndex = gltfMaterial.values.at(METALLIC_ROUGHNESS_TEXTURE).TextureIndex();
-			auto texName = gltfMaterial.name + std::to_string(texId++);
-
-			TexParams params = Texture::EmptyParams();
-			material->metallicRoughnessTexture = ParseTexture(model, texName, std::string(METALLIC_ROUGHNESS_TEXTURE), textureIndex, params);
-			//auto& a = material->metallicRoughnessTexture->GetImageData();
-			//std::cout << a.data[0] / 255.0f << std::endl;
-			//std::cout << a.data[1] / 255.0f << std::endl;
-			//std::cout << a.data[2] / 255.0f << std::endl;
-		}
-
-		// Parse normal texture
-		constexpr const char* NORMAL_TEXTURE = "normalTexture";
-		if (gltfMaterial.additionalValues.find(NORMAL_TEXTURE) != gltfMaterial.additionalValues.end())
-		{
-			int textureIndex = gltfMaterial.additionalValues.at(NORMAL_TEXTURE).TextureIndex();
-			auto texName = gltfMaterial.name + std::to_string(texId++);
-			TexParams params = Texture::EmptyParams();
-			material->normalTexture = ParseTexture(model, texName, std::string(NORMAL_TEXTURE), textureIndex, params);
-		}
-
-		// Parse occlusion texture
-		constexpr const char* OCCLUSION_TEXTURE = "occlusionTexture";
-		if (gltfMaterial.additionalValues.find(OCCLUSION_TEXTURE) != gltfMaterial.additionalValues.end())
-		{
-			int textureIndex = gltfMaterial.additionalValues.at(OCCLUSION_TEXTURE).TextureIndex();
-			auto texName = gltfMaterial.name + std::to_string(texId++);
-			TexParams params = Texture::EmptyParams();
-			material->occlusionTexture = ParseTexture(model, texName, std::string(OCCLUSION_TEXTURE), textureIndex, params);
-		}
-
-		// Parse emissive texture
-		constexpr const char* EMISSIVE_TEXTURE = "emissiveTexture";
-		if (gltfMaterial.additionalValues.find(EMISSIVE_TEXTURE) != gltfMaterial.additionalValues.end())
-		{
-			int textureIndex = gltfMaterial.additionalValues.at(EMISSIVE_TEXTURE).TextureIndex();
-			auto texName = gltfMaterial.name + std::to_string(texId++);
-			TexParams params = Texture::EmptyParams();
-			material->emissiveTexture = ParseTexture(model, texName, std::string(EMISSIVE_TEXTURE), textureIndex, params);
-		}
-
-		// Parse emissive factor
-		constexpr const char* EMISSIVE_FACTOR = "emissiveFactor";
-		if (gltfMaterial.additionalValues.find(EMISSIVE_FACTOR) != gltfMaterial.additionalValues.end())
-		{
-			const auto& factor = gltfMaterial.additionalValues.at(EMISSIVE_FACTOR).ColorFactor();
-			material->emissiveFactor = glm::vec3(factor[0], factor[1], factor[2]);
-		}
-		else
-		{
-			material->emissiveFactor = glm::vec3(0.0f);
-		}
-
-		constexpr const char* KHR_materials_emissive_strength = "KHR_materials_emissive_strength";
-		if (gltfMaterial.extensions.find(KHR_materials_emissive_strength) != gltfMaterial.extensions.end())
-		{
-			const tinygltf::Value& emissionStr = gltfMaterial.extensions.at(KHR_materials_emissive_strength);
-			if (emissionStr.Has("emissiveStrength"))
-			{
-				auto emissiveStrength = static_cast<float>(emissionStr.Get("emissiveStrength").GetNumberAsDouble());
-				material->emissiveStrength = emissiveStrength * EmissionStrengthMultiplier;
-			}
-		}
-
-		// Parse KHR_materials_transmission
-		constexpr const char* KHR_MATERIALS_TRANSMISSION = "KHR_materials_transmission";
-		if (gltfMaterial.extensions.find(KHR_MATERIALS_TRANSMISSION) != gltfMaterial.extensions.end())
-		{
-			const tinygltf::Value& transmission = gltfMaterial.extensions.at(KHR_MATERIALS_TRANSMISSION);
-			if (transmission.Has("transmissionFactor") && transmission.Get("transmissionFactor").IsNumber())
-			{
-				material->transmissionFactor = static_cast<float>(transmission.Get("transmissionFactor").GetNumberAsDouble());
-				if (material->transmissionFactor)
-					material->useTransparency = true;
-			}
-			else
-			{
-				material->transmissionFactor = 0.0f; 
-			}
-		}
-		else
-		{
-			material->transmissionFactor = 0.0f; 
-		}
-
-		// Parse KHR_materials_volume
-		constexpr const char* KHR_MATERIALS_VOLUME = "KHR_materials_volume";
-		if (gltfMaterial.extensions.find(KHR_MATERIALS_VOLUME) != gltfMaterial.extensions.end())
-		{
-			const tinygltf::Value& volume = gltfMaterial.extensions.at(KHR_MATERIALS_VOLUME);
-
-			if (volume.Has("thicknessFactor") && volume.Get("thicknessFactor").IsNumber())
-			{
-				material->thickness = static_cast<float>(volume.Get("thicknessFactor").GetNumberAsDouble());
-			}
-			else
-			{
-				material->thickness = 0.0f; 
-			}
-
-			// Attenuation color
-			if (volume.Has("attenuationColor") && volume.Get("attenuationColor").IsArray())
-			{
-				const auto& colorArray = volume.Get("attenuationColor");
-				material->attenuationColor = glm::vec3(
-					static_cast<float>(colorArray.Get(0).GetNumberAsDouble()),
-					static_cast<float>(colorArray.Get(1).GetNumberAsDouble()),
-					static_cast<float>(colorArray.Get(2).GetNumberAsDouble())
-				);
-			}
-			else
-			{
-				material->attenuationColor = glm::vec3(1.0f); 
-			}
-
-			// Attenuation distance
-			if (volume.Has("attenuationDistance") && volume.Get("attenuationDistance").IsNumber())
-			{
-				material->attenuationDistance = static_cast<float>(volume.Get("attenuationDistance").GetNumberAsDouble());
-			}
-			else
-			{
-				material->attenuationDistance = std::numeric_limits<float>::max(); 
-			}
-		}
-		else
-		{
-			material->thickness = 0.0f;
-			material->attenuationColor = glm::vec3(1.0f);
-			material->attenuationDistance = std::numeric_limits<float>::max();
-		}
-
-		// Refraction Index (KHR_materials_ior)
-		constexpr const char* KHR_MATERIALS_IOR = "KHR_materials_ior";
-		if (gltfMaterial.extensions.find(KHR_MATERIALS_IOR) != gltfMaterial.extensions.end())
-		{
-			const tinygltf::Value& ior = gltfMaterial.extensions.at(KHR_MATERIALS_IOR);
-			if (ior.Has("ior") && ior.Get("ior").IsNumber())
-			{
-				material->refractionIndex = static_cast<float>(ior.Get("ior").GetNumberAsDouble());
-			}
-			else
-			{
-				material->refractionIndex = 1.5f; // Default IOR for glass
-			}
-		}
-		else
-		{
-			material->refractionIndex = 1.5f; // Default IOR for glass
-		}
+		auto parseTexture = [&](int textureIndex, const char* slot)
+			{
+				auto texName = desc.name + std::to_string(texId++);
+				TexParams params = Texture::EmptyParams();
+				// for textures whose mips are built at upload
+				params.normalMap = std::string(slot) == "normalTexture";
+				if (std::string(slot) == "baseColorTexture" && desc.alphaMode == "MASK")
+					params.alphaCutoff = desc.alphaCutoff;
+				return ParseTexture(scene, texName, std::string(slot), textureIndex, params);
+			};
+
+		if (desc.baseColorTexture >= 0)
+			material->baseColorTexture = parseTexture(desc.baseColorTexture, "baseColorTexture");
+		if (desc.metallicRoughnessTexture >= 0)
+			material->metallicRoughnessTexture = parseTexture(desc.metallicRoughnessTexture, "metallicRoughnessTexture");
+		if (desc.normalTexture >= 0)
+			material->normalTexture = parseTexture(desc.normalTexture, "normalTexture");
+		if (desc.occlusionTexture >= 0)
+			material->occlusionTexture = parseTexture(desc.occlusionTexture, "occlusionTexture");
+		if (desc.emissiveTexture >= 0)
+			material->emissiveTexture = parseTexture(desc.emissiveTexture, "emissiveTexture");
 
 		// Alpha properties
-		material->alphaMode = AlphaModeFromString(gltfMaterial.alphaMode);
-		material->alphaCutoff = static_cast<float>(gltfMaterial.alphaCutoff);
-		material->doubleSided = gltfMaterial.doubleSided;
+		material->alphaMode = AlphaModeFromString(desc.alphaMode);
+		material->alphaCutoff = desc.alphaCutoff;
+		material->doubleSided = desc.doubleSided;
 
 		// Cache the material
-		materialCache[matIdx] = material;
+		m_merge->materialCache[matIdx] = material;
 
 		return material;
 	}
 
-	std::shared_ptr<Texture> GLBLoader::ParseTexture(const tinygltf::Model& model, std::string& matName, const std::string& name, int textureIndex, TexParams overwriteParams)
+	std::shared_ptr<Texture> GLBLoader::ParseTexture(const GLBScene& scene, std::string& matName, const std::string& name, int textureIndex, TexParams overwriteParams)
 	{
 		// Check if the texture index is valid
-		if (textureIndex < 0 || textureIndex >= model.textures.size())
+		if (textureIndex < 0 || textureIndex >= scene.textureImages.size())
 			return nullptr;
 
 		// Check the cache for an existing texture
-		auto it = textureCache.find(textureIndex);
-		if (it != textureCache.end())
+		auto it = m_merge->textureCache.find(textureIndex);
+		if (it != m_merge->textureCache.end())
 		{
 			return it->second; // Return the cached texture
 		}
 
 		// Fetch the texture and its image data
-		const auto& texture = model.textures[textureIndex];
-		const auto& glbImageData = model.images[texture.source];
+		int source = scene.textureImages[textureIndex];
+		if (source < 0 || source >= scene.images.size())
+			return nullptr;
+		const auto& glbImageData = scene.images[source];
 
 		// Generate a final name for the texture
 		const std::string& finalName = matName + "_" + name;
 
+		// a cooked copy for this slot replaces the decoded image
+		auto cooked = m_merge->cookedTextures.find(textureIndex);
+		if (cooked != m_merge->cookedTextures.end() && cooked->second->cache.GetImage().mapped != nullptr &&
+			name == SlotName(cooked->second->usage))
+		{
+			auto params = Texture::OverwriteParams(Texture::DefaultParams(4, false), overwriteParams);
+			auto jltexture = StreamTextures && m_resourceLoader->GetTextureStreamer()->Enabled
+				? m_resourceLoader->CreateTexture(finalName, TextureStreamSource{ cooked->second->cachePath, cooked->second->cacheHash }, params)
+				: m_resourceLoader->CreateTexture(finalName, cooked->second->cache.GetImage(), params);
+			m_merge->textureCache[textureIndex] = jltexture;
+			return jltexture;
+		}
+
+		// so does a prebuilt mip chain
+		auto mipmapped = m_merge->mipmappedTextures.find(textureIndex);
+		if (mipmapped != m_merge->mipmappedTextures.end() && mipmapped->second->GetImage() != nullptr &&
+			name == SlotName(mipmapped->second->usage))
+		{
+			auto params = Texture::OverwriteParams(Texture::DefaultParams(glbImageData.component, false), overwriteParams);
+			bool stream = StreamTextures && m_resourceLoader->GetTextureStreamer()->Enabled && !mipmapped->second->cachePath.empty();
+			auto jltexture = stream
+				? m_resourceLoader->CreateTexture(finalName, TextureStreamSource{ mipmapped->second->cachePath }, params)
+				: m_resourceLoader->CreateTexture(finalName, *mipmapped->second->GetImage(), params);
+			m_merge->textureCache[textureIndex] = jltexture;
+			return jltexture;
+		}
+
 		// Extract texture details
 		uint32_t width = static_cast<uint32_t>(glbImageData.width);
 		uint32_t height = static_cast<uint32_t>(glbImageData.height);
@@ -861,7 +1292,7 @@ namespace JLEngine
 		imgData.width = width;
 		imgData.height = height;
 		imgData.channels = channels;
-		imgData.data = glbImageData.image;
+		imgData.data.assign(glbImageData.pixels, glbImageData.pixels + glbImageData.size);
 
 		auto params = Texture::DefaultParams(imgData.channels, false);
 		auto newParams = Texture::OverwriteParams(params, overwriteParams);
@@ -886,125 +1317,15 @@ namespace JLEngine
 		auto jltexture = m_resourceLoader->CreateTexture(finalName, imgData, newParams);
 
 		// Cache the newly created texture
-		textureCache[textureIndex] = jltexture;
+		m_merge->textureCache[textureIndex] = jltexture;
 
 		return jltexture;
 	}
 
-	void GLBLoader::ParseTransform(std::shared_ptr<Node> node, const tinygltf::Node& gltfNode)
-	{
-		if (!gltfNode.matrix.empty() && gltfNode.matrix.size() == 16)
-		{
-			// Load the matrix directly
-			glm::mat4 matrix(1.0f);
-			for (int i = 0; i < 16; ++i) {
-				matrix[i / 4][i % 4] = static_cast<float>(gltfNode.matrix[i]);
-			}
-			node->localMatrix = matrix;
-
-			// Decompose the matrix into T/R/S
-			glm::vec3 skew;
-			glm::vec4 perspective;
-			if (!glm::decompose(matrix, node->scale, node->rotation, node->translation, skew, perspective))
-			{
-				std::cerr << "Error: Failed to decompose matrix in GLTF node." << std::endl;
-				node->translation = glm::vec3(0.0f);
-				node->rotation = glm::quat_identity<float, glm::defaultp>();
-				node->scale = glm::vec3(1.0f);
-			}
-			return;
-		}
-
-		// Load T/R/S components and compose the matrix
-		node->translation = glm::vec3(0.0f);
-		node->rotation = glm::quat_identity<float, glm::defaultp>();
-		node->scale = glm::vec3(1.0f);
-
-		// Parse translation
-		if (!gltfNode.translation.empty() && gltfNode.translation.size() == 3)
-		{
-			node->translation = glm::vec3(
-				gltfNode.translation[0],
-				gltfNode.translation[1],
-				gltfNode.translation[2]);
-		}
-
-		// Parse rotation (GLTF quaternion format: x, y, z, w)
-		if (!gltfNode.rotation.empty() && gltfNode.rotation.size() == 4)
-		{
-			node->rotation = glm::quat(
-				static_cast<float>(gltfNode.rotation[3]), // w
-				static_cast<float>(gltfNode.rotation[0]), // x
-				static_cast<float>(gltfNode.rotation[1]), // y
-				static_cast<float>(gltfNode.rotation[2])); // z
-		}
-
-		// Parse scale
-		if (!gltfNode.scale.empty() && gltfNode.scale.size() == 3)
-		{
-			node->scale = glm::vec3(
-				gltfNode.scale[0],
-				gltfNode.scale[1],
-				gltfNode.scale[2]);
-		}
-
-		// Compose the matrix from T/R/S
-		node->localMatrix = glm::translate(glm::mat4(1.0f), node->translation) *
-			glm::mat4_cast(node->rotation) *
-			glm::scale(glm::mat4(1.0f), node->scale);
-	}
-
-	void GLBLoader::loadKHRTextureTransform(const tinygltf::Material& gltfMaterial, std::shared_ptr<Material> material)
-	{
-		auto& extensions = gltfMaterial.pbrMetallicRoughness.baseColorTexture.extensions;
-
-		if (extensions.find("KHR_texture_transform") != extensions.end())
-		{
-			const tinygltf::Value& transform = extensions.at("KHR_texture_transform");
-
-			if (transform.Has("scale") && transform.Get("scale").IsArray())
-			{
-				const auto& scaleArray = transform.Get("scale");
-				bool isArray = scaleArray.IsArray();
-				auto valX = static_cast<float>(scaleArray.Get(0).GetNumberAsDouble());
-				auto valY = static_cast<float>(scaleArray.Get(1).GetNumberAsDouble());
-				material->scale = glm::vec2(valX, valY);
-			}
-		}
-	}
-
-	SubMesh GLBLoader::CreateSubMeshAnim(const tinygltf::Model& model, const std::vector<const tinygltf::Primitive*>& primitives, MaterialVertexAttributeKey key)
+	SubMesh GLBLoader::CreateSubMeshAnim(const GLBScene& scene, const GLBSubMeshView& prepared)
 	{
-		std::vector<float> positions, normals, texCoords, tangents, texCoords2, weights;
-		std::vector<uint32_t> indices;
-		std::vector< uint16_t> joints;
-		
-		uint32_t indexOffset = 0;
-		BatchLoadAttributes(model, primitives, positions, normals, texCoords, texCoords2, tangents, weights, joints, indices, indexOffset, key.attributesKey);
-
-		GenerateMissingAttributes(positions, normals, texCoords, tangents, indices, key.attributesKey);
-
-		Material* material;
-		if (!model.materials.empty())
-		{
-			if (key.materialIndex < 0)
-			{
-				material = m_resourceLoader->GetDefaultMaterial();
-			}
-			else
-			{
-				material = ParseMaterial(model, model.materials[key.materialIndex], key.materialIndex).get();
-				UpdateUVsFromScaleOffset(texCoords, material->scale, material->offset);
-			}
-		}
-		else
-		{
-			material = m_resourceLoader->GetDefaultMaterial();
-		}
-
-		// Interleave vertex data
-		std::vector<std::byte> interleavedVertexData;
-		Geometry::GenerateInterleavedVertexData(positions, normals, texCoords, tangents, weights, joints, interleavedVertexData);
+		MaterialVertexAttributeKey key(prepared.materialIndex, prepared.attribKey);
+		Material* material = GetSubMeshMaterial(scene, key.materialIndex);
 
 		auto& vao = m_skinnedMeshVAOs[key.attributesKey];
 		if (!vao)
@@ -1014,29 +1335,24 @@ namespace JLEngine
 			vao->SetVertexAttribKey(key.attributesKey);
 		}
 
-		auto& vbo = vao->GetVBO();
-		auto& vdata = vbo.GetDataMutable();
-		uint32_t vertexOffset = (uint32_t)vdata.size() / (CalculateStrideInBytes(key.attributesKey));
-		vdata.insert(vdata.end(), interleavedVertexData.begin(), interleavedVertexData.end());
-
-		auto& ibo = vao->GetIBO();
-		auto& idata = ibo.GetDataMutable();
-		uint32_t indexBase = (uint32_t)idata.size();
-		idata.insert(idata.end(), indices.begin(), indices.end());
+		// placed by the batch, freed ranges from unloaded meshes are reused before the buffers grow
+		auto geometry = vao->AddGeometry(prepared.vertices, prepared.vertexBytes, prepared.indices, prepared.indexCount);
+		auto& range = vao->GetGeometry().GetRange(geometry);
 
 		SubMesh submesh;		
 		submesh.flags |= SubmeshFlags::ANIMATED;
-		submesh.aabb = CalculateAABB(positions);
+		submesh.aabb = prepared.aabb;
 		submesh.attribKey = key.attributesKey;
 		submesh.materialHandle = material->GetHandle();
 		submesh.command = 
 		{
-			.count = static_cast<uint32_t>(indices.size()),
+			.count = static_cast<uint32_t>(prepared.indexCount),
 			.instanceCount = 1,
-			.firstIndex = indexBase,
-			.baseVertex = vertexOffset,
+			.firstIndex = range.firstIndex,
+			.baseVertex = range.baseVertex,
 			.baseInstance = 0
 		};
+		submesh.geometry = geometry;
 
 		return submesh;
 	}
@@ -1227,7 +1543,7 @@ namespace JLEngine
 		return animations;
 	}
 
-	bool GLBLoader::AssociateAnimationWithNode(const tinygltf::Model& model, int nodeIndex, Node* node)
+	bool GLBLoader::AssociateAnimationWithNode(int nodeIndex, Node* node)
 	{
 		bool associationFound = false;
 		auto& resources = m_resourceLoader->GetAnimationManager()->GetResources();
@@ -1239,7 +1555,7 @@ namespace JLEngine
 			{
 				associationFound = true;
 				node->IsAnimated = true;
-				auto& node = nodeMapping[nodeIndex];
+				auto& node = m_merge->nodeMapping[nodeIndex];
 				auto& animController = node->animController;
 
 				if (animController == nullptr)
@@ -1321,7 +1637,7 @@ namespace JLEngine
 		}
 	}
 
-	LightGPU GLBLoader::ParseLight(const tinygltf::Model& model, int lightIndex)
+	LightGPU GLBLoader::ParseLight(const GLBScene& scene, int lightIndex)
 	{
 		LightGPU gpuLight = {}; 
 
@@ -1333,14 +1649,14 @@ namespace JLEngine
 		gpuLight.spotAngleOuter = glm::cos(glm::radians(45.0f)); 
 		gpuLight.spotAngleInner = glm::cos(glm::radians(22.5f));
 
-		if (model.extensions.find("KHR_lights_punctual") == model.extensions.end()) 
+		if (!scene.hasLights) 
 		{
 			std::cerr << "KHR_lights_punctual extension not found in model.\n" << std::endl;
 			gpuLight.enabled = 0; // Disable if not found
 			return gpuLight;
 		}
 
-		const auto& lightValue = model.lights[lightIndex];
+		const auto& lightValue = scene.lights[lightIndex];
 		string lightType = lightValue.type;
 
 		std::transform(lightType.begin(), lightType.end(), lightType.begin(),
@@ -1350,12 +1666,11 @@ namespace JLEngine
 		else
 			gpuLight.type = (int32_t)LightType::Spot;
 
-		gpuLight.intensity = static_cast<float>(lightValue.intensity) * 0.25f;
-		gpuLight.spotAngleInner = static_cast<float>(glm::cos(lightValue.spot.innerConeAngle));
-		gpuLight.spotAngleOuter = static_cast<float>(glm::cos(lightValue.spot.outerConeAngle));
-		gpuLight.radius = static_cast<float>(lightValue.range);
-		auto& col = lightValue.color;
-		gpuLight.color = glm::vec3(col[0], col[1], col[2]);
+		gpuLight.intensity = lightValue.intensity * 0.25f;
+		gpuLight.spotAngleInner = glm::cos(lightValue.innerConeAngle);
+		gpuLight.spotAngleOuter = glm::cos(lightValue.outerConeAngle);
+		gpuLight.radius = lightValue.range;
+		gpuLight.color = lightValue.color;
 		gpuLight.direction = glm::vec3(1.0f, 0.0f, 0.0f);
 		gpuLight.enabled = 1;
 		gpuLight.castsShadows = 0;
@@ -1602,12 +1917,25 @@ namespace JLEngine
 		return false;
 	}	
 
-	void GLBLoader::ClearCaches()
+	VertexArrayObject* GLBLoader::GetSubmeshVAO(const SubMesh& submesh)
 	{
-		nodeMapping.clear();
-		meshCache.clear();
-		materialCache.clear();
-		textureCache.clear();
-		meshNodeReferences.clear();
+		auto& vaos = HasVertexAttribKey(submesh.attribKey, AttributeType::JOINT_0) ? m_skinnedMeshVAOs :
+			(submesh.flags & SubmeshFlags::USES_TRANSPARENCY) != 0 ? m_transparentVAOs : m_staticVAOs;
+
+		auto it = vaos.find(submesh.attribKey);
+		return it != vaos.end() ? it->second.get() : nullptr;
+	}
+
+	void GLBLoader::ReleaseMeshGeometry(Mesh& mesh)
+	{
+		for (auto& submesh : mesh.GetSubmeshes())
+		{
+			auto vao = GetSubmeshVAO(submesh);
+			if (vao == nullptr || submesh.geometry == InvalidGeometry) continue;
+
+			vao->RemoveGeometry(submesh.geometry);
+			submesh.geometry = InvalidGeometry;
+			submesh.command.count = 0;
+		}
 	}
 }
\ No newline at end of file
@@ -7,10 +7,17 @@
 #include <iostream>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "VertexBuffers.h"
 #include "Mesh.h"
 #include "AnimData.h"
+#include "AnimationCompressor.h"
+#include "GLBImporter.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "TextureCache.h"
+#include "KTX2File.h"
 
 namespace JLEngine
 {
@@ -22,6 +29,27 @@ namespace JLEngine
 	class Mesh;
 	class Graphics;
 	class ResourceLoader;
+	class JobSystem;
+	struct JobCounter;
+	class Animation;
+
+	enum class NormalGen
+	{
+		Smooth,
+		Flat
+	};
+
+	struct AssetGenerationSettings
+	{
+		bool GenerateNormals = true; // if missing generate normals
+		bool GenerateTangents = true; // if missing generate tangents
+		NormalGen NormalGenType = NormalGen::Smooth; // type of normals to generate
+		// static meshes get octahedral normals and tangents and half float uvs, 24 bytes a vertex
+		// instead of 48. Skinned meshes stay float, the pre-skinning pass reads them as floats
+		bool CompactVertices = false;
+		// merge duplicate vertices and reorder each submesh for the vertex cache, overdraw and fetch
+		bool OptimizeMeshes = true;
+	};
 
 	struct MaterialVertexAttributeKey
 	{
@@ -38,6 +66,114 @@ namespace JLEngine
 		}
 	};
 
+	// One submesh worth of primitives, loaded, completed and interleaved on a worker. GLBLoader
+	// only has to add it to a batched VAO
+	struct PreparedSubMesh
+	{
+		PreparedSubMesh(MaterialVertexAttributeKey key) : key(key) {}
+
+		MaterialVertexAttributeKey key;
+		std::vector<const tinygltf::Primitive*> primitives;
+		std::vector<std::byte> vertexData;
+		std::vector<uint32_t> indices;
+		AABB aabb{};
+		MeshOptimizationStats optimization;
+
+		GLBSubMeshView View() const
+		{
+			return { key.materialIndex, key.attributesKey, aabb, vertexData.data(), vertexData.size(), indices.data(), indices.size() };
+		}
+	};
+
+	// A glTF texture cooked for the first material slot that uses it, other slots upload the
+	// decoded image as before
+	struct CookedTexture
+	{
+		TextureUsage usage = TextureUsage::BaseColor;
+		int image = -1;
+		float alphaCutoff = -1.0f;	// the MASK cutoff of the material, for base color
+		TextureCache cache;
+		std::string cachePath;		// what the texture streams from
+		uint64_t cacheHash = 0;
+	};
+
+	// The mip chain of a glTF texture that isn't cooked, built on a worker so the upload does no
+	// filtering. Cached as KTX2 next to the mesh cache when there is one
+	struct MipmappedTexture
+	{
+		TextureUsage usage = TextureUsage::BaseColor;
+		int image = -1;
+		MipSettings settings;
+		KTX2File file;							// on a cache hit
+		std::shared_ptr<KTX2Image> generated;	// built by this load, shared by the slots with the same image and settings
+		std::string cachePath;					// set once the chain is on disk, what the texture streams from
+
+		const KTX2Image* GetImage() const
+		{
+			if (generated) return generated.get();
+			return file.GetImage().mapped != nullptr ? &file.GetImage() : nullptr;
+		}
+	};
+
+	// One GLB file on its way into the scene. GLBLoader::Import fills it without touching the
+	// resource managers or GL so it can run on a worker, MergeStep then builds the resources and
+	// nodes on the render thread a piece at a time. The per file caches live here so several files
+	// can be part way through at once
+	struct GLBImport
+	{
+		enum class Stage
+		{
+			Import,
+			Animations,
+			Materials,
+			Meshes,
+			Nodes,
+			Done,
+			Failed
+		};
+
+		std::string fileName;
+		Stage stage = Stage::Import;
+
+		// the loader's settings when the load was created, a worker never reads the loader's own
+		bool compressAnimations = true;
+		KeyframeCompressionSettings compression;
+		uint64_t settingsHash = 0;
+		bool compactVertices = false;
+		bool optimizeMeshes = true;
+		bool compressTextures = false;
+		TextureCookSettings textureCompression;
+		bool mipmapTextures = true;
+		std::string cacheFolder;
+
+		// --- IMPORT --- //
+		uint64_t cacheHash = 0;
+		std::string cachePath;
+		bool cacheHit = false;
+		MeshCache cookedCache;	// open on a cache hit, the scene points into it
+		// keyed by glTF texture index, mapped until the import is released
+		std::unordered_map<int, std::unique_ptr<CookedTexture>> cookedTextures;
+		std::unordered_map<int, std::unique_ptr<MipmappedTexture>> mipmappedTextures;
+		GLBImporter importer;
+		// submeshes prepared by the workers keyed by glTF mesh index
+		std::unordered_map<int, std::vector<PreparedSubMesh>> preparedMeshes;
+		// not in the animation manager yet, the merge adds them
+		std::vector<std::shared_ptr<Animation>> animations;
+		// the importer's scene or the mesh cache's
+		GLBScene* scene = nullptr;
+
+		// --- MERGE --- //
+		std::vector<int> mergeItems;	// material or mesh indices left for the current stage
+		size_t mergeCursor = 0;
+		std::unordered_map<int, std::shared_ptr<Node>> nodeMapping; // maps the gltf nodeIndex to my JLEngine::Node
+		std::unordered_map<int, std::shared_ptr<Mesh>> meshCache;
+		std::unordered_map<int, std::shared_ptr<Material>> materialCache;
+		std::unordered_map<int, std::shared_ptr<Texture>> textureCache;
+		// copies of the merged animations for WriteCache, filled when the file wasn't a cache hit
+		std::vector<MeshCacheAnimation> cacheAnimations;
+		std::shared_ptr<Node> root;
+	};
+
 	class GLBLoader
 	{
 	public:
@@ -45,27 +181,74 @@ namespace JLEngine
 
 		std::shared_ptr<Node> LoadGLB(const std::string& fileName);
 
+		// --- STREAMED LOADS --- //
+		// LoadGLB in parts so AssetStreamer can spread it out. CreateImport takes the settings on the
+		// render thread, Import is the worker half and MergeStep the render thread half
+		std::shared_ptr<GLBImport> CreateImport(const std::string& fileName) const;
+		bool Import(GLBImport& import, JobSystem& jobs);
+		// Publishes the animations, or creates one material, or one mesh's geometry, or the node tree.
+		// True once import.root is built or the import failed
+		bool MergeStep(GLBImport& import);
+		// Cooks a merged import into its mesh cache, only reads the import so it can run on a worker
+		static bool WriteCache(const GLBImport& import);
+
 		std::unordered_map<VertexAttribKey, std::shared_ptr<VertexArrayObject>>& GetStaticVAOs() { return m_staticVAOs; }
 		std::unordered_map<VertexAttribKey, std::shared_ptr<VertexArrayObject>>& GetDynamicVAOs() { return m_skinnedMeshVAOs; }
 		std::unordered_map<VertexAttribKey, std::shared_ptr<VertexArrayObject>>& GetTransparentVAOs() { return m_transparentVAOs; }
 	
-		void ClearCaches();
+		// Frees the submeshes' ranges in their batched VAOs so streamed in props can reuse the space.
+		// The mesh must already be out of the scene, its draw commands are left empty
+		void ReleaseMeshGeometry(Mesh& mesh);
+		VertexArrayObject* GetSubmeshVAO(const SubMesh& submesh);
 
 		float EmissionStrengthMultiplier = 0.25f;
 
+		// Animations are key reduced and quantized as they load, see AnimationCompressor
+		bool CompressAnimations = true;
+		KeyframeCompressionSettings AnimationCompression;
+
+		// Cooked imports are written here and loaded instead of the GLB while it and the settings
+		// are unchanged, see MeshCache. Empty turns the cache off
+		std::string CacheFolder;
+		AssetGenerationSettings Settings;
+		// Material textures are block compressed with their mips on import and kept next to the
+		// mesh cache, so this needs CacheFolder. See TextureCooker
+		bool CompressTextures = false;
+		TextureCookSettings TextureCompression;
+		// Material textures that aren't compressed get their mips from MipGenerator on the import
+		// workers, kept next to the mesh cache when CacheFolder is set
+		bool MipmapTextures = true;
+		// Textures with a cache file (cooked, or mips written by the above) start at their low mips and
+		// are streamed in by the TextureStreamer as they are drawn closer
+		bool StreamTextures = true;
+
 	protected:
-		std::shared_ptr<Node> ParseNode(const tinygltf::Model& model, const tinygltf::Node& gltfNode, int nodeIndex);
-		std::shared_ptr<Mesh> ParseMesh(const tinygltf::Model& model, int meshIndex);
-		std::shared_ptr<Animation> ParseAnimation(int animIdx, const tinygltf::Model& model, const tinygltf::Animation& gltfAnimation);
-		void ParseSkin(const tinygltf::Model& model, const tinygltf::Skin& skin, Mesh& mesh);
+		// Builds the node tree, the same for a parsed GLB and a mesh cache hit
+		std::shared_ptr<Node> MergeScene(const GLBScene& scene);
+		void PublishAnimations(GLBImport& import);
+		void CollectMergeItems(GLBImport& import, std::vector<int>& materials, std::vector<int>& meshes);
+		std::shared_ptr<Node> ParseNode(const GLBScene& scene, int nodeIndex);
+		std::shared_ptr<Mesh> ParseMesh(const GLBScene& scene, int meshIndex);
+		// Queues a job for every submesh of the meshes the scene will parse, ParseMesh picks them up
+		void PrepareMeshes(GLBImport& import, const tinygltf::Scene& scene, JobSystem& jobs, JobCounter& counter);
+		void CollectMeshes(const tinygltf::Model& model, int nodeIndex, std::unordered_set<int>& meshes, std::unordered_set<std::string>& names);
+		std::vector<PreparedSubMesh> GroupPrimitives(const tinygltf::Model& model, int meshIndex, bool compactVertices);
+		void PrepareSubMesh(const GLBImporter& importer, PreparedSubMesh& prepared, bool optimize);
+		std::shared_ptr<Animation> ParseAnimation(const GLBImport& import, int animIdx, const tinygltf::Model& model, const tinygltf::Animation& gltfAnimation);
+		void LoadCachedAnimations(GLBImport& import);
+		// Opens or cooks the compressed copy of every material texture once import.scene is set
+		void CookTextures(GLBImport& import, JobSystem& jobs);
+		// Opens or builds the mip chains of the material textures CookTextures didn't take
+		void GenerateTextureMips(GLBImport& import, JobSystem& jobs);
+		uint64_t SettingsHash() const;
+		void ParseSkin(const GLBScene& scene, const GLBSkinDesc& skin, Mesh& mesh);
 		std::vector<float> GetKeyframeTimes(const tinygltf::Model& model, int accessorIndex);
 		std::vector<glm::vec4> GetKeyframeValues(const tinygltf::Model& model, int accessorIndex);
-		std::shared_ptr<Material> ParseMaterial(const tinygltf::Model& model, const tinygltf::Material& gltfMaterial, int matIdx);
-		std::shared_ptr<Texture> ParseTexture(const tinygltf::Model& model, std::string& matName, const std::string& texName, int textureIndex, TexParams overwriteParams);
-		void ParseTransform(std::shared_ptr<Node> node, const tinygltf::Node& gltfNode);
-		void loadKHRTextureTransform(const tinygltf::Material& gltfMaterial, std::shared_ptr<Material> material);
-		SubMesh CreateSubMeshAnim(const tinygltf::Model& model, const std::vector<const tinygltf::Primitive*>& primitives, MaterialVertexAttributeKey key);
-		SubMesh CreateSubMesh(const tinygltf::Model& model, const std::vector<const tinygltf::Primitive*>& primitives, MaterialVertexAttributeKey key);
+		std::shared_ptr<Material> ParseMaterial(const GLBScene& scene, int matIdx);
+		std::shared_ptr<Texture> ParseTexture(const GLBScene& scene, std::string& matName, const std::string& texName, int textureIndex, TexParams overwriteParams);
+		SubMesh CreateSubMeshAnim(const GLBScene& scene, const GLBSubMeshView& prepared);
+		SubMesh CreateSubMesh(const GLBScene& scene, const GLBSubMeshView& prepared);
+		Material* GetSubMeshMaterial(const GLBScene& scene, int materialIndex);
 		void UpdateUVsFromScaleOffset(std::vector<float>& uvs, glm::vec2 scale, glm::vec2 offset);
 		bool LoadIndices(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<unsigned int>& indices);
 		bool LoadTangentAttribute(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<float>& tangentData);
@@ -75,7 +258,7 @@ namespace JLEngine
 		void LoadPositionAttribute(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<float>& vertexData);
 		void LoadWeightAttribute(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<float>& weights);
 		void LoadJointAttribute(const tinygltf::Model& model, const tinygltf::Primitive& primitive, std::vector<uint16_t>& joints);
-		LightGPU ParseLight(const tinygltf::Model& model, int lightIndex);
+		LightGPU ParseLight(const GLBScene& scene, int lightIndex);
 		void GenerateMissingAttributes(std::vector<float>& positions, 
 			std::vector<float>& normals, 
 			std::vector<float>& texCoords, 
@@ -104,15 +287,12 @@ namespace JLEngine
 		glm::vec4 GetVec4FromValue(const tinygltf::Value& value, const glm::vec4& defaultValue);
 		glm::vec3 GetVec3FromValue(const tinygltf::Value& value, const glm::vec3& defaultValue);
 		std::vector<Animation*> GetAnimationsFromSkeleton(int gltfSkeletonRoot);
-		bool AssociateAnimationWithNode(const tinygltf::Model& model, int nodeIndex, Node* node);
+		bool AssociateAnimationWithNode(int nodeIndex, Node* node);
 
 	private:
 
-		std::unordered_map<int, std::shared_ptr<Node>> nodeMapping; // maps the gltf nodeIndex to my JLEngine::Node
-		std::unordered_map<int, std::shared_ptr<Mesh>> meshCache;
-		std::unordered_map<int, std::shared_ptr<Material>> materialCache;
-		std::unordered_map<int, std::shared_ptr<Texture>> textureCache;
-		std::unordered_map<int, std::vector<std::shared_ptr<Node>>> meshNodeReferences;
+		// the import MergeStep is working on, the Parse functions cache into it
+		GLBImport* m_merge = nullptr;
 
 		std::unordered_map<VertexAttribKey, std::shared_ptr<VertexArrayObject>> m_staticVAOs;
 		std::unordered_map<VertexAttribKey, std::shared_ptr<VertexArrayObject>> m_skinnedMeshVAOs;
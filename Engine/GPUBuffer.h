@@ -33,6 +33,11 @@ namespace JLEngine
 
 		GLbitfield GetUsageFlags() const { return m_usageFlags; }
 
+		// Set for buffers created with GL_MAP_PERSISTENT_BIT, writes go straight through this pointer
+		void* GetMappedPtr() const			  { return m_mapped; }
+		void SetMappedPtr(void* mapped)		  { m_mapped = mapped; }
+		bool IsPersistentlyMapped() const	  { return m_mapped != nullptr; }
+
 	protected:
 
 		uint32_t m_type;
@@ -41,6 +46,7 @@ namespace JLEngine
 		bool m_isDirty = true;
 		bool m_immutable = true;
 		bool m_created = false;
+		void* m_mapped = nullptr;
 	};
 }
 
@@ -0,0 +1,230 @@
+#include "GeometryBatch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace JLEngine
+{
+	GeometryID GeometryBatch::Add(std::vector<std::byte>& vertexData, std::vector<uint32_t>& indexData, uint32_t stride,
+		const std::vector<std::byte>& vertices, const std::vector<uint32_t>& indices)
+	{
+		return Add(vertexData, indexData, stride, vertices.data(), vertices.size(), indices.data(), indices.size());
+	}
+
+	GeometryID GeometryBatch::Add(std::vector<std::byte>& vertexData, std::vector<uint32_t>& indexData, uint32_t stride,
+		const std::byte* vertices, size_t vertexBytes, const uint32_t* indices, size_t indexCount)
+	{
+		if (stride == 0) return InvalidGeometry;
+		if (m_stride == 0) m_stride = stride;
+		if (stride != m_stride)
+		{
+			std::cerr << "GeometryBatch: vertex stride " << stride << " doesn't match the batch stride " << m_stride << std::endl;
+			return InvalidGeometry;
+		}
+
+		GeometryID id = m_ids.Allocate();
+		if (id >= m_records.size()) m_records.resize(id + 1);
+
+		auto& record = m_records[id];
+		record = Record{};
+		record.live = true;
+		record.range.vertexCount = static_cast<uint32_t>(vertexBytes / stride);
+		record.range.indexCount = static_cast<uint32_t>(indexCount);
+
+		// --- VERTICES ---
+		uint32_t baseVertex = m_vertexAllocator.Allocate(record.range.vertexCount);
+		if (baseVertex != BufferSuballocator::InvalidOffset)
+		{
+			size_t required = static_cast<size_t>(m_vertexAllocator.Capacity()) * m_stride;
+			if (vertexData.size() < required) vertexData.resize(required);
+
+			size_t begin = static_cast<size_t>(baseVertex) * m_stride;
+			size_t bytes = static_cast<size_t>(record.range.vertexCount) * m_stride;
+			std::memcpy(vertexData.data() + begin, vertices, bytes);
+			m_dirtyVertexBytes.push_back({ begin, begin + bytes });
+
+			record.range.baseVertex = baseVertex;
+			m_vertexOwners[baseVertex] = id;
+		}
+
+		// --- INDICES ---
+		uint32_t firstIndex = m_indexAllocator.Allocate(record.range.indexCount);
+		if (firstIndex != BufferSuballocator::InvalidOffset)
+		{
+			if (indexData.size() < m_indexAllocator.Capacity()) indexData.resize(m_indexAllocator.Capacity());
+
+			std::copy(indices, indices + indexCount, indexData.begin() + firstIndex);
+			size_t begin = static_cast<size_t>(firstIndex) * sizeof(uint32_t);
+			m_dirtyIndexBytes.push_back({ begin, begin + indexCount * sizeof(uint32_t) });
+
+			record.range.firstIndex = firstIndex;
+			m_indexOwners[firstIndex] = id;
+		}
+
+		return id;
+	}
+
+	void GeometryBatch::Remove(GeometryID id)
+	{
+		if (!IsLive(id)) return;
+
+		// the data is left in place, nothing reads a free range and the next Add overwrites it
+		auto& record = m_records[id];
+		if (record.range.vertexCount > 0)
+		{
+			m_vertexAllocator.Free(record.range.baseVertex, record.range.vertexCount);
+			m_vertexOwners.erase(record.range.baseVertex);
+		}
+		if (record.range.indexCount > 0)
+		{
+			m_indexAllocator.Free(record.range.firstIndex, record.range.indexCount);
+			m_indexOwners.erase(record.range.firstIndex);
+		}
+
+		record = Record{};
+		m_ids.Free(id);
+	}
+
+	void GeometryBatch::SetOwner(GeometryID id, Mesh* owner, uint32_t submeshIndex)
+	{
+		if (!IsLive(id)) return;
+
+		m_records[id].owner = owner;
+		m_records[id].submeshIndex = submeshIndex;
+	}
+
+	void GeometryBatch::Clear()
+	{
+		m_records.clear();
+		m_ids.Clear();
+		m_vertexAllocator.Clear();
+		m_indexAllocator.Clear();
+		m_vertexOwners.clear();
+		m_indexOwners.clear();
+		m_stride = 0;
+		ClearDirty();
+	}
+
+	size_t GeometryBatch::Defragment(std::vector<std::byte>& vertexData, std::vector<uint32_t>& indexData, size_t byteBudget, std::vector<GeometryMove>& moves)
+	{
+		size_t moved = 0;
+		bool verticesCompact = false;
+		bool indicesCompact = false;
+
+		// alternate between the two spaces so neither starves the other of budget
+		while (!(verticesCompact && indicesCompact) && (moved == 0 || moved < byteBudget))
+		{
+			if (!verticesCompact)
+			{
+				size_t bytes = CompactVertices(vertexData, moves);
+				verticesCompact = bytes == 0;
+				moved += bytes;
+			}
+			if (!indicesCompact && (moved == 0 || moved < byteBudget))
+			{
+				size_t bytes = CompactIndices(indexData, moves);
+				indicesCompact = bytes == 0;
+				moved += bytes;
+			}
+		}
+		return moved;
+	}
+
+	size_t GeometryBatch::CompactVertices(std::vector<std::byte>& vertexData, std::vector<GeometryMove>& moves)
+	{
+		uint32_t hole, holeSize;
+		if (!m_vertexAllocator.FirstFreeBlock(hole, holeSize)) return 0;
+
+		// the lowest hole is always followed by a live range unless it is the tail
+		auto owner = m_vertexOwners.find(hole + holeSize);
+		if (owner == m_vertexOwners.end())
+		{
+			if (m_vertexAllocator.TrimTail())
+				vertexData.resize(static_cast<size_t>(m_vertexAllocator.Capacity()) * m_stride);
+			return 0;
+		}
+
+		GeometryID id = owner->second;
+		auto& range = m_records[id].range;
+		uint32_t from = range.baseVertex;
+		if (!m_vertexAllocator.Move(from, range.vertexCount, hole)) return 0;
+
+		// sliding down, memmove handles the overlap
+		size_t begin = static_cast<size_t>(hole) * m_stride;
+		size_t bytes = static_cast<size_t>(range.vertexCount) * m_stride;
+		std::memmove(vertexData.data() + begin, vertexData.data() + static_cast<size_t>(from) * m_stride, bytes);
+		m_dirtyVertexBytes.push_back({ begin, begin + bytes });
+
+		m_vertexOwners.erase(owner);
+		m_vertexOwners[hole] = id;
+		range.baseVertex = hole;
+
+		moves.push_back(MakeMove(id));
+		return bytes;
+	}
+
+	size_t GeometryBatch::CompactIndices(std::vector<uint32_t>& indexData, std::vector<GeometryMove>& moves)
+	{
+		uint32_t hole, holeSize;
+		if (!m_indexAllocator.FirstFreeBlock(hole, holeSize)) return 0;
+
+		auto owner = m_indexOwners.find(hole + holeSize);
+		if (owner == m_indexOwners.end())
+		{
+			if (m_indexAllocator.TrimTail())
+				indexData.resize(m_indexAllocator.Capacity());
+			return 0;
+		}
+
+		GeometryID id = owner->second;
+		auto& range = m_records[id].range;
+		uint32_t from = range.firstIndex;
+		if (!m_indexAllocator.Move(from, range.indexCount, hole)) return 0;
+
+		// indices are local to the geometry, they are copied as they are
+		std::copy(indexData.begin() + from, indexData.begin() + from + range.indexCount, indexData.begin() + hole);
+		size_t begin = static_cast<size_t>(hole) * sizeof(uint32_t);
+		size_t bytes = static_cast<size_t>(range.indexCount) * sizeof(uint32_t);
+		m_dirtyIndexBytes.push_back({ begin, begin + bytes });
+
+		m_indexOwners.erase(owner);
+		m_indexOwners[hole] = id;
+		range.firstIndex = hole;
+
+		moves.push_back(MakeMove(id));
+		return bytes;
+	}
+
+	GeometryMove GeometryBatch::MakeMove(GeometryID id) const
+	{
+		auto& record = m_records[id];
+		return GeometryMove{ id, record.owner, record.submeshIndex, record.range };
+	}
+
+	void GeometryBatch::ClearDirty()
+	{
+		m_dirtyVertexBytes.clear();
+		m_dirtyIndexBytes.clear();
+	}
+
+	void GeometryBatch::Coalesce(std::vector<ByteRange>& ranges)
+	{
+		if (ranges.size() < 2) return;
+
+		std::sort(ranges.begin(), ranges.end());
+		size_t merged = 0;
+		for (size_t i = 1; i < ranges.size(); ++i)
+		{
+			if (ranges[i].first <= ranges[merged].second)
+			{
+				ranges[merged].second = std::max(ranges[merged].second, ranges[i].second);
+			}
+			else
+			{
+				ranges[++merged] = ranges[i];
+			}
+		}
+		ranges.resize(merged + 1);
+	}
+}
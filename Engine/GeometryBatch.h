@@ -0,0 +1,109 @@
+#ifndef GEOMETRY_BATCH_H
+#define GEOMETRY_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "BufferSuballocator.h"
+#include "SlotAllocator.h"
+
+namespace JLEngine
+{
+	class Mesh;
+
+	using GeometryID = uint32_t;
+	constexpr GeometryID InvalidGeometry = UINT32_MAX;
+
+	// Where a piece of geometry lives in its batch, in vertices and indices. Indices are local
+	// to the geometry so moving the vertices only changes baseVertex
+	struct GeometryRange
+	{
+		uint32_t baseVertex = 0;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+	};
+
+	// A range that was relocated by Defragment, the owner's draw commands need the new offsets
+	struct GeometryMove
+	{
+		GeometryID id = InvalidGeometry;
+		Mesh* owner = nullptr;
+		uint32_t submeshIndex = 0;
+		GeometryRange range;
+	};
+
+	// Placement for all the meshes sharing one vertex array. Vertex and index ranges come from
+	// suballocators so geometry can be added and freed at runtime without touching the rest of
+	// the batch, and the CPU copies of the vertex/index buffers are kept sized to match.
+	// Writes are recorded as dirty byte ranges so only those are sent to the GPU.
+	// The batch works on the buffers it is handed, the VertexArrayObject that owns it passes its own.
+	class GeometryBatch
+	{
+	public:
+		using ByteRange = std::pair<size_t, size_t>;	// [begin, end)
+
+		// stride is the vertex size in bytes, every geometry in the batch must use the same layout
+		GeometryID Add(std::vector<std::byte>& vertexData, std::vector<uint32_t>& indexData, uint32_t stride,
+			const std::vector<std::byte>& vertices, const std::vector<uint32_t>& indices);
+		// Same from raw ranges, e.g. straight out of a mapped mesh cache
+		GeometryID Add(std::vector<std::byte>& vertexData, std::vector<uint32_t>& indexData, uint32_t stride,
+			const std::byte* vertices, size_t vertexBytes, const uint32_t* indices, size_t indexCount);
+		void Remove(GeometryID id);
+		void SetOwner(GeometryID id, Mesh* owner, uint32_t submeshIndex);
+		void Clear();
+
+		// Slides live ranges down into the lowest holes until about byteBudget bytes have been moved,
+		// at least one range moves per call so large meshes still make progress. Call once a frame to
+		// compact in the background. Returns the bytes moved, 0 once the batch is compact
+		size_t Defragment(std::vector<std::byte>& vertexData, std::vector<uint32_t>& indexData, size_t byteBudget, std::vector<GeometryMove>& moves);
+
+		bool IsLive(GeometryID id) const { return id < m_records.size() && m_records[id].live; }
+		const GeometryRange& GetRange(GeometryID id) const { return m_records[id].range; }
+		uint32_t GetStride() const { return m_stride; }
+		size_t GetLiveCount() const { return m_ids.LiveCount(); }
+
+		const BufferSuballocator& GetVertexAllocator() const { return m_vertexAllocator; }
+		const BufferSuballocator& GetIndexAllocator() const { return m_indexAllocator; }
+
+		// --- DIRTY TRACKING ---
+		bool HasDirtyRanges() const { return !m_dirtyVertexBytes.empty() || !m_dirtyIndexBytes.empty(); }
+		// Sorted and merged on request
+		std::vector<ByteRange>& GetDirtyVertexRanges() { Coalesce(m_dirtyVertexBytes); return m_dirtyVertexBytes; }
+		std::vector<ByteRange>& GetDirtyIndexRanges() { Coalesce(m_dirtyIndexBytes); return m_dirtyIndexBytes; }
+		void ClearDirty();
+
+		static void Coalesce(std::vector<ByteRange>& ranges);
+
+	private:
+		struct Record
+		{
+			GeometryRange range;
+			Mesh* owner = nullptr;
+			uint32_t submeshIndex = 0;
+			bool live = false;
+		};
+
+		// One compaction step on the vertex or index space, returns the bytes moved
+		size_t CompactVertices(std::vector<std::byte>& vertexData, std::vector<GeometryMove>& moves);
+		size_t CompactIndices(std::vector<uint32_t>& indexData, std::vector<GeometryMove>& moves);
+		GeometryMove MakeMove(GeometryID id) const;
+
+		std::vector<Record> m_records;
+		SlotAllocator m_ids;
+		BufferSuballocator m_vertexAllocator;
+		BufferSuballocator m_indexAllocator;
+		// start offset -> geometry, finds the range that sits right after a hole
+		std::unordered_map<uint32_t, GeometryID> m_vertexOwners;
+		std::unordered_map<uint32_t, GeometryID> m_indexOwners;
+		uint32_t m_stride = 0;
+
+		std::vector<ByteRange> m_dirtyVertexBytes;
+		std::vector<ByteRange> m_dirtyIndexBytes;
+	};
+}
+
+#endif
\ No newline at end of file
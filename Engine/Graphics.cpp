@@ -11,6 +11,8 @@
 #include "GPUResource.h"
 #include "RenderTarget.h"
 #include "VertexStructures.h"
+#include "MipGenerator.h"
+#include "JobSystem.h"
 
 #include <sstream>
 #include <stdexcept>
@@ -71,12 +73,36 @@ namespace JLEngine
 
 		glTextureStorage2D(image, mipLevels, params.internalFormat, imgData.width, imgData.height);
 
+		// 8 bit mips are filtered on the CPU, gamma correct and aware of normal maps and alpha testing
+		bool cpuMipmaps = params.mipmapEnabled && params.cpuMipmaps && !imgData.isHDR && params.dataType == GL_UNSIGNED_BYTE &&
+			imgData.channels >= 1 && imgData.channels <= 4 &&
+			imgData.data.size() == static_cast<size_t>(imgData.width) * imgData.height * imgData.channels;
+
 		if (imgData.isHDR && !imgData.hdrData.empty())
 		{
 			glTextureSubImage2D(image, 
 				0, 0, 0, imgData.width, imgData.height, params.format, 
 				params.dataType, imgData.hdrData.data());
 		}
+		else if (cpuMipmaps)
+		{
+			MipSettings settings;
+			settings.srgb = params.internalFormat == GL_SRGB8 || params.internalFormat == GL_SRGB8_ALPHA8;
+			settings.normalMap = params.normalMap;
+			settings.alphaCutoff = params.alphaCutoff;
+			auto chain = MipGenerator::Generate(imgData.data.data(), imgData.width, imgData.height, imgData.channels, settings, &JobSystem::Global());
+
+			// the levels are tightly packed, small RGB ones break GL's default 4 byte alignment
+			GLint unpackAlignment;
+			glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			for (GLuint level = 0; level < mipLevels && level < chain.levels.size(); ++level)
+			{
+				const auto& mip = chain.levels[level];
+				glTextureSubImage2D(image, level, 0, 0, mip.width, mip.height, params.format, params.dataType, chain.LevelData(level));
+			}
+			glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+		}
 		else if (!imgData.data.empty())
 		{
 			glTextureSubImage2D(image,
@@ -98,27 +124,349 @@ namespace JLEngine
 		glTextureParameteri(image, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTextureParameteri(image, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-		if (params.mipmapEnabled)
+		if (params.mipmapEnabled && !cpuMipmaps)
 		{
 			glGenerateTextureMipmap(image); // Generate mipmaps for mutable textures
 		}
 
 		if (makeBindless)
 		{
-			GLuint64 bindlessHandle = glGetTextureHandleARB(texture->GetGPUID());
-			if (bindlessHandle == 0)
-			{
-				std::cerr << "Error: glGetTextureHandleARB - handle = 0" << std::endl;
-				throw std::runtime_error("Invalid handle");
-			}
-			glMakeTextureHandleResidentARB(bindlessHandle);
-			texture->SetBindlessHandle(bindlessHandle);
+			MakeBindless(texture);
 		}
 
 		// debug 
 		glObjectLabel(GL_TEXTURE, image, (GLsizei)texture->GetName().length(), texture->GetName().c_str());
 	}
 
+	void Graphics::CreateCompressedTexture(Texture* texture, const CompressedImage& image, bool makeBindless)
+	{
+		if (!texture)
+		{
+			throw std::runtime_error("Invalid texture!");
+		}
+
+		if (image.levels.empty() || image.width == 0 || image.height == 0)
+		{
+			std::cerr << "Graphics::CreateCompressedTexture: No levels in " << texture->GetName() << std::endl;
+			return;
+		}
+
+		auto& params = texture->GetParams();
+		GLenum internalFormat = CompressedInternalFormat(image.format, image.srgb);
+
+		GLuint id;
+		glCreateTextures(GL_TEXTURE_2D, 1, &id);
+		texture->SetGPUID(id);
+
+		GLfloat anisotropy;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &anisotropy);
+		glTextureParameterf(id, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+
+		GLsizei levels = static_cast<GLsizei>(image.levels.size());
+		glTextureStorage2D(id, levels, internalFormat, image.width, image.height);
+		for (GLsizei level = 0; level < levels; ++level)
+		{
+			const auto& info = image.levels[level];
+			glCompressedTextureSubImage2D(id, level, 0, 0, info.width, info.height, internalFormat,
+				static_cast<GLsizei>(info.size), image.LevelData(level));
+		}
+
+		glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, params.magFilter);
+		glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : params.minFilter);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		if (makeBindless)
+		{
+			MakeBindless(texture);
+		}
+
+		glObjectLabel(GL_TEXTURE, id, (GLsizei)texture->GetName().length(), texture->GetName().c_str());
+	}
+
+	namespace
+	{
+		// the S3TC enums come from extensions glad may leave out, every desktop driver supports them
+		constexpr GLenum RGB_S3TC_DXT1 = 0x83F0;
+		constexpr GLenum RGBA_S3TC_DXT1 = 0x83F1;
+		constexpr GLenum RGBA_S3TC_DXT5 = 0x83F3;
+		constexpr GLenum SRGB_S3TC_DXT1 = 0x8C4C;
+		constexpr GLenum SRGB_ALPHA_S3TC_DXT1 = 0x8C4D;
+		constexpr GLenum SRGB_ALPHA_S3TC_DXT5 = 0x8C4F;
+
+		struct KTX2GLFormat
+		{
+			GLenum internalFormat = 0;
+			GLenum format = 0;	// 0 for the compressed formats
+			GLenum type = 0;
+		};
+
+		KTX2GLFormat GetKTX2GLFormat(KTX2Format format)
+		{
+			switch (format)
+			{
+			case KTX2Format::R8_UNORM:			return { GL_R8, GL_RED, GL_UNSIGNED_BYTE };
+			case KTX2Format::RG8_UNORM:			return { GL_RG8, GL_RG, GL_UNSIGNED_BYTE };
+			case KTX2Format::RGB8_UNORM:		return { GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE };
+			case KTX2Format::RGB8_SRGB:			return { GL_SRGB8, GL_RGB, GL_UNSIGNED_BYTE };
+			case KTX2Format::RGBA8_UNORM:		return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE };
+			case KTX2Format::RGBA8_SRGB:		return { GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE };
+			case KTX2Format::R16_SFLOAT:		return { GL_R16F, GL_RED, GL_HALF_FLOAT };
+			case KTX2Format::RG16_SFLOAT:		return { GL_RG16F, GL_RG, GL_HALF_FLOAT };
+			case KTX2Format::RGB16_SFLOAT:		return { GL_RGB16F, GL_RGB, GL_HALF_FLOAT };
+			case KTX2Format::RGBA16_SFLOAT:		return { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT };
+			case KTX2Format::R32_SFLOAT:		return { GL_R32F, GL_RED, GL_FLOAT };
+			case KTX2Format::RG32_SFLOAT:		return { GL_RG32F, GL_RG, GL_FLOAT };
+			case KTX2Format::RGB32_SFLOAT:		return { GL_RGB32F, GL_RGB, GL_FLOAT };
+			case KTX2Format::RGBA32_SFLOAT:		return { GL_RGBA32F, GL_RGBA, GL_FLOAT };
+			case KTX2Format::B10G11R11_UFLOAT:	return { GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV };
+			case KTX2Format::BC1_RGB_UNORM:		return { RGB_S3TC_DXT1 };
+			case KTX2Format::BC1_RGB_SRGB:		return { SRGB_S3TC_DXT1 };
+			case KTX2Format::BC1_RGBA_UNORM:	return { RGBA_S3TC_DXT1 };
+			case KTX2Format::BC1_RGBA_SRGB:		return { SRGB_ALPHA_S3TC_DXT1 };
+			case KTX2Format::BC3_UNORM:			return { RGBA_S3TC_DXT5 };
+			case KTX2Format::BC3_SRGB:			return { SRGB_ALPHA_S3TC_DXT5 };
+			case KTX2Format::BC4_UNORM:			return { GL_COMPRESSED_RED_RGTC1 };
+			case KTX2Format::BC5_UNORM:			return { GL_COMPRESSED_RG_RGTC2 };
+			case KTX2Format::BC6H_UFLOAT:		return { GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT };
+			case KTX2Format::BC7_UNORM:			return { GL_COMPRESSED_RGBA_BPTC_UNORM };
+			case KTX2Format::BC7_SRGB:			return { GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM };
+			default:							return {};
+			}
+		}
+	}
+
+	uint32_t Graphics::CompressedInternalFormat(BlockFormat format, bool srgb)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1: return srgb ? SRGB_S3TC_DXT1 : RGB_S3TC_DXT1;
+		case BlockFormat::BC3: return srgb ? SRGB_ALPHA_S3TC_DXT5 : RGBA_S3TC_DXT5;
+		case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+		case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+		case BlockFormat::BC7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+		}
+		return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+
+	uint32_t Graphics::CreateKTX2Texture(const KTX2Image& image, const std::string& label)
+	{
+		auto glFormat = GetKTX2GLFormat(image.format);
+		if (glFormat.internalFormat == 0 || image.levels.empty())
+		{
+			std::cerr << "Graphics::CreateKTX2Texture: Unsupported format " << static_cast<uint32_t>(image.format) << " for " << label << std::endl;
+			return 0;
+		}
+
+		GLenum target = image.IsCubemap() ? (image.IsArray() ? GL_TEXTURE_CUBE_MAP_ARRAY : GL_TEXTURE_CUBE_MAP)
+			: (image.IsArray() ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D);
+		GLsizei levels = static_cast<GLsizei>(image.levels.size());
+		// cube faces are layers to the 3D calls, a cube array has six a layer
+		GLsizei depth = static_cast<GLsizei>(std::max(image.layers, 1u) * image.faces);
+
+		GLuint id;
+		glCreateTextures(target, 1, &id);
+		if (target == GL_TEXTURE_2D || target == GL_TEXTURE_CUBE_MAP)
+			glTextureStorage2D(id, levels, glFormat.internalFormat, image.width, image.height);
+		else
+			glTextureStorage3D(id, levels, glFormat.internalFormat, image.width, image.height, depth);
+
+		// KTX2 rows are tightly packed, GL's default 4 byte alignment breaks small RGB levels
+		GLint unpackAlignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for (GLsizei level = 0; level < levels; ++level)
+		{
+			GLsizei width = image.LevelWidth(level);
+			GLsizei height = image.LevelHeight(level);
+			const std::byte* pixels = image.LevelData(level);
+			GLsizei size = static_cast<GLsizei>(image.levels[level].size);
+
+			if (target == GL_TEXTURE_2D)
+			{
+				if (glFormat.format == 0)
+					glCompressedTextureSubImage2D(id, level, 0, 0, width, height, glFormat.internalFormat, size, pixels);
+				else
+					glTextureSubImage2D(id, level, 0, 0, width, height, glFormat.format, glFormat.type, pixels);
+			}
+			else
+			{
+				if (glFormat.format == 0)
+					glCompressedTextureSubImage3D(id, level, 0, 0, 0, width, height, depth, glFormat.internalFormat, size, pixels);
+				else
+					glTextureSubImage3D(id, level, 0, 0, 0, width, height, depth, glFormat.format, glFormat.type, pixels);
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+		GLenum wrap = image.IsCubemap() ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+		glTextureParameteri(id, GL_TEXTURE_WRAP_S, wrap);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_T, wrap);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_R, wrap);
+		glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		if (!label.empty())
+			glObjectLabel(GL_TEXTURE, id, (GLsizei)label.length(), label.c_str());
+		return id;
+	}
+
+	void Graphics::CreateKTX2Texture(Texture* texture, const KTX2Image& image, bool makeBindless)
+	{
+		if (!texture)
+		{
+			throw std::runtime_error("Invalid texture!");
+		}
+
+		uint32_t id = CreateKTX2Texture(image, texture->GetName());
+		if (id == 0) return;
+		texture->SetGPUID(id);
+
+		GLfloat anisotropy;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &anisotropy);
+		glTextureParameterf(id, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+
+		if (makeBindless)
+		{
+			MakeBindless(texture);
+		}
+	}
+
+	bool Graphics::ReplaceTextureMips(Texture* texture, const KTX2Image& upload, uint32_t levelCount,
+		uint32_t firstMip, uint32_t oldFirstMip, bool makeBindless)
+	{
+		if (!texture)
+		{
+			throw std::runtime_error("Invalid texture!");
+		}
+
+		auto glFormat = GetKTX2GLFormat(upload.format);
+		GLuint oldId = texture->GetGPUID();
+		if (glFormat.internalFormat == 0 || levelCount == 0 || upload.levels.size() > levelCount ||
+			(oldId == 0 && upload.levels.size() < levelCount))
+		{
+			std::cerr << "Graphics::ReplaceTextureMips: Can't build " << texture->GetName() << " from mip " << firstMip << std::endl;
+			return false;
+		}
+
+		GLuint id;
+		glCreateTextures(GL_TEXTURE_2D, 1, &id);
+		glTextureStorage2D(id, levelCount, glFormat.internalFormat, upload.width, upload.height);
+
+		GLint unpackAlignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			GLsizei width = upload.LevelWidth(level);
+			GLsizei height = upload.LevelHeight(level);
+			if (level < upload.levels.size())
+			{
+				const std::byte* pixels = upload.LevelData(level);
+				if (glFormat.format == 0)
+					glCompressedTextureSubImage2D(id, level, 0, 0, width, height, glFormat.internalFormat,
+						static_cast<GLsizei>(upload.levels[level].size), pixels);
+				else
+					glTextureSubImage2D(id, level, 0, 0, width, height, glFormat.format, glFormat.type, pixels);
+			}
+			else
+			{
+				// whole levels, which is allowed for block compressed formats below the block size
+				GLint oldLevel = static_cast<GLint>(firstMip + level - oldFirstMip);
+				glCopyImageSubData(oldId, GL_TEXTURE_2D, oldLevel, 0, 0, 0, id, GL_TEXTURE_2D, level, 0, 0, 0, width, height, 1);
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+		auto& params = texture->GetParams();
+		GLfloat anisotropy;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &anisotropy);
+		glTextureParameterf(id, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+		glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, params.magFilter);
+		glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glObjectLabel(GL_TEXTURE, id, (GLsizei)texture->GetName().length(), texture->GetName().c_str());
+
+		texture->SetGPUID(id);
+		texture->SetBindlessHandle(0);
+		if (makeBindless)
+		{
+			MakeBindless(texture);
+		}
+		return true;
+	}
+
+	void Graphics::ReleaseTexture(uint32_t textureId, uint64_t bindlessHandle)
+	{
+		if (bindlessHandle != 0)
+			glMakeTextureHandleNonResidentARB(bindlessHandle);
+		GLuint id = textureId;
+		if (id != 0)
+			API()->DeleteTexture(1, &id);
+	}
+
+	bool Graphics::ReadKTX2Texture(uint32_t textureId, KTX2Format format, KTX2Image& out)
+	{
+		auto glFormat = GetKTX2GLFormat(format);
+		if (glFormat.internalFormat == 0 || textureId == 0)
+			return false;
+
+		GLint target = 0, width = 0, height = 0, depth = 0;
+		glGetTextureParameteriv(textureId, GL_TEXTURE_TARGET, &target);
+		glGetTextureLevelParameteriv(textureId, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTextureLevelParameteriv(textureId, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTextureLevelParameteriv(textureId, 0, GL_TEXTURE_DEPTH, &depth);
+		if (width == 0 || height == 0)
+			return false;
+
+		// mutable textures only have the levels that were given storage
+		uint32_t levelCount = 0;
+		uint32_t maxLevels = static_cast<uint32_t>(std::log2(std::max(width, height))) + 1;
+		while (levelCount < maxLevels)
+		{
+			GLint levelWidth = 0;
+			glGetTextureLevelParameteriv(textureId, levelCount, GL_TEXTURE_WIDTH, &levelWidth);
+			if (levelWidth == 0) break;
+			levelCount++;
+		}
+
+		uint32_t faces = (target == GL_TEXTURE_CUBE_MAP || target == GL_TEXTURE_CUBE_MAP_ARRAY) ? 6 : 1;
+		uint32_t layers = 0;
+		if (target == GL_TEXTURE_2D_ARRAY) layers = depth;
+		if (target == GL_TEXTURE_CUBE_MAP_ARRAY) layers = depth / 6;
+		out.Allocate(format, width, height, levelCount, layers, faces);
+
+		// cube faces come back one after another like KTX2 keeps them
+		GLint packAlignment;
+		glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			GLsizei size = static_cast<GLsizei>(out.levels[level].size);
+			std::byte* pixels = out.data.data() + out.levels[level].offset;
+			if (glFormat.format == 0)
+				glGetCompressedTextureImage(textureId, level, size, pixels);
+			else
+				glGetTextureImage(textureId, level, glFormat.format, glFormat.type, size, pixels);
+		}
+		glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+		return true;
+	}
+
+	void Graphics::MakeBindless(Texture* texture)
+	{
+		GLuint64 bindlessHandle = glGetTextureHandleARB(texture->GetGPUID());
+		if (bindlessHandle == 0)
+		{
+			std::cerr << "Error: glGetTextureHandleARB - handle = 0" << std::endl;
+			throw std::runtime_error("Invalid handle");
+		}
+		glMakeTextureHandleResidentARB(bindlessHandle);
+		texture->SetBindlessHandle(bindlessHandle);
+	}
+
 	void Graphics::CreateCubemap(Cubemap* cubemap)
 	{
 		if (!cubemap)
@@ -201,7 +549,21 @@ namespace JLEngine
 
 		glVertexArrayVertexBuffer(vao->GetGPUID(), 0, vbo.GetGPUBuffer().GetGPUID(), 0, stride);
 
-		auto vertexAttribKey = vao->GetAttribKey();
+		SetupVertexAttributes(vaoID, vao->GetAttribKey(), vao->GetPosCount());
+
+		if (vao->HasIndices())
+		{
+			auto& ibo = vao->GetIBO();
+			CreateGPUBuffer<uint32_t>(ibo.GetGPUBuffer(), ibo.GetDataImmutable());
+			glVertexArrayElementBuffer(vaoID, ibo.GetGPUBuffer().GetGPUID());
+		}
+
+		// the whole batch was just uploaded
+		vao->GetGeometry().ClearDirty();
+	}
+
+	void Graphics::SetupVertexAttributes(uint32_t vaoID, uint32_t vertexAttribKey, int posCount)
+	{
 		uint32_t offset = 0;
 		uint32_t index = 0;
 
@@ -209,71 +571,95 @@ namespace JLEngine
 		{
 			if (vertexAttribKey & (1 << i))
 			{
-				GLenum type = GL_FLOAT;    // Default type is float
-				GLboolean normalized = GL_FALSE;
-				GLsizei size = 0;
-				bool isInteger = false;
+				auto format = GetVertexAttribFormat(vertexAttribKey, static_cast<AttributeType>(1 << i), posCount);
+				if (format.components == 0) continue;
 
-				switch (static_cast<AttributeType>(1 << i))
+				GLenum type = GL_FLOAT;
+				switch (format.type)
 				{
-				case AttributeType::POSITION:
-					size = vao->GetPosCount();
-					break;
-				case AttributeType::NORMAL:
-					size = 3;
-					break;
-				case AttributeType::TEX_COORD_0:
-				case AttributeType::TEX_COORD_1:
-					size = 2;
-					break;
-				case AttributeType::COLOUR:
-					size = 4;
-					normalized = GL_TRUE;
-					break;
-				case AttributeType::TANGENT:
-					size = 4;
-					break;
-				case AttributeType::JOINT_0:
-					size = 4;
-					type = GL_UNSIGNED_SHORT;  // JOINT_0 is typically unsigned short
-					isInteger = true;
-					break;
-				case AttributeType::WEIGHT_0:
-					size = 4;
-					break;
-				default:
-					std::cerr << "Unsupported attribute type!" << std::endl;
-					continue;
+				case VertexComponentType::HalfFloat:		type = GL_HALF_FLOAT; break;
+				case VertexComponentType::Short:			type = GL_SHORT; break;
+				case VertexComponentType::UnsignedShort:	type = GL_UNSIGNED_SHORT; break;
+				default: break;
 				}
 
 				glEnableVertexArrayAttrib(vaoID, index);
 
-				if (isInteger)
+				if (format.integer)
 				{
-					glVertexArrayAttribIFormat(vaoID, index, size, type, offset);
+					glVertexArrayAttribIFormat(vaoID, index, format.components, type, offset);
 				}
 				else
 				{
-					glVertexArrayAttribFormat(vaoID, index, size, type, normalized, offset);
+					glVertexArrayAttribFormat(vaoID, index, format.components, type, format.normalized ? GL_TRUE : GL_FALSE, offset);
 				}
 
 				glVertexArrayAttribBinding(vaoID, index, 0);
 
 				// Update offset based on attribute size
-				offset += size * (isInteger ? sizeof(uint16_t) : sizeof(float));
+				offset += format.SizeInBytes();
 				++index;
 			}
 		}
+	}
 
-		if (vao->HasIndices())
+	void Graphics::AttachVertexArrayBuffers(VertexArrayObject* vao, uint32_t vertexBufferID, uint32_t indexBufferID)
+	{
+		if (vao->GetGPUID() == 0)
 		{
-			auto& ibo = vao->GetIBO();
-			CreateGPUBuffer<uint32_t>(ibo.GetGPUBuffer(), ibo.GetDataImmutable());
-			glVertexArrayElementBuffer(vaoID, ibo.GetGPUBuffer().GetGPUID());
+			uint32_t vaoID;
+			glCreateVertexArrays(1, &vaoID);
+			vao->SetGPUID(vaoID);
+			SetupVertexAttributes(vaoID, vao->GetAttribKey(), vao->GetPosCount());
 		}
+
+		glVertexArrayVertexBuffer(vao->GetGPUID(), 0, vertexBufferID, 0, CalculateStrideInBytes(vao->GetAttribKey(), vao->GetPosCount()));
+		glVertexArrayElementBuffer(vao->GetGPUID(), indexBufferID);
 	}
 
 
+	void Graphics::UploadGeometryChanges(VertexArrayObject* vao)
+	{
+		auto& geometry = vao->GetGeometry();
+		if (!geometry.HasDirtyRanges()) return;
+
+		// --- VERTICES ---
+		auto& vbo = vao->GetVBO();
+		auto& vdata = vbo.GetDataImmutable();
+		GPUBuffer& vertexBuffer = vbo.GetGPUBuffer();
+		uint32_t oldVBO = vertexBuffer.GetGPUID();
+		ReserveGPUBuffer(vertexBuffer, vdata.size());
+		if (vertexBuffer.GetGPUID() != oldVBO)
+			glVertexArrayVertexBuffer(vao->GetGPUID(), 0, vertexBuffer.GetGPUID(), 0, CalculateStrideInBytes(vao));
+
+		// ranges can point past the end if the batch trimmed its tail after writing them
+		for (auto& [begin, end] : geometry.GetDirtyVertexRanges())
+		{
+			size_t clampedEnd = std::min(end, vdata.size());
+			if (begin >= clampedEnd) continue;
+			API()->NamedBufferSubData(vertexBuffer.GetGPUID(), begin, clampedEnd - begin, vdata.data() + begin);
+		}
+
+		// --- INDICES ---
+		auto& ibo = vao->GetIBO();
+		auto& idata = ibo.GetDataImmutable();
+		GPUBuffer& indexBuffer = ibo.GetGPUBuffer();
+		uint32_t oldIBO = indexBuffer.GetGPUID();
+		ReserveGPUBuffer(indexBuffer, idata.size() * sizeof(uint32_t));
+		if (indexBuffer.GetGPUID() != oldIBO)
+			glVertexArrayElementBuffer(vao->GetGPUID(), indexBuffer.GetGPUID());
+
+		size_t indexBytes = idata.size() * sizeof(uint32_t);
+		for (auto& [begin, end] : geometry.GetDirtyIndexRanges())
+		{
+			size_t clampedEnd = std::min(end, indexBytes);
+			if (begin >= clampedEnd) continue;
+			API()->NamedBufferSubData(indexBuffer.GetGPUID(), begin, clampedEnd - begin, reinterpret_cast<const std::byte*>(idata.data()) + begin);
+		}
+
+		geometry.ClearDirty();
+	}
+
 	void Graphics::DisposeVertexArray(VertexArrayObject* vao)
 	{
 		auto id = vao->GetGPUID();
@@ -476,6 +862,20 @@ namespace JLEngine
 		}
 	}
 
+	void Graphics::ReserveGPUBuffer(GPUBuffer& buffer, size_t sizeInBytes)
+	{
+		if (sizeInBytes <= buffer.GetSizeInBytes()) return;
+
+		// at least double so a stream of small additions doesn't copy the buffer every time
+		size_t newSize = std::max(sizeInBytes, buffer.GetSizeInBytes() * 2);
+
+		uint32_t oldGPUID = buffer.GetGPUID();
+		Resize(buffer, buffer.GetSizeInBytes(), newSize);
+		buffer.SetCreated(true);
+
+		API()->DisposeBuffer(1, &oldGPUID);
+	}
+
 	void Graphics::Resize(GPUBuffer& buffer, size_t oldSize, size_t newSize)
 	{
 		uint32_t newGPUID;
@@ -628,6 +1028,11 @@ namespace JLEngine
 		glBindBufferBase(buffer.GetType(), bindPoint, buffer.GetGPUID());
 	}
 
+	void Graphics::BindTransient(GLenum target, int bindPoint, const TransientAllocation& allocation)
+	{
+		API()->BindBufferRange(allocation.bufferID, target, bindPoint, allocation.offset, allocation.size);
+	}
+
 	void Graphics::CreateGPUBuffer(GPUBuffer& buffer)
 	{
 		bool immutable = buffer.IsImmutable();
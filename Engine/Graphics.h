@@ -2,9 +2,12 @@
 #define GRAPHICS_H
 
 #include "Texture.h"
+#include "TextureCompressor.h"
+#include "KTX2File.h"
 #include "ShaderStorageBuffer.h"
 #include "GPUBuffer.h"
 #include "GraphicsAPI.h"
+#include "PersistentRingBuffer.h"
 
 #include <stdexcept>
 #include <algorithm>
@@ -28,8 +31,19 @@ namespace JLEngine
 	{
 		std::shared_ptr<VertexArrayObject> vao;
 		std::shared_ptr<IndirectDrawBuffer> drawBuffer;
+		// compacted per frame from drawBuffer, only the commands that survived culling
+		std::shared_ptr<IndirectDrawBuffer> visibleDrawBuffer;
+		// culling slot for each command in drawBuffer, NoCullSlot for commands that are always drawn
+		std::vector<uint32_t> cullSlots;
+		// one per shadow cascade, the same commands as drawBuffer with culled casters at instanceCount 0
+		std::vector<std::shared_ptr<IndirectDrawBuffer>> shadowDrawBuffers;
+		std::vector<uint32_t> shadowCasterCounts;
+
+		static constexpr uint32_t NoCullSlot = UINT32_MAX;
 	};
 
+	using FrameRingBuffer = PersistentRingBuffer<GraphicsAPI>;
+
 	class Graphics
 	{
 	public:
@@ -40,10 +54,32 @@ namespace JLEngine
 		static void DisposeTexture(Texture* texture);
 		static void DisposeCubemap(Cubemap* texture);
 		static void CreateTexture(Texture* texture, bool makeBindless = true);
+		// Uploads every level of a cooked texture as it is, the GPU generates no mips
+		static void CreateCompressedTexture(Texture* texture, const CompressedImage& image, bool makeBindless = true);
+		static uint32_t CompressedInternalFormat(BlockFormat format, bool srgb);
+		// A 2D, array or cube texture with every level of the image, read straight from its memory
+		// so a mapped KTX2File is uploaded without a copy. Returns 0 for formats GL can't take
+		static uint32_t CreateKTX2Texture(const KTX2Image& image, const std::string& label = "");
+		static void CreateKTX2Texture(Texture* texture, const KTX2Image& image, bool makeBindless = true);
+		// Texture streaming, see TextureStreamer. Gives the texture new storage for levelCount levels
+		// from mip firstMip of its chain, upload holding the top ones and sized from firstMip. The levels
+		// below those are copied across on the GPU from the current storage, which starts at oldFirstMip.
+		// The old object and bindless handle are left for ReleaseTexture
+		static bool ReplaceTextureMips(Texture* texture, const KTX2Image& upload, uint32_t levelCount,
+			uint32_t firstMip, uint32_t oldFirstMip, bool makeBindless = true);
+		// Deletes a texture object, its handle made non resident first
+		static void ReleaseTexture(uint32_t textureId, uint64_t bindlessHandle);
+		// Every level of a texture in the given format, for writing bakes out with KTX2File
+		static bool ReadKTX2Texture(uint32_t textureId, KTX2Format format, KTX2Image& out);
 		static void CreateCubemap(Cubemap* cubemap);		
 
 		static void CreateVertexArray(VertexArrayObject* vao);
 		static void DisposeVertexArray(VertexArrayObject* vao);
+		// Sends the ranges the VAO's GeometryBatch wrote since the last call, growing (and rebinding) the buffers if needed
+		static void UploadGeometryChanges(VertexArrayObject* vao);
+		// Points a VAO at buffers it doesn't own, e.g. vertices written by a compute pass drawn with another
+		// VAO's indices. Creates the VAO on first use, call again whenever either buffer is reallocated
+		static void AttachVertexArrayBuffers(VertexArrayObject* vao, uint32_t vertexBufferID, uint32_t indexBufferID);
 
 		// Create a GPU buffer with initial data
 		template <typename T>
@@ -56,7 +92,18 @@ namespace JLEngine
 		static void UploadToGPUBuffer(GPUBuffer& buffer, const std::vector<T>& data, uint32_t offset = 0);
 		template <typename T>
 		static void UploadToGPUBuffer(GPUBuffer& buffer, const T& data, uint32_t offset = 0);
+		// Upload only the listed elements of data, merged into contiguous runs (indices are sorted in place)
+		template <typename T>
+		static void UploadGPUBufferElements(GPUBuffer& buffer, const std::vector<T>& data, std::vector<uint32_t>& indices);
+		// Same as above but the runs are written into this frame's ring partition and copied on the GPU,
+		// falls back to NamedBufferSubData for whatever doesn't fit
+		template <typename T>
+		static void UploadGPUBufferElements(GPUBuffer& buffer, const std::vector<T>& data, std::vector<uint32_t>& indices, FrameRingBuffer& staging);
+		// Grow the buffer to at least sizeInBytes keeping its contents
+		static void ReserveGPUBuffer(GPUBuffer& buffer, size_t sizeInBytes);
 		static void BindGPUBuffer(GPUBuffer& buffer, int bindPoint);
+		// Binds the slice of a ring buffer written this frame, target is GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+		static void BindTransient(GLenum target, int bindPoint, const TransientAllocation& allocation);
 		static void DisposeGPUBuffer(GPUBuffer* idbo);
 
 		static void Blit(RenderTarget* src, RenderTarget* dst, uint32_t bitfield = GL_COLOR_BUFFER_BIT, uint32_t filter = GL_NEAREST);
@@ -72,8 +119,10 @@ namespace JLEngine
 		static void CreateIndirectDrawBuffer(IndirectDrawBuffer* idbo);
 
 	protected:
+		static void SetupVertexAttributes(uint32_t vaoID, uint32_t vertexAttribKey, int posCount);
 		static void AttachDepth(RenderTarget* target);
 		static void AttachTextures(RenderTarget* target);
+		static void MakeBindless(Texture* texture);
 
 		static void Resize(GPUBuffer& buffer, size_t oldSize, size_t newSize);
 
@@ -122,18 +171,60 @@ namespace JLEngine
 		size_t dataSize = data.size() * sizeof(T);
 
 		// Ensure the buffer has enough capacity
-		if (offset + dataSize > buffer.GetSizeInBytes())
-		{
-			size_t newSize = glm::max(offset + dataSize, buffer.GetSizeInBytes() * 2);
+		ReserveGPUBuffer(buffer, offset + dataSize);
+
+		// Upload data to the buffer
+		API()->NamedBufferSubData(buffer.GetGPUID(), offset, dataSize, data.data());
+		buffer.ClearDirty();
+	}
+
+	template <typename T>
+	void Graphics::UploadGPUBufferElements(GPUBuffer& buffer, const std::vector<T>& data, std::vector<uint32_t>& indices)
+	{
+		if (indices.empty()) return;
+
+		ReserveGPUBuffer(buffer, data.size() * sizeof(T));
 
-			uint32_t oldGPUID = buffer.GetGPUID(); 
-			Resize(buffer, buffer.GetSizeInBytes(), newSize);
+		std::sort(indices.begin(), indices.end());
+		indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
 
-			API()->DisposeBuffer(1, &oldGPUID);
+		size_t runStart = 0;
+		for (size_t i = 1; i <= indices.size(); ++i)
+		{
+			if (i < indices.size() && indices[i] == indices[i - 1] + 1) continue;
+
+			uint32_t first = indices[runStart];
+			size_t count = indices[i - 1] - first + 1;
+			API()->NamedBufferSubData(buffer.GetGPUID(), first * sizeof(T), count * sizeof(T), data.data() + first);
+			runStart = i;
 		}
+		buffer.ClearDirty();
+	}
 
-		// Upload data to the buffer
-		API()->NamedBufferSubData(buffer.GetGPUID(), offset, dataSize, data.data());
+	template <typename T>
+	void Graphics::UploadGPUBufferElements(GPUBuffer& buffer, const std::vector<T>& data, std::vector<uint32_t>& indices, FrameRingBuffer& staging)
+	{
+		if (indices.empty()) return;
+
+		ReserveGPUBuffer(buffer, data.size() * sizeof(T));
+
+		std::sort(indices.begin(), indices.end());
+		indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+		size_t runStart = 0;
+		for (size_t i = 1; i <= indices.size(); ++i)
+		{
+			if (i < indices.size() && indices[i] == indices[i - 1] + 1) continue;
+
+			uint32_t first = indices[runStart];
+			size_t count = indices[i - 1] - first + 1;
+			auto allocation = staging.Upload(data.data() + first, count * sizeof(T));
+			if (allocation)
+				API()->CopyNamedBufferSubData(allocation.bufferID, buffer.GetGPUID(), allocation.offset, first * sizeof(T), count * sizeof(T));
+			else
+				API()->NamedBufferSubData(buffer.GetGPUID(), first * sizeof(T), count * sizeof(T), data.data() + first);
+			runStart = i;
+		}
 		buffer.ClearDirty();
 	}
 }
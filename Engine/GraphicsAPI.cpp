@@ -6,6 +6,7 @@
 #include "TextureReader.h"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <array>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
@@ -143,6 +144,11 @@ namespace JLEngine
 		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 	}
 
+	void GraphicsAPI::SyncVertexAttribBarrier()
+	{
+		glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+	}
+
 	void GraphicsAPI::SyncFramebuffer()
 	{
 		glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
@@ -462,6 +468,29 @@ namespace JLEngine
 		}
 	}
 
+	GLsync GraphicsAPI::FenceSync()
+	{
+		return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	GLenum GraphicsAPI::ClientWaitSync(GLsync sync, uint64_t timeoutNs)
+	{
+		// flush so the fence is guaranteed to reach the GPU, otherwise a wait can never finish
+		return glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNs);
+	}
+
+	void GraphicsAPI::DeleteSync(GLsync sync)
+	{
+		glDeleteSync(sync);
+	}
+
+	size_t GraphicsAPI::GetBufferOffsetAlignment()
+	{
+		GLint uboAlignment = GetInteger(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT);
+		GLint ssboAlignment = GetInteger(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT);
+		return static_cast<size_t>(std::max({ uboAlignment, ssboAlignment, 1 }));
+	}
+
 	void GraphicsAPI::BindBuffer( uint32_t buffType, uint32_t vboID )
 	{
 		glBindBuffer(buffType, vboID);
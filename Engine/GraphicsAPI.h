@@ -98,6 +98,7 @@ namespace JLEngine
 		 void ClearColour(float x, float y, float z, float w);
 		 void SyncCompute();
 		 void SyncShaderStorageBarrier();
+		 void SyncVertexAttribBarrier();
 		 void SyncFramebuffer();
 				
 		 // Shader
@@ -219,6 +220,12 @@ namespace JLEngine
 		void UnmapNamedBuffer(uint32_t id);
 		void BindBuffer(uint32_t buffType, uint32_t boID);
 		void DisposeBuffer(uint32_t count, uint32_t* id);
+		// Sync
+		GLsync FenceSync();
+		GLenum ClientWaitSync(GLsync sync, uint64_t timeoutNs);
+		void DeleteSync(GLsync sync);
+		// Offset alignment that satisfies both uniform and storage buffer range binds
+		size_t GetBufferOffsetAlignment();
 
 		// deprecated
 		void BindTexture(uint32_t target, uint32_t id);
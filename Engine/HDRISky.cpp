@@ -6,6 +6,8 @@
 #include "ResourceLoader.h"
 #include "TextureReader.h"
 
+#include <filesystem>
+
 namespace JLEngine
 {
     HDRISky::HDRISky(ResourceLoader* resourceLoader)
@@ -25,46 +27,20 @@ namespace JLEngine
     void HDRISky::Reload(const std::string& assetPath, const HdriSkyInitParams& initParams)
     {
         DeleteTextures();
-
-        auto shaderAssetPath = assetPath + "Core/Shaders/";
-        auto textureAssetPath = assetPath + "HDRI/";
-    
-        TextureReader::LoadTexture(assetPath + "HDRI/" + initParams.fileName, m_hdriSkyImageData, 0);
-        int cubemapSize = m_hdriSkyImageData.width / 4;
-
-        CubemapBaker baker(assetPath, m_resourceLoader);
-
-        m_hdriSky = baker.HDRtoCubemap(m_hdriSkyImageData, cubemapSize, 
-            true, initParams.compressionThreshold, initParams.maxValue);
-        m_irradianceMap = baker.GenerateIrradianceCubemap(m_hdriSky, initParams.irradianceMapSize);
-        m_prefilteredMap = baker.GeneratePrefilteredEnvMap(m_hdriSky, initParams.prefilteredMapSize, initParams.prefilteredSamples);
-        m_brdfLUTMap = baker.GenerateBRDFLUT(512, 1024);
-        
-        m_hdriSkyImageData.hdrData.clear();
+        Bake(assetPath, initParams, true);
     }
 
     void HDRISky::Initialise(const std::string& assetPath, const HdriSkyInitParams& initParams)
     {
         auto shaderAssetPath = assetPath + "Core/Shaders/";
-        auto textureAssetPath = assetPath + "HDRI/";
 
         m_skyShader = m_resourceLoader->CreateShaderFromFile("SkyboxShader", "enviro_cubemap_vert.glsl", "enviro_cubemap_frag.glsl", shaderAssetPath).get();
         Geometry::CreateBox(m_skyboxVAO);
         Graphics::CreateVertexArray(&m_skyboxVAO);
 
-        TextureReader::LoadTexture(assetPath + "HDRI/" + initParams.fileName, m_hdriSkyImageData, 0);
-        int cubemapSize = m_hdriSkyImageData.width / 4;
-
-        //TextureReader::PrintImageData(m_hdriSkyImageData);
-
         Graphics::API()->Enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
-        CubemapBaker baker(assetPath, m_resourceLoader);
-
-        m_hdriSky = baker.HDRtoCubemap(m_hdriSkyImageData, cubemapSize, false, initParams.compressionThreshold, initParams.maxValue);
-        m_irradianceMap = baker.GenerateIrradianceCubemap(m_hdriSky, initParams.irradianceMapSize);
-        m_prefilteredMap = baker.GeneratePrefilteredEnvMap(m_hdriSky, initParams.prefilteredMapSize, initParams.prefilteredSamples);
-        m_brdfLUTMap = baker.GenerateBRDFLUT(512, 1024);
+        Bake(assetPath, initParams, false);
 
         //std::array<ImageData, 6> cubemapData;
         //Graphics::API()->ReadCubemap(m_hdriSky, m_hdriSkyImageData.width, m_hdriSkyImageData.height,
@@ -135,6 +111,66 @@ namespace JLEngine
         //    std::cerr << "  WARNING: No finite values found across all cubemap faces!" << std::endl;
         //}
         //std::cout << "---------------------------------------------" << std::endl;
+    }
+
+    void HDRISky::Bake(const std::string& assetPath, const HdriSkyInitParams& initParams, bool genMipmaps)
+    {
+        auto hdriFile = assetPath + "HDRI/" + initParams.fileName;
+        auto cacheFolder = assetPath + "Cache/Textures/";
+        auto bakingPath = assetPath + "Core/Shaders/Baking/";
+
+        // keyed by the HDRI, the baking shaders and the parameters. A hit skips decoding the HDRI too
+        uint64_t settings = 14695981039346656037ull;
+        auto mix = [&settings](const void* data, size_t size)
+            {
+                auto bytes = static_cast<const uint8_t*>(data);
+                for (size_t i = 0; i < size; ++i)
+                {
+                    settings ^= bytes[i];
+                    settings *= 1099511628211ull;
+                }
+            };
+        mix(&initParams.compressionThreshold, sizeof(initParams.compressionThreshold));
+        mix(&initParams.maxValue, sizeof(initParams.maxValue));
+        mix(&initParams.irradianceMapSize, sizeof(initParams.irradianceMapSize));
+        mix(&initParams.prefilteredMapSize, sizeof(initParams.prefilteredMapSize));
+        mix(&initParams.prefilteredSamples, sizeof(initParams.prefilteredSamples));
+        mix(&genMipmaps, sizeof(genMipmaps));
+
+        std::vector<std::string> sources = { hdriFile, bakingPath + "equirectangular_to_cubemap_frag.glsl",
+            bakingPath + "irradiance_frag.glsl", bakingPath + "prefiltered_env_map_frag.glsl" };
+        auto stem = std::filesystem::path(initParams.fileName).stem().string();
+        auto skyPath = CubemapBaker::BakeCachePath(cacheFolder, stem + "_sky", sources, settings);
+        auto irradiancePath = CubemapBaker::BakeCachePath(cacheFolder, stem + "_irradiance", sources, settings);
+        auto prefilteredPath = CubemapBaker::BakeCachePath(cacheFolder, stem + "_prefiltered", sources, settings);
+        auto brdfPath = CubemapBaker::BRDFLUTCachePath(assetPath, 512, 1024);
+
+        m_hdriSky = CubemapBaker::LoadBake(skyPath);
+        m_irradianceMap = CubemapBaker::LoadBake(irradiancePath);
+        m_prefilteredMap = CubemapBaker::LoadBake(prefilteredPath);
+        m_brdfLUTMap = CubemapBaker::LoadBake(brdfPath);
+        if (m_hdriSky > 0 && m_irradianceMap > 0 && m_prefilteredMap > 0 && m_brdfLUTMap > 0)
+        {
+            std::cout << "Using baked sky cache for " << initParams.fileName << std::endl;
+            return;
+        }
+        DeleteTextures();
+
+        TextureReader::LoadTexture(hdriFile, m_hdriSkyImageData, 0);
+        int cubemapSize = m_hdriSkyImageData.width / 4;
+
+        CubemapBaker baker(assetPath, m_resourceLoader);
+
+        m_hdriSky = baker.HDRtoCubemap(m_hdriSkyImageData, cubemapSize, genMipmaps, initParams.compressionThreshold, initParams.maxValue);
+        m_irradianceMap = baker.GenerateIrradianceCubemap(m_hdriSky, initParams.irradianceMapSize);
+        m_prefilteredMap = baker.GeneratePrefilteredEnvMap(m_hdriSky, initParams.prefilteredMapSize, initParams.prefilteredSamples);
+        m_brdfLUTMap = baker.GenerateBRDFLUT(512, 1024);
+
+        // the sky is kept as half floats, the rest are baked in them already
+        CubemapBaker::SaveBake(m_hdriSky, KTX2Format::RGB16_SFLOAT, skyPath);
+        CubemapBaker::SaveBake(m_irradianceMap, KTX2Format::RGB16_SFLOAT, irradiancePath);
+        CubemapBaker::SaveBake(m_prefilteredMap, KTX2Format::RGB16_SFLOAT, prefilteredPath);
+        CubemapBaker::SaveBake(m_brdfLUTMap, KTX2Format::RG16_SFLOAT, brdfPath);
 
         m_hdriSkyImageData.hdrData.clear();
     }
@@ -43,6 +43,8 @@ namespace JLEngine
 
 	protected:
 
+		// Loads the maps from the bake cache or bakes them and fills the cache
+		void Bake(const std::string& assetPath, const HdriSkyInitParams& initParams, bool genMipmaps);
 		void DeleteTextures();
 
 		uint32_t m_hdriSky			= 0;
@@ -0,0 +1,401 @@
+#include "ImageConversion.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JL_IMAGE_SSE
+#include <emmintrin.h>
+#endif
+
+// pshufb for the 8 bit swizzle and the hardware half conversion, MSVC only says so through /arch
+#if defined(JL_IMAGE_SSE) && (defined(__SSSE3__) || defined(__AVX__))
+#define JL_IMAGE_SSSE3
+#include <tmmintrin.h>
+#endif
+#if defined(JL_IMAGE_SSE) && (defined(__F16C__) || defined(__AVX2__))
+#define JL_IMAGE_F16C
+#include <immintrin.h>
+#endif
+
+namespace JLEngine
+{
+	namespace
+	{
+		constexpr float InvUnorm8 = 1.0f / 255.0f;
+
+		uint32_t FloatBits(float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		float BitsFloat(uint32_t bits)
+		{
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		float SRGBToLinear(float c)
+		{
+			return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float LinearToSRGB(float c)
+		{
+			return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+		}
+
+		const std::array<float, 256>& SRGBTable()
+		{
+			static const std::array<float, 256> table = []()
+				{
+					std::array<float, 256> values{};
+					for (int i = 0; i < 256; ++i) values[i] = SRGBToLinear(i / 255.0f);
+					return values;
+				}();
+			return table;
+		}
+
+		// Linear to sRGB as a straight line per eighth of an octave from 2^-13 to 1, indexed by the
+		// exponent and the top 3 mantissa bits with the next 8 placing the value along the line.
+		// Below 2^-13 everything rounds to 0 anyway
+		constexpr uint32_t EncodeMinBits = (127 - 13) << 23;
+		constexpr uint32_t EncodeMaxBits = 0x3F7FFFFF;		// the float below 1
+		constexpr int EncodeBuckets = 13 * 8;
+
+		struct SRGBEncodeTable
+		{
+			std::array<float, EncodeBuckets> start{};
+			std::array<float, EncodeBuckets> slope{};
+		};
+
+		const SRGBEncodeTable& EncodeTable()
+		{
+			static const SRGBEncodeTable table = []()
+				{
+					SRGBEncodeTable values;
+					for (int i = 0; i < EncodeBuckets; ++i)
+					{
+						float x0 = BitsFloat(EncodeMinBits + (uint32_t(i) << 20));
+						float x1 = BitsFloat(EncodeMinBits + (uint32_t(i + 1) << 20));
+						values.start[i] = 255.0f * LinearToSRGB(x0);
+						values.slope[i] = 255.0f * (LinearToSRGB(x1) - LinearToSRGB(x0)) / 256.0f;
+					}
+					return values;
+				}();
+			return table;
+		}
+
+		uint8_t EncodeSRGB(float value, const SRGBEncodeTable& table)
+		{
+			// NaN falls to the bottom like it does in _mm_max_ps
+			uint32_t bits = value > BitsFloat(EncodeMinBits) ? std::min(FloatBits(value), EncodeMaxBits) : EncodeMinBits;
+			uint32_t bucket = (bits - EncodeMinBits) >> 20;
+			float t = static_cast<float>((bits >> 12) & 0xFF);
+			return static_cast<uint8_t>(static_cast<int>(table.start[bucket] + table.slope[bucket] * t + 0.5f));
+		}
+
+		uint8_t EncodeUnorm(float value)
+		{
+			float clamped = value > 0.0f ? std::min(value, 1.0f) : 0.0f;
+			return static_cast<uint8_t>(static_cast<int>(clamped * 255.0f + 0.5f));
+		}
+
+#if defined(JL_IMAGE_SSE)
+		// 4 floats to halves in the low 16 bits of each lane, sign extended so _mm_packs_epi32 keeps them
+		__m128i FloatToHalf4(__m128 value)
+		{
+#if defined(JL_IMAGE_F16C)
+			return _mm_srai_epi32(_mm_slli_epi32(_mm_cvtepu16_epi32(_mm_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT)), 16), 16);
+#else
+			const __m128i signMask = _mm_set1_epi32(static_cast<int>(0x80000000u));
+			const __m128i halfMax = _mm_set1_epi32((127 + 16) << 23);
+			const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+			const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+			const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+			__m128 sign = _mm_and_ps(_mm_castsi128_ps(signMask), value);
+			__m128 absValue = _mm_xor_ps(value, sign);
+			__m128i absBits = _mm_castps_si128(absValue);
+
+			__m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absValue, absValue));
+			__m128i isRegular = _mm_cmpgt_epi32(halfMax, absBits);
+			__m128i special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+			// subnormal results are rounded by the float add
+			__m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+			__m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absValue, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+			// normal results rebias the exponent and round to even on the dropped mantissa bits
+			__m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+			__m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absBits, normalBias), mantissaOdd), 13);
+
+			__m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+			__m128i result = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, special));
+			return _mm_or_si128(result, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+#endif
+		}
+#endif
+	}
+
+	void ImageConversion::SRGBToLinear(const uint8_t* src, float* dst, size_t pixels, int channels)
+	{
+		const auto& table = SRGBTable();
+		if (channels == 4)
+		{
+			for (size_t i = 0; i < pixels; ++i, src += 4, dst += 4)
+			{
+				dst[0] = table[src[0]];
+				dst[1] = table[src[1]];
+				dst[2] = table[src[2]];
+				dst[3] = src[3] * InvUnorm8;
+			}
+			return;
+		}
+
+		size_t count = pixels * channels;
+		for (size_t i = 0; i < count; ++i)
+			dst[i] = table[src[i]];
+	}
+
+	void ImageConversion::LinearToSRGB(const float* src, uint8_t* dst, size_t pixels, int channels)
+	{
+		const auto& table = EncodeTable();
+		size_t count = pixels * channels;
+		size_t i = 0;
+
+#if defined(JL_IMAGE_SSE)
+		// 4 floats a step, for RGBA that's one pixel so the alpha is always lane 3
+		const __m128i alphaLane = channels == 4 ? _mm_set_epi32(-1, 0, 0, 0) : _mm_setzero_si128();
+		const __m128 minValue = _mm_castsi128_ps(_mm_set1_epi32(EncodeMinBits));
+		const __m128 maxValue = _mm_castsi128_ps(_mm_set1_epi32(EncodeMaxBits));
+		const __m128i minBits = _mm_set1_epi32(EncodeMinBits);
+		const __m128i byteMask = _mm_set1_epi32(0xFF);
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 value = _mm_loadu_ps(src + i);
+
+			__m128 clamped = _mm_min_ps(_mm_max_ps(value, minValue), maxValue);
+			__m128i bits = _mm_castps_si128(clamped);
+			alignas(16) uint32_t bucket[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(bucket), _mm_srli_epi32(_mm_sub_epi32(bits, minBits), 20));
+			__m128 start = _mm_setr_ps(table.start[bucket[0]], table.start[bucket[1]], table.start[bucket[2]], table.start[bucket[3]]);
+			__m128 slope = _mm_setr_ps(table.slope[bucket[0]], table.slope[bucket[1]], table.slope[bucket[2]], table.slope[bucket[3]]);
+			__m128 t = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(bits, 12), byteMask));
+			__m128 encoded = _mm_add_ps(_mm_add_ps(start, _mm_mul_ps(slope, t)), half);
+
+			__m128 alpha = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+			alpha = _mm_add_ps(_mm_mul_ps(alpha, _mm_set1_ps(255.0f)), half);
+
+			__m128 result = _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(alphaLane), alpha), _mm_andnot_ps(_mm_castsi128_ps(alphaLane), encoded));
+			__m128i packed = _mm_cvttps_epi32(result);
+			packed = _mm_packus_epi16(_mm_packs_epi32(packed, packed), packed);
+			int bytes = _mm_cvtsi128_si32(packed);
+			std::memcpy(dst + i, &bytes, 4);
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			bool isAlpha = channels == 4 && (i & 3) == 3;
+			dst[i] = isAlpha ? EncodeUnorm(src[i]) : EncodeSRGB(src[i], table);
+		}
+	}
+
+	void ImageConversion::UnormToFloat(const uint8_t* src, float* dst, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(JL_IMAGE_SSE)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scale = _mm_set1_ps(InvUnorm8);
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			__m128i low = _mm_unpacklo_epi8(bytes, zero);
+			__m128i high = _mm_unpackhi_epi8(bytes, zero);
+			_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+			_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+			_mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+			_mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+		}
+#endif
+
+		for (; i < count; ++i)
+			dst[i] = src[i] * InvUnorm8;
+	}
+
+	void ImageConversion::FloatToUnorm(const float* src, uint8_t* dst, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(JL_IMAGE_SSE)
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i packed[4];
+			for (int j = 0; j < 4; ++j)
+			{
+				// max first so NaN turns into 0 like the scalar path
+				__m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + j * 4), _mm_setzero_ps()), one);
+				packed[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+			}
+			__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(packed[0], packed[1]), _mm_packs_epi32(packed[2], packed[3]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bytes);
+		}
+#endif
+
+		for (; i < count; ++i)
+			dst[i] = EncodeUnorm(src[i]);
+	}
+
+	void ImageConversion::ExpandRGBToRGBA(const uint8_t* src, uint8_t* dst, size_t pixels, uint8_t alpha)
+	{
+		size_t i = 0;
+
+#if defined(JL_IMAGE_SSSE3)
+		// 16 bytes are read for 12, so the last few pixels go through the scalar loop
+		const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i alphaBytes = _mm_set1_epi32(static_cast<int>(uint32_t(alpha) << 24));
+		for (; i + 6 <= pixels; i += 4)
+		{
+			__m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alphaBytes));
+		}
+#endif
+
+		for (; i < pixels; ++i)
+		{
+			dst[i * 4 + 0] = src[i * 3 + 0];
+			dst[i * 4 + 1] = src[i * 3 + 1];
+			dst[i * 4 + 2] = src[i * 3 + 2];
+			dst[i * 4 + 3] = alpha;
+		}
+	}
+
+	void ImageConversion::ExpandRGBToRGBA(const float* src, float* dst, size_t pixels, float alpha)
+	{
+		size_t i = 0;
+
+#if defined(JL_IMAGE_SSE)
+		// 4 pixels are 3 loads: r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3
+		const __m128 alphas = _mm_set1_ps(alpha);
+		for (; i + 4 <= pixels; i += 4)
+		{
+			__m128 a = _mm_loadu_ps(src + i * 3);
+			__m128 b = _mm_loadu_ps(src + i * 3 + 4);
+			__m128 c = _mm_loadu_ps(src + i * 3 + 8);
+
+			__m128 a2 = _mm_shuffle_ps(a, alphas, _MM_SHUFFLE(0, 0, 2, 2));		// b0 b0 A A
+			__m128 a3 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 3, 3));			// r1 r1 g1 g1
+			__m128 b1 = _mm_shuffle_ps(b, alphas, _MM_SHUFFLE(0, 0, 1, 1));		// b1 b1 A A
+			__m128 c0 = _mm_shuffle_ps(c, alphas, _MM_SHUFFLE(0, 0, 0, 0));		// b2 b2 A A
+			__m128 c3 = _mm_shuffle_ps(c, alphas, _MM_SHUFFLE(0, 0, 3, 3));		// b3 b3 A A
+
+			float* out = dst + i * 4;
+			_mm_storeu_ps(out, _mm_shuffle_ps(a, a2, _MM_SHUFFLE(2, 0, 1, 0)));
+			_mm_storeu_ps(out + 4, _mm_shuffle_ps(a3, b1, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(out + 8, _mm_shuffle_ps(b, c0, _MM_SHUFFLE(2, 0, 3, 2)));
+			_mm_storeu_ps(out + 12, _mm_shuffle_ps(c, c3, _MM_SHUFFLE(2, 0, 2, 1)));
+		}
+#endif
+
+		for (; i < pixels; ++i)
+		{
+			dst[i * 4 + 0] = src[i * 3 + 0];
+			dst[i * 4 + 1] = src[i * 3 + 1];
+			dst[i * 4 + 2] = src[i * 3 + 2];
+			dst[i * 4 + 3] = alpha;
+		}
+	}
+
+	void ImageConversion::FloatToHalf(const float* src, uint16_t* dst, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(JL_IMAGE_SSE)
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i low = FloatToHalf4(_mm_loadu_ps(src + i));
+			__m128i high = FloatToHalf4(_mm_loadu_ps(src + i + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(low, high));
+		}
+#endif
+
+		for (; i < count; ++i)
+			dst[i] = FloatToHalf(src[i]);
+	}
+
+	uint16_t ImageConversion::FloatToHalf(float value)
+	{
+		uint32_t bits = FloatBits(value);
+		uint32_t sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		uint32_t half;
+		if (bits >= (127u + 16u) << 23)
+		{
+			half = bits > 0x7F800000u ? 0x7E00u : 0x7C00u;
+		}
+		else if (bits < (127u - 14u) << 23)
+		{
+			const uint32_t magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+			half = FloatBits(BitsFloat(bits) + BitsFloat(magic)) - magic;
+		}
+		else
+		{
+			uint32_t mantissaOdd = (bits >> 13) & 1u;
+			half = (bits + 0xFFFu - ((127u - 15u) << 23) + mantissaOdd) >> 13;
+		}
+		return static_cast<uint16_t>(half | (sign >> 16));
+	}
+
+	float ImageConversion::HalfToFloat(uint16_t value)
+	{
+		uint32_t sign = uint32_t(value & 0x8000u) << 16;
+		uint32_t exponent = (value >> 10) & 0x1Fu;
+		uint32_t mantissa = value & 0x3FFu;
+
+		if (exponent == 0)
+		{
+			float magnitude = static_cast<float>(mantissa) * BitsFloat((127u - 24u) << 23);
+			return BitsFloat(FloatBits(magnitude) | sign);
+		}
+		if (exponent == 31)
+			return BitsFloat(sign | 0x7F800000u | (mantissa << 13));
+		return BitsFloat(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+	}
+
+	void ImageConversion::FlipVertical(void* pixels, size_t rowBytes, size_t rows)
+	{
+		auto* bytes = static_cast<uint8_t*>(pixels);
+		for (size_t y = 0; y < rows / 2; ++y)
+		{
+			uint8_t* top = bytes + y * rowBytes;
+			uint8_t* bottom = bytes + (rows - 1 - y) * rowBytes;
+			size_t x = 0;
+
+#if defined(JL_IMAGE_SSE)
+			for (; x + 16 <= rowBytes; x += 16)
+			{
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(top + x), b);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(bottom + x), a);
+			}
+#endif
+
+			for (; x < rowBytes; ++x)
+				std::swap(top[x], bottom[x]);
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef IMAGE_CONVERSION_H
+#define IMAGE_CONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace JLEngine
+{
+	// Pixel conversions for decoded images, each writes into memory the caller owns. The SIMD
+	// paths give the same results as the scalar ones so a build without them loads the same pixels
+	class ImageConversion
+	{
+	public:
+		// 8 bit sRGB to linear floats through a table, the fastest way for 256 inputs. With 4
+		// channels the alpha is only rescaled
+		static void SRGBToLinear(const uint8_t* src, float* dst, size_t pixels, int channels);
+		// Linear floats to the nearest 8 bit sRGB value within 0.15, exact for every value that
+		// came from SRGBToLinear. With 4 channels the alpha is only rescaled
+		static void LinearToSRGB(const float* src, uint8_t* dst, size_t pixels, int channels);
+		// 0..255 to 0..1
+		static void UnormToFloat(const uint8_t* src, float* dst, size_t count);
+		// Clamped to 0..1 and rounded, NaN becomes 0
+		static void FloatToUnorm(const float* src, uint8_t* dst, size_t count);
+
+		// RGB to RGBA with a constant alpha
+		static void ExpandRGBToRGBA(const uint8_t* src, uint8_t* dst, size_t pixels, uint8_t alpha = 255);
+		static void ExpandRGBToRGBA(const float* src, float* dst, size_t pixels, float alpha = 1.0f);
+
+		// Rounds to nearest even, values past the half range become infinity and NaNs stay NaNs
+		static void FloatToHalf(const float* src, uint16_t* dst, size_t count);
+		static uint16_t FloatToHalf(float value);
+		static float HalfToFloat(uint16_t value);
+
+		// Swaps the rows top to bottom in place
+		static void FlipVertical(void* pixels, size_t rowBytes, size_t rows);
+	};
+}
+
+#endif
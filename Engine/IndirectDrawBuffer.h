@@ -19,6 +19,8 @@ namespace JLEngine
 		glm::mat4 modelMatrix;			// 64 bytes
 		uint32_t materialID;			// 4 bytes
 		uint32_t baseJointIndex;
+		uint32_t bakedClip;				// 1 + index of a baked clip to play instead of the joint palette, 0 for none
+		float bakedTimeOffset;			// added to the global time when playing the baked clip
 	};
 
 	struct DrawIndirectCommand
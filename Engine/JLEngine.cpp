@@ -2,10 +2,12 @@
 #include "GraphicsAPI.h"
 #include "ShaderStorageBuffer.h"
 #include "DeferredRenderer.h"
+#include "TransformHierarchy.h"
 
 #include <iostream> 
 #include <thread>
 #include <chrono>
+#include <filesystem>
 
 #include <glm/gtx/matrix_decompose.hpp>
 #include "UIHelperFunctions.h"
@@ -30,16 +32,21 @@ namespace JLEngine
         m_resourceLoader = new ResourceLoader(Graphics::API());
 
         m_resourceLoader->SetHotReloading(true);
+        m_resourceLoader->SetMeshCacheFolder(assetFolder + "Cache/Meshes/");
         m_input->SetRawMouseMotion(true);
         setVsync(true);
 
         Graphics::API()->DumpInfo();
 
         m_renderer = new DeferredRenderer(Graphics::API(), m_resourceLoader, windowWidth, windowHeight, assetFolder);
+        m_assetStreamer = std::make_unique<AssetStreamer>(m_resourceLoader, m_renderer, JobSystem::Global());
     }
 
     JLEngineCore::~JLEngineCore()
     {
+        // finish the imports still on workers before anything they point at goes
+        m_assetStreamer.reset();
+
         m_im3dManager.Shutdown();
         m_imguiManager.Shutdown();
 
@@ -74,6 +81,10 @@ namespace JLEngine
         float fps = 0.0f;
         double frameTimeAccumulator = 0.0;
 
+        // an app that only streams never has a point where loading is done
+        if (!m_loadingFinalized)
+            FinalizeLoading();
+
         SceneManager& sceneManager = m_renderer->GetSceneManager();
         auto frustum = m_flyCamera->GetViewFrustum();
 
@@ -110,6 +121,12 @@ namespace JLEngine
                 m_fixedUpdateCount++;   
             }
 
+            // Merge finished background loads within the frame budget, their nodes join this frame's transform pass
+            m_assetStreamer->Update();
+
+            // Resolve every transform edited this frame in one pass before anything reads world matrices
+            TransformHierarchy::Global().Update();
+
             if (frameTimeAccumulator >= 1.0)
             {
                 fps = (float)m_frameCount;
@@ -164,7 +181,7 @@ namespace JLEngine
     std::shared_ptr<Node> JLEngineCore::LoadAndAttachToRoot(const std::string& fileName, const glm::vec3& pos)
     {
         auto node = m_resourceLoader->LoadGLB(fileName);
-        node->translation = pos;
+        node->SetTranslation(pos);
         m_renderer->SceneRoot()->AddChild(node);
         return node;
     }
@@ -172,9 +189,7 @@ namespace JLEngine
     std::shared_ptr<Node> JLEngineCore::LoadAndAttachToRoot(const std::string& fileName, const glm::vec3& pos, const glm::quat& rotation, const glm::vec3& scale)
     {
         auto node = m_resourceLoader->LoadGLB(fileName);
-        node->translation = pos;
-        node->rotation = rotation;
-        node->scale = scale;
+        node->SetTRS(pos, rotation, scale);
         m_renderer->SceneRoot()->AddChild(node);
         return node;
     }
@@ -182,13 +197,33 @@ namespace JLEngine
     std::shared_ptr<Node> JLEngineCore::LoadAndAttachToRoot(const std::string& fileName, const glm::mat4& transform)
     {
         auto node = m_resourceLoader->LoadGLB(fileName);
-        glm::vec3 skew;
+        glm::vec3 translation, scale, skew;
+        glm::quat rotation;
         glm::vec4 perspective;
-        glm::decompose(transform, node->scale, node->rotation, node->translation, skew, perspective);
+        glm::decompose(transform, scale, rotation, translation, skew, perspective);
+        node->SetTRS(translation, rotation, scale);
         m_renderer->SceneRoot()->AddChild(node);
         return node;
     }
 
+    std::shared_ptr<AssetLoadHandle> JLEngineCore::LoadAsync(const std::string& fileName, AssetLoadCallback onLoaded)
+    {
+        return m_assetStreamer->Load(fileName, nullptr, std::move(onLoaded));
+    }
+
+    std::shared_ptr<AssetLoadHandle> JLEngineCore::LoadAsync(const std::string& fileName, const glm::vec3& pos, AssetLoadCallback onLoaded)
+    {
+        return LoadAsync(fileName, pos, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f), std::move(onLoaded));
+    }
+
+    std::shared_ptr<AssetLoadHandle> JLEngineCore::LoadAsync(const std::string& fileName, const glm::vec3& pos, const glm::quat& rotation, const glm::vec3& scale, AssetLoadCallback onLoaded)
+    {
+        auto placeholder = std::make_shared<Node>(std::filesystem::path(fileName).stem().string());
+        placeholder->SetTRS(pos, rotation, scale);
+        m_renderer->GetSceneManager().AddNode(placeholder);
+        return m_assetStreamer->Load(fileName, placeholder, std::move(onLoaded));
+    }
+
     std::shared_ptr<Node> JLEngineCore::MakeInstanceOf(std::shared_ptr<Node>& existingNode, const glm::vec3& pos, bool attachToRoot)
     {
         auto& submesh = existingNode->mesh->GetSubmesh(0);
@@ -230,9 +265,7 @@ namespace JLEngine
         if (parentLocked && parentLocked->tag == NodeTag::SceneRoot)
         {
             // The mesh is in the SceneRoot, no parent hierarchy needed
-            newNode->translation = pos;
-            newNode->rotation = existingNode->rotation;
-            newNode->scale = existingNode->scale;
+            newNode->SetTRS(pos, existingNode->GetRotation(), existingNode->GetScale());
 
             // Recursively clone child nodes
             CloneChildNodes(existingNode, newNode);
@@ -254,9 +287,7 @@ namespace JLEngine
             auto newParent = std::make_shared<Node>(currentOriginal->name + "_inst");
 
             // Copy Transform Data
-            newParent->translation = currentOriginal->translation;
-            newParent->rotation = currentOriginal->rotation;
-            newParent->scale = currentOriginal->scale;
+            newParent->SetTRS(currentOriginal->GetTranslation(), currentOriginal->GetRotation(), currentOriginal->GetScale());
             newParent->tag = currentOriginal->tag;
 
             // Attach the last created node as its child
@@ -274,13 +305,11 @@ namespace JLEngine
         // Step 4: Apply Position Offset **Only to the Top-Most Parent**
         if (rootInstance)
         {
-            rootInstance->translation += pos;
-            rootInstance->localMatrix = glm::translate(glm::mat4(1.0f), rootInstance->translation);
+            rootInstance->SetTranslation(rootInstance->GetTranslation() + pos);
         }
         else
         {
-            newNode->translation += pos;
-            newNode->localMatrix = glm::translate(glm::mat4(1.0f), newNode->translation);
+            newNode->SetTranslation(newNode->GetTranslation() + pos);
         }
 
         // Step 5: Attach to the scene root if requested
@@ -300,9 +329,7 @@ namespace JLEngine
             auto clonedChild = std::make_shared<Node>(child->name + "_inst");
 
             // Copy Transform Data
-            clonedChild->translation = child->translation;
-            clonedChild->rotation = child->rotation;
-            clonedChild->scale = child->scale;
+            clonedChild->SetTRS(child->GetTranslation(), child->GetRotation(), child->GetScale());
             clonedChild->tag = child->tag;
 
             // Clone Mesh and Animation (if applicable)
@@ -342,6 +369,7 @@ namespace JLEngine
             m_renderer->AddVAO(JLEngine::VAOType::DYNAMIC, skinnedMeshVAOs.begin()->first, skinnedMeshVAOs.begin()->second);
         m_renderer->GenerateGPUBuffers();
         m_renderer->LateInitialize();
+        m_loadingFinalized = true;
     }
 
     GraphicsAPI* JLEngineCore::GetGraphicsAPI() const
@@ -360,6 +388,10 @@ namespace JLEngine
     {
         return m_renderer;
     }
+    AssetStreamer* JLEngineCore::GetAssetStreamer() const
+    {
+        return m_assetStreamer.get();
+    }
 
     FlyCamera* JLEngineCore::GetFlyCamera()
     {
@@ -11,6 +11,7 @@
 #include "IMGuiManager.h"
 #include "Im3dManager.h"
 #include "FlyCamera.h"
+#include "AssetStreamer.h"
 
 namespace JLEngine
 {
@@ -30,6 +31,11 @@ namespace JLEngine
         std::shared_ptr<Node> LoadAndAttachToRoot(const std::string& fileName, const glm::vec3& pos);
         std::shared_ptr<Node> LoadAndAttachToRoot(const std::string& fileName, const glm::vec3& pos, const glm::quat& rotation, const glm::vec3& scale);
         std::shared_ptr<Node> LoadAndAttachToRoot(const std::string& fileName, const glm::mat4& transform);
+        // Streamed versions of LoadAndAttachToRoot. The returned handle's placeholder node is in the scene
+        // straight away, the file's nodes appear under it once the background import has been merged
+        std::shared_ptr<AssetLoadHandle> LoadAsync(const std::string& fileName, AssetLoadCallback onLoaded = nullptr);
+        std::shared_ptr<AssetLoadHandle> LoadAsync(const std::string& fileName, const glm::vec3& pos, AssetLoadCallback onLoaded = nullptr);
+        std::shared_ptr<AssetLoadHandle> LoadAsync(const std::string& fileName, const glm::vec3& pos, const glm::quat& rotation, const glm::vec3& scale, AssetLoadCallback onLoaded = nullptr);
         std::shared_ptr<Node> MakeInstanceOf(std::shared_ptr<Node>& existingNode, const glm::vec3& pos, bool attachToRoot);        
         void FinalizeLoading();
 
@@ -37,6 +43,7 @@ namespace JLEngine
         Input* GetInput()                       const;
         ResourceLoader* GetResourceLoader()     const;
         DeferredRenderer* GetRenderer()         const;
+        AssetStreamer* GetAssetStreamer()       const;
 
         FlyCamera* GetFlyCamera();
 
@@ -58,6 +65,8 @@ namespace JLEngine
 
         std::string m_assetFolder;
         DeferredRenderer* m_renderer;
+        std::unique_ptr<AssetStreamer> m_assetStreamer;
+        bool m_loadingFinalized = false;
 
         FlyCamera* m_flyCamera;
 
@@ -0,0 +1,155 @@
+#include "JobSystem.h"
+
+namespace JLEngine
+{
+	namespace
+	{
+		thread_local unsigned t_threadIndex = 0;
+		// set while a background job runs so the jobs it submits inherit the priority
+		thread_local bool t_inBackground = false;
+		// the job tree of the background job running on this thread, 0 outside one
+		thread_local uint64_t t_tree = 0;
+	}
+
+	JobSystem::JobSystem(unsigned workerCount)
+	{
+		if (workerCount == HardwareWorkers)
+		{
+			unsigned hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+		}
+
+		m_workers.reserve(workerCount);
+		for (unsigned i = 0; i < workerCount; ++i)
+		{
+			m_workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_wake.notify_all();
+
+		for (auto& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	JobSystem& JobSystem::Global()
+	{
+		static JobSystem jobSystem;
+		return jobSystem;
+	}
+
+	unsigned JobSystem::CurrentThreadIndex()
+	{
+		return t_threadIndex;
+	}
+
+	void JobSystem::Submit(std::function<void()> job, JobCounter* counter)
+	{
+		if (counter) counter->pending.fetch_add(1);
+		Enqueue(Job{ std::move(job), counter, t_inBackground, t_inBackground ? t_tree : 0 });
+	}
+
+	void JobSystem::SubmitBackground(std::function<void()> job, JobCounter* counter)
+	{
+		if (counter) counter->pending.fetch_add(1);
+		uint64_t tree = t_inBackground ? t_tree : m_nextTree.fetch_add(1);
+		Enqueue(Job{ std::move(job), counter, true, tree });
+	}
+
+	void JobSystem::Enqueue(Job job)
+	{
+		// no workers, run it now rather than leave it for a Wait that may never come
+		if (m_workers.empty())
+		{
+			Run(job);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			(job.background ? m_backgroundQueue : m_queue).push_back(std::move(job));
+		}
+		m_wake.notify_one();
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		while (counter.pending.load() > 0)
+		{
+			if (!TryRunOne(counter))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::WorkerLoop(unsigned threadIndex)
+	{
+		t_threadIndex = threadIndex;
+
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [this]() { return m_stopping || !m_queue.empty() || !m_backgroundQueue.empty(); });
+				if (m_queue.empty() && m_backgroundQueue.empty()) return; // stopping and drained
+
+				auto& queue = m_queue.empty() ? m_backgroundQueue : m_queue;
+				job = std::move(queue.front());
+				queue.pop_front();
+			}
+			Run(job);
+		}
+	}
+
+	bool JobSystem::TryRunOne(const JobCounter& waitingOn)
+	{
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_queue.empty())
+			{
+				job = std::move(m_queue.front());
+				m_queue.pop_front();
+			}
+			else
+			{
+				// the background queue is whole file loads and texture reads, a waiting job only takes its own
+				// work so it isn't held up until some other load has finished
+				if (t_threadIndex == 0) return false;
+				auto it = std::find_if(m_backgroundQueue.begin(), m_backgroundQueue.end(), [&waitingOn](const Job& queued)
+					{
+						return queued.counter == &waitingOn || (t_inBackground && queued.tree == t_tree);
+					});
+				if (it == m_backgroundQueue.end()) return false;
+
+				job = std::move(*it);
+				m_backgroundQueue.erase(it);
+			}
+		}
+		Run(job);
+		return true;
+	}
+
+	void JobSystem::Run(Job& job)
+	{
+		// a background job waiting on its children may run a normal job in between, restore after
+		bool wasBackground = t_inBackground;
+		uint64_t wasTree = t_tree;
+		t_inBackground = job.background;
+		t_tree = job.tree;
+		job.work();
+		t_inBackground = wasBackground;
+		t_tree = wasTree;
+		if (job.counter) job.counter->pending.fetch_sub(1);
+	}
+}
\ No newline at end of file
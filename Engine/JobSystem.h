@@ -0,0 +1,135 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace JLEngine
+{
+	// Jobs submitted against the same counter, Wait on it to block until they have all run
+	struct JobCounter
+	{
+		std::atomic<uint32_t> pending{ 0 };
+	};
+
+	// Fixed pool of worker threads fed from one queue. The threads live as long as the system so
+	// per frame work doesn't pay for thread creation, and a thread that waits on a counter runs
+	// queued jobs instead of sleeping so nested waits can't deadlock.
+	class JobSystem
+	{
+	public:
+		// hardware_concurrency - 1 workers, the thread that waits is the last one
+		static constexpr unsigned HardwareWorkers = UINT32_MAX;
+
+		// 0 workers runs every job on the thread that submits it
+		explicit JobSystem(unsigned workerCount = HardwareWorkers);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// Pool shared by the engine
+		static JobSystem& Global();
+
+		// Workers plus the calling thread
+		unsigned GetThreadCount() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+		// 0 for threads outside the pool, 1..workers for the pool's own threads
+		static unsigned CurrentThreadIndex();
+
+		void Submit(std::function<void()> job, JobCounter* counter = nullptr);
+		// Runs after every queued normal job and only on the pool's threads, so a long streaming
+		// load can't be picked up by the render thread while it waits on a frame's ParallelFor.
+		// Jobs submitted from inside a background job are background too and belong to its job tree
+		void SubmitBackground(std::function<void()> job, JobCounter* counter = nullptr);
+		// Threads outside the pool only help with normal jobs, waiting there on background work spins.
+		// A pool thread helps with normal jobs and with the background jobs of the counter or of the
+		// job tree it's in, never an unrelated load that happens to be next in the queue
+		void Wait(JobCounter& counter);
+
+		// Runs fn(begin, end, threadIndex) over [0, count) in chunks of grain items, the calling
+		// thread takes part. threadIndex is below GetThreadCount() and no two chunks running at
+		// once share one, use it to pick per thread scratch memory
+		template <typename Fn>
+		void ParallelFor(size_t count, size_t grain, Fn&& fn);
+
+	private:
+		struct Job
+		{
+			std::function<void()> work;
+			JobCounter* counter = nullptr;
+			bool background = false;
+			// the top level background job this one came from, 0 for normal jobs
+			uint64_t tree = 0;
+		};
+
+		void Enqueue(Job job);
+		void WorkerLoop(unsigned threadIndex);
+		bool TryRunOne(const JobCounter& waitingOn);
+		void Run(Job& job);
+
+		std::vector<std::thread> m_workers;
+		std::deque<Job> m_queue;
+		std::deque<Job> m_backgroundQueue;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		bool m_stopping = false;
+		std::atomic<uint64_t> m_nextTree{ 1 };
+	};
+
+	template <typename Fn>
+	void JobSystem::ParallelFor(size_t count, size_t grain, Fn&& fn)
+	{
+		if (count == 0) return;
+
+		grain = std::max<size_t>(grain, 1);
+		size_t chunks = (count + grain - 1) / grain;
+		if (chunks == 1 || m_workers.empty())
+		{
+			fn(size_t(0), count, CurrentThreadIndex());
+			return;
+		}
+
+		// chunks are pulled from a shared cursor so uneven work balances itself, the jobs only
+		// capture a pointer to this so they fit std::function's small buffer
+		struct Range
+		{
+			Fn& fn;
+			size_t count;
+			size_t grain;
+			size_t chunks;
+			std::atomic<size_t> next{ 0 };
+
+			void Run()
+			{
+				unsigned threadIndex = CurrentThreadIndex();
+				for (size_t chunk = next.fetch_add(1); chunk < chunks; chunk = next.fetch_add(1))
+				{
+					size_t begin = chunk * grain;
+					fn(begin, std::min(begin + grain, count), threadIndex);
+				}
+			}
+		};
+
+		Range range{ fn, count, grain, chunks };
+		Range* shared = &range;
+		JobCounter counter;
+
+		size_t helpers = std::min<size_t>(chunks, GetThreadCount()) - 1;
+		for (size_t i = 0; i < helpers; ++i)
+		{
+			Submit([shared]() { shared->Run(); }, &counter);
+		}
+		range.Run();
+		Wait(counter);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,350 @@
+#include "KTX2File.h"
+#include "BinaryStream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+namespace JLEngine
+{
+	namespace
+	{
+		constexpr uint8_t Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+		// identifier, the nine header words and the index
+		constexpr uint32_t HeaderSize = 80;
+		constexpr uint32_t LevelIndexEntrySize = 24;
+
+		// --- DATA FORMAT DESCRIPTOR --- //
+		// Khronos Data Format basic descriptor block, only what the formats above need
+		enum DFDModel : uint8_t { ModelRGBSDA = 1, ModelBC1A = 128, ModelBC3 = 130, ModelBC4 = 131, ModelBC5 = 132, ModelBC6H = 133, ModelBC7 = 134 };
+		enum DFDQualifier : uint8_t { QualifierLinear = 0x10, QualifierSigned = 0x40, QualifierFloat = 0x80 };
+		constexpr uint8_t PrimariesBT709 = 1;
+		constexpr uint8_t TransferLinear = 1;
+		constexpr uint8_t TransferSRGB = 2;
+		constexpr uint8_t ChannelAlpha = 15;
+		constexpr uint32_t FloatOne = 0x3F800000;
+		constexpr uint32_t FloatMinusOne = 0xBF800000;
+
+		struct DFDSample
+		{
+			uint32_t bitOffset;
+			uint32_t bitLength;
+			uint8_t channel;
+			uint8_t qualifiers;
+			uint32_t lower;
+			uint32_t upper;
+		};
+
+		std::vector<DFDSample> DescribeSamples(KTX2Format format, const KTX2FormatInfo& info, uint8_t& model)
+		{
+			std::vector<DFDSample> samples;
+			uint8_t alphaQualifier = info.srgb ? QualifierLinear : 0;
+			switch (format)
+			{
+			case KTX2Format::BC1_RGB_UNORM:
+			case KTX2Format::BC1_RGB_SRGB:
+				model = ModelBC1A;
+				samples.push_back({ 0, 64, 0, 0, 0, 0xFFFFFFFF });
+				break;
+			case KTX2Format::BC1_RGBA_UNORM:
+			case KTX2Format::BC1_RGBA_SRGB:
+				model = ModelBC1A;
+				samples.push_back({ 0, 64, 1, 0, 0, 0xFFFFFFFF });
+				break;
+			case KTX2Format::BC3_UNORM:
+			case KTX2Format::BC3_SRGB:
+				model = ModelBC3;
+				samples.push_back({ 0, 64, ChannelAlpha, alphaQualifier, 0, 0xFFFFFFFF });
+				samples.push_back({ 64, 64, 0, 0, 0, 0xFFFFFFFF });
+				break;
+			case KTX2Format::BC4_UNORM:
+				model = ModelBC4;
+				samples.push_back({ 0, 64, 0, 0, 0, 0xFFFFFFFF });
+				break;
+			case KTX2Format::BC5_UNORM:
+				model = ModelBC5;
+				samples.push_back({ 0, 64, 0, 0, 0, 0xFFFFFFFF });
+				samples.push_back({ 64, 64, 1, 0, 0, 0xFFFFFFFF });
+				break;
+			case KTX2Format::BC6H_UFLOAT:
+				model = ModelBC6H;
+				samples.push_back({ 0, 128, 0, QualifierFloat, 0, FloatOne });
+				break;
+			case KTX2Format::BC7_UNORM:
+			case KTX2Format::BC7_SRGB:
+				model = ModelBC7;
+				samples.push_back({ 0, 128, 0, 0, 0, 0xFFFFFFFF });
+				break;
+			case KTX2Format::B10G11R11_UFLOAT:
+				model = ModelRGBSDA;
+				samples.push_back({ 0, 11, 0, QualifierFloat, 0, FloatOne });
+				samples.push_back({ 11, 11, 1, QualifierFloat, 0, FloatOne });
+				samples.push_back({ 22, 10, 2, QualifierFloat, 0, FloatOne });
+				break;
+			default:
+			{
+				model = ModelRGBSDA;
+				uint32_t bits = info.typeSize * 8;
+				for (uint32_t c = 0; c < info.channels; ++c)
+				{
+					uint8_t channel = c == 3 ? ChannelAlpha : static_cast<uint8_t>(c);
+					if (info.floatingPoint)
+						samples.push_back({ c * bits, bits, channel, QualifierSigned | QualifierFloat, FloatMinusOne, FloatOne });
+					else
+						samples.push_back({ c * bits, bits, channel, c == 3 ? alphaQualifier : uint8_t(0), 0, (1u << bits) - 1 });
+				}
+				break;
+			}
+			}
+			return samples;
+		}
+
+		// The total size word then one basic block
+		std::vector<uint32_t> BuildDFD(KTX2Format format, const KTX2FormatInfo& info)
+		{
+			uint8_t model = ModelRGBSDA;
+			auto samples = DescribeSamples(format, info, model);
+			uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+			std::vector<uint32_t> words;
+			words.push_back(4 + blockSize);
+			words.push_back(0);	// Khronos vendor, basic descriptor type
+			words.push_back(2u | (blockSize << 16));
+			words.push_back(model | (PrimariesBT709 << 8) | ((info.srgb ? TransferSRGB : TransferLinear) << 16));
+			words.push_back((info.blockWidth - 1) | ((info.blockHeight - 1) << 8));
+			words.push_back(info.blockBytes);
+			words.push_back(0);
+			for (const auto& sample : samples)
+			{
+				words.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (uint32_t(sample.channel | sample.qualifiers) << 24));
+				words.push_back(0);
+				words.push_back(sample.lower);
+				words.push_back(sample.upper);
+			}
+			return words;
+		}
+
+		// One entry naming the writer, each entry is padded to 4 bytes
+		std::vector<uint8_t> BuildKeyValueData()
+		{
+			const char key[] = "KTXwriter";
+			const char value[] = "JLEngine";
+			uint32_t length = sizeof(key) + sizeof(value);
+
+			std::vector<uint8_t> bytes(sizeof(length));
+			std::memcpy(bytes.data(), &length, sizeof(length));
+			bytes.insert(bytes.end(), key, key + sizeof(key));
+			bytes.insert(bytes.end(), value, value + sizeof(value));
+			bytes.resize((bytes.size() + 3) & ~size_t(3), 0);
+			return bytes;
+		}
+
+		uint64_t AlignUp(uint64_t value, uint64_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	KTX2FormatInfo KTX2File::GetFormatInfo(KTX2Format format)
+	{
+		// blockWidth, blockHeight, blockBytes, typeSize, channels, compressed, srgb, float
+		switch (format)
+		{
+		case KTX2Format::R8_UNORM:			return { 1, 1, 1, 1, 1, false, false, false };
+		case KTX2Format::RG8_UNORM:			return { 1, 1, 2, 1, 2, false, false, false };
+		case KTX2Format::RGB8_UNORM:		return { 1, 1, 3, 1, 3, false, false, false };
+		case KTX2Format::RGB8_SRGB:			return { 1, 1, 3, 1, 3, false, true, false };
+		case KTX2Format::RGBA8_UNORM:		return { 1, 1, 4, 1, 4, false, false, false };
+		case KTX2Format::RGBA8_SRGB:		return { 1, 1, 4, 1, 4, false, true, false };
+		case KTX2Format::R16_SFLOAT:		return { 1, 1, 2, 2, 1, false, false, true };
+		case KTX2Format::RG16_SFLOAT:		return { 1, 1, 4, 2, 2, false, false, true };
+		case KTX2Format::RGB16_SFLOAT:		return { 1, 1, 6, 2, 3, false, false, true };
+		case KTX2Format::RGBA16_SFLOAT:		return { 1, 1, 8, 2, 4, false, false, true };
+		case KTX2Format::R32_SFLOAT:		return { 1, 1, 4, 4, 1, false, false, true };
+		case KTX2Format::RG32_SFLOAT:		return { 1, 1, 8, 4, 2, false, false, true };
+		case KTX2Format::RGB32_SFLOAT:		return { 1, 1, 12, 4, 3, false, false, true };
+		case KTX2Format::RGBA32_SFLOAT:		return { 1, 1, 16, 4, 4, false, false, true };
+		case KTX2Format::B10G11R11_UFLOAT:	return { 1, 1, 4, 4, 3, false, false, true };
+		case KTX2Format::BC1_RGB_UNORM:		return { 4, 4, 8, 1, 3, true, false, false };
+		case KTX2Format::BC1_RGB_SRGB:		return { 4, 4, 8, 1, 3, true, true, false };
+		case KTX2Format::BC1_RGBA_UNORM:	return { 4, 4, 8, 1, 4, true, false, false };
+		case KTX2Format::BC1_RGBA_SRGB:		return { 4, 4, 8, 1, 4, true, true, false };
+		case KTX2Format::BC3_UNORM:			return { 4, 4, 16, 1, 4, true, false, false };
+		case KTX2Format::BC3_SRGB:			return { 4, 4, 16, 1, 4, true, true, false };
+		case KTX2Format::BC4_UNORM:			return { 4, 4, 8, 1, 1, true, false, false };
+		case KTX2Format::BC5_UNORM:			return { 4, 4, 16, 1, 2, true, false, false };
+		case KTX2Format::BC6H_UFLOAT:		return { 4, 4, 16, 1, 3, true, false, true };
+		case KTX2Format::BC7_UNORM:			return { 4, 4, 16, 1, 4, true, false, false };
+		case KTX2Format::BC7_SRGB:			return { 4, 4, 16, 1, 4, true, true, false };
+		default:							return {};
+		}
+	}
+
+	void KTX2Image::Allocate(KTX2Format imageFormat, uint32_t imageWidth, uint32_t imageHeight, uint32_t levelCount, uint32_t layerCount, uint32_t faceCount)
+	{
+		format = imageFormat;
+		width = imageWidth;
+		height = imageHeight;
+		layers = layerCount;
+		faces = faceCount;
+		mapped = nullptr;
+
+		levels.resize(levelCount);
+		uint64_t offset = 0;
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			levels[level].offset = offset;
+			levels[level].size = ImageSize(level) * std::max(layers, 1u) * faces;
+			offset += levels[level].size;
+		}
+		data.assign(static_cast<size_t>(offset), std::byte{ 0 });
+	}
+
+	uint64_t KTX2Image::ImageSize(size_t level) const
+	{
+		auto info = KTX2File::GetFormatInfo(format);
+		uint64_t blocksWide = (LevelWidth(level) + info.blockWidth - 1) / info.blockWidth;
+		uint64_t blocksHigh = (LevelHeight(level) + info.blockHeight - 1) / info.blockHeight;
+		return blocksWide * blocksHigh * info.blockBytes;
+	}
+
+	const std::byte* KTX2Image::ImageData(size_t level, uint32_t layer, uint32_t face) const
+	{
+		return LevelData(level) + (static_cast<uint64_t>(layer) * faces + face) * ImageSize(level);
+	}
+
+	std::byte* KTX2Image::MutableImageData(size_t level, uint32_t layer, uint32_t face)
+	{
+		return data.data() + levels[level].offset + (static_cast<uint64_t>(layer) * faces + face) * ImageSize(level);
+	}
+
+	bool KTX2File::Write(const std::string& path, const KTX2Image& image)
+	{
+		auto info = GetFormatInfo(image.format);
+		if (info.blockBytes == 0 || image.levels.empty() || image.width == 0 || image.height == 0 || (image.faces != 1 && image.faces != 6))
+			return false;
+
+		auto dfd = BuildDFD(image.format, info);
+		auto keyValues = BuildKeyValueData();
+		uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+		uint32_t dfdOffset = HeaderSize + LevelIndexEntrySize * levelCount;
+		uint32_t dfdLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+		uint32_t kvdOffset = dfdOffset + dfdLength;
+		uint32_t kvdLength = static_cast<uint32_t>(keyValues.size());
+
+		// the smallest level goes first so a reader can stream the chain in, each one starts on a
+		// multiple of the texel block size and of 4
+		uint64_t alignment = std::lcm<uint64_t>(info.blockBytes, 4);
+		std::vector<uint64_t> fileOffsets(levelCount);
+		uint64_t offset = kvdOffset + kvdLength;
+		for (uint32_t level = levelCount; level-- > 0;)
+		{
+			offset = AlignUp(offset, alignment);
+			fileOffsets[level] = offset;
+			offset += image.levels[level].size;
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) return false;
+
+		BinaryWriter writer(file);
+		writer.Bytes(Identifier, sizeof(Identifier));
+		writer.Value(static_cast<uint32_t>(image.format));
+		writer.Value(info.typeSize);
+		writer.Value(image.width);
+		writer.Value(image.height);
+		writer.Value(uint32_t(0));	// pixelDepth, no 3D textures
+		writer.Value(image.layers);
+		writer.Value(image.faces);
+		writer.Value(levelCount);
+		writer.Value(uint32_t(0));	// no supercompression
+
+		writer.Value(dfdOffset);
+		writer.Value(dfdLength);
+		writer.Value(kvdOffset);
+		writer.Value(kvdLength);
+		writer.Value(uint64_t(0));	// no supercompression global data
+		writer.Value(uint64_t(0));
+
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			writer.Value(fileOffsets[level]);
+			writer.Value(image.levels[level].size);
+			writer.Value(image.levels[level].size);
+		}
+
+		writer.Bytes(dfd.data(), dfdLength);
+		writer.Bytes(keyValues.data(), kvdLength);
+
+		for (uint32_t level = levelCount; level-- > 0;)
+		{
+			writer.Align(static_cast<size_t>(alignment));
+			writer.Bytes(image.LevelData(level), static_cast<size_t>(image.levels[level].size));
+		}
+		return writer.Good();
+	}
+
+	bool KTX2File::Open(const std::string& path)
+	{
+		Close();
+		if (!m_file.Open(path)) return false;
+
+		BinaryReader reader(m_file.Data(), m_file.Size());
+		const std::byte* identifier = reader.Bytes(sizeof(Identifier));
+		if (identifier == nullptr || std::memcmp(identifier, Identifier, sizeof(Identifier)) != 0)
+		{
+			Close();
+			return false;
+		}
+
+		auto format = static_cast<KTX2Format>(reader.Value<uint32_t>());
+		reader.Value<uint32_t>();	// typeSize, only matters to big endian readers
+		uint32_t width = reader.Value<uint32_t>();
+		uint32_t height = reader.Value<uint32_t>();
+		uint32_t depth = reader.Value<uint32_t>();
+		uint32_t layers = reader.Value<uint32_t>();
+		uint32_t faces = reader.Value<uint32_t>();
+		uint32_t levelCount = std::max(reader.Value<uint32_t>(), 1u);
+		uint32_t supercompression = reader.Value<uint32_t>();
+		for (int i = 0; i < 4; ++i) reader.Value<uint32_t>();	// dfd and kvd ranges
+		for (int i = 0; i < 2; ++i) reader.Value<uint64_t>();	// sgd range
+
+		auto info = GetFormatInfo(format);
+		if (!reader.Good() || info.blockBytes == 0 || supercompression != 0 || width == 0 || height == 0 || depth != 0 ||
+			(faces != 1 && faces != 6) || levelCount > 32)
+		{
+			Close();
+			return false;
+		}
+
+		m_image.format = format;
+		m_image.width = width;
+		m_image.height = height;
+		m_image.layers = layers;
+		m_image.faces = faces;
+		m_image.mapped = m_file.Data();
+		m_image.levels.resize(levelCount);
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			uint64_t byteOffset = reader.Value<uint64_t>();
+			uint64_t byteLength = reader.Value<uint64_t>();
+			reader.Value<uint64_t>();	// uncompressed length, the same without supercompression
+
+			uint64_t expected = m_image.ImageSize(level) * std::max(layers, 1u) * faces;
+			if (!reader.Good() || byteLength != expected || byteOffset > m_file.Size() || byteLength > m_file.Size() - byteOffset)
+			{
+				Close();
+				return false;
+			}
+			m_image.levels[level] = { byteOffset, byteLength };
+		}
+		return true;
+	}
+
+	void KTX2File::Close()
+	{
+		m_image = KTX2Image();
+		m_file.Close();
+	}
+}
@@ -0,0 +1,116 @@
+#ifndef KTX2_FILE_H
+#define KTX2_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace JLEngine
+{
+	// The formats the engine reads and writes, the values are the VkFormat ones KTX2 stores
+	enum class KTX2Format : uint32_t
+	{
+		Undefined = 0,
+		R8_UNORM = 9,
+		RG8_UNORM = 16,
+		RGB8_UNORM = 23,
+		RGB8_SRGB = 29,
+		RGBA8_UNORM = 37,
+		RGBA8_SRGB = 43,
+		R16_SFLOAT = 76,
+		RG16_SFLOAT = 83,
+		RGB16_SFLOAT = 90,
+		RGBA16_SFLOAT = 97,
+		R32_SFLOAT = 100,
+		RG32_SFLOAT = 103,
+		RGB32_SFLOAT = 106,
+		RGBA32_SFLOAT = 109,
+		B10G11R11_UFLOAT = 122,
+		BC1_RGB_UNORM = 131,
+		BC1_RGB_SRGB = 132,
+		BC1_RGBA_UNORM = 133,
+		BC1_RGBA_SRGB = 134,
+		BC3_UNORM = 137,
+		BC3_SRGB = 138,
+		BC4_UNORM = 139,
+		BC5_UNORM = 141,
+		BC6H_UFLOAT = 143,
+		BC7_UNORM = 145,
+		BC7_SRGB = 146
+	};
+
+	struct KTX2FormatInfo
+	{
+		uint32_t blockWidth = 1;	// 4 for the block compressed formats
+		uint32_t blockHeight = 1;
+		uint32_t blockBytes = 0;	// bytes per texel when uncompressed, 0 for unknown formats
+		uint32_t typeSize = 1;		// size of the component type, what KTX2 byte swaps by
+		uint32_t channels = 0;
+		bool compressed = false;
+		bool srgb = false;
+		bool floatingPoint = false;
+	};
+
+	struct KTX2Level
+	{
+		uint64_t offset = 0;	// from Data()
+		uint64_t size = 0;		// every layer and face of the level
+	};
+
+	// A 2D, array or cube texture with its mip chain as KTX2 lays it out: within a level the
+	// layers follow each other and each layer holds its faces. The pixels are either owned or
+	// point into a KTX2File mapping, so they can be handed to GL without a copy
+	struct KTX2Image
+	{
+		KTX2Format format = KTX2Format::Undefined;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t layers = 0;	// 0 for a texture that isn't an array
+		uint32_t faces = 1;		// 6 for a cube map
+		std::vector<KTX2Level> levels;
+		std::vector<std::byte> data;
+		const std::byte* mapped = nullptr;
+
+		// Sizes the levels for the format and zero fills the pixels
+		void Allocate(KTX2Format imageFormat, uint32_t imageWidth, uint32_t imageHeight, uint32_t levelCount, uint32_t layerCount = 0, uint32_t faceCount = 1);
+
+		bool IsCubemap() const { return faces == 6; }
+		bool IsArray() const { return layers > 0; }
+		uint32_t LevelWidth(size_t level) const { return width >> level > 0 ? width >> level : 1; }
+		uint32_t LevelHeight(size_t level) const { return height >> level > 0 ? height >> level : 1; }
+		// One face of one layer
+		uint64_t ImageSize(size_t level) const;
+
+		const std::byte* Data() const { return mapped ? mapped : data.data(); }
+		const std::byte* LevelData(size_t level) const { return Data() + levels[level].offset; }
+		const std::byte* ImageData(size_t level, uint32_t layer, uint32_t face) const;
+		std::byte* MutableImageData(size_t level, uint32_t layer, uint32_t face);
+	};
+
+	// Khronos KTX 2.0 files, without supercompression or Basis Universal. Opening maps the file
+	// and points the image's levels into the mapping, like the engine's own cache files
+	class KTX2File
+	{
+	public:
+		static KTX2FormatInfo GetFormatInfo(KTX2Format format);
+
+		// Levels go smallest first as the spec asks, with the data format descriptor for the format
+		static bool Write(const std::string& path, const KTX2Image& image);
+
+		// False when the file is missing, truncated, supercompressed or in a format not listed above
+		bool Open(const std::string& path);
+		void Close();
+
+		// Valid until Close, the levels point into the mapping
+		const KTX2Image& GetImage() const { return m_image; }
+
+	private:
+		MappedFile m_file;
+		KTX2Image m_image;
+	};
+}
+
+#endif
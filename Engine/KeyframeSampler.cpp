@@ -0,0 +1,708 @@
+#include "KeyframeSampler.h"
+#include "BinaryStream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JL_KEYFRAME_SSE
+#include <emmintrin.h>
+#endif
+
+namespace JLEngine
+{
+	namespace
+	{
+		glm::vec4 DefaultValue(TargetPath path)
+		{
+			if (path == TargetPath::ROTATION) return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			if (path == TargetPath::SCALE) return glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+			return glm::vec4(0.0f);
+		}
+
+		glm::vec4 NormalizeRotation(const glm::vec4& q)
+		{
+			float lengthSq = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+			return lengthSq > 0.0f ? q / std::sqrt(lengthSq) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+
+		size_t PaddedCount(size_t count)
+		{
+			return (count + 3) & ~size_t(3);
+		}
+
+		// the three smallest components of a unit quaternion lie within +-1/sqrt(2)
+		constexpr float SmallestThreeRange = 0.70710678f;
+		constexpr float SmallestThreeSteps = 32767.0f;
+
+		void EncodeRotation48(glm::vec4 q, uint16_t* out)
+		{
+			q = NormalizeRotation(q);
+			int largest = 0;
+			for (int i = 1; i < 4; ++i)
+			{
+				if (std::abs(q[i]) > std::abs(q[largest])) largest = i;
+			}
+			// q and -q are the same rotation, keeping the dropped component positive lets the decoder rebuild it
+			if (q[largest] < 0.0f) q = -q;
+
+			uint64_t bits = static_cast<uint64_t>(largest) << 45;
+			int shift = 30;
+			for (int i = 0; i < 4; ++i)
+			{
+				if (i == largest) continue;
+				float unit = std::clamp((q[i] + SmallestThreeRange) / (2.0f * SmallestThreeRange), 0.0f, 1.0f);
+				bits |= static_cast<uint64_t>(std::lround(unit * SmallestThreeSteps)) << shift;
+				shift -= 15;
+			}
+			out[0] = static_cast<uint16_t>(bits);
+			out[1] = static_cast<uint16_t>(bits >> 16);
+			out[2] = static_cast<uint16_t>(bits >> 32);
+		}
+
+		glm::vec4 DecodeRotation48(const uint16_t* in)
+		{
+			uint64_t bits = static_cast<uint64_t>(in[0]) | (static_cast<uint64_t>(in[1]) << 16) | (static_cast<uint64_t>(in[2]) << 32);
+			int largest = static_cast<int>((bits >> 45) & 3);
+
+			glm::vec4 q(0.0f);
+			float sumSq = 0.0f;
+			int shift = 30;
+			for (int i = 0; i < 4; ++i)
+			{
+				if (i == largest) continue;
+				float c = static_cast<float>((bits >> shift) & 0x7FFF) * (2.0f * SmallestThreeRange / SmallestThreeSteps) - SmallestThreeRange;
+				q[i] = c;
+				sumSq += c * c;
+				shift -= 15;
+			}
+			q[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSq));
+			return q;
+		}
+
+		// FNV-1a
+		void HashBytes(uint64_t& hash, const void* data, size_t size)
+		{
+			auto bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; ++i)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+		}
+
+		template <typename T>
+		void HashVector(uint64_t& hash, const std::vector<T>& v)
+		{
+			uint64_t size = v.size();
+			HashBytes(hash, &size, sizeof(size));
+			if (!v.empty()) HashBytes(hash, v.data(), v.size() * sizeof(T));
+		}
+	}
+
+	void KeyframeSampler::Clear()
+	{
+		m_keyOffset.clear();
+		m_timeline.clear();
+		m_tangentOffset.clear();
+		m_path.clear();
+		m_interpolation.clear();
+		m_format.clear();
+		m_rangeMin.clear();
+		m_rangeScale.clear();
+		m_isCubic.clear();
+		m_isStep.clear();
+		m_timelineOffset.clear();
+		m_timelineCount.clear();
+		m_timelineChannel.clear();
+		m_times.clear();
+		m_values.clear();
+		m_packed.clear();
+		m_inTangents.assign(1, glm::vec4(0.0f));
+		m_outTangents.assign(1, glm::vec4(0.0f));
+	}
+
+	void KeyframeSampler::AddChannel(TargetPath path, InterpolationType interpolation, const std::vector<float>& times,
+		const std::vector<glm::vec4>& values,
+		const std::vector<glm::vec4>& inTangents,
+		const std::vector<glm::vec4>& outTangents)
+	{
+		size_t keyCount = std::min(times.size(), values.size());
+
+		bool cubic = interpolation == InterpolationType::CUBICSPLINE;
+		if (cubic && (inTangents.size() < keyCount || outTangents.size() < keyCount))
+		{
+			// tangents missing, a Hermite curve with zero tangents still passes through the keys
+			interpolation = InterpolationType::LINEAR;
+			cubic = false;
+		}
+
+		size_t channel = m_keyOffset.size();
+		m_keyOffset.push_back(static_cast<uint32_t>(m_values.size()));
+		m_path.push_back(static_cast<uint8_t>(path));
+		m_interpolation.push_back(static_cast<uint8_t>(interpolation));
+		m_format.push_back(static_cast<uint8_t>(KeyFormat::Float));
+		m_rangeMin.push_back(glm::vec4(0.0f));
+		m_rangeScale.push_back(glm::vec4(0.0f));
+
+		if (keyCount == 0)
+		{
+			// a single key holding the bind value keeps every channel samplable
+			const float zero = 0.0f;
+			m_timeline.push_back(AddTimeline(&zero, 1));
+			m_tangentOffset.push_back(0);
+			m_values.push_back(DefaultValue(path));
+		}
+		else
+		{
+			m_timeline.push_back(AddTimeline(times.data(), keyCount));
+			m_values.insert(m_values.end(), values.begin(), values.begin() + keyCount);
+
+			if (cubic)
+			{
+				m_tangentOffset.push_back(static_cast<uint32_t>(m_inTangents.size()));
+				m_inTangents.insert(m_inTangents.end(), inTangents.begin(), inTangents.begin() + keyCount);
+				m_outTangents.insert(m_outTangents.end(), outTangents.begin(), outTangents.begin() + keyCount);
+			}
+			else
+			{
+				m_tangentOffset.push_back(0);
+			}
+		}
+
+		if (m_timelineChannel[m_timeline[channel]] == UINT32_MAX)
+			m_timelineChannel[m_timeline[channel]] = static_cast<uint32_t>(channel);
+
+		m_isCubic.resize(PaddedCount(channel + 1), 0.0f);
+		m_isStep.resize(PaddedCount(channel + 1), 0.0f);
+		m_isCubic[channel] = cubic ? 1.0f : 0.0f;
+		m_isStep[channel] = interpolation == InterpolationType::STEP ? 1.0f : 0.0f;
+	}
+
+	uint32_t KeyframeSampler::AddTimeline(const float* times, size_t count)
+	{
+		// animations have a handful of distinct timelines, a linear scan at load time is plenty
+		for (size_t timeline = 0; timeline < m_timelineOffset.size(); ++timeline)
+		{
+			if (m_timelineCount[timeline] == count && std::equal(times, times + count, m_times.data() + m_timelineOffset[timeline]))
+				return static_cast<uint32_t>(timeline);
+		}
+
+		m_timelineOffset.push_back(static_cast<uint32_t>(m_times.size()));
+		m_timelineCount.push_back(static_cast<uint32_t>(count));
+		m_timelineChannel.push_back(UINT32_MAX);
+		m_times.insert(m_times.end(), times, times + count);
+		return static_cast<uint32_t>(m_timelineOffset.size() - 1);
+	}
+
+	size_t KeyframeSampler::FindTimelineKey(uint32_t timeline, float time, size_t keyHint) const
+	{
+		size_t count = m_timelineCount[timeline];
+		const float* times = m_times.data() + m_timelineOffset[timeline];
+		size_t key = std::min(keyHint, count - 1);
+
+		// gallop from the hint in doubling steps until the time is bracketed, then binary search
+		// the bracket. Playback moves a key or two a frame and stops after one or two compares,
+		// a seek or a loop wrap costs O(log distance) instead of walking every key in between
+		size_t lo, hi;
+		if (time >= times[key])
+		{
+			lo = key;
+			hi = key + 1;
+			for (size_t step = 1; hi < count && times[hi] <= time; step <<= 1)
+			{
+				lo = hi;
+				hi = lo + step;
+			}
+			hi = std::min(hi, count);
+			// times[lo] <= time, the answer is the last key in [lo, hi) not after time
+			return static_cast<size_t>(std::upper_bound(times + lo + 1, times + hi, time) - times) - 1;
+		}
+
+		hi = key;
+		lo = 0;
+		for (size_t step = 1; hi >= step; step <<= 1)
+		{
+			if (times[hi - step] <= time)
+			{
+				lo = hi - step;
+				break;
+			}
+			hi -= step;
+		}
+		// times[hi] > time, before the first key holds key 0
+		size_t upper = static_cast<size_t>(std::upper_bound(times + lo, times + hi, time) - times);
+		return upper > 0 ? upper - 1 : 0;
+	}
+
+	size_t KeyframeSampler::FindKey(size_t channel, float time, size_t keyHint) const
+	{
+		return FindTimelineKey(m_timeline[channel], time, keyHint);
+	}
+
+	void KeyframeSampler::Seek(float time, std::vector<size_t>& keyframeIndices) const
+	{
+		size_t channelCount = ChannelCount();
+		if (keyframeIndices.size() < channelCount)
+			keyframeIndices.resize(channelCount, 0);
+
+		for (size_t c = 0; c < channelCount; ++c)
+		{
+			uint32_t timeline = m_timeline[c];
+			uint32_t first = m_timelineChannel[timeline];
+			// the first channel on a timeline comes first, later ones copy its cursor
+			keyframeIndices[c] = first == c ? FindTimelineKey(timeline, time, keyframeIndices[c]) : keyframeIndices[first];
+		}
+	}
+
+	KeyframeSampler::KeySpan KeyframeSampler::SpanAt(size_t channel, size_t key) const
+	{
+		uint32_t timeline = m_timeline[channel];
+		uint32_t count = m_timelineCount[timeline];
+		const float* times = m_times.data() + m_timelineOffset[timeline];
+		uint32_t offset = m_keyOffset[channel];
+
+		// past the last key the value holds
+		size_t next = key + 1 < count ? key + 1 : key;
+		return KeySpan{ offset + static_cast<uint32_t>(key), offset + static_cast<uint32_t>(next), times[key], times[next] };
+	}
+
+	KeyframeSampler::KeySpan KeyframeSampler::FindKeys(size_t channel, float time, size_t keyHint) const
+	{
+		return SpanAt(channel, FindKey(channel, time, keyHint));
+	}
+
+	void KeyframeSampler::Sample(float time, const std::vector<size_t>& keyframeIndices, KeyframeSampleScratch& scratch, glm::vec4* out) const
+	{
+		size_t channelCount = ChannelCount();
+		if (channelCount == 0) return;
+
+		// --- LOCATE KEYS ---
+		size_t padded = PaddedCount(channelCount);
+		scratch.t0.assign(padded, 0.0f);
+		scratch.t1.assign(padded, 0.0f);
+		scratch.w00.resize(padded);
+		scratch.w01.resize(padded);
+		scratch.w10.resize(padded);
+		scratch.w11.resize(padded);
+		scratch.k0.resize(channelCount);
+		scratch.k1.resize(channelCount);
+		scratch.outTangent.resize(channelCount);
+		scratch.inTangent.resize(channelCount);
+
+		for (size_t c = 0; c < channelCount; ++c)
+		{
+			uint32_t timeline = m_timeline[c];
+			uint32_t first = m_timelineChannel[timeline];
+			size_t key;
+			if (first == c)
+				key = FindTimelineKey(timeline, time, c < keyframeIndices.size() ? keyframeIndices[c] : 0);
+			else
+				key = scratch.k0[first] - m_keyOffset[first];
+			KeySpan span = SpanAt(c, key);
+
+			scratch.t0[c] = span.t0;
+			scratch.t1[c] = span.t1;
+			scratch.k0[c] = span.k0;
+			scratch.k1[c] = span.k1;
+
+			uint32_t tangentOffset = m_tangentOffset[c];
+			scratch.outTangent[c] = tangentOffset ? tangentOffset + (span.k0 - m_keyOffset[c]) : 0;
+			scratch.inTangent[c] = tangentOffset ? tangentOffset + (span.k1 - m_keyOffset[c]) : 0;
+		}
+
+		// --- WEIGHTS ---
+		ComputeWeights(0, padded, time, scratch);
+
+		for (size_t c = 0; c < channelCount; ++c)
+		{
+			if (m_path[c] == TargetPath::ROTATION && m_interpolation[c] == static_cast<uint8_t>(InterpolationType::LINEAR))
+				SlerpWeights(c, scratch.k0[c], scratch.k1[c], scratch.w00[c], scratch.w01[c]);
+		}
+
+		// --- BLEND ---
+		for (size_t c = 0; c < channelCount; ++c)
+		{
+#if defined(JL_KEYFRAME_SSE)
+			glm::vec4 v0 = Value(c, scratch.k0[c]);
+			glm::vec4 v1 = Value(c, scratch.k1[c]);
+			__m128 result = _mm_mul_ps(_mm_set1_ps(scratch.w00[c]), _mm_loadu_ps(&v0.x));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(scratch.w01[c]), _mm_loadu_ps(&v1.x)));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(scratch.w10[c]), _mm_loadu_ps(&m_outTangents[scratch.outTangent[c]].x)));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(scratch.w11[c]), _mm_loadu_ps(&m_inTangents[scratch.inTangent[c]].x)));
+
+			if (m_path[c] == TargetPath::ROTATION)
+			{
+				__m128 squared = _mm_mul_ps(result, result);
+				__m128 sum = _mm_add_ps(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 3, 0, 1)));
+				sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+				if (_mm_cvtss_f32(sum) > 0.0f)
+					result = _mm_div_ps(result, _mm_sqrt_ps(sum));
+				else
+					result = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+			}
+			_mm_storeu_ps(&out[c].x, result);
+#else
+			glm::vec4 result = scratch.w00[c] * Value(c, scratch.k0[c]) + scratch.w01[c] * Value(c, scratch.k1[c]) +
+				scratch.w10[c] * m_outTangents[scratch.outTangent[c]] + scratch.w11[c] * m_inTangents[scratch.inTangent[c]];
+			out[c] = m_path[c] == TargetPath::ROTATION ? NormalizeRotation(result) : result;
+#endif
+		}
+	}
+
+	void KeyframeSampler::ComputeWeights(size_t first, size_t last, float time, KeyframeSampleScratch& scratch) const
+	{
+#if defined(JL_KEYFRAME_SSE)
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 three = _mm_set1_ps(3.0f);
+		const __m128 t = _mm_set1_ps(time);
+
+		for (size_t c = first; c < last; c += 4)
+		{
+			__m128 t0 = _mm_loadu_ps(&scratch.t0[c]);
+			__m128 td = _mm_sub_ps(_mm_loadu_ps(&scratch.t1[c]), t0);
+
+			// s = (t - t0) / td clamped to [0, 1], held keys (td == 0) get 0
+			__m128 valid = _mm_cmpgt_ps(td, zero);
+			__m128 s = _mm_div_ps(_mm_sub_ps(t, t0), _mm_or_ps(_mm_and_ps(valid, td), _mm_andnot_ps(valid, one)));
+			s = _mm_and_ps(valid, _mm_min_ps(_mm_max_ps(s, zero), one));
+			__m128 s2 = _mm_mul_ps(s, s);
+			__m128 s3 = _mm_mul_ps(s2, s);
+
+			// Hermite basis, the tangent terms are scaled by the key interval as glTF stores them per second
+			__m128 h00 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(two, s3), _mm_mul_ps(three, s2)), one);
+			__m128 h01 = _mm_sub_ps(_mm_mul_ps(three, s2), _mm_mul_ps(two, s3));
+			__m128 h10 = _mm_mul_ps(td, _mm_add_ps(_mm_sub_ps(s3, _mm_mul_ps(two, s2)), s));
+			__m128 h11 = _mm_mul_ps(td, _mm_sub_ps(s3, s2));
+
+			__m128 cubic = _mm_loadu_ps(&m_isCubic[c]);
+			__m128 step = _mm_loadu_ps(&m_isStep[c]);
+			__m128 linear = _mm_sub_ps(_mm_sub_ps(one, cubic), step);
+
+			__m128 w00 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cubic, h00), _mm_mul_ps(linear, _mm_sub_ps(one, s))), step);
+			__m128 w01 = _mm_add_ps(_mm_mul_ps(cubic, h01), _mm_mul_ps(linear, s));
+
+			_mm_storeu_ps(&scratch.w00[c], w00);
+			_mm_storeu_ps(&scratch.w01[c], w01);
+			_mm_storeu_ps(&scratch.w10[c], _mm_mul_ps(cubic, h10));
+			_mm_storeu_ps(&scratch.w11[c], _mm_mul_ps(cubic, h11));
+		}
+#else
+		for (size_t c = first; c < last; ++c)
+		{
+			ComputeWeightsScalar(c, time, scratch.t0[c], scratch.t1[c], scratch.w00[c], scratch.w01[c], scratch.w10[c], scratch.w11[c]);
+		}
+#endif
+	}
+
+	void KeyframeSampler::ComputeWeightsScalar(size_t channel, float time, float t0, float t1, float& w00, float& w01, float& w10, float& w11) const
+	{
+		float td = t1 - t0;
+		float s = td > 0.0f ? std::clamp((time - t0) / td, 0.0f, 1.0f) : 0.0f;
+		float s2 = s * s;
+		float s3 = s2 * s;
+
+		float cubic = m_isCubic[channel];
+		float step = m_isStep[channel];
+		float linear = 1.0f - cubic - step;
+
+		w00 = cubic * (2.0f * s3 - 3.0f * s2 + 1.0f) + linear * (1.0f - s) + step;
+		w01 = cubic * (3.0f * s2 - 2.0f * s3) + linear * s;
+		w10 = cubic * td * (s3 - 2.0f * s2 + s);
+		w11 = cubic * td * (s3 - s2);
+	}
+
+	void KeyframeSampler::SlerpWeights(size_t channel, uint32_t k0, uint32_t k1, float& w00, float& w01) const
+	{
+		if (k0 == k1) return;
+
+		// the linear pass left s in w01
+		float s = w01;
+		glm::vec4 q0 = Value(channel, k0);
+		glm::vec4 q1 = Value(channel, k1);
+		float cosTheta = q0.x * q1.x + q0.y * q1.y + q0.z * q1.z + q0.w * q1.w;
+
+		// shortest path
+		float sign = 1.0f;
+		if (cosTheta < 0.0f)
+		{
+			sign = -1.0f;
+			cosTheta = -cosTheta;
+		}
+
+		// nearly parallel, lerp (the result is normalized) to avoid dividing by sin(0)
+		if (cosTheta > 1.0f - glm::epsilon<float>())
+		{
+			w00 = 1.0f - s;
+			w01 = sign * s;
+			return;
+		}
+
+		float angle = std::acos(cosTheta);
+		float invSin = 1.0f / std::sin(angle);
+		w00 = std::sin((1.0f - s) * angle) * invSin;
+		w01 = sign * std::sin(s * angle) * invSin;
+	}
+
+	void KeyframeSampler::SampleScalar(float time, const std::vector<size_t>& keyframeIndices, glm::vec4* out) const
+	{
+		for (size_t c = 0; c < ChannelCount(); ++c)
+		{
+			out[c] = SampleChannel(c, time, c < keyframeIndices.size() ? keyframeIndices[c] : 0);
+		}
+	}
+
+	glm::vec4 KeyframeSampler::SampleChannel(size_t channel, float time, size_t keyHint) const
+	{
+		KeySpan span = FindKeys(channel, time, keyHint);
+		glm::vec4 v0 = Value(channel, span.k0);
+		glm::vec4 v1 = Value(channel, span.k1);
+		bool rotation = m_path[channel] == TargetPath::ROTATION;
+
+		float td = span.t1 - span.t0;
+		float s = td > 0.0f ? std::clamp((time - span.t0) / td, 0.0f, 1.0f) : 0.0f;
+
+		switch (GetInterpolation(channel))
+		{
+		case InterpolationType::STEP:
+			return v0;
+
+		case InterpolationType::CUBICSPLINE:
+		{
+			uint32_t tangentOffset = m_tangentOffset[channel];
+			const glm::vec4& b0 = m_outTangents[tangentOffset + (span.k0 - m_keyOffset[channel])];
+			const glm::vec4& a1 = m_inTangents[tangentOffset + (span.k1 - m_keyOffset[channel])];
+
+			float s2 = s * s;
+			float s3 = s2 * s;
+			glm::vec4 result = (2.0f * s3 - 3.0f * s2 + 1.0f) * v0 + td * (s3 - 2.0f * s2 + s) * b0 +
+				(-2.0f * s3 + 3.0f * s2) * v1 + td * (s3 - s2) * a1;
+			return rotation ? NormalizeRotation(result) : result;
+		}
+
+		case InterpolationType::LINEAR:
+		default:
+			if (rotation)
+			{
+				glm::quat q0(v0.w, v0.x, v0.y, v0.z);
+				glm::quat q1(v1.w, v1.x, v1.y, v1.z);
+				glm::quat q = glm::normalize(glm::slerp(q0, q1, s));
+				return glm::vec4(q.x, q.y, q.z, q.w);
+			}
+			return glm::mix(v0, v1, s);
+		}
+	}
+
+	glm::vec4 KeyframeSampler::Value(size_t channel, uint32_t row) const
+	{
+		switch (static_cast<KeyFormat>(m_format[channel]))
+		{
+		case KeyFormat::Rotation48:
+			return DecodeRotation48(&m_packed[static_cast<size_t>(row) * 3]);
+
+		case KeyFormat::Range48:
+		{
+			const uint16_t* key = &m_packed[static_cast<size_t>(row) * 3];
+			const glm::vec4& scale = m_rangeScale[channel];
+			return m_rangeMin[channel] + glm::vec4(key[0] * scale.x, key[1] * scale.y, key[2] * scale.z, 0.0f);
+		}
+
+		case KeyFormat::Float:
+		default:
+			return m_values[row];
+		}
+	}
+
+	void KeyframeSampler::Quantize()
+	{
+		std::vector<glm::vec4> values;
+		std::vector<uint16_t> packed;
+		packed.reserve(m_packed.size() + m_values.size() * 3);
+
+		for (size_t c = 0; c < ChannelCount(); ++c)
+		{
+			uint32_t first = m_keyOffset[c];
+			size_t count = KeyCount(c);
+			auto format = static_cast<KeyFormat>(m_format[c]);
+
+			if (format != KeyFormat::Float)
+			{
+				// already quantized, rows move as they are
+				m_keyOffset[c] = static_cast<uint32_t>(packed.size() / 3);
+				packed.insert(packed.end(), m_packed.begin() + first * 3, m_packed.begin() + (first + count) * 3);
+				continue;
+			}
+
+			if (m_path[c] == TargetPath::ROTATION && m_isCubic[c] != 0.0f)
+			{
+				m_keyOffset[c] = static_cast<uint32_t>(values.size());
+				values.insert(values.end(), m_values.begin() + first, m_values.begin() + first + count);
+				continue;
+			}
+
+			m_keyOffset[c] = static_cast<uint32_t>(packed.size() / 3);
+			packed.resize(packed.size() + count * 3);
+			uint16_t* out = packed.data() + static_cast<size_t>(m_keyOffset[c]) * 3;
+
+			if (m_path[c] == TargetPath::ROTATION)
+			{
+				m_format[c] = static_cast<uint8_t>(KeyFormat::Rotation48);
+				for (size_t k = 0; k < count; ++k)
+				{
+					EncodeRotation48(m_values[first + k], out + k * 3);
+				}
+				continue;
+			}
+
+			glm::vec4 lo = m_values[first], hi = m_values[first];
+			for (size_t k = 1; k < count; ++k)
+			{
+				lo = glm::min(lo, m_values[first + k]);
+				hi = glm::max(hi, m_values[first + k]);
+			}
+			glm::vec4 scale = (hi - lo) / 65535.0f;
+			// w doesn't vary for translation and scale, it decodes to the first key's
+			m_format[c] = static_cast<uint8_t>(KeyFormat::Range48);
+			m_rangeMin[c] = glm::vec4(lo.x, lo.y, lo.z, m_values[first].w);
+			m_rangeScale[c] = scale;
+
+			for (size_t k = 0; k < count; ++k)
+			{
+				const glm::vec4& v = m_values[first + k];
+				for (int i = 0; i < 3; ++i)
+				{
+					out[k * 3 + i] = scale[i] > 0.0f ? static_cast<uint16_t>(std::lround(std::clamp((v[i] - lo[i]) / scale[i], 0.0f, 65535.0f))) : 0;
+				}
+			}
+		}
+
+		m_values = std::move(values);
+		m_packed = std::move(packed);
+		m_packed.shrink_to_fit();
+	}
+
+	void KeyframeSampler::GetChannelKeys(size_t channel, std::vector<float>& times, std::vector<glm::vec4>& values,
+		std::vector<glm::vec4>& inTangents, std::vector<glm::vec4>& outTangents) const
+	{
+		uint32_t timeline = m_timeline[channel];
+		size_t count = m_timelineCount[timeline];
+		const float* first = m_times.data() + m_timelineOffset[timeline];
+		times.assign(first, first + count);
+
+		values.resize(count);
+		for (size_t k = 0; k < count; ++k)
+		{
+			values[k] = Value(channel, m_keyOffset[channel] + static_cast<uint32_t>(k));
+		}
+
+		inTangents.clear();
+		outTangents.clear();
+		if (uint32_t tangentOffset = m_tangentOffset[channel])
+		{
+			inTangents.assign(m_inTangents.begin() + tangentOffset, m_inTangents.begin() + tangentOffset + count);
+			outTangents.assign(m_outTangents.begin() + tangentOffset, m_outTangents.begin() + tangentOffset + count);
+		}
+	}
+
+	size_t KeyframeSampler::MemoryBytes() const
+	{
+		size_t perChannel = ChannelCount() * (sizeof(uint32_t) * 3 + sizeof(uint8_t) * 3 + sizeof(glm::vec4) * 2) +
+			m_isCubic.size() * sizeof(float) * 2;
+		size_t perTimeline = TimelineCount() * sizeof(uint32_t) * 3;
+		size_t perKey = m_times.size() * sizeof(float) + m_values.size() * sizeof(glm::vec4) + m_packed.size() * sizeof(uint16_t) +
+			(m_inTangents.size() + m_outTangents.size()) * sizeof(glm::vec4);
+		return perChannel + perTimeline + perKey;
+	}
+
+	uint64_t KeyframeSampler::Fingerprint() const
+	{
+		uint64_t hash = 14695981039346656037ull;
+		HashVector(hash, m_keyOffset);
+		HashVector(hash, m_timeline);
+		HashVector(hash, m_tangentOffset);
+		HashVector(hash, m_path);
+		HashVector(hash, m_interpolation);
+		HashVector(hash, m_format);
+		HashVector(hash, m_rangeMin);
+		HashVector(hash, m_rangeScale);
+		HashVector(hash, m_timelineOffset);
+		HashVector(hash, m_timelineCount);
+		HashVector(hash, m_times);
+		HashVector(hash, m_values);
+		HashVector(hash, m_packed);
+		HashVector(hash, m_inTangents);
+		HashVector(hash, m_outTangents);
+		return hash;
+	}
+
+	void KeyframeSampler::Write(BinaryWriter& writer) const
+	{
+		writer.Vector(m_keyOffset);
+		writer.Vector(m_timeline);
+		writer.Vector(m_tangentOffset);
+		writer.Vector(m_path);
+		writer.Vector(m_interpolation);
+		writer.Vector(m_format);
+		writer.Vector(m_rangeMin);
+		writer.Vector(m_rangeScale);
+		writer.Vector(m_isCubic);
+		writer.Vector(m_isStep);
+		writer.Vector(m_timelineOffset);
+		writer.Vector(m_timelineCount);
+		writer.Vector(m_timelineChannel);
+		writer.Vector(m_times);
+		writer.Vector(m_values);
+		writer.Vector(m_packed);
+		writer.Vector(m_inTangents);
+		writer.Vector(m_outTangents);
+	}
+
+	bool KeyframeSampler::Read(BinaryReader& reader)
+	{
+		reader.Vector(m_keyOffset);
+		reader.Vector(m_timeline);
+		reader.Vector(m_tangentOffset);
+		reader.Vector(m_path);
+		reader.Vector(m_interpolation);
+		reader.Vector(m_format);
+		reader.Vector(m_rangeMin);
+		reader.Vector(m_rangeScale);
+		reader.Vector(m_isCubic);
+		reader.Vector(m_isStep);
+		reader.Vector(m_timelineOffset);
+		reader.Vector(m_timelineCount);
+		reader.Vector(m_timelineChannel);
+		reader.Vector(m_times);
+		reader.Vector(m_values);
+		reader.Vector(m_packed);
+		reader.Vector(m_inTangents);
+		reader.Vector(m_outTangents);
+
+		size_t channels = m_keyOffset.size();
+		size_t timelines = m_timelineOffset.size();
+		bool valid = reader.Good() &&
+			m_timeline.size() == channels && m_tangentOffset.size() == channels && m_path.size() == channels &&
+			m_interpolation.size() == channels && m_format.size() == channels &&
+			m_rangeMin.size() == channels && m_rangeScale.size() == channels &&
+			m_isCubic.size() >= channels && m_isStep.size() == m_isCubic.size() &&
+			m_timelineCount.size() == timelines && m_timelineChannel.size() == timelines &&
+			!m_inTangents.empty() && m_inTangents.size() == m_outTangents.size();
+
+		for (size_t channel = 0; valid && channel < channels; ++channel)
+		{
+			valid = m_timeline[channel] < timelines;
+		}
+		for (size_t timeline = 0; valid && timeline < timelines; ++timeline)
+		{
+			valid = static_cast<size_t>(m_timelineOffset[timeline]) + m_timelineCount[timeline] <= m_times.size();
+		}
+
+		if (!valid) Clear();
+		return valid;
+	}
+}
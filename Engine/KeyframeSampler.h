@@ -0,0 +1,154 @@
+#ifndef KEYFRAME_SAMPLER_H
+#define KEYFRAME_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace JLEngine
+{
+	class BinaryWriter;
+	class BinaryReader;
+
+	enum TargetPath
+	{
+		TRANSLATION,
+		ROTATION,
+		SCALE
+	};
+
+	enum class InterpolationType
+	{
+		LINEAR = 0,
+		STEP = 1,
+		CUBICSPLINE = 2,
+	};
+
+	// How a channel's value rows are stored
+	enum class KeyFormat : uint8_t
+	{
+		Float = 0,			// glm::vec4
+		Rotation48 = 1,		// smallest three: index of the dropped largest component and the other three in 15 bits
+		Range48 = 2			// xyz in 16 bits over the channel's range, w is constant
+	};
+
+	// Per channel working arrays for KeyframeSampler::Sample, reuse one per thread
+	struct KeyframeSampleScratch
+	{
+		std::vector<float> t0, t1;
+		std::vector<float> w00, w01, w10, w11;			// weights of value k, value k + 1, out tangent k, in tangent k + 1
+		std::vector<uint32_t> k0, k1;					// value rows
+		std::vector<uint32_t> outTangent, inTangent;	// tangent rows, 0 (a zero row) for channels without tangents
+	};
+
+	// Keyframes of every channel of an animation packed into flat arrays, with the per channel data
+	// (key ranges, interpolation, path) stored SoA. Sampling runs in passes over the channels:
+	// locate the keys, then compute the interpolation weights four channels at a time with SSE, then
+	// blend each channel's value rows as one vec4. LINEAR, STEP and glTF CUBICSPLINE (Hermite with
+	// in/out tangents) all reduce to the same weighted sum of four rows, linear rotations slerp.
+	// Times before the first key hold the first value and times after the last hold the last.
+	// Channels with identical key times (glTF exporters key every joint from one input accessor)
+	// share a single timeline, its keys are located once and reused by the other channels.
+	class KeyframeSampler
+	{
+	public:
+		KeyframeSampler() { Clear(); }
+
+		void Clear();
+
+		// Channels are sampled in the order they are added. Tangents are only read for CUBICSPLINE
+		// and must then have one entry per key (the glTF in-tangent, value, out-tangent triplets split apart)
+		void AddChannel(TargetPath path, InterpolationType interpolation, const std::vector<float>& times,
+			const std::vector<glm::vec4>& values,
+			const std::vector<glm::vec4>& inTangents = {},
+			const std::vector<glm::vec4>& outTangents = {});
+
+		size_t ChannelCount() const { return m_keyOffset.size(); }
+		size_t TimelineCount() const { return m_timelineOffset.size(); }
+		size_t GetTimeline(size_t channel) const { return m_timeline[channel]; }
+		size_t KeyCount(size_t channel) const { return m_timelineCount[m_timeline[channel]]; }
+		TargetPath GetPath(size_t channel) const { return static_cast<TargetPath>(m_path[channel]); }
+		InterpolationType GetInterpolation(size_t channel) const { return static_cast<InterpolationType>(m_interpolation[channel]); }
+
+		// Writes one value per channel to out. keyframeIndices are the keys at or before time from the
+		// last call (AnimationController keeps them), they are only a starting point for the search,
+		// missing or stale entries are fine
+		void Sample(float time, const std::vector<size_t>& keyframeIndices, KeyframeSampleScratch& scratch, glm::vec4* out) const;
+
+		// Reference implementation, one channel at a time with no SIMD
+		void SampleScalar(float time, const std::vector<size_t>& keyframeIndices, glm::vec4* out) const;
+		glm::vec4 SampleChannel(size_t channel, float time, size_t keyHint = 0) const;
+
+		// The key at or before time (0 before the first key). Gallops out from keyHint and binary
+		// searches the bracket, so playback costs a compare or two and a seek O(log keys)
+		size_t FindKey(size_t channel, float time, size_t keyHint = 0) const;
+
+		// Moves every channel's key cursor to time, searching each shared timeline once
+		void Seek(float time, std::vector<size_t>& keyframeIndices) const;
+
+		// Re-encodes the values as 6 byte rows decoded on the fly while sampling, rotations as smallest
+		// three and translation/scale over each channel's range. Cubic rotations stay float, flipping a
+		// key's sign to canonicalize it would break its tangents
+		void Quantize();
+		KeyFormat GetKeyFormat(size_t channel) const { return static_cast<KeyFormat>(m_format[channel]); }
+
+		// Copies a channel's keys back out as floats, tangents only for CUBICSPLINE
+		void GetChannelKeys(size_t channel, std::vector<float>& times, std::vector<glm::vec4>& values,
+			std::vector<glm::vec4>& inTangents, std::vector<glm::vec4>& outTangents) const;
+
+		// Every array as it is, so a compressed animation loads from a cache without being rebuilt.
+		// Read leaves the sampler cleared when the arrays don't agree with each other
+		void Write(BinaryWriter& writer) const;
+		bool Read(BinaryReader& reader);
+
+		size_t MemoryBytes() const;
+		// Hash of every key and channel setting, identical samplers give identical fingerprints
+		uint64_t Fingerprint() const;
+
+	private:
+		struct KeySpan
+		{
+			uint32_t k0, k1;
+			float t0, t1;
+		};
+
+		size_t FindTimelineKey(uint32_t timeline, float time, size_t keyHint) const;
+		KeySpan FindKeys(size_t channel, float time, size_t keyHint) const;
+		KeySpan SpanAt(size_t channel, size_t key) const;
+		uint32_t AddTimeline(const float* times, size_t count);
+		glm::vec4 Value(size_t channel, uint32_t row) const;
+		void ComputeWeights(size_t first, size_t last, float time, KeyframeSampleScratch& scratch) const;
+		void ComputeWeightsScalar(size_t channel, float time, float t0, float t1, float& w00, float& w01, float& w10, float& w11) const;
+		void SlerpWeights(size_t channel, uint32_t k0, uint32_t k1, float& w00, float& w01) const;
+
+		// --- PER CHANNEL (SoA) ---
+		std::vector<uint32_t> m_keyOffset;			// first row in m_values or m_packed, by m_format
+		std::vector<uint32_t> m_timeline;
+		std::vector<uint32_t> m_tangentOffset;		// first row in the tangent arrays, 0 when there are none
+		std::vector<uint8_t> m_path;
+		std::vector<uint8_t> m_interpolation;
+		std::vector<uint8_t> m_format;
+		std::vector<glm::vec4> m_rangeMin;			// Range48 value = min + key * scale
+		std::vector<glm::vec4> m_rangeScale;
+		// 1.0f/0.0f per channel so the weight pass can blend the three formulas without branching,
+		// padded to a multiple of 4 channels
+		std::vector<float> m_isCubic;
+		std::vector<float> m_isStep;
+
+		// --- PER TIMELINE ---
+		std::vector<uint32_t> m_timelineOffset;		// first key in m_times
+		std::vector<uint32_t> m_timelineCount;
+		std::vector<uint32_t> m_timelineChannel;		// first channel on the timeline, its cursor is shared
+
+		// --- PER KEY ---
+		std::vector<float> m_times;
+		std::vector<glm::vec4> m_values;
+		std::vector<uint16_t> m_packed;				// three per row
+		// row 0 is zero, channels without tangents point there
+		std::vector<glm::vec4> m_inTangents;
+		std::vector<glm::vec4> m_outTangents;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -94,6 +94,9 @@ void DemoInstancing(JLEngine::JLEngineCore& engine, const std::string& assetFold
             auto newNode = engine.MakeInstanceOf(skeletonNode, pos, true);
             auto newSkeletonNode = JLEngine::Node::FindSkeletonNode(newNode);
             newSkeletonNode->animController->SetCurrentAnimation(anim.get());
+            // background crowd, played on the GPU from a baked palette with a staggered start
+            newSkeletonNode->animController->Update((i * 55 + j) * 0.137f);
+            newSkeletonNode->animController->SetBakedPlayback(true);
 
             auto newHelmetInstance = engine.MakeInstanceOf(helmet, pos2, true);
             newHelmetInstance->UpdateHierarchy();
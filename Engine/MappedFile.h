@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace JLEngine
+{
+	// Read only mapping of a whole file. Pages are faulted in from the OS file cache as they are
+	// touched, so reading a range costs the copy out of it and nothing else
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile() { Close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Fails for missing and empty files
+		bool Open(const std::string& path);
+		void Close();
+
+		bool IsOpen() const { return m_data != nullptr; }
+		const std::byte* Data() const { return m_data; }
+		size_t Size() const { return m_size; }
+
+	private:
+		const std::byte* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+}
+
+#endif
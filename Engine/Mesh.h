@@ -5,6 +5,7 @@
 #include "IndirectDrawBuffer.h"
 #include "CollisionShapes.h"
 #include "AnimData.h"
+#include "GeometryBatch.h"
 
 #include <memory>
 #include <vector>
@@ -34,6 +35,7 @@ namespace JLEngine
 		uint32_t attribKey = 0;
 		uint32_t materialHandle = 0;
 		DrawIndirectCommand command{};
+		GeometryID geometry = InvalidGeometry;	// range in the batched VAO, see GeometryBatch
 	};
 
 	std::string MakeKey(const std::string& meshName, const SubMesh& subMesh);
@@ -64,7 +66,7 @@ namespace JLEngine
 		}
 		void AddInverseBindMatrix(glm::mat4& matrix) { m_inverseBindMatrices.push_back(matrix); }
 
-		Node* node;
+		Node* node = nullptr;
 
 	private:	
 
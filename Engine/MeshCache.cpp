@@ -0,0 +1,526 @@
+#include "MeshCache.h"
+#include "AnimData.h"
+#include "BinaryStream.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+namespace JLEngine
+{
+	namespace
+	{
+		constexpr char CacheMagic[4] = { 'J', 'L', 'M', 'C' };
+		// bump when the file layout or anything the loader cooks into it changes, old caches are then recooked
+		constexpr uint32_t CacheVersion = 1;
+		// blobs start on a 16 byte boundary so the mapped ranges are aligned for any attribute
+		constexpr size_t BlobAlignment = 16;
+
+		// Where a submesh's vertices and indices sit in its attribute key's blobs
+		struct SubMeshRecord
+		{
+			int32_t materialIndex;
+			VertexAttribKey attribKey;
+			AABB aabb;
+			uint32_t blob;
+			uint64_t vertexOffset;
+			uint64_t vertexBytes;
+			uint64_t indexOffset;
+			uint64_t indexCount;
+		};
+
+		struct BlobRecord
+		{
+			VertexAttribKey attribKey;
+			uint64_t vertexBytes;
+			uint64_t indexCount;
+		};
+
+		// file names from source names like "Sponza.glb"
+		std::string SafeFileName(const std::string& name)
+		{
+			std::string result = name.empty() ? "mesh" : name;
+			for (char& c : result)
+			{
+				bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+				if (!keep) c = '_';
+			}
+			return result;
+		}
+
+		void WriteMaterial(BinaryWriter& writer, const GLBMaterialDesc& desc)
+		{
+			writer.String(desc.name);
+			writer.Value(desc.baseColorFactor);
+			writer.Value(desc.metallicFactor);
+			writer.Value(desc.roughnessFactor);
+			writer.Value(desc.emissiveFactor);
+			writer.Value(desc.hasEmissiveStrength);
+			writer.Value(desc.emissiveStrength);
+			writer.Value(desc.transmissionFactor);
+			writer.Value(desc.refractionIndex);
+			writer.Value(desc.thickness);
+			writer.Value(desc.attenuationColor);
+			writer.Value(desc.attenuationDistance);
+			writer.String(desc.alphaMode);
+			writer.Value(desc.alphaCutoff);
+			writer.Value(desc.doubleSided);
+			writer.Value(desc.useTransparency);
+			writer.Value(desc.scale);
+			writer.Value(desc.baseColorTexture);
+			writer.Value(desc.metallicRoughnessTexture);
+			writer.Value(desc.normalTexture);
+			writer.Value(desc.occlusionTexture);
+			writer.Value(desc.emissiveTexture);
+		}
+
+		void ReadMaterial(BinaryReader& reader, GLBMaterialDesc& desc)
+		{
+			reader.String(desc.name);
+			reader.Value(desc.baseColorFactor);
+			reader.Value(desc.metallicFactor);
+			reader.Value(desc.roughnessFactor);
+			reader.Value(desc.emissiveFactor);
+			reader.Value(desc.hasEmissiveStrength);
+			reader.Value(desc.emissiveStrength);
+			reader.Value(desc.transmissionFactor);
+			reader.Value(desc.refractionIndex);
+			reader.Value(desc.thickness);
+			reader.Value(desc.attenuationColor);
+			reader.Value(desc.attenuationDistance);
+			reader.String(desc.alphaMode);
+			reader.Value(desc.alphaCutoff);
+			reader.Value(desc.doubleSided);
+			reader.Value(desc.useTransparency);
+			reader.Value(desc.scale);
+			reader.Value(desc.baseColorTexture);
+			reader.Value(desc.metallicRoughnessTexture);
+			reader.Value(desc.normalTexture);
+			reader.Value(desc.occlusionTexture);
+			reader.Value(desc.emissiveTexture);
+		}
+	}
+
+	uint64_t MeshCache::HashSource(const std::string& sourceFile, uint64_t settingsHash)
+	{
+		MappedFile source;
+		if (!source.Open(sourceFile)) return 0;
+
+		// FNV-1a a word at a time, this runs on every load so it has to keep up with the disk
+		uint64_t hash = 14695981039346656037ull ^ settingsHash;
+		hash *= 1099511628211ull;
+
+		const std::byte* bytes = source.Data();
+		size_t size = source.Size();
+		size_t words = size / sizeof(uint64_t);
+		for (size_t i = 0; i < words; ++i)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(word));
+			hash ^= word;
+			hash *= 1099511628211ull;
+		}
+		for (size_t i = words * sizeof(uint64_t); i < size; ++i)
+		{
+			hash ^= static_cast<uint8_t>(bytes[i]);
+			hash *= 1099511628211ull;
+		}
+
+		hash ^= size;
+		hash *= 1099511628211ull;
+		// 0 means the source couldn't be read
+		return hash != 0 ? hash : 1;
+	}
+
+	std::string MeshCache::CachePath(const std::string& cacheFolder, const std::string& sourceFile, uint64_t hash)
+	{
+		auto stem = std::filesystem::path(sourceFile).stem().string();
+		return (std::filesystem::path(cacheFolder) / (SafeFileName(stem) + "_" + std::to_string(hash) + ".jlmesh")).string();
+	}
+
+	MeshCacheAnimation MeshCache::Snapshot(Animation& animation)
+	{
+		MeshCacheAnimation result;
+		result.name = animation.GetName();
+		result.duration = animation.GetDuration();
+
+		for (const auto& sampler : animation.GetSamplers())
+		{
+			result.samplers.push_back(sampler.GetInterpolation());
+		}
+
+		for (auto& channel : animation.GetChannels())
+		{
+			MeshCacheChannel cached;
+			cached.samplerIndex = channel.GetSamplerIndex();
+			cached.targetNode = channel.GetTargetNode();
+			cached.updated = channel.IsUpdated();
+			cached.path = channel.GetTargetPath();
+			cached.nodeName = channel.GetNodeName();
+			result.channels.push_back(cached);
+		}
+
+		result.keyframes = animation.GetKeyframes();
+		return result;
+	}
+
+	bool MeshCache::Write(const std::string& path, uint64_t hash, const GLBScene& scene, const std::vector<Animation*>& animations)
+	{
+		std::vector<MeshCacheAnimation> snapshots;
+		snapshots.reserve(animations.size());
+		for (auto* animation : animations)
+		{
+			snapshots.push_back(Snapshot(*animation));
+		}
+		return WriteSnapshots(path, hash, scene, snapshots);
+	}
+
+	bool MeshCache::WriteSnapshots(const std::string& path, uint64_t hash, const GLBScene& scene, const std::vector<MeshCacheAnimation>& animations)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) return false;
+
+		BinaryWriter writer(file);
+		writer.Bytes(CacheMagic, sizeof(CacheMagic));
+		writer.Value(CacheVersion);
+		writer.Value(hash);
+
+		// --- GEOMETRY LAYOUT --- //
+		// every submesh with the same attribute key goes in one vertex blob and one index blob
+		std::vector<BlobRecord> blobs;
+		std::unordered_map<VertexAttribKey, uint32_t> blobIndex;
+		std::vector<std::vector<SubMeshRecord>> meshRecords(scene.meshes.size());
+		for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
+		{
+			for (const auto& submesh : scene.meshes[meshIndex].submeshes)
+			{
+				auto it = blobIndex.find(submesh.attribKey);
+				if (it == blobIndex.end())
+				{
+					it = blobIndex.emplace(submesh.attribKey, static_cast<uint32_t>(blobs.size())).first;
+					blobs.push_back({ submesh.attribKey, 0, 0 });
+				}
+
+				auto& blob = blobs[it->second];
+				SubMeshRecord record{};
+				record.materialIndex = submesh.materialIndex;
+				record.attribKey = submesh.attribKey;
+				record.aabb = submesh.aabb;
+				record.blob = it->second;
+				record.vertexOffset = blob.vertexBytes;
+				record.vertexBytes = submesh.vertexBytes;
+				record.indexOffset = blob.indexCount;
+				record.indexCount = submesh.indexCount;
+				meshRecords[meshIndex].push_back(record);
+
+				blob.vertexBytes += submesh.vertexBytes;
+				blob.indexCount += submesh.indexCount;
+			}
+		}
+
+		// --- SCENE --- //
+		writer.Vector(scene.rootNodes);
+
+		writer.Value(static_cast<uint32_t>(scene.nodes.size()));
+		for (const auto& node : scene.nodes)
+		{
+			writer.String(node.name);
+			writer.Value(node.mesh);
+			writer.Value(node.skin);
+			writer.Value(node.camera);
+			writer.Value(node.light);
+			writer.Value(node.translation);
+			writer.Value(node.rotation);
+			writer.Value(node.scale);
+			writer.Vector(node.children);
+		}
+
+		writer.Value(static_cast<uint32_t>(scene.meshes.size()));
+		for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
+		{
+			writer.String(scene.meshes[meshIndex].name);
+			writer.Value(scene.meshes[meshIndex].prepared);
+			writer.Vector(meshRecords[meshIndex]);
+		}
+
+		writer.Value(static_cast<uint32_t>(scene.skins.size()));
+		for (const auto& skin : scene.skins)
+		{
+			writer.String(skin.name);
+			writer.Value(skin.skeleton);
+			writer.Vector(skin.joints);
+			writer.Vector(skin.inverseBindMatrices);
+		}
+
+		writer.Value(scene.hasLights);
+		writer.Value(static_cast<uint32_t>(scene.lights.size()));
+		for (const auto& light : scene.lights)
+		{
+			writer.String(light.type);
+			writer.Value(light.color);
+			writer.Value(light.intensity);
+			writer.Value(light.range);
+			writer.Value(light.innerConeAngle);
+			writer.Value(light.outerConeAngle);
+		}
+
+		writer.Value(static_cast<uint32_t>(scene.materials.size()));
+		for (const auto& material : scene.materials)
+		{
+			WriteMaterial(writer, material);
+		}
+
+		writer.Vector(scene.textureImages);
+
+		writer.Value(static_cast<uint32_t>(scene.images.size()));
+		for (const auto& image : scene.images)
+		{
+			writer.Value(image.width);
+			writer.Value(image.height);
+			writer.Value(image.component);
+			writer.Value(image.bits);
+			writer.Value(static_cast<uint64_t>(image.size));
+		}
+
+		// --- ANIMATIONS --- //
+		writer.Value(static_cast<uint32_t>(animations.size()));
+		for (const auto& animation : animations)
+		{
+			writer.String(animation.name);
+			writer.Value(animation.duration);
+
+			writer.Value(static_cast<uint32_t>(animation.samplers.size()));
+			for (auto interpolation : animation.samplers)
+			{
+				writer.Value(static_cast<uint8_t>(interpolation));
+			}
+
+			writer.Value(static_cast<uint32_t>(animation.channels.size()));
+			for (const auto& channel : animation.channels)
+			{
+				writer.Value(static_cast<int32_t>(channel.samplerIndex));
+				writer.Value(static_cast<int32_t>(channel.targetNode));
+				writer.Value(static_cast<uint8_t>(channel.updated));
+				writer.Value(static_cast<uint8_t>(channel.path));
+				writer.String(channel.nodeName);
+			}
+
+			animation.keyframes.Write(writer);
+		}
+
+		// --- BLOBS --- //
+		writer.Vector(blobs);
+		for (uint32_t blob = 0; blob < blobs.size(); ++blob)
+		{
+			writer.Align(BlobAlignment);
+			for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
+			{
+				const auto& submeshes = scene.meshes[meshIndex].submeshes;
+				for (size_t i = 0; i < submeshes.size(); ++i)
+				{
+					if (meshRecords[meshIndex][i].blob == blob)
+						writer.Bytes(submeshes[i].vertices, submeshes[i].vertexBytes);
+				}
+			}
+
+			writer.Align(BlobAlignment);
+			for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
+			{
+				const auto& submeshes = scene.meshes[meshIndex].submeshes;
+				for (size_t i = 0; i < submeshes.size(); ++i)
+				{
+					if (meshRecords[meshIndex][i].blob == blob)
+						writer.Bytes(submeshes[i].indices, submeshes[i].indexCount * sizeof(uint32_t));
+				}
+			}
+		}
+
+		for (const auto& image : scene.images)
+		{
+			writer.Align(BlobAlignment);
+			writer.Bytes(image.pixels, image.size);
+		}
+
+		return writer.Good();
+	}
+
+	bool MeshCache::Open(const std::string& path, uint64_t expectedHash)
+	{
+		Close();
+		if (!m_file.Open(path)) return false;
+
+		BinaryReader reader(m_file.Data(), m_file.Size());
+		char magic[4] = {};
+		const std::byte* magicBytes = reader.Bytes(sizeof(magic));
+		if (magicBytes) std::memcpy(magic, magicBytes, sizeof(magic));
+		uint32_t version = reader.Value<uint32_t>();
+		uint64_t hash = reader.Value<uint64_t>();
+
+		if (!reader.Good() || std::memcmp(magic, CacheMagic, sizeof(magic)) != 0 || version != CacheVersion || hash != expectedHash)
+		{
+			Close();
+			return false;
+		}
+
+		// --- SCENE --- //
+		reader.Vector(m_scene.rootNodes);
+
+		m_scene.nodes.resize(reader.Value<uint32_t>());
+		for (auto& node : m_scene.nodes)
+		{
+			if (!reader.Good()) break;
+			reader.String(node.name);
+			reader.Value(node.mesh);
+			reader.Value(node.skin);
+			reader.Value(node.camera);
+			reader.Value(node.light);
+			reader.Value(node.translation);
+			reader.Value(node.rotation);
+			reader.Value(node.scale);
+			reader.Vector(node.children);
+		}
+
+		std::vector<std::vector<SubMeshRecord>> meshRecords(reader.Value<uint32_t>());
+		m_scene.meshes.resize(meshRecords.size());
+		for (size_t meshIndex = 0; meshIndex < meshRecords.size() && reader.Good(); ++meshIndex)
+		{
+			reader.String(m_scene.meshes[meshIndex].name);
+			reader.Value(m_scene.meshes[meshIndex].prepared);
+			reader.Vector(meshRecords[meshIndex]);
+		}
+
+		m_scene.skins.resize(reader.Value<uint32_t>());
+		for (auto& skin : m_scene.skins)
+		{
+			if (!reader.Good()) break;
+			reader.String(skin.name);
+			reader.Value(skin.skeleton);
+			reader.Vector(skin.joints);
+			reader.Vector(skin.inverseBindMatrices);
+		}
+
+		reader.Value(m_scene.hasLights);
+		m_scene.lights.resize(reader.Value<uint32_t>());
+		for (auto& light : m_scene.lights)
+		{
+			if (!reader.Good()) break;
+			reader.String(light.type);
+			reader.Value(light.color);
+			reader.Value(light.intensity);
+			reader.Value(light.range);
+			reader.Value(light.innerConeAngle);
+			reader.Value(light.outerConeAngle);
+		}
+
+		m_scene.materials.resize(reader.Value<uint32_t>());
+		for (auto& material : m_scene.materials)
+		{
+			if (!reader.Good()) break;
+			ReadMaterial(reader, material);
+		}
+
+		reader.Vector(m_scene.textureImages);
+
+		m_scene.images.resize(reader.Value<uint32_t>());
+		for (auto& image : m_scene.images)
+		{
+			if (!reader.Good()) break;
+			reader.Value(image.width);
+			reader.Value(image.height);
+			reader.Value(image.component);
+			reader.Value(image.bits);
+			image.size = static_cast<size_t>(reader.Value<uint64_t>());
+		}
+
+		// --- ANIMATIONS --- //
+		bool keyframesValid = true;
+		m_animations.resize(reader.Value<uint32_t>());
+		for (auto& animation : m_animations)
+		{
+			if (!reader.Good()) break;
+			reader.String(animation.name);
+			reader.Value(animation.duration);
+
+			animation.samplers.resize(reader.Value<uint32_t>());
+			for (auto& sampler : animation.samplers)
+			{
+				if (!reader.Good()) break;
+				sampler = static_cast<InterpolationType>(reader.Value<uint8_t>());
+			}
+
+			animation.channels.resize(reader.Value<uint32_t>());
+			for (auto& channel : animation.channels)
+			{
+				if (!reader.Good()) break;
+				channel.samplerIndex = reader.Value<int32_t>();
+				channel.targetNode = reader.Value<int32_t>();
+				channel.updated = reader.Value<uint8_t>() != 0;
+				channel.path = static_cast<TargetPath>(reader.Value<uint8_t>());
+				reader.String(channel.nodeName);
+			}
+
+			keyframesValid = animation.keyframes.Read(reader);
+			if (!keyframesValid) break;
+		}
+
+		// --- BLOBS --- //
+		// the views point straight into the mapping
+		std::vector<BlobRecord> blobs;
+		reader.Vector(blobs);
+		std::vector<const std::byte*> blobVertices(blobs.size(), nullptr);
+		std::vector<const uint32_t*> blobIndices(blobs.size(), nullptr);
+		for (size_t blob = 0; blob < blobs.size() && reader.Good(); ++blob)
+		{
+			reader.Align(BlobAlignment);
+			blobVertices[blob] = reader.Array<std::byte>(static_cast<size_t>(blobs[blob].vertexBytes));
+			reader.Align(BlobAlignment);
+			blobIndices[blob] = reader.Array<uint32_t>(static_cast<size_t>(blobs[blob].indexCount));
+		}
+
+		for (auto& image : m_scene.images)
+		{
+			if (!reader.Good()) break;
+			reader.Align(BlobAlignment);
+			image.pixels = reinterpret_cast<const unsigned char*>(reader.Array<std::byte>(image.size));
+		}
+
+		bool valid = reader.Good() && keyframesValid;
+		for (size_t meshIndex = 0; valid && meshIndex < meshRecords.size(); ++meshIndex)
+		{
+			for (const auto& record : meshRecords[meshIndex])
+			{
+				valid = record.blob < blobs.size() &&
+					record.vertexOffset + record.vertexBytes <= blobs[record.blob].vertexBytes &&
+					record.indexOffset + record.indexCount <= blobs[record.blob].indexCount;
+				if (!valid) break;
+
+				GLBSubMeshView view;
+				view.materialIndex = record.materialIndex;
+				view.attribKey = record.attribKey;
+				view.aabb = record.aabb;
+				view.vertices = blobVertices[record.blob] + record.vertexOffset;
+				view.vertexBytes = static_cast<size_t>(record.vertexBytes);
+				view.indices = blobIndices[record.blob] + record.indexOffset;
+				view.indexCount = static_cast<size_t>(record.indexCount);
+				m_scene.meshes[meshIndex].submeshes.push_back(view);
+			}
+		}
+
+		if (!valid)
+		{
+			std::cerr << "MeshCache: " << path << " is truncated or corrupt, the source will be loaded instead" << std::endl;
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MeshCache::Close()
+	{
+		m_scene.Clear();
+		m_animations.clear();
+		m_file.Close();
+	}
+}
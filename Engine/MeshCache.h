@@ -0,0 +1,69 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GLBImporter.h"
+#include "KeyframeSampler.h"
+#include "MappedFile.h"
+
+namespace JLEngine
+{
+	class Animation;
+
+	struct MeshCacheChannel
+	{
+		int samplerIndex = 0;
+		int targetNode = -1;
+		bool updated = false;		// already retargeted to a joint index by GLBLoader::ParseSkin
+		TargetPath path = TargetPath::TRANSLATION;
+		std::string nodeName;
+	};
+
+	// An animation as GLBLoader left it, compressed keyframes and retargeted channels
+	struct MeshCacheAnimation
+	{
+		std::string name;
+		float duration = 0.0f;
+		std::vector<InterpolationType> samplers;
+		std::vector<MeshCacheChannel> channels;
+		KeyframeSampler keyframes;
+	};
+
+	// Cooked GLB import, written after a file is first loaded. Holds the GLBScene the merge reads with
+	// the interleaved vertices and indices of every attribute key in one blob each, the decoded
+	// pixels, and the file's animations. Opening maps the file and points the scene's views into
+	// the blobs, so a hit parses no JSON, decodes no images and touches no vertex until the VAOs
+	// copy their ranges. Keyed by a hash of the source file and the import settings
+	class MeshCache
+	{
+	public:
+		// FNV-1a over the source file's bytes, seeded with the settings hash. 0 when it can't be read
+		static uint64_t HashSource(const std::string& sourceFile, uint64_t settingsHash);
+		static std::string CachePath(const std::string& cacheFolder, const std::string& sourceFile, uint64_t hash);
+
+		// Only the prepared meshes are written, animations are taken after the merge so their channels
+		// are already retargeted
+		static bool Write(const std::string& path, uint64_t hash, const GLBScene& scene, const std::vector<Animation*>& animations);
+		// From copies, so a streamed load can write its cache on a worker while the animations play
+		static bool WriteSnapshots(const std::string& path, uint64_t hash, const GLBScene& scene, const std::vector<MeshCacheAnimation>& animations);
+		static MeshCacheAnimation Snapshot(Animation& animation);
+
+		// False when the file is missing, from another version or source, or truncated
+		bool Open(const std::string& path, uint64_t expectedHash);
+		void Close();
+
+		// Valid until Close, the views point into the mapping
+		GLBScene& GetScene() { return m_scene; }
+		std::vector<MeshCacheAnimation>& GetAnimations() { return m_animations; }
+
+	private:
+		MappedFile m_file;
+		GLBScene m_scene;
+		std::vector<MeshCacheAnimation> m_animations;
+	};
+}
+
+#endif
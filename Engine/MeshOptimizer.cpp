@@ -0,0 +1,296 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+namespace JLEngine
+{
+	namespace
+	{
+		glm::vec3 ReadPosition(const std::byte* vertices, uint32_t stride, uint32_t index)
+		{
+			float p[3];
+			std::memcpy(p, vertices + static_cast<size_t>(index) * stride, sizeof(p));
+			return glm::vec3(p[0], p[1], p[2]);
+		}
+	}
+
+	MeshOptimizationStats MeshOptimizer::Optimize(std::vector<std::byte>& vertices, uint32_t stride, std::vector<uint32_t>& indices)
+	{
+		MeshOptimizationStats stats;
+		if (stride < sizeof(float) * 3 || vertices.size() % stride != 0) return stats;
+
+		size_t vertexCount = vertices.size() / stride;
+		stats.triangles = indices.size() / 3;
+		stats.verticesBefore = vertexCount;
+		stats.verticesAfter = vertexCount;
+
+		bool inRange = std::all_of(indices.begin(), indices.end(), [vertexCount](uint32_t index) { return index < vertexCount; });
+		if (indices.size() % 3 != 0 || !inRange) return stats;
+
+		stats.missesBefore = CountCacheMisses(indices, vertexCount);
+
+		vertexCount = DeduplicateVertices(vertices, stride, indices);
+
+		std::vector<uint32_t> clusterStarts;
+		OptimizeVertexCache(indices, vertexCount, &clusterStarts);
+		OptimizeOverdraw(indices, vertices.data(), stride, clusterStarts);
+
+		stats.verticesAfter = OptimizeVertexFetch(vertices, stride, indices);
+		stats.missesAfter = CountCacheMisses(indices, stats.verticesAfter);
+		return stats;
+	}
+
+	size_t MeshOptimizer::DeduplicateVertices(std::vector<std::byte>& vertices, uint32_t stride, std::vector<uint32_t>& indices)
+	{
+		size_t vertexCount = vertices.size() / stride;
+
+		// the keys view the old buffer, the unique vertices go to a new one
+		std::vector<std::byte> unique;
+		unique.reserve(vertices.size());
+		std::vector<uint32_t> remap(vertexCount);
+		std::unordered_map<std::string_view, uint32_t> seen;
+		seen.reserve(vertexCount);
+
+		const char* source = reinterpret_cast<const char*>(vertices.data());
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			std::string_view bytes(source + v * stride, stride);
+			auto [it, inserted] = seen.emplace(bytes, static_cast<uint32_t>(unique.size() / stride));
+			if (inserted)
+			{
+				unique.insert(unique.end(), vertices.begin() + v * stride, vertices.begin() + (v + 1) * stride);
+			}
+			remap[v] = it->second;
+		}
+
+		for (auto& index : indices)
+		{
+			index = remap[index];
+		}
+
+		size_t uniqueCount = unique.size() / stride;
+		seen.clear();
+		vertices = std::move(unique);
+		return uniqueCount;
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusterStarts)
+	{
+		if (clusterStarts) clusterStarts->clear();
+
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0) return;
+
+		// --- TRIANGLES AROUND EACH VERTEX --- //
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (uint32_t index : indices) offsets[index + 1]++;
+		for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// triangles not yet emitted around each vertex
+		std::vector<uint32_t> live(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v) live[v] = offsets[v + 1] - offsets[v];
+
+		// time is bumped on every simulated miss, a vertex is in cache while time - cacheTime <= CacheSize
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		uint32_t time = CacheSize + 1;
+		auto inCache = [&](uint32_t v) { return time - cacheTime[v] <= CacheSize; };
+
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnd;
+		deadEnd.reserve(indices.size());
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		size_t cursor = 0;
+		auto nextLive = [&]() -> int64_t
+			{
+				// the most recently used vertices that still have triangles, then any vertex that does
+				while (!deadEnd.empty())
+				{
+					uint32_t v = deadEnd.back();
+					deadEnd.pop_back();
+					if (live[v] > 0) return v;
+				}
+				while (cursor < vertexCount)
+				{
+					if (live[cursor] > 0) return static_cast<int64_t>(cursor);
+					++cursor;
+				}
+				return -1;
+			};
+
+		int64_t fanning = nextLive();
+		bool coldStart = true;
+		while (fanning >= 0)
+		{
+			// --- EMIT THE FAN --- //
+			candidates.clear();
+			for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+			{
+				uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) continue;
+				emitted[triangle] = 1;
+
+				if (coldStart && clusterStarts)
+				{
+					clusterStarts->push_back(static_cast<uint32_t>(output.size() / 3));
+				}
+				coldStart = false;
+
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					uint32_t v = indices[triangle * 3 + corner];
+					output.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+					if (!inCache(v)) cacheTime[v] = time++;
+				}
+			}
+
+			// --- NEXT FANNING VERTEX --- //
+			// the oldest candidate that will still be in cache once its own fan is emitted
+			int64_t best = -1;
+			int64_t bestPriority = -1;
+			for (uint32_t v : candidates)
+			{
+				if (live[v] == 0) continue;
+
+				int64_t age = time - cacheTime[v];
+				int64_t priority = age + 2 * static_cast<int64_t>(live[v]) <= CacheSize ? age : 0;
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					best = v;
+				}
+			}
+
+			if (best < 0)
+			{
+				best = nextLive();
+				coldStart = best >= 0 && !inCache(static_cast<uint32_t>(best));
+			}
+			fanning = best;
+		}
+
+		indices = std::move(output);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::byte* vertices, uint32_t stride, const std::vector<uint32_t>& clusterStarts)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if (clusterStarts.size() < 2 || triangleCount == 0) return;
+
+		struct Cluster
+		{
+			uint32_t first = 0;
+			uint32_t end = 0;
+			glm::vec3 centroid{ 0.0f };
+			glm::vec3 normal{ 0.0f };
+			float area = 0.0f;
+			float sortKey = 0.0f;
+		};
+
+		std::vector<Cluster> clusters(clusterStarts.size());
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			Cluster& cluster = clusters[c];
+			cluster.first = clusterStarts[c];
+			cluster.end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : static_cast<uint32_t>(triangleCount);
+
+			for (uint32_t t = cluster.first; t < cluster.end; ++t)
+			{
+				glm::vec3 p0 = ReadPosition(vertices, stride, indices[t * 3]);
+				glm::vec3 p1 = ReadPosition(vertices, stride, indices[t * 3 + 1]);
+				glm::vec3 p2 = ReadPosition(vertices, stride, indices[t * 3 + 2]);
+
+				// twice the area, the factor cancels out
+				glm::vec3 areaNormal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(areaNormal);
+				cluster.normal += areaNormal;
+				cluster.centroid += (p0 + p1 + p2) * (area / 3.0f);
+				cluster.area += area;
+			}
+
+			meshCentroid += cluster.centroid;
+			meshArea += cluster.area;
+			if (cluster.area > 0.0f) cluster.centroid /= cluster.area;
+		}
+
+		if (meshArea <= 0.0f) return;
+		meshCentroid /= meshArea;
+
+		for (auto& cluster : clusters)
+		{
+			float normalLength = glm::length(cluster.normal);
+			cluster.sortKey = normalLength > 0.0f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / normalLength) : 0.0f;
+		}
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+		std::vector<uint32_t> sorted;
+		sorted.reserve(indices.size());
+		for (const auto& cluster : clusters)
+		{
+			sorted.insert(sorted.end(), indices.begin() + cluster.first * 3, indices.begin() + cluster.end * 3);
+		}
+		indices = std::move(sorted);
+	}
+
+	size_t MeshOptimizer::OptimizeVertexFetch(std::vector<std::byte>& vertices, uint32_t stride, std::vector<uint32_t>& indices)
+	{
+		size_t vertexCount = vertices.size() / stride;
+		constexpr uint32_t Unused = UINT32_MAX;
+		std::vector<uint32_t> remap(vertexCount, Unused);
+
+		std::vector<std::byte> reordered;
+		reordered.reserve(vertices.size());
+		uint32_t next = 0;
+		for (auto& index : indices)
+		{
+			if (remap[index] == Unused)
+			{
+				remap[index] = next++;
+				reordered.insert(reordered.end(), vertices.begin() + static_cast<size_t>(index) * stride,
+					vertices.begin() + (static_cast<size_t>(index) + 1) * stride);
+			}
+			index = remap[index];
+		}
+
+		vertices = std::move(reordered);
+		return next;
+	}
+
+	size_t MeshOptimizer::CountCacheMisses(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		// 1 + the miss count when the vertex went in, 0 never. FIFO, so it stays for cacheSize misses
+		std::vector<size_t> insertedAt(vertexCount, 0);
+		size_t misses = 0;
+		for (uint32_t index : indices)
+		{
+			if (index >= vertexCount) continue;
+
+			size_t inserted = insertedAt[index];
+			if (inserted != 0 && misses - (inserted - 1) <= cacheSize) continue;
+
+			insertedAt[index] = misses + 1;
+			++misses;
+		}
+		return misses;
+	}
+}
@@ -0,0 +1,66 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace JLEngine
+{
+	struct MeshOptimizationStats
+	{
+		size_t triangles = 0;
+		size_t verticesBefore = 0;
+		size_t verticesAfter = 0;
+		// post transform cache misses on a FIFO of MeshOptimizer::CacheSize entries
+		size_t missesBefore = 0;
+		size_t missesAfter = 0;
+
+		// misses per triangle, 0.5 is the best a large regular mesh can do
+		float AcmrBefore() const { return triangles > 0 ? static_cast<float>(missesBefore) / triangles : 0.0f; }
+		float AcmrAfter() const { return triangles > 0 ? static_cast<float>(missesAfter) / triangles : 0.0f; }
+		// misses per vertex, 1.0 transforms every vertex once
+		float AtvrBefore() const { return verticesBefore > 0 ? static_cast<float>(missesBefore) / verticesBefore : 0.0f; }
+		float AtvrAfter() const { return verticesAfter > 0 ? static_cast<float>(missesAfter) / verticesAfter : 0.0f; }
+
+		MeshOptimizationStats& operator+=(const MeshOptimizationStats& other)
+		{
+			triangles += other.triangles;
+			verticesBefore += other.verticesBefore;
+			verticesAfter += other.verticesAfter;
+			missesBefore += other.missesBefore;
+			missesAfter += other.missesAfter;
+			return *this;
+		}
+	};
+
+	// Import time reordering of an indexed triangle list. Identical vertices are merged, the triangles
+	// are reordered for the post transform cache with Tipsify (Sander et al. 2007), the runs it starts
+	// after a cache flush are sorted outward facing first to cut overdraw, and the vertices are
+	// renumbered in the order the triangles use them. Only the order changes, every triangle is kept
+	// with its winding
+	class MeshOptimizer
+	{
+	public:
+		static constexpr uint32_t CacheSize = 16;
+
+		// Interleaved vertices with the position as three floats at the start, as every layout
+		// CalculateStrideInBytes describes. Lists that aren't whole triangles or index past the
+		// vertices are left alone, the stats then only have the before numbers
+		static MeshOptimizationStats Optimize(std::vector<std::byte>& vertices, uint32_t stride, std::vector<uint32_t>& indices);
+
+		// --- STAGES --- //
+		// Merges vertices whose bytes are identical, returns the vertex count left
+		static size_t DeduplicateVertices(std::vector<std::byte>& vertices, uint32_t stride, std::vector<uint32_t>& indices);
+		// Tipsify. clusterStarts gets the first triangle of every run that began with the cache cold
+		static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusterStarts = nullptr);
+		// Draws the clusters facing away from the mesh centre first, they tend to hide the rest
+		static void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::byte* vertices, uint32_t stride, const std::vector<uint32_t>& clusterStarts);
+		// Renumbers the vertices in first use order, unused ones are dropped. Returns the vertex count
+		static size_t OptimizeVertexFetch(std::vector<std::byte>& vertices, uint32_t stride, std::vector<uint32_t>& indices);
+
+		static size_t CountCacheMisses(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = CacheSize);
+	};
+}
+
+#endif
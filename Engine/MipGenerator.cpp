@@ -0,0 +1,421 @@
+#include "MipGenerator.h"
+#include "ImageConversion.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JL_MIP_SSE
+#include <emmintrin.h>
+#endif
+
+namespace JLEngine
+{
+	namespace
+	{
+		// bump when a filter changes, cached chains are then rebuilt
+		constexpr uint32_t MipVersion = 1;
+
+		constexpr int MaxTaps = 8;
+
+		// The source texels behind one destination texel along an axis: taps from 2x + firstTap
+		struct FilterKernel
+		{
+			int taps = 0;
+			int firstTap = 0;
+			std::array<float, MaxTaps> weights{};
+		};
+
+		double BesselI0(double x)
+		{
+			double sum = 1.0, term = 1.0;
+			for (int k = 1; k < 32; ++k)
+			{
+				term *= (x / (2.0 * k)) * (x / (2.0 * k));
+				sum += term;
+			}
+			return sum;
+		}
+
+		const FilterKernel& Kernel(MipFilter filter)
+		{
+			static const FilterKernel box = []()
+				{
+					FilterKernel kernel;
+					kernel.taps = 2;
+					kernel.weights = { 0.5f, 0.5f };
+					return kernel;
+				}();
+
+			// sinc at half the source rate under a Kaiser window 4 texels either side, the taps sit
+			// 0.5, 1.5, 2.5 and 3.5 texels from the destination texel's centre
+			static const FilterKernel kaiser = []()
+				{
+					const double pi = 3.14159265358979323846;
+					const double beta = 4.0;
+					FilterKernel kernel;
+					kernel.taps = 8;
+					kernel.firstTap = -3;
+					double sum = 0.0;
+					double weights[MaxTaps];
+					for (int k = 0; k < 8; ++k)
+					{
+						double d = k - 3.5;
+						double x = pi * d * 0.5;
+						double sinc = std::sin(x) / x;
+						double t = d / 4.0;
+						weights[k] = sinc * BesselI0(beta * std::sqrt(1.0 - t * t)) / BesselI0(beta);
+						sum += weights[k];
+					}
+					for (int k = 0; k < 8; ++k)
+						kernel.weights[k] = static_cast<float>(weights[k] / sum);
+					return kernel;
+				}();
+
+			return filter == MipFilter::Box ? box : kaiser;
+		}
+
+		// Source index of every tap of every destination texel along one axis. The box reads the
+		// last texel twice on odd sizes like the GPU's own mips
+		std::vector<uint32_t> TapIndices(const FilterKernel& kernel, uint32_t size, uint32_t outSize, bool wrap)
+		{
+			std::vector<uint32_t> indices(static_cast<size_t>(outSize) * kernel.taps);
+			for (uint32_t x = 0; x < outSize; ++x)
+			{
+				for (int k = 0; k < kernel.taps; ++k)
+				{
+					int64_t i = static_cast<int64_t>(x) * 2 + kernel.firstTap + k;
+					if (wrap && kernel.taps > 2)
+						i = ((i % size) + size) % size;
+					else
+						i = std::clamp<int64_t>(i, 0, size - 1);
+					indices[static_cast<size_t>(x) * kernel.taps + k] = static_cast<uint32_t>(i);
+				}
+			}
+			return indices;
+		}
+
+		// One RGBA float texel times a weight added to the sum
+		struct Accumulator
+		{
+#if defined(JL_MIP_SSE)
+			__m128 sum = _mm_setzero_ps();
+			void Add(const float* texel, float weight) { sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(texel), _mm_set1_ps(weight))); }
+			void Store(float* out) const { _mm_storeu_ps(out, sum); }
+#else
+			float sum[4] = {};
+			void Add(const float* texel, float weight) { for (int c = 0; c < 4; ++c) sum[c] += texel[c] * weight; }
+			void Store(float* out) const { std::memcpy(out, sum, sizeof(sum)); }
+#endif
+		};
+
+		size_t RowGrain(uint32_t width)
+		{
+			// enough texels per chunk that a job is worth its overhead
+			return std::max<size_t>(1, 16384 / std::max<uint32_t>(width, 1));
+		}
+
+		template <typename Fn>
+		void ForRows(JobSystem* jobs, uint32_t rows, uint32_t width, Fn&& fn)
+		{
+			if (jobs)
+			{
+				jobs->ParallelFor(rows, RowGrain(width), [&fn](size_t begin, size_t end, unsigned) { fn(begin, end); });
+				return;
+			}
+			fn(size_t(0), size_t(rows));
+		}
+
+		// Half size in both directions, horizontally into scratch then vertically into out
+		void DownsampleLevel(const std::vector<float>& level, uint32_t width, uint32_t height, const MipSettings& settings,
+			std::vector<float>& scratch, std::vector<float>& out, JobSystem* jobs)
+		{
+			const FilterKernel& kernel = Kernel(settings.filter);
+			uint32_t outWidth = std::max(width / 2, 1u);
+			uint32_t outHeight = std::max(height / 2, 1u);
+			auto columns = TapIndices(kernel, width, outWidth, settings.wrap);
+			auto rows = TapIndices(kernel, height, outHeight, settings.wrap);
+
+			scratch.resize(static_cast<size_t>(outWidth) * height * 4);
+			ForRows(jobs, height, width, [&](size_t begin, size_t end)
+				{
+					for (size_t y = begin; y < end; ++y)
+					{
+						const float* src = level.data() + y * width * 4;
+						float* dst = scratch.data() + y * outWidth * 4;
+						for (uint32_t x = 0; x < outWidth; ++x)
+						{
+							const uint32_t* taps = &columns[static_cast<size_t>(x) * kernel.taps];
+							Accumulator sum;
+							for (int k = 0; k < kernel.taps; ++k)
+								sum.Add(src + static_cast<size_t>(taps[k]) * 4, kernel.weights[k]);
+							sum.Store(dst + x * 4);
+						}
+					}
+				});
+
+			out.resize(static_cast<size_t>(outWidth) * outHeight * 4);
+			ForRows(jobs, outHeight, outWidth, [&](size_t begin, size_t end)
+				{
+					for (size_t y = begin; y < end; ++y)
+					{
+						const float* srcRows[MaxTaps];
+						for (int k = 0; k < kernel.taps; ++k)
+							srcRows[k] = scratch.data() + static_cast<size_t>(rows[y * kernel.taps + k]) * outWidth * 4;
+						float* dst = out.data() + y * outWidth * 4;
+						for (uint32_t x = 0; x < outWidth; ++x)
+						{
+							Accumulator sum;
+							for (int k = 0; k < kernel.taps; ++k)
+								sum.Add(srcRows[k] + x * 4, kernel.weights[k]);
+							sum.Store(dst + x * 4);
+						}
+					}
+				});
+
+			if (settings.normalMap)
+			{
+				for (size_t i = 0; i < out.size(); i += 4)
+				{
+					float* n = &out[i];
+					float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+					if (length > 1e-6f)
+					{
+						n[0] /= length;
+						n[1] /= length;
+						n[2] /= length;
+					}
+					else
+					{
+						n[0] = n[1] = 0.0f;
+						n[2] = 1.0f;
+					}
+				}
+			}
+		}
+
+		// Any channel count to RGBA floats, missing colour channels are 0 and a missing alpha is opaque
+		void Decode(const uint8_t* pixels, size_t count, int channels, const MipSettings& settings, std::vector<float>& rgba)
+		{
+			rgba.resize(count * 4);
+			std::vector<uint8_t> expanded;
+			const uint8_t* source = pixels;
+			if (channels == 3)
+			{
+				expanded.resize(count * 4);
+				ImageConversion::ExpandRGBToRGBA(pixels, expanded.data(), count);
+				source = expanded.data();
+			}
+			else if (channels != 4)
+			{
+				expanded.assign(count * 4, 0);
+				for (size_t i = 0; i < count; ++i)
+				{
+					for (int c = 0; c < channels; ++c)
+						expanded[i * 4 + c] = pixels[i * channels + c];
+					expanded[i * 4 + 3] = 255;
+				}
+				source = expanded.data();
+			}
+
+			if (settings.srgb && !settings.normalMap)
+				ImageConversion::SRGBToLinear(source, rgba.data(), count, 4);
+			else
+				ImageConversion::UnormToFloat(source, rgba.data(), count * 4);
+
+			if (settings.normalMap)
+			{
+				for (size_t i = 0; i < rgba.size(); i += 4)
+				{
+					rgba[i + 0] = rgba[i + 0] * 2.0f - 1.0f;
+					rgba[i + 1] = rgba[i + 1] * 2.0f - 1.0f;
+					rgba[i + 2] = rgba[i + 2] * 2.0f - 1.0f;
+				}
+			}
+		}
+
+		// RGBA floats back to the source's channels, the alpha scaled for coverage
+		void Encode(const std::vector<float>& rgba, int channels, const MipSettings& settings, float alphaScale, uint8_t* out)
+		{
+			size_t count = rgba.size() / 4;
+			std::vector<uint8_t> encoded(rgba.size());
+			if (settings.normalMap)
+			{
+				std::vector<float> mapped(rgba);
+				for (size_t i = 0; i < mapped.size(); i += 4)
+				{
+					mapped[i + 0] = mapped[i + 0] * 0.5f + 0.5f;
+					mapped[i + 1] = mapped[i + 1] * 0.5f + 0.5f;
+					mapped[i + 2] = mapped[i + 2] * 0.5f + 0.5f;
+				}
+				ImageConversion::FloatToUnorm(mapped.data(), encoded.data(), encoded.size());
+			}
+			else if (settings.srgb)
+				ImageConversion::LinearToSRGB(rgba.data(), encoded.data(), count, 4);
+			else
+				ImageConversion::FloatToUnorm(rgba.data(), encoded.data(), encoded.size());
+
+			if (alphaScale != 1.0f)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					float alpha = rgba[i * 4 + 3] * alphaScale;
+					ImageConversion::FloatToUnorm(&alpha, &encoded[i * 4 + 3], 1);
+				}
+			}
+
+			if (channels == 4)
+			{
+				std::memcpy(out, encoded.data(), encoded.size());
+				return;
+			}
+			for (size_t i = 0; i < count; ++i)
+				for (int c = 0; c < channels; ++c)
+					out[i * channels + c] = encoded[i * 4 + c];
+		}
+
+		// The alpha scale that brings the level's coverage closest to the top level's. Small levels
+		// only have a few distinct alphas, so the scales either side of the step are compared
+		float CoverageScale(const std::vector<float>& rgba, float cutoff, float target)
+		{
+			size_t count = rgba.size() / 4;
+			float low = 0.0f, high = 1.0f;
+			while (MipGenerator::AlphaCoverage(rgba.data(), count, cutoff, high) < target && high < 64.0f)
+				high *= 2.0f;
+			for (int i = 0; i < 16; ++i)
+			{
+				float mid = (low + high) * 0.5f;
+				if (MipGenerator::AlphaCoverage(rgba.data(), count, cutoff, mid) < target)
+					low = mid;
+				else
+					high = mid;
+			}
+			float above = MipGenerator::AlphaCoverage(rgba.data(), count, cutoff, high) - target;
+			float below = target - MipGenerator::AlphaCoverage(rgba.data(), count, cutoff, low);
+			return below < above ? low : high;
+		}
+	}
+
+	uint32_t MipGenerator::MipCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+			++levels;
+		return levels;
+	}
+
+	MipChain MipGenerator::Generate(const uint8_t* pixels, uint32_t width, uint32_t height, int channels,
+		const MipSettings& settings, JobSystem* jobs)
+	{
+		MipChain chain;
+		if (pixels == nullptr || width == 0 || height == 0 || channels < 1 || channels > 4) return chain;
+
+		chain.width = width;
+		chain.height = height;
+		chain.channels = channels;
+
+		size_t offset = 0;
+		uint32_t mipCount = MipCount(width, height);
+		for (uint32_t mip = 0; mip < mipCount; ++mip)
+		{
+			MipLevel level;
+			level.width = std::max(width >> mip, 1u);
+			level.height = std::max(height >> mip, 1u);
+			level.offset = offset;
+			level.size = static_cast<size_t>(level.width) * level.height * channels;
+			chain.levels.push_back(level);
+			offset += level.size;
+		}
+		chain.pixels.resize(offset);
+		std::memcpy(chain.pixels.data(), pixels, chain.levels[0].size);
+
+		std::vector<float> level, next, scratch;
+		Decode(pixels, static_cast<size_t>(width) * height, channels, settings, level);
+
+		bool keepCoverage = channels == 4 && settings.alphaCutoff > 0.0f && settings.alphaCutoff < 1.0f;
+		float coverage = keepCoverage ? AlphaCoverage(level.data(), level.size() / 4, settings.alphaCutoff, 1.0f) : 0.0f;
+
+		for (uint32_t mip = 1; mip < mipCount; ++mip)
+		{
+			const auto& parent = chain.levels[mip - 1];
+			DownsampleLevel(level, parent.width, parent.height, settings, scratch, next, jobs);
+			std::swap(level, next);
+
+			float alphaScale = keepCoverage ? CoverageScale(level, settings.alphaCutoff, coverage) : 1.0f;
+			Encode(level, channels, settings, alphaScale, chain.pixels.data() + chain.levels[mip].offset);
+		}
+		return chain;
+	}
+
+	void MipGenerator::Generate(std::vector<MipRequest>& requests, JobSystem& jobs)
+	{
+		JobCounter counter;
+		for (auto& request : requests)
+		{
+			jobs.Submit([&request, &jobs]()
+				{
+					request.chain = Generate(request.pixels, request.width, request.height, request.channels, request.settings, &jobs);
+				}, &counter);
+		}
+		jobs.Wait(counter);
+	}
+
+	std::vector<uint8_t> MipGenerator::Downsample(const uint8_t* pixels, uint32_t width, uint32_t height, int channels, const MipSettings& settings)
+	{
+		std::vector<float> level, next, scratch;
+		Decode(pixels, static_cast<size_t>(width) * height, channels, settings, level);
+		DownsampleLevel(level, width, height, settings, scratch, next, nullptr);
+
+		std::vector<uint8_t> result(next.size() / 4 * channels);
+		Encode(next, channels, settings, 1.0f, result.data());
+		return result;
+	}
+
+	float MipGenerator::AlphaCoverage(const float* rgba, size_t pixels, float cutoff, float scale)
+	{
+		if (pixels == 0) return 0.0f;
+
+		// the same test the gbuffer shader discards with
+		size_t covered = 0;
+		for (size_t i = 0; i < pixels; ++i)
+		{
+			if (std::min(rgba[i * 4 + 3] * scale, 1.0f) >= cutoff)
+				++covered;
+		}
+		return static_cast<float>(covered) / static_cast<float>(pixels);
+	}
+
+	uint64_t MipGenerator::CacheHash(uint64_t sourceHash, int imageIndex, const MipSettings& settings)
+	{
+		// FNV-1a like the other caches, the source hash already covers the file's bytes
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [&hash](const void* data, size_t size)
+			{
+				auto bytes = static_cast<const uint8_t*>(data);
+				for (size_t i = 0; i < size; ++i)
+				{
+					hash ^= bytes[i];
+					hash *= 1099511628211ull;
+				}
+			};
+
+		mix(&sourceHash, sizeof(sourceHash));
+		mix(&imageIndex, sizeof(imageIndex));
+		mix(&settings.filter, sizeof(settings.filter));
+		mix(&settings.srgb, sizeof(settings.srgb));
+		mix(&settings.normalMap, sizeof(settings.normalMap));
+		mix(&settings.wrap, sizeof(settings.wrap));
+		mix(&settings.alphaCutoff, sizeof(settings.alphaCutoff));
+		mix(&MipVersion, sizeof(MipVersion));
+		return hash;
+	}
+
+	std::string MipGenerator::CachePath(const std::string& cacheFolder, uint64_t hash)
+	{
+		return (std::filesystem::path(cacheFolder) / ("mips_" + std::to_string(hash) + ".ktx2")).string();
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef MIP_GENERATOR_H
+#define MIP_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace JLEngine
+{
+	class JobSystem;
+
+	enum class MipFilter : uint32_t
+	{
+		Box,	// 2x2 average
+		Kaiser	// 8x8 Kaiser windowed sinc, sharper with less aliasing
+	};
+
+	struct MipSettings
+	{
+		MipFilter filter = MipFilter::Kaiser;
+		bool srgb = false;			// RGB is filtered in linear light and stored back as sRGB
+		bool normalMap = false;		// RGB is read as vectors and renormalized on every level
+		bool wrap = true;			// taps past an edge wrap around like GL_REPEAT, or clamp
+		// 0..1 for alpha tested (MASK) textures, each level's alpha is scaled so as many texels pass
+		// the cutoff as on the top level and the surface doesn't thin out in the distance
+		float alphaCutoff = -1.0f;
+	};
+
+	struct MipLevel
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		size_t offset = 0;		// from the start of pixels
+		size_t size = 0;
+	};
+
+	// Every level of an 8 bit texture with the channels of the source, packed without row padding
+	struct MipChain
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		int channels = 0;
+		std::vector<MipLevel> levels;
+		std::vector<uint8_t> pixels;
+
+		const uint8_t* LevelData(size_t level) const { return pixels.data() + levels[level].offset; }
+	};
+
+	// One texture of a batch, the pixels have to outlive the call
+	struct MipRequest
+	{
+		const uint8_t* pixels = nullptr;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		int channels = 0;
+		MipSettings settings;
+		MipChain chain;
+	};
+
+	// Builds mip chains on the CPU so the GPU doesn't have to, filtered in float with every level
+	// taken from the float copy of the one above, so rounding doesn't build up down the chain
+	class MipGenerator
+	{
+	public:
+		// The full chain down to 1x1, as Graphics::CreateTexture allocates it
+		static uint32_t MipCount(uint32_t width, uint32_t height);
+
+		// 8 bit pixels with 1 to 4 channels, the rows of each level are spread over the jobs
+		static MipChain Generate(const uint8_t* pixels, uint32_t width, uint32_t height, int channels,
+			const MipSettings& settings, JobSystem* jobs = nullptr);
+		// One job per texture
+		static void Generate(std::vector<MipRequest>& requests, JobSystem& jobs);
+
+		// Only the level below, without alpha coverage
+		static std::vector<uint8_t> Downsample(const uint8_t* pixels, uint32_t width, uint32_t height, int channels, const MipSettings& settings);
+
+		// Fraction of the RGBA texels whose alpha times scale reaches the cutoff
+		static float AlphaCoverage(const float* rgba, size_t pixels, float cutoff, float scale);
+
+		// Key for a cached chain of one image of a source file, changes with the settings and the filters
+		static uint64_t CacheHash(uint64_t sourceHash, int imageIndex, const MipSettings& settings);
+		static std::string CachePath(const std::string& cacheFolder, uint64_t hash);
+	};
+}
+
+#endif
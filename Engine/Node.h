@@ -5,12 +5,14 @@
 #include <vector>
 #include <memory> // For smart pointers
 #include <functional>
+#include <algorithm>
 #include <glm/glm.hpp> // For transformation matrices and vectors
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Mesh.h"
 #include "Light.h"
+#include "TransformHierarchy.h"
 
 namespace JLEngine
 {
@@ -25,99 +27,84 @@ namespace JLEngine
     };
 
     // Node class representing a single entity in a scene graph
+    // Transform data lives in the flat TransformHierarchy, the node only keeps a handle to it
     class Node : public std::enable_shared_from_this<Node>
     {
     public:
         // Constructor
         Node(const std::string& name = "", NodeTag nodeTag = NodeTag::Mesh)
-            : name(name), tag(nodeTag), useMatrix(false),
-            localMatrix(glm::mat4(1.0)), translation(0.0f),
-            rotation(1.0f, 0.0f, 0.0f, 0.0f), scale(1.0f), mesh(0) 
+            : name(name), tag(nodeTag), mesh(0),
+            m_transform(TransformHierarchy::Global().Create())
         {
-            UpdateTransforms();
         }
 
+        ~Node()
+        {
+            TransformHierarchy::Global().Destroy(m_transform);
+        }
+
+        Node(const Node&) = delete;
+        Node& operator=(const Node&) = delete;
+
         std::string name;
         NodeTag tag;
 
         void SetTranslationRotation(const glm::vec3& newTranslation, const glm::quat& newRotation)
         {
-            translation = newTranslation;
-            rotation = newRotation;
-            UpdateHierarchy();
+            auto& hierarchy = TransformHierarchy::Global();
+            hierarchy.SetTRS(m_transform, newTranslation, newRotation, hierarchy.GetScale(m_transform));
         }
 
         void SetTRS(const glm::vec3& newTranslation, const glm::quat& newRotation, const glm::vec3& newScale)
         {
-            translation = newTranslation;
-            rotation = newRotation;
-            scale = newScale;
-            UpdateHierarchy();
+            TransformHierarchy::Global().SetTRS(m_transform, newTranslation, newRotation, newScale);
         }
 
         void SetTranslation(const glm::vec3& newTranslation)
         {
-            translation = newTranslation;
-            UpdateHierarchy();
+            TransformHierarchy::Global().SetTranslation(m_transform, newTranslation);
         }
 
         const glm::vec3& GetTranslation() const
         {
-            return translation;
+            return TransformHierarchy::Global().GetTranslation(m_transform);
         }
 
         // Rotation
         void SetRotation(const glm::quat& newRotation)
         {
-            rotation = newRotation;
-            UpdateHierarchy();
+            TransformHierarchy::Global().SetRotation(m_transform, newRotation);
         }
 
         const glm::quat& GetRotation() const
         {
-            return rotation;
+            return TransformHierarchy::Global().GetRotation(m_transform);
         }
 
         // Scale
         void SetScale(const glm::vec3& newScale)
         {
-            scale = newScale;
-            UpdateHierarchy();
+            TransformHierarchy::Global().SetScale(m_transform, newScale);
         }
 
         const glm::vec3& GetScale() const
         {
-            return scale;
+            return TransformHierarchy::Global().GetScale(m_transform);
         }
 
         glm::mat4 GetLocalTransform() const
         {
-            if (useMatrix)
-            {
-                return localMatrix;
-            }
-            glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), translation);
-            glm::mat4 rotationMatrix = glm::toMat4(rotation);
-            glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), scale);
-            return translationMatrix * rotationMatrix * scaleMatrix;
+            return TransformHierarchy::Global().GetLocalTransform(m_transform);
         }
 
-        glm::mat4 GetGlobalTransform()
+        // Resolves pending hierarchy changes if any, so prefer calling TransformHierarchy::Update
+        // once after a batch of edits rather than interleaving sets and gets
+        glm::mat4 GetGlobalTransform() const
         {
-            return globalTransform; // Use cached value
+            return TransformHierarchy::Global().GetWorldTransform(m_transform);
         }
 
-        void UpdateTransforms(const glm::mat4& parentTransform = glm::mat4(1.0f))
-        {
-            // Compute this node's global transform
-            globalTransform = parentTransform * GetLocalTransform();
-
-            // Update children
-            for (auto& child : children)
-            {
-                child->UpdateTransforms(globalTransform);
-            }
-        }
+        TransformHandle GetTransformHandle() const { return m_transform; }
 
         static std::shared_ptr<Node> FindNode(std::shared_ptr<Node>& root, std::string_view name)
         {
@@ -176,28 +163,34 @@ namespace JLEngine
             return foundSkeleton; // Return nullptr if no skeleton is found
         }
 
-        // You do not want to call this before a node has been attached to the scene root 
-        // So when setting up a new node just set its scale/translation/rotation directly without 
-        // using the SetX methods which call UpdateHierarchy
+        // Flags this node and its subtree for recomputation, the world matrices are resolved
+        // by the next TransformHierarchy::Update (or lazily by GetGlobalTransform)
         void UpdateHierarchy()
         {
-            if (auto parentPtr = parent.lock())
-            {
-                UpdateTransforms(parentPtr->GetGlobalTransform());
-            }
-            else
-            {
-                UpdateTransforms(glm::mat4(1.0f));
-            }
+            TransformHierarchy::Global().MarkDirty(m_transform);
         }
 
         void AddChild(std::shared_ptr<Node>& child)
         {
             child->parent = shared_from_this();
-            child->UpdateTransforms(globalTransform);
+            TransformHierarchy::Global().SetParent(child->m_transform, m_transform);
             children.push_back(child);
         }
 
+        // Detaches child, its transform becomes a root. Returns the child so the caller can keep it alive
+        std::shared_ptr<Node> RemoveChild(Node* child)
+        {
+            auto it = std::find_if(children.begin(), children.end(),
+                [child](const std::shared_ptr<Node>& c) { return c.get() == child; });
+            if (it == children.end()) return nullptr;
+
+            std::shared_ptr<Node> removed = std::move(*it);
+            children.erase(it);
+            removed->parent.reset();
+            TransformHierarchy::Global().SetParent(removed->m_transform, InvalidTransformHandle);
+            return removed;
+        }
+
         void SetTag(NodeTag newTag)
         {
             tag = newTag;
@@ -210,9 +203,6 @@ namespace JLEngine
 
         int32_t perDrawDataIndex = -1;
 
-        glm::mat4 localMatrix;
-        bool useMatrix;
-
         LightGPU light;
         std::shared_ptr<Mesh> mesh;
         std::shared_ptr<AnimationController> animController;
@@ -220,11 +210,6 @@ namespace JLEngine
         std::vector<std::shared_ptr<Node>> children;
         std::weak_ptr<Node> parent;
 
-        glm::mat4 globalTransform; // Cached global transform
-        glm::vec3 translation;
-        glm::quat rotation;
-        glm::vec3 scale;
-
         glm::vec3 anim_translation;
         glm::quat anim_rotation;
         glm::vec3 anim_scale;
@@ -233,6 +218,7 @@ namespace JLEngine
         bool isDirty = true;
         bool IsAnimated = false;
     private:
+        TransformHandle m_transform;
     };
 
     void PrintNodeHierarchy(const Node* node, int depth = 0);
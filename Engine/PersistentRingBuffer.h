@@ -0,0 +1,268 @@
+#ifndef PERSISTENT_RING_BUFFER_H
+#define PERSISTENT_RING_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "GPUBuffer.h"
+
+namespace JLEngine
+{
+	// A slice of the ring for this frame. Write through data, then bind [offset, offset + size)
+	// of bufferID or copy from it on the GPU. Valid until the same frame slot comes round again
+	struct TransientAllocation
+	{
+		void* data = nullptr;
+		uint32_t bufferID = 0;
+		size_t offset = 0;
+		size_t size = 0;
+
+		explicit operator bool() const { return data != nullptr; }
+	};
+
+	struct RingBufferStats
+	{
+		uint32_t fenceWaits = 0;		// BeginFrame found the GPU still using the partition
+		uint32_t overflows = 0;			// allocations that didn't fit this frame's partition
+		uint32_t reallocations = 0;
+		size_t frameBytes = 0;			// used by the current frame so far
+		size_t peakFrameBytes = 0;
+	};
+
+	// One persistently and coherently mapped buffer split into frameCount partitions. The CPU writes
+	// frame N's partition while the GPU reads earlier ones, a fence per partition is waited on only
+	// when the ring wraps back onto it, so uploads never stall on a glBufferSubData sync or a reallocation.
+	//
+	// API is GraphicsAPI in the engine, it needs CreateNamedBuffer, NamedBufferStorage, MapNamedBufferRange,
+	// DisposeBuffer, FenceSync, ClientWaitSync and DeleteSync. Tests drive it with a mock that has the same calls.
+	template <typename API>
+	class PersistentRingBuffer
+	{
+	public:
+		static constexpr GLbitfield MapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		explicit PersistentRingBuffer(uint32_t frameCount = 3)
+			: m_frameCount(std::max(frameCount, 1u)), m_gpuBuffer(GL_SHADER_STORAGE_BUFFER, MapFlags) {}
+		~PersistentRingBuffer() = default;
+
+		PersistentRingBuffer(const PersistentRingBuffer&) = delete;
+		PersistentRingBuffer& operator=(const PersistentRingBuffer&) = delete;
+
+		// alignment covers both uniform and storage buffer offset rules so any slice can be bound as either
+		bool Create(API* api, size_t bytesPerFrame, size_t alignment = 256);
+		void Dispose();
+		bool IsCreated() const { return m_mapped != nullptr; }
+
+		// Moves to the next partition, waiting on its fence if the GPU hasn't finished with it
+		void BeginFrame();
+		// Fences the partition written this frame
+		void EndFrame();
+
+		// size bytes from this frame's partition, an empty allocation if it doesn't fit
+		TransientAllocation Allocate(size_t size);
+		TransientAllocation Upload(const void* data, size_t size);
+		template <typename T>
+		TransientAllocation Upload(const std::vector<T>& data) { return Upload(data.data(), data.size() * sizeof(T)); }
+
+		// Grows the partitions to at least bytesPerFrame. Waits for every partition to be released, so call it
+		// only when the per frame footprint has grown (e.g. after the scene changed) and before this frame's
+		// allocations, anything allocated earlier in the frame belonged to the old buffer
+		bool Reserve(size_t bytesPerFrame);
+
+		GPUBuffer& GetGPUBuffer() { return m_gpuBuffer; }
+		size_t GetBytesPerFrame() const { return m_bytesPerFrame; }
+		size_t GetAlignment() const { return m_alignment; }
+		uint32_t GetFrameCount() const { return m_frameCount; }
+		uint32_t GetCurrentPartition() const { return m_partition; }
+		const RingBufferStats& GetStats() const { return m_stats; }
+
+	private:
+		void WaitFence(uint32_t partition);
+		void WaitAll();
+		size_t AlignUp(size_t value) const { return (value + m_alignment - 1) / m_alignment * m_alignment; }
+
+		API* m_api = nullptr;
+		uint32_t m_frameCount;
+		size_t m_bytesPerFrame = 0;
+		size_t m_alignment = 256;
+
+		GPUBuffer m_gpuBuffer;
+		std::byte* m_mapped = nullptr;
+		std::vector<GLsync> m_fences;
+
+		uint32_t m_partition = 0;
+		size_t m_head = 0;
+		bool m_inFrame = false;
+
+		RingBufferStats m_stats;
+	};
+
+	template <typename API>
+	bool PersistentRingBuffer<API>::Create(API* api, size_t bytesPerFrame, size_t alignment)
+	{
+		if (api == nullptr || bytesPerFrame == 0) return false;
+
+		m_api = api;
+		m_alignment = std::max<size_t>(alignment, 1);
+		m_bytesPerFrame = AlignUp(bytesPerFrame);
+		size_t totalSize = m_bytesPerFrame * m_frameCount;
+
+		uint32_t id = 0;
+		m_api->CreateNamedBuffer(id);
+		m_api->NamedBufferStorage(id, totalSize, MapFlags, nullptr);
+		m_mapped = static_cast<std::byte*>(m_api->MapNamedBufferRange(id, MapFlags, 0, totalSize));
+
+		m_gpuBuffer.SetGPUID(id);
+		m_gpuBuffer.SetSizeInBytes(totalSize);
+		m_gpuBuffer.SetMappedPtr(m_mapped);
+		m_gpuBuffer.SetCreated(true);
+
+		m_fences.assign(m_frameCount, nullptr);
+		m_partition = 0;
+		m_head = 0;
+		m_inFrame = false;
+		return m_mapped != nullptr;
+	}
+
+	template <typename API>
+	void PersistentRingBuffer<API>::Dispose()
+	{
+		if (m_api == nullptr) return;
+
+		for (auto& fence : m_fences)
+		{
+			if (fence != nullptr) m_api->DeleteSync(fence);
+			fence = nullptr;
+		}
+
+		// persistent mappings don't have to be unmapped before the buffer is deleted
+		uint32_t id = m_gpuBuffer.GetGPUID();
+		if (id != 0) m_api->DisposeBuffer(1, &id);
+
+		m_gpuBuffer.SetGPUID(0);
+		m_gpuBuffer.SetSizeInBytes(0);
+		m_gpuBuffer.SetMappedPtr(nullptr);
+		m_gpuBuffer.SetCreated(false);
+		m_mapped = nullptr;
+		m_inFrame = false;
+	}
+
+	template <typename API>
+	void PersistentRingBuffer<API>::BeginFrame()
+	{
+		if (!IsCreated()) return;
+		if (m_inFrame) EndFrame();
+
+		m_partition = (m_partition + 1) % m_frameCount;
+		WaitFence(m_partition);
+
+		m_head = 0;
+		m_stats.frameBytes = 0;
+		m_inFrame = true;
+	}
+
+	template <typename API>
+	void PersistentRingBuffer<API>::EndFrame()
+	{
+		if (!IsCreated() || !m_inFrame) return;
+
+		// nothing written, nothing for the GPU to release
+		if (m_head > 0)
+			m_fences[m_partition] = m_api->FenceSync();
+		m_inFrame = false;
+	}
+
+	template <typename API>
+	TransientAllocation PersistentRingBuffer<API>::Allocate(size_t size)
+	{
+		if (!IsCreated() || size == 0) return {};
+
+		size_t offset = AlignUp(m_head);
+		if (offset + size > m_bytesPerFrame)
+		{
+			m_stats.overflows++;
+			return {};
+		}
+
+		m_head = offset + size;
+		m_stats.frameBytes = m_head;
+		m_stats.peakFrameBytes = std::max(m_stats.peakFrameBytes, m_head);
+
+		size_t absolute = static_cast<size_t>(m_partition) * m_bytesPerFrame + offset;
+		return TransientAllocation{ m_mapped + absolute, m_gpuBuffer.GetGPUID(), absolute, size };
+	}
+
+	template <typename API>
+	TransientAllocation PersistentRingBuffer<API>::Upload(const void* data, size_t size)
+	{
+		auto allocation = Allocate(size);
+		if (allocation) std::memcpy(allocation.data, data, size);
+		return allocation;
+	}
+
+	template <typename API>
+	bool PersistentRingBuffer<API>::Reserve(size_t bytesPerFrame)
+	{
+		if (m_api == nullptr) return false;
+		if (AlignUp(bytesPerFrame) <= m_bytesPerFrame) return true;
+
+		bool inFrame = m_inFrame;
+
+		// the GPU may still read any partition, the old buffer can only go once they are all released
+		WaitAll();
+
+		API* api = m_api;
+		size_t alignment = m_alignment;
+		size_t newSize = std::max(AlignUp(bytesPerFrame), m_bytesPerFrame + m_bytesPerFrame / 2);
+		Dispose();
+
+		m_stats.reallocations++;
+		bool created = Create(api, newSize, alignment);
+		// a reserve inside a frame carries on in the new buffer's first partition
+		m_inFrame = created && inFrame;
+		return created;
+	}
+
+	template <typename API>
+	void PersistentRingBuffer<API>::WaitFence(uint32_t partition)
+	{
+		GLsync& fence = m_fences[partition];
+		if (fence == nullptr) return;
+
+		// check without waiting first, in the normal case the partition was released frames ago
+		GLenum result = m_api->ClientWaitSync(fence, 0);
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+		{
+			m_stats.fenceWaits++;
+			constexpr uint64_t timeoutNs = 1000000; // 1ms per try
+			while (result == GL_TIMEOUT_EXPIRED)
+			{
+				result = m_api->ClientWaitSync(fence, timeoutNs);
+			}
+			if (result == GL_WAIT_FAILED)
+			{
+				std::cerr << "PersistentRingBuffer: fence wait failed, partition " << partition << " may still be in use" << std::endl;
+			}
+		}
+
+		m_api->DeleteSync(fence);
+		fence = nullptr;
+	}
+
+	template <typename API>
+	void PersistentRingBuffer<API>::WaitAll()
+	{
+		if (m_inFrame) EndFrame();
+		for (uint32_t i = 0; i < m_frameCount && i < m_fences.size(); ++i)
+		{
+			WaitFence(i);
+		}
+	}
+}
+
+#endif
\ No newline at end of file
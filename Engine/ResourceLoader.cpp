@@ -9,13 +9,6 @@
 
 #include <glm/glm.hpp>
 
-#undef APIENTRY
-#define TINYGLTF_IMPLEMENTATION
-#include <tiny_gltf.h>
-
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
-
 namespace JLEngine
 {
     std::unordered_map<std::type_index, std::any> ResourceLoader::m_managers;
@@ -40,6 +33,7 @@ namespace JLEngine
         m_managers[typeid(Animation)] = m_animManager;
 
         m_textureFactory = new TextureFactory(m_textureManager, graphics);
+        m_textureStreamer = new TextureStreamer(JobSystem::Global());
         m_cubemapFactory = new CubemapFactory(m_cubemapManager, graphics);
         m_shaderFactory = new ShaderFactory(m_shaderManager, graphics);
         m_materialFactory = new MaterialFactory(m_materialManager);
@@ -53,6 +47,8 @@ namespace JLEngine
 
     ResourceLoader::~ResourceLoader() 
     {
+        // waits for its reads, then releases the textures it replaced
+        delete m_textureStreamer;
         delete m_textureFactory;
         delete m_cubemapFactory;
 
@@ -74,13 +70,24 @@ namespace JLEngine
     }
 
     std::shared_ptr<Node> ResourceLoader::LoadGLB(const std::string& glbFile)
+    {
+        PrepareGLBLoader();
+        return m_glbLoader->LoadGLB(glbFile);
+    }
+
+    std::shared_ptr<GLBImport> ResourceLoader::CreateGLBImport(const std::string& glbFile)
+    {
+        PrepareGLBLoader();
+        return m_glbLoader->CreateImport(glbFile);
+    }
+
+    void ResourceLoader::PrepareGLBLoader()
     {
         if (!m_glbLoader)
             m_glbLoader = new GLBLoader(this);
 
-        auto scene = m_glbLoader->LoadGLB(glbFile);
-        m_glbLoader->ClearCaches();
-        return scene;
+        m_glbLoader->CacheFolder = m_meshCacheFolder;
+        m_glbLoader->Settings = m_settings;
     }
 
     std::shared_ptr<Cubemap> ResourceLoader::CreateCubemapFromFile(const std::string& name, std::array<std::string, 6> fileNames, std::string folderPath)
@@ -103,6 +110,21 @@ namespace JLEngine
         return m_textureFactory->CreateFromData(name, imageData, texParams);
     }
 
+    std::shared_ptr<Texture> ResourceLoader::CreateTexture(const std::string& name, const CompressedImage& image, const TexParams& texParams)
+    {
+        return m_textureFactory->CreateFromCompressed(name, image, texParams);
+    }
+
+    std::shared_ptr<Texture> ResourceLoader::CreateTexture(const std::string& name, const KTX2Image& image, const TexParams& texParams)
+    {
+        return m_textureFactory->CreateFromKTX2(name, image, texParams);
+    }
+
+    std::shared_ptr<Texture> ResourceLoader::CreateTexture(const std::string& name, const TextureStreamSource& source, const TexParams& texParams)
+    {
+        return m_textureFactory->CreateStreamed(name, source, texParams, *m_textureStreamer);
+    }
+
     std::shared_ptr<Texture> ResourceLoader::CreateTextureEmpty(const std::string& name)
     {
         return m_textureFactory->CreateEmpty(name);
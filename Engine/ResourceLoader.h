@@ -35,19 +35,6 @@ namespace JLEngine
 	
 	enum class DepthType;
 
-	enum class NormalGen
-	{
-		Smooth,
-		Flat
-	};
-
-	struct AssetGenerationSettings
-	{
-		bool GenerateNormals = true; // if missing generate normals
-		bool GenerateTangents = true; // if missing generate tangents
-		NormalGen NormalGenType = NormalGen::Smooth; // type of normals to generate
-	};
-
 	class ResourceLoader
 	{
 	public:
@@ -63,12 +50,20 @@ namespace JLEngine
 		ResourceManager<Animation>* GetAnimationManager() const { return m_animManager; }
 
 		std::shared_ptr<Node> LoadGLB(const std::string& glbFile);		
+		// A load for AssetStreamer to import on a worker, taken with the current settings
+		std::shared_ptr<GLBImport> CreateGLBImport(const std::string& glbFile);
 		void SetGlobalGenerationSettings(AssetGenerationSettings& settings) { m_settings = settings; }
+		// Cooked GLB imports go here, see MeshCache. Empty (the default) always imports the GLB
+		void SetMeshCacheFolder(const std::string& folder) { m_meshCacheFolder = folder; }
 
 		// Texture Loading ///////////////////////////////////
 		std::shared_ptr<Texture> CreateTexture(const std::string& name, const std::string& filePath, const TexParams& texParams, int outputChannels = 0);		
 		std::shared_ptr<Texture> CreateTexture(const std::string& name, const std::string& filePath);
 		std::shared_ptr<Texture> CreateTexture(const std::string& name, ImageData& imageData, const TexParams& texParams = TexParams());
+		std::shared_ptr<Texture> CreateTexture(const std::string& name, const CompressedImage& image, const TexParams& texParams = TexParams());
+		std::shared_ptr<Texture> CreateTexture(const std::string& name, const KTX2Image& image, const TexParams& texParams = TexParams());
+		// Streamed from the file by the TextureStreamer, see TextureFactory::CreateStreamed
+		std::shared_ptr<Texture> CreateTexture(const std::string& name, const TextureStreamSource& source, const TexParams& texParams = TexParams());
 		std::shared_ptr<Texture> CreateTextureEmpty(const std::string& name);
 		Texture* DefaultBlackTexture();
 		void DeleteTexture(const std::string& name);
@@ -109,6 +104,7 @@ namespace JLEngine
 		std::shared_ptr<Animation> CreateAnimation(const std::string& name);
 
 		GLBLoader* GetGLBLoader() { return m_glbLoader; }
+		TextureStreamer* GetTextureStreamer() { return m_textureStreamer; }
 		GraphicsAPI* GetGraphics() { return m_graphics; }
 
 		template <typename T>
@@ -150,8 +146,10 @@ namespace JLEngine
 		}
 
 	protected:
+		void PrepareGLBLoader();
 
 		AssetGenerationSettings m_settings;
+		std::string m_meshCacheFolder;
 		GraphicsAPI* m_graphics;
 
 		bool m_hotReload;
@@ -168,6 +166,7 @@ namespace JLEngine
 		static std::unordered_map<std::type_index, std::any> m_managers;
 
 		TextureFactory* m_textureFactory;
+		TextureStreamer* m_textureStreamer;
 		CubemapFactory* m_cubemapFactory;
 		ShaderFactory* m_shaderFactory;
 		MaterialFactory* m_materialFactory;
@@ -180,7 +179,7 @@ namespace JLEngine
 		ShaderProgram* m_solidColor = nullptr;
 		ShaderProgram* m_screenSpaceQuad = nullptr;
 
-		GLBLoader* m_glbLoader;
+		GLBLoader* m_glbLoader = nullptr;
 
 		/*  Material Manager Variables */
 		Material* m_defaultMat;
@@ -0,0 +1,534 @@
+#include "SceneBVH.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace JLEngine
+{
+	namespace
+	{
+		constexpr int MaxDepth = 64;
+		// below this a subtree isn't worth handing to another thread
+		constexpr uint32_t MinParallelSubtree = 4096;
+
+		AABB EmptyBox()
+		{
+			return { glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+		}
+
+		void Grow(AABB& box, const AABB& other)
+		{
+			box.min = glm::min(box.min, other.min);
+			box.max = glm::max(box.max, other.max);
+		}
+
+		// half the surface area, the factor of 2 doesn't change which split wins
+		float HalfArea(const AABB& box)
+		{
+			glm::vec3 e = box.max - box.min;
+			return e.x * e.y + e.y * e.z + e.z * e.x;
+		}
+
+		bool Overlaps(const AABB& a, const AABB& b)
+		{
+			return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+				a.min.y <= b.max.y && a.max.y >= b.min.y &&
+				a.min.z <= b.max.z && a.max.z >= b.min.z;
+		}
+
+		bool Contains(const AABB& box, const glm::vec3& point)
+		{
+			return point.x >= box.min.x && point.x <= box.max.x &&
+				point.y >= box.min.y && point.y <= box.max.y &&
+				point.z >= box.min.z && point.z <= box.max.z;
+		}
+
+		// slab test, returns the entry distance or infinity on a miss
+		float IntersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& invDir, float maxDistance)
+		{
+			glm::vec3 t0 = (box.min - origin) * invDir;
+			glm::vec3 t1 = (box.max - origin) * invDir;
+			glm::vec3 tSmall = glm::min(t0, t1);
+			glm::vec3 tBig = glm::max(t0, t1);
+
+			float tMin = std::max(std::max(tSmall.x, tSmall.y), std::max(tSmall.z, 0.0f));
+			float tMax = std::min(std::min(tBig.x, tBig.y), std::min(tBig.z, maxDistance));
+			return tMin <= tMax ? tMin : std::numeric_limits<float>::infinity();
+		}
+
+		enum class PlaneTest { Outside, Intersecting, Inside };
+
+		PlaneTest TestFrustum(const AABB& box, const Plane* planes)
+		{
+			glm::vec3 center = (box.min + box.max) * 0.5f;
+			glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+			PlaneTest result = PlaneTest::Inside;
+			for (int p = 0; p < 6; ++p)
+			{
+				const glm::vec3& n = planes[p].m_normal;
+				float distance = glm::dot(n, center) + planes[p].m_distance;
+				float radius = glm::dot(glm::abs(n), extent);
+
+				if (distance + radius < 0.0f) return PlaneTest::Outside;
+				if (distance - radius < 0.0f) result = PlaneTest::Intersecting;
+			}
+			return result;
+		}
+	}
+
+	void SceneBVH::Build(const std::vector<AABB>& worldBounds, unsigned threadCount)
+	{
+		m_nodes.clear();
+		m_primitiveBounds = worldBounds;
+		if (worldBounds.empty()) return;
+
+		uint32_t count = static_cast<uint32_t>(worldBounds.size());
+		m_primitiveIndices.resize(count);
+		m_centroids.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			m_primitiveIndices[i] = i;
+			m_centroids[i] = (worldBounds[i].min + worldBounds[i].max) * 0.5f;
+		}
+
+		// a binary tree with n leaves never has more than 2n - 1 nodes, reserving keeps node references valid
+		m_nodes.reserve(count * 2 - 1);
+
+		BVHNode root;
+		root.leftOrFirst = 0;
+		root.count = count;
+		UpdateNodeBounds(root);
+		m_nodes.push_back(root);
+
+		if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+		if (threadCount == 1 || count < MinParallelSubtree * 2)
+		{
+			BuildSubtree(m_nodes, 0);
+			return;
+		}
+
+		// --- SPLIT THE TOP OF THE TREE UNTIL THERE ARE ENOUGH SUBTREES TO SHARE OUT ---
+		struct Task
+		{
+			uint32_t node;
+			int depth;
+		};
+		std::vector<Task> tasks;
+		uint32_t taskSize = std::max(MinParallelSubtree, count / (threadCount * 4));
+
+		std::vector<Task> stack;
+		stack.push_back({ 0, 0 });
+		while (!stack.empty())
+		{
+			Task task = stack.back();
+			stack.pop_back();
+
+			if (task.depth >= MaxDepth) continue;
+			if (m_nodes[task.node].count <= taskSize)
+			{
+				tasks.push_back(task);
+				continue;
+			}
+
+			if (Subdivide(m_nodes, task.node))
+			{
+				uint32_t left = m_nodes[task.node].leftOrFirst;
+				stack.push_back({ left, task.depth + 1 });
+				stack.push_back({ left + 1, task.depth + 1 });
+			}
+		}
+
+		// --- BUILD THE SUBTREES IN PARALLEL ---
+		// each subtree owns a disjoint range of m_primitiveIndices, so the partitioning never overlaps
+		std::sort(tasks.begin(), tasks.end(), [this](const Task& a, const Task& b)
+			{
+				return m_nodes[a.node].count > m_nodes[b.node].count;
+			});
+
+		std::vector<std::vector<BVHNode>> subtrees(tasks.size());
+		std::atomic<size_t> nextTask{ 0 };
+		auto worker = [&]()
+			{
+				for (size_t t = nextTask++; t < tasks.size(); t = nextTask++)
+				{
+					auto& nodes = subtrees[t];
+					nodes.reserve(m_nodes[tasks[t].node].count * 2 - 1);
+					nodes.push_back(m_nodes[tasks[t].node]);
+					BuildSubtree(nodes, tasks[t].depth);
+				}
+			};
+
+		std::vector<std::thread> threads;
+		unsigned workerCount = std::min<unsigned>(threadCount, static_cast<unsigned>(tasks.size()));
+		for (unsigned i = 1; i < workerCount; ++i)
+		{
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		// --- APPEND THE SUBTREES, REBASING THEIR CHILD INDICES ---
+		// subtree node 0 replaces the task node, nodes 1.. go on the end, so parents still come before children
+		for (size_t t = 0; t < tasks.size(); ++t)
+		{
+			auto& nodes = subtrees[t];
+			uint32_t offset = static_cast<uint32_t>(m_nodes.size()) - 1;
+
+			for (auto& node : nodes)
+			{
+				if (!node.IsLeaf()) node.leftOrFirst += offset;
+			}
+
+			m_nodes[tasks[t].node] = nodes[0];
+			m_nodes.insert(m_nodes.end(), nodes.begin() + 1, nodes.end());
+		}
+	}
+
+	void SceneBVH::BuildSubtree(std::vector<BVHNode>& nodes, int depth)
+	{
+		// explicit stack of (node, depth) so degenerate input can't blow the call stack
+		std::vector<std::pair<uint32_t, int>> stack;
+		stack.push_back({ 0, depth });
+		while (!stack.empty())
+		{
+			auto [nodeIndex, nodeDepth] = stack.back();
+			stack.pop_back();
+
+			if (nodeDepth >= MaxDepth) continue;
+
+			if (Subdivide(nodes, nodeIndex))
+			{
+				uint32_t left = nodes[nodeIndex].leftOrFirst;
+				stack.push_back({ left, nodeDepth + 1 });
+				stack.push_back({ left + 1, nodeDepth + 1 });
+			}
+		}
+	}
+
+	void SceneBVH::Refit(const std::vector<AABB>& worldBounds)
+	{
+		if (worldBounds.size() != m_primitiveBounds.size() || m_nodes.empty()) return;
+
+		m_primitiveBounds = worldBounds;
+
+		// children always come after their parent
+		for (size_t i = m_nodes.size(); i-- > 0;)
+		{
+			BVHNode& node = m_nodes[i];
+			if (node.IsLeaf())
+			{
+				UpdateNodeBounds(node);
+			}
+			else
+			{
+				node.bounds = m_nodes[node.leftOrFirst].bounds;
+				Grow(node.bounds, m_nodes[node.leftOrFirst + 1].bounds);
+			}
+		}
+	}
+
+	void SceneBVH::UpdateNodeBounds(BVHNode& node) const
+	{
+		node.bounds = EmptyBox();
+		for (uint32_t i = 0; i < node.count; ++i)
+		{
+			Grow(node.bounds, m_primitiveBounds[m_primitiveIndices[node.leftOrFirst + i]]);
+		}
+	}
+
+	float SceneBVH::FindBestSplit(const BVHNode& node, int& axis, float& splitPos) const
+	{
+		struct Bin
+		{
+			AABB bounds;
+			uint32_t count;
+		};
+
+		float bestCost = std::numeric_limits<float>::max();
+
+		// bins span the centroid bounds, not the node bounds, so large boxes don't squash everything into one bin
+		glm::vec3 centroidMin(std::numeric_limits<float>::max());
+		glm::vec3 centroidMax(std::numeric_limits<float>::lowest());
+		for (uint32_t i = 0; i < node.count; ++i)
+		{
+			const glm::vec3& c = m_centroids[m_primitiveIndices[node.leftOrFirst + i]];
+			centroidMin = glm::min(centroidMin, c);
+			centroidMax = glm::max(centroidMax, c);
+		}
+
+		for (int a = 0; a < 3; ++a)
+		{
+			float boundsMin = centroidMin[a];
+			float boundsMax = centroidMax[a];
+			if (boundsMin == boundsMax) continue;
+
+			Bin bins[BinCount];
+			for (auto& bin : bins)
+			{
+				bin.bounds = EmptyBox();
+				bin.count = 0;
+			}
+
+			float scale = BinCount / (boundsMax - boundsMin);
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				uint32_t primitive = m_primitiveIndices[node.leftOrFirst + i];
+				int binIndex = std::min(BinCount - 1, static_cast<int>((m_centroids[primitive][a] - boundsMin) * scale));
+				bins[binIndex].count++;
+				Grow(bins[binIndex].bounds, m_primitiveBounds[primitive]);
+			}
+
+			// sweep from both ends to get the area and count either side of every bin boundary
+			float leftArea[BinCount - 1], rightArea[BinCount - 1];
+			uint32_t leftCount[BinCount - 1], rightCount[BinCount - 1];
+			AABB leftBox = EmptyBox(), rightBox = EmptyBox();
+			uint32_t leftSum = 0, rightSum = 0;
+			for (int i = 0; i < BinCount - 1; ++i)
+			{
+				leftSum += bins[i].count;
+				leftCount[i] = leftSum;
+				if (bins[i].count > 0) Grow(leftBox, bins[i].bounds);
+				leftArea[i] = leftSum > 0 ? HalfArea(leftBox) : 0.0f;
+
+				rightSum += bins[BinCount - 1 - i].count;
+				rightCount[BinCount - 2 - i] = rightSum;
+				if (bins[BinCount - 1 - i].count > 0) Grow(rightBox, bins[BinCount - 1 - i].bounds);
+				rightArea[BinCount - 2 - i] = rightSum > 0 ? HalfArea(rightBox) : 0.0f;
+			}
+
+			float binWidth = (boundsMax - boundsMin) / BinCount;
+			for (int i = 0; i < BinCount - 1; ++i)
+			{
+				if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+
+				float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					axis = a;
+					splitPos = boundsMin + binWidth * (i + 1);
+				}
+			}
+		}
+		return bestCost;
+	}
+
+	bool SceneBVH::Subdivide(std::vector<BVHNode>& nodes, uint32_t nodeIndex)
+	{
+		BVHNode& node = nodes[nodeIndex];
+		if (node.count <= MaxLeafSize) return false;
+
+		int axis = 0;
+		float splitPos = 0.0f;
+		float splitCost = FindBestSplit(node, axis, splitPos);
+
+		// stop when splitting costs more than testing every primitive in this node
+		float leafCost = node.count * HalfArea(node.bounds);
+		if (splitCost >= leafCost) return false;
+
+		// partition the primitive indices in place around the split plane
+		uint32_t i = node.leftOrFirst;
+		uint32_t j = i + node.count - 1;
+		while (i <= j)
+		{
+			if (m_centroids[m_primitiveIndices[i]][axis] < splitPos)
+			{
+				i++;
+			}
+			else
+			{
+				std::swap(m_primitiveIndices[i], m_primitiveIndices[j]);
+				if (j == 0) break;
+				j--;
+			}
+		}
+
+		uint32_t leftCount = i - node.leftOrFirst;
+		if (leftCount == 0 || leftCount == node.count) return false;
+
+		uint32_t leftChild = static_cast<uint32_t>(nodes.size());
+
+		BVHNode left;
+		left.leftOrFirst = node.leftOrFirst;
+		left.count = leftCount;
+		UpdateNodeBounds(left);
+
+		BVHNode right;
+		right.leftOrFirst = i;
+		right.count = node.count - leftCount;
+		UpdateNodeBounds(right);
+
+		node.leftOrFirst = leftChild;
+		node.count = 0;
+
+		nodes.push_back(left);
+		nodes.push_back(right);
+		return true;
+	}
+
+	bool SceneBVH::AnyContainsPoint(const glm::vec3& point) const
+	{
+		if (m_nodes.empty()) return false;
+
+		uint32_t stack[MaxDepth + 1];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const BVHNode& node = m_nodes[stack[--stackSize]];
+			if (!Contains(node.bounds, point)) continue;
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = 0; i < node.count; ++i)
+				{
+					if (Contains(m_primitiveBounds[m_primitiveIndices[node.leftOrFirst + i]], point)) return true;
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.leftOrFirst;
+				stack[stackSize++] = node.leftOrFirst + 1;
+			}
+		}
+		return false;
+	}
+
+	void SceneBVH::QueryPoint(const glm::vec3& point, std::vector<uint32_t>& out) const
+	{
+		QueryBox({ point, point }, out);
+	}
+
+	void SceneBVH::QueryBox(const AABB& box, std::vector<uint32_t>& out) const
+	{
+		if (m_nodes.empty()) return;
+
+		uint32_t stack[MaxDepth + 1];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const BVHNode& node = m_nodes[stack[--stackSize]];
+			if (!Overlaps(node.bounds, box)) continue;
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = 0; i < node.count; ++i)
+				{
+					uint32_t primitive = m_primitiveIndices[node.leftOrFirst + i];
+					if (Overlaps(m_primitiveBounds[primitive], box)) out.push_back(primitive);
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.leftOrFirst;
+				stack[stackSize++] = node.leftOrFirst + 1;
+			}
+		}
+	}
+
+	void SceneBVH::QueryFrustum(const Plane* planes, std::vector<uint32_t>& out) const
+	{
+		if (m_nodes.empty()) return;
+
+		// the low bit flags a node that is already known to be fully inside, its subtree is taken without testing
+		uint32_t stack[MaxDepth + 1];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			uint32_t entry = stack[--stackSize];
+			const BVHNode& node = m_nodes[entry >> 1];
+			bool inside = (entry & 1) != 0;
+
+			if (!inside)
+			{
+				PlaneTest test = TestFrustum(node.bounds, planes);
+				if (test == PlaneTest::Outside) continue;
+				inside = test == PlaneTest::Inside;
+			}
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = 0; i < node.count; ++i)
+				{
+					uint32_t primitive = m_primitiveIndices[node.leftOrFirst + i];
+					if (inside || TestFrustum(m_primitiveBounds[primitive], planes) != PlaneTest::Outside)
+					{
+						out.push_back(primitive);
+					}
+				}
+			}
+			else
+			{
+				stack[stackSize++] = (node.leftOrFirst << 1) | (inside ? 1u : 0u);
+				stack[stackSize++] = ((node.leftOrFirst + 1) << 1) | (inside ? 1u : 0u);
+			}
+		}
+	}
+
+	bool SceneBVH::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BVHRayHit& hit) const
+	{
+		if (m_nodes.empty()) return false;
+
+		// zero components give +-inf which the slab test handles
+		glm::vec3 invDir = 1.0f / direction;
+		float closest = maxDistance;
+		bool found = false;
+
+		uint32_t stack[MaxDepth + 1];
+		int stackSize = 0;
+		if (IntersectRay(m_nodes[0].bounds, origin, invDir, closest) != std::numeric_limits<float>::infinity())
+		{
+			stack[stackSize++] = 0;
+		}
+
+		while (stackSize > 0)
+		{
+			const BVHNode& node = m_nodes[stack[--stackSize]];
+			if (IntersectRay(node.bounds, origin, invDir, closest) > closest) continue;
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = 0; i < node.count; ++i)
+				{
+					uint32_t primitive = m_primitiveIndices[node.leftOrFirst + i];
+					float t = IntersectRay(m_primitiveBounds[primitive], origin, invDir, closest);
+					if (t <= closest)
+					{
+						closest = t;
+						hit.primitive = primitive;
+						hit.distance = t;
+						found = true;
+					}
+				}
+				continue;
+			}
+
+			// visit the nearer child first so the far one is more likely to be rejected by the closer hit
+			uint32_t nearChild = node.leftOrFirst;
+			uint32_t farChild = node.leftOrFirst + 1;
+			float nearT = IntersectRay(m_nodes[nearChild].bounds, origin, invDir, closest);
+			float farT = IntersectRay(m_nodes[farChild].bounds, origin, invDir, closest);
+			if (farT < nearT)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearT, farT);
+			}
+
+			if (farT != std::numeric_limits<float>::infinity()) stack[stackSize++] = farChild;
+			if (nearT != std::numeric_limits<float>::infinity()) stack[stackSize++] = nearChild;
+		}
+		return found;
+	}
+}
\ No newline at end of file
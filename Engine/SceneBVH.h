@@ -0,0 +1,92 @@
+#ifndef SCENE_BVH_H
+#define SCENE_BVH_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "CollisionShapes.h"
+
+namespace JLEngine
+{
+	struct BVHNode
+	{
+		AABB bounds;
+		// leaf: first entry in the primitive index list, interior: index of the left child (right is left + 1)
+		uint32_t leftOrFirst = 0;
+		// number of primitives in a leaf, 0 for interior nodes
+		uint32_t count = 0;
+
+		bool IsLeaf() const { return count > 0; }
+	};
+
+	struct BVHRayHit
+	{
+		uint32_t primitive = UINT32_MAX;
+		float distance = 0.0f;
+	};
+
+	// Bounding volume hierarchy over world space boxes (one per scene submesh).
+	// Built top down with a binned surface area heuristic, primitives are referred to by their
+	// index in the bounds list passed to Build. Nodes are stored depth first so a child always
+	// follows its parent, which lets Refit update moved boxes in one reverse pass.
+	class SceneBVH
+	{
+	public:
+		SceneBVH() = default;
+
+		// threadCount 0 uses every hardware thread. The top of the tree is split on the calling thread,
+		// the subtrees below that are built in parallel and appended in order.
+		void Build(const std::vector<AABB>& worldBounds, unsigned threadCount = 1);
+
+		// Keeps the topology and recomputes the node bounds, worldBounds must match the count given to Build.
+		// Cheap compared to a rebuild but the tree quality degrades if things move a long way.
+		void Refit(const std::vector<AABB>& worldBounds);
+
+		// --- QUERIES ---
+		// The gather versions append primitive indices to out
+
+		bool AnyContainsPoint(const glm::vec3& point) const;
+		void QueryPoint(const glm::vec3& point, std::vector<uint32_t>& out) const;
+		void QueryBox(const AABB& box, std::vector<uint32_t>& out) const;
+		// planes point inwards (see ViewFrustum::ExtractPlanes)
+		void QueryFrustum(const Plane* planes, std::vector<uint32_t>& out) const;
+		// Closest box hit along the ray, a ray starting inside a box hits it at distance 0
+		bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BVHRayHit& hit) const;
+
+		bool Empty() const { return m_nodes.empty(); }
+		size_t GetPrimitiveCount() const { return m_primitiveBounds.size(); }
+		const std::vector<BVHNode>& GetNodes() const { return m_nodes; }
+		const AABB& GetPrimitiveBounds(uint32_t primitive) const { return m_primitiveBounds[primitive]; }
+		// Primitive order referenced by the leaves (leftOrFirst .. leftOrFirst + count)
+		const std::vector<uint32_t>& GetPrimitiveIndices() const { return m_primitiveIndices; }
+
+		// Collects the world space bounds of every submesh in a scene list (see SceneManager::GetSubmeshes)
+		template <typename SubmeshList>
+		static void GatherWorldBounds(const SubmeshList& submeshes, std::vector<AABB>& worldBounds)
+		{
+			worldBounds.resize(submeshes.size());
+			for (size_t i = 0; i < submeshes.size(); ++i)
+			{
+				worldBounds[i] = TransformAABB(submeshes[i].first.aabb, submeshes[i].second->GetGlobalTransform());
+			}
+		}
+
+	private:
+		static constexpr uint32_t MaxLeafSize = 4;
+		static constexpr int BinCount = 16;
+
+		// Splits nodes[nodeIndex] and appends its two children to nodes, false if it stays a leaf
+		bool Subdivide(std::vector<BVHNode>& nodes, uint32_t nodeIndex);
+		void BuildSubtree(std::vector<BVHNode>& nodes, int depth);
+		float FindBestSplit(const BVHNode& node, int& axis, float& splitPos) const;
+		void UpdateNodeBounds(BVHNode& node) const;
+
+		std::vector<BVHNode> m_nodes;
+		std::vector<uint32_t> m_primitiveIndices;
+		std::vector<AABB> m_primitiveBounds;
+		std::vector<glm::vec3> m_centroids;
+	};
+}
+
+#endif
\ No newline at end of file
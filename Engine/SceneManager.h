@@ -10,6 +10,7 @@
 
 #include "Node.h"
 #include "ResourceLoader.h"
+#include "SceneRegistry.h"
 
 namespace JLEngine
 {
@@ -23,185 +24,129 @@ namespace JLEngine
 		void SetRoot(std::shared_ptr<Node>& root) { m_sceneRoot = root; }
 		std::shared_ptr<Node>& GetRoot() { return m_sceneRoot; }
 
+		// Full rebuild from the root, prefer AddNode/RemoveNode for anything spawned after load
 		void ForceUpdate()
 		{
-			m_nonInstancedStatic.clear();
-			m_nonInstancedDynamic.clear();
-			m_instancedStatic.clear();
-			m_transparentObjects.clear();
-			m_skinnedAnimControllers.clear();
-			m_rigidAnimControllers.clear();
-			m_submeshList.clear();
-			m_skinnedAnimControllers.clear();
-			m_rigidAnimControllers.clear();
-
-			std::function<void(Node*)> populateLists = [&](Node* node)
-				{
-					if (node->IsAnimated && node->GetTag() != NodeTag::Mesh) // animated node, but no mesh
-					{
-						m_rigidAnimControllers.push_back(std::make_pair(node->animController, node));
-					}
-					if (node->GetTag() == NodeTag::Light)
-					{
-						m_lights.try_emplace(node->name, node);
-					}
-					if (node->GetTag() == NodeTag::Mesh)
-					{
-						auto matMgr = m_resourceLoader->GetMaterialManager();
-
-						auto& submeshes = node->mesh->GetSubmeshes();
-						for (auto i = 0; i < submeshes.size(); i++)
-						{
-							auto& submesh = node->mesh->GetSubmesh(i); 
-							m_submeshList.push_back(std::make_pair(submesh, node));
-							auto isInstanced = submesh.instanceTransforms != nullptr;
-							auto isStatic = (submesh.flags & SubmeshFlags::STATIC) != 0;
-							auto isSkinned = (submesh.flags & SubmeshFlags::SKINNED) != 0;
-							auto usesTransparency = (submesh.flags & SubmeshFlags::USES_TRANSPARENCY) != 0;
-							auto isAnimated = (submesh.flags & SubmeshFlags::ANIMATED) != 0;
-							auto mat = matMgr->Get(submesh.materialHandle);
-
-							if (isInstanced && !usesTransparency && isStatic)
-							{
-								auto key = MakeKey(node->mesh->GetName(), submesh);
-								if (m_instancedStatic.find(key) == m_instancedStatic.end())
-								{
-									m_instancedStatic[key] = std::make_pair(submesh, node);
-								}
-							}
-							else if (usesTransparency) // not currently handling transparent/skinned, but will eventually 
-							{
-								m_transparentObjects.push_back(std::make_pair(submesh, node));
-							}
-							else if (isStatic && !isAnimated)
-							{
-								m_nonInstancedStatic.push_back(std::make_pair(submesh, node));
-							}
-							else if (isInstanced && isSkinned)
-							{
-								m_skinnedAnimControllers.push_back(std::make_pair(node->animController, node));
-								auto key = MakeKey(node->mesh->GetName(), submesh);
-								if (m_instancedDynamic.find(key) == m_instancedDynamic.end())
-								{
-									m_instancedDynamic[key] = std::make_pair(submesh, node);
-								}
-							}
-							else if (isSkinned && isAnimated)
-							{
-								m_skinnedAnimControllers.push_back(std::make_pair(node->animController, node));
-								m_nonInstancedDynamic.push_back(std::make_pair(submesh, node));
-							}
-							else if (isAnimated)
-							{
-								// non skinned animations
-								m_rigidAnimControllers.push_back(std::make_pair(node->animController, node));
-								m_animatedRigidObjects.push_back(std::make_pair(submesh, node));
-							}
-						}
-					}
-
-					for (auto& child : node->children)
-					{
-						populateLists(child.get());
-					}
-				};
-			populateLists(m_sceneRoot.get());
-		}
-
-		std::unordered_map<std::string, Node*>& GetLightNodes() { return m_lights; }
+			m_registry.Clear();
+			m_registry.AddSubtree(m_sceneRoot.get());
+		}
+
+		// --- INCREMENTAL CHANGES ---
+		// Only the nodes involved are visited, the renderer picks the changes up with TakeChanges
+
+		// Attaches node under parent (the root if null) and registers its subtree
+		void AddNode(std::shared_ptr<Node> node, Node* parent = nullptr)
+		{
+			if (!node) return;
+			if (parent == nullptr) parent = m_sceneRoot.get();
+			if (parent != nullptr) parent->AddChild(node);
+
+			m_registry.AddSubtree(node.get());
+		}
+
+		// Unregisters the subtree and detaches it from its parent, the returned pointer keeps it alive
+		std::shared_ptr<Node> RemoveNode(Node* node)
+		{
+			if (node == nullptr) return nullptr;
+
+			m_registry.RemoveSubtree(node);
+
+			auto parent = node->parent.lock();
+			if (!parent) return node->shared_from_this();
+			return parent->RemoveChild(node);
+		}
+
+		void SetSubmeshFlags(Node* node, uint32_t submeshIndex, uint32_t flags) { m_registry.SetSubmeshFlags(node, submeshIndex, flags); }
+		void SetSubmeshMaterial(Node* node, uint32_t submeshIndex, uint32_t materialHandle) { m_registry.SetSubmeshMaterial(node, submeshIndex, materialHandle); }
+		void MarkDirty(Node* node) { m_registry.MarkDirty(node); }
+
+		void TakeChanges(SceneChanges& changes) { m_registry.TakeChanges(changes); }
+		SceneRegistry& GetRegistry() { return m_registry; }
+
+		std::unordered_map<std::string, Node*>& GetLightNodes() { return m_registry.GetLightNodes(); }
 
 		std::vector<std::pair<JLEngine::SubMesh, Node*>>& GetSubmeshes()
 		{
-			return m_submeshList;
+			return m_registry.GetSubmeshes();
 		}
 
 		std::vector<std::pair<SubMesh, Node*>>& GetNonInstancedStatic()
 		{
-			return m_nonInstancedStatic;
+			return m_registry.GetNonInstancedStatic();
 		}
 
 		std::vector<std::pair<SubMesh, Node*>>& GetNonInstancedDynamic()
 		{
-			return m_nonInstancedDynamic;
+			return m_registry.GetNonInstancedDynamic();
 		}
 
 		std::vector<std::pair<SubMesh, Node*>>& GetRigidAnimated()
 		{
-			return m_animatedRigidObjects;
+			return m_registry.GetRigidAnimated();
 		}
 
 		std::unordered_map<std::string, std::pair<SubMesh, Node*>>& GetInstancedStatic()
 		{
-			return m_instancedStatic;
+			return m_registry.GetInstancedStatic();
 		}
 
 		std::unordered_map<std::string, std::pair<SubMesh, Node*>>& GetInstancedDynamic()
 		{
-			return m_instancedDynamic;
+			return m_registry.GetInstancedDynamic();
 		}
 
 		std::vector<std::pair<SubMesh, Node*>>& GetTransparent()
 		{
-			return m_transparentObjects;
+			return m_registry.GetTransparent();
 		}
 
 		std::vector<std::pair<std::shared_ptr<AnimationController>, Node*>>& GetSkinnedAnimationControllers()
 		{
-			return m_skinnedAnimControllers;
+			return m_registry.GetSkinnedAnimationControllers();
 		}
 
 		std::vector<std::pair<std::shared_ptr<AnimationController>, Node*>>& GetRigidAnimationControllers()
 		{
-			return m_rigidAnimControllers;
+			return m_registry.GetRigidAnimationControllers();
 		}
 
 		void SortStaticFrontToBack(glm::vec3& eyePos)
 		{
-			std::sort(m_nonInstancedStatic.begin(), m_nonInstancedStatic.end(),
-				[&](const auto& a, const auto& b)
-				{
-					return glm::distance2(eyePos, a.second->translation) < glm::distance2(eyePos, b.second->translation);
-				});
+			m_registry.SortByDistance(SceneBucket::Static, eyePos, true);
 		}
 
 		void SortDynamicFrontToBack(glm::vec3& eyePos)
 		{
-			std::sort(m_nonInstancedDynamic.begin(), m_nonInstancedDynamic.end(),
-				[&](const auto& a, const auto& b)
-				{
-					return glm::distance2(eyePos, a.second->translation) < glm::distance2(eyePos, b.second->translation);
-				});
+			m_registry.SortByDistance(SceneBucket::Skinned, eyePos, true);
 		}
 
 		void SortTransparentBackToFront(const glm::vec3& eyePos)
 		{
-			std::sort(m_transparentObjects.begin(), m_transparentObjects.end(),
-				[&](const auto& a, const auto& b)
-				{
-					return glm::distance2(eyePos, a.second->translation) > glm::distance2(eyePos, b.second->translation);
-				});
+			m_registry.SortByDistance(SceneBucket::Transparent, eyePos, false);
 		}
 
 		void RebuildTransparentDrawCommands(std::unordered_map<VertexAttribKey, VAOResource>& transparentResources,
 									  std::unordered_map<uint32_t, size_t>& materialIDMap,
 									  ShaderStorageBuffer<PerDrawData> ssboTransparentPerDraw)
 		{
-			auto matMgr = m_resourceLoader->GetMaterialManager();
 			for (auto& item : transparentResources)
 			{
 				auto& vaoRes = item.second;
 				auto& drawBuffer = vaoRes.drawBuffer;
 				drawBuffer->ClearCommands();
 
-				for (auto& transObj : m_transparentObjects)
+				for (auto& transObj : m_registry.GetTransparent())
 				{
 					PerDrawData pdd;
 					pdd.materialID = (int)materialIDMap[transObj.first.materialHandle];
 					pdd.modelMatrix = transObj.second->GetGlobalTransform();
-					auto mat = matMgr->Get(transObj.first.materialHandle);
+
+					// the transparent shader reads its per draw data at gl_BaseInstance
+					auto command = transObj.first.command;
+					command.baseInstance = static_cast<uint32_t>(ssboTransparentPerDraw.GetDataImmutable().size());
 
 					ssboTransparentPerDraw.AddData(pdd);
-					transparentResources[transObj.first.attribKey].drawBuffer->AddDrawCommand(transObj.first.command);
+					transparentResources[transObj.first.attribKey].drawBuffer->AddDrawCommand(command);
 				}
 				Graphics::UploadToGPUBuffer(drawBuffer->GetGPUBuffer(), drawBuffer->GetDataImmutable(), 0);
 			}
@@ -211,16 +156,7 @@ namespace JLEngine
 	private:
 
 		std::shared_ptr<Node> m_sceneRoot;
-		std::vector<std::pair<SubMesh, Node*>> m_nonInstancedStatic;  // static meshes
-		std::vector<std::pair<SubMesh, Node*>> m_animatedRigidObjects; // rigid animations
-		std::vector<std::pair<SubMesh, Node*>> m_nonInstancedDynamic; // skinned meshes
-		std::vector<std::pair<SubMesh, Node*>> m_transparentObjects; // transparent meshes		
-		std::unordered_map<std::string, Node*> m_lights;
-		std::unordered_map<std::string, std::pair<SubMesh, Node*>> m_instancedStatic;	// instanced static meshes
-		std::unordered_map<std::string, std::pair<SubMesh, Node*>> m_instancedDynamic; // instanced skinned meshes
-		std::vector<std::pair<SubMesh, Node*>> m_submeshList;
-		std::vector<std::pair<std::shared_ptr<AnimationController>, Node*>> m_skinnedAnimControllers;
-		std::vector<std::pair<std::shared_ptr<AnimationController>, Node*>> m_rigidAnimControllers;
+		SceneRegistry m_registry;
 
 		ResourceLoader* m_resourceLoader;
 	};
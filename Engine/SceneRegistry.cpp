@@ -0,0 +1,630 @@
+#include "SceneRegistry.h"
+
+#include <algorithm>
+#include <numeric>
+#include <glm/gtx/norm.hpp>
+
+namespace JLEngine
+{
+	void SceneRegistry::Clear()
+	{
+		m_items.clear();
+		m_itemIDs.Clear();
+		m_nodeItems.clear();
+		m_meshItems.clear();
+		for (auto& bucketItems : m_bucketItems) bucketItems.clear();
+		m_submeshListItems.clear();
+		for (auto& slots : m_slots) slots.Clear();
+		m_jointSlots.Clear();
+		m_changes.Clear();
+
+		m_nonInstancedStatic.clear();
+		m_animatedRigidObjects.clear();
+		m_nonInstancedDynamic.clear();
+		m_transparentObjects.clear();
+		m_submeshList.clear();
+		m_instancedStatic.clear();
+		m_instancedDynamic.clear();
+		m_lights.clear();
+
+		m_skinnedAnimControllers.clear();
+		m_rigidAnimControllers.clear();
+		m_skinnedControllerIndices.clear();
+		m_rigidControllerIndices.clear();
+	}
+
+	void SceneRegistry::AddSubtree(Node* node)
+	{
+		if (node == nullptr) return;
+
+		std::vector<Node*> stack = { node };
+		while (!stack.empty())
+		{
+			Node* current = stack.back();
+			stack.pop_back();
+
+			AddNode(current);
+			for (auto& child : current->children)
+			{
+				stack.push_back(child.get());
+			}
+		}
+	}
+
+	void SceneRegistry::RemoveSubtree(Node* node)
+	{
+		if (node == nullptr) return;
+
+		std::vector<Node*> stack = { node };
+		while (!stack.empty())
+		{
+			Node* current = stack.back();
+			stack.pop_back();
+
+			RemoveNode(current);
+			for (auto& child : current->children)
+			{
+				stack.push_back(child.get());
+			}
+		}
+	}
+
+	void SceneRegistry::AddNode(Node* node)
+	{
+		auto [it, inserted] = m_nodeItems.try_emplace(node);
+		if (!inserted) return;
+
+		if (node->GetTag() == NodeTag::Light)
+		{
+			m_lights.try_emplace(node->name, node);
+			m_changes.lightsChanged = true;
+		}
+
+		if (node->GetTag() == NodeTag::Mesh && node->mesh)
+		{
+			auto submeshCount = static_cast<uint32_t>(node->mesh->GetSubmeshes().size());
+			it->second.reserve(submeshCount);
+			for (uint32_t i = 0; i < submeshCount; ++i)
+			{
+				it->second.push_back(AddItem(node, i));
+			}
+		}
+
+		UpdateControllers(node);
+	}
+
+	void SceneRegistry::RemoveNode(Node* node)
+	{
+		auto it = m_nodeItems.find(node);
+		if (it == m_nodeItems.end()) return;
+
+		for (SceneItemID id : it->second)
+		{
+			RemoveItem(id);
+		}
+		m_nodeItems.erase(it);
+
+		auto light = m_lights.find(node->name);
+		if (light != m_lights.end() && light->second == node)
+		{
+			m_lights.erase(light);
+			m_changes.lightsChanged = true;
+		}
+
+		SetController(m_skinnedAnimControllers, m_skinnedControllerIndices, node, false);
+		SetController(m_rigidAnimControllers, m_rigidControllerIndices, node, false);
+	}
+
+	SceneItemID SceneRegistry::AddItem(Node* node, uint32_t submeshIndex)
+	{
+		SceneItemID id = m_itemIDs.Allocate();
+		if (id >= m_items.size()) m_items.resize(id + 1);
+
+		auto& item = m_items[id];
+		item = SceneItem{};
+		item.node = node;
+		item.submeshIndex = submeshIndex;
+		item.submesh = node->mesh->GetSubmesh(submeshIndex);
+		item.live = true;
+
+		item.submeshListIndex = static_cast<uint32_t>(m_submeshList.size());
+		m_submeshList.push_back(std::make_pair(item.submesh, node));
+		m_submeshListItems.push_back(id);
+		m_meshItems[node->mesh.get()].push_back(id);
+
+		JoinInstanceGroup(node->mesh.get(), submeshIndex);
+		Place(id);
+		return id;
+	}
+
+	void SceneRegistry::RemoveItem(SceneItemID id)
+	{
+		auto& item = m_items[id];
+		// Release forgets the key, the group still needs it
+		auto instances = item.submesh.instanceTransforms;
+		std::string instanceKey = item.instanceKey;
+		SceneBucket groupBucket = Classify(item.submesh);
+
+		Release(id);
+
+		uint32_t index = item.submeshListIndex;
+		uint32_t last = static_cast<uint32_t>(m_submeshList.size() - 1);
+		if (index != last)
+		{
+			m_submeshList[index] = std::move(m_submeshList[last]);
+			m_submeshListItems[index] = m_submeshListItems[last];
+			m_items[m_submeshListItems[index]].submeshListIndex = index;
+		}
+		m_submeshList.pop_back();
+		m_submeshListItems.pop_back();
+
+		auto meshItems = m_meshItems.find(item.node->mesh.get());
+		if (meshItems != m_meshItems.end())
+		{
+			auto& ids = meshItems->second;
+			auto found = std::find(ids.begin(), ids.end(), id);
+			if (found != ids.end()) ids.erase(found);
+			if (ids.empty()) m_meshItems.erase(meshItems);
+		}
+
+		Node* node = item.node;
+		uint32_t submeshIndex = item.submeshIndex;
+		item = SceneItem{};
+		m_itemIDs.Free(id);
+
+		if (instances)
+		{
+			LeaveInstanceGroup(node, submeshIndex, *instances, instanceKey, groupBucket);
+		}
+	}
+
+	void SceneRegistry::LeaveInstanceGroup(Node* node, uint32_t submeshIndex, std::vector<Node*>& instances, const std::string& instanceKey, SceneBucket groupBucket)
+	{
+		instances.erase(std::remove(instances.begin(), instances.end(), node), instances.end());
+
+		auto& mesh = *node->mesh;
+		mesh.GetSubmesh(submeshIndex).command.instanceCount = static_cast<uint32_t>(instances.size());
+		// the mesh's node stands in for instances without their own controller, it can't be the one leaving
+		if (mesh.node == node)
+		{
+			mesh.node = instances.empty() ? nullptr : instances.front();
+		}
+
+		auto instanceMap = GetInstanceMap(groupBucket);
+		if (instanceMap == nullptr || instanceKey.empty()) return;
+
+		// the owner stays, its draw shrinks by one
+		auto group = instanceMap->find(instanceKey);
+		if (group != instanceMap->end())
+		{
+			ResizeInstanceGroup(group->second.second, instanceKey);
+			return;
+		}
+
+		// the owner left, the first registered instance takes the group over
+		for (Node* instance : instances)
+		{
+			auto it = m_nodeItems.find(instance);
+			if (it == m_nodeItems.end()) continue;
+
+			for (SceneItemID id : it->second)
+			{
+				if (m_items[id].instanceKey != instanceKey) continue;
+				Release(id);
+				Place(id);
+				return;
+			}
+		}
+	}
+
+	void SceneRegistry::Place(SceneItemID id)
+	{
+		auto& item = m_items[id];
+		SceneBucket bucket = Classify(item.submesh);
+		bool instanced = bucket == SceneBucket::InstancedStatic || bucket == SceneBucket::InstancedSkinned;
+
+		if (instanced)
+		{
+			// one draw covers every instance, the first submesh registered with the key owns it
+			item.instanceKey = MakeKey(item.node->mesh->GetName(), item.submesh);
+			auto& instanceMap = *GetInstanceMap(bucket);
+			auto [group, inserted] = instanceMap.try_emplace(item.instanceKey, std::make_pair(item.submesh, item.node));
+			if (!inserted)
+			{
+				bucket = SceneBucket::None;
+				ResizeInstanceGroup(group->second.second, item.instanceKey);
+			}
+		}
+
+		item.bucket = bucket;
+		auto& bucketItems = m_bucketItems[static_cast<size_t>(bucket)];
+		item.listIndex = static_cast<uint32_t>(bucketItems.size());
+		bucketItems.push_back(id);
+
+		if (auto list = GetList(bucket))
+		{
+			list->push_back(std::make_pair(item.submesh, item.node));
+		}
+
+		PerDrawSpace space = GetPerDrawSpace(bucket);
+		if (space == PerDrawSpace::None) return;
+
+		bool ownsInstances = bucket == SceneBucket::InstancedStatic || bucket == SceneBucket::InstancedSkinned;
+		item.slotCount = ownsInstances ? (item.submesh.instanceTransforms ? static_cast<uint32_t>(item.submesh.instanceTransforms->size()) : 0) : 1;
+		item.slot = m_slots[static_cast<size_t>(space)].Allocate(item.slotCount);
+
+		if (space == PerDrawSpace::Skinned)
+		{
+			auto& skeleton = item.node->mesh->GetSkeleton();
+			item.jointCount = skeleton ? static_cast<uint32_t>(skeleton->joints.size()) : 0;
+			item.jointSlot = m_jointSlots.Allocate(item.jointCount);
+		}
+
+		item.pendingAdd = true;
+		m_changes.added.push_back(id);
+	}
+
+	void SceneRegistry::ResizeInstanceGroup(Node* owner, const std::string& instanceKey)
+	{
+		auto it = m_nodeItems.find(owner);
+		if (it == m_nodeItems.end()) return;
+
+		for (SceneItemID id : it->second)
+		{
+			auto& item = m_items[id];
+			if (item.instanceKey != instanceKey || GetInstanceMap(item.bucket) == nullptr) continue;
+
+			// instances added or removed since the owner was placed change its slots and its draw
+			uint32_t instanceCount = item.submesh.instanceTransforms ? static_cast<uint32_t>(item.submesh.instanceTransforms->size()) : 0;
+			if (instanceCount != item.slotCount)
+			{
+				Release(id);
+				Place(id);
+			}
+			return;
+		}
+	}
+
+	void SceneRegistry::JoinInstanceGroup(Mesh* mesh, uint32_t submeshIndex)
+	{
+		auto it = m_meshItems.find(mesh);
+		if (it == m_meshItems.end()) return;
+
+		const SubMesh& current = mesh->GetSubmesh(submeshIndex);
+		if (current.instanceTransforms == nullptr) return;
+
+		// nodes placed before the mesh was instanced still hold their own copy without the instance list,
+		// they would be drawn on their own and again as part of the group
+		for (SceneItemID id : it->second)
+		{
+			auto& item = m_items[id];
+			if (item.submeshIndex != submeshIndex || item.submesh.instanceTransforms == current.instanceTransforms) continue;
+
+			for (SubMesh* submesh : { &item.submesh, &m_submeshList[item.submeshListIndex].first })
+			{
+				submesh->flags = current.flags;
+				submesh->instanceTransforms = current.instanceTransforms;
+				submesh->command.instanceCount = current.command.instanceCount;
+			}
+			Release(id);
+			Place(id);
+			UpdateControllers(item.node);
+		}
+	}
+
+	void SceneRegistry::Release(SceneItemID id)
+	{
+		auto& item = m_items[id];
+
+		// the renderer has drawn this placement, it needs to drop the command and the slots
+		if (!item.pendingAdd && GetPerDrawSpace(item.bucket) != PerDrawSpace::None)
+		{
+			m_changes.removed.push_back(item);
+		}
+		item.pendingAdd = false;
+		item.pendingDirty = false;
+
+		// --- SWAP REMOVE FROM THE BUCKET ---
+		auto& bucketItems = m_bucketItems[static_cast<size_t>(item.bucket)];
+		auto list = GetList(item.bucket);
+		uint32_t index = item.listIndex;
+		uint32_t last = static_cast<uint32_t>(bucketItems.size() - 1);
+		if (index != last)
+		{
+			bucketItems[index] = bucketItems[last];
+			if (list) (*list)[index] = std::move((*list)[last]);
+			m_items[bucketItems[index]].listIndex = index;
+		}
+		bucketItems.pop_back();
+		if (list) list->pop_back();
+
+		if (auto instanceMap = GetInstanceMap(item.bucket))
+		{
+			instanceMap->erase(item.instanceKey);
+		}
+
+		PerDrawSpace space = GetPerDrawSpace(item.bucket);
+		if (space != PerDrawSpace::None)
+		{
+			m_slots[static_cast<size_t>(space)].Free(item.slot, item.slotCount);
+		}
+		m_jointSlots.Free(item.jointSlot, item.jointCount);
+
+		item.bucket = SceneBucket::None;
+		item.slot = SlotAllocator::InvalidSlot;
+		item.slotCount = 0;
+		item.jointSlot = SlotAllocator::InvalidSlot;
+		item.jointCount = 0;
+		item.instanceKey.clear();
+	}
+
+	void SceneRegistry::SetSubmeshFlags(Node* node, uint32_t submeshIndex, uint32_t flags)
+	{
+		auto it = m_nodeItems.find(node);
+		if (it == m_nodeItems.end() || submeshIndex >= it->second.size()) return;
+
+		node->mesh->GetSubmesh(submeshIndex).flags = flags;
+
+		SceneItemID id = it->second[submeshIndex];
+		auto& item = m_items[id];
+		item.submesh.flags = flags;
+		m_submeshList[item.submeshListIndex].first.flags = flags;
+
+		Release(id);
+		Place(id);
+		UpdateControllers(node);
+	}
+
+	void SceneRegistry::SetSubmeshMaterial(Node* node, uint32_t submeshIndex, uint32_t materialHandle)
+	{
+		auto it = m_nodeItems.find(node);
+		if (it == m_nodeItems.end() || submeshIndex >= it->second.size()) return;
+
+		node->mesh->GetSubmesh(submeshIndex).materialHandle = materialHandle;
+
+		SceneItemID id = it->second[submeshIndex];
+		auto& item = m_items[id];
+		item.submesh.materialHandle = materialHandle;
+		m_submeshList[item.submeshListIndex].first.materialHandle = materialHandle;
+
+		// the material is part of the instance key, so instanced groups have to be re-bucketed
+		if (Classify(item.submesh) == SceneBucket::InstancedStatic || Classify(item.submesh) == SceneBucket::InstancedSkinned)
+		{
+			Release(id);
+			Place(id);
+			return;
+		}
+
+		if (auto list = GetList(item.bucket))
+		{
+			(*list)[item.listIndex].first.materialHandle = materialHandle;
+		}
+		MarkItemDirty(id);
+	}
+
+	void SceneRegistry::MarkDirty(Node* node)
+	{
+		auto it = m_nodeItems.find(node);
+		if (it == m_nodeItems.end()) return;
+
+		for (SceneItemID id : it->second)
+		{
+			MarkItemDirty(id);
+		}
+	}
+
+	void SceneRegistry::PatchSubmeshGeometry(const Mesh* mesh, uint32_t submeshIndex, uint32_t firstIndex, uint32_t baseVertex, std::vector<SceneItemID>& patched)
+	{
+		auto it = m_meshItems.find(mesh);
+		if (it == m_meshItems.end()) return;
+
+		auto patch = [firstIndex, baseVertex](SubMesh& submesh)
+			{
+				submesh.command.firstIndex = firstIndex;
+				submesh.command.baseVertex = baseVertex;
+			};
+
+		for (SceneItemID id : it->second)
+		{
+			auto& item = m_items[id];
+			if (item.submeshIndex != submeshIndex) continue;
+
+			patch(item.submesh);
+			patch(m_submeshList[item.submeshListIndex].first);
+			if (auto list = GetList(item.bucket))
+			{
+				patch((*list)[item.listIndex].first);
+			}
+			else if (auto instances = GetInstanceMap(item.bucket))
+			{
+				auto group = instances->find(item.instanceKey);
+				if (group != instances->end() && group->second.second == item.node)
+					patch(group->second.first);
+			}
+			patched.push_back(id);
+		}
+	}
+
+	void SceneRegistry::MarkItemDirty(SceneItemID id)
+	{
+		auto& item = m_items[id];
+		// a pending add writes everything anyway
+		if (item.pendingAdd || item.pendingDirty || GetPerDrawSpace(item.bucket) == PerDrawSpace::None) return;
+
+		item.pendingDirty = true;
+		m_changes.dirty.push_back(id);
+	}
+
+	void SceneRegistry::TakeChanges(SceneChanges& out)
+	{
+		out.Clear();
+		std::swap(out.removed, m_changes.removed);
+		out.lightsChanged = m_changes.lightsChanged;
+
+		// an item released and placed again in the same frame is queued more than once, the flag keeps the first
+		for (SceneItemID id : m_changes.added)
+		{
+			auto& item = m_items[id];
+			if (!item.live || !item.pendingAdd) continue;
+			item.pendingAdd = false;
+			out.added.push_back(id);
+		}
+		for (SceneItemID id : m_changes.dirty)
+		{
+			auto& item = m_items[id];
+			if (!item.live || !item.pendingDirty) continue;
+			item.pendingDirty = false;
+			out.dirty.push_back(id);
+		}
+
+		m_changes.Clear();
+	}
+
+	void SceneRegistry::UpdateControllers(Node* node)
+	{
+		bool wantsSkinned = false;
+		bool wantsRigid = node->IsAnimated && node->GetTag() != NodeTag::Mesh; // animated node, but no mesh
+
+		auto it = m_nodeItems.find(node);
+		if (it != m_nodeItems.end())
+		{
+			for (SceneItemID id : it->second)
+			{
+				// instanced groups owned by another node still animate this one
+				switch (Classify(m_items[id].submesh))
+				{
+				case SceneBucket::Skinned:
+				case SceneBucket::InstancedSkinned:
+					wantsSkinned = true;
+					break;
+				case SceneBucket::RigidAnimated:
+					wantsRigid = true;
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		SetController(m_skinnedAnimControllers, m_skinnedControllerIndices, node, wantsSkinned);
+		SetController(m_rigidAnimControllers, m_rigidControllerIndices, node, wantsRigid);
+	}
+
+	void SceneRegistry::SetController(ControllerList& list, std::unordered_map<const Node*, uint32_t>& indices, Node* node, bool wanted)
+	{
+		auto it = indices.find(node);
+		bool present = it != indices.end();
+
+		if (wanted && !present && node->animController)
+		{
+			indices[node] = static_cast<uint32_t>(list.size());
+			list.push_back(std::make_pair(node->animController, node));
+		}
+		else if (!wanted && present)
+		{
+			uint32_t index = it->second;
+			indices.erase(it);
+			if (index != list.size() - 1)
+			{
+				list[index] = std::move(list.back());
+				indices[list[index].second] = index;
+			}
+			list.pop_back();
+		}
+	}
+
+	void SceneRegistry::SortByDistance(SceneBucket bucket, const glm::vec3& eyePos, bool frontToBack)
+	{
+		auto list = GetList(bucket);
+		if (list == nullptr || list->size() < 2) return;
+
+		auto& bucketItems = m_bucketItems[static_cast<size_t>(bucket)];
+		std::vector<float> distances(list->size());
+		for (size_t i = 0; i < list->size(); ++i)
+		{
+			distances[i] = glm::distance2(eyePos, (*list)[i].second->GetTranslation());
+		}
+
+		std::vector<uint32_t> order(list->size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(),
+			[&](uint32_t a, uint32_t b)
+			{
+				return frontToBack ? distances[a] < distances[b] : distances[a] > distances[b];
+			});
+
+		std::vector<std::pair<SubMesh, Node*>> sortedList;
+		std::vector<SceneItemID> sortedItems;
+		sortedList.reserve(order.size());
+		sortedItems.reserve(order.size());
+		for (uint32_t index : order)
+		{
+			sortedList.push_back(std::move((*list)[index]));
+			sortedItems.push_back(bucketItems[index]);
+		}
+		*list = std::move(sortedList);
+		bucketItems = std::move(sortedItems);
+
+		for (uint32_t i = 0; i < bucketItems.size(); ++i)
+		{
+			m_items[bucketItems[i]].listIndex = i;
+		}
+	}
+
+	PerDrawSpace SceneRegistry::GetPerDrawSpace(SceneBucket bucket)
+	{
+		switch (bucket)
+		{
+		case SceneBucket::Static:
+		case SceneBucket::RigidAnimated:
+		case SceneBucket::InstancedStatic:
+			return PerDrawSpace::Static;
+		case SceneBucket::Skinned:
+		case SceneBucket::InstancedSkinned:
+			return PerDrawSpace::Skinned;
+		case SceneBucket::Transparent:
+			return PerDrawSpace::Transparent;
+		default:
+			return PerDrawSpace::None;
+		}
+	}
+
+	SceneBucket SceneRegistry::Classify(const SubMesh& submesh)
+	{
+		auto isInstanced = submesh.instanceTransforms != nullptr;
+		auto isStatic = (submesh.flags & SubmeshFlags::STATIC) != 0;
+		auto isSkinned = (submesh.flags & SubmeshFlags::SKINNED) != 0;
+		auto usesTransparency = (submesh.flags & SubmeshFlags::USES_TRANSPARENCY) != 0;
+		auto isAnimated = (submesh.flags & SubmeshFlags::ANIMATED) != 0;
+
+		if (isInstanced && !usesTransparency && isStatic) return SceneBucket::InstancedStatic;
+		if (usesTransparency) return SceneBucket::Transparent; // not currently handling transparent/skinned, but will eventually
+		if (isStatic && !isAnimated) return SceneBucket::Static;
+		if (isInstanced && isSkinned) return SceneBucket::InstancedSkinned;
+		if (isSkinned && isAnimated) return SceneBucket::Skinned;
+		if (isAnimated) return SceneBucket::RigidAnimated; // non skinned animations
+		return SceneBucket::None;
+	}
+
+	std::vector<std::pair<SubMesh, Node*>>* SceneRegistry::GetList(SceneBucket bucket)
+	{
+		switch (bucket)
+		{
+		case SceneBucket::Static: return &m_nonInstancedStatic;
+		case SceneBucket::RigidAnimated: return &m_animatedRigidObjects;
+		case SceneBucket::Skinned: return &m_nonInstancedDynamic;
+		case SceneBucket::Transparent: return &m_transparentObjects;
+		default: return nullptr;
+		}
+	}
+
+	std::unordered_map<std::string, std::pair<SubMesh, Node*>>* SceneRegistry::GetInstanceMap(SceneBucket bucket)
+	{
+		switch (bucket)
+		{
+		case SceneBucket::InstancedStatic: return &m_instancedStatic;
+		case SceneBucket::InstancedSkinned: return &m_instancedDynamic;
+		default: return nullptr;
+		}
+	}
+}
\ No newline at end of file
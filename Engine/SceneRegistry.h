@@ -0,0 +1,187 @@
+#ifndef SCENE_REGISTRY_H
+#define SCENE_REGISTRY_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Node.h"
+#include "SlotAllocator.h"
+
+namespace JLEngine
+{
+	enum class SceneBucket : uint8_t
+	{
+		None,				// registered but not drawn, e.g. an instanced submesh whose group is owned by another node
+		Static,
+		RigidAnimated,
+		InstancedStatic,
+		Skinned,
+		InstancedSkinned,
+		Transparent,
+		Count
+	};
+
+	// The per draw data buffer a bucket's slots index into
+	enum class PerDrawSpace : uint8_t
+	{
+		Static,				// static, rigid animated and instanced static share the static per draw buffer
+		Skinned,			// skinned and instanced skinned
+		Transparent,
+		Count,
+		None = Count
+	};
+
+	using SceneItemID = uint32_t;
+
+	// One registered submesh
+	struct SceneItem
+	{
+		Node* node = nullptr;
+		uint32_t submeshIndex = 0;
+		SceneBucket bucket = SceneBucket::None;
+		// position in the bucket list and in the full submesh list, both change when another item is swap removed
+		uint32_t listIndex = 0;
+		uint32_t submeshListIndex = 0;
+		// first per draw data entry and how many (the instance count for instanced buckets), fixed while registered
+		uint32_t slot = SlotAllocator::InvalidSlot;
+		uint32_t slotCount = 0;
+		// first joint matrix for the skinned buckets, instances share one palette
+		uint32_t jointSlot = SlotAllocator::InvalidSlot;
+		uint32_t jointCount = 0;
+		// copy of node->mesh->GetSubmesh(submeshIndex), kept in step by SetSubmeshFlags/SetSubmeshMaterial
+		SubMesh submesh;
+		std::string instanceKey;
+		bool live = false;
+		bool pendingAdd = false;
+		bool pendingDirty = false;
+	};
+
+	// Everything the renderer still has to mirror on the GPU since it last took the changes
+	struct SceneChanges
+	{
+		// copies, the ids and slots may already belong to something else
+		std::vector<SceneItem> removed;
+		std::vector<SceneItemID> added;
+		// per draw data needs rewriting (material or transform), the draw command is unchanged
+		std::vector<SceneItemID> dirty;
+		bool lightsChanged = false;
+
+		bool Empty() const { return removed.empty() && added.empty() && dirty.empty() && !lightsChanged; }
+		void Clear()
+		{
+			removed.clear();
+			added.clear();
+			dirty.clear();
+			lightsChanged = false;
+		}
+	};
+
+	// Sorts registered submeshes into the render buckets and keeps them that way as nodes come and go.
+	// Every submesh gets per draw data slots from its bucket's SlotAllocator, the slots never move while
+	// the submesh is registered so the renderer only rewrites what appears in the change log.
+	// Bucket lists use swap removal, their order is not meaningful. Nodes must be removed before they are destroyed.
+	class SceneRegistry
+	{
+	public:
+		SceneRegistry() = default;
+
+		void Clear();
+
+		// Registers node and everything below it, O(nodes + submeshes in the subtree)
+		void AddSubtree(Node* node);
+		void RemoveSubtree(Node* node);
+		bool IsRegistered(const Node* node) const { return m_nodeItems.find(node) != m_nodeItems.end(); }
+
+		// Moves the submesh to the bucket its new flags select, e.g. a static prop that starts animating
+		void SetSubmeshFlags(Node* node, uint32_t submeshIndex, uint32_t flags);
+		void SetSubmeshMaterial(Node* node, uint32_t submeshIndex, uint32_t materialHandle);
+		// Per draw data for every submesh on the node is rewritten, for static nodes moved after registration
+		void MarkDirty(Node* node);
+		// Points every registered copy of mesh's submesh at its new place in the batched VAO after a defragment.
+		// The draw command itself isn't in the change log, patched receives the items so the caller can fix its own copies
+		void PatchSubmeshGeometry(const Mesh* mesh, uint32_t submeshIndex, uint32_t firstIndex, uint32_t baseVertex, std::vector<SceneItemID>& patched);
+
+		// Swaps the pending changes into out and starts a new log
+		void TakeChanges(SceneChanges& out);
+		const SceneChanges& GetChanges() const { return m_changes; }
+
+		const SceneItem& GetItem(SceneItemID id) const { return m_items[id]; }
+		const std::vector<SceneItemID>& GetBucketItems(SceneBucket bucket) const { return m_bucketItems[static_cast<size_t>(bucket)]; }
+		const SlotAllocator& GetSlots(PerDrawSpace space) const { return m_slots[static_cast<size_t>(space)]; }
+		const SlotAllocator& GetJointSlots() const { return m_jointSlots; }
+		size_t GetItemCount() const { return m_itemIDs.LiveCount(); }
+
+		static PerDrawSpace GetPerDrawSpace(SceneBucket bucket);
+		static SceneBucket Classify(const SubMesh& submesh);
+
+		// --- BUCKET LISTS ---
+		std::vector<std::pair<SubMesh, Node*>>& GetSubmeshes() { return m_submeshList; }
+		std::vector<std::pair<SubMesh, Node*>>& GetNonInstancedStatic() { return m_nonInstancedStatic; }
+		std::vector<std::pair<SubMesh, Node*>>& GetNonInstancedDynamic() { return m_nonInstancedDynamic; }
+		std::vector<std::pair<SubMesh, Node*>>& GetRigidAnimated() { return m_animatedRigidObjects; }
+		std::vector<std::pair<SubMesh, Node*>>& GetTransparent() { return m_transparentObjects; }
+		std::unordered_map<std::string, std::pair<SubMesh, Node*>>& GetInstancedStatic() { return m_instancedStatic; }
+		std::unordered_map<std::string, std::pair<SubMesh, Node*>>& GetInstancedDynamic() { return m_instancedDynamic; }
+		std::unordered_map<std::string, Node*>& GetLightNodes() { return m_lights; }
+		std::vector<std::pair<std::shared_ptr<AnimationController>, Node*>>& GetSkinnedAnimationControllers() { return m_skinnedAnimControllers; }
+		std::vector<std::pair<std::shared_ptr<AnimationController>, Node*>>& GetRigidAnimationControllers() { return m_rigidAnimControllers; }
+
+		// Reorders a list bucket by distance from eyePos, the slots are untouched
+		void SortByDistance(SceneBucket bucket, const glm::vec3& eyePos, bool frontToBack);
+
+	private:
+		using ControllerList = std::vector<std::pair<std::shared_ptr<AnimationController>, Node*>>;
+
+		void AddNode(Node* node);
+		void RemoveNode(Node* node);
+		SceneItemID AddItem(Node* node, uint32_t submeshIndex);
+		void RemoveItem(SceneItemID id);
+		// Classifies the item, gives it slots and queues it for the renderer
+		void Place(SceneItemID id);
+		// Re-places the owner of an instanced group when its instance count no longer matches its slots
+		void ResizeInstanceGroup(Node* owner, const std::string& instanceKey);
+		// Takes a removed node out of its group's instance list, shrinks the owner's draw or hands the
+		// group to the next registered instance when the owner itself went
+		void LeaveInstanceGroup(Node* node, uint32_t submeshIndex, std::vector<Node*>& instances, const std::string& instanceKey, SceneBucket groupBucket);
+		// Moves the items of mesh placed before it became instanced into its instance group
+		void JoinInstanceGroup(Mesh* mesh, uint32_t submeshIndex);
+		// Takes the item out of its bucket, frees its slots and queues the removal if the renderer has seen it
+		void Release(SceneItemID id);
+		void MarkItemDirty(SceneItemID id);
+		void UpdateControllers(Node* node);
+		static void SetController(ControllerList& list, std::unordered_map<const Node*, uint32_t>& indices, Node* node, bool wanted);
+		std::vector<std::pair<SubMesh, Node*>>* GetList(SceneBucket bucket);
+		std::unordered_map<std::string, std::pair<SubMesh, Node*>>* GetInstanceMap(SceneBucket bucket);
+
+		std::vector<SceneItem> m_items;
+		SlotAllocator m_itemIDs;
+		std::unordered_map<const Node*, std::vector<SceneItemID>> m_nodeItems;
+		std::unordered_map<const Mesh*, std::vector<SceneItemID>> m_meshItems;	// meshes can be shared between nodes
+		std::vector<SceneItemID> m_bucketItems[static_cast<size_t>(SceneBucket::Count)];
+		std::vector<SceneItemID> m_submeshListItems;
+		SlotAllocator m_slots[static_cast<size_t>(PerDrawSpace::Count)];
+		SlotAllocator m_jointSlots;
+		SceneChanges m_changes;
+
+		std::vector<std::pair<SubMesh, Node*>> m_nonInstancedStatic;  // static meshes
+		std::vector<std::pair<SubMesh, Node*>> m_animatedRigidObjects; // rigid animations
+		std::vector<std::pair<SubMesh, Node*>> m_nonInstancedDynamic; // skinned meshes
+		std::vector<std::pair<SubMesh, Node*>> m_transparentObjects; // transparent meshes
+		std::vector<std::pair<SubMesh, Node*>> m_submeshList;
+		std::unordered_map<std::string, std::pair<SubMesh, Node*>> m_instancedStatic;	// instanced static meshes
+		std::unordered_map<std::string, std::pair<SubMesh, Node*>> m_instancedDynamic; // instanced skinned meshes
+		std::unordered_map<std::string, Node*> m_lights;
+
+		ControllerList m_skinnedAnimControllers;
+		ControllerList m_rigidAnimControllers;
+		std::unordered_map<const Node*, uint32_t> m_skinnedControllerIndices;
+		std::unordered_map<const Node*, uint32_t> m_rigidControllerIndices;
+	};
+}
+
+#endif
\ No newline at end of file
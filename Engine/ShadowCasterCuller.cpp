@@ -0,0 +1,74 @@
+#include "ShadowCasterCuller.h"
+
+namespace JLEngine
+{
+	void ShadowCasterCuller::ExtractCascadePlanes(const glm::mat4& lightSpaceMatrix, Plane planes[6])
+	{
+		// same extraction as ViewFrustum::ExtractPlanes, for an ortho matrix these are the six box faces
+		glm::vec4 row0(lightSpaceMatrix[0][0], lightSpaceMatrix[1][0], lightSpaceMatrix[2][0], lightSpaceMatrix[3][0]);
+		glm::vec4 row1(lightSpaceMatrix[0][1], lightSpaceMatrix[1][1], lightSpaceMatrix[2][1], lightSpaceMatrix[3][1]);
+		glm::vec4 row2(lightSpaceMatrix[0][2], lightSpaceMatrix[1][2], lightSpaceMatrix[2][2], lightSpaceMatrix[3][2]);
+		glm::vec4 row3(lightSpaceMatrix[0][3], lightSpaceMatrix[1][3], lightSpaceMatrix[2][3], lightSpaceMatrix[3][3]);
+
+		planes[0] = Plane(row3 + row0);	// Left
+		planes[1] = Plane(row3 - row0);	// Right
+		planes[2] = Plane(row3 + row1);	// Bottom
+		planes[3] = Plane(row3 - row1);	// Top
+		planes[5] = Plane(row3 - row2);	// Far
+
+		// Near faces the light, a zero normal with a positive distance passes every box
+		planes[4] = Plane();
+		planes[4].m_distance = 1.0f;
+	}
+
+	void ShadowCasterCuller::Cull(const FrustumCuller& bounds, const std::vector<glm::mat4>& cascadeLightSpaceMatrices)
+	{
+		m_visibility.resize(cascadeLightSpaceMatrices.size());
+		m_stats.resize(cascadeLightSpaceMatrices.size());
+
+		Plane planes[6];
+		for (size_t cascade = 0; cascade < cascadeLightSpaceMatrices.size(); ++cascade)
+		{
+			ExtractCascadePlanes(cascadeLightSpaceMatrices[cascade], planes);
+			m_stats[cascade] = bounds.Cull(planes, m_visibility[cascade]);
+		}
+	}
+
+	void ShadowCasterCuller::SetAllVisible(size_t slotCount, size_t cascadeCount)
+	{
+		m_visibility.resize(cascadeCount);
+		m_stats.resize(cascadeCount);
+
+		auto count = static_cast<uint32_t>(slotCount);
+		for (size_t cascade = 0; cascade < cascadeCount; ++cascade)
+		{
+			m_visibility[cascade].assign(slotCount, 1);
+			m_stats[cascade] = { count, count, 0 };
+		}
+	}
+
+	uint32_t ShadowCasterCuller::BuildCascadeCommands(const std::vector<DrawIndirectCommand>& allCommands,
+		const std::vector<uint32_t>& cullSlots,
+		const std::vector<uint8_t>& visibility,
+		std::vector<DrawIndirectCommand>& cascadeCommands)
+	{
+		cascadeCommands.resize(allCommands.size());
+
+		uint32_t drawn = 0;
+		for (size_t i = 0; i < allCommands.size(); ++i)
+		{
+			cascadeCommands[i] = allCommands[i];
+
+			uint32_t slot = i < cullSlots.size() ? cullSlots[i] : UINT32_MAX;
+			if (slot < visibility.size() && !visibility[slot])
+			{
+				cascadeCommands[i].instanceCount = 0;
+			}
+			else if (cascadeCommands[i].instanceCount > 0)
+			{
+				drawn++;
+			}
+		}
+		return drawn;
+	}
+}
\ No newline at end of file
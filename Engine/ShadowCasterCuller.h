@@ -0,0 +1,49 @@
+#ifndef SHADOW_CASTER_CULLER_H
+#define SHADOW_CASTER_CULLER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "CollisionShapes.h"
+#include "FrustumCuller.h"
+#include "IndirectDrawBuffer.h"
+
+namespace JLEngine
+{
+	// Builds a caster list per shadow cascade from the cascade light space matrices.
+	// The cull volume is the cascade's ortho box with the light facing side removed, anything
+	// between the light and the box can still throw a shadow into it so it has to be kept.
+	class ShadowCasterCuller
+	{
+	public:
+		ShadowCasterCuller() = default;
+
+		// Planes of the ortho box, normals point inwards and plane 4 (near) always passes
+		static void ExtractCascadePlanes(const glm::mat4& lightSpaceMatrix, Plane planes[6]);
+
+		// Culls every box in bounds against each cascade, visibility is indexed by the culler slot
+		void Cull(const FrustumCuller& bounds, const std::vector<glm::mat4>& cascadeLightSpaceMatrices);
+
+		// Marks every slot visible for every cascade, used when culling is disabled
+		void SetAllVisible(size_t slotCount, size_t cascadeCount);
+
+		size_t GetCascadeCount() const { return m_visibility.size(); }
+		const std::vector<uint8_t>& GetVisibility(size_t cascade) const { return m_visibility[cascade]; }
+		const CullingStats& GetStats(size_t cascade) const { return m_stats[cascade]; }
+
+		// Copies allCommands into cascadeCommands keeping the order, commands whose slot is culled get
+		// an instanceCount of 0. Draw ids are unchanged so shaders indexing by gl_DrawID still line up.
+		// Slots past the end of visibility (VAOResource::NoCullSlot) are always drawn. Returns the number of commands that will draw something.
+		static uint32_t BuildCascadeCommands(const std::vector<DrawIndirectCommand>& allCommands,
+			const std::vector<uint32_t>& cullSlots,
+			const std::vector<uint8_t>& visibility,
+			std::vector<DrawIndirectCommand>& cascadeCommands);
+
+	private:
+		std::vector<std::vector<uint8_t>> m_visibility;
+		std::vector<CullingStats> m_stats;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "SkinningEvaluator.h"
+
+namespace JLEngine
+{
+	void SkinningEvaluator::Evaluate(const std::vector<SkinningTask>& tasks, std::vector<glm::mat4>& palette, JobSystem& jobs, size_t grain)
+	{
+		if (tasks.empty()) return;
+
+		// indexed by JobSystem thread index, sized before the jobs start so it never moves under them
+		if (m_scratch.size() < jobs.GetThreadCount())
+			m_scratch.resize(jobs.GetThreadCount());
+
+		jobs.ParallelFor(tasks.size(), grain, [&](size_t begin, size_t end, unsigned threadIndex)
+			{
+				auto& scratch = m_scratch[threadIndex];
+				for (size_t i = begin; i < end; ++i)
+				{
+					const auto& task = tasks[i];
+					if (task.animation == nullptr || task.skeleton == nullptr || task.jointCount == 0) continue;
+					if (static_cast<size_t>(task.jointSlot) + task.jointCount > palette.size()) continue;
+
+					if (task.controller != nullptr && task.controller->IsBlending())
+					{
+						AnimHelpers::EvaluateBlendedJointMatrices(*task.controller, *task.skeleton, *task.inverseBindMatrices,
+							scratch, palette.data() + task.jointSlot, task.jointCount);
+						continue;
+					}
+
+					AnimHelpers::EvaluateJointMatrices(*task.animation, task.time, *task.keyframeIndices, *task.skeleton,
+						*task.inverseBindMatrices, scratch, palette.data() + task.jointSlot, task.jointCount);
+				}
+			});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef SKINNING_EVALUATOR_H
+#define SKINNING_EVALUATOR_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AnimHelpers.h"
+#include "JobSystem.h"
+
+namespace JLEngine
+{
+	// One skeleton to pose this frame and the slice of the palette it owns
+	struct SkinningTask
+	{
+		Animation* animation = nullptr;
+		float time = 0.0f;
+		const std::vector<size_t>* keyframeIndices = nullptr;
+		const Skeleton* skeleton = nullptr;
+		const std::vector<glm::mat4>* inverseBindMatrices = nullptr;
+		uint32_t jointSlot = 0;
+		uint32_t jointCount = 0;
+		// blends every layer of the controller instead when it has more than one clip playing
+		const AnimationController* controller = nullptr;
+	};
+
+	// Evaluates skinned animations as parallel jobs over the task list. Every task writes only its own
+	// [jointSlot, jointSlot + jointCount) slice of the palette so jobs never share output, and each
+	// thread works in its own AnimationScratch so a warmed up frame does no heap allocation.
+	class SkinningEvaluator
+	{
+	public:
+		// Tasks per job, enough to cover the queueing cost of a chunk
+		static constexpr size_t DefaultGrain = 8;
+
+		// palette must already hold every task's slice
+		void Evaluate(const std::vector<SkinningTask>& tasks, std::vector<glm::mat4>& palette, JobSystem& jobs, size_t grain = DefaultGrain);
+
+	private:
+		std::vector<AnimationScratch> m_scratch;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef SLOT_ALLOCATOR_H
+#define SLOT_ALLOCATOR_H
+
+#include <cstdint>
+#include <vector>
+
+namespace JLEngine
+{
+	// Hands out stable indices into a flat array (per draw data, joint palettes, item tables).
+	// Freed ranges go on a free list and are reused before the array grows, so a live index never
+	// moves and adding or removing something only touches the entries it owns.
+	class SlotAllocator
+	{
+	public:
+		static constexpr uint32_t InvalidSlot = UINT32_MAX;
+
+		// First of count contiguous slots, InvalidSlot for a count of 0
+		uint32_t Allocate(uint32_t count = 1)
+		{
+			if (count == 0) return InvalidSlot;
+
+			// single slots can come from any free range, take the end of the last one so it is O(1)
+			// larger requests are first fit, searched from the most recently freed
+			for (size_t i = m_freeRanges.size(); i-- > 0;)
+			{
+				auto& range = m_freeRanges[i];
+				if (range.count < count) continue;
+
+				range.count -= count;
+				uint32_t first = range.first + range.count;
+				if (range.count == 0)
+				{
+					range = m_freeRanges.back();
+					m_freeRanges.pop_back();
+				}
+				m_live += count;
+				return first;
+			}
+
+			uint32_t first = m_capacity;
+			m_capacity += count;
+			m_live += count;
+			return first;
+		}
+
+		void Free(uint32_t first, uint32_t count = 1)
+		{
+			if (first == InvalidSlot || count == 0) return;
+			m_live -= count;
+
+			// removals usually come in runs (a despawned subtree), merge with the last freed range when they touch
+			if (!m_freeRanges.empty())
+			{
+				auto& last = m_freeRanges.back();
+				if (last.first + last.count == first)
+				{
+					last.count += count;
+					return;
+				}
+				if (first + count == last.first)
+				{
+					last.first = first;
+					last.count += count;
+					return;
+				}
+			}
+			m_freeRanges.push_back({ first, count });
+		}
+
+		void Clear()
+		{
+			m_freeRanges.clear();
+			m_capacity = 0;
+			m_live = 0;
+		}
+
+		// One past the highest slot ever handed out, the backing arrays need this many entries
+		uint32_t Capacity() const { return m_capacity; }
+		uint32_t LiveCount() const { return m_live; }
+		size_t FreeRangeCount() const { return m_freeRanges.size(); }
+
+	private:
+		struct Range
+		{
+			uint32_t first;
+			uint32_t count;
+		};
+
+		std::vector<Range> m_freeRanges;
+		uint32_t m_capacity = 0;
+		uint32_t m_live = 0;
+	};
+}
+
+#endif
\ No newline at end of file
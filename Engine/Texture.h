@@ -13,6 +13,11 @@ namespace JLEngine
     struct TexParams
     {
         bool mipmapEnabled =        true;
+        // 8 bit textures get their mips from MipGenerator instead of glGenerateTextureMipmap,
+        // sRGB formats are filtered in linear light
+        bool cpuMipmaps =           true;
+        bool normalMap =            false;      // mips are renormalized
+        float alphaCutoff =         -1.0f;      // MASK cutoff, the mips keep the alpha tested coverage
         uint32_t wrapS =            GL_REPEAT;
         uint32_t wrapT =            GL_REPEAT;
         uint32_t wrapR =            GL_REPEAT;
@@ -104,6 +109,8 @@ namespace JLEngine
             if (overwrite.wrapR > 0) target.wrapR = overwrite.wrapR;
             if (overwrite.wrapS > 0) target.wrapS = overwrite.wrapS;
             if (overwrite.wrapT > 0) target.wrapT = overwrite.wrapT;
+            if (overwrite.normalMap) target.normalMap = true;
+            if (overwrite.alphaCutoff >= 0.0f) target.alphaCutoff = overwrite.alphaCutoff;
             return target;
         }
 
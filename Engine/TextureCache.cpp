@@ -0,0 +1,105 @@
+#include "TextureCache.h"
+#include "BinaryStream.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace JLEngine
+{
+	namespace
+	{
+		constexpr char CacheMagic[4] = { 'J', 'L', 'T', 'C' };
+		// bump when the file layout or the encoders change, old textures are then recooked
+		constexpr uint32_t CacheVersion = 2;
+		constexpr size_t BlockAlignment = 16;
+	}
+
+	uint64_t TextureCache::Hash(uint64_t sourceHash, int imageIndex, TextureUsage usage, const TextureCookSettings& settings, float alphaCutoff)
+	{
+		// FNV-1a like the mesh cache, the source hash already covers the file's bytes
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [&hash](const void* data, size_t size)
+			{
+				auto bytes = static_cast<const uint8_t*>(data);
+				for (size_t i = 0; i < size; ++i)
+				{
+					hash ^= bytes[i];
+					hash *= 1099511628211ull;
+				}
+			};
+
+		mix(&sourceHash, sizeof(sourceHash));
+		mix(&imageIndex, sizeof(imageIndex));
+		mix(&usage, sizeof(usage));
+		mix(&settings.highQuality, sizeof(settings.highQuality));
+		mix(&alphaCutoff, sizeof(alphaCutoff));
+		mix(&CacheVersion, sizeof(CacheVersion));
+		return hash;
+	}
+
+	std::string TextureCache::CachePath(const std::string& cacheFolder, uint64_t hash)
+	{
+		return (std::filesystem::path(cacheFolder) / (std::to_string(hash) + ".jltex")).string();
+	}
+
+	bool TextureCache::Write(const std::string& path, uint64_t hash, const CompressedImage& image)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) return false;
+
+		BinaryWriter writer(file);
+		writer.Bytes(CacheMagic, sizeof(CacheMagic));
+		writer.Value(CacheVersion);
+		writer.Value(hash);
+		writer.Value(static_cast<uint32_t>(image.format));
+		writer.Value(static_cast<uint8_t>(image.srgb));
+		writer.Value(image.width);
+		writer.Value(image.height);
+		writer.Vector(image.levels);
+
+		writer.Align(BlockAlignment);
+		writer.Bytes(image.Data(), static_cast<size_t>(image.SizeInBytes()));
+		return writer.Good();
+	}
+
+	bool TextureCache::Open(const std::string& path, uint64_t expectedHash)
+	{
+		Close();
+		if (!m_file.Open(path)) return false;
+
+		BinaryReader reader(m_file.Data(), m_file.Size());
+		char magic[4] = {};
+		const std::byte* magicBytes = reader.Bytes(sizeof(magic));
+		if (magicBytes) std::memcpy(magic, magicBytes, sizeof(magic));
+		uint32_t version = reader.Value<uint32_t>();
+		uint64_t hash = reader.Value<uint64_t>();
+
+		if (!reader.Good() || std::memcmp(magic, CacheMagic, sizeof(magic)) != 0 || version != CacheVersion || hash != expectedHash)
+		{
+			Close();
+			return false;
+		}
+
+		m_image.format = static_cast<BlockFormat>(reader.Value<uint32_t>());
+		m_image.srgb = reader.Value<uint8_t>() != 0;
+		reader.Value(m_image.width);
+		reader.Value(m_image.height);
+		reader.Vector(m_image.levels);
+
+		reader.Align(BlockAlignment);
+		m_image.mapped = reader.Bytes(static_cast<size_t>(m_image.SizeInBytes()));
+		if (!reader.Good() || m_image.levels.empty())
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void TextureCache::Close()
+	{
+		m_image = CompressedImage();
+		m_file.Close();
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.h"
+#include "TextureCooker.h"
+
+namespace JLEngine
+{
+	// One cooked texture, the compressed mip chain of a source image for one use. Opening maps the
+	// file and points the image's levels into the mapping so the upload reads straight from it.
+	// Keyed like MeshCache by a hash of the source file, plus the image, its use, the settings and
+	// the MASK cutoff its mips keep the coverage of
+	class TextureCache
+	{
+	public:
+		static uint64_t Hash(uint64_t sourceHash, int imageIndex, TextureUsage usage, const TextureCookSettings& settings, float alphaCutoff = -1.0f);
+		static std::string CachePath(const std::string& cacheFolder, uint64_t hash);
+
+		static bool Write(const std::string& path, uint64_t hash, const CompressedImage& image);
+
+		// False when the file is missing, from another version or source, or truncated
+		bool Open(const std::string& path, uint64_t expectedHash);
+		void Close();
+
+		// Valid until Close, the levels point into the mapping
+		const CompressedImage& GetImage() const { return m_image; }
+
+	private:
+		MappedFile m_file;
+		CompressedImage m_image;
+	};
+}
+
+#endif
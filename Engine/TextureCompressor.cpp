@@ -0,0 +1,681 @@
+#include "TextureCompressor.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace JLEngine
+{
+	namespace
+	{
+		// BC7 4 bit index weights out of 64
+		constexpr int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// The helpers below take the block as 16 RGBA points and only look at the first N channels.
+		// Direction of the largest spread of the points around their mean, by power iteration from
+		// the covariance row with the largest variance. Solid blocks get any unit axis
+		template <int N>
+		void PrincipalAxis(const float (*points)[4], const float* mean, float* axis)
+		{
+			float covariance[N][N] = {};
+			for (int i = 0; i < 16; ++i)
+			{
+				float d[N];
+				for (int c = 0; c < N; ++c) d[c] = points[i][c] - mean[c];
+				for (int r = 0; r < N; ++r)
+					for (int c = 0; c < N; ++c)
+						covariance[r][c] += d[r] * d[c];
+			}
+
+			int largest = 0;
+			for (int c = 1; c < N; ++c)
+			{
+				if (covariance[c][c] > covariance[largest][largest]) largest = c;
+			}
+
+			for (int c = 0; c < N; ++c) axis[c] = covariance[largest][c];
+			if (covariance[largest][largest] < 1e-6f)
+			{
+				for (int c = 0; c < N; ++c) axis[c] = 1.0f;
+			}
+
+			for (int iteration = 0; iteration < 8; ++iteration)
+			{
+				float next[N] = {};
+				for (int r = 0; r < N; ++r)
+					for (int c = 0; c < N; ++c)
+						next[r] += covariance[r][c] * axis[c];
+
+				float length = 0.0f;
+				for (int c = 0; c < N; ++c) length += next[c] * next[c];
+				if (length < 1e-12f) break;
+				for (int c = 0; c < N; ++c) axis[c] = next[c];
+
+				// keeps the values in range, the last pass normalizes properly
+				float scale = 1.0f / std::sqrt(length);
+				for (int c = 0; c < N; ++c) axis[c] *= scale;
+			}
+
+			float length = 0.0f;
+			for (int c = 0; c < N; ++c) length += axis[c] * axis[c];
+			float scale = 1.0f / std::sqrt(length);
+			for (int c = 0; c < N; ++c) axis[c] *= scale;
+		}
+
+		// The ends of the points' projection onto the axis, clamped to the 8 bit range
+		template <int N>
+		void AxisEndpoints(const float (*points)[4], const float* mean, const float* axis, float* low, float* high)
+		{
+			float minT = FLT_MAX;
+			float maxT = -FLT_MAX;
+			for (int i = 0; i < 16; ++i)
+			{
+				float t = 0.0f;
+				for (int c = 0; c < N; ++c) t += (points[i][c] - mean[c]) * axis[c];
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+
+			for (int c = 0; c < N; ++c)
+			{
+				low[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+				high[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+			}
+		}
+
+		// Endpoints a and b minimizing the squared error of (1 - t) * a + t * b against the points
+		// for the given t. False when the ts don't pin them down
+		template <int N>
+		bool LeastSquaresEndpoints(const float (*points)[4], const float* t, float* a, float* b)
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ax[N] = {}, bx[N] = {};
+			for (int i = 0; i < 16; ++i)
+			{
+				float s = 1.0f - t[i];
+				aa += s * s;
+				ab += s * t[i];
+				bb += t[i] * t[i];
+				for (int c = 0; c < N; ++c)
+				{
+					ax[c] += s * points[i][c];
+					bx[c] += t[i] * points[i][c];
+				}
+			}
+
+			float det = aa * bb - ab * ab;
+			if (std::abs(det) < 1e-4f) return false;
+
+			float invDet = 1.0f / det;
+			for (int c = 0; c < N; ++c)
+			{
+				a[c] = std::clamp((ax[c] * bb - bx[c] * ab) * invDet, 0.0f, 255.0f);
+				b[c] = std::clamp((bx[c] * aa - ax[c] * ab) * invDet, 0.0f, 255.0f);
+			}
+			return true;
+		}
+
+		void LoadPoints(const uint8_t* block, int channels, float (*points)[4], float* mean)
+		{
+			for (int c = 0; c < channels; ++c) mean[c] = 0.0f;
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < channels; ++c)
+				{
+					points[i][c] = block[i * 4 + c];
+					mean[c] += points[i][c];
+				}
+			}
+			for (int c = 0; c < channels; ++c) mean[c] /= 16.0f;
+		}
+
+		void WriteLE(std::byte* out, uint64_t value, int bytes)
+		{
+			for (int i = 0; i < bytes; ++i)
+				out[i] = static_cast<std::byte>((value >> (i * 8)) & 0xFF);
+		}
+
+		uint64_t ReadLE(const std::byte* in, int bytes)
+		{
+			uint64_t value = 0;
+			for (int i = 0; i < bytes; ++i)
+				value |= static_cast<uint64_t>(in[i]) << (i * 8);
+			return value;
+		}
+
+		// --- BC1 --- //
+		uint16_t Pack565(const float* c)
+		{
+			int r = std::clamp(static_cast<int>(std::lround(c[0] * 31.0f / 255.0f)), 0, 31);
+			int g = std::clamp(static_cast<int>(std::lround(c[1] * 63.0f / 255.0f)), 0, 63);
+			int b = std::clamp(static_cast<int>(std::lround(c[2] * 31.0f / 255.0f)), 0, 31);
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		void Unpack565(uint16_t value, int* c)
+		{
+			int r = (value >> 11) & 31;
+			int g = (value >> 5) & 63;
+			int b = value & 31;
+			c[0] = (r << 3) | (r >> 2);
+			c[1] = (g << 2) | (g >> 4);
+			c[2] = (b << 3) | (b >> 2);
+		}
+
+		// The four colour palette, as the decoder builds it
+		void BC1Palette(uint16_t c0, uint16_t c1, int (*palette)[3])
+		{
+			Unpack565(c0, palette[0]);
+			Unpack565(c1, palette[1]);
+			for (int c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+		}
+
+		// Nearest palette entry for each pixel, returns the squared error
+		int FitBC1Indices(const float (*points)[4], uint16_t c0, uint16_t c1, uint8_t* indices)
+		{
+			int palette[4][3];
+			BC1Palette(c0, c1, palette);
+
+			int error = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				int best = 0;
+				int bestDistance = INT32_MAX;
+				for (int k = 0; k < 4; ++k)
+				{
+					int distance = 0;
+					for (int c = 0; c < 3; ++c)
+					{
+						int d = static_cast<int>(points[i][c]) - palette[k][c];
+						distance += d * d;
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						best = k;
+					}
+				}
+				indices[i] = static_cast<uint8_t>(best);
+				error += bestDistance;
+			}
+			return error;
+		}
+
+		// --- BC4 --- //
+		void BC4Palette(int a0, int a1, int* palette)
+		{
+			palette[0] = a0;
+			palette[1] = a1;
+			if (a0 > a1)
+			{
+				for (int k = 2; k < 8; ++k)
+					palette[k] = ((8 - k) * a0 + (k - 1) * a1 + 3) / 7;
+			}
+			else
+			{
+				for (int k = 2; k < 6; ++k)
+					palette[k] = ((6 - k) * a0 + (k - 1) * a1 + 2) / 5;
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+
+		// --- BC7 --- //
+		struct BitWriter
+		{
+			uint8_t bytes[16] = {};
+			int position = 0;
+
+			void Put(uint32_t value, int count)
+			{
+				for (int bit = 0; bit < count; ++bit, ++position)
+				{
+					if ((value >> bit) & 1u) bytes[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+				}
+			}
+		};
+
+		struct BitReader
+		{
+			const std::byte* bytes;
+			int position = 0;
+
+			uint32_t Get(int count)
+			{
+				uint32_t value = 0;
+				for (int bit = 0; bit < count; ++bit, ++position)
+				{
+					uint32_t set = (static_cast<uint32_t>(bytes[position >> 3]) >> (position & 7)) & 1u;
+					value |= set << bit;
+				}
+				return value;
+			}
+		};
+
+		// Mode 6 endpoint, 7 bits a channel and one p-bit shared by the four
+		struct BC7Endpoint
+		{
+			int value[4] = {};
+			int pbit = 0;
+
+			int Expanded(int channel) const { return (value[channel] << 1) | pbit; }
+		};
+
+		BC7Endpoint QuantizeBC7(const float* endpoint, int pbit)
+		{
+			BC7Endpoint quantized;
+			quantized.pbit = pbit;
+			for (int c = 0; c < 4; ++c)
+				quantized.value[c] = std::clamp(static_cast<int>(std::lround((endpoint[c] - pbit) * 0.5f)), 0, 127);
+			return quantized;
+		}
+
+		int FitBC7Indices(const float (*points)[4], const BC7Endpoint& e0, const BC7Endpoint& e1, uint8_t* indices)
+		{
+			int palette[16][4];
+			for (int k = 0; k < 16; ++k)
+			{
+				for (int c = 0; c < 4; ++c)
+					palette[k][c] = ((64 - BC7Weights[k]) * e0.Expanded(c) + BC7Weights[k] * e1.Expanded(c) + 32) >> 6;
+			}
+
+			int error = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				int best = 0;
+				int bestDistance = INT32_MAX;
+				for (int k = 0; k < 16; ++k)
+				{
+					int distance = 0;
+					for (int c = 0; c < 4; ++c)
+					{
+						int d = static_cast<int>(points[i][c]) - palette[k][c];
+						distance += d * d;
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						best = k;
+					}
+				}
+				indices[i] = static_cast<uint8_t>(best);
+				error += bestDistance;
+			}
+			return error;
+		}
+
+		void EncodeBlock(BlockFormat format, const uint8_t* block, std::byte* out)
+		{
+			switch (format)
+			{
+			case BlockFormat::BC1:
+				TextureCompressor::EncodeBC1(block, out);
+				break;
+			case BlockFormat::BC3:
+				TextureCompressor::EncodeBC4(block, 3, out);
+				TextureCompressor::EncodeBC1(block, out + 8);
+				break;
+			case BlockFormat::BC4:
+				TextureCompressor::EncodeBC4(block, 0, out);
+				break;
+			case BlockFormat::BC5:
+				TextureCompressor::EncodeBC4(block, 0, out);
+				TextureCompressor::EncodeBC4(block, 1, out + 8);
+				break;
+			case BlockFormat::BC7:
+				TextureCompressor::EncodeBC7(block, out);
+				break;
+			}
+		}
+
+		void DecodeBlock(BlockFormat format, const std::byte* in, uint8_t* block)
+		{
+			switch (format)
+			{
+			case BlockFormat::BC1:
+				TextureCompressor::DecodeBC1(in, block);
+				break;
+			case BlockFormat::BC3:
+				TextureCompressor::DecodeBC1(in + 8, block, true);
+				TextureCompressor::DecodeBC4(in, 3, block);
+				break;
+			case BlockFormat::BC4:
+				TextureCompressor::DecodeBC4(in, 0, block);
+				break;
+			case BlockFormat::BC5:
+				TextureCompressor::DecodeBC4(in, 0, block);
+				TextureCompressor::DecodeBC4(in + 8, 1, block);
+				break;
+			case BlockFormat::BC7:
+				TextureCompressor::DecodeBC7(in, block);
+				break;
+			}
+		}
+	}
+
+	size_t TextureCompressor::BlockBytes(BlockFormat format)
+	{
+		return (format == BlockFormat::BC1 || format == BlockFormat::BC4) ? 8 : 16;
+	}
+
+	size_t TextureCompressor::CompressedSize(BlockFormat format, uint32_t width, uint32_t height)
+	{
+		size_t blocksX = (static_cast<size_t>(width) + 3) / 4;
+		size_t blocksY = (static_cast<size_t>(height) + 3) / 4;
+		return blocksX * blocksY * BlockBytes(format);
+	}
+
+	void TextureCompressor::Compress(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, std::byte* out, JobSystem* jobs)
+	{
+		size_t blocksX = (static_cast<size_t>(width) + 3) / 4;
+		size_t blocksY = (static_cast<size_t>(height) + 3) / 4;
+		size_t blockBytes = BlockBytes(format);
+
+		auto encodeRows = [&](size_t begin, size_t end, unsigned)
+			{
+				uint8_t block[64];
+				for (size_t by = begin; by < end; ++by)
+				{
+					for (size_t bx = 0; bx < blocksX; ++bx)
+					{
+						// blocks past the edge repeat the last row and column
+						for (int y = 0; y < 4; ++y)
+						{
+							size_t sy = std::min<size_t>(by * 4 + y, height - 1);
+							for (int x = 0; x < 4; ++x)
+							{
+								size_t sx = std::min<size_t>(bx * 4 + x, width - 1);
+								std::memcpy(block + (y * 4 + x) * 4, rgba + (sy * width + sx) * 4, 4);
+							}
+						}
+						EncodeBlock(format, block, out + (by * blocksX + bx) * blockBytes);
+					}
+				}
+			};
+
+		if (jobs)
+			jobs->ParallelFor(blocksY, 1, encodeRows);
+		else
+			encodeRows(0, blocksY, 0);
+	}
+
+	void TextureCompressor::Decompress(BlockFormat format, const std::byte* blocks, uint32_t width, uint32_t height, uint8_t* rgba)
+	{
+		size_t blocksX = (static_cast<size_t>(width) + 3) / 4;
+		size_t blocksY = (static_cast<size_t>(height) + 3) / 4;
+		size_t blockBytes = BlockBytes(format);
+
+		uint8_t block[64];
+		for (size_t by = 0; by < blocksY; ++by)
+		{
+			for (size_t bx = 0; bx < blocksX; ++bx)
+			{
+				for (int i = 0; i < 16; ++i)
+				{
+					block[i * 4 + 0] = 0;
+					block[i * 4 + 1] = 0;
+					block[i * 4 + 2] = 0;
+					block[i * 4 + 3] = 255;
+				}
+				DecodeBlock(format, blocks + (by * blocksX + bx) * blockBytes, block);
+
+				for (int y = 0; y < 4; ++y)
+				{
+					size_t py = by * 4 + y;
+					if (py >= height) break;
+					for (int x = 0; x < 4; ++x)
+					{
+						size_t px = bx * 4 + x;
+						if (px >= width) break;
+						std::memcpy(rgba + (py * width + px) * 4, block + (y * 4 + x) * 4, 4);
+					}
+				}
+			}
+		}
+	}
+
+	void TextureCompressor::EncodeBC1(const uint8_t* block, std::byte* out)
+	{
+		float points[16][4];
+		float mean[4];
+		LoadPoints(block, 3, points, mean);
+
+		float axis[3], low[3], high[3];
+		PrincipalAxis<3>(points, mean, axis);
+		AxisEndpoints<3>(points, mean, axis, low, high);
+
+		uint16_t c0 = Pack565(high);
+		uint16_t c1 = Pack565(low);
+		uint8_t indices[16];
+		int error = FitBC1Indices(points, c0, c1, indices);
+
+		// least squares endpoints for the chosen indices, kept while they lower the error
+		static const float IndexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+		for (int iteration = 0; iteration < 2 && error > 0; ++iteration)
+		{
+			float t[16];
+			for (int i = 0; i < 16; ++i) t[i] = IndexWeights[indices[i]];
+
+			float a[3], b[3];
+			if (!LeastSquaresEndpoints<3>(points, t, a, b)) break;
+
+			uint16_t n0 = Pack565(a);
+			uint16_t n1 = Pack565(b);
+			uint8_t refined[16];
+			int refinedError = FitBC1Indices(points, n0, n1, refined);
+			if (refinedError >= error) break;
+
+			c0 = n0;
+			c1 = n1;
+			std::memcpy(indices, refined, sizeof(indices));
+			error = refinedError;
+		}
+
+		// four colours need c0 > c1, swapping the endpoints swaps 0 with 1 and 2 with 3
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+			for (auto& index : indices) index ^= 1;
+		}
+		else if (c0 == c1)
+		{
+			std::memset(indices, 0, sizeof(indices));
+		}
+
+		uint32_t bits = 0;
+		for (int i = 0; i < 16; ++i) bits |= static_cast<uint32_t>(indices[i]) << (i * 2);
+
+		WriteLE(out, c0, 2);
+		WriteLE(out + 2, c1, 2);
+		WriteLE(out + 4, bits, 4);
+	}
+
+	void TextureCompressor::EncodeBC4(const uint8_t* block, int channel, std::byte* out)
+	{
+		int low = 255, high = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			low = std::min<int>(low, block[i * 4 + channel]);
+			high = std::max<int>(high, block[i * 4 + channel]);
+		}
+
+		// eight values between the extremes, a solid block lands in the six value mode with
+		// both endpoints equal and every index 0
+		int palette[8];
+		BC4Palette(high, low, palette);
+
+		uint64_t bits = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			int value = block[i * 4 + channel];
+			int best = 0;
+			int bestDistance = INT32_MAX;
+			for (int k = 0; k < 8; ++k)
+			{
+				int distance = std::abs(value - palette[k]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = k;
+				}
+			}
+			bits |= static_cast<uint64_t>(best) << (i * 3);
+		}
+
+		out[0] = static_cast<std::byte>(high);
+		out[1] = static_cast<std::byte>(low);
+		WriteLE(out + 2, bits, 6);
+	}
+
+	void TextureCompressor::EncodeBC7(const uint8_t* block, std::byte* out)
+	{
+		float points[16][4];
+		float mean[4];
+		LoadPoints(block, 4, points, mean);
+
+		float axis[4], low[4], high[4];
+		PrincipalAxis<4>(points, mean, axis);
+		AxisEndpoints<4>(points, mean, axis, low, high);
+
+		// the p-bits are tried in every combination, the best pair is refined
+		BC7Endpoint e0, e1;
+		uint8_t indices[16];
+		int error = INT32_MAX;
+		for (int pbits = 0; pbits < 4; ++pbits)
+		{
+			BC7Endpoint q0 = QuantizeBC7(low, pbits & 1);
+			BC7Endpoint q1 = QuantizeBC7(high, pbits >> 1);
+			uint8_t candidate[16];
+			int candidateError = FitBC7Indices(points, q0, q1, candidate);
+			if (candidateError < error)
+			{
+				e0 = q0;
+				e1 = q1;
+				std::memcpy(indices, candidate, sizeof(indices));
+				error = candidateError;
+			}
+		}
+
+		for (int iteration = 0; iteration < 4 && error > 0; ++iteration)
+		{
+			float t[16];
+			for (int i = 0; i < 16; ++i) t[i] = BC7Weights[indices[i]] / 64.0f;
+
+			float a[4], b[4];
+			if (!LeastSquaresEndpoints<4>(points, t, a, b)) break;
+
+			bool improved = false;
+			for (int pbits = 0; pbits < 4; ++pbits)
+			{
+				BC7Endpoint n0 = QuantizeBC7(a, pbits & 1);
+				BC7Endpoint n1 = QuantizeBC7(b, pbits >> 1);
+				uint8_t refined[16];
+				int refinedError = FitBC7Indices(points, n0, n1, refined);
+				if (refinedError < error)
+				{
+					e0 = n0;
+					e1 = n1;
+					std::memcpy(indices, refined, sizeof(indices));
+					error = refinedError;
+					improved = true;
+				}
+			}
+			if (!improved) break;
+		}
+
+		// the first index is stored without its top bit, so it has to be below 8
+		if (indices[0] >= 8)
+		{
+			std::swap(e0, e1);
+			for (auto& index : indices) index = static_cast<uint8_t>(15 - index);
+		}
+
+		BitWriter writer;
+		writer.Put(1u << 6, 7);
+		for (int c = 0; c < 4; ++c)
+		{
+			writer.Put(e0.value[c], 7);
+			writer.Put(e1.value[c], 7);
+		}
+		writer.Put(e0.pbit, 1);
+		writer.Put(e1.pbit, 1);
+		writer.Put(indices[0], 3);
+		for (int i = 1; i < 16; ++i) writer.Put(indices[i], 4);
+
+		std::memcpy(out, writer.bytes, sizeof(writer.bytes));
+	}
+
+	void TextureCompressor::DecodeBC1(const std::byte* in, uint8_t* block, bool fourColors)
+	{
+		uint16_t c0 = static_cast<uint16_t>(ReadLE(in, 2));
+		uint16_t c1 = static_cast<uint16_t>(ReadLE(in + 2, 2));
+		uint32_t bits = static_cast<uint32_t>(ReadLE(in + 4, 4));
+
+		int palette[4][4];
+		Unpack565(c0, palette[0]);
+		Unpack565(c1, palette[1]);
+		palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+		for (int c = 0; c < 3; ++c)
+		{
+			if (c0 > c1 || fourColors)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		if (!(c0 > c1 || fourColors)) palette[3][3] = 0;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			int code = (bits >> (i * 2)) & 3;
+			for (int c = 0; c < 4; ++c) block[i * 4 + c] = static_cast<uint8_t>(palette[code][c]);
+		}
+	}
+
+	void TextureCompressor::DecodeBC4(const std::byte* in, int channel, uint8_t* block)
+	{
+		int palette[8];
+		BC4Palette(static_cast<int>(in[0]), static_cast<int>(in[1]), palette);
+		uint64_t bits = ReadLE(in + 2, 6);
+
+		for (int i = 0; i < 16; ++i)
+			block[i * 4 + channel] = static_cast<uint8_t>(palette[(bits >> (i * 3)) & 7]);
+	}
+
+	void TextureCompressor::DecodeBC7(const std::byte* in, uint8_t* block)
+	{
+		BitReader reader{ in };
+		if (reader.Get(7) != (1u << 6))
+		{
+			std::memset(block, 0, 64);
+			return;
+		}
+
+		BC7Endpoint e0, e1;
+		for (int c = 0; c < 4; ++c)
+		{
+			e0.value[c] = static_cast<int>(reader.Get(7));
+			e1.value[c] = static_cast<int>(reader.Get(7));
+		}
+		e0.pbit = static_cast<int>(reader.Get(1));
+		e1.pbit = static_cast<int>(reader.Get(1));
+
+		for (int i = 0; i < 16; ++i)
+		{
+			int weight = BC7Weights[reader.Get(i == 0 ? 3 : 4)];
+			for (int c = 0; c < 4; ++c)
+				block[i * 4 + c] = static_cast<uint8_t>(((64 - weight) * e0.Expanded(c) + weight * e1.Expanded(c) + 32) >> 6);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef TEXTURE_COMPRESSOR_H
+#define TEXTURE_COMPRESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace JLEngine
+{
+	class JobSystem;
+
+	// GPU block formats, every block is 4x4 pixels
+	enum class BlockFormat : uint32_t
+	{
+		BC1,	// RGB, 8 bytes
+		BC3,	// RGBA, a BC4 alpha block then a BC1 colour block, 16 bytes
+		BC4,	// R, 8 bytes
+		BC5,	// RG as two BC4 blocks, 16 bytes
+		BC7		// RGBA, 16 bytes
+	};
+
+	struct CompressedLevel
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint64_t offset = 0;	// from the start of the image's blocks
+		uint64_t size = 0;
+	};
+
+	// A block compressed texture with its mip chain. The blocks are either owned or point into a
+	// TextureCache mapping
+	struct CompressedImage
+	{
+		BlockFormat format = BlockFormat::BC7;
+		bool srgb = false;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<CompressedLevel> levels;
+		std::vector<std::byte> blocks;
+		const std::byte* mapped = nullptr;
+
+		const std::byte* Data() const { return mapped ? mapped : blocks.data(); }
+		const std::byte* LevelData(size_t level) const { return Data() + levels[level].offset; }
+		uint64_t SizeInBytes() const { return levels.empty() ? 0 : levels.back().offset + levels.back().size; }
+	};
+
+	// CPU encoders and decoders for the BC formats. Nothing here touches GL so it runs on the workers
+	// and in the tests. Pixels are always RGBA8, the formats with fewer channels take the first ones.
+	// BC7 is only written in mode 6, one subset with 7 bit RGBA endpoints and 4 bit indices, which
+	// suits the smooth content of material textures and is what the decoder reads back
+	class TextureCompressor
+	{
+	public:
+		static size_t BlockBytes(BlockFormat format);
+		static size_t CompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+		// width * height * 4 bytes in, CompressedSize bytes out. The block rows are spread over the
+		// jobs when there are any, the result is the same either way
+		static void Compress(BlockFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, std::byte* out, JobSystem* jobs = nullptr);
+		// Back to RGBA8 the way GL samples it, missing channels read 0 and alpha 255
+		static void Decompress(BlockFormat format, const std::byte* blocks, uint32_t width, uint32_t height, uint8_t* rgba);
+
+		// --- BLOCKS --- //
+		// 16 RGBA pixels row by row
+		static void EncodeBC1(const uint8_t* block, std::byte* out);
+		static void EncodeBC4(const uint8_t* block, int channel, std::byte* out);
+		static void EncodeBC7(const uint8_t* block, std::byte* out);
+
+		// BC3's colour block always has four colours whatever the endpoint order
+		static void DecodeBC1(const std::byte* in, uint8_t* block, bool fourColors = false);
+		static void DecodeBC4(const std::byte* in, int channel, uint8_t* block);
+		// Mode 6 only, blocks in other modes decode to zero
+		static void DecodeBC7(const std::byte* in, uint8_t* block);
+	};
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include "TextureCooker.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace JLEngine
+{
+	namespace
+	{
+		// Grey is spread over RGB and a missing alpha is opaque, so every format reads the channels
+		// the shaders expect
+		std::vector<uint8_t> ExpandToRGBA(const uint8_t* pixels, size_t pixelCount, int channels)
+		{
+			std::vector<uint8_t> rgba(pixelCount * 4);
+			for (size_t i = 0; i < pixelCount; ++i)
+			{
+				const uint8_t* src = pixels + i * channels;
+				uint8_t* dst = rgba.data() + i * 4;
+				switch (channels)
+				{
+				case 1:
+					dst[0] = dst[1] = dst[2] = src[0];
+					dst[3] = 255;
+					break;
+				case 2:
+					dst[0] = dst[1] = dst[2] = src[0];
+					dst[3] = src[1];
+					break;
+				case 3:
+					dst[0] = src[0];
+					dst[1] = src[1];
+					dst[2] = src[2];
+					dst[3] = 255;
+					break;
+				default:
+					dst[0] = src[0];
+					dst[1] = src[1];
+					dst[2] = src[2];
+					dst[3] = src[3];
+					break;
+				}
+			}
+			return rgba;
+		}
+	}
+
+	BlockFormat TextureCooker::ChooseFormat(TextureUsage usage, bool hasAlpha, const TextureCookSettings& settings)
+	{
+		switch (usage)
+		{
+		case TextureUsage::Normal:
+			return BlockFormat::BC5;
+		case TextureUsage::Occlusion:
+			return BlockFormat::BC4;
+		case TextureUsage::BaseColor:
+			if (settings.highQuality) return BlockFormat::BC7;
+			return hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+		default:
+			// packed metallic roughness and emissive ignore alpha
+			return settings.highQuality ? BlockFormat::BC7 : BlockFormat::BC1;
+		}
+	}
+
+	uint32_t TextureCooker::MipCount(uint32_t width, uint32_t height)
+	{
+		return static_cast<uint32_t>(std::log2(std::max(width, height))) + 1;
+	}
+
+	CompressedImage TextureCooker::Cook(const uint8_t* pixels, uint32_t width, uint32_t height, int channels,
+		TextureUsage usage, const TextureCookSettings& settings, JobSystem* jobs, float alphaCutoff)
+	{
+		CompressedImage image;
+		if (pixels == nullptr || width == 0 || height == 0 || channels < 1 || channels > 4) return image;
+
+		std::vector<uint8_t> rgba = ExpandToRGBA(pixels, static_cast<size_t>(width) * height, channels);
+
+		bool hasAlpha = false;
+		for (size_t i = 3; i < rgba.size() && !hasAlpha; i += 4)
+			hasAlpha = rgba[i] != 255;
+
+		image.format = ChooseFormat(usage, hasAlpha, settings);
+		image.srgb = IsSRGB(usage);
+		image.width = width;
+		image.height = height;
+
+		MipChain chain = MipGenerator::Generate(rgba.data(), width, height, 4, MipSettingsFor(usage, alphaCutoff), jobs);
+
+		uint64_t offset = 0;
+		for (const auto& mip : chain.levels)
+		{
+			CompressedLevel levelInfo;
+			levelInfo.width = mip.width;
+			levelInfo.height = mip.height;
+			levelInfo.offset = offset;
+			levelInfo.size = TextureCompressor::CompressedSize(image.format, levelInfo.width, levelInfo.height);
+			image.levels.push_back(levelInfo);
+			offset += levelInfo.size;
+		}
+
+		image.blocks.resize(static_cast<size_t>(offset));
+		for (size_t mip = 0; mip < chain.levels.size(); ++mip)
+		{
+			const auto& levelInfo = image.levels[mip];
+			TextureCompressor::Compress(image.format, chain.LevelData(mip), levelInfo.width, levelInfo.height, image.blocks.data() + levelInfo.offset, jobs);
+		}
+		return image;
+	}
+
+	MipSettings TextureCooker::MipSettingsFor(TextureUsage usage, float alphaCutoff)
+	{
+		MipSettings settings;
+		settings.srgb = IsSRGB(usage);
+		settings.normalMap = usage == TextureUsage::Normal;
+		settings.alphaCutoff = usage == TextureUsage::BaseColor ? alphaCutoff : -1.0f;
+		return settings;
+	}
+
+	std::vector<uint8_t> TextureCooker::Downsample(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, bool srgb, bool normalMap)
+	{
+		MipSettings settings;
+		settings.filter = MipFilter::Box;
+		settings.srgb = srgb;
+		settings.normalMap = normalMap;
+		return MipGenerator::Downsample(rgba.data(), width, height, 4, settings);
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "TextureCompressor.h"
+#include "MipGenerator.h"
+
+namespace JLEngine
+{
+	class JobSystem;
+
+	// The material slot a texture is cooked for, it decides the format and how the mips are filtered
+	enum class TextureUsage : uint32_t
+	{
+		BaseColor,
+		MetallicRoughness,
+		Normal,
+		Occlusion,
+		Emissive
+	};
+
+	struct TextureCookSettings
+	{
+		// BC7 for colour and packed maps, BC1 or BC3 when off at half the size for opaque maps.
+		// Normals are always BC5 and occlusion BC4
+		bool highQuality = true;
+	};
+
+	// Turns decoded material textures into block compressed mip chains for TextureCache
+	class TextureCooker
+	{
+	public:
+		static BlockFormat ChooseFormat(TextureUsage usage, bool hasAlpha, const TextureCookSettings& settings);
+		// Only base color, the same as the uncompressed upload so the shaders see the same values
+		static bool IsSRGB(TextureUsage usage) { return usage == TextureUsage::BaseColor; }
+		// The full chain down to 1x1, as Graphics::CreateTexture allocates it
+		static uint32_t MipCount(uint32_t width, uint32_t height);
+
+		// 8 bit pixels with 1 to 4 channels. The mips come from MipGenerator, every level is
+		// compressed with its block rows spread over the jobs. alphaCutoff is the MASK cutoff of the
+		// material for base color, its mips then keep their alpha tested coverage
+		static CompressedImage Cook(const uint8_t* pixels, uint32_t width, uint32_t height, int channels,
+			TextureUsage usage, const TextureCookSettings& settings, JobSystem* jobs = nullptr, float alphaCutoff = -1.0f);
+		// How the slot's mips are filtered, the same for cooked and uncompressed textures
+		static MipSettings MipSettingsFor(TextureUsage usage, float alphaCutoff = -1.0f);
+
+		// Half size 2x2 box filter on RGBA8. sRGB levels are averaged in linear light, normal maps
+		// average the decoded vectors and renormalize them
+		static std::vector<uint8_t> Downsample(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, bool srgb, bool normalMap);
+	};
+}
+
+#endif
@@ -7,6 +7,10 @@
 #include "TextureReader.h"
 #include "ImageData.h"
 #include "Graphics.h"
+#include "KTX2File.h"
+#include "TextureStreamer.h"
+
+#include <filesystem>
 
 namespace JLEngine
 {
@@ -19,6 +23,9 @@ namespace JLEngine
         // Create a texture from a file
         std::shared_ptr<Texture> CreateFromFile(const std::string& name, const std::string& filePath, const TexParams& texParams, int outputChannels = 0)
         {
+            if (IsKTX2(filePath))
+                return CreateFromKTX2(name, filePath, texParams);
+
             return m_textureManager->Load(name, [&]() {
                 ImageData imageData;
                 TextureReader::LoadTexture(filePath, imageData, outputChannels);
@@ -38,6 +45,9 @@ namespace JLEngine
 
         std::shared_ptr<Texture> CreateFromFile(const std::string& name, const std::string& filePath)
         {
+            if (IsKTX2(filePath))
+                return CreateFromKTX2(name, filePath, TexParams());
+
             return m_textureManager->Load(name, [&]() {
                 ImageData imageData;
                 TextureReader::LoadTexture(filePath, imageData, 0);
@@ -55,6 +65,71 @@ namespace JLEngine
                 });
         }
 
+        // Create a 2D texture from a KTX2 file, its levels are uploaded from the mapping as they are
+        std::shared_ptr<Texture> CreateFromKTX2(const std::string& name, const std::string& filePath, TexParams texParams)
+        {
+            KTX2File file;
+            if (!m_textureManager->Get(name) && !file.Open(filePath))
+            {
+                std::cerr << "Failed to load texture: " << filePath << std::endl;
+                return nullptr;
+            }
+            return CreateFromKTX2(name, file.GetImage(), texParams);
+        }
+
+        // Create a 2D texture from a KTX2 image in memory or mapped
+        std::shared_ptr<Texture> CreateFromKTX2(const std::string& name, const KTX2Image& image, TexParams texParams)
+        {
+            return m_textureManager->Load(name, [&]() {
+                if (image.IsCubemap() || image.IsArray())
+                {
+                    std::cerr << "Texture " << name << " is not a 2D texture" << std::endl;
+                    return std::shared_ptr<Texture>(nullptr);
+                }
+
+                ImageData data;
+                data.width = static_cast<int>(image.width);
+                data.height = static_cast<int>(image.height);
+                data.channels = static_cast<int>(KTX2File::GetFormatInfo(image.format).channels);
+                data.isHDR = KTX2File::GetFormatInfo(image.format).floatingPoint;
+                texParams.mipmapEnabled = image.levels.size() > 1;
+
+                auto texture = std::make_shared<Texture>(name);
+                texture->InitFromData(data);
+                texture->SetParams(texParams);
+                Graphics::CreateKTX2Texture(texture.get(), image);
+                return texture;
+                });
+        }
+
+        // Create a 2D texture that starts with the low mips of a cache file, the streamer loads the rest
+        // as it is drawn closer
+        std::shared_ptr<Texture> CreateStreamed(const std::string& name, const TextureStreamSource& source, TexParams texParams, TextureStreamer& streamer)
+        {
+            return m_textureManager->Load(name, [&]() {
+                KTX2Image layout;
+                if (!TextureStreamer::ReadLayout(source, layout))
+                {
+                    std::cerr << "Failed to load texture: " << source.path << std::endl;
+                    return std::shared_ptr<Texture>(nullptr);
+                }
+
+                ImageData data;
+                data.width = static_cast<int>(layout.width);
+                data.height = static_cast<int>(layout.height);
+                data.channels = static_cast<int>(KTX2File::GetFormatInfo(layout.format).channels);
+                data.isHDR = KTX2File::GetFormatInfo(layout.format).floatingPoint;
+                texParams.mipmapEnabled = layout.levels.size() > 1;
+
+                auto texture = std::make_shared<Texture>(name);
+                texture->InitFromData(data);
+                texture->SetParams(texParams);
+                if (!streamer.Add(texture, source))
+                    return std::shared_ptr<Texture>(nullptr);
+                return texture;
+                });
+        }
+
         // Create an empty texture
         std::shared_ptr<Texture> CreateEmpty(const std::string& name)
         {
@@ -82,6 +157,32 @@ namespace JLEngine
                 });
         }
 
+        // Create a texture from a cooked mip chain, only the size is kept on the CPU
+        std::shared_ptr<Texture> CreateFromCompressed(const std::string& name, const CompressedImage& image, TexParams texParams = TexParams())
+        {
+            return m_textureManager->Load(name, [&]() {
+                if (image.levels.empty())
+                {
+                    std::cerr << "Invalid compressed image provided for texture: " << name << std::endl;
+                    return std::shared_ptr<Texture>(nullptr);
+                }
+
+                ImageData data;
+                data.width = static_cast<int>(image.width);
+                data.height = static_cast<int>(image.height);
+                data.channels = 4;
+
+                texParams.internalFormat = Graphics::CompressedInternalFormat(image.format, image.srgb);
+                texParams.mipmapEnabled = image.levels.size() > 1;
+
+                auto texture = std::make_shared<Texture>(name);
+                texture->InitFromData(data);
+                texture->SetParams(texParams);
+                Graphics::CreateCompressedTexture(texture.get(), image);
+                return texture;
+                });
+        }
+
         static Texture* Create(
             int width, 
             int height, 
@@ -112,6 +213,11 @@ namespace JLEngine
         }
 
     private:
+        static bool IsKTX2(const std::string& filePath)
+        {
+            return std::filesystem::path(filePath).extension() == ".ktx2";
+        }
+
         ResourceManager<Texture>* m_textureManager;
         GraphicsAPI* m_graphics;
     };
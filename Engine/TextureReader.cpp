@@ -2,10 +2,138 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <iostream>
+#include <cstring>
 #include "TextureReader.h"
+#include "ImageConversion.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
 
 namespace JLEngine
 {
+    namespace
+    {
+        // Per thread rows for conversions that go through more than one kernel
+        thread_local std::vector<uint8_t> s_byteRow;
+        thread_local std::vector<float> s_floatRow;
+
+        // One row from what stb decoded, 8 bit or float, into the requested type. expand is RGB to RGBA
+        void ConvertRow(const void* src, void* dst, size_t width, int channels, bool expand, bool floatSource, PixelType type, bool srgbToLinear)
+        {
+            int dstChannels = expand ? 4 : channels;
+            size_t dstCount = width * dstChannels;
+
+            if (floatSource)
+            {
+                const float* pixels = static_cast<const float*>(src);
+                if (type == PixelType::Float)
+                {
+                    if (expand) ImageConversion::ExpandRGBToRGBA(pixels, static_cast<float*>(dst), width);
+                    else std::memcpy(dst, pixels, dstCount * sizeof(float));
+                    return;
+                }
+                if (expand)
+                {
+                    s_floatRow.resize(dstCount);
+                    ImageConversion::ExpandRGBToRGBA(pixels, s_floatRow.data(), width);
+                    pixels = s_floatRow.data();
+                }
+                ImageConversion::FloatToHalf(pixels, static_cast<uint16_t*>(dst), dstCount);
+                return;
+            }
+
+            const uint8_t* pixels = static_cast<const uint8_t*>(src);
+            if (type == PixelType::UInt8)
+            {
+                if (expand) ImageConversion::ExpandRGBToRGBA(pixels, static_cast<uint8_t*>(dst), width);
+                else std::memcpy(dst, pixels, dstCount);
+                return;
+            }
+            if (expand)
+            {
+                s_byteRow.resize(dstCount);
+                ImageConversion::ExpandRGBToRGBA(pixels, s_byteRow.data(), width);
+                pixels = s_byteRow.data();
+            }
+
+            float* floats = static_cast<float*>(dst);
+            if (type == PixelType::Half)
+            {
+                s_floatRow.resize(dstCount);
+                floats = s_floatRow.data();
+            }
+            if (srgbToLinear) ImageConversion::SRGBToLinear(pixels, floats, width, dstChannels);
+            else ImageConversion::UnormToFloat(pixels, floats, dstCount);
+            if (type == PixelType::Half)
+                ImageConversion::FloatToHalf(floats, static_cast<uint16_t*>(dst), dstCount);
+        }
+
+        // Maps the file, decodes it and converts it into the destination. allocate(request, channels)
+        // runs once the size is known and may point the request at a buffer of its own
+        template <typename Allocate>
+        bool DecodeRequest(ImageLoadRequest& request, Allocate&& allocate)
+        {
+            MappedFile file;
+            if (!file.Open(request.path))
+            {
+                std::cerr << "Failed to load texture: " << request.path << std::endl;
+                return false;
+            }
+
+            auto* bytes = reinterpret_cast<const stbi_uc*>(file.Data());
+            int length = static_cast<int>(file.Size());
+            ImageInfo& info = request.info;
+            if (!stbi_info_from_memory(bytes, length, &info.width, &info.height, &info.channels))
+            {
+                std::cerr << "Failed to load texture: " << request.path << " (" << stbi_failure_reason() << ")" << std::endl;
+                return false;
+            }
+            info.isHDR = stbi_is_hdr_from_memory(bytes, length) != 0;
+
+            // RGB to RGBA is done by the kernels, stb is left with any other change of channels
+            int channels = request.channels > 0 ? request.channels : info.channels;
+            bool expand = info.channels == 3 && channels == 4;
+            int decodeChannels = expand || channels == info.channels ? 0 : channels;
+
+            if (!allocate(request, channels))
+                return false;
+
+            size_t rowBytes = static_cast<size_t>(info.width) * TextureReader::PixelSize(request.type, channels);
+            size_t pitch = request.rowPitch > 0 ? request.rowPitch : rowBytes;
+            if (!request.destination || pitch < rowBytes || request.destinationSize < pitch * (info.height - 1) + rowBytes)
+            {
+                std::cerr << "Destination too small for texture: " << request.path << std::endl;
+                return false;
+            }
+
+            // LoadTexture turns stb's flip on for HDR files and leaves it on, undo it here if it's set
+            bool stbFlips = stbi__vertically_flip_on_load != 0;
+            bool flip = request.flipVertically != stbFlips;
+            bool floatSource = info.isHDR && request.type != PixelType::UInt8;
+
+            int width, height, sourceChannels;
+            void* pixels = floatSource
+                ? static_cast<void*>(stbi_loadf_from_memory(bytes, length, &width, &height, &sourceChannels, decodeChannels))
+                : static_cast<void*>(stbi_load_from_memory(bytes, length, &width, &height, &sourceChannels, decodeChannels));
+            if (!pixels)
+            {
+                std::cerr << "Failed to decode texture: " << request.path << " (" << stbi_failure_reason() << ")" << std::endl;
+                return false;
+            }
+
+            int srcChannels = decodeChannels > 0 ? decodeChannels : sourceChannels;
+            size_t srcRowBytes = static_cast<size_t>(width) * srcChannels * (floatSource ? sizeof(float) : 1);
+            for (int y = 0; y < height; ++y)
+            {
+                const auto* src = static_cast<const uint8_t*>(pixels) + y * srcRowBytes;
+                auto* dst = static_cast<uint8_t*>(request.destination) + (flip ? height - 1 - y : y) * pitch;
+                ConvertRow(src, dst, width, srcChannels, expand, floatSource, request.type, request.srgbToLinear);
+            }
+
+            stbi_image_free(pixels);
+            return true;
+        }
+    }
+
     TextureReader::TextureReader() {}
 
     TextureReader::~TextureReader() {}
@@ -38,80 +166,144 @@ namespace JLEngine
         }
     }
 
-    std::array<ImageData, 6> TextureReader::LoadCubeMapHDR(const std::string& folderPath, const std::array<std::string, 6>& fileNames)
+    bool TextureReader::GetImageInfo(const std::string& filePath, ImageInfo& info)
     {
-        if (fileNames.size() != 6) 
+        if (!stbi_info(filePath.c_str(), &info.width, &info.height, &info.channels))
+            return false;
+        info.isHDR = stbi_is_hdr(filePath.c_str()) != 0;
+        return true;
+    }
+
+    size_t TextureReader::PixelSize(PixelType type, int channels)
+    {
+        size_t componentSize = type == PixelType::Float ? sizeof(float) : type == PixelType::Half ? sizeof(uint16_t) : 1;
+        return componentSize * channels;
+    }
+
+    bool TextureReader::LoadImages(std::vector<ImageLoadRequest>& requests, JobSystem& jobs)
+    {
+        JobCounter counter;
+        for (auto& request : requests)
         {
-            throw std::invalid_argument("Cube map requires exactly 6 textures.");
+            jobs.Submit([&request]() {
+                request.loaded = DecodeRequest(request, [](ImageLoadRequest&, int) { return true; });
+                }, &counter);
         }
+        jobs.Wait(counter);
 
-        auto finalAssetPath = [&](size_t index) { return folderPath + fileNames[index]; };
+        return std::all_of(requests.begin(), requests.end(), [](const ImageLoadRequest& request) { return request.loaded; });
+    }
 
-        std::array<ImageData, 6> cubeFaceData;
+    bool TextureReader::LoadImages(const std::vector<std::string>& filePaths, std::vector<ImageData>& images, JobSystem& jobs,
+        int numCompsDesired, bool flipVertically)
+    {
+        images.resize(filePaths.size());
+        std::vector<ImageLoadRequest> requests(filePaths.size());
 
-        try 
+        JobCounter counter;
+        for (size_t i = 0; i < filePaths.size(); ++i)
         {
-            for (size_t i = 0; i < 6; ++i)
-            {
-                ImageData imgData;      
-                float* stbData = stbi_loadf(finalAssetPath(i).c_str(), &imgData.width, &imgData.height, &imgData.channels, 0);                
-                if (!stbData)
-                {
-                    std::cerr << "Failed to load HDR image: " << finalAssetPath(i) << std::endl;
-                    throw std::runtime_error("Failed to load HDR image: " + finalAssetPath(i));
-                }
-                imgData.isHDR = true;
-                imgData.hdrData.assign(stbData, stbData + (imgData.width * imgData.height * imgData.channels));
-                stbi_image_free(stbData);
-                cubeFaceData[i] = std::move(imgData);
-            }
+            auto& request = requests[i];
+            request.path = filePaths[i];
+            request.channels = numCompsDesired;
+            request.flipVertically = flipVertically;
+
+            jobs.Submit([&request, &image = images[i]]() {
+                request.loaded = DecodeRequest(request, [&image](ImageLoadRequest& request, int channels)
+                    {
+                        image.width = request.info.width;
+                        image.height = request.info.height;
+                        image.channels = channels;
+                        image.isHDR = request.info.isHDR;
+
+                        size_t count = static_cast<size_t>(image.width) * image.height * channels;
+                        request.type = image.isHDR ? PixelType::Float : PixelType::UInt8;
+                        if (image.isHDR)
+                        {
+                            image.hdrData.resize(count);
+                            image.data.clear();
+                            request.destination = image.hdrData.data();
+                        }
+                        else
+                        {
+                            image.data.resize(count);
+                            image.hdrData.clear();
+                            request.destination = image.data.data();
+                        }
+                        request.destinationSize = count * PixelSize(request.type, 1);
+                        return true;
+                    });
+                }, &counter);
+        }
+        jobs.Wait(counter);
+
+        return std::all_of(requests.begin(), requests.end(), [](const ImageLoadRequest& request) { return request.loaded; });
+    }
+
+    std::array<ImageData, 6> TextureReader::LoadCubeMapHDR(const std::string& folderPath, const std::array<std::string, 6>& fileNames)
+    {
+        if (fileNames.size() != 6) 
+        {
+            throw std::invalid_argument("Cube map requires exactly 6 textures.");
         }
-        catch (const std::runtime_error&)
+
+        // the faces decode in parallel, each straight into its own buffer
+        std::vector<std::string> paths;
+        for (const auto& fileName : fileNames)
+            paths.push_back(folderPath + fileName);
+
+        std::vector<ImageData> faces;
+        if (!LoadImages(paths, faces, JobSystem::Global()))
         {
-            throw; // Rethrow the exception
+            throw std::runtime_error("Failed to load HDR cube map: " + folderPath);
         }
 
+        std::array<ImageData, 6> cubeFaceData;
+        for (size_t i = 0; i < 6; ++i)
+            cubeFaceData[i] = std::move(faces[i]);
+
         return cubeFaceData;
     }
 
     float* TextureReader::StitchSky(const std::string& assetPath, std::initializer_list<const char*> fileNames, int width, int height, int channels)
     {
-        int facePixelCount = width * height;
-        auto totalPixelCount = facePixelCount * fileNames.size();
-        float* finalData = new float[totalPixelCount * channels];
+        size_t faceFloats = static_cast<size_t>(width) * height * channels;
+        float* finalData = new float[faceFloats * fileNames.size()];
 
-        int index = 0;
+        // every face decodes on its own job straight into its slice of the result
+        std::vector<ImageLoadRequest> requests;
         for (auto fileName : fileNames)
         {
-            auto finalAssetPath = assetPath + fileName;
-            int tWidth, tHeight, tChannels;
-            float* hdrData = stbi_loadf(finalAssetPath.c_str(), &tWidth, &tHeight, &tChannels, 0);
+            ImageLoadRequest request;
+            request.path = assetPath + fileName;
+            request.destination = finalData + requests.size() * faceFloats;
+            request.destinationSize = faceFloats * sizeof(float);
+            request.type = PixelType::Float;
+            request.channels = channels;
+            requests.push_back(std::move(request));
+        }
 
-            if (!hdrData)
-            {
-                std::cerr << "Failed to load HDR image!" << std::endl;
-                delete[] finalData;
-                return nullptr;
-            }
-            if (width != tWidth || height != tHeight)
+        if (!LoadImages(requests, JobSystem::Global()))
+        {
+            std::cerr << "Failed to load HDR image!" << std::endl;
+            delete[] finalData;
+            return nullptr;
+        }
+
+        for (const auto& request : requests)
+        {
+            if (width != request.info.width || height != request.info.height)
             {
-                std::cerr << "Mismatched dimensions for file: " << finalAssetPath << std::endl;
-                stbi_image_free(hdrData);
+                std::cerr << "Mismatched dimensions for file: " << request.path << std::endl;
                 delete[] finalData;
                 return nullptr;
             }
-            if (tChannels < channels)
+            if (request.info.channels < channels)
             {
-                std::cerr << "Texture has insufficient channels (expected at least 3): " << finalAssetPath << std::endl;
-                stbi_image_free(hdrData);
+                std::cerr << "Texture has insufficient channels (expected at least " << channels << "): " << request.path << std::endl;
                 delete[] finalData;
                 return nullptr;
             }
-
-            std::memcpy(finalData + (index * facePixelCount * 3), hdrData, facePixelCount * channels * sizeof(float));
-            index++;
-
-            stbi_image_free(hdrData);
         }
         return finalData;
     }
@@ -3,12 +3,49 @@
 
 #include <string>
 #include <array>
+#include <vector>
 
 #include "Types.h"
 #include "ImageData.h"
 
 namespace JLEngine
 {
+    class JobSystem;
+
+    // How a batch load stores the decoded pixels
+    enum class PixelType
+    {
+        UInt8,
+        Float,
+        Half
+    };
+
+    struct ImageInfo
+    {
+        int width = 0;
+        int height = 0;
+        int channels = 0;   // as stored in the file
+        bool isHDR = false;
+    };
+
+    // One file of a batch load. The pixels are converted straight into memory the caller owns, so
+    // the faces of a cube map or the maps of a material can share one buffer without a copy each
+    struct ImageLoadRequest
+    {
+        std::string path;
+        void* destination = nullptr;
+        size_t destinationSize = 0;
+        size_t rowPitch = 0;            // bytes from one row to the next, 0 for tightly packed
+        PixelType type = PixelType::UInt8;
+        int channels = 0;               // 0 keeps the file's, RGB to RGBA adds an opaque alpha
+        bool flipVertically = false;
+        bool srgbToLinear = false;      // 8 bit files stored as Float or Half, the alpha stays linear
+
+        // Filled in by the load
+        ImageInfo info;
+        bool loaded = false;
+    };
+
     class TextureReader
     {
     public:
@@ -20,6 +57,17 @@ namespace JLEngine
         static float* StitchSky(const std::string& assetPath, std::initializer_list<const char*> fileNames, int width, int height, int channels);
         static ImageData StitchSky(std::array<JLEngine::ImageData, 6>& files, int width, int height, int channels);
 
+        // Reads the header only, for sizing the buffers of a batch load
+        static bool GetImageInfo(const std::string& filePath, ImageInfo& info);
+        static size_t PixelSize(PixelType type, int channels);
+        // Decodes one file per job, false if any request failed (each one says whether it loaded).
+        // Flipping is done by the conversion, the stb flag LoadTexture sets doesn't apply here
+        static bool LoadImages(std::vector<ImageLoadRequest>& requests, JobSystem& jobs);
+        // HDR files as floats and the rest as 8 bit. The buffers already in the images are reused,
+        // so loading a set of the same size again doesn't allocate
+        static bool LoadImages(const std::vector<std::string>& filePaths, std::vector<ImageData>& images, JobSystem& jobs,
+            int numCompsDesired = 0, bool flipVertically = false);
+
         static void PrintImageData(ImageData& data);
 
     private:
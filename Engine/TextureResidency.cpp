@@ -0,0 +1,236 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace JLEngine
+{
+	TextureResidency::TextureResidency(uint64_t budgetBytes, uint32_t tailSize)
+		: m_budget(budgetBytes), m_tailSize(std::max(tailSize, 1u))
+	{
+	}
+
+	uint32_t TextureResidency::Add(uint32_t width, uint32_t height, const std::vector<uint64_t>& levelBytes)
+	{
+		if (levelBytes.empty()) return InvalidTexture;
+
+		uint32_t id;
+		if (!m_free.empty())
+		{
+			id = m_free.back();
+			m_free.pop_back();
+		}
+		else
+		{
+			id = static_cast<uint32_t>(m_entries.size());
+			m_entries.emplace_back();
+		}
+
+		Entry& entry = m_entries[id];
+		entry = Entry();
+		uint32_t levelCount = static_cast<uint32_t>(levelBytes.size());
+		entry.bytesFrom.assign(levelCount + 1, 0);
+		for (uint32_t mip = levelCount; mip-- > 0;)
+			entry.bytesFrom[mip] = entry.bytesFrom[mip + 1] + levelBytes[mip];
+
+		// the first level small enough, or the last one
+		uint32_t tailMip = 0;
+		while (tailMip + 1 < levelCount && std::max(width >> tailMip, height >> tailMip) > m_tailSize)
+			++tailMip;
+
+		entry.tailMip = tailMip;
+		entry.residentMip = tailMip;
+		entry.loadingMip = tailMip;
+		entry.requestedMip = tailMip;
+		entry.lastUsed = 0;
+		entry.live = true;
+		m_usedBytes += entry.bytesFrom[tailMip];
+		return id;
+	}
+
+	void TextureResidency::Remove(uint32_t texture)
+	{
+		if (texture >= m_entries.size() || !m_entries[texture].live) return;
+
+		Entry& entry = m_entries[texture];
+		m_usedBytes -= Held(entry);
+		entry.live = false;
+		// the id is reused once the load in flight has reported back
+		if (entry.loadingMip == entry.residentMip)
+			m_free.push_back(texture);
+	}
+
+	void TextureResidency::BeginFrame()
+	{
+		++m_frame;
+		for (Entry& entry : m_entries)
+			entry.requestedMip = entry.tailMip;
+	}
+
+	void TextureResidency::Request(uint32_t texture, uint32_t mip)
+	{
+		if (texture >= m_entries.size() || !m_entries[texture].live) return;
+
+		Entry& entry = m_entries[texture];
+		entry.requestedMip = std::min(entry.requestedMip, mip);
+		entry.lastUsed = m_frame;
+	}
+
+	uint32_t TextureResidency::GetRequestedMip(uint32_t texture) const
+	{
+		const Entry& entry = m_entries[texture];
+		return entry.lastUsed == m_frame ? entry.requestedMip : entry.tailMip;
+	}
+
+	void TextureResidency::Update(std::vector<ResidencyChange>& loads, std::vector<ResidencyChange>& evictions, uint32_t maxLoads)
+	{
+		loads.clear();
+		evictions.clear();
+
+		// a lowered budget gives back what's over before anything new comes in
+		if (m_usedBytes > m_budget)
+			Evict(m_usedBytes - m_budget, evictions);
+
+		std::vector<uint32_t> candidates;
+		for (uint32_t id = 0; id < m_entries.size(); ++id)
+		{
+			const Entry& entry = m_entries[id];
+			if (entry.live && !entry.failed && entry.lastUsed == m_frame &&
+				entry.loadingMip == entry.residentMip && entry.requestedMip < entry.residentMip)
+				candidates.push_back(id);
+		}
+
+		// the textures furthest from what they need go first
+		std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+			{
+				uint32_t missingA = m_entries[a].residentMip - m_entries[a].requestedMip;
+				uint32_t missingB = m_entries[b].residentMip - m_entries[b].requestedMip;
+				return missingA != missingB ? missingA > missingB : a < b;
+			});
+
+		for (uint32_t id : candidates)
+		{
+			if (loads.size() >= maxLoads) break;
+
+			Entry& entry = m_entries[id];
+			uint64_t needed = entry.bytesFrom[entry.requestedMip] - entry.bytesFrom[entry.residentMip];
+			if (m_usedBytes + needed > m_budget)
+				Evict(m_usedBytes + needed - m_budget, evictions);
+
+			// whatever fits of it when the rest of the budget is in use this frame
+			uint32_t target = entry.requestedMip;
+			while (target < entry.residentMip && m_usedBytes + entry.bytesFrom[target] - entry.bytesFrom[entry.residentMip] > m_budget)
+				++target;
+			if (target == entry.residentMip) continue;
+
+			m_usedBytes += entry.bytesFrom[target] - entry.bytesFrom[entry.residentMip];
+			entry.loadingMip = target;
+			loads.push_back({ id, entry.residentMip, target });
+		}
+	}
+
+	void TextureResidency::CompleteLoad(uint32_t texture, bool succeeded)
+	{
+		if (texture >= m_entries.size()) return;
+
+		Entry& entry = m_entries[texture];
+		if (entry.loadingMip == entry.residentMip) return;
+
+		if (!entry.live)
+		{
+			// removed while loading, its bytes already went with it
+			entry.loadingMip = entry.residentMip;
+			m_free.push_back(texture);
+			return;
+		}
+
+		if (succeeded)
+		{
+			entry.residentMip = entry.loadingMip;
+		}
+		else
+		{
+			m_usedBytes -= entry.bytesFrom[entry.loadingMip] - entry.bytesFrom[entry.residentMip];
+			entry.loadingMip = entry.residentMip;
+			entry.failed = true;
+		}
+	}
+
+	void TextureResidency::Evict(uint64_t bytes, std::vector<ResidencyChange>& evictions)
+	{
+		std::vector<uint32_t> unused, surplus;
+		for (uint32_t id = 0; id < m_entries.size(); ++id)
+		{
+			const Entry& entry = m_entries[id];
+			if (!entry.live || entry.loadingMip != entry.residentMip) continue;
+
+			if (entry.lastUsed != m_frame && entry.residentMip < entry.tailMip)
+				unused.push_back(id);
+			else if (entry.lastUsed == m_frame && entry.residentMip < entry.requestedMip)
+				surplus.push_back(id);
+		}
+
+		std::sort(unused.begin(), unused.end(), [this](uint32_t a, uint32_t b)
+			{
+				return m_entries[a].lastUsed != m_entries[b].lastUsed ? m_entries[a].lastUsed < m_entries[b].lastUsed : a < b;
+			});
+		std::sort(surplus.begin(), surplus.end(), [this](uint32_t a, uint32_t b)
+			{
+				uint64_t extraA = Held(m_entries[a]) - m_entries[a].bytesFrom[m_entries[a].requestedMip];
+				uint64_t extraB = Held(m_entries[b]) - m_entries[b].bytesFrom[m_entries[b].requestedMip];
+				return extraA != extraB ? extraA > extraB : a < b;
+			});
+
+		uint64_t freed = 0;
+		auto drop = [&](uint32_t id, uint32_t mip)
+			{
+				Entry& entry = m_entries[id];
+				freed += entry.bytesFrom[entry.residentMip] - entry.bytesFrom[mip];
+				evictions.push_back({ id, entry.residentMip, mip });
+				SetResident(entry, mip);
+			};
+
+		for (uint32_t id : unused)
+		{
+			if (freed >= bytes) return;
+			drop(id, m_entries[id].tailMip);
+		}
+		for (uint32_t id : surplus)
+		{
+			if (freed >= bytes) return;
+			drop(id, m_entries[id].requestedMip);
+		}
+	}
+
+	void TextureResidency::SetResident(Entry& entry, uint32_t mip)
+	{
+		m_usedBytes -= Held(entry);
+		entry.residentMip = mip;
+		entry.loadingMip = mip;
+		m_usedBytes += Held(entry);
+	}
+
+	uint64_t TextureResidency::Held(const Entry& entry) const
+	{
+		return entry.bytesFrom[std::min(entry.residentMip, entry.loadingMip)];
+	}
+
+	uint32_t TextureResidency::RequiredMip(uint32_t width, uint32_t height, uint32_t levelCount, float screenPixels)
+	{
+		if (levelCount == 0) return 0;
+		float size = static_cast<float>(std::max(width, height));
+		if (!(screenPixels > 0.0f)) return levelCount - 1;
+		if (screenPixels >= size) return 0;
+
+		uint32_t mip = static_cast<uint32_t>(std::floor(std::log2(size / screenPixels)));
+		return std::min(mip, levelCount - 1);
+	}
+
+	float TextureResidency::ScreenSize(float radius, float distance, float fovY, float viewportHeight)
+	{
+		// inside the sphere it's as close as it gets
+		distance = std::max(distance, radius);
+		if (!(distance > 0.0f)) return viewportHeight;
+		return radius * viewportHeight / (distance * std::tan(fovY * 0.5f));
+	}
+}
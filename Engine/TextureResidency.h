@@ -0,0 +1,95 @@
+#ifndef TEXTURE_RESIDENCY_H
+#define TEXTURE_RESIDENCY_H
+
+#include <cstdint>
+#include <vector>
+
+namespace JLEngine
+{
+	// A texture going from fromMip to toMip, both the finest level resident. Loads go to a lower mip
+	struct ResidencyChange
+	{
+		uint32_t texture = 0;
+		uint32_t fromMip = 0;
+		uint32_t toMip = 0;
+	};
+
+	// Decides which mips of the streamed textures are in memory, without touching GL or files so
+	// it can be tested on its own. Every texture keeps its small levels (the tail) and the finer
+	// ones come and go: each frame the renderer asks for the mip a texture needs, Update starts
+	// loads for the ones short of it, biggest shortfall first, and when a load would go over the
+	// budget evicts the textures nobody asked for in the longest time
+	class TextureResidency
+	{
+	public:
+		static constexpr uint32_t InvalidTexture = UINT32_MAX;
+
+		// The tail is the levels no bigger than tailSize on their longest side
+		explicit TextureResidency(uint64_t budgetBytes = 512ull << 20, uint32_t tailSize = 64);
+
+		// levelBytes from mip 0 down, the texture starts with its tail resident
+		uint32_t Add(uint32_t width, uint32_t height, const std::vector<uint64_t>& levelBytes);
+		void Remove(uint32_t texture);
+
+		// Lowering it evicts on the next Update
+		void SetBudget(uint64_t bytes) { m_budget = bytes; }
+		uint64_t GetBudget() const { return m_budget; }
+		// Resident levels of every texture plus the loads in flight
+		uint64_t GetUsedBytes() const { return m_usedBytes; }
+
+		// Starts a frame, textures not asked for from here on count as unused
+		void BeginFrame();
+		// The finest of this frame's requests is kept
+		void Request(uint32_t texture, uint32_t mip);
+
+		// The loads to start and the evictions to apply now. A load's bytes count against the budget
+		// until CompleteLoad, a texture with a load in flight is neither loaded again nor evicted
+		void Update(std::vector<ResidencyChange>& loads, std::vector<ResidencyChange>& evictions, uint32_t maxLoads = 4);
+		// A failed texture stays as it is and isn't loaded again
+		void CompleteLoad(uint32_t texture, bool succeeded);
+
+		uint32_t GetResidentMip(uint32_t texture) const { return m_entries[texture].residentMip; }
+		uint32_t GetTailMip(uint32_t texture) const { return m_entries[texture].tailMip; }
+		// This frame's request, the tail mip when there was none
+		uint32_t GetRequestedMip(uint32_t texture) const;
+		bool IsLoading(uint32_t texture) const { return m_entries[texture].loadingMip != m_entries[texture].residentMip; }
+		// Size of the levels from mip down
+		uint64_t LevelBytes(uint32_t texture, uint32_t mip) const { return m_entries[texture].bytesFrom[mip]; }
+		size_t GetCount() const { return m_entries.size() - m_free.size(); }
+
+		// The mip whose texels are about pixel sized when the texture is drawn screenPixels across,
+		// as if it covered the surface once
+		static uint32_t RequiredMip(uint32_t width, uint32_t height, uint32_t levelCount, float screenPixels);
+		// Projected diameter in pixels of a sphere distance away, fovY in radians
+		static float ScreenSize(float radius, float distance, float fovY, float viewportHeight);
+
+	private:
+		struct Entry
+		{
+			// bytesFrom[mip] is the size of mip and every level below it, one past the last level is 0
+			std::vector<uint64_t> bytesFrom;
+			uint32_t tailMip = 0;
+			uint32_t residentMip = 0;
+			uint32_t loadingMip = 0;
+			uint32_t requestedMip = 0;
+			uint64_t lastUsed = 0;
+			bool live = false;
+			bool failed = false;
+		};
+
+		// LRU eviction until bytes are freed or nothing else can go. Textures unused this frame drop
+		// to their tail first, oldest first, then the ones holding finer mips than this frame needs
+		void Evict(uint64_t bytes, std::vector<ResidencyChange>& evictions);
+		void SetResident(Entry& entry, uint32_t mip);
+		uint64_t Held(const Entry& entry) const;
+
+		std::vector<Entry> m_entries;
+		std::vector<uint32_t> m_free;
+		uint64_t m_budget;
+		uint64_t m_usedBytes = 0;
+		uint64_t m_frame = 1;
+		uint32_t m_tailSize;
+	};
+}
+
+#endif
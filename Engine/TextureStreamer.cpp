@@ -0,0 +1,265 @@
+#include "TextureStreamer.h"
+
+#include "Graphics.h"
+#include "Texture.h"
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace JLEngine
+{
+	namespace
+	{
+		KTX2Format ToKTX2Format(BlockFormat format, bool srgb)
+		{
+			switch (format)
+			{
+			case BlockFormat::BC1: return srgb ? KTX2Format::BC1_RGB_SRGB : KTX2Format::BC1_RGB_UNORM;
+			case BlockFormat::BC3: return srgb ? KTX2Format::BC3_SRGB : KTX2Format::BC3_UNORM;
+			case BlockFormat::BC4: return KTX2Format::BC4_UNORM;
+			case BlockFormat::BC5: return KTX2Format::BC5_UNORM;
+			case BlockFormat::BC7: return srgb ? KTX2Format::BC7_SRGB : KTX2Format::BC7_UNORM;
+			}
+			return KTX2Format::Undefined;
+		}
+
+		// Either kind of source mapped, layout has no pixels of its own and its offsets are from data
+		struct SourceFile
+		{
+			KTX2File ktx2;
+			TextureCache cache;
+			KTX2Image layout;
+			const std::byte* data = nullptr;
+
+			bool Open(const TextureStreamSource& source)
+			{
+				if (std::filesystem::path(source.path).extension() == ".ktx2")
+				{
+					if (!ktx2.Open(source.path)) return false;
+					const KTX2Image& image = ktx2.GetImage();
+					if (image.IsCubemap() || image.IsArray()) return false;
+
+					layout.format = image.format;
+					layout.width = image.width;
+					layout.height = image.height;
+					layout.levels = image.levels;
+					data = image.Data();
+				}
+				else
+				{
+					if (!cache.Open(source.path, source.cacheHash)) return false;
+					const CompressedImage& image = cache.GetImage();
+
+					layout.format = ToKTX2Format(image.format, image.srgb);
+					layout.width = image.width;
+					layout.height = image.height;
+					layout.levels.clear();
+					for (const auto& level : image.levels)
+						layout.levels.push_back({ level.offset, level.size });
+					data = image.Data();
+				}
+				return !layout.levels.empty() && layout.format != KTX2Format::Undefined;
+			}
+
+			bool Read(uint32_t firstMip, uint32_t endMip, KTX2Image& out) const
+			{
+				if (firstMip > endMip || endMip > layout.levels.size()) return false;
+
+				out.Allocate(layout.format, layout.LevelWidth(firstMip), layout.LevelHeight(firstMip), endMip - firstMip);
+				for (uint32_t mip = firstMip; mip < endMip; ++mip)
+				{
+					const KTX2Level& level = layout.levels[mip];
+					if (out.levels[mip - firstMip].size != level.size) return false;
+					// the copy is what pages the level in from disk
+					std::memcpy(out.data.data() + out.levels[mip - firstMip].offset, data + level.offset, static_cast<size_t>(level.size));
+				}
+				return true;
+			}
+		};
+	}
+
+	TextureStreamer::TextureStreamer(JobSystem& jobs)
+		: m_jobs(jobs)
+	{
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		m_jobs.Wait(m_inFlight);
+		if (Graphics::Alive())
+		{
+			for (const auto& retired : m_retired)
+				Graphics::ReleaseTexture(retired.textureId, retired.bindlessHandle);
+		}
+	}
+
+	bool TextureStreamer::ReadLayout(const TextureStreamSource& source, KTX2Image& layout)
+	{
+		SourceFile file;
+		if (!file.Open(source)) return false;
+		layout = file.layout;
+		return true;
+	}
+
+	bool TextureStreamer::ReadLevels(const TextureStreamSource& source, uint32_t firstMip, uint32_t endMip, KTX2Image& out)
+	{
+		SourceFile file;
+		return file.Open(source) && file.Read(firstMip, endMip, out);
+	}
+
+	bool TextureStreamer::Add(const std::shared_ptr<Texture>& texture, const TextureStreamSource& source)
+	{
+		if (texture == nullptr || m_ids.count(texture.get())) return false;
+
+		SourceFile file;
+		if (!file.Open(source))
+		{
+			std::cerr << "TextureStreamer: could not read " << source.path << std::endl;
+			return false;
+		}
+
+		std::vector<uint64_t> levelBytes;
+		for (const auto& level : file.layout.levels)
+			levelBytes.push_back(level.size);
+		uint32_t id = m_residency.Add(file.layout.width, file.layout.height, levelBytes);
+		if (id >= m_entries.size())
+			m_entries.resize(id + 1);
+
+		Entry& entry = m_entries[id];
+		entry.texture = texture;
+		entry.key = texture.get();
+		entry.source = source;
+		entry.layout = file.layout;
+
+		uint32_t levelCount = static_cast<uint32_t>(file.layout.levels.size());
+		uint32_t tailMip = m_residency.GetTailMip(id);
+		KTX2Image tail;
+		if (!file.Read(tailMip, levelCount, tail) || !Resize(texture.get(), entry, tail, levelCount, tailMip))
+		{
+			Forget(id);
+			return false;
+		}
+
+		m_ids[texture.get()] = id;
+		return true;
+	}
+
+	bool TextureStreamer::IsStreamed(const Texture* texture) const
+	{
+		return m_ids.count(texture) > 0;
+	}
+
+	void TextureStreamer::BeginFrame()
+	{
+		++m_frame;
+		m_residency.BeginFrame();
+	}
+
+	void TextureStreamer::Request(const Texture* texture, float screenPixels)
+	{
+		auto it = m_ids.find(texture);
+		if (it == m_ids.end()) return;
+
+		const KTX2Image& layout = m_entries[it->second].layout;
+		uint32_t levelCount = static_cast<uint32_t>(layout.levels.size());
+		m_residency.Request(it->second, TextureResidency::RequiredMip(layout.width, layout.height, levelCount, screenPixels));
+	}
+
+	void TextureStreamer::Update()
+	{
+		m_changed.clear();
+
+		while (!m_retired.empty() && m_retired.front().frame + RetireFrames <= m_frame)
+		{
+			Graphics::ReleaseTexture(m_retired.front().textureId, m_retired.front().bindlessHandle);
+			m_retired.pop_front();
+		}
+
+		// textures their owners let go of
+		for (uint32_t id = 0; id < m_entries.size(); ++id)
+		{
+			if (m_entries[id].key != nullptr && m_entries[id].texture.expired())
+				Forget(id);
+		}
+
+		// --- FINISHED LOADS ---
+		for (auto& load : m_loads)
+		{
+			if (!load->done.load(std::memory_order_acquire)) continue;
+
+			auto texture = m_entries[load->id].texture.lock();
+			bool swapped = load->succeeded && texture != nullptr &&
+				Resize(texture.get(), m_entries[load->id], load->levels, load->fromMip, load->toMip);
+			if (load->succeeded && texture != nullptr && !swapped)
+				std::cerr << "TextureStreamer: could not load mip " << load->toMip << " of " << texture->GetName() << std::endl;
+
+			m_residency.CompleteLoad(load->id, swapped);
+			if (swapped)
+				m_changed.push_back(texture.get());
+			load = nullptr;
+		}
+		m_loads.erase(std::remove(m_loads.begin(), m_loads.end(), nullptr), m_loads.end());
+
+		// --- NEW LOADS AND EVICTIONS ---
+		m_residency.Update(m_newLoads, m_evictions, MaxLoadsPerFrame);
+
+		for (const auto& eviction : m_evictions)
+		{
+			const Entry& entry = m_entries[eviction.texture];
+			auto texture = entry.texture.lock();
+			if (texture == nullptr) continue;
+
+			// no levels to upload, everything left is copied from the current storage
+			KTX2Image upload;
+			upload.format = entry.layout.format;
+			upload.width = entry.layout.LevelWidth(eviction.toMip);
+			upload.height = entry.layout.LevelHeight(eviction.toMip);
+			if (Resize(texture.get(), entry, upload, eviction.fromMip, eviction.toMip))
+				m_changed.push_back(texture.get());
+		}
+
+		for (const auto& change : m_newLoads)
+		{
+			auto load = std::make_shared<Load>();
+			load->id = change.texture;
+			load->fromMip = change.fromMip;
+			load->toMip = change.toMip;
+			m_loads.push_back(load);
+
+			TextureStreamSource source = m_entries[change.texture].source;
+			m_jobs.SubmitBackground([load, source]()
+				{
+					load->succeeded = ReadLevels(source, load->toMip, load->fromMip, load->levels);
+					load->done.store(true, std::memory_order_release);
+				}, &m_inFlight);
+		}
+	}
+
+	bool TextureStreamer::Resize(Texture* texture, const Entry& entry, const KTX2Image& upload, uint32_t fromMip, uint32_t toMip)
+	{
+		uint32_t levelCount = static_cast<uint32_t>(entry.layout.levels.size()) - toMip;
+		uint32_t oldId = texture->GetGPUID();
+		uint64_t oldHandle = texture->Bindless();
+		if (!Graphics::ReplaceTextureMips(texture, upload, levelCount, toMip, fromMip))
+			return false;
+
+		// frames already submitted may still sample through the old handle
+		if (oldId != 0)
+			m_retired.push_back({ oldId, oldHandle, m_frame });
+		return true;
+	}
+
+	void TextureStreamer::Forget(uint32_t id)
+	{
+		Entry& entry = m_entries[id];
+		auto it = m_ids.find(entry.key);
+		if (it != m_ids.end() && it->second == id)
+			m_ids.erase(it);
+
+		m_residency.Remove(id);
+		entry = Entry();
+	}
+}
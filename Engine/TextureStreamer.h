@@ -0,0 +1,116 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "JobSystem.h"
+#include "KTX2File.h"
+#include "TextureResidency.h"
+
+namespace JLEngine
+{
+	class Texture;
+
+	// Where a streamed texture's levels are read from, a KTX2 file or a cooked TextureCache file
+	struct TextureStreamSource
+	{
+		std::string path;
+		uint64_t cacheHash = 0;		// what the TextureCache file has to match, unused for KTX2
+	};
+
+	// Keeps the textures that have a file on disk at the mips they are drawn at. A texture starts
+	// with its small levels, the renderer asks each frame for the mip every drawn texture needs and
+	// TextureResidency picks the loads and evictions that keep the total under the budget. The
+	// levels are read by background jobs, Update then gives the texture new storage with them, the
+	// levels it already had copied over on the GPU. That changes the bindless handle, so whatever
+	// holds one (the material buffer) has to be patched from GetChangedTextures. Render thread only
+	class TextureStreamer
+	{
+	public:
+		explicit TextureStreamer(JobSystem& jobs);
+		// Waits for the loads in flight and releases the textures waiting to be
+		~TextureStreamer();
+
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		// The format, size and level sizes of a source, without its pixels
+		static bool ReadLayout(const TextureStreamSource& source, KTX2Image& layout);
+		// Levels firstMip up to endMip of a source, the image sized from firstMip
+		static bool ReadLevels(const TextureStreamSource& source, uint32_t firstMip, uint32_t endMip, KTX2Image& out);
+
+		// Creates the texture's storage from the tail of the source's chain and tracks it from then on,
+		// the texture's params should be set. False when the source can't be read
+		bool Add(const std::shared_ptr<Texture>& texture, const TextureStreamSource& source);
+		bool IsStreamed(const Texture* texture) const;
+
+		// Once a frame before the Requests
+		void BeginFrame();
+		// The texture is drawn about screenPixels across this frame
+		void Request(const Texture* texture, float screenPixels);
+		// Swaps in the loads that finished, applies evictions and starts the next loads
+		void Update();
+		// Textures whose GL object and bindless handle the last Update replaced
+		const std::vector<Texture*>& GetChangedTextures() const { return m_changed; }
+
+		void SetBudget(uint64_t bytes) { m_residency.SetBudget(bytes); }
+		const TextureResidency& GetResidency() const { return m_residency; }
+
+		// Textures added from now on are streamed, the ones already in keep streaming
+		bool Enabled = true;
+		uint32_t MaxLoadsPerFrame = 4;
+		// Frames a replaced texture is kept for the GPU to finish with, as many as the frame ring holds
+		uint32_t RetireFrames = 3;
+
+	private:
+		struct Entry
+		{
+			std::weak_ptr<Texture> texture;
+			const Texture* key = nullptr;		// what m_ids has it under, null for a free entry
+			TextureStreamSource source;
+			KTX2Image layout;
+		};
+
+		struct Load
+		{
+			uint32_t id = 0;
+			uint32_t fromMip = 0;
+			uint32_t toMip = 0;
+			KTX2Image levels;
+			std::atomic<bool> done{ false };
+			bool succeeded = false;
+		};
+
+		struct Retired
+		{
+			uint32_t textureId = 0;
+			uint64_t bindlessHandle = 0;
+			uint64_t frame = 0;
+		};
+
+		// Storage from toMip down, upload the levels the old storage doesn't have
+		bool Resize(Texture* texture, const Entry& entry, const KTX2Image& upload, uint32_t fromMip, uint32_t toMip);
+		void Forget(uint32_t id);
+
+		JobSystem& m_jobs;
+		TextureResidency m_residency;
+		// by residency id
+		std::vector<Entry> m_entries;
+		std::unordered_map<const Texture*, uint32_t> m_ids;
+		std::vector<std::shared_ptr<Load>> m_loads;
+		std::deque<Retired> m_retired;
+		std::vector<Texture*> m_changed;
+		std::vector<ResidencyChange> m_newLoads;
+		std::vector<ResidencyChange> m_evictions;
+		uint64_t m_frame = 0;
+		JobCounter m_inFlight;
+	};
+}
+
+#endif
@@ -0,0 +1,282 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <glm/gtx/quaternion.hpp>
+
+namespace JLEngine
+{
+    TransformHierarchy& TransformHierarchy::Global()
+    {
+        static TransformHierarchy hierarchy;
+        return hierarchy;
+    }
+
+    TransformHandle TransformHierarchy::Create()
+    {
+        TransformHandle handle;
+        if (!m_freeHandles.empty())
+        {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+        }
+        else
+        {
+            handle = static_cast<TransformHandle>(m_handleToIndex.size());
+            m_handleToIndex.push_back(0);
+        }
+
+        // New transforms have no parent so appending keeps the parent-before-child ordering
+        m_handleToIndex[handle] = static_cast<uint32_t>(m_parents.size());
+        m_translations.emplace_back(0.0f);
+        m_rotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+        m_scales.emplace_back(1.0f);
+        m_parents.push_back(NoParent);
+        m_world.emplace_back(1.0f);
+        m_dirty.push_back(0);
+        m_alive.push_back(1);
+        m_indexToHandle.push_back(handle);
+
+        return handle;
+    }
+
+    void TransformHierarchy::Destroy(TransformHandle handle)
+    {
+        if (handle >= m_handleToIndex.size()) return;
+
+        // The slot is compacted away on the next sort, which also detaches any surviving children.
+        // The handle can't be reused before then or those children would be adopted by the new owner.
+        m_alive[m_handleToIndex[handle]] = 0;
+        m_pendingFree.push_back(handle);
+        m_needsSort = true;
+    }
+
+    void TransformHierarchy::SetParent(TransformHandle child, TransformHandle parent)
+    {
+        uint32_t childIndex = m_handleToIndex[child];
+
+        if (parent == InvalidTransformHandle)
+        {
+            m_parents[childIndex] = NoParent;
+        }
+        else
+        {
+            uint32_t parentIndex = m_handleToIndex[parent];
+            m_parents[childIndex] = static_cast<int32_t>(parentIndex);
+
+            // Re-parenting under a transform that comes later in the arrays breaks the ordering
+            if (parentIndex > childIndex)
+            {
+                m_needsSort = true;
+            }
+        }
+
+        MarkDirtyIndex(childIndex);
+    }
+
+    TransformHandle TransformHierarchy::GetParent(TransformHandle handle) const
+    {
+        int32_t parentIndex = m_parents[m_handleToIndex[handle]];
+        return parentIndex == NoParent ? InvalidTransformHandle : m_indexToHandle[parentIndex];
+    }
+
+    void TransformHierarchy::SetTranslation(TransformHandle handle, const glm::vec3& translation)
+    {
+        uint32_t index = m_handleToIndex[handle];
+        m_translations[index] = translation;
+        MarkDirtyIndex(index);
+    }
+
+    void TransformHierarchy::SetRotation(TransformHandle handle, const glm::quat& rotation)
+    {
+        uint32_t index = m_handleToIndex[handle];
+        m_rotations[index] = rotation;
+        MarkDirtyIndex(index);
+    }
+
+    void TransformHierarchy::SetScale(TransformHandle handle, const glm::vec3& scale)
+    {
+        uint32_t index = m_handleToIndex[handle];
+        m_scales[index] = scale;
+        MarkDirtyIndex(index);
+    }
+
+    void TransformHierarchy::SetTRS(TransformHandle handle, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+    {
+        uint32_t index = m_handleToIndex[handle];
+        m_translations[index] = translation;
+        m_rotations[index] = rotation;
+        m_scales[index] = scale;
+        MarkDirtyIndex(index);
+    }
+
+    glm::mat4 TransformHierarchy::GetLocalTransform(TransformHandle handle) const
+    {
+        return ComposeLocal(m_handleToIndex[handle]);
+    }
+
+    glm::mat4 TransformHierarchy::ComposeLocal(uint32_t index) const
+    {
+        // Equivalent to translate * rotate * scale without the two extra matrix multiplies
+        glm::mat4 local = glm::toMat4(m_rotations[index]);
+        local[0] *= m_scales[index].x;
+        local[1] *= m_scales[index].y;
+        local[2] *= m_scales[index].z;
+        local[3] = glm::vec4(m_translations[index], 1.0f);
+        return local;
+    }
+
+    const glm::mat4& TransformHierarchy::GetWorldTransform(TransformHandle handle)
+    {
+        if (HasPendingUpdates())
+        {
+            Update();
+        }
+        return m_world[m_handleToIndex[handle]];
+    }
+
+    void TransformHierarchy::MarkDirty(TransformHandle handle)
+    {
+        MarkDirtyIndex(m_handleToIndex[handle]);
+    }
+
+    void TransformHierarchy::MarkDirtyIndex(uint32_t index)
+    {
+        m_dirty[index] = 1;
+        m_firstDirty = std::min(m_firstDirty, index);
+    }
+
+    void TransformHierarchy::Update()
+    {
+        if (m_needsSort)
+        {
+            SortHierarchy();
+        }
+
+        if (m_firstDirty == NoDirty) return;
+
+        // Parents always precede their children, so a dirty flag only ever has to look one step back
+        const uint32_t count = static_cast<uint32_t>(m_parents.size());
+        for (uint32_t i = m_firstDirty; i < count; ++i)
+        {
+            const int32_t parent = m_parents[i];
+            if (parent != NoParent && m_dirty[parent])
+            {
+                m_dirty[i] = 1;
+            }
+
+            if (!m_dirty[i]) continue;
+
+            glm::mat4 local = ComposeLocal(i);
+            m_world[i] = parent != NoParent ? m_world[parent] * local : local;
+        }
+
+        std::fill(m_dirty.begin() + m_firstDirty, m_dirty.end(), static_cast<uint8_t>(0));
+        m_firstDirty = NoDirty;
+    }
+
+    void TransformHierarchy::SortHierarchy()
+    {
+        const uint32_t count = static_cast<uint32_t>(m_parents.size());
+
+        // --- Gather children per parent (CSR layout), orphaning children of destroyed transforms ---
+        std::vector<uint32_t> childOffsets(count + 1, 0);
+        std::vector<uint32_t> order;
+        order.reserve(count);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (!m_alive[i]) continue;
+
+            int32_t parent = m_parents[i];
+            if (parent != NoParent && !m_alive[parent])
+            {
+                m_parents[i] = parent = NoParent;
+                m_dirty[i] = 1;
+            }
+
+            if (parent == NoParent)
+            {
+                order.push_back(i);
+            }
+            else
+            {
+                childOffsets[parent + 1]++;
+            }
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            childOffsets[i + 1] += childOffsets[i];
+        }
+
+        std::vector<uint32_t> children(childOffsets[count]);
+        std::vector<uint32_t> cursor(childOffsets.begin(), childOffsets.end() - 1);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (m_alive[i] && m_parents[i] != NoParent)
+            {
+                children[cursor[m_parents[i]]++] = i;
+            }
+        }
+
+        // --- Breadth first from the roots gives a parent-before-child order ---
+        for (size_t k = 0; k < order.size(); ++k)
+        {
+            uint32_t index = order[k];
+            for (uint32_t c = childOffsets[index]; c < childOffsets[index + 1]; ++c)
+            {
+                order.push_back(children[c]);
+            }
+        }
+
+        // --- Permute the arrays into the new order ---
+        const uint32_t newCount = static_cast<uint32_t>(order.size());
+        std::vector<int32_t> oldToNew(count, NoParent);
+        for (uint32_t i = 0; i < newCount; ++i)
+        {
+            oldToNew[order[i]] = static_cast<int32_t>(i);
+        }
+
+        std::vector<glm::vec3> translations(newCount);
+        std::vector<glm::quat> rotations(newCount);
+        std::vector<glm::vec3> scales(newCount);
+        std::vector<int32_t> parents(newCount);
+        std::vector<glm::mat4> world(newCount);
+        std::vector<uint8_t> dirty(newCount);
+        std::vector<TransformHandle> indexToHandle(newCount);
+
+        m_firstDirty = NoDirty;
+        for (uint32_t i = 0; i < newCount; ++i)
+        {
+            uint32_t old = order[i];
+            translations[i] = m_translations[old];
+            rotations[i] = m_rotations[old];
+            scales[i] = m_scales[old];
+            parents[i] = m_parents[old] == NoParent ? NoParent : oldToNew[m_parents[old]];
+            world[i] = m_world[old];
+            dirty[i] = m_dirty[old];
+            indexToHandle[i] = m_indexToHandle[old];
+            m_handleToIndex[indexToHandle[i]] = i;
+
+            if (dirty[i] && m_firstDirty == NoDirty)
+            {
+                m_firstDirty = i;
+            }
+        }
+
+        m_translations = std::move(translations);
+        m_rotations = std::move(rotations);
+        m_scales = std::move(scales);
+        m_parents = std::move(parents);
+        m_world = std::move(world);
+        m_dirty = std::move(dirty);
+        m_indexToHandle = std::move(indexToHandle);
+        m_alive.assign(newCount, 1);
+
+        // Dead slots are gone, their handles are safe to hand out again
+        m_freeHandles.insert(m_freeHandles.end(), m_pendingFree.begin(), m_pendingFree.end());
+        m_pendingFree.clear();
+
+        m_needsSort = false;
+    }
+}
\ No newline at end of file
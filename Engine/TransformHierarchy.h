@@ -0,0 +1,88 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace JLEngine
+{
+    using TransformHandle = uint32_t;
+    constexpr TransformHandle InvalidTransformHandle = UINT32_MAX;
+
+    // Flat, data oriented storage for the scene graph transforms.
+    // Every Node owns a handle into this structure; local TRS, parent links and world matrices
+    // live in parallel arrays that are kept sorted parent-before-child, so resolving the whole
+    // hierarchy is a single linear pass over the dirty range instead of a recursive walk.
+    // Handles are stable, dense indices are not (they change when the arrays are re-sorted).
+    class TransformHierarchy
+    {
+    public:
+        TransformHierarchy() = default;
+
+        // Hierarchy shared by all scene nodes
+        static TransformHierarchy& Global();
+
+        TransformHandle Create();
+        void Destroy(TransformHandle handle);
+
+        // Pass InvalidTransformHandle to detach and make the transform a root
+        void SetParent(TransformHandle child, TransformHandle parent);
+        TransformHandle GetParent(TransformHandle handle) const;
+
+        void SetTranslation(TransformHandle handle, const glm::vec3& translation);
+        void SetRotation(TransformHandle handle, const glm::quat& rotation);
+        void SetScale(TransformHandle handle, const glm::vec3& scale);
+        void SetTRS(TransformHandle handle, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+        const glm::vec3& GetTranslation(TransformHandle handle) const { return m_translations[m_handleToIndex[handle]]; }
+        const glm::quat& GetRotation(TransformHandle handle) const { return m_rotations[m_handleToIndex[handle]]; }
+        const glm::vec3& GetScale(TransformHandle handle) const { return m_scales[m_handleToIndex[handle]]; }
+
+        glm::mat4 GetLocalTransform(TransformHandle handle) const;
+
+        // Resolves any pending changes before returning
+        const glm::mat4& GetWorldTransform(TransformHandle handle);
+
+        // Flags the transform (and therefore its subtree) for recomputation on the next Update
+        void MarkDirty(TransformHandle handle);
+
+        // Recomputes world matrices of every dirty transform and its descendants
+        void Update();
+
+        bool HasPendingUpdates() const { return m_firstDirty != NoDirty || m_needsSort; }
+        size_t Size() const { return m_parents.size(); }
+
+        // Per frame view of the world matrices in sorted order, valid until the next structural change
+        const std::vector<glm::mat4>& GetWorldTransforms() const { return m_world; }
+
+    private:
+        static constexpr uint32_t NoDirty = UINT32_MAX;
+        static constexpr int32_t NoParent = -1;
+
+        glm::mat4 ComposeLocal(uint32_t index) const;
+        void MarkDirtyIndex(uint32_t index);
+        void SortHierarchy();
+
+        // --- SoA data, indexed by dense index ---
+        std::vector<glm::vec3> m_translations;
+        std::vector<glm::quat> m_rotations;
+        std::vector<glm::vec3> m_scales;
+        std::vector<int32_t> m_parents;
+        std::vector<glm::mat4> m_world;
+        std::vector<uint8_t> m_dirty;
+        std::vector<uint8_t> m_alive;
+        std::vector<TransformHandle> m_indexToHandle;
+
+        // --- Handle indirection ---
+        std::vector<uint32_t> m_handleToIndex;
+        std::vector<TransformHandle> m_freeHandles;
+        std::vector<TransformHandle> m_pendingFree;
+
+        uint32_t m_firstDirty = NoDirty;
+        bool m_needsSort = false;
+    };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,354 @@
+#include "TriangleBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JL_BVH_SSE
+#include <emmintrin.h>
+#endif
+
+namespace JLEngine
+{
+	namespace
+	{
+		constexpr int MaxStackSize = 65;
+		constexpr float Miss = std::numeric_limits<float>::infinity();
+		// rejects near parallel triangles, scaled by the edge lengths in the determinant
+		constexpr float DeterminantEpsilon = 1e-12f;
+
+		float IntersectBox(const AABB& box, const glm::vec3& origin, const glm::vec3& invDir, float maxDistance)
+		{
+			glm::vec3 t0 = (box.min - origin) * invDir;
+			glm::vec3 t1 = (box.max - origin) * invDir;
+			glm::vec3 tSmall = glm::min(t0, t1);
+			glm::vec3 tBig = glm::max(t0, t1);
+
+			float tMin = std::max(std::max(tSmall.x, tSmall.y), std::max(tSmall.z, 0.0f));
+			float tMax = std::min(std::min(tBig.x, tBig.y), std::min(tBig.z, maxDistance));
+			return tMin <= tMax ? tMin : Miss;
+		}
+
+#if defined(JL_BVH_SSE)
+		inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		inline float HorizontalMin(__m128 v)
+		{
+			v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+			v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+			return _mm_cvtss_f32(v);
+		}
+
+		struct RayPacket
+		{
+			__m128 ox, oy, oz;
+			__m128 dx, dy, dz;
+			__m128 ix, iy, iz;
+		};
+
+		// entry distance per lane, lanes that miss (or start past tMax) get infinity
+		inline __m128 IntersectBox4(const AABB& box, const RayPacket& p, __m128 tMax)
+		{
+			__m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.x), p.ox), p.ix);
+			__m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.x), p.ox), p.ix);
+			__m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.y), p.oy), p.iy);
+			__m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.y), p.oy), p.iy);
+			__m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.z), p.oz), p.iz);
+			__m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.z), p.oz), p.iz);
+
+			__m128 entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)),
+				_mm_max_ps(_mm_min_ps(t0z, t1z), _mm_setzero_ps()));
+			__m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)),
+				_mm_min_ps(_mm_max_ps(t0z, t1z), tMax));
+
+			return Select(_mm_cmple_ps(entry, exit), entry, _mm_set1_ps(Miss));
+		}
+#endif
+	}
+
+	void TriangleBVH::BuildFromPositions(const std::vector<glm::vec3>& positions, unsigned threadCount)
+	{
+		size_t count = positions.size() / 3;
+
+		std::vector<AABB> bounds(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const glm::vec3& p0 = positions[i * 3 + 0];
+			const glm::vec3& p1 = positions[i * 3 + 1];
+			const glm::vec3& p2 = positions[i * 3 + 2];
+			bounds[i] = { glm::min(p0, glm::min(p1, p2)), glm::max(p0, glm::max(p1, p2)) };
+		}
+
+		m_bvh.Build(bounds, threadCount);
+
+		// copy the triangles into the order the leaves reference them
+		m_triangleIndices = m_bvh.GetPrimitiveIndices();
+		m_triangles.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			size_t source = m_triangleIndices[i] * size_t(3);
+			m_triangles[i].v0 = positions[source];
+			m_triangles[i].edge1 = positions[source + 1] - positions[source];
+			m_triangles[i].edge2 = positions[source + 2] - positions[source];
+		}
+	}
+
+	template <bool AnyHit>
+	bool TriangleBVH::TraceScalar(const BVHRay& ray, TriangleHit& hit) const
+	{
+		const auto& nodes = m_bvh.GetNodes();
+		if (nodes.empty()) return false;
+
+		glm::vec3 invDir = 1.0f / ray.direction;
+		float closest = ray.maxDistance;
+		bool found = false;
+
+		uint32_t stack[MaxStackSize];
+		int stackSize = 0;
+		if (IntersectBox(nodes[0].bounds, ray.origin, invDir, closest) != Miss) stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const BVHNode& node = nodes[stack[--stackSize]];
+			if (IntersectBox(node.bounds, ray.origin, invDir, closest) == Miss) continue;
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+				{
+					// Moller-Trumbore, double sided
+					const PackedTriangle& tri = m_triangles[i];
+					glm::vec3 pvec = glm::cross(ray.direction, tri.edge2);
+					float det = glm::dot(tri.edge1, pvec);
+					if (std::abs(det) < DeterminantEpsilon) continue;
+
+					float invDet = 1.0f / det;
+					glm::vec3 tvec = ray.origin - tri.v0;
+					float u = glm::dot(tvec, pvec) * invDet;
+					if (u < 0.0f || u > 1.0f) continue;
+
+					glm::vec3 qvec = glm::cross(tvec, tri.edge1);
+					float v = glm::dot(ray.direction, qvec) * invDet;
+					if (v < 0.0f || u + v > 1.0f) continue;
+
+					float t = glm::dot(tri.edge2, qvec) * invDet;
+					if (t <= 0.0f || t >= closest) continue;
+
+					closest = t;
+					hit.triangle = m_triangleIndices[i];
+					hit.distance = t;
+					hit.u = u;
+					hit.v = v;
+					found = true;
+
+					if (AnyHit) return true;
+				}
+				continue;
+			}
+
+			// nearer child on top of the stack so the far one is more likely to be skipped
+			uint32_t nearChild = node.leftOrFirst;
+			uint32_t farChild = node.leftOrFirst + 1;
+			float nearT = IntersectBox(nodes[nearChild].bounds, ray.origin, invDir, closest);
+			float farT = IntersectBox(nodes[farChild].bounds, ray.origin, invDir, closest);
+			if (farT < nearT)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearT, farT);
+			}
+
+			if (farT != Miss) stack[stackSize++] = farChild;
+			if (nearT != Miss) stack[stackSize++] = nearChild;
+		}
+		return found;
+	}
+
+	template <bool AnyHit>
+	void TriangleBVH::TracePacket(const BVHRay* rays, TriangleHit* hits, bool* occluded) const
+	{
+#if defined(JL_BVH_SSE)
+		const auto& nodes = m_bvh.GetNodes();
+
+		RayPacket p;
+		p.ox = _mm_setr_ps(rays[0].origin.x, rays[1].origin.x, rays[2].origin.x, rays[3].origin.x);
+		p.oy = _mm_setr_ps(rays[0].origin.y, rays[1].origin.y, rays[2].origin.y, rays[3].origin.y);
+		p.oz = _mm_setr_ps(rays[0].origin.z, rays[1].origin.z, rays[2].origin.z, rays[3].origin.z);
+		p.dx = _mm_setr_ps(rays[0].direction.x, rays[1].direction.x, rays[2].direction.x, rays[3].direction.x);
+		p.dy = _mm_setr_ps(rays[0].direction.y, rays[1].direction.y, rays[2].direction.y, rays[3].direction.y);
+		p.dz = _mm_setr_ps(rays[0].direction.z, rays[1].direction.z, rays[2].direction.z, rays[3].direction.z);
+		p.ix = _mm_div_ps(_mm_set1_ps(1.0f), p.dx);
+		p.iy = _mm_div_ps(_mm_set1_ps(1.0f), p.dy);
+		p.iz = _mm_div_ps(_mm_set1_ps(1.0f), p.dz);
+
+		__m128 tMax = _mm_setr_ps(rays[0].maxDistance, rays[1].maxDistance, rays[2].maxDistance, rays[3].maxDistance);
+		__m128 hitU = _mm_setzero_ps();
+		__m128 hitV = _mm_setzero_ps();
+		__m128 hitSlot = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		// lanes still looking for a hit, any hit rays drop out after their first one
+		__m128 active = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 miss = _mm_set1_ps(Miss);
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const __m128 epsilon = _mm_set1_ps(DeterminantEpsilon);
+
+		uint32_t stack[MaxStackSize];
+		int stackSize = 0;
+		if (!nodes.empty() && _mm_movemask_ps(_mm_cmplt_ps(IntersectBox4(nodes[0].bounds, p, tMax), miss)) != 0)
+		{
+			stack[stackSize++] = 0;
+		}
+
+		while (stackSize > 0)
+		{
+			const BVHNode& node = nodes[stack[--stackSize]];
+			__m128 laneMask = _mm_and_ps(active, _mm_cmplt_ps(IntersectBox4(node.bounds, p, tMax), miss));
+			if (_mm_movemask_ps(laneMask) == 0) continue;
+
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i)
+				{
+					const PackedTriangle& tri = m_triangles[i];
+					__m128 e1x = _mm_set1_ps(tri.edge1.x), e1y = _mm_set1_ps(tri.edge1.y), e1z = _mm_set1_ps(tri.edge1.z);
+					__m128 e2x = _mm_set1_ps(tri.edge2.x), e2y = _mm_set1_ps(tri.edge2.y), e2z = _mm_set1_ps(tri.edge2.z);
+
+					// pvec = d x e2
+					__m128 px = _mm_sub_ps(_mm_mul_ps(p.dy, e2z), _mm_mul_ps(p.dz, e2y));
+					__m128 py = _mm_sub_ps(_mm_mul_ps(p.dz, e2x), _mm_mul_ps(p.dx, e2z));
+					__m128 pz = _mm_sub_ps(_mm_mul_ps(p.dx, e2y), _mm_mul_ps(p.dy, e2x));
+					__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+					__m128 invDet = _mm_div_ps(one, det);
+
+					// tvec = o - v0
+					__m128 tx = _mm_sub_ps(p.ox, _mm_set1_ps(tri.v0.x));
+					__m128 ty = _mm_sub_ps(p.oy, _mm_set1_ps(tri.v0.y));
+					__m128 tz = _mm_sub_ps(p.oz, _mm_set1_ps(tri.v0.z));
+					__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), invDet);
+
+					// qvec = tvec x e1
+					__m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+					__m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+					__m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+					__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(p.dx, qx), _mm_mul_ps(p.dy, qy)), _mm_mul_ps(p.dz, qz)), invDet);
+					__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+					__m128 hitMask = _mm_and_ps(laneMask, _mm_cmpge_ps(_mm_and_ps(det, absMask), epsilon));
+					hitMask = _mm_and_ps(hitMask, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)));
+					hitMask = _mm_and_ps(hitMask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+					hitMask = _mm_and_ps(hitMask, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, tMax)));
+
+					if (_mm_movemask_ps(hitMask) == 0) continue;
+
+					tMax = Select(hitMask, t, tMax);
+					hitU = Select(hitMask, u, hitU);
+					hitV = Select(hitMask, v, hitV);
+					hitSlot = Select(hitMask, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(i))), hitSlot);
+
+					if (AnyHit)
+					{
+						active = _mm_andnot_ps(hitMask, active);
+						laneMask = _mm_andnot_ps(hitMask, laneMask);
+						if (_mm_movemask_ps(active) == 0)
+						{
+							stackSize = 0;
+							break;
+						}
+					}
+				}
+				continue;
+			}
+
+			// order the children by the closest entry point over the packet
+			uint32_t nearChild = node.leftOrFirst;
+			uint32_t farChild = node.leftOrFirst + 1;
+			__m128 nearEntry = Select(active, IntersectBox4(nodes[nearChild].bounds, p, tMax), miss);
+			__m128 farEntry = Select(active, IntersectBox4(nodes[farChild].bounds, p, tMax), miss);
+			float nearT = HorizontalMin(nearEntry);
+			float farT = HorizontalMin(farEntry);
+			if (farT < nearT)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearT, farT);
+			}
+
+			if (farT != Miss) stack[stackSize++] = farChild;
+			if (nearT != Miss) stack[stackSize++] = nearChild;
+		}
+
+		alignas(16) float distances[4], us[4], vs[4];
+		alignas(16) int32_t slots[4];
+		_mm_store_ps(distances, tMax);
+		_mm_store_ps(us, hitU);
+		_mm_store_ps(vs, hitV);
+		_mm_store_si128(reinterpret_cast<__m128i*>(slots), _mm_castps_si128(hitSlot));
+
+		for (int lane = 0; lane < PacketSize; ++lane)
+		{
+			bool laneHit = slots[lane] >= 0;
+			if (occluded) occluded[lane] = laneHit;
+			if (hits)
+			{
+				hits[lane] = TriangleHit();
+				if (laneHit)
+				{
+					hits[lane].triangle = m_triangleIndices[slots[lane]];
+					hits[lane].distance = distances[lane];
+					hits[lane].u = us[lane];
+					hits[lane].v = vs[lane];
+				}
+			}
+		}
+#else
+		for (int lane = 0; lane < PacketSize; ++lane)
+		{
+			TriangleHit hit;
+			bool laneHit = TraceScalar<AnyHit>(rays[lane], hit);
+			if (occluded) occluded[lane] = laneHit;
+			if (hits) hits[lane] = hit;
+		}
+#endif
+	}
+
+	bool TriangleBVH::Intersect(const BVHRay& ray, TriangleHit& hit) const
+	{
+		hit = TriangleHit();
+		return TraceScalar<false>(ray, hit);
+	}
+
+	void TriangleBVH::Intersect4(const BVHRay* rays, TriangleHit* hits) const
+	{
+		TracePacket<false>(rays, hits, nullptr);
+	}
+
+	bool TriangleBVH::Occluded(const BVHRay& ray) const
+	{
+		TriangleHit hit;
+		return TraceScalar<true>(ray, hit);
+	}
+
+	void TriangleBVH::Occluded4(const BVHRay* rays, bool* occluded) const
+	{
+		TracePacket<true>(rays, nullptr, occluded);
+	}
+
+	void TriangleBVH::IntersectRays(const std::vector<BVHRay>& rays, std::vector<TriangleHit>& hits) const
+	{
+		hits.resize(rays.size());
+
+		size_t i = 0;
+		for (; i + PacketSize <= rays.size(); i += PacketSize)
+		{
+			Intersect4(&rays[i], &hits[i]);
+		}
+		for (; i < rays.size(); ++i)
+		{
+			Intersect(rays[i], hits[i]);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "SceneBVH.h"
+
+namespace JLEngine
+{
+	struct BVHRay
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+		float maxDistance = 1e30f;
+	};
+
+	struct TriangleHit
+	{
+		static constexpr uint32_t NoHit = UINT32_MAX;
+
+		// index into the triangle list given to Build
+		uint32_t triangle = NoHit;
+		float distance = 0.0f;
+		// barycentrics of v1 and v2
+		float u = 0.0f;
+		float v = 0.0f;
+
+		bool IsHit() const { return triangle != NoHit; }
+	};
+
+	// CPU ray tracer over world space triangles, a reference for the DDGI probe rays, offline probe
+	// baking without a GPU, and picking. The topology comes from a SceneBVH over the triangle bounds;
+	// the triangles are copied into leaf order as (v0, edge1, edge2) so a leaf is one contiguous read.
+	// Single rays use the scalar kernel, Intersect4/Occluded4 trace packets of 4 rays with SSE.
+	class TriangleBVH
+	{
+	public:
+		static constexpr int PacketSize = 4;
+
+		TriangleBVH() = default;
+
+		// Works with anything that has v0, v1 and v2 members, e.g. the TriWithEmisison list from
+		// DeferredRenderer::ExtractSceneTriangles. threadCount 0 uses every hardware thread.
+		template <typename Triangle>
+		void Build(const std::vector<Triangle>& triangles, unsigned threadCount = 0)
+		{
+			std::vector<glm::vec3> positions(triangles.size() * 3);
+			for (size_t i = 0; i < triangles.size(); ++i)
+			{
+				positions[i * 3 + 0] = triangles[i].v0;
+				positions[i * 3 + 1] = triangles[i].v1;
+				positions[i * 3 + 2] = triangles[i].v2;
+			}
+			BuildFromPositions(positions, threadCount);
+		}
+
+		// Three positions per triangle
+		void BuildFromPositions(const std::vector<glm::vec3>& positions, unsigned threadCount = 0);
+
+		// --- CLOSEST HIT ---
+		bool Intersect(const BVHRay& ray, TriangleHit& hit) const;
+		void Intersect4(const BVHRay* rays, TriangleHit* hits) const;
+
+		// --- ANY HIT --- (shadow / visibility rays, stops at the first triangle found)
+		bool Occluded(const BVHRay& ray) const;
+		void Occluded4(const BVHRay* rays, bool* occluded) const;
+
+		// Traces a batch as packets of 4, the remainder goes through the scalar path
+		void IntersectRays(const std::vector<BVHRay>& rays, std::vector<TriangleHit>& hits) const;
+
+		bool Empty() const { return m_triangles.empty(); }
+		size_t GetTriangleCount() const { return m_triangles.size(); }
+		const SceneBVH& GetBVH() const { return m_bvh; }
+
+	private:
+		struct PackedTriangle
+		{
+			glm::vec3 v0;
+			glm::vec3 edge1;
+			glm::vec3 edge2;
+		};
+
+		template <bool AnyHit>
+		bool TraceScalar(const BVHRay& ray, TriangleHit& hit) const;
+		template <bool AnyHit>
+		void TracePacket(const BVHRay* rays, TriangleHit* hits, bool* occluded) const;
+
+		SceneBVH m_bvh;
+		std::vector<PackedTriangle> m_triangles;		// leaf order
+		std::vector<uint32_t> m_triangleIndices;		// leaf order -> build order
+	};
+}
+
+#endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "VertexBuffers.h"
 #include "VertexStructures.h"
 #include "Resource.h"
+#include "GeometryBatch.h"
 
 #include <memory>
 #include <string>
@@ -39,6 +40,25 @@ namespace JLEngine
 		void SetGPUID(uint32_t gpuid) { m_gpuID = gpuid; }
 		uint32_t GetGPUID() const { return m_gpuID; }
 
+		// --- BATCHED GEOMETRY ---
+		// Places the vertices (interleaved for this VAO's key) and indices in the shared buffers,
+		// reusing freed ranges before the buffers grow. Graphics::UploadGeometryChanges sends the new ranges
+		GeometryID AddGeometry(const std::vector<std::byte>& vertices, const std::vector<uint32_t>& indices)
+		{
+			return m_geometry.Add(m_vbo.GetDataMutable(), m_ibo.GetDataMutable(), CalculateStrideInBytes(m_key, m_posCount), vertices, indices);
+		}
+		GeometryID AddGeometry(const std::byte* vertices, size_t vertexBytes, const uint32_t* indices, size_t indexCount)
+		{
+			return m_geometry.Add(m_vbo.GetDataMutable(), m_ibo.GetDataMutable(), CalculateStrideInBytes(m_key, m_posCount),
+				vertices, vertexBytes, indices, indexCount);
+		}
+		void RemoveGeometry(GeometryID id) { m_geometry.Remove(id); }
+		size_t DefragmentGeometry(size_t byteBudget, std::vector<GeometryMove>& moves)
+		{
+			return m_geometry.Defragment(m_vbo.GetDataMutable(), m_ibo.GetDataMutable(), byteBudget, moves);
+		}
+		GeometryBatch& GetGeometry() { return m_geometry; }
+
 	private:
 
 		int m_posCount = 3;
@@ -57,6 +77,7 @@ namespace JLEngine
 
 		VertexBuffer m_vbo;
 		IndexBuffer m_ibo;
+		GeometryBatch m_geometry;
 	};
 }
 
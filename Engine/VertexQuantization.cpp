@@ -0,0 +1,180 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <glm/gtc/packing.hpp>
+
+namespace JLEngine
+{
+	namespace
+	{
+		constexpr int SnormMax = 32767;
+
+		int16_t ToSnorm16(float value)
+		{
+			return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * SnormMax));
+		}
+
+		float FromSnorm16(int16_t value)
+		{
+			// as GL converts a normalized GL_SHORT
+			return std::max(static_cast<float>(value) / SnormMax, -1.0f);
+		}
+
+		uint32_t PackPair(int x, int y)
+		{
+			return static_cast<uint16_t>(static_cast<int16_t>(x)) | (static_cast<uint32_t>(static_cast<uint16_t>(static_cast<int16_t>(y))) << 16);
+		}
+
+		glm::vec2 UnpackPair(uint32_t packed)
+		{
+			return glm::vec2(FromSnorm16(static_cast<int16_t>(packed & 0xFFFF)), FromSnorm16(static_cast<int16_t>(packed >> 16)));
+		}
+
+		// Rounding each coordinate to the nearest step isn't always the nearest direction, so the
+		// snorm values either side are tried and the one decoding closest to n is kept. oddY != -1
+		// only takes second values whose lowest bit matches it
+		uint32_t PackOctahedral(const glm::vec3& n, int oddY = -1)
+		{
+			glm::vec2 e = VertexQuantization::OctahedralEncode(n);
+			int baseX = static_cast<int>(std::floor(std::clamp(e.x, -1.0f, 1.0f) * SnormMax));
+			int baseY = static_cast<int>(std::floor(std::clamp(e.y, -1.0f, 1.0f) * SnormMax));
+
+			uint32_t best = 0;
+			float bestDot = -2.0f;
+			for (int x = baseX; x <= baseX + 1; ++x)
+			{
+				for (int y = baseY - 1; y <= baseY + 2; ++y)
+				{
+					int cx = std::clamp(x, -SnormMax, SnormMax);
+					int cy = std::clamp(y, -SnormMax, SnormMax);
+					// without a parity to match the outer two would only ever be further away
+					if (oddY < 0 && (y < baseY || y > baseY + 1)) continue;
+					if (oddY >= 0 && (cy & 1) != oddY) continue;
+
+					uint32_t packed = PackPair(cx, cy);
+					float d = glm::dot(VertexQuantization::OctahedralDecode(UnpackPair(packed)), n);
+					if (d > bestDot)
+					{
+						bestDot = d;
+						best = packed;
+					}
+				}
+			}
+			return best;
+		}
+	}
+
+	glm::vec2 VertexQuantization::OctahedralEncode(const glm::vec3& n)
+	{
+		float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+		if (l1 <= 0.0f) return glm::vec2(0.0f);
+
+		glm::vec2 e(n.x / l1, n.y / l1);
+		if (n.z < 0.0f)
+		{
+			glm::vec2 folded(1.0f - std::abs(e.y), 1.0f - std::abs(e.x));
+			e.x = e.x >= 0.0f ? folded.x : -folded.x;
+			e.y = e.y >= 0.0f ? folded.y : -folded.y;
+		}
+		return e;
+	}
+
+	glm::vec3 VertexQuantization::OctahedralDecode(const glm::vec2& e)
+	{
+		glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+		float t = std::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return glm::normalize(n);
+	}
+
+	uint32_t VertexQuantization::PackNormal(const glm::vec3& n)
+	{
+		return PackOctahedral(n);
+	}
+
+	glm::vec3 VertexQuantization::UnpackNormal(uint32_t packed)
+	{
+		return OctahedralDecode(UnpackPair(packed));
+	}
+
+	uint32_t VertexQuantization::PackTangent(const glm::vec4& t)
+	{
+		return PackOctahedral(glm::vec3(t), t.w < 0.0f ? 1 : 0);
+	}
+
+	glm::vec4 VertexQuantization::UnpackTangent(uint32_t packed)
+	{
+		// the handedness bit stays in the direction, it moves it by one step at most
+		float w = (packed & 0x10000u) != 0 ? -1.0f : 1.0f;
+		return glm::vec4(OctahedralDecode(UnpackPair(packed)), w);
+	}
+
+	uint32_t VertexQuantization::PackTexCoord(const glm::vec2& uv)
+	{
+		return glm::packHalf2x16(uv);
+	}
+
+	glm::vec2 VertexQuantization::UnpackTexCoord(uint32_t packed)
+	{
+		return glm::unpackHalf2x16(packed);
+	}
+
+	void VertexQuantization::InterleaveCompact(const std::vector<float>& positions,
+		const std::vector<float>& normals,
+		const std::vector<float>& texCoords,
+		const std::vector<float>& texCoords2,
+		const std::vector<float>& tangents,
+		std::vector<std::byte>& vertexData)
+	{
+		size_t vertexCount = positions.size() / 3;
+		if (positions.size() % 3 != 0)
+		{
+			std::cerr << "Error: Positions array size is not a multiple of 3." << std::endl;
+			return;
+		}
+
+		bool hasNormals = !normals.empty() && normals.size() == vertexCount * 3;
+		bool hasTexCoords = !texCoords.empty() && texCoords.size() == vertexCount * 2;
+		bool hasTexCoords2 = !texCoords2.empty() && texCoords2.size() == vertexCount * 2;
+		bool hasTangents = !tangents.empty() && tangents.size() == vertexCount * 4;
+
+		// every attribute after the position is one word
+		size_t vertexSize = sizeof(float) * 3;
+		if (hasNormals) vertexSize += sizeof(uint32_t);
+		if (hasTexCoords) vertexSize += sizeof(uint32_t);
+		if (hasTexCoords2) vertexSize += sizeof(uint32_t);
+		if (hasTangents) vertexSize += sizeof(uint32_t);
+
+		vertexData.clear();
+		vertexData.resize(vertexCount * vertexSize);
+
+		auto insertWord = [](std::byte* dest, uint32_t word)
+			{
+				std::memcpy(dest, &word, sizeof(word));
+				return dest + sizeof(word);
+			};
+
+		std::byte* dataPtr = vertexData.data();
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			std::memcpy(dataPtr, &positions[i * 3], sizeof(float) * 3);
+			dataPtr += sizeof(float) * 3;
+
+			if (hasNormals)
+				dataPtr = insertWord(dataPtr, PackNormal(glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2])));
+
+			if (hasTexCoords)
+				dataPtr = insertWord(dataPtr, PackTexCoord(glm::vec2(texCoords[i * 2], texCoords[i * 2 + 1])));
+
+			if (hasTexCoords2)
+				dataPtr = insertWord(dataPtr, PackTexCoord(glm::vec2(texCoords2[i * 2], texCoords2[i * 2 + 1])));
+
+			if (hasTangents)
+				dataPtr = insertWord(dataPtr, PackTangent(glm::vec4(tangents[i * 4], tangents[i * 4 + 1], tangents[i * 4 + 2], tangents[i * 4 + 3])));
+		}
+	}
+}
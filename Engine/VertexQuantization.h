@@ -0,0 +1,42 @@
+#ifndef VERTEX_QUANTIZATION_H
+#define VERTEX_QUANTIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "VertexStructures.h"
+
+namespace JLEngine
+{
+	// Encoding for keys with CompactVertexFormat. Normals and tangents are octahedral, two snorm16
+	// in one word with x in the low half the way GL reads them, texture coordinates are half floats.
+	// The decode has to match vertex_decode.glsl
+	class VertexQuantization
+	{
+	public:
+		// Maps a unit vector onto the [-1, 1] square, the lower hemisphere folded over the diagonals
+		static glm::vec2 OctahedralEncode(const glm::vec3& n);
+		static glm::vec3 OctahedralDecode(const glm::vec2& e);
+
+		static uint32_t PackNormal(const glm::vec3& n);
+		static glm::vec3 UnpackNormal(uint32_t packed);
+		// The handedness in w is the lowest bit of the second value, set means -1
+		static uint32_t PackTangent(const glm::vec4& t);
+		static glm::vec4 UnpackTangent(uint32_t packed);
+		static uint32_t PackTexCoord(const glm::vec2& uv);
+		static glm::vec2 UnpackTexCoord(uint32_t packed);
+
+		// Geometry::GenerateInterleavedVertexData for a compact key, same attribute order. Attributes
+		// with the wrong number of values are left out like there
+		static void InterleaveCompact(const std::vector<float>& positions,
+			const std::vector<float>& normals,
+			const std::vector<float>& texCoords,
+			const std::vector<float>& texCoords2,
+			const std::vector<float>& tangents,
+			std::vector<std::byte>& vertexData);
+	};
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include "VertexSkinning.h"
+
+#include <cstring>
+
+namespace JLEngine
+{
+	SkinnedVertexLayout SkinnedVertexLayout::FromAttribKey(VertexAttribKey key, int posCount)
+	{
+		SkinnedVertexLayout layout;
+		// the skinning pass reads float normals and tangents, a compact key can't be skinned
+		if (IsCompactVertexFormat(key)) return layout;
+
+		uint32_t offset = 0;
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(AttributeType::COUNT); ++i)
+		{
+			if ((key & (1u << i)) == 0) continue;
+
+			switch (static_cast<AttributeType>(1 << i))
+			{
+			case AttributeType::POSITION:
+				layout.position = offset;
+				offset += posCount * sizeof(float);
+				break;
+			case AttributeType::NORMAL:
+				layout.normal = offset;
+				offset += 3 * sizeof(float);
+				break;
+			case AttributeType::TEX_COORD_0:
+				layout.texCoord = offset;
+				offset += 2 * sizeof(float);
+				break;
+			case AttributeType::TEX_COORD_1:
+				offset += 2 * sizeof(float);
+				break;
+			case AttributeType::COLOUR:
+				offset += 4 * sizeof(float);
+				break;
+			case AttributeType::TANGENT:
+				layout.tangent = offset;
+				offset += 4 * sizeof(float);
+				break;
+			case AttributeType::JOINT_0:
+				layout.joints = offset;
+				offset += 4 * sizeof(uint16_t);
+				break;
+			case AttributeType::WEIGHT_0:
+				layout.weights = offset;
+				offset += 4 * sizeof(float);
+				break;
+			default:
+				break;
+			}
+		}
+
+		layout.stride = offset;
+		return layout;
+	}
+
+	void VertexSkinning::SkinVertices(const std::byte* source, const SkinnedVertexLayout& layout, uint32_t vertexCount,
+		const glm::mat4* palette, PreskinnedVertex* out)
+	{
+		auto read = [](const std::byte* vertex, uint32_t offset, float* values, int count)
+			{
+				std::memcpy(values, vertex + offset, count * sizeof(float));
+			};
+
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			const std::byte* vertex = source + static_cast<size_t>(v) * layout.stride;
+			PreskinnedVertex& result = out[v];
+
+			glm::vec3 position(0.0f), normal(0.0f, 0.0f, 1.0f);
+			glm::vec2 texCoord(0.0f);
+			glm::vec4 tangent(1.0f, 0.0f, 0.0f, 1.0f);
+			read(vertex, layout.position, &position.x, 3);
+			if (layout.normal != SkinnedVertexLayout::NoAttribute) read(vertex, layout.normal, &normal.x, 3);
+			if (layout.texCoord != SkinnedVertexLayout::NoAttribute) read(vertex, layout.texCoord, &texCoord.x, 2);
+			if (layout.tangent != SkinnedVertexLayout::NoAttribute) read(vertex, layout.tangent, &tangent.x, 4);
+
+			uint16_t joints[4];
+			glm::vec4 weights;
+			std::memcpy(joints, vertex + layout.joints, sizeof(joints));
+			read(vertex, layout.weights, &weights.x, 4);
+
+			// --- SKINNING MATRIX ---
+			glm::mat4 skin(1.0f);
+			float weightSum = weights.x + weights.y + weights.z + weights.w;
+			if (weightSum > 0.0f)
+			{
+				weights /= weightSum;
+				skin = weights.x * palette[joints[0]] + weights.y * palette[joints[1]] +
+					weights.z * palette[joints[2]] + weights.w * palette[joints[3]];
+			}
+
+			glm::vec3 skinnedPosition = glm::vec3(skin * glm::vec4(position, 1.0f));
+			glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(skin)));
+			glm::vec3 skinnedNormal = glm::normalize(normalMatrix * normal);
+			glm::vec3 skinnedTangent = glm::normalize(normalMatrix * glm::vec3(tangent));
+
+			std::memcpy(result.position, &skinnedPosition.x, sizeof(result.position));
+			std::memcpy(result.normal, &skinnedNormal.x, sizeof(result.normal));
+			std::memcpy(result.texCoord, &texCoord.x, sizeof(result.texCoord));
+			result.tangent[0] = skinnedTangent.x;
+			result.tangent[1] = skinnedTangent.y;
+			result.tangent[2] = skinnedTangent.z;
+			result.tangent[3] = tangent.w;
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef VERTEX_SKINNING_H
+#define VERTEX_SKINNING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "VertexStructures.h"
+
+namespace JLEngine
+{
+	// Byte offsets of each attribute in an interleaved vertex, in the order Graphics::CreateVertexArray
+	// lays them out. Attributes the key doesn't have are NoAttribute
+	struct SkinnedVertexLayout
+	{
+		static constexpr uint32_t NoAttribute = UINT32_MAX;
+
+		uint32_t stride = 0;
+		uint32_t position = NoAttribute;
+		uint32_t normal = NoAttribute;
+		uint32_t texCoord = NoAttribute;
+		uint32_t tangent = NoAttribute;
+		uint32_t joints = NoAttribute;		// 4 x uint16
+		uint32_t weights = NoAttribute;		// 4 x float
+
+		static SkinnedVertexLayout FromAttribKey(VertexAttribKey key, int posCount = 3);
+
+		bool CanSkin() const { return position != NoAttribute && joints != NoAttribute && weights != NoAttribute; }
+	};
+
+	// What the pre-skinning pass writes for every vertex, the static vertex format so the skinned
+	// meshes can be drawn by the static G-buffer and shadow shaders
+	struct PreskinnedVertex
+	{
+		float position[3];
+		float normal[3];
+		float texCoord[2];
+		float tangent[4];
+	};
+	static_assert(sizeof(PreskinnedVertex) == 48, "must match OUTPUT_STRIDE in joint_transform.compute");
+
+	// Up to WorkgroupSize vertices of one skinned draw, one compute workgroup each. Matches SkinJob
+	// in joint_transform.compute
+	struct SkinJobGPU
+	{
+		uint32_t firstVertex;	// into the skinned vertex buffer, the output buffer uses the same index
+		uint32_t vertexCount;
+		uint32_t perDrawSlot;	// skinned per draw data with the joint base / baked clip
+		uint32_t pad0;
+	};
+
+	class VertexSkinning
+	{
+	public:
+		static constexpr VertexAttribKey PreskinnedAttribKey =
+			static_cast<VertexAttribKey>(AttributeType::POSITION) | static_cast<VertexAttribKey>(AttributeType::NORMAL) |
+			static_cast<VertexAttribKey>(AttributeType::TEX_COORD_0) | static_cast<VertexAttribKey>(AttributeType::TANGENT);
+
+		static constexpr uint32_t WorkgroupSize = 64;
+
+		// CPU reference for joint_transform.compute. Skins vertexCount vertices of source into out,
+		// palette is indexed by the vertex joint indices. Weights are normalized, a vertex with no
+		// weight keeps its bind pose. Normals and tangents use the inverse transpose, tangent w is kept
+		static void SkinVertices(const std::byte* source, const SkinnedVertexLayout& layout, uint32_t vertexCount,
+			const glm::mat4* palette, PreskinnedVertex* out);
+	};
+}
+
+#endif
@@ -61,85 +61,65 @@ namespace JLEngine
 		return (mask & static_cast<uint32_t>(attribute)) != 0;
 	}
 
-	uint32_t CalculateStrideInBytes(VertexArrayObject* vao)
+	bool IsCompactVertexFormat(VertexAttribKey key)
 	{
-		uint32_t stride = 0;
-		int floatSize = static_cast<int>(sizeof(float));
+		return (key & CompactVertexFormat) != 0;
+	}
 
-		for (uint32_t i = 0; i < 32; ++i)
+	uint32_t VertexAttribFormat::SizeInBytes() const
+	{
+		switch (type)
 		{
-			if (vao->GetAttribKey() & (1 << i)) // Check if the bit is set
-			{
-				switch (static_cast<AttributeType>(1 << i))
-				{
-				case AttributeType::POSITION:
-					stride += vao->GetPosCount() * floatSize; // 3 floats
-					break;
-				case AttributeType::NORMAL:
-					stride += 3 * floatSize; // 3 floats
-					break;
-				case AttributeType::TEX_COORD_0:
-				case AttributeType::TEX_COORD_1:
-					stride += 2 * floatSize; // 2 floats
-					break;
-				case AttributeType::COLOUR:
-					stride += 4 * floatSize; // 4 floats
-					break;
-				case AttributeType::TANGENT:
-					stride += 4 * floatSize; // 4 floats
-					break;
-				case AttributeType::JOINT_0:
-					stride += 4 * sizeof(uint16_t);
-					break;
-				case AttributeType::WEIGHT_0:
-					stride += 4 * floatSize;
-					break;
-				default:
-					std::cerr << "Unsupported attribute type!" << std::endl;
-					break;
-				}
-			}
+		case VertexComponentType::HalfFloat:
+		case VertexComponentType::Short:
+		case VertexComponentType::UnsignedShort:
+			return components * sizeof(uint16_t);
+		default:
+			return components * sizeof(float);
+		}
+	}
+
+	VertexAttribFormat GetVertexAttribFormat(VertexAttribKey key, AttributeType type, int posCount)
+	{
+		bool compact = IsCompactVertexFormat(key);
+
+		switch (type)
+		{
+		case AttributeType::POSITION:
+			return { posCount };
+		case AttributeType::NORMAL:
+			return compact ? VertexAttribFormat{ 2, VertexComponentType::Short, true } : VertexAttribFormat{ 3 };
+		case AttributeType::TEX_COORD_0:
+		case AttributeType::TEX_COORD_1:
+			return compact ? VertexAttribFormat{ 2, VertexComponentType::HalfFloat } : VertexAttribFormat{ 2 };
+		case AttributeType::COLOUR:
+			return { 4, VertexComponentType::Float, true };
+		case AttributeType::TANGENT:
+			// the handedness is the lowest bit of the second value
+			return compact ? VertexAttribFormat{ 2, VertexComponentType::Short, true } : VertexAttribFormat{ 4 };
+		case AttributeType::JOINT_0:
+			return { 4, VertexComponentType::UnsignedShort, false, true };
+		case AttributeType::WEIGHT_0:
+			return { 4 };
+		default:
+			std::cerr << "Unsupported attribute type!" << std::endl;
+			return {};
 		}
-		return stride;
+	}
+
+	uint32_t CalculateStrideInBytes(VertexArrayObject* vao)
+	{
+		return CalculateStrideInBytes(vao->GetAttribKey(), vao->GetPosCount());
 	}
 
 	uint32_t CalculateStrideInBytes(VertexAttribKey key, int posCount)
 	{
 		uint32_t stride = 0;
-		int floatSize = static_cast<int>(sizeof(float));
-
-		for (uint32_t i = 0; i < 32; ++i)
+		for (uint32_t i = 0; i < static_cast<uint32_t>(AttributeType::COUNT); ++i)
 		{
 			if (key & (1 << i)) // Check if the bit is set
 			{
-				switch (static_cast<AttributeType>(1 << i))
-				{
-				case AttributeType::POSITION:
-					stride += posCount * floatSize; // 3 floats
-					break;
-				case AttributeType::NORMAL:
-					stride += 3 * floatSize; // 3 floats
-					break;
-				case AttributeType::TEX_COORD_0:
-				case AttributeType::TEX_COORD_1:
-					stride += 2 * floatSize; // 2 floats
-					break;
-				case AttributeType::COLOUR:
-					stride += 4 * floatSize; // 4 floats
-					break;
-				case AttributeType::TANGENT:
-					stride += 4 * floatSize; // 4 floats
-					break;				
-				case AttributeType::JOINT_0:
-					stride += 4 * sizeof(uint16_t);
-					break;
-				case AttributeType::WEIGHT_0:
-					stride += 4 * floatSize;
-					break;
-				default:
-					std::cerr << "Unsupported attribute type!" << std::endl;
-					break;
-				}
+				stride += GetVertexAttribFormat(key, static_cast<AttributeType>(1 << i), posCount).SizeInBytes();
 			}
 		}
 		return stride;
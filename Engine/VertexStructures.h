@@ -24,6 +24,30 @@ namespace JLEngine
 		COUNT		= 8			// num elements in this enum 
 	};
 
+	// Not an attribute. Set on a key whose normals and tangents are octahedral snorm16 pairs and whose
+	// texture coordinates are half floats, see Geometry::GenerateCompactVertexData. Positions and the
+	// skin attributes keep their format. Batches are keyed by the full key so the formats never mix
+	constexpr VertexAttribKey CompactVertexFormat = 1u << 16;
+
+	enum class VertexComponentType
+	{
+		Float,
+		HalfFloat,
+		Short,
+		UnsignedShort
+	};
+
+	// How one attribute of a key is stored in the interleaved vertex
+	struct VertexAttribFormat
+	{
+		int components = 0;
+		VertexComponentType type = VertexComponentType::Float;
+		bool normalized = false;
+		bool integer = false;	// read as an ivec, not converted to float
+
+		uint32_t SizeInBytes() const;
+	};
+
 	class VertexArrayObject;
 
 	AttributeType AttribTypeFromString(const std::string& str);
@@ -32,6 +56,9 @@ namespace JLEngine
 	void AddToVertexAttribKey(VertexAttribKey& key, AttributeType type);
 	void RemoveFromVertexAttribKey(VertexAttribKey& key, AttributeType type);
 	bool HasVertexAttribKey(uint32_t mask, AttributeType attribute);
+	bool IsCompactVertexFormat(VertexAttribKey key);
+
+	VertexAttribFormat GetVertexAttribFormat(VertexAttribKey key, AttributeType type, int posCount = 3);
 
 	uint32_t CalculateStrideInBytes(VertexArrayObject* vao);
 	uint32_t CalculateStrideInBytes(VertexAttribKey key, int posCount = 3);
@@ -57,7 +57,7 @@ namespace JLEngine
 			m_corners[i] = glm::vec3(temp);
 		}
 
-		glm::vec4 tempOrig = transform * glm::vec4(0.0f);
+		glm::vec4 tempOrig = transform * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 		glm::vec3 origin = glm::vec3(tempOrig);
 
 		m_planes[0] = Plane(origin, m_corners[3], m_corners[0]);		// Left
@@ -66,21 +66,55 @@ namespace JLEngine
 		m_planes[3] = Plane(origin, m_corners[2], m_corners[3]);		// Top
 		m_planes[4] = Plane(m_corners[0], m_corners[1], m_corners[2]);	// Near
 		m_planes[5] = Plane(m_corners[5], m_corners[4], m_corners[7]);	// Far
+
+		// winding depends on the handedness of transform, so orient every plane towards the centre
+		glm::vec3 centre(0.0f);
+		for (int i = 0; i < 8; ++i)
+		{
+			centre += m_corners[i];
+		}
+		centre /= 8.0f;
+
+		for (int i = 0; i < 6; ++i)
+		{
+			if (m_planes[i].DistanceToPoint(centre) < 0.0f)
+			{
+				m_planes[i].m_normal = -m_planes[i].m_normal;
+				m_planes[i].m_distance = -m_planes[i].m_distance;
+			}
+		}
+	}
+
+	void ViewFrustum::ExtractPlanes(const glm::mat4& viewProjection)
+	{
+		// Gribb/Hartmann, glm is column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+		glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		m_planes[0] = Plane(row3 + row0);	// Left
+		m_planes[1] = Plane(row3 - row0);	// Right
+		m_planes[2] = Plane(row3 + row1);	// Bottom
+		m_planes[3] = Plane(row3 - row1);	// Top
+		m_planes[4] = Plane(row3 + row2);	// Near
+		m_planes[5] = Plane(row3 - row2);	// Far
 	}
 
-	bool ViewFrustum::Contains(AABB box)
+	bool ViewFrustum::Contains(const AABB& box) const
 	{
 		for (int i = 0; i < 6; ++i)
 		{
-			glm::vec3& norm = m_planes->m_normal;
+			const glm::vec3& norm = m_planes[i].m_normal;
 
+			// the corner furthest along the normal, if that is behind the plane the whole box is
 			glm::vec3 positive = box.min;
-			if (norm.x <= 0.0f) positive.x = box.max.x;
-			if (norm.y <= 0.0f) positive.y = box.max.y;
-			if (norm.z <= 0.0f) positive.z = box.max.z;
+			if (norm.x >= 0.0f) positive.x = box.max.x;
+			if (norm.y >= 0.0f) positive.y = box.max.y;
+			if (norm.z >= 0.0f) positive.z = box.max.z;
 
-			if (m_planes[i].DistanceToPoint(positive) > 0) return true;
+			if (m_planes[i].DistanceToPoint(positive) < 0.0f) return false;
 		}
-		return false;
+		return true;
 	}
 }
\ No newline at end of file
@@ -30,7 +30,13 @@ namespace JLEngine
 		void UpdatePerspective(const glm::mat4& transform, float fov, float near, float far, float aspect);
 		void UpdatePerspective(const glm::mat4& transform);
 		
-		bool Contains(AABB box);
+		// Builds the six planes from a combined projection * view matrix, normals point inwards
+		void ExtractPlanes(const glm::mat4& viewProjection);
+
+		// True if the box is inside or intersecting the frustum
+		bool Contains(const AABB& box) const;
+
+		const Plane* GetPlanes() const { return m_planes; }
 		
 		void SetNear(float nearPlane) { m_near = nearPlane; }
 		float GetNear() { return m_near; }
@@ -0,0 +1,213 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "AnimationBaker.h"
+#include "AnimHelpers.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // A CesiumMan sized chain with smooth translation, rotation and scale curves on every joint
+    struct TestCharacter
+    {
+        Skeleton skeleton;
+        std::unique_ptr<Animation> animation;
+        std::vector<glm::mat4> inverseBindMatrices;
+    };
+
+    std::unique_ptr<TestCharacter> MakeCharacter(int jointCount = 19, int keyCount = 60)
+    {
+        auto character = std::make_unique<TestCharacter>();
+        character->animation = std::make_unique<Animation>("Anim_Skeleton_idx:0");
+
+        for (int joint = 0; joint < jointCount; ++joint)
+        {
+            character->skeleton.joints.push_back(Skeleton::Joint{ joint - 1, glm::mat4(1.0f) });
+            character->inverseBindMatrices.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f * joint, 0.0f)));
+
+            for (int path = 0; path < 3; ++path)
+            {
+                std::vector<float> times;
+                std::vector<glm::vec4> values;
+                for (int key = 0; key < keyCount; ++key)
+                {
+                    float t = key / 30.0f;
+                    times.push_back(t);
+                    if (path == TargetPath::ROTATION)
+                    {
+                        float angle = 0.3f * std::sin(t * 4.0f + joint);
+                        values.push_back(glm::vec4(std::sin(angle * 0.5f), 0.0f, 0.0f, std::cos(angle * 0.5f)));
+                    }
+                    else if (path == TargetPath::TRANSLATION)
+                    {
+                        values.push_back(glm::vec4(0.0f, 0.1f, 0.02f * std::cos(t + joint), 0.0f));
+                    }
+                    else
+                    {
+                        values.push_back(glm::vec4(1.0f + 0.05f * std::sin(t), 1.0f, 1.0f, 0.0f));
+                    }
+                }
+
+                AnimationSampler sampler;
+                sampler.SetTimes(std::move(times));
+                sampler.SetValues(std::move(values));
+                character->animation->AddSampler(sampler);
+                character->animation->AddChannel(AnimationChannel(static_cast<int>(character->animation->GetSamplers().size()) - 1, joint, static_cast<TargetPath>(path)));
+            }
+        }
+        character->animation->CalcDuration();
+        character->animation->PrecomputeSamplers();
+        return character;
+    }
+
+    std::vector<glm::mat4> Evaluate(TestCharacter& character, float time)
+    {
+        AnimationScratch scratch;
+        std::vector<glm::mat4> palette(character.skeleton.joints.size());
+        std::vector<size_t> keyframeIndices(character.animation->GetChannels().size(), 0);
+        AnimHelpers::EvaluateJointMatrices(*character.animation, time, keyframeIndices, character.skeleton,
+            character.inverseBindMatrices, scratch, palette.data(), palette.size());
+        return palette;
+    }
+
+    float MaxDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+    {
+        float difference = 0.0f;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int r = 0; r < 4; ++r)
+                {
+                    difference = std::max(difference, std::abs(a[i][c][r] - b[i][c][r]));
+                }
+            }
+        }
+        return difference;
+    }
+
+    std::filesystem::path TestCacheFolder()
+    {
+        auto folder = std::filesystem::temp_directory_path() / "jlengine_bake_test";
+        std::filesystem::remove_all(folder);
+        return folder;
+    }
+}
+
+TEST_CASE("AnimationBaker frames match the evaluated animation", "[AnimationBaker]")
+{
+    auto character = MakeCharacter();
+    BakedAnimation baked;
+    REQUIRE(AnimationBaker::Bake(*character->animation, character->skeleton, character->inverseBindMatrices, 30.0f, BakedPaletteFormat::Float3x4, baked));
+
+    float duration = character->animation->GetDuration();
+    REQUIRE(baked.jointCount == 19);
+    REQUIRE(baked.words.size() == static_cast<size_t>(baked.frameCount) * 19 * 12);
+    REQUIRE(std::abs((baked.frameCount - 1) / baked.frameRate - duration) < 1e-4f);
+
+    std::vector<glm::mat4> sampled(19);
+    for (uint32_t frame = 0; frame + 1 < baked.frameCount; frame += 7)
+    {
+        float time = frame / baked.frameRate;
+        AnimationBaker::Sample(baked, time, sampled.data());
+        REQUIRE(MaxDifference(sampled, Evaluate(*character, time)) < 1e-4f);
+    }
+
+    // between frames it's a linear blend of two close poses
+    AnimationBaker::Sample(baked, 0.517f, sampled.data());
+    REQUIRE(MaxDifference(sampled, Evaluate(*character, 0.517f)) < 5e-3f);
+}
+
+TEST_CASE("AnimationBaker loops and packs half floats", "[AnimationBaker]")
+{
+    auto character = MakeCharacter();
+    BakedAnimation full, half;
+    REQUIRE(AnimationBaker::Bake(*character->animation, character->skeleton, character->inverseBindMatrices, 30.0f, BakedPaletteFormat::Float3x4, full));
+    REQUIRE(AnimationBaker::Bake(*character->animation, character->skeleton, character->inverseBindMatrices, 30.0f, BakedPaletteFormat::Half3x4, half));
+    REQUIRE(half.words.size() * 2 == full.words.size());
+    REQUIRE(half.sourceHash != full.sourceHash);
+
+    std::vector<glm::mat4> a(19), b(19);
+    AnimationBaker::Sample(full, 0.3f, a.data());
+    AnimationBaker::Sample(half, 0.3f, b.data());
+    REQUIRE(MaxDifference(a, b) < 5e-3f);
+
+    // instances keep playing past the end
+    AnimationBaker::Sample(full, 0.3f + 3.0f * full.duration, b.data());
+    REQUIRE(MaxDifference(a, b) < 1e-4f);
+    AnimationBaker::Sample(full, 0.3f - full.duration, b.data());
+    REQUIRE(MaxDifference(a, b) < 1e-4f);
+}
+
+TEST_CASE("AnimationBaker caches bakes on disk keyed by their source", "[AnimationBaker]")
+{
+    auto character = MakeCharacter(4, 10);
+    auto folder = TestCacheFolder();
+
+    BakedAnimation first, second;
+    REQUIRE(AnimationBaker::BakeCached(folder.string(), *character->animation, character->skeleton, character->inverseBindMatrices, 30.0f, BakedPaletteFormat::Half3x4, first));
+
+    std::vector<std::filesystem::path> files;
+    for (auto& entry : std::filesystem::directory_iterator(folder)) files.push_back(entry.path());
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].filename().string().find(':') == std::string::npos);
+
+    REQUIRE(AnimationBaker::LoadCache(files[0].string(), first.sourceHash, second));
+    REQUIRE(second.words == first.words);
+    REQUIRE(second.frameCount == first.frameCount);
+    REQUIRE(second.format == BakedPaletteFormat::Half3x4);
+
+    // a stale or damaged cache is rejected
+    REQUIRE_FALSE(AnimationBaker::LoadCache(files[0].string(), first.sourceHash + 1, second));
+    std::filesystem::resize_file(files[0], std::filesystem::file_size(files[0]) - 8);
+    REQUIRE_FALSE(AnimationBaker::LoadCache(files[0].string(), first.sourceHash, second));
+
+    // and so rebaked
+    REQUIRE(AnimationBaker::BakeCached(folder.string(), *character->animation, character->skeleton, character->inverseBindMatrices, 30.0f, BakedPaletteFormat::Half3x4, second));
+    REQUIRE(second.words == first.words);
+
+    // editing the animation changes the key
+    auto values = character->animation->GetSamplers()[0].GetValues();
+    values[0].y += 1.0f;
+    character->animation->GetSamplers()[0].SetValues(std::move(values));
+    REQUIRE(AnimationBaker::HashSource(*character->animation, character->skeleton, character->inverseBindMatrices, 30.0f, BakedPaletteFormat::Half3x4) != first.sourceHash);
+
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("AnimationBaker per instance cost", "[AnimationBaker][!benchmark]")
+{
+    auto character = MakeCharacter();
+    BakedAnimation baked;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    AnimationBaker::Bake(*character->animation, character->skeleton, character->inverseBindMatrices, 30.0f, BakedPaletteFormat::Half3x4, baked);
+    double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "Bake: " << bakeMs << " ms, " << baked.words.size() * sizeof(uint32_t) / 1024.0 << " KB for " << baked.frameCount << " frames" << std::endl;
+
+    AnimationScratch scratch;
+    std::vector<glm::mat4> palette(19);
+    std::vector<size_t> keyframeIndices(character->animation->GetChannels().size(), 0);
+
+    BENCHMARK("Live keyframe evaluation (1 character)")
+    {
+        AnimHelpers::EvaluateJointMatrices(*character->animation, 0.77f, keyframeIndices, character->skeleton,
+            character->inverseBindMatrices, scratch, palette.data(), palette.size());
+        return palette[0][3][1];
+    };
+
+    // the GPU does this per vertex, it's only here to show what the CPU no longer pays per instance
+    BENCHMARK("Baked palette sample, CPU reference (1 character)")
+    {
+        AnimationBaker::Sample(baked, 0.77f, palette.data());
+        return palette[0][3][1];
+    };
+}
@@ -0,0 +1,245 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "AnimationCompressor.h"
+#include "AnimData.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    glm::vec4 ToVec4(const glm::quat& q)
+    {
+        return glm::vec4(q.x, q.y, q.z, q.w);
+    }
+
+    // Mocap style: every joint keyed at 60 Hz on one timeline, smooth rotations, a moving root,
+    // mostly constant translation and scale on the other joints
+    KeyframeSampler MakeMocapClip(int joints, int keys)
+    {
+        KeyframeSampler sampler;
+        std::vector<float> times;
+        for (int k = 0; k < keys; ++k) times.push_back(k / 60.0f);
+
+        for (int joint = 0; joint < joints; ++joint)
+        {
+            std::vector<glm::vec4> translations, rotations, scales;
+            for (float t : times)
+            {
+                float bob = joint == 0 ? 0.05f * std::sin(t * 6.0f) : 0.0f;
+                translations.push_back(glm::vec4(joint == 0 ? 0.8f * t : 0.0f, 0.1f + bob, 0.0f, 0.0f));
+                glm::vec3 axis = glm::normalize(glm::vec3(1.0f, 0.3f * joint, 0.1f));
+                rotations.push_back(ToVec4(glm::angleAxis(0.5f * std::sin(t * 2.0f + joint) + 0.2f * std::sin(t * 7.0f), axis)));
+                scales.push_back(glm::vec4(1.0f, 1.0f, 1.0f, 0.0f));
+            }
+            sampler.AddChannel(TargetPath::TRANSLATION, InterpolationType::LINEAR, times, translations);
+            sampler.AddChannel(TargetPath::ROTATION, InterpolationType::LINEAR, times, rotations);
+            sampler.AddChannel(TargetPath::SCALE, InterpolationType::LINEAR, times, scales);
+        }
+        return sampler;
+    }
+}
+
+TEST_CASE("AnimationCompressor quantized rotations round trip", "[AnimationCompressor]")
+{
+    std::mt19937 rng(11);
+    std::normal_distribution<float> gaussian;
+    std::vector<float> times;
+    std::vector<glm::vec4> rotations;
+    for (int k = 0; k < 500; ++k)
+    {
+        times.push_back(static_cast<float>(k));
+        rotations.push_back(glm::normalize(glm::vec4(gaussian(rng), gaussian(rng), gaussian(rng), gaussian(rng))));
+    }
+    // identity and axis aligned rotations put the largest component on every index
+    rotations[0] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    rotations[1] = glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f);
+    rotations[2] = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+
+    KeyframeSampler sampler;
+    sampler.AddChannel(TargetPath::ROTATION, InterpolationType::STEP, times, rotations);
+    size_t floatBytes = sampler.MemoryBytes();
+    sampler.Quantize();
+    REQUIRE(sampler.GetKeyFormat(0) == KeyFormat::Rotation48);
+    // 4 byte times + 6 byte rotations instead of 4 + 16
+    REQUIRE(sampler.MemoryBytes() * 10 < floatBytes * 6);
+
+    for (size_t k = 0; k < times.size(); ++k)
+    {
+        glm::vec4 q = sampler.SampleChannel(0, times[k]);
+        REQUIRE(AnimationCompressor::KeyError(TargetPath::ROTATION, q, rotations[k]) < 2e-4f);
+        REQUIRE(std::abs(glm::length(q) - 1.0f) < 1e-4f);
+    }
+}
+
+TEST_CASE("AnimationCompressor quantized translations stay within a step of their range", "[AnimationCompressor]")
+{
+    std::vector<float> times = { 0.0f, 1.0f, 2.0f, 3.0f };
+    std::vector<glm::vec4> values = { glm::vec4(-2.0f, 5.0f, 0.25f, 0.0f), glm::vec4(3.0f, 5.0f, 0.5f, 0.0f),
+        glm::vec4(0.1234f, 5.0f, 0.3f, 0.0f), glm::vec4(1.0f, 5.0f, 0.26f, 0.0f) };
+
+    KeyframeSampler sampler;
+    sampler.AddChannel(TargetPath::TRANSLATION, InterpolationType::LINEAR, times, values);
+    sampler.Quantize();
+    REQUIRE(sampler.GetKeyFormat(0) == KeyFormat::Range48);
+
+    for (size_t k = 0; k < times.size(); ++k)
+    {
+        glm::vec4 v = sampler.SampleChannel(0, times[k]);
+        REQUIRE(std::abs(v.x - values[k].x) <= 5.0f / 65535.0f);
+        REQUIRE(v.y == 5.0f);
+        REQUIRE(std::abs(v.z - values[k].z) <= 0.25f / 65535.0f);
+        REQUIRE(v.w == 0.0f);
+    }
+}
+
+TEST_CASE("AnimationCompressor drops keys interpolation reproduces", "[AnimationCompressor]")
+{
+    std::vector<float> times;
+    std::vector<glm::vec4> ramp, flat, steps;
+    for (int k = 0; k < 100; ++k)
+    {
+        times.push_back(k * 0.1f);
+        ramp.push_back(glm::vec4(k * 0.5f, 1.0f, -k * 0.25f, 0.0f));
+        flat.push_back(glm::vec4(1.0f, 2.0f, 3.0f, 0.0f));
+        steps.push_back(glm::vec4(static_cast<float>(k / 30), 0.0f, 0.0f, 0.0f));
+    }
+
+    REQUIRE(AnimationCompressor::ReduceKeys(TargetPath::TRANSLATION, InterpolationType::LINEAR, times, ramp, 1e-4f) == std::vector<size_t>{ 0, 99 });
+    REQUIRE(AnimationCompressor::ReduceKeys(TargetPath::SCALE, InterpolationType::LINEAR, times, flat, 1e-4f) == std::vector<size_t>{ 0 });
+    REQUIRE(AnimationCompressor::ReduceKeys(TargetPath::TRANSLATION, InterpolationType::STEP, times, steps, 1e-4f) == std::vector<size_t>{ 0, 30, 60, 90 });
+    REQUIRE(AnimationCompressor::ReduceKeys(TargetPath::TRANSLATION, InterpolationType::CUBICSPLINE, times, ramp, 1e-4f).size() == 100);
+
+    // a corner has to stay
+    ramp[50].y = 2.0f;
+    auto kept = AnimationCompressor::ReduceKeys(TargetPath::TRANSLATION, InterpolationType::LINEAR, times, ramp, 1e-4f);
+    REQUIRE(std::find(kept.begin(), kept.end(), size_t(50)) != kept.end());
+}
+
+TEST_CASE("AnimationCompressor keeps a clip within tolerance", "[AnimationCompressor]")
+{
+    KeyframeSampler source = MakeMocapClip(19, 600);
+    KeyframeCompressionSettings settings;
+    KeyframeCompressionStats stats;
+    KeyframeSampler compressed = AnimationCompressor::Compress(source, settings, &stats);
+
+    REQUIRE(compressed.ChannelCount() == source.ChannelCount());
+    REQUIRE(stats.keysBefore == 19 * 3 * 600);
+    REQUIRE(stats.keysAfter < stats.keysBefore / 4);
+    REQUIRE(stats.Ratio() > 5.0f);
+
+    // reduction plus a quantization step
+    REQUIRE(stats.maxRotationError < settings.rotationTolerance + 2e-4f);
+    REQUIRE(stats.maxTranslationError < settings.translationTolerance + 1e-4f);
+    REQUIRE(stats.maxScaleError < settings.scaleTolerance + 1e-4f);
+
+    // decoding on the fly goes through the same SIMD passes
+    KeyframeSampleScratch scratch;
+    std::vector<glm::vec4> simd(compressed.ChannelCount()), scalar(compressed.ChannelCount());
+    std::vector<size_t> cursors;
+    for (float t = 0.0f; t < 10.0f; t += 0.37f)
+    {
+        compressed.Seek(t, cursors);
+        compressed.Sample(t, cursors, scratch, simd.data());
+        compressed.SampleScalar(t, cursors, scalar.data());
+        for (size_t c = 0; c < simd.size(); ++c)
+        {
+            REQUIRE(AnimationCompressor::KeyError(compressed.GetPath(c), simd[c], scalar[c]) < 1e-4f);
+        }
+    }
+}
+
+TEST_CASE("AnimationCompressor leaves cubic rotations as floats", "[AnimationCompressor]")
+{
+    std::vector<float> times = { 0.0f, 0.5f, 1.0f };
+    std::vector<glm::vec4> values = { ToVec4(glm::angleAxis(0.0f, glm::vec3(0.0f, 1.0f, 0.0f))),
+        ToVec4(glm::angleAxis(0.5f, glm::vec3(0.0f, 1.0f, 0.0f))), ToVec4(glm::angleAxis(1.0f, glm::vec3(0.0f, 1.0f, 0.0f))) };
+    std::vector<glm::vec4> tangents(3, glm::vec4(0.0f, 0.5f, 0.0f, 0.0f));
+
+    KeyframeSampler source;
+    source.AddChannel(TargetPath::ROTATION, InterpolationType::CUBICSPLINE, times, values, tangents, tangents);
+    source.AddChannel(TargetPath::TRANSLATION, InterpolationType::CUBICSPLINE, times, values, tangents, tangents);
+
+    KeyframeSampler compressed = AnimationCompressor::Compress(source, KeyframeCompressionSettings{});
+    REQUIRE(compressed.GetKeyFormat(0) == KeyFormat::Float);
+    REQUIRE(compressed.GetKeyFormat(1) == KeyFormat::Range48);
+    REQUIRE(compressed.KeyCount(0) == 3);
+    REQUIRE(compressed.KeyCount(1) == 3);
+    REQUIRE(compressed.GetInterpolation(1) == InterpolationType::CUBICSPLINE);
+}
+
+TEST_CASE("AnimationCompressor replaces an animation's keys", "[AnimationCompressor]")
+{
+    Animation animation("Compressed");
+    AnimationSampler sampler;
+    std::vector<float> times;
+    std::vector<glm::vec4> values;
+    for (int k = 0; k <= 120; ++k)
+    {
+        times.push_back(k / 60.0f);
+        values.push_back(glm::vec4(k / 60.0f, 0.0f, 0.0f, 0.0f));
+    }
+    sampler.SetTimes(std::move(times));
+    sampler.SetValues(std::move(values));
+    animation.AddSampler(sampler);
+    animation.AddChannel(AnimationChannel(0, 0, TargetPath::TRANSLATION));
+    animation.PrecomputeSamplers();
+    animation.CalcDuration();
+
+    uint64_t before = animation.GetKeyframes().Fingerprint();
+    auto stats = AnimationCompressor::Compress(animation, KeyframeCompressionSettings{});
+    REQUIRE(stats.keysAfter == 2);
+    REQUIRE(animation.IsSourceReleased());
+    REQUIRE(animation.GetSamplers()[0].GetTimes().empty());
+    REQUIRE(animation.GetKeyframes().Fingerprint() != before);
+
+    // the keyframes are the only copy now, rebuilding them would leave nothing
+    animation.PrecomputeSamplers();
+    animation.CalcDuration();
+    REQUIRE(animation.GetDuration() == 2.0f);
+    REQUIRE(std::abs(animation.GetKeyframes().SampleChannel(0, 1.5f).x - 1.5f) < 1e-4f);
+}
+
+TEST_CASE("AnimationCompressor sampling cost", "[AnimationCompressor][!benchmark]")
+{
+    // a CesiumMan sized skeleton playing a long mocap take
+    KeyframeSampler source = MakeMocapClip(19, 3600);
+    KeyframeCompressionStats stats;
+    auto start = std::chrono::high_resolution_clock::now();
+    KeyframeSampler compressed = AnimationCompressor::Compress(source, KeyframeCompressionSettings{}, &stats);
+    double compressMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << "Compressed " << stats.keysBefore << " -> " << stats.keysAfter << " keys, " << stats.bytesBefore / 1024 << " -> "
+        << stats.bytesAfter / 1024 << " KB (" << stats.Ratio() << "x) in " << compressMs << " ms, max error "
+        << glm::degrees(stats.maxRotationError) << " deg / " << stats.maxTranslationError << " / " << stats.maxScaleError << std::endl;
+
+    KeyframeSampleScratch scratch;
+    std::vector<glm::vec4> out(source.ChannelCount());
+    std::vector<size_t> sourceCursors, compressedCursors;
+    size_t frame = 0;
+
+    BENCHMARK("Float keys (57 channels)")
+    {
+        float t = std::fmod(++frame * 0.016f, 60.0f);
+        source.Seek(t, sourceCursors);
+        source.Sample(t, sourceCursors, scratch, out.data());
+        return out[0].x;
+    };
+
+    BENCHMARK("Reduced and quantized keys (57 channels)")
+    {
+        float t = std::fmod(++frame * 0.016f, 60.0f);
+        compressed.Seek(t, compressedCursors);
+        compressed.Sample(t, compressedCursors, scratch, out.data());
+        return out[0].x;
+    };
+}
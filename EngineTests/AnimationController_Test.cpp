@@ -0,0 +1,392 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "AnimationController.h"
+#include "JobSystem.h"
+#include "SkinningEvaluator.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    struct TRS
+    {
+        glm::vec3 translation{ 0.0f };
+        float angle = 0.0f; // about y
+        glm::vec3 scale{ 1.0f };
+    };
+
+    glm::vec4 RotationY(float angle)
+    {
+        return glm::vec4(0.0f, std::sin(angle * 0.5f), 0.0f, std::cos(angle * 0.5f));
+    }
+
+    // Two keys per channel on every joint, from -> to over duration seconds
+    std::unique_ptr<Animation> MakeClip(const std::string& name, int jointCount, float duration, const TRS& from, const TRS& to)
+    {
+        auto animation = std::make_unique<Animation>(name);
+        for (int joint = 0; joint < jointCount; ++joint)
+        {
+            for (int path = 0; path < 3; ++path)
+            {
+                std::vector<glm::vec4> values;
+                if (path == TargetPath::TRANSLATION)
+                    values = { glm::vec4(from.translation, 0.0f), glm::vec4(to.translation, 0.0f) };
+                else if (path == TargetPath::ROTATION)
+                    values = { RotationY(from.angle), RotationY(to.angle) };
+                else
+                    values = { glm::vec4(from.scale, 0.0f), glm::vec4(to.scale, 0.0f) };
+
+                AnimationSampler sampler;
+                sampler.SetTimes({ 0.0f, duration });
+                sampler.SetValues(std::move(values));
+                animation->AddSampler(sampler);
+                animation->AddChannel(AnimationChannel(static_cast<int>(animation->GetSamplers().size()) - 1, joint, static_cast<TargetPath>(path)));
+            }
+        }
+        animation->CalcDuration();
+        animation->PrecomputeSamplers();
+        return animation;
+    }
+
+    // Storage and capacity of every buffer the controller and the scratch own, a frame that grows or
+    // reallocates one of them changes the list
+    std::vector<std::pair<const void*, size_t>> Buffers(const AnimationController& controller, const AnimationScratch& scratch)
+    {
+        std::vector<std::pair<const void*, size_t>> buffers;
+        auto add = [&buffers](const auto& v) { buffers.emplace_back(static_cast<const void*>(v.data()), v.capacity()); };
+
+        add(controller.GetLayers());
+        for (const auto& layer : controller.GetLayers())
+        {
+            add(layer.clips);
+            add(layer.jointMask);
+            for (const auto& clip : layer.clips)
+            {
+                add(clip.keyframeIndices);
+                add(clip.referenceValues);
+            }
+        }
+
+        add(scratch.translations);
+        add(scratch.rotations);
+        add(scratch.scales);
+        add(scratch.localTransforms);
+        add(scratch.globalTransforms);
+        add(scratch.samples);
+        add(scratch.accumTranslations);
+        add(scratch.accumRotations);
+        add(scratch.accumScales);
+        add(scratch.accumWeights);
+        const auto& keys = scratch.keyframes;
+        for (const auto* v : { &keys.t0, &keys.t1, &keys.w00, &keys.w01, &keys.w10, &keys.w11 }) add(*v);
+        for (const auto* v : { &keys.k0, &keys.k1, &keys.outTangent, &keys.inTangent }) add(*v);
+        return buffers;
+    }
+
+    std::unique_ptr<Animation> MakeConstantClip(const std::string& name, int jointCount, const TRS& pose, float duration = 1.0f)
+    {
+        return MakeClip(name, jointCount, duration, pose, pose);
+    }
+
+    Skeleton MakeChain(int jointCount)
+    {
+        Skeleton skeleton;
+        for (int joint = 0; joint < jointCount; ++joint)
+        {
+            skeleton.joints.push_back(Skeleton::Joint{ joint - 1, glm::mat4(1.0f) });
+        }
+        return skeleton;
+    }
+
+    bool Near(const glm::vec3& a, const glm::vec3& b, float epsilon = 1e-4f)
+    {
+        return glm::length(a - b) <= epsilon;
+    }
+
+    float AngleY(const glm::quat& q)
+    {
+        float angle = 2.0f * std::atan2(q.y, q.w);
+        return angle > glm::pi<float>() ? angle - 2.0f * glm::pi<float>() : angle;
+    }
+
+    bool SameMatrix(const glm::mat4& a, const glm::mat4& b)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                if (std::abs(a[c][r] - b[c][r]) > 1e-4f) return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE("AnimationController single clip matches direct sampling", "[AnimationController]")
+{
+    auto walk = MakeClip("Walk", 3, 1.0f, TRS{ glm::vec3(0.0f), 0.0f, glm::vec3(1.0f) }, TRS{ glm::vec3(1.0f, 2.0f, 0.0f), 1.0f, glm::vec3(2.0f) });
+    Skeleton skeleton = MakeChain(3);
+    std::vector<glm::mat4> inverseBind(3, glm::mat4(1.0f));
+
+    AnimationController controller;
+    controller.SetCurrentAnimation(walk.get());
+    controller.Update(0.3f);
+    REQUIRE_FALSE(controller.IsBlending());
+    REQUIRE(controller.CurrAnim() == walk.get());
+
+    AnimationScratch scratch;
+    std::vector<glm::mat4> direct(3), blended(3);
+    AnimHelpers::EvaluateJointMatrices(*walk, controller.GetTime(), controller.GetKeyframeIndices(), skeleton, inverseBind, scratch, direct.data(), 3);
+    AnimHelpers::EvaluateBlendedJointMatrices(controller, skeleton, inverseBind, scratch, blended.data(), 3);
+    for (int i = 0; i < 3; ++i)
+    {
+        REQUIRE(SameMatrix(direct[i], blended[i]));
+    }
+}
+
+TEST_CASE("AnimationController blends weighted clips in local TRS space", "[AnimationController]")
+{
+    auto walk = MakeConstantClip("Walk", 2, TRS{ glm::vec3(0.0f), 0.0f, glm::vec3(1.0f) });
+    auto run = MakeConstantClip("Run", 2, TRS{ glm::vec3(2.0f, 0.0f, 4.0f), 1.2f, glm::vec3(3.0f) });
+
+    AnimationController controller;
+    controller.SetClipWeight(walk.get(), 3.0f);
+    controller.SetClipWeight(run.get(), 1.0f);
+    REQUIRE(controller.IsBlending());
+
+    AnimationScratch scratch;
+    AnimHelpers::EvaluateBlendedPose(controller, 2, scratch);
+
+    // weights are normalized, 3:1
+    REQUIRE(Near(scratch.translations[1], glm::vec3(0.5f, 0.0f, 1.0f)));
+    REQUIRE(Near(scratch.scales[1], glm::vec3(1.5f)));
+    float angle = AngleY(scratch.rotations[1]);
+    REQUIRE(angle > 0.0f);
+    REQUIRE(angle < 0.6f);
+    REQUIRE(std::abs(glm::length(scratch.rotations[1]) - 1.0f) < 1e-5f);
+}
+
+TEST_CASE("AnimationController crossfades and drops the faded clip", "[AnimationController]")
+{
+    auto walk = MakeConstantClip("Walk", 1, TRS{ glm::vec3(0.0f), 0.0f, glm::vec3(1.0f) });
+    auto run = MakeConstantClip("Run", 1, TRS{ glm::vec3(4.0f, 0.0f, 0.0f), 0.0f, glm::vec3(1.0f) });
+
+    AnimationController controller;
+    controller.AddAnimation(walk.get());
+    controller.AddAnimation(run.get());
+    controller.SetCurrentAnimation("Walk");
+    controller.CrossFade("Run", 0.5f);
+
+    // fading towards run already makes it the current clip
+    REQUIRE(controller.CurrAnim() == run.get());
+
+    controller.Update(0.25f);
+    REQUIRE(controller.IsBlending());
+
+    AnimationScratch scratch;
+    AnimHelpers::EvaluateBlendedPose(controller, 1, scratch);
+    REQUIRE(Near(scratch.translations[0], glm::vec3(2.0f, 0.0f, 0.0f)));
+
+    controller.Update(0.5f);
+    REQUIRE_FALSE(controller.IsBlending());
+    REQUIRE(controller.GetLayers()[0].clips.size() == 1);
+    REQUIRE(controller.CurrAnim() == run.get());
+
+    // a zero length fade snaps
+    controller.CrossFade(walk.get(), 0.0f);
+    controller.Update(0.0f);
+    REQUIRE(controller.CurrAnim() == walk.get());
+    REQUIRE(controller.GetLayers()[0].clips.size() == 1);
+}
+
+TEST_CASE("AnimationController override layers respect the joint mask", "[AnimationController]")
+{
+    Skeleton skeleton = MakeChain(3);
+    auto walk = MakeConstantClip("Walk", 3, TRS{ glm::vec3(0.0f), 0.0f, glm::vec3(1.0f) });
+    auto wave = MakeConstantClip("Wave", 3, TRS{ glm::vec3(0.0f, 2.0f, 0.0f), 0.0f, glm::vec3(1.0f) });
+
+    auto mask = AnimHelpers::BuildJointMask(skeleton, 1);
+    REQUIRE(mask == std::vector<float>{ 0.0f, 1.0f, 1.0f });
+
+    AnimationController controller;
+    controller.SetCurrentAnimation(walk.get());
+    size_t upperBody = controller.AddLayer(AnimationBlendMode::Override, 1.0f, mask);
+    controller.SetClipWeight(wave.get(), 1.0f, upperBody);
+
+    AnimationScratch scratch;
+    AnimHelpers::EvaluateBlendedPose(controller, 3, scratch);
+    REQUIRE(Near(scratch.translations[0], glm::vec3(0.0f)));
+    REQUIRE(Near(scratch.translations[1], glm::vec3(0.0f, 2.0f, 0.0f)));
+    REQUIRE(Near(scratch.translations[2], glm::vec3(0.0f, 2.0f, 0.0f)));
+
+    controller.SetLayerWeight(upperBody, 0.25f);
+    AnimHelpers::EvaluateBlendedPose(controller, 3, scratch);
+    REQUIRE(Near(scratch.translations[1], glm::vec3(0.0f, 0.5f, 0.0f)));
+}
+
+TEST_CASE("AnimationController additive layers add the difference from the first frame", "[AnimationController]")
+{
+    auto idle = MakeConstantClip("Idle", 2, TRS{ glm::vec3(1.0f, 0.0f, 0.0f), 0.5f, glm::vec3(2.0f) }, 2.0f);
+    // breathing offsets relative to an arbitrary reference pose
+    auto breathe = MakeClip("Breathe", 2, 2.0f,
+        TRS{ glm::vec3(5.0f, 5.0f, 5.0f), 0.2f, glm::vec3(1.0f) },
+        TRS{ glm::vec3(5.0f, 7.0f, 5.0f), 0.6f, glm::vec3(1.5f) });
+
+    AnimationController controller;
+    controller.SetCurrentAnimation(idle.get());
+    size_t layer = controller.AddLayer(AnimationBlendMode::Additive);
+    controller.SetClipWeight(breathe.get(), 1.0f, layer);
+
+    // at its reference frame an additive clip changes nothing
+    AnimationScratch scratch;
+    AnimHelpers::EvaluateBlendedPose(controller, 2, scratch);
+    REQUIRE(Near(scratch.translations[0], glm::vec3(1.0f, 0.0f, 0.0f)));
+    REQUIRE(std::abs(AngleY(scratch.rotations[0]) - 0.5f) < 1e-4f);
+    REQUIRE(Near(scratch.scales[0], glm::vec3(2.0f)));
+
+    controller.Update(1.0f); // halfway through both
+    AnimHelpers::EvaluateBlendedPose(controller, 2, scratch);
+    REQUIRE(Near(scratch.translations[1], glm::vec3(1.0f, 1.0f, 0.0f)));
+    REQUIRE(std::abs(AngleY(scratch.rotations[1]) - 0.7f) < 1e-3f);
+    REQUIRE(Near(scratch.scales[1], glm::vec3(2.5f)));
+
+    controller.SetLayerWeight(layer, 0.5f);
+    AnimHelpers::EvaluateBlendedPose(controller, 2, scratch);
+    REQUIRE(Near(scratch.translations[1], glm::vec3(1.0f, 0.5f, 0.0f)));
+}
+
+TEST_CASE("AnimationController synchronized layers keep clips in phase", "[AnimationController]")
+{
+    auto walk = MakeConstantClip("Walk", 1, TRS{}, 1.0f);
+    auto run = MakeConstantClip("Run", 1, TRS{}, 0.5f);
+
+    AnimationController controller;
+    controller.SetLayerSynchronized(0, true);
+    controller.SetClipWeight(walk.get(), 0.5f);
+    controller.SetClipWeight(run.get(), 0.5f);
+
+    controller.Update(0.3f);
+    const auto& clips = controller.GetLayers()[0].clips;
+    REQUIRE(std::abs(clips[0].time / 1.0f - clips[1].time / 0.5f) < 1e-5f);
+    // the phase moves at the rate of the blended cycle, 0.75 seconds
+    REQUIRE(std::abs(controller.GetLayers()[0].phase - 0.4f) < 1e-5f);
+}
+
+TEST_CASE("AnimationController blended frames don't allocate", "[AnimationController]")
+{
+    Skeleton skeleton = MakeChain(19);
+    std::vector<glm::mat4> inverseBind(19, glm::mat4(1.0f));
+    auto walk = MakeClip("Walk", 19, 1.0f, TRS{}, TRS{ glm::vec3(1.0f), 1.0f, glm::vec3(1.0f) });
+    auto run = MakeClip("Run", 19, 0.7f, TRS{}, TRS{ glm::vec3(2.0f), -1.0f, glm::vec3(1.0f) });
+    auto wave = MakeClip("Wave", 19, 1.3f, TRS{}, TRS{ glm::vec3(0.0f), 2.0f, glm::vec3(1.0f) });
+
+    AnimationController controller;
+    controller.SetCurrentAnimation(walk.get());
+    controller.CrossFade(run.get(), 10.0f);
+    controller.AddLayer(AnimationBlendMode::Override, 0.5f, AnimHelpers::BuildJointMask(skeleton, 8));
+    controller.SetClipWeight(wave.get(), 1.0f, 1);
+    controller.AddLayer(AnimationBlendMode::Additive);
+    controller.SetClipWeight(wave.get(), 0.3f, 2);
+
+    AnimationScratch scratch;
+    std::vector<glm::mat4> palette(19);
+    AnimHelpers::EvaluateBlendedJointMatrices(controller, skeleton, inverseBind, scratch, palette.data(), palette.size());
+
+    auto warmed = Buffers(controller, scratch);
+    for (int frame = 0; frame < 50; ++frame)
+    {
+        controller.Update(1.0f / 60.0f);
+        AnimHelpers::EvaluateBlendedJointMatrices(controller, skeleton, inverseBind, scratch, palette.data(), palette.size());
+        REQUIRE(Buffers(controller, scratch) == warmed);
+    }
+
+    REQUIRE(controller.IsBlending());
+}
+
+TEST_CASE("AnimationController blended characters per millisecond", "[AnimationController][!benchmark]")
+{
+    // 500 CesiumMan sized characters, walk/run crossfade with an upper body layer and an additive layer
+    constexpr int Characters = 500;
+    constexpr int Joints = 19;
+    Skeleton skeleton = MakeChain(Joints);
+    std::vector<glm::mat4> inverseBind(Joints, glm::mat4(1.0f));
+    auto walk = MakeClip("Walk", Joints, 1.0f, TRS{}, TRS{ glm::vec3(1.0f), 1.0f, glm::vec3(1.0f) });
+    auto run = MakeClip("Run", Joints, 0.7f, TRS{}, TRS{ glm::vec3(2.0f), -1.0f, glm::vec3(1.0f) });
+    auto wave = MakeClip("Wave", Joints, 1.3f, TRS{}, TRS{ glm::vec3(0.0f), 2.0f, glm::vec3(1.0f) });
+
+    std::vector<std::unique_ptr<AnimationController>> single, blended;
+    for (int i = 0; i < Characters; ++i)
+    {
+        single.push_back(std::make_unique<AnimationController>());
+        single.back()->SetCurrentAnimation(walk.get());
+        single.back()->Update(i * 0.013f);
+
+        auto controller = std::make_unique<AnimationController>();
+        controller->SetLayerSynchronized(0, true);
+        controller->SetClipWeight(walk.get(), 0.6f);
+        controller->SetClipWeight(run.get(), 0.4f);
+        controller->AddLayer(AnimationBlendMode::Override, 0.7f, AnimHelpers::BuildJointMask(skeleton, 8));
+        controller->SetClipWeight(wave.get(), 1.0f, 1);
+        controller->AddLayer(AnimationBlendMode::Additive, 0.5f);
+        controller->SetClipWeight(wave.get(), 1.0f, 2);
+        controller->Update(i * 0.013f);
+        blended.push_back(std::move(controller));
+    }
+
+    auto makeTasks = [&](std::vector<std::unique_ptr<AnimationController>>& controllers)
+    {
+        std::vector<SkinningTask> tasks;
+        for (int i = 0; i < Characters; ++i)
+        {
+            SkinningTask task;
+            task.animation = controllers[i]->CurrAnim();
+            task.time = controllers[i]->GetTime();
+            task.keyframeIndices = &controllers[i]->GetKeyframeIndices();
+            task.skeleton = &skeleton;
+            task.inverseBindMatrices = &inverseBind;
+            task.jointSlot = static_cast<uint32_t>(i * Joints);
+            task.jointCount = Joints;
+            task.controller = controllers[i].get();
+            tasks.push_back(task);
+        }
+        return tasks;
+    };
+
+    auto singleTasks = makeTasks(single);
+    auto blendedTasks = makeTasks(blended);
+    std::vector<glm::mat4> palette(static_cast<size_t>(Characters) * Joints);
+    JobSystem jobs(0);
+    SkinningEvaluator evaluator;
+    evaluator.Evaluate(blendedTasks, palette, jobs);
+
+    BENCHMARK("Single clip (500 characters, 1 thread)")
+    {
+        evaluator.Evaluate(singleTasks, palette, jobs);
+        return palette[0][3][1];
+    };
+
+    BENCHMARK("Blended, 2 clips + 2 layers (500 characters, 1 thread)")
+    {
+        evaluator.Evaluate(blendedTasks, palette, jobs);
+        return palette[0][3][1];
+    };
+
+    for (auto* tasks : { &singleTasks, &blendedTasks })
+    {
+        constexpr int Frames = 100;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < Frames; ++frame)
+        {
+            evaluator.Evaluate(*tasks, palette, jobs);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << (tasks == &singleTasks ? "Single clip: " : "Blended: ") << (Characters * Frames) / ms << " characters/ms" << std::endl;
+    }
+}
@@ -0,0 +1,129 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <vector>
+
+#include "FrustumCuller.h"
+#include "ViewFrustum.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    ViewFrustum MakeFrustum()
+    {
+        glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 10.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        ViewFrustum frustum;
+        frustum.ExtractPlanes(proj * view);
+        return frustum;
+    }
+
+    std::vector<AABB> MakeRandomBoxes(size_t count, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(-150.0f, 150.0f);
+        std::uniform_real_distribution<float> size(0.1f, 5.0f);
+
+        std::vector<AABB> boxes(count);
+        for (auto& box : boxes)
+        {
+            glm::vec3 c(pos(rng), pos(rng) * 0.2f, pos(rng));
+            glm::vec3 e(size(rng), size(rng), size(rng));
+            box = { c - e, c + e };
+        }
+        return boxes;
+    }
+}
+
+TEST_CASE("ViewFrustum::Contains tests every plane", "[FrustumCulling]")
+{
+    ViewFrustum frustum = MakeFrustum();
+
+    REQUIRE(frustum.Contains({ glm::vec3(-0.5f), glm::vec3(0.5f) }));               // in front of the camera
+    REQUIRE_FALSE(frustum.Contains({ glm::vec3(-0.5f, -0.5f, 20.0f), glm::vec3(0.5f, 0.5f, 21.0f) })); // behind
+    REQUIRE_FALSE(frustum.Contains({ glm::vec3(80.0f, 0.0f, 0.0f), glm::vec3(81.0f, 1.0f, 1.0f) }));   // off to the right
+    REQUIRE_FALSE(frustum.Contains({ glm::vec3(-1.0f, 0.0f, -200.0f), glm::vec3(1.0f, 1.0f, -150.0f) })); // past the far plane
+    REQUIRE(frustum.Contains({ glm::vec3(-100.0f), glm::vec3(100.0f) }));           // encloses the camera
+}
+
+TEST_CASE("FrustumCuller SIMD path matches the scalar reference", "[FrustumCulling]")
+{
+    ViewFrustum frustum = MakeFrustum();
+
+    // odd count so the scalar remainder path is exercised too
+    auto boxes = MakeRandomBoxes(10007, 3);
+
+    FrustumCuller culler;
+    culler.Resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        culler.SetWorldBounds(i, boxes[i]);
+    }
+
+    std::vector<uint8_t> simdVisibility, scalarVisibility;
+    CullingStats simdStats = culler.Cull(frustum.GetPlanes(), simdVisibility);
+    CullingStats scalarStats = culler.CullScalar(frustum.GetPlanes(), scalarVisibility);
+
+    REQUIRE(simdVisibility == scalarVisibility);
+    REQUIRE(simdStats.visible == scalarStats.visible);
+    REQUIRE(simdStats.tested == boxes.size());
+    REQUIRE(simdStats.visible + simdStats.culled == simdStats.tested);
+    REQUIRE(simdStats.visible > 0);
+    REQUIRE(simdStats.culled > 0);
+
+    // centre/extent form is the same test as the positive vertex one
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        REQUIRE((simdVisibility[i] != 0) == frustum.Contains(boxes[i]));
+    }
+}
+
+TEST_CASE("FrustumCuller transforms local bounds by the node transform", "[FrustumCulling]")
+{
+    ViewFrustum frustum = MakeFrustum();
+    AABB local = { glm::vec3(-1.0f), glm::vec3(1.0f) };
+
+    FrustumCuller culler;
+    culler.Resize(2);
+    culler.SetBounds(0, local, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f)));
+    culler.SetBounds(1, local, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 50.0f)));
+
+    std::vector<uint8_t> visibility;
+    CullingStats stats = culler.Cull(frustum.GetPlanes(), visibility);
+
+    REQUIRE(visibility[0] == 1);
+    REQUIRE(visibility[1] == 0);
+    REQUIRE(stats.visible == 1);
+    REQUIRE(stats.culled == 1);
+}
+
+TEST_CASE("FrustumCuller benchmark", "[FrustumCulling][!benchmark]")
+{
+    ViewFrustum frustum = MakeFrustum();
+    auto boxes = MakeRandomBoxes(100000, 11);
+
+    FrustumCuller culler;
+    culler.Resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        culler.SetWorldBounds(i, boxes[i]);
+    }
+
+    std::vector<uint8_t> visibility;
+
+    BENCHMARK("Scalar cull (100k boxes)")
+    {
+        return culler.CullScalar(frustum.GetPlanes(), visibility).visible;
+    };
+
+    BENCHMARK("SIMD cull (100k boxes)")
+    {
+        return culler.Cull(frustum.GetPlanes(), visibility).visible;
+    };
+}
\ No newline at end of file
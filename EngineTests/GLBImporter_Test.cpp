@@ -0,0 +1,168 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "GLBImporter.h"
+#include "JobSystem.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // tests run from the project folder, the assets sit next to it
+    std::filesystem::path FindAssets()
+    {
+        for (const char* path : { "../Assets", "Assets", "../../Assets" })
+        {
+            if (std::filesystem::exists(std::filesystem::path(path) / "Duck.glb"))
+                return path;
+        }
+        return {};
+    }
+
+    std::vector<std::string> AssetFiles(const std::filesystem::path& assets)
+    {
+        std::vector<std::string> files;
+        for (const auto& entry : std::filesystem::directory_iterator(assets))
+        {
+            if (entry.path().extension() == ".glb")
+                files.push_back(entry.path().string());
+        }
+        return files;
+    }
+}
+
+TEST_CASE("GLBImporter decodes the embedded images after parsing", "[GLBImporter]")
+{
+    auto assets = FindAssets();
+    if (assets.empty())
+    {
+        WARN("Assets folder not found, skipping");
+        return;
+    }
+
+    JobSystem jobs(3);
+    GLBImporter importer;
+    std::string err, warn;
+
+    REQUIRE(importer.Parse((assets / "Duck.glb").string(), err, warn));
+    REQUIRE_FALSE(importer.GetModel().images.empty());
+    // only the encoded bytes were kept while parsing
+    REQUIRE(importer.GetModel().images[0].image.empty());
+
+    JobCounter counter;
+    importer.SubmitImageDecodes(jobs, counter);
+    jobs.Wait(counter);
+    REQUIRE(importer.FinishImages(err, warn));
+
+    const auto& image = importer.GetModel().images[0];
+    REQUIRE(image.width > 0);
+    REQUIRE(image.height > 0);
+    REQUIRE(image.component == 4);
+    REQUIRE(image.image.size() == static_cast<size_t>(image.width) * image.height * 4);
+}
+
+TEST_CASE("GLBImporter gives the same model on one thread and on the pool", "[GLBImporter]")
+{
+    auto assets = FindAssets();
+    if (assets.empty())
+    {
+        WARN("Assets folder not found, skipping");
+        return;
+    }
+
+    JobSystem serial(0);
+    JobSystem pool(3);
+    for (const auto& file : { "DamagedHelmet.glb", "CesiumMan.glb", "Duck.glb" })
+    {
+        GLBImporter a, b;
+        std::string err, warn;
+        REQUIRE(a.Load((assets / file).string(), serial, err, warn));
+        REQUIRE(b.Load((assets / file).string(), pool, err, warn));
+        a.ParseMaterials(serial);
+        b.ParseMaterials(pool);
+
+        REQUIRE(a.GetModel().images.size() == b.GetModel().images.size());
+        for (size_t i = 0; i < a.GetModel().images.size(); ++i)
+        {
+            REQUIRE(a.GetModel().images[i].image == b.GetModel().images[i].image);
+        }
+
+        REQUIRE(a.GetMaterials().size() == a.GetModel().materials.size());
+        REQUIRE(b.GetMaterials().size() == a.GetMaterials().size());
+        for (size_t i = 0; i < a.GetMaterials().size(); ++i)
+        {
+            REQUIRE(a.GetMaterials()[i].baseColorTexture == b.GetMaterials()[i].baseColorTexture);
+            REQUIRE(a.GetMaterials()[i].baseColorFactor == b.GetMaterials()[i].baseColorFactor);
+        }
+    }
+}
+
+TEST_CASE("GLBImporter parses material properties without creating resources", "[GLBImporter]")
+{
+    tinygltf::Material gltfMaterial;
+    gltfMaterial.name = "Glass";
+    gltfMaterial.alphaMode = "BLEND";
+    gltfMaterial.alphaCutoff = 0.25;
+    gltfMaterial.values["baseColorFactor"].number_array = { 1.0, 0.5, 0.25, 0.5 };
+    gltfMaterial.values["baseColorTexture"].json_double_value["index"] = 2.0;
+    gltfMaterial.additionalValues["normalTexture"].json_double_value["index"] = 3.0;
+
+    auto desc = GLBImporter::ParseMaterial(gltfMaterial);
+    REQUIRE(desc.name == "Glass");
+    REQUIRE(desc.baseColorFactor == glm::vec4(1.0f, 0.5f, 0.25f, 0.5f));
+    // translucent base colour goes to the transparent batch
+    REQUIRE(desc.useTransparency);
+    REQUIRE(desc.baseColorTexture == 2);
+    REQUIRE(desc.normalTexture == 3);
+    REQUIRE(desc.metallicRoughnessTexture == -1);
+    REQUIRE(desc.emissiveTexture == -1);
+    REQUIRE(desc.metallicFactor == 1.0f);
+    REQUIRE(desc.refractionIndex == 1.5f);
+    REQUIRE(desc.alphaMode == "BLEND");
+    REQUIRE(desc.alphaCutoff == 0.25f);
+    REQUIRE_FALSE(desc.hasEmissiveStrength);
+}
+
+TEST_CASE("GLBImporter load time over the Assets folder", "[GLBImporter][!benchmark]")
+{
+    auto assets = FindAssets();
+    if (assets.empty())
+    {
+        WARN("Assets folder not found, skipping");
+        return;
+    }
+    auto files = AssetFiles(assets);
+
+    auto loadAll = [&files](JobSystem& jobs)
+        {
+            size_t bytes = 0;
+            GLBImporter importer;
+            for (const auto& file : files)
+            {
+                std::string err, warn;
+                if (importer.Load(file, jobs, err, warn))
+                {
+                    importer.ParseMaterials(jobs);
+                    for (const auto& image : importer.GetModel().images)
+                        bytes += image.image.size();
+                }
+            }
+            return bytes;
+        };
+
+    // what LoadGLB used to do, every image decoded by tinygltf on the loading thread
+    JobSystem serial(0);
+    BENCHMARK("Import Assets, one thread")
+    {
+        return loadAll(serial);
+    };
+
+    BENCHMARK("Import Assets, job system")
+    {
+        return loadAll(JobSystem::Global());
+    };
+}
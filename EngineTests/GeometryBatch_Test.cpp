@@ -0,0 +1,248 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "GeometryBatch.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    constexpr uint32_t Stride = 32;
+
+    // Every byte of a vertex encodes the geometry's tag, so moved data can be checked after a defragment
+    std::vector<std::byte> MakeVertices(uint32_t vertexCount, uint8_t tag)
+    {
+        return std::vector<std::byte>(static_cast<size_t>(vertexCount) * Stride, static_cast<std::byte>(tag));
+    }
+
+    std::vector<uint32_t> MakeIndices(uint32_t vertexCount, uint32_t indexCount)
+    {
+        std::vector<uint32_t> indices(indexCount);
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            indices[i] = i % vertexCount;
+        }
+        return indices;
+    }
+
+    struct TestBatch
+    {
+        GeometryBatch batch;
+        std::vector<std::byte> vertexData;
+        std::vector<uint32_t> indexData;
+
+        GeometryID Add(uint32_t vertexCount, uint32_t indexCount, uint8_t tag)
+        {
+            return batch.Add(vertexData, indexData, Stride, MakeVertices(vertexCount, tag), MakeIndices(vertexCount, indexCount));
+        }
+
+        bool Holds(GeometryID id, uint8_t tag) const
+        {
+            auto& range = batch.GetRange(id);
+            for (size_t i = 0; i < static_cast<size_t>(range.vertexCount) * Stride; ++i)
+            {
+                if (vertexData[static_cast<size_t>(range.baseVertex) * Stride + i] != static_cast<std::byte>(tag)) return false;
+            }
+            for (uint32_t i = 0; i < range.indexCount; ++i)
+            {
+                if (indexData[range.firstIndex + i] != i % range.vertexCount) return false;
+            }
+            return true;
+        }
+    };
+}
+
+TEST_CASE("BufferSuballocator best fit and coalescing", "[GeometryBatch]")
+{
+    BufferSuballocator allocator;
+    uint32_t a = allocator.Allocate(100);
+    uint32_t b = allocator.Allocate(50);
+    uint32_t c = allocator.Allocate(200);
+    uint32_t d = allocator.Allocate(10);
+    REQUIRE(a == 0);
+    REQUIRE(b == 100);
+    REQUIRE(c == 150);
+    REQUIRE(d == 350);
+    REQUIRE(allocator.Capacity() == 360);
+
+    // neighbouring frees merge into one block, which then fits a request neither could alone
+    allocator.Free(b, 50);
+    allocator.Free(c, 200);
+    REQUIRE(allocator.FreeBlockCount() == 1); // b and c coalesced
+    allocator.Allocate(250);
+    REQUIRE(allocator.FreeBlockCount() == 0);
+    REQUIRE(allocator.Capacity() == 360);
+
+    allocator.Free(a, 100);
+    allocator.Free(d, 10);
+    REQUIRE(allocator.Allocate(40) == 0);
+    REQUIRE(allocator.UsedSize() == 290);
+
+    // too big for the 60 hole left at 40, the trailing hole is reused when the buffer has to grow
+    uint32_t e = allocator.Allocate(70);
+    REQUIRE(e == 350);
+    REQUIRE(allocator.Capacity() == 420);
+
+    REQUIRE(allocator.Allocate(0) == BufferSuballocator::InvalidOffset);
+}
+
+TEST_CASE("GeometryBatch reuses freed ranges for streamed geometry", "[GeometryBatch]")
+{
+    TestBatch t;
+    GeometryID a = t.Add(100, 300, 1);
+    GeometryID b = t.Add(50, 150, 2);
+    GeometryID c = t.Add(80, 240, 3);
+    REQUIRE(t.batch.GetRange(b).baseVertex == 100);
+    REQUIRE(t.batch.GetRange(b).firstIndex == 300);
+    REQUIRE(t.vertexData.size() == 230 * Stride);
+    REQUIRE(t.indexData.size() == 690);
+
+    // unloading a prop and streaming a smaller one in lands in the hole, nothing grows
+    t.batch.ClearDirty();
+    t.batch.Remove(b);
+    GeometryID d = t.Add(40, 120, 4);
+    REQUIRE(t.batch.GetRange(d).baseVertex == 100);
+    REQUIRE(t.batch.GetRange(d).firstIndex == 300);
+    REQUIRE(t.vertexData.size() == 230 * Stride);
+    REQUIRE(t.Holds(a, 1));
+    REQUIRE(t.Holds(c, 3));
+    REQUIRE(t.Holds(d, 4));
+
+    // only the new geometry has to be sent to the GPU
+    auto& vertexRanges = t.batch.GetDirtyVertexRanges();
+    REQUIRE(vertexRanges.size() == 1);
+    REQUIRE(vertexRanges[0].first == 100 * Stride);
+    REQUIRE(vertexRanges[0].second == 140 * Stride);
+    auto& indexRanges = t.batch.GetDirtyIndexRanges();
+    REQUIRE(indexRanges.size() == 1);
+    REQUIRE(indexRanges[0].second - indexRanges[0].first == 120 * sizeof(uint32_t));
+
+    REQUIRE(t.batch.GetLiveCount() == 3);
+}
+
+TEST_CASE("GeometryBatch defragment compacts and reports moves", "[GeometryBatch]")
+{
+    TestBatch t;
+    std::vector<GeometryID> ids;
+    for (uint8_t i = 0; i < 10; ++i)
+    {
+        ids.push_back(t.Add(10 + i, 30 + i, i + 1));
+    }
+    t.batch.SetOwner(ids[9], nullptr, 7);
+
+    // free every other one
+    for (size_t i = 0; i < ids.size(); i += 2)
+    {
+        t.batch.Remove(ids[i]);
+    }
+    t.batch.ClearDirty();
+
+    size_t liveVertices = 0;
+    for (size_t i = 1; i < ids.size(); i += 2) liveVertices += t.batch.GetRange(ids[i]).vertexCount;
+
+    // a tiny budget still moves one range per call
+    std::vector<GeometryMove> moves;
+    REQUIRE(t.batch.Defragment(t.vertexData, t.indexData, 1, moves) > 0);
+    REQUIRE(moves.size() == 1);
+
+    while (t.batch.Defragment(t.vertexData, t.indexData, 1, moves) > 0) {}
+
+    REQUIRE(t.batch.GetVertexAllocator().FreeBlockCount() == 0);
+    REQUIRE(t.batch.GetIndexAllocator().FreeBlockCount() == 0);
+    REQUIRE(t.batch.GetVertexAllocator().Capacity() == liveVertices);
+    REQUIRE(t.vertexData.size() == liveVertices * Stride);
+
+    for (size_t i = 1; i < ids.size(); i += 2)
+    {
+        REQUIRE(t.Holds(ids[i], static_cast<uint8_t>(i + 1)));
+    }
+
+    // the last move of each geometry has its final place
+    bool sawOwner = false;
+    for (auto& move : moves)
+    {
+        if (move.id == ids[9])
+        {
+            REQUIRE(move.submeshIndex == 7);
+            sawOwner = true;
+        }
+    }
+    REQUIRE(sawOwner);
+    auto& last = t.batch.GetRange(ids[9]);
+    for (auto it = moves.rbegin(); it != moves.rend(); ++it)
+    {
+        if (it->id != ids[9]) continue;
+        REQUIRE(it->range.baseVertex == last.baseVertex);
+        REQUIRE(it->range.firstIndex == last.firstIndex);
+        break;
+    }
+}
+
+TEST_CASE("GeometryBatch defragment respects the byte budget", "[GeometryBatch]")
+{
+    TestBatch t;
+    GeometryID hole = t.Add(1000, 0, 1);
+    std::vector<GeometryID> ids;
+    for (uint8_t i = 0; i < 20; ++i)
+    {
+        ids.push_back(t.Add(100, 0, i + 2));
+    }
+    t.batch.Remove(hole);
+
+    std::vector<GeometryMove> moves;
+    size_t moved = t.batch.Defragment(t.vertexData, t.indexData, 100 * Stride * 5, moves);
+    REQUIRE(moved == 100 * Stride * 5);
+    REQUIRE(moves.size() == 5);
+    REQUIRE(t.batch.GetVertexAllocator().FreeBlockCount() == 1);
+
+    REQUIRE(t.batch.Defragment(t.vertexData, t.indexData, 1, moves) == 100 * Stride);
+}
+
+TEST_CASE("GeometryBatch rejects a different vertex layout", "[GeometryBatch]")
+{
+    TestBatch t;
+    t.Add(10, 30, 1);
+    auto id = t.batch.Add(t.vertexData, t.indexData, Stride * 2, std::vector<std::byte>(Stride * 2 * 10), MakeIndices(10, 30));
+    REQUIRE(id == InvalidGeometry);
+}
+
+TEST_CASE("GeometryBatch streaming benchmark", "[GeometryBatch][!benchmark]")
+{
+    // a level worth of props, then stream a batch of them out and back in
+    TestBatch t;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> vertexCounts(200, 4000);
+    std::vector<GeometryID> ids;
+    for (int i = 0; i < 2000; ++i)
+    {
+        uint32_t vertexCount = vertexCounts(rng);
+        ids.push_back(t.Add(vertexCount, vertexCount * 3, 1));
+    }
+    t.batch.ClearDirty();
+
+    BENCHMARK("Stream 100 props out and in")
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            auto& id = ids[(i * 17) % ids.size()];
+            uint32_t vertexCount = t.batch.GetRange(id).vertexCount;
+            t.batch.Remove(id);
+            id = t.Add(vertexCount, vertexCount * 3, 2);
+        }
+        size_t dirty = 0;
+        for (auto& range : t.batch.GetDirtyVertexRanges()) dirty += range.second - range.first;
+        t.batch.ClearDirty();
+        return dirty;
+    };
+
+    BENCHMARK("Full batch re-upload copy")
+    {
+        std::vector<std::byte> copy(t.vertexData.size());
+        std::memcpy(copy.data(), t.vertexData.data(), t.vertexData.size());
+        return copy.size();
+    };
+}
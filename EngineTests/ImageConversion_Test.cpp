@@ -0,0 +1,217 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "ImageConversion.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    float ReferenceSRGBToLinear(float c)
+    {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float ReferenceLinearToSRGB(float c)
+    {
+        c = std::fmin(std::fmax(c, 0.0f), 1.0f);
+        return 255.0f * (c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f);
+    }
+
+    uint32_t Bits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}
+
+TEST_CASE("sRGB values survive a round trip through linear", "[ImageConversion]")
+{
+    std::vector<uint8_t> bytes(256 * 4);
+    for (size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] = static_cast<uint8_t>(i / 4);
+
+    for (int channels : { 3, 4 })
+    {
+        size_t pixels = bytes.size() / channels;
+        std::vector<float> linear(pixels * channels);
+        ImageConversion::SRGBToLinear(bytes.data(), linear.data(), pixels, channels);
+
+        for (size_t i = 0; i < linear.size(); ++i)
+        {
+            bool alpha = channels == 4 && i % 4 == 3;
+            float expected = alpha ? bytes[i] / 255.0f : ReferenceSRGBToLinear(bytes[i] / 255.0f);
+            REQUIRE(std::abs(linear[i] - expected) < 1e-6f);
+        }
+
+        std::vector<uint8_t> encoded(linear.size());
+        ImageConversion::LinearToSRGB(linear.data(), encoded.data(), pixels, channels);
+        REQUIRE(encoded == std::vector<uint8_t>(bytes.begin(), bytes.begin() + encoded.size()));
+    }
+}
+
+TEST_CASE("Linear to sRGB stays within rounding of the exact curve", "[ImageConversion]")
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-0.25f, 1.25f);
+
+    // an odd count so the scalar tail sees values too
+    std::vector<float> linear(4097);
+    for (float& value : linear) value = dist(rng);
+    linear[0] = std::numeric_limits<float>::quiet_NaN();
+    linear[1] = std::numeric_limits<float>::infinity();
+    linear[2] = 1e-9f;
+    linear[4096] = 0.5f;
+
+    std::vector<uint8_t> encoded(linear.size());
+    ImageConversion::LinearToSRGB(linear.data(), encoded.data(), linear.size(), 1);
+
+    REQUIRE(encoded[0] == 0);
+    REQUIRE(encoded[1] == 255);
+    REQUIRE(encoded[2] == 0);
+    for (size_t i = 1; i < linear.size(); ++i)
+        REQUIRE(std::abs(encoded[i] - ReferenceLinearToSRGB(linear[i])) < 0.65f);
+
+    // the SIMD and scalar paths agree, one value at a time is always scalar
+    for (size_t i = 0; i < linear.size(); ++i)
+    {
+        uint8_t single;
+        ImageConversion::LinearToSRGB(&linear[i], &single, 1, 1);
+        REQUIRE(single == encoded[i]);
+    }
+
+    // the alpha of RGBA is plain 0..1
+    float rgba[8] = { 0.5f, 0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 2.0f, -1.0f };
+    uint8_t out[8];
+    ImageConversion::LinearToSRGB(rgba, out, 2, 4);
+    REQUIRE(out[0] == 188);
+    REQUIRE(out[3] == 128);
+    REQUIRE(out[6] == 255);
+    REQUIRE(out[7] == 0);
+}
+
+TEST_CASE("Half floats round to nearest even", "[ImageConversion]")
+{
+    REQUIRE(ImageConversion::FloatToHalf(0.0f) == 0x0000);
+    REQUIRE(ImageConversion::FloatToHalf(-0.0f) == 0x8000);
+    REQUIRE(ImageConversion::FloatToHalf(1.0f) == 0x3C00);
+    REQUIRE(ImageConversion::FloatToHalf(-2.0f) == 0xC000);
+    REQUIRE(ImageConversion::FloatToHalf(65504.0f) == 0x7BFF);
+    REQUIRE(ImageConversion::FloatToHalf(65520.0f) == 0x7C00);
+    REQUIRE(ImageConversion::FloatToHalf(std::numeric_limits<float>::infinity()) == 0x7C00);
+    REQUIRE(ImageConversion::FloatToHalf(std::ldexp(1.0f, -24)) == 0x0001);
+    REQUIRE(ImageConversion::FloatToHalf(std::ldexp(1.0f, -26)) == 0x0000);
+    // halfway between 1 and the next half, the even one wins
+    REQUIRE(ImageConversion::FloatToHalf(1.0f + std::ldexp(1.0f, -11)) == 0x3C00);
+    REQUIRE(ImageConversion::FloatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)) == 0x3C02);
+    REQUIRE(std::isnan(ImageConversion::HalfToFloat(ImageConversion::FloatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+    // every half that isn't a NaN comes back as itself through the batch path
+    std::vector<float> floats;
+    std::vector<uint16_t> halves;
+    for (uint32_t h = 0; h < 0x10000; ++h)
+    {
+        if ((h & 0x7C00) == 0x7C00 && (h & 0x03FF) != 0) continue;
+        halves.push_back(static_cast<uint16_t>(h));
+        floats.push_back(ImageConversion::HalfToFloat(static_cast<uint16_t>(h)));
+    }
+    std::vector<uint16_t> converted(floats.size());
+    ImageConversion::FloatToHalf(floats.data(), converted.data(), floats.size());
+    REQUIRE(converted == halves);
+
+    // and random floats give the same bits either way
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<uint32_t> bits(0, 0xFFFFFFFF);
+    std::vector<float> values(1001);
+    for (float& value : values)
+    {
+        uint32_t b = bits(rng);
+        // keep to the range around the half exponents, NaN payloads are allowed to differ
+        b = (b & 0x807FFFFF) | ((100 + b % 50) << 23);
+        std::memcpy(&value, &b, sizeof(value));
+    }
+    std::vector<uint16_t> batch(values.size());
+    ImageConversion::FloatToHalf(values.data(), batch.data(), values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+        REQUIRE(batch[i] == ImageConversion::FloatToHalf(values[i]));
+}
+
+TEST_CASE("RGB expands to RGBA at any length", "[ImageConversion]")
+{
+    for (size_t pixels = 0; pixels < 14; ++pixels)
+    {
+        std::vector<uint8_t> rgb(pixels * 3);
+        std::vector<float> rgbFloat(pixels * 3);
+        for (size_t i = 0; i < rgb.size(); ++i)
+        {
+            rgb[i] = static_cast<uint8_t>(i * 7 + 1);
+            rgbFloat[i] = static_cast<float>(i) + 0.5f;
+        }
+
+        // one pixel of slack at the end catches writes past the output
+        std::vector<uint8_t> rgba(pixels * 4 + 4, 0xEE);
+        std::vector<float> rgbaFloat(pixels * 4 + 4, -1.0f);
+        ImageConversion::ExpandRGBToRGBA(rgb.data(), rgba.data(), pixels, 200);
+        ImageConversion::ExpandRGBToRGBA(rgbFloat.data(), rgbaFloat.data(), pixels, 0.25f);
+
+        for (size_t p = 0; p < pixels; ++p)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                REQUIRE(rgba[p * 4 + c] == rgb[p * 3 + c]);
+                REQUIRE(rgbaFloat[p * 4 + c] == rgbFloat[p * 3 + c]);
+            }
+            REQUIRE(rgba[p * 4 + 3] == 200);
+            REQUIRE(rgbaFloat[p * 4 + 3] == 0.25f);
+        }
+        REQUIRE(rgba[pixels * 4] == 0xEE);
+        REQUIRE(rgbaFloat[pixels * 4] == -1.0f);
+    }
+}
+
+TEST_CASE("Unorm bytes become floats", "[ImageConversion]")
+{
+    std::vector<uint8_t> bytes(37);
+    for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = static_cast<uint8_t>(i * 7);
+
+    std::vector<float> floats(bytes.size());
+    ImageConversion::UnormToFloat(bytes.data(), floats.data(), bytes.size());
+    for (size_t i = 0; i < bytes.size(); ++i)
+        REQUIRE(std::abs(floats[i] - bytes[i] / 255.0f) < 1e-7f);
+    REQUIRE(Bits(floats[0]) == 0);
+
+    // and back, with values outside 0..1 and a NaN in the vector part
+    floats[3] = -0.5f;
+    floats[5] = 2.0f;
+    floats[9] = std::numeric_limits<float>::quiet_NaN();
+    std::vector<uint8_t> unorm(floats.size());
+    ImageConversion::FloatToUnorm(floats.data(), unorm.data(), floats.size());
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+        if (i == 3 || i == 9) REQUIRE(unorm[i] == 0);
+        else if (i == 5) REQUIRE(unorm[i] == 255);
+        else REQUIRE(unorm[i] == bytes[i]);
+    }
+}
+
+TEST_CASE("Rows flip in place", "[ImageConversion]")
+{
+    // a row length that isn't a multiple of the vector width and an odd number of rows
+    const size_t rowBytes = 37, rows = 5;
+    std::vector<uint8_t> image(rowBytes * rows);
+    for (size_t i = 0; i < image.size(); ++i) image[i] = static_cast<uint8_t>(i);
+    auto original = image;
+
+    ImageConversion::FlipVertical(image.data(), rowBytes, rows);
+    for (size_t y = 0; y < rows; ++y)
+        REQUIRE(std::memcmp(&image[y * rowBytes], &original[(rows - 1 - y) * rowBytes], rowBytes) == 0);
+
+    ImageConversion::FlipVertical(image.data(), rowBytes, rows);
+    REQUIRE(image == original);
+}
@@ -0,0 +1,207 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // Holds a worker inside a job until Release, so the test controls what is queued when it frees up
+    struct Gate
+    {
+        std::atomic<bool> entered{ false };
+        std::atomic<bool> open{ false };
+
+        void Block()
+        {
+            entered.store(true);
+            while (!open.load()) std::this_thread::yield();
+        }
+
+        void WaitEntered()
+        {
+            while (!entered.load()) std::this_thread::yield();
+        }
+
+        void Release() { open.store(true); }
+    };
+}
+
+TEST_CASE("JobSystem ParallelFor covers every index once", "[JobSystem]")
+{
+    JobSystem jobs(3);
+    REQUIRE(jobs.GetThreadCount() == 4);
+
+    std::vector<std::atomic<int>> hits(1000);
+    std::atomic<bool> badThreadIndex{ false };
+    jobs.ParallelFor(hits.size(), 7, [&](size_t begin, size_t end, unsigned threadIndex)
+        {
+            if (threadIndex >= jobs.GetThreadCount()) badThreadIndex = true;
+            for (size_t i = begin; i < end; ++i) hits[i]++;
+        });
+
+    REQUIRE_FALSE(badThreadIndex);
+    REQUIRE(std::all_of(hits.begin(), hits.end(), [](const std::atomic<int>& h) { return h == 1; }));
+}
+
+TEST_CASE("JobSystem waits on submitted jobs", "[JobSystem]")
+{
+    JobSystem jobs(2);
+    JobCounter counter;
+    std::atomic<int> done{ 0 };
+    for (int i = 0; i < 64; ++i)
+    {
+        jobs.Submit([&]() { done++; }, &counter);
+    }
+    jobs.Wait(counter);
+    REQUIRE(done == 64);
+
+    // no workers, everything runs on the caller
+    JobSystem inlineJobs(0);
+    REQUIRE(inlineJobs.GetThreadCount() == 1);
+    JobCounter inlineCounter;
+    inlineJobs.Submit([&]() { done++; }, &inlineCounter);
+    inlineJobs.Wait(inlineCounter);
+    REQUIRE(done == 65);
+}
+
+TEST_CASE("JobSystem without workers runs every job on the submitting thread", "[JobSystem]")
+{
+    JobSystem jobs(0);
+    REQUIRE(jobs.GetThreadCount() == 1);
+
+    JobCounter counter;
+    std::vector<int> order;
+    jobs.Submit([&]() { order.push_back(0); }, &counter);
+    jobs.SubmitBackground([&]()
+        {
+            order.push_back(1);
+            jobs.Submit([&]() { order.push_back(2); }, &counter);
+        }, &counter);
+    jobs.Wait(counter);
+
+    REQUIRE(order == std::vector<int>{ 0, 1, 2 });
+    REQUIRE(counter.pending.load() == 0);
+}
+
+TEST_CASE("JobSystem runs queued normal jobs before background jobs", "[JobSystem]")
+{
+    JobSystem jobs(1);
+    Gate gate;
+    JobCounter counter;
+    std::mutex mutex;
+    std::vector<int> order;
+
+    jobs.Submit([&]() { gate.Block(); }, &counter);
+    gate.WaitEntered();
+
+    jobs.SubmitBackground([&]() { std::lock_guard<std::mutex> lock(mutex); order.push_back(1); }, &counter);
+    jobs.SubmitBackground([&]() { std::lock_guard<std::mutex> lock(mutex); order.push_back(2); }, &counter);
+
+    // queued after the background jobs, the worker still takes it first
+    JobCounter normal;
+    jobs.Submit([&]() { std::lock_guard<std::mutex> lock(mutex); order.push_back(0); }, &normal);
+
+    // the waiting thread is outside the pool, it may run the normal job but never the background ones
+    std::thread release([&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            gate.Release();
+        });
+    jobs.Wait(counter);
+    jobs.Wait(normal);
+    release.join();
+
+    REQUIRE(order == std::vector<int>{ 0, 1, 2 });
+}
+
+TEST_CASE("JobSystem keeps background jobs off threads outside the pool", "[JobSystem]")
+{
+    JobSystem jobs(1);
+    Gate gate;
+    JobCounter blocker;
+    jobs.Submit([&]() { gate.Block(); }, &blocker);
+    gate.WaitEntered();
+
+    JobCounter counter;
+    std::atomic<unsigned> backgroundThread{ 0 };
+    std::atomic<unsigned> normalThread{ 1 };
+    jobs.SubmitBackground([&]() { backgroundThread.store(JobSystem::CurrentThreadIndex()); }, &counter);
+    jobs.Submit([&]() { normalThread.store(JobSystem::CurrentThreadIndex()); }, &counter);
+
+    std::thread release([&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            gate.Release();
+        });
+    jobs.Wait(counter);
+    release.join();
+    jobs.Wait(blocker);
+
+    // the only worker was held, so the waiting thread picked up the normal job itself
+    REQUIRE(normalThread.load() == 0);
+    REQUIRE(backgroundThread.load() == 1);
+}
+
+TEST_CASE("JobSystem jobs submitted from a background job stay background", "[JobSystem]")
+{
+    JobSystem jobs(2);
+    JobCounter outer;
+    JobCounter inner;
+    std::atomic<bool> submitted{ false };
+    std::atomic<bool> waited{ false };
+    std::atomic<int> innerRuns{ 0 };
+    std::atomic<unsigned> innerThread{ 0 };
+
+    jobs.SubmitBackground([&]()
+        {
+            jobs.Submit([&]()
+                {
+                    innerThread.store(JobSystem::CurrentThreadIndex());
+                    innerRuns.fetch_add(1);
+                }, &inner);
+            submitted.store(true);
+            // keep this worker busy until the test thread has waited on the nested job
+            while (!waited.load()) std::this_thread::yield();
+        }, &outer);
+
+    while (!submitted.load()) std::this_thread::yield();
+    jobs.Wait(inner);
+    waited.store(true);
+    jobs.Wait(outer);
+
+    REQUIRE(innerRuns.load() == 1);
+    REQUIRE(innerThread.load() != 0);
+}
+
+TEST_CASE("JobSystem background jobs only help with their own work while they wait", "[JobSystem]")
+{
+    JobSystem jobs(1);
+    JobCounter counter;
+    std::atomic<bool> firstDone{ false };
+    std::atomic<bool> secondRanFirst{ false };
+
+    // a file load that waits on its children, queued ahead of another whole load
+    jobs.SubmitBackground([&]()
+        {
+            JobCounter children;
+            std::atomic<int> childRuns{ 0 };
+            for (int i = 0; i < 4; ++i)
+                jobs.SubmitBackground([&]() { childRuns.fetch_add(1); }, &children);
+            jobs.Wait(children);
+            firstDone.store(childRuns.load() == 4);
+        }, &counter);
+    jobs.SubmitBackground([&]() { secondRanFirst.store(!firstDone.load()); }, &counter);
+
+    jobs.Wait(counter);
+
+    REQUIRE(firstDone.load());
+    REQUIRE_FALSE(secondRanFirst.load());
+}
@@ -0,0 +1,212 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "KTX2File.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    std::string TempPath(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    // Every byte distinct enough that a level, layer or face landing in the wrong place shows up
+    void FillPattern(KTX2Image& image)
+    {
+        for (size_t i = 0; i < image.data.size(); ++i)
+            image.data[i] = static_cast<std::byte>((i * 31 + i / 251) & 0xFF);
+    }
+
+    std::vector<uint8_t> ReadFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    uint32_t Word(const std::vector<uint8_t>& bytes, size_t offset)
+    {
+        uint32_t value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    }
+
+    uint64_t Word64(const std::vector<uint8_t>& bytes, size_t offset)
+    {
+        uint64_t value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    }
+
+    void RequireSamePixels(const KTX2Image& a, const KTX2Image& b)
+    {
+        REQUIRE(a.format == b.format);
+        REQUIRE(a.width == b.width);
+        REQUIRE(a.height == b.height);
+        REQUIRE(a.layers == b.layers);
+        REQUIRE(a.faces == b.faces);
+        REQUIRE(a.levels.size() == b.levels.size());
+        for (size_t level = 0; level < a.levels.size(); ++level)
+        {
+            REQUIRE(a.levels[level].size == b.levels[level].size);
+            REQUIRE(std::memcmp(a.LevelData(level), b.LevelData(level), static_cast<size_t>(a.levels[level].size)) == 0);
+        }
+    }
+}
+
+TEST_CASE("Level sizes follow the format", "[KTX2File]")
+{
+    KTX2Image image;
+    image.Allocate(KTX2Format::RGB16_SFLOAT, 10, 6, 4);
+    REQUIRE(image.ImageSize(0) == 10 * 6 * 6);
+    REQUIRE(image.ImageSize(3) == 1 * 1 * 6);
+    REQUIRE(image.levels[1].offset == image.levels[0].size);
+
+    image.Allocate(KTX2Format::BC7_SRGB, 10, 6, 2, 3, 6);
+    // 3x2 blocks a face, 18 faces across the layers
+    REQUIRE(image.ImageSize(0) == 3 * 2 * 16);
+    REQUIRE(image.levels[0].size == 3 * 2 * 16 * 18);
+    REQUIRE(image.ImageData(0, 1, 2) == image.LevelData(0) + (1 * 6 + 2) * image.ImageSize(0));
+    REQUIRE(KTX2File::GetFormatInfo(KTX2Format::BC7_SRGB).srgb);
+    REQUIRE(KTX2File::GetFormatInfo(KTX2Format::Undefined).blockBytes == 0);
+}
+
+TEST_CASE("2D textures with mips round trip", "[KTX2File]")
+{
+    KTX2Image image;
+    image.Allocate(KTX2Format::RGBA8_SRGB, 64, 32, 7);
+    FillPattern(image);
+
+    auto path = TempPath("ktx2_2d.ktx2");
+    REQUIRE(KTX2File::Write(path, image));
+
+    KTX2File file;
+    REQUIRE(file.Open(path));
+    REQUIRE(file.GetImage().mapped != nullptr);
+    RequireSamePixels(file.GetImage(), image);
+    REQUIRE_FALSE(file.GetImage().IsCubemap());
+    REQUIRE_FALSE(file.GetImage().IsArray());
+
+    file.Close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Cube maps, arrays and compressed formats round trip", "[KTX2File]")
+{
+    KTX2Image cube;
+    cube.Allocate(KTX2Format::RGB16_SFLOAT, 16, 16, 5, 0, 6);
+    FillPattern(cube);
+
+    KTX2Image array;
+    array.Allocate(KTX2Format::BC7_UNORM, 20, 12, 3, 4);
+    FillPattern(array);
+
+    KTX2Image lut;
+    lut.Allocate(KTX2Format::RG16_SFLOAT, 8, 8, 1);
+    FillPattern(lut);
+
+    auto path = TempPath("ktx2_cube.ktx2");
+    for (const KTX2Image* image : { &cube, &array, &lut })
+    {
+        REQUIRE(KTX2File::Write(path, *image));
+        KTX2File file;
+        REQUIRE(file.Open(path));
+        RequireSamePixels(file.GetImage(), *image);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Files follow the KTX2 layout", "[KTX2File]")
+{
+    KTX2Image image;
+    image.Allocate(KTX2Format::RGB32_SFLOAT, 8, 8, 4, 0, 6);
+    FillPattern(image);
+
+    auto path = TempPath("ktx2_layout.ktx2");
+    REQUIRE(KTX2File::Write(path, image));
+    auto bytes = ReadFile(path);
+    std::filesystem::remove(path);
+
+    const uint8_t identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+    REQUIRE(std::memcmp(bytes.data(), identifier, sizeof(identifier)) == 0);
+    REQUIRE(Word(bytes, 12) == 106);    // VK_FORMAT_R32G32B32_SFLOAT
+    REQUIRE(Word(bytes, 16) == 4);      // typeSize
+    REQUIRE(Word(bytes, 36) == 6);      // faceCount
+    REQUIRE(Word(bytes, 40) == 4);      // levelCount
+
+    // levels are stored smallest first, each on a multiple of lcm(12, 4)
+    uint64_t previous = bytes.size();
+    for (int level = 0; level < 4; ++level)
+    {
+        uint64_t offset = Word64(bytes, 80 + level * 24);
+        REQUIRE(offset % 12 == 0);
+        REQUIRE(offset < previous);
+        REQUIRE(Word64(bytes, 80 + level * 24 + 8) == image.levels[level].size);
+        previous = offset;
+    }
+
+    // the data format descriptor: one sample per channel, 32 bit signed floats
+    uint32_t dfdOffset = Word(bytes, 48);
+    uint32_t dfdLength = Word(bytes, 52);
+    REQUIRE(Word(bytes, dfdOffset) == dfdLength);
+    REQUIRE((Word(bytes, dfdOffset + 8) >> 16) == 24 + 3 * 16);
+    REQUIRE((Word(bytes, dfdOffset + 12) & 0xFF) == 1);     // RGBSDA
+    REQUIRE(Word(bytes, dfdOffset + 20) == 12);             // bytesPlane0
+    uint32_t firstSample = Word(bytes, dfdOffset + 28);
+    REQUIRE(((firstSample >> 16) & 0xFF) == 31);
+    REQUIRE((firstSample >> 24) == 0xC0);
+
+    // the writer is named in the key/value data
+    uint32_t kvdOffset = Word(bytes, 56);
+    REQUIRE(std::memcmp(bytes.data() + kvdOffset + 4, "KTXwriter", 10) == 0);
+}
+
+TEST_CASE("Broken files are refused", "[KTX2File]")
+{
+    KTX2Image image;
+    image.Allocate(KTX2Format::BC5_UNORM, 32, 32, 6);
+    FillPattern(image);
+
+    auto path = TempPath("ktx2_broken.ktx2");
+    REQUIRE(KTX2File::Write(path, image));
+    auto bytes = ReadFile(path);
+
+    KTX2File file;
+    auto writeAndOpen = [&](const std::vector<uint8_t>& contents)
+        {
+            // a mapped file can't be rewritten on every platform
+            file.Close();
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+            out.close();
+            return file.Open(path);
+        };
+
+    REQUIRE(writeAndOpen(bytes));
+
+    // the largest level is last in the file
+    REQUIRE_FALSE(writeAndOpen(std::vector<uint8_t>(bytes.begin(), bytes.end() - 1)));
+
+    auto badIdentifier = bytes;
+    badIdentifier[5] = '1';
+    REQUIRE_FALSE(writeAndOpen(badIdentifier));
+
+    auto supercompressed = bytes;
+    supercompressed[44] = 2;
+    REQUIRE_FALSE(writeAndOpen(supercompressed));
+
+    auto unknownFormat = bytes;
+    unknownFormat[12] = 0;
+    REQUIRE_FALSE(writeAndOpen(unknownFormat));
+
+    file.Close();
+    std::filesystem::remove(path);
+
+    KTX2Image empty;
+    REQUIRE_FALSE(KTX2File::Write(path, empty));
+}
@@ -0,0 +1,398 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "KeyframeSampler.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    bool Near(const glm::vec4& a, const glm::vec4& b, float epsilon = 1e-4f)
+    {
+        return std::abs(a.x - b.x) <= epsilon && std::abs(a.y - b.y) <= epsilon &&
+            std::abs(a.z - b.z) <= epsilon && std::abs(a.w - b.w) <= epsilon;
+    }
+
+    // q and -q are the same rotation
+    bool SameRotation(const glm::vec4& a, const glm::vec4& b, float epsilon = 1e-4f)
+    {
+        return Near(a, b, epsilon) || Near(a, -b, epsilon);
+    }
+
+    glm::vec4 ToVec4(const glm::quat& q)
+    {
+        return glm::vec4(q.x, q.y, q.z, q.w);
+    }
+
+    // Evenly spaced keys of f, with f' as tangents when cubic
+    template <typename F, typename D>
+    void AddCurve(KeyframeSampler& sampler, TargetPath path, InterpolationType interpolation, int keys, float spacing, F f, D derivative)
+    {
+        std::vector<float> times;
+        std::vector<glm::vec4> values, tangents;
+        for (int k = 0; k < keys; ++k)
+        {
+            float t = k * spacing;
+            times.push_back(t);
+            values.push_back(f(t));
+            tangents.push_back(derivative(t));
+        }
+
+        if (interpolation == InterpolationType::CUBICSPLINE)
+            sampler.AddChannel(path, interpolation, times, values, tangents, tangents);
+        else
+            sampler.AddChannel(path, interpolation, times, values);
+    }
+
+    glm::vec4 Cubic(float t) { return glm::vec4(t * t * t, 2.0f * t - t * t, 1.0f, -0.5f * t * t * t); }
+    glm::vec4 CubicDerivative(float t) { return glm::vec4(3.0f * t * t, 2.0f - 2.0f * t, 0.0f, -1.5f * t * t); }
+    glm::vec4 Line(float t) { return glm::vec4(t, 1.0f - t, 2.0f * t, 0.0f); }
+    glm::vec4 Zero(float) { return glm::vec4(0.0f); }
+
+    // A mix of every interpolation and path, enough channels that the SIMD pass has a tail
+    KeyframeSampler MakeMixedSampler(int channels, int keys)
+    {
+        KeyframeSampler sampler;
+        for (int c = 0; c < channels; ++c)
+        {
+            auto interpolation = static_cast<InterpolationType>(c % 3);
+            auto path = static_cast<TargetPath>((c / 3) % 3);
+            float spacing = 0.03f + 0.01f * (c % 5);
+
+            if (path == TargetPath::ROTATION)
+            {
+                AddCurve(sampler, path, interpolation, keys, spacing,
+                    [c](float t) { return ToVec4(glm::angleAxis(0.7f * std::sin(3.0f * t + c), glm::normalize(glm::vec3(1.0f, 0.5f, 0.2f * c)))); },
+                    [](float t) { return glm::vec4(0.1f * std::cos(t), 0.0f, 0.05f, 0.0f); });
+            }
+            else
+            {
+                AddCurve(sampler, path, interpolation, keys, spacing,
+                    [c](float t) { return glm::vec4(std::sin(t + c), std::cos(2.0f * t), 0.5f * t, 0.0f); },
+                    [c](float t) { return glm::vec4(std::cos(t + c), -2.0f * std::sin(2.0f * t), 0.5f, 0.0f); });
+            }
+        }
+        return sampler;
+    }
+
+    // What the controller did before the galloping search, kept as the reference and the baseline
+    size_t LinearFindKey(const std::vector<float>& times, float time, size_t key)
+    {
+        key = std::min(key, times.size() - 1);
+        while (key + 1 < times.size() && time >= times[key + 1]) key++;
+        while (key > 0 && time < times[key]) key--;
+        return key;
+    }
+
+    std::vector<float> UnevenTimes(int keys, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> gap(0.001f, 0.05f);
+        std::vector<float> times;
+        float t = 0.0f;
+        for (int k = 0; k < keys; ++k)
+        {
+            times.push_back(t);
+            // repeated times happen in exported clips, the search has to land on the last of them
+            t += (k % 17 == 5) ? 0.0f : gap(rng);
+        }
+        return times;
+    }
+}
+
+TEST_CASE("KeyframeSampler STEP holds the previous key", "[KeyframeSampler]")
+{
+    KeyframeSampler sampler;
+    sampler.AddChannel(TargetPath::TRANSLATION, InterpolationType::STEP, { 0.0f, 1.0f, 2.0f },
+        { glm::vec4(1.0f), glm::vec4(2.0f), glm::vec4(3.0f) });
+
+    REQUIRE(Near(sampler.SampleChannel(0, 0.0f), glm::vec4(1.0f)));
+    REQUIRE(Near(sampler.SampleChannel(0, 0.999f), glm::vec4(1.0f)));
+    REQUIRE(Near(sampler.SampleChannel(0, 1.0f), glm::vec4(2.0f)));
+    REQUIRE(Near(sampler.SampleChannel(0, 1.5f), glm::vec4(2.0f)));
+    REQUIRE(Near(sampler.SampleChannel(0, 5.0f), glm::vec4(3.0f)));
+
+    KeyframeSampleScratch scratch;
+    glm::vec4 out;
+    sampler.Sample(1.999f, {}, scratch, &out);
+    REQUIRE(Near(out, glm::vec4(2.0f)));
+}
+
+TEST_CASE("KeyframeSampler LINEAR matches a lerp and holds outside the keys", "[KeyframeSampler]")
+{
+    KeyframeSampler sampler;
+    AddCurve(sampler, TargetPath::SCALE, InterpolationType::LINEAR, 5, 0.25f, Line, Zero);
+
+    for (float t = 0.0f; t <= 1.0f; t += 0.0625f)
+    {
+        REQUIRE(Near(sampler.SampleChannel(0, t), Line(t)));
+    }
+    REQUIRE(Near(sampler.SampleChannel(0, -1.0f), Line(0.0f)));
+    REQUIRE(Near(sampler.SampleChannel(0, 3.0f), Line(1.0f)));
+}
+
+TEST_CASE("KeyframeSampler LINEAR rotations slerp along the shortest path", "[KeyframeSampler]")
+{
+    glm::vec3 axis = glm::normalize(glm::vec3(0.3f, 1.0f, -0.2f));
+    glm::quat a = glm::angleAxis(0.2f, axis);
+    glm::quat b = glm::angleAxis(1.4f, axis);
+
+    KeyframeSampler sampler;
+    sampler.AddChannel(TargetPath::ROTATION, InterpolationType::LINEAR, { 0.0f, 1.0f }, { ToVec4(a), ToVec4(b) });
+    // same keys with the second stored negated, still the short way round
+    sampler.AddChannel(TargetPath::ROTATION, InterpolationType::LINEAR, { 0.0f, 1.0f }, { ToVec4(a), -ToVec4(b) });
+
+    KeyframeSampleScratch scratch;
+    glm::vec4 out[2];
+    for (float t = 0.0f; t <= 1.0f; t += 0.125f)
+    {
+        glm::vec4 expected = ToVec4(glm::angleAxis(0.2f + 1.2f * t, axis));
+        sampler.Sample(t, {}, scratch, out);
+        REQUIRE(SameRotation(out[0], expected));
+        REQUIRE(SameRotation(out[1], expected));
+        REQUIRE(std::abs(glm::length(out[0]) - 1.0f) < 1e-5f);
+    }
+}
+
+TEST_CASE("KeyframeSampler CUBICSPLINE reproduces a cubic from its tangents", "[KeyframeSampler]")
+{
+    // Hermite interpolation is exact for a cubic when the tangents are its derivative,
+    // uneven key spacing checks the tangents are scaled by the key interval
+    KeyframeSampler sampler;
+    std::vector<float> times = { 0.0f, 0.3f, 0.45f, 1.0f, 1.6f };
+    std::vector<glm::vec4> values, tangents;
+    for (float t : times)
+    {
+        values.push_back(Cubic(t));
+        tangents.push_back(CubicDerivative(t));
+    }
+    sampler.AddChannel(TargetPath::TRANSLATION, InterpolationType::CUBICSPLINE, times, values, tangents, tangents);
+
+    for (float t = 0.0f; t <= 1.6f; t += 0.05f)
+    {
+        REQUIRE(Near(sampler.SampleChannel(0, t), Cubic(t)));
+    }
+    REQUIRE(Near(sampler.SampleChannel(0, 2.0f), Cubic(1.6f)));
+    REQUIRE(sampler.GetInterpolation(0) == InterpolationType::CUBICSPLINE);
+}
+
+TEST_CASE("KeyframeSampler CUBICSPLINE rotations are normalized", "[KeyframeSampler]")
+{
+    KeyframeSampler sampler;
+    AddCurve(sampler, TargetPath::ROTATION, InterpolationType::CUBICSPLINE, 4, 0.5f,
+        [](float t) { return ToVec4(glm::angleAxis(t, glm::vec3(0.0f, 1.0f, 0.0f))); },
+        [](float t) { return glm::vec4(0.0f, 0.5f * std::cos(0.5f * t), 0.0f, -0.5f * std::sin(0.5f * t)); });
+
+    for (float t = 0.0f; t <= 1.5f; t += 0.1f)
+    {
+        glm::vec4 q = sampler.SampleChannel(0, t);
+        REQUIRE(std::abs(glm::length(q) - 1.0f) < 1e-5f);
+        REQUIRE(SameRotation(q, ToVec4(glm::angleAxis(t, glm::vec3(0.0f, 1.0f, 0.0f))), 1e-3f));
+    }
+}
+
+TEST_CASE("KeyframeSampler SIMD pass matches the scalar reference", "[KeyframeSampler]")
+{
+    KeyframeSampler sampler = MakeMixedSampler(27, 40);
+    REQUIRE(sampler.ChannelCount() == 27);
+
+    KeyframeSampleScratch scratch;
+    std::vector<glm::vec4> simd(27), scalar(27);
+    std::vector<size_t> hints(27, 0);
+
+    for (float t = -0.1f; t < 2.5f; t += 0.0173f)
+    {
+        sampler.Sample(t, hints, scratch, simd.data());
+        sampler.SampleScalar(t, hints, scalar.data());
+        for (size_t c = 0; c < simd.size(); ++c)
+        {
+            REQUIRE(Near(simd[c], scalar[c]));
+        }
+    }
+}
+
+TEST_CASE("KeyframeSampler tolerates stale and missing key hints", "[KeyframeSampler]")
+{
+    KeyframeSampler sampler = MakeMixedSampler(9, 30);
+    std::vector<glm::vec4> expected(9), out(9);
+    sampler.SampleScalar(0.4f, {}, expected.data());
+
+    KeyframeSampleScratch scratch;
+    // hints past the time, past the end, and too few of them
+    std::vector<size_t> stale = { 29, 1000, 15, 0, 7 };
+    sampler.Sample(0.4f, stale, scratch, out.data());
+    for (size_t c = 0; c < out.size(); ++c)
+    {
+        REQUIRE(Near(out[c], expected[c]));
+    }
+}
+
+TEST_CASE("KeyframeSampler FindKey matches a linear scan from any hint", "[KeyframeSampler]")
+{
+    std::mt19937 rng(7);
+    for (int keys : { 1, 2, 3, 64, 1000 })
+    {
+        std::vector<float> times = UnevenTimes(keys, rng);
+        KeyframeSampler sampler;
+        sampler.AddChannel(TargetPath::TRANSLATION, InterpolationType::LINEAR, times, std::vector<glm::vec4>(times.size(), glm::vec4(1.0f)));
+
+        std::uniform_real_distribution<float> time(-0.5f, times.back() + 0.5f);
+        std::uniform_int_distribution<size_t> hint(0, times.size() + 3);
+        for (int i = 0; i < 2000; ++i)
+        {
+            float t = i % 10 == 0 ? times[i % times.size()] : time(rng);
+            size_t h = hint(rng);
+            REQUIRE(sampler.FindKey(0, t, h) == LinearFindKey(times, t, h));
+        }
+    }
+}
+
+TEST_CASE("KeyframeSampler channels with the same key times share a timeline", "[KeyframeSampler]")
+{
+    // MakeMixedSampler spaces keys five different ways
+    KeyframeSampler sampler = MakeMixedSampler(27, 40);
+    REQUIRE(sampler.TimelineCount() == 5);
+    REQUIRE(sampler.GetTimeline(0) == sampler.GetTimeline(5));
+    REQUIRE(sampler.GetTimeline(0) != sampler.GetTimeline(1));
+
+    sampler.AddChannel(TargetPath::SCALE, InterpolationType::LINEAR, {}, {});
+    sampler.AddChannel(TargetPath::SCALE, InterpolationType::STEP, {}, {});
+    REQUIRE(sampler.TimelineCount() == 6);
+
+    // a seek moves every cursor to where a search from scratch lands
+    std::vector<size_t> cursors;
+    for (float t : { 0.5f, 1.9f, 0.01f, 1.2f, -1.0f, 10.0f })
+    {
+        sampler.Seek(t, cursors);
+        REQUIRE(cursors.size() == sampler.ChannelCount());
+        for (size_t c = 0; c < sampler.ChannelCount(); ++c)
+        {
+            REQUIRE(cursors[c] == sampler.FindKey(c, t));
+        }
+    }
+}
+
+TEST_CASE("KeyframeSampler empty channels give a default value", "[KeyframeSampler]")
+{
+    KeyframeSampler sampler;
+    sampler.AddChannel(TargetPath::SCALE, InterpolationType::LINEAR, {}, {});
+    sampler.AddChannel(TargetPath::ROTATION, InterpolationType::LINEAR, {}, {});
+
+    glm::vec4 out[2];
+    KeyframeSampleScratch scratch;
+    sampler.Sample(1.0f, {}, scratch, out);
+    REQUIRE(std::isfinite(out[0].x));
+    REQUIRE(std::abs(glm::length(out[1]) - 1.0f) < 1e-5f);
+}
+
+TEST_CASE("KeyframeSampler channels per microsecond", "[KeyframeSampler][!benchmark]")
+{
+    // 60 channels is a CesiumMan sized skeleton with translation, rotation and scale on every joint
+    constexpr int Channels = 60;
+    KeyframeSampler sampler = MakeMixedSampler(Channels, 60);
+    KeyframeSampleScratch scratch;
+    std::vector<glm::vec4> out(Channels);
+    std::vector<size_t> hints(Channels, 0);
+
+    BENCHMARK("Scalar reference (60 channels)")
+    {
+        sampler.SampleScalar(0.77f, hints, out.data());
+        return out[0].x;
+    };
+
+    BENCHMARK("SIMD passes (60 channels)")
+    {
+        sampler.Sample(0.77f, hints, scratch, out.data());
+        return out[0].x;
+    };
+
+    constexpr int Frames = 20000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < Frames; ++frame)
+    {
+        sampler.Sample(std::fmod(frame * 0.016f, 1.8f), hints, scratch, out.data());
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "KeyframeSampler: " << (static_cast<double>(Channels) * Frames) / us << " channels/us" << std::endl;
+}
+
+TEST_CASE("KeyframeSampler key search", "[KeyframeSampler][!benchmark]")
+{
+    // a long clip (a cutscene or mocap take) is where walking the keys hurts
+    constexpr int Channels = 60;
+    constexpr int Keys = 4000;
+    std::mt19937 rng(3);
+    std::vector<float> times = UnevenTimes(Keys, rng);
+    float duration = times.back();
+
+    KeyframeSampler sampler;
+    std::vector<std::vector<float>> channelTimes;
+    for (int c = 0; c < Channels; ++c)
+    {
+        sampler.AddChannel(TargetPath::TRANSLATION, InterpolationType::LINEAR, times, std::vector<glm::vec4>(Keys, glm::vec4(0.0f)));
+        channelTimes.push_back(times);
+    }
+
+    std::uniform_real_distribution<float> random(0.0f, duration);
+    std::vector<float> seeks(1024);
+    for (float& t : seeks) t = random(rng);
+
+    std::vector<size_t> linear(Channels, 0), galloping(Channels, 0);
+    size_t frame = 0;
+
+    BENCHMARK("Sequential playback, linear walk (60 channels)")
+    {
+        float t = std::fmod(++frame * 0.016f, duration);
+        for (int c = 0; c < Channels; ++c) linear[c] = LinearFindKey(channelTimes[c], t, linear[c]);
+        return linear[0];
+    };
+
+    BENCHMARK("Sequential playback, Seek (60 channels)")
+    {
+        sampler.Seek(std::fmod(++frame * 0.016f, duration), galloping);
+        return galloping[0];
+    };
+
+    BENCHMARK("Random seek, linear walk (60 channels)")
+    {
+        float t = seeks[++frame & 1023];
+        for (int c = 0; c < Channels; ++c) linear[c] = LinearFindKey(channelTimes[c], t, linear[c]);
+        return linear[0];
+    };
+
+    BENCHMARK("Random seek, Seek (60 channels)")
+    {
+        sampler.Seek(seeks[++frame & 1023], galloping);
+        return galloping[0];
+    };
+
+    BENCHMARK("Random seek, Seek without a shared timeline (1 channel)")
+    {
+        return sampler.FindKey(0, seeks[++frame & 1023], galloping[0]);
+    };
+
+    constexpr int Iterations = 20000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < Iterations; ++i)
+    {
+        float t = seeks[i & 1023];
+        for (int c = 0; c < Channels; ++c) linear[c] = LinearFindKey(channelTimes[c], t, linear[c]);
+    }
+    double linearUs = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < Iterations; ++i)
+    {
+        sampler.Seek(seeks[i & 1023], galloping);
+    }
+    double seekUs = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "Random seek: linear " << linearUs / Iterations << " us, Seek " << seekUs / Iterations << " us per pose ("
+        << (galloping[0] == linear[0] ? "same keys" : "KEYS DIFFER") << ")" << std::endl;
+}
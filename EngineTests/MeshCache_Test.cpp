@@ -0,0 +1,335 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "MeshCache.h"
+#include "AnimData.h"
+#include "JobSystem.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // Owns the geometry and pixels the scene's views point at, like GLBLoader's prepared submeshes
+    struct TestScene
+    {
+        GLBScene scene;
+        std::vector<std::vector<std::byte>> vertices;
+        std::vector<std::vector<uint32_t>> indices;
+        std::vector<unsigned char> pixels;
+        std::unique_ptr<Animation> animation;
+    };
+
+    void AddSubMesh(TestScene& test, GLBMeshDesc& mesh, int material, VertexAttribKey key, size_t vertexBytes, size_t indexCount, uint8_t tag)
+    {
+        test.vertices.emplace_back(vertexBytes, static_cast<std::byte>(tag));
+        test.indices.emplace_back(indexCount);
+        for (size_t i = 0; i < indexCount; ++i) test.indices.back()[i] = static_cast<uint32_t>(i * tag);
+
+        GLBSubMeshView view;
+        view.materialIndex = material;
+        view.attribKey = key;
+        view.aabb = { glm::vec3(-1.0f * tag), glm::vec3(1.0f * tag) };
+        view.vertices = test.vertices.back().data();
+        view.vertexBytes = vertexBytes;
+        view.indices = test.indices.back().data();
+        view.indexCount = indexCount;
+        mesh.submeshes.push_back(view);
+    }
+
+    std::unique_ptr<TestScene> MakeScene()
+    {
+        auto test = std::make_unique<TestScene>();
+        test->vertices.reserve(8);
+        test->indices.reserve(8);
+        auto& scene = test->scene;
+
+        scene.rootNodes = { 0 };
+        scene.nodes.resize(3);
+        scene.nodes[0].name = "Root";
+        scene.nodes[0].children = { 1, 2 };
+        scene.nodes[1].name = "Body";
+        scene.nodes[1].mesh = 0;
+        scene.nodes[1].skin = 0;
+        scene.nodes[1].translation = glm::vec3(1.0f, 2.0f, 3.0f);
+        scene.nodes[2].name = "Lamp";
+        scene.nodes[2].light = 0;
+        scene.nodes[2].scale = glm::vec3(2.0f);
+
+        // two submeshes share an attribute key, so a blob, and one has its own
+        scene.meshes.resize(2);
+        scene.meshes[0].name = "BodyMesh";
+        scene.meshes[0].prepared = true;
+        AddSubMesh(*test, scene.meshes[0], 0, 15, 48 * 3, 6, 1);
+        AddSubMesh(*test, scene.meshes[0], -1, 15, 48 * 5, 9, 2);
+        AddSubMesh(*test, scene.meshes[0], 0, 7, 36 * 4, 3, 3);
+        scene.meshes[1].name = "NotReached";
+
+        GLBSkinDesc skin;
+        skin.name = "Skeleton";
+        skin.joints = { 0, 1 };
+        skin.inverseBindMatrices = { glm::mat4(1.0f), glm::mat4(2.0f) };
+        scene.skins.push_back(skin);
+
+        scene.hasLights = true;
+        GLBLightDesc light;
+        light.type = "spot";
+        light.intensity = 20.0f;
+        light.outerConeAngle = 0.5f;
+        scene.lights.push_back(light);
+
+        GLBMaterialDesc material;
+        material.name = "Skin";
+        material.baseColorFactor = glm::vec4(0.5f, 0.25f, 1.0f, 1.0f);
+        material.alphaMode = "MASK";
+        material.baseColorTexture = 0;
+        scene.materials.push_back(material);
+
+        test->pixels.resize(4 * 4 * 4);
+        for (size_t i = 0; i < test->pixels.size(); ++i) test->pixels[i] = static_cast<unsigned char>(i);
+        scene.textureImages = { 0 };
+        GLBImageView image;
+        image.width = 4;
+        image.height = 4;
+        image.component = 4;
+        image.pixels = test->pixels.data();
+        image.size = test->pixels.size();
+        scene.images.push_back(image);
+
+        test->animation = std::make_unique<Animation>("Anim_Body_idx:0");
+        for (int path = 0; path < 2; ++path)
+        {
+            AnimationSampler sampler;
+            sampler.SetTimes({ 0.0f, 0.5f, 1.0f });
+            if (path == TargetPath::ROTATION)
+                sampler.SetValues({ glm::vec4(0, 0, 0, 1), glm::vec4(0, 0.7071f, 0, 0.7071f), glm::vec4(0, 1, 0, 0) });
+            else
+                sampler.SetValues({ glm::vec4(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(2.0f, 0.0f, 0.0f, 0.0f) });
+            test->animation->AddSampler(sampler);
+
+            AnimationChannel channel(path, 1, static_cast<TargetPath>(path));
+            std::string nodeName = "Body";
+            channel.SetNodeName(nodeName);
+            channel.UpdateTargetNode(path);
+            test->animation->AddChannel(channel);
+        }
+        test->animation->PrecomputeSamplers();
+        test->animation->CalcDuration();
+
+        KeyframeSampler keyframes = test->animation->GetKeyframes();
+        keyframes.Quantize();
+        test->animation->SetKeyframes(std::move(keyframes));
+        test->animation->ReleaseSourceKeys();
+        return test;
+    }
+
+    std::filesystem::path TestCacheFolder()
+    {
+        auto folder = std::filesystem::temp_directory_path() / "jlengine_mesh_cache_test";
+        std::filesystem::remove_all(folder);
+        std::filesystem::create_directories(folder);
+        return folder;
+    }
+}
+
+TEST_CASE("MeshCache reads back the scene it wrote", "[MeshCache]")
+{
+    auto test = MakeScene();
+    auto folder = TestCacheFolder();
+    auto path = MeshCache::CachePath(folder.string(), "Models/Body.glb", 1234);
+    REQUIRE(std::filesystem::path(path).filename().string() == "Body_1234.jlmesh");
+
+    REQUIRE(MeshCache::Write(path, 1234, test->scene, { test->animation.get() }));
+
+    MeshCache cache;
+    REQUIRE(cache.Open(path, 1234));
+    auto& scene = cache.GetScene();
+
+    REQUIRE(scene.rootNodes == test->scene.rootNodes);
+    REQUIRE(scene.nodes.size() == 3);
+    REQUIRE(scene.nodes[0].children == std::vector<int>{ 1, 2 });
+    REQUIRE(scene.nodes[1].name == "Body");
+    REQUIRE(scene.nodes[1].mesh == 0);
+    REQUIRE(scene.nodes[1].skin == 0);
+    REQUIRE(scene.nodes[1].translation == glm::vec3(1.0f, 2.0f, 3.0f));
+    REQUIRE(scene.nodes[2].light == 0);
+    REQUIRE(scene.nodes[2].scale == glm::vec3(2.0f));
+
+    // every submesh's ranges come back byte for byte, straight out of the mapping
+    REQUIRE(scene.meshes.size() == 2);
+    REQUIRE(scene.meshes[0].prepared);
+    REQUIRE_FALSE(scene.meshes[1].prepared);
+    REQUIRE(scene.meshes[0].submeshes.size() == 3);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const auto& expected = test->scene.meshes[0].submeshes[i];
+        const auto& submesh = scene.meshes[0].submeshes[i];
+        REQUIRE(submesh.materialIndex == expected.materialIndex);
+        REQUIRE(submesh.attribKey == expected.attribKey);
+        REQUIRE(submesh.aabb.max == expected.aabb.max);
+        REQUIRE(submesh.vertexBytes == expected.vertexBytes);
+        REQUIRE(submesh.indexCount == expected.indexCount);
+        REQUIRE(std::memcmp(submesh.vertices, expected.vertices, expected.vertexBytes) == 0);
+        REQUIRE(std::memcmp(submesh.indices, expected.indices, expected.indexCount * sizeof(uint32_t)) == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(submesh.indices) % alignof(uint32_t) == 0);
+    }
+    // the first two share their key's blob
+    REQUIRE(scene.meshes[0].submeshes[1].vertices == scene.meshes[0].submeshes[0].vertices + 48 * 3);
+
+    REQUIRE(scene.skins.size() == 1);
+    REQUIRE(scene.skins[0].joints == std::vector<int>{ 0, 1 });
+    REQUIRE(scene.skins[0].inverseBindMatrices[1] == glm::mat4(2.0f));
+
+    REQUIRE(scene.hasLights);
+    REQUIRE(scene.lights[0].type == "spot");
+    REQUIRE(scene.lights[0].outerConeAngle == 0.5f);
+
+    REQUIRE(scene.materials.size() == 1);
+    REQUIRE(scene.materials[0].name == "Skin");
+    REQUIRE(scene.materials[0].baseColorFactor == glm::vec4(0.5f, 0.25f, 1.0f, 1.0f));
+    REQUIRE(scene.materials[0].alphaMode == "MASK");
+    REQUIRE(scene.materials[0].baseColorTexture == 0);
+    REQUIRE(scene.materials[0].normalTexture == -1);
+
+    REQUIRE(scene.textureImages == std::vector<int>{ 0 });
+    REQUIRE(scene.images[0].width == 4);
+    REQUIRE(scene.images[0].size == test->pixels.size());
+    REQUIRE(std::memcmp(scene.images[0].pixels, test->pixels.data(), test->pixels.size()) == 0);
+
+    // the compressed keyframes and retargeted channels load as they were
+    auto& animations = cache.GetAnimations();
+    REQUIRE(animations.size() == 1);
+    REQUIRE(animations[0].name == "Anim_Body_idx:0");
+    REQUIRE(animations[0].duration == test->animation->GetDuration());
+    REQUIRE(animations[0].channels.size() == 2);
+    REQUIRE(animations[0].channels[1].updated);
+    REQUIRE(animations[0].channels[1].targetNode == 1);
+    REQUIRE(animations[0].channels[1].path == TargetPath::ROTATION);
+    REQUIRE(animations[0].channels[1].nodeName == "Body");
+    REQUIRE(animations[0].keyframes.Fingerprint() == test->animation->GetKeyframes().Fingerprint());
+    REQUIRE(animations[0].keyframes.GetKeyFormat(1) == KeyFormat::Rotation48);
+
+    cache.Close();
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("MeshCache rejects stale and damaged files", "[MeshCache]")
+{
+    auto test = MakeScene();
+    auto folder = TestCacheFolder();
+    auto path = (folder / "Body_1.jlmesh").string();
+    REQUIRE(MeshCache::Write(path, 1, test->scene, { test->animation.get() }));
+
+    MeshCache cache;
+    REQUIRE_FALSE(cache.Open(path, 2));
+    REQUIRE_FALSE(cache.Open((folder / "Missing.jlmesh").string(), 1));
+
+    // cut into the pixel blob
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+    REQUIRE_FALSE(cache.Open(path, 1));
+    REQUIRE(cache.GetScene().meshes.empty());
+
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("MeshCache source hash follows the file and the settings", "[MeshCache]")
+{
+    auto folder = TestCacheFolder();
+    auto path = (folder / "Source.glb").string();
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "glTF and some bytes that are not a multiple of eight";
+    }
+
+    uint64_t hash = MeshCache::HashSource(path, 0);
+    REQUIRE(hash != 0);
+    REQUIRE(MeshCache::HashSource(path, 0) == hash);
+    REQUIRE(MeshCache::HashSource(path, 1) != hash);
+    REQUIRE(MeshCache::HashSource((folder / "Missing.glb").string(), 0) == 0);
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file << "!";
+    }
+    REQUIRE(MeshCache::HashSource(path, 0) != hash);
+
+    std::filesystem::remove_all(folder);
+}
+
+TEST_CASE("MeshCache load time against importing the Assets folder", "[MeshCache][!benchmark]")
+{
+    std::filesystem::path assets;
+    for (const char* path : { "../Assets", "Assets", "../../Assets" })
+    {
+        if (std::filesystem::exists(std::filesystem::path(path) / "Duck.glb"))
+            assets = path;
+    }
+    if (assets.empty())
+    {
+        WARN("Assets folder not found, skipping");
+        return;
+    }
+
+    // cook every file's images and materials, the geometry needs the GL side of GLBLoader
+    auto folder = TestCacheFolder();
+    std::vector<std::string> sources, caches;
+    for (const auto& entry : std::filesystem::directory_iterator(assets))
+    {
+        if (entry.path().extension() != ".glb") continue;
+
+        GLBImporter importer;
+        std::string err, warn;
+        if (!importer.Load(entry.path().string(), JobSystem::Global(), err, warn)) continue;
+        importer.ParseMaterials(JobSystem::Global());
+        importer.BuildScene();
+
+        auto path = MeshCache::CachePath(folder.string(), entry.path().string(), 1);
+        if (MeshCache::Write(path, 1, importer.GetScene(), {}))
+        {
+            sources.push_back(entry.path().string());
+            caches.push_back(path);
+        }
+    }
+
+    BENCHMARK("Import Assets")
+    {
+        size_t bytes = 0;
+        for (const auto& source : sources)
+        {
+            GLBImporter importer;
+            std::string err, warn;
+            if (importer.Load(source, JobSystem::Global(), err, warn))
+            {
+                for (const auto& image : importer.GetModel().images)
+                    bytes += image.image.size();
+            }
+        }
+        return bytes;
+    };
+
+    BENCHMARK("Open mesh caches")
+    {
+        size_t bytes = 0;
+        for (const auto& cache : caches)
+        {
+            MeshCache meshCache;
+            if (meshCache.Open(cache, 1))
+            {
+                // the copy texture creation makes, which is what faults the pages in
+                for (const auto& image : meshCache.GetScene().images)
+                {
+                    std::vector<unsigned char> pixels(image.pixels, image.pixels + image.size);
+                    bytes += pixels.size();
+                }
+            }
+        }
+        return bytes;
+    };
+
+    std::filesystem::remove_all(folder);
+}
@@ -0,0 +1,185 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // position and a uv, enough bytes past the position to catch a vertex swapped for its neighbour
+    constexpr uint32_t Stride = sizeof(float) * 5;
+
+    struct TestMesh
+    {
+        std::vector<std::byte> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    void AddVertex(std::vector<std::byte>& vertices, float x, float y, float z)
+    {
+        float v[5] = { x, y, z, x * 0.1f, y * 0.1f };
+        const std::byte* bytes = reinterpret_cast<const std::byte*>(v);
+        vertices.insert(vertices.end(), bytes, bytes + Stride);
+    }
+
+    // A welded grid of quads with the rows bent into a half cylinder so the clusters face different ways
+    TestMesh MakeGrid(int width, int height)
+    {
+        TestMesh mesh;
+        for (int y = 0; y <= height; ++y)
+        {
+            for (int x = 0; x <= width; ++x)
+            {
+                float angle = 3.14159265f * y / height;
+                AddVertex(mesh.vertices, static_cast<float>(x), std::cos(angle), std::sin(angle));
+            }
+        }
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                uint32_t i0 = y * (width + 1) + x;
+                uint32_t i1 = i0 + 1;
+                uint32_t i2 = i0 + width + 1;
+                uint32_t i3 = i2 + 1;
+                mesh.indices.insert(mesh.indices.end(), { i0, i2, i1, i1, i2, i3 });
+            }
+        }
+        return mesh;
+    }
+
+    // Every triangle gets its own three vertices, as a glTF exported without indices has
+    TestMesh Unweld(const TestMesh& mesh)
+    {
+        TestMesh unwelded;
+        for (uint32_t index : mesh.indices)
+        {
+            unwelded.vertices.insert(unwelded.vertices.end(), mesh.vertices.begin() + index * Stride, mesh.vertices.begin() + (index + 1) * Stride);
+            unwelded.indices.push_back(static_cast<uint32_t>(unwelded.indices.size()));
+        }
+        return unwelded;
+    }
+
+    void ShuffleTriangles(TestMesh& mesh, uint32_t seed)
+    {
+        std::vector<uint32_t> order(mesh.indices.size() / 3);
+        for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::shuffle(order.begin(), order.end(), std::mt19937(seed));
+
+        std::vector<uint32_t> shuffled;
+        for (uint32_t t : order)
+        {
+            shuffled.insert(shuffled.end(), mesh.indices.begin() + t * 3, mesh.indices.begin() + t * 3 + 3);
+        }
+        mesh.indices = std::move(shuffled);
+    }
+
+    // Each triangle as the bytes of its three vertices, rotated to start at the smallest so the
+    // winding is kept but the starting corner doesn't matter, then sorted
+    std::vector<std::string> TriangleSet(const TestMesh& mesh)
+    {
+        std::vector<std::string> triangles;
+        for (size_t t = 0; t < mesh.indices.size() / 3; ++t)
+        {
+            std::string corners[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                const char* vertex = reinterpret_cast<const char*>(mesh.vertices.data()) + mesh.indices[t * 3 + c] * Stride;
+                corners[c].assign(vertex, Stride);
+            }
+            int first = static_cast<int>(std::min_element(corners, corners + 3) - corners);
+            triangles.push_back(corners[first] + corners[(first + 1) % 3] + corners[(first + 2) % 3]);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
+
+TEST_CASE("Optimizing keeps every triangle and its winding", "[MeshOptimizer]")
+{
+    TestMesh mesh = MakeGrid(24, 24);
+    ShuffleTriangles(mesh, 7);
+    auto before = TriangleSet(mesh);
+
+    MeshOptimizationStats stats = MeshOptimizer::Optimize(mesh.vertices, Stride, mesh.indices);
+
+    REQUIRE(stats.triangles == 24 * 24 * 2);
+    REQUIRE(mesh.indices.size() == before.size() * 3);
+    REQUIRE(mesh.vertices.size() == stats.verticesAfter * Stride);
+    REQUIRE(TriangleSet(mesh) == before);
+}
+
+TEST_CASE("Identical vertices are merged", "[MeshOptimizer]")
+{
+    TestMesh welded = MakeGrid(8, 8);
+    TestMesh mesh = Unweld(welded);
+    auto before = TriangleSet(mesh);
+
+    MeshOptimizationStats stats = MeshOptimizer::Optimize(mesh.vertices, Stride, mesh.indices);
+
+    REQUIRE(stats.verticesBefore == 8 * 8 * 6);
+    REQUIRE(stats.verticesAfter == welded.vertices.size() / Stride);
+    REQUIRE(TriangleSet(mesh) == before);
+}
+
+TEST_CASE("Cache misses drop on a shuffled mesh", "[MeshOptimizer]")
+{
+    TestMesh mesh = MakeGrid(32, 32);
+    ShuffleTriangles(mesh, 42);
+
+    MeshOptimizationStats stats = MeshOptimizer::Optimize(mesh.vertices, Stride, mesh.indices);
+
+    // the after numbers have to be measured on the final order
+    REQUIRE(stats.missesAfter == MeshOptimizer::CountCacheMisses(mesh.indices, stats.verticesAfter));
+
+    // a shuffled grid misses nearly every index, a good order gets well under one vertex a triangle
+    REQUIRE(stats.AcmrBefore() > 2.0f);
+    REQUIRE(stats.AcmrAfter() < 0.8f);
+    REQUIRE(stats.AtvrAfter() < 1.5f);
+}
+
+TEST_CASE("Vertices are stored in the order they are first used", "[MeshOptimizer]")
+{
+    TestMesh mesh = MakeGrid(6, 6);
+    ShuffleTriangles(mesh, 3);
+    // a vertex no triangle uses
+    AddVertex(mesh.vertices, 100.0f, 100.0f, 100.0f);
+
+    MeshOptimizationStats stats = MeshOptimizer::Optimize(mesh.vertices, Stride, mesh.indices);
+    REQUIRE(stats.verticesAfter == 7 * 7);
+
+    uint32_t next = 0;
+    for (uint32_t index : mesh.indices)
+    {
+        REQUIRE(index <= next);
+        if (index == next) ++next;
+    }
+    REQUIRE(next == stats.verticesAfter);
+}
+
+TEST_CASE("Lists that aren't whole triangles are left alone", "[MeshOptimizer]")
+{
+    TestMesh mesh = MakeGrid(2, 2);
+    mesh.indices.pop_back();
+    TestMesh original = mesh;
+
+    MeshOptimizationStats stats = MeshOptimizer::Optimize(mesh.vertices, Stride, mesh.indices);
+
+    REQUIRE(stats.missesAfter == 0);
+    REQUIRE(mesh.indices == original.indices);
+    REQUIRE(mesh.vertices == original.vertices);
+
+    // and so are indices past the end of the vertices
+    mesh = MakeGrid(2, 2);
+    mesh.indices[4] = 1000;
+    original = mesh;
+    MeshOptimizer::Optimize(mesh.vertices, Stride, mesh.indices);
+    REQUIRE(mesh.indices == original.indices);
+}
@@ -0,0 +1,259 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cmath>
+#include <vector>
+
+#include "ImageConversion.h"
+#include "JobSystem.h"
+#include "MipGenerator.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    std::vector<uint8_t> Constant(uint32_t width, uint32_t height, int channels, uint8_t value)
+    {
+        return std::vector<uint8_t>(static_cast<size_t>(width) * height * channels, value);
+    }
+
+    // Vertical stripes one texel wide, black and white
+    std::vector<uint8_t> Stripes(uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height);
+        for (uint32_t y = 0; y < height; ++y)
+            for (uint32_t x = 0; x < width; ++x)
+                pixels[y * width + x] = (x & 1) ? 255 : 0;
+        return pixels;
+    }
+
+    // Random-ish alpha so the box filter pulls most texels towards the middle
+    std::vector<uint8_t> Foliage(uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4, 128);
+        uint32_t state = 12345;
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            pixels[i * 4 + 3] = (state >> 24) < 90 ? 255 : 0;
+        }
+        return pixels;
+    }
+
+    float Coverage(const MipChain& chain, size_t level, float cutoff)
+    {
+        std::vector<float> rgba(chain.levels[level].size);
+        ImageConversion::UnormToFloat(chain.LevelData(level), rgba.data(), rgba.size());
+        return MipGenerator::AlphaCoverage(rgba.data(), rgba.size() / 4, cutoff, 1.0f);
+    }
+}
+
+TEST_CASE("Mip chains go down to 1x1 packed level after level", "[MipGenerator]")
+{
+    REQUIRE(MipGenerator::MipCount(1, 1) == 1);
+    REQUIRE(MipGenerator::MipCount(256, 256) == 9);
+    REQUIRE(MipGenerator::MipCount(300, 20) == 9);
+
+    auto pixels = Constant(37, 10, 3, 40);
+    auto chain = MipGenerator::Generate(pixels.data(), 37, 10, 3, MipSettings());
+    REQUIRE(chain.channels == 3);
+    REQUIRE(chain.levels.size() == 6);
+
+    const uint32_t widths[] = { 37, 18, 9, 4, 2, 1 };
+    const uint32_t heights[] = { 10, 5, 2, 1, 1, 1 };
+    size_t offset = 0;
+    for (size_t level = 0; level < chain.levels.size(); ++level)
+    {
+        REQUIRE(chain.levels[level].width == widths[level]);
+        REQUIRE(chain.levels[level].height == heights[level]);
+        REQUIRE(chain.levels[level].offset == offset);
+        REQUIRE(chain.levels[level].size == widths[level] * heights[level] * 3);
+        offset += chain.levels[level].size;
+    }
+    REQUIRE(chain.pixels.size() == offset);
+    // the top level is the source as it is
+    REQUIRE(std::equal(pixels.begin(), pixels.end(), chain.pixels.begin()));
+}
+
+TEST_CASE("Both filters keep a constant image constant", "[MipGenerator]")
+{
+    for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+    {
+        for (bool srgb : { false, true })
+        {
+            MipSettings settings;
+            settings.filter = filter;
+            settings.srgb = srgb;
+            settings.wrap = filter == MipFilter::Kaiser;
+
+            auto pixels = Constant(64, 16, 4, 77);
+            auto chain = MipGenerator::Generate(pixels.data(), 64, 16, 4, settings);
+            for (uint8_t value : chain.pixels)
+                REQUIRE(value == 77);
+        }
+    }
+}
+
+TEST_CASE("sRGB textures are averaged in linear light", "[MipGenerator]")
+{
+    auto pixels = Stripes(8, 8);
+    MipSettings settings;
+    settings.filter = MipFilter::Box;
+
+    auto linear = MipGenerator::Downsample(pixels.data(), 8, 8, 1, settings);
+    settings.srgb = true;
+    auto srgb = MipGenerator::Downsample(pixels.data(), 8, 8, 1, settings);
+
+    REQUIRE(linear.size() == 16);
+    for (size_t i = 0; i < linear.size(); ++i)
+    {
+        REQUIRE(linear[i] == 128);
+        // half of white in linear light is 188 in sRGB
+        REQUIRE(srgb[i] == 188);
+    }
+
+    // the Kaiser filter reaches past the pair and smooths the stripes into the same grey
+    settings.filter = MipFilter::Kaiser;
+    settings.srgb = false;
+    auto kaiser = MipGenerator::Downsample(pixels.data(), 8, 8, 1, settings);
+    for (uint8_t value : kaiser)
+        REQUIRE(std::abs(value - 128) <= 1);
+}
+
+TEST_CASE("Normal maps stay unit length down the chain", "[MipGenerator]")
+{
+    // a ridge, half the texels lean left and half lean right
+    const uint32_t size = 16;
+    std::vector<uint8_t> pixels(size * size * 3);
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            uint8_t* texel = &pixels[(y * size + x) * 3];
+            texel[0] = (x & 1) ? 218 : 37;
+            texel[1] = 128;
+            texel[2] = 218;
+        }
+    }
+
+    MipSettings settings;
+    settings.normalMap = true;
+    auto chain = MipGenerator::Generate(pixels.data(), size, size, 3, settings);
+    for (size_t level = 1; level < chain.levels.size(); ++level)
+    {
+        const uint8_t* data = chain.LevelData(level);
+        for (size_t i = 0; i < chain.levels[level].size; i += 3)
+        {
+            float x = data[i] / 255.0f * 2.0f - 1.0f;
+            float y = data[i + 1] / 255.0f * 2.0f - 1.0f;
+            float z = data[i + 2] / 255.0f * 2.0f - 1.0f;
+            REQUIRE(std::sqrt(x * x + y * y + z * z) == Catch::Approx(1.0f).margin(0.02f));
+            // the average of the two tilts points straight up
+            REQUIRE(z > 0.98f);
+        }
+    }
+}
+
+TEST_CASE("Alpha tested textures keep their coverage", "[MipGenerator]")
+{
+    const uint32_t size = 64;
+    const float cutoff = 0.5f;
+    auto pixels = Foliage(size, size);
+
+    MipSettings settings;
+    settings.filter = MipFilter::Box;
+    auto plain = MipGenerator::Generate(pixels.data(), size, size, 4, settings);
+    settings.alphaCutoff = cutoff;
+    auto preserved = MipGenerator::Generate(pixels.data(), size, size, 4, settings);
+
+    float top = Coverage(preserved, 0, cutoff);
+    REQUIRE(top == Coverage(plain, 0, cutoff));
+    REQUIRE(top > 0.2f);
+    REQUIRE(top < 0.5f);
+
+    // plain averaging drops most of the leaves a few levels down
+    REQUIRE(Coverage(plain, 3, cutoff) < top * 0.5f);
+    for (size_t level = 1; level + 2 < preserved.levels.size(); ++level)
+        REQUIRE(Coverage(preserved, level, cutoff) == Catch::Approx(top).margin(0.1f));
+
+    // colour is left alone
+    for (size_t i = 0; i < preserved.pixels.size(); i += 4)
+        REQUIRE(preserved.pixels[i] == 128);
+}
+
+TEST_CASE("Batches give the same chains as one at a time", "[MipGenerator]")
+{
+    auto stripes = Stripes(32, 8);
+    auto foliage = Foliage(16, 16);
+
+    std::vector<MipRequest> requests(2);
+    requests[0].pixels = stripes.data();
+    requests[0].width = 32;
+    requests[0].height = 8;
+    requests[0].channels = 1;
+    requests[1].pixels = foliage.data();
+    requests[1].width = 16;
+    requests[1].height = 16;
+    requests[1].channels = 4;
+    requests[1].settings.srgb = true;
+    requests[1].settings.alphaCutoff = 0.5f;
+
+    JobSystem jobs(2);
+    MipGenerator::Generate(requests, jobs);
+
+    for (const auto& request : requests)
+    {
+        auto serial = MipGenerator::Generate(request.pixels, request.width, request.height, request.channels, request.settings);
+        REQUIRE(request.chain.levels.size() == serial.levels.size());
+        REQUIRE(request.chain.pixels == serial.pixels);
+    }
+}
+
+TEST_CASE("Cache keys change with the settings", "[MipGenerator]")
+{
+    MipSettings settings;
+    uint64_t base = MipGenerator::CacheHash(1, 0, settings);
+    REQUIRE(base == MipGenerator::CacheHash(1, 0, settings));
+    REQUIRE(base != MipGenerator::CacheHash(2, 0, settings));
+    REQUIRE(base != MipGenerator::CacheHash(1, 1, settings));
+
+    MipSettings other = settings;
+    other.srgb = true;
+    REQUIRE(base != MipGenerator::CacheHash(1, 0, other));
+    other = settings;
+    other.filter = MipFilter::Box;
+    REQUIRE(base != MipGenerator::CacheHash(1, 0, other));
+    other = settings;
+    other.alphaCutoff = 0.5f;
+    REQUIRE(base != MipGenerator::CacheHash(1, 0, other));
+
+    REQUIRE(MipGenerator::CachePath("cache", base).find(".ktx2") != std::string::npos);
+}
+
+TEST_CASE("MipGenerator against 2x2 averaging", "[MipGenerator][!benchmark]")
+{
+    const uint32_t size = 1024;
+    std::vector<uint8_t> pixels(size * size * 4);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uint8_t>(i * 7 + (i >> 12));
+
+    MipSettings box;
+    box.filter = MipFilter::Box;
+    box.srgb = true;
+    MipSettings kaiser;
+    kaiser.srgb = true;
+
+    BENCHMARK("Box, 1024 RGBA sRGB")
+    {
+        return MipGenerator::Generate(pixels.data(), size, size, 4, box).pixels.size();
+    };
+    BENCHMARK("Kaiser, 1024 RGBA sRGB")
+    {
+        return MipGenerator::Generate(pixels.data(), size, size, 4, kaiser).pixels.size();
+    };
+    BENCHMARK("Kaiser, 1024 RGBA sRGB, job system")
+    {
+        return MipGenerator::Generate(pixels.data(), size, size, 4, kaiser, &JobSystem::Global()).pixels.size();
+    };
+}
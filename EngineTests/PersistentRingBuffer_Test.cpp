@@ -0,0 +1,253 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "PersistentRingBuffer.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // Stands in for GraphicsAPI, buffers are heap memory and each fence is signalled once the test
+    // has run enough "GPU frames" after it was issued
+    class MockGraphicsAPI
+    {
+    public:
+        void CreateNamedBuffer(uint32_t& id)
+        {
+            id = m_nextBuffer++;
+        }
+
+        void NamedBufferStorage(uint32_t id, size_t size, GLbitfield usageFlags, const void* data = nullptr)
+        {
+            storageFlags = usageFlags;
+            m_buffers[id].assign(size, std::byte{ 0 });
+        }
+
+        void* MapNamedBufferRange(uint32_t id, GLbitfield access, uint32_t offset, size_t length)
+        {
+            mapFlags = access;
+            return m_buffers[id].data() + offset;
+        }
+
+        void DisposeBuffer(uint32_t count, uint32_t* id)
+        {
+            for (uint32_t i = 0; i < count; ++i) m_buffers.erase(id[i]);
+            disposed += count;
+        }
+
+        GLsync FenceSync()
+        {
+            m_fences.push_back(std::make_unique<Fence>());
+            m_fences.back()->issuedFrame = gpuFrame;
+            fencesIssued++;
+            return reinterpret_cast<GLsync>(m_fences.back().get());
+        }
+
+        GLenum ClientWaitSync(GLsync sync, uint64_t timeoutNs)
+        {
+            auto fence = reinterpret_cast<Fence*>(sync);
+            waitCalls++;
+            if (fence->issuedFrame + gpuLatency <= gpuFrame) return GL_ALREADY_SIGNALED;
+            if (timeoutNs == 0) return GL_TIMEOUT_EXPIRED;
+
+            // a blocking wait lets the GPU catch up one frame per try
+            gpuFrame++;
+            return fence->issuedFrame + gpuLatency <= gpuFrame ? GL_CONDITION_SATISFIED : GL_TIMEOUT_EXPIRED;
+        }
+
+        void DeleteSync(GLsync sync)
+        {
+            reinterpret_cast<Fence*>(sync)->deleted = true;
+            fencesDeleted++;
+        }
+
+        const std::vector<std::byte>& Buffer(uint32_t id) { return m_buffers[id]; }
+        size_t LiveBuffers() const { return m_buffers.size(); }
+
+        // frames the GPU trails the CPU by before a fence signals
+        uint32_t gpuLatency = 0;
+        uint32_t gpuFrame = 0;
+
+        GLbitfield storageFlags = 0;
+        GLbitfield mapFlags = 0;
+        uint32_t fencesIssued = 0;
+        uint32_t fencesDeleted = 0;
+        uint32_t waitCalls = 0;
+        uint32_t disposed = 0;
+
+    private:
+        struct Fence
+        {
+            uint32_t issuedFrame = 0;
+            bool deleted = false;
+        };
+
+        uint32_t m_nextBuffer = 1;
+        std::map<uint32_t, std::vector<std::byte>> m_buffers;
+        std::vector<std::unique_ptr<Fence>> m_fences;
+    };
+
+    using TestRing = PersistentRingBuffer<MockGraphicsAPI>;
+
+    // One CPU frame that writes size bytes, the GPU advances a frame when it's submitted
+    void RunFrame(TestRing& ring, MockGraphicsAPI& api, size_t size)
+    {
+        ring.BeginFrame();
+        if (size > 0) ring.Allocate(size);
+        ring.EndFrame();
+        api.gpuFrame++;
+    }
+}
+
+TEST_CASE("PersistentRingBuffer maps one persistent buffer split into partitions", "[PersistentRingBuffer]")
+{
+    MockGraphicsAPI api;
+    TestRing ring(3);
+    REQUIRE(ring.Create(&api, 1000, 256));
+
+    REQUIRE(ring.GetBytesPerFrame() == 1024);
+    REQUIRE(ring.GetGPUBuffer().GetSizeInBytes() == 3 * 1024);
+    REQUIRE(ring.GetGPUBuffer().IsPersistentlyMapped());
+    REQUIRE((api.storageFlags & GL_MAP_PERSISTENT_BIT) != 0);
+    REQUIRE((api.mapFlags & GL_MAP_COHERENT_BIT) != 0);
+
+    // each frame writes into the next partition and wraps after frameCount frames
+    std::vector<size_t> offsets;
+    for (int frame = 0; frame < 4; ++frame)
+    {
+        ring.BeginFrame();
+        offsets.push_back(ring.Allocate(16).offset);
+        ring.EndFrame();
+    }
+    REQUIRE(offsets == std::vector<size_t>{ 1024, 2048, 0, 1024 });
+
+    ring.Dispose();
+    REQUIRE(api.LiveBuffers() == 0);
+    REQUIRE(api.fencesDeleted == api.fencesIssued);
+}
+
+TEST_CASE("PersistentRingBuffer aligns allocations and rejects overflow", "[PersistentRingBuffer]")
+{
+    MockGraphicsAPI api;
+    TestRing ring(2);
+    ring.Create(&api, 1024, 256);
+    ring.BeginFrame();
+    size_t base = static_cast<size_t>(ring.GetCurrentPartition()) * ring.GetBytesPerFrame();
+
+    auto a = ring.Allocate(10);
+    auto b = ring.Allocate(300);
+    auto c = ring.Allocate(200);
+    REQUIRE(a.offset == base);
+    REQUIRE(b.offset == base + 256);
+    REQUIRE(c.offset == base + 768);
+    REQUIRE(ring.GetStats().frameBytes == 968);
+
+    // data written through the pointer is what the GPU sees at the bind offset
+    const uint32_t value = 0xABCD1234;
+    auto d = ring.Upload(&value, sizeof(value));
+    REQUIRE_FALSE(d); // 968 aligned up leaves no room
+    REQUIRE(ring.GetStats().overflows == 1);
+
+    ring.EndFrame();
+    ring.BeginFrame();
+    auto e = ring.Upload(&value, sizeof(value));
+    REQUIRE(e);
+    uint32_t readBack = 0;
+    std::memcpy(&readBack, api.Buffer(e.bufferID).data() + e.offset, sizeof(readBack));
+    REQUIRE(readBack == value);
+
+    REQUIRE_FALSE(ring.Allocate(0));
+    REQUIRE(ring.GetStats().peakFrameBytes == 968);
+}
+
+TEST_CASE("PersistentRingBuffer only waits when the GPU is behind", "[PersistentRingBuffer]")
+{
+    MockGraphicsAPI api;
+    TestRing ring(3);
+    ring.Create(&api, 256, 256);
+
+    // the GPU keeps up, fences are found signalled with a zero timeout poll
+    for (int frame = 0; frame < 10; ++frame) RunFrame(ring, api, 64);
+    REQUIRE(ring.GetStats().fenceWaits == 0);
+    REQUIRE(api.fencesIssued == 10);
+    // a fence is released when its partition comes round again, one is left per partition
+    REQUIRE(api.fencesIssued - api.fencesDeleted == ring.GetFrameCount());
+
+    // the GPU falls further behind than the ring is deep, coming back round has to block
+    api.gpuLatency = 5;
+    for (int frame = 0; frame < 6; ++frame) RunFrame(ring, api, 64);
+    REQUIRE(ring.GetStats().fenceWaits > 0);
+    REQUIRE(api.fencesIssued - api.fencesDeleted <= ring.GetFrameCount());
+}
+
+TEST_CASE("PersistentRingBuffer skips the fence for an empty frame", "[PersistentRingBuffer]")
+{
+    MockGraphicsAPI api;
+    TestRing ring(2);
+    ring.Create(&api, 256, 256);
+
+    RunFrame(ring, api, 0);
+    RunFrame(ring, api, 0);
+    REQUIRE(api.fencesIssued == 0);
+
+    RunFrame(ring, api, 32);
+    REQUIRE(api.fencesIssued == 1);
+}
+
+TEST_CASE("PersistentRingBuffer reserve drains the fences before reallocating", "[PersistentRingBuffer]")
+{
+    MockGraphicsAPI api;
+    TestRing ring(3);
+    ring.Create(&api, 256, 256);
+    api.gpuLatency = 2;
+
+    RunFrame(ring, api, 64);
+    RunFrame(ring, api, 64);
+    uint32_t oldBuffer = ring.GetGPUBuffer().GetGPUID();
+
+    // already big enough, nothing happens
+    REQUIRE(ring.Reserve(200));
+    REQUIRE(ring.GetStats().reallocations == 0);
+
+    ring.BeginFrame();
+    REQUIRE(ring.Reserve(600));
+    REQUIRE(ring.GetStats().reallocations == 1);
+    REQUIRE(ring.GetBytesPerFrame() == 768);
+    REQUIRE(ring.GetGPUBuffer().GetGPUID() != oldBuffer);
+    REQUIRE(api.disposed == 1);
+    REQUIRE(api.fencesDeleted == api.fencesIssued);
+
+    // still inside the frame that reserved, allocations carry on in the new buffer
+    auto allocation = ring.Allocate(600);
+    REQUIRE(allocation);
+    REQUIRE(allocation.bufferID == ring.GetGPUBuffer().GetGPUID());
+    ring.EndFrame();
+    REQUIRE(api.fencesIssued - api.fencesDeleted == 1);
+
+    // small growth still goes up by half so a slowly growing scene doesn't reallocate every frame
+    ring.Reserve(800);
+    REQUIRE(ring.GetBytesPerFrame() == 1280);
+}
+
+TEST_CASE("PersistentRingBuffer upload benchmark", "[PersistentRingBuffer][!benchmark]")
+{
+    // a frame's worth of joint palettes, copied into the mapped partition
+    MockGraphicsAPI api;
+    TestRing ring(3);
+    std::vector<float> palette(16 * 4096, 1.0f);
+    ring.Create(&api, palette.size() * sizeof(float) + 4096, 256);
+
+    BENCHMARK("Ring upload 4096 joint matrices")
+    {
+        ring.BeginFrame();
+        auto allocation = ring.Upload(palette);
+        ring.EndFrame();
+        api.gpuFrame++;
+        return allocation.offset;
+    };
+}
@@ -0,0 +1,247 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "SceneBVH.h"
+#include "ViewFrustum.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // Buildings on a city sized ground plane, a few large boxes mixed in with lots of small props
+    std::vector<AABB> MakeCity(size_t count, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(-500.0f, 500.0f);
+        std::uniform_real_distribution<float> size(0.2f, 3.0f);
+        std::uniform_real_distribution<float> height(0.0f, 40.0f);
+        std::uniform_int_distribution<int> large(0, 20);
+
+        std::vector<AABB> boxes(count);
+        for (auto& box : boxes)
+        {
+            glm::vec3 c(pos(rng), height(rng) * 0.25f, pos(rng));
+            glm::vec3 e(size(rng), size(rng), size(rng));
+            if (large(rng) == 0) e *= 8.0f;
+            box = { c - e, c + e };
+        }
+        return boxes;
+    }
+
+    bool Overlaps(const AABB& a, const AABB& b)
+    {
+        return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+            a.min.y <= b.max.y && a.max.y >= b.min.y &&
+            a.min.z <= b.max.z && a.max.z >= b.min.z;
+    }
+
+    std::vector<uint32_t> Sorted(std::vector<uint32_t> indices)
+    {
+        std::sort(indices.begin(), indices.end());
+        return indices;
+    }
+
+    // Probe grid matching DDGI::GenerateProbes, 10x7x10 spread over the scene
+    std::vector<glm::vec3> MakeProbeGrid()
+    {
+        std::vector<glm::vec3> probes;
+        glm::ivec3 resolution(10, 7, 10);
+        glm::vec3 spacing(100.0f, 2.0f, 100.0f);
+        glm::vec3 halfGrid = glm::vec3(resolution - 1) * spacing * 0.5f;
+        for (int z = 0; z < resolution.z; ++z)
+            for (int y = 0; y < resolution.y; ++y)
+                for (int x = 0; x < resolution.x; ++x)
+                    probes.push_back(glm::vec3(0.0f, 4.5f, 0.0f) + glm::vec3(x, y, z) * spacing - halfGrid);
+        return probes;
+    }
+}
+
+TEST_CASE("SceneBVH queries match a linear scan", "[SceneBVH]")
+{
+    auto boxes = MakeCity(5000, 1);
+
+    SceneBVH bvh;
+    bvh.Build(boxes);
+    REQUIRE(bvh.GetPrimitiveCount() == boxes.size());
+    REQUIRE(bvh.GetNodes().size() < boxes.size() * 2);
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> pos(-500.0f, 500.0f);
+
+    SECTION("Point and box queries")
+    {
+        for (int q = 0; q < 200; ++q)
+        {
+            glm::vec3 point(pos(rng), pos(rng) * 0.01f, pos(rng));
+            AABB query = { point - glm::vec3(15.0f), point + glm::vec3(15.0f) };
+
+            std::vector<uint32_t> expectedPoint, expectedBox;
+            for (uint32_t i = 0; i < boxes.size(); ++i)
+            {
+                if (Overlaps(boxes[i], { point, point })) expectedPoint.push_back(i);
+                if (Overlaps(boxes[i], query)) expectedBox.push_back(i);
+            }
+
+            std::vector<uint32_t> pointHits, boxHits;
+            bvh.QueryPoint(point, pointHits);
+            bvh.QueryBox(query, boxHits);
+
+            REQUIRE(Sorted(pointHits) == expectedPoint);
+            REQUIRE(Sorted(boxHits) == expectedBox);
+            REQUIRE(bvh.AnyContainsPoint(point) == !expectedPoint.empty());
+        }
+    }
+
+    SECTION("Frustum query")
+    {
+        glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(100.0f, 0.0f, 50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        ViewFrustum frustum;
+        frustum.ExtractPlanes(proj * view);
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < boxes.size(); ++i)
+        {
+            if (frustum.Contains(boxes[i])) expected.push_back(i);
+        }
+
+        std::vector<uint32_t> hits;
+        bvh.QueryFrustum(frustum.GetPlanes(), hits);
+        REQUIRE(!expected.empty());
+        REQUIRE(Sorted(hits) == expected);
+    }
+
+    SECTION("Ray query returns the closest box")
+    {
+        for (int q = 0; q < 200; ++q)
+        {
+            glm::vec3 origin(pos(rng), 30.0f, pos(rng));
+            glm::vec3 dir = glm::normalize(glm::vec3(pos(rng), -250.0f, pos(rng)));
+
+            float expected = std::numeric_limits<float>::max();
+            for (const auto& box : boxes)
+            {
+                glm::vec3 t0 = (box.min - origin) / dir;
+                glm::vec3 t1 = (box.max - origin) / dir;
+                glm::vec3 tSmall = glm::min(t0, t1), tBig = glm::max(t0, t1);
+                float tMin = std::max(std::max(tSmall.x, tSmall.y), std::max(tSmall.z, 0.0f));
+                float tMax = std::min(std::min(tBig.x, tBig.y), std::min(tBig.z, 1000.0f));
+                if (tMin <= tMax) expected = std::min(expected, tMin);
+            }
+
+            BVHRayHit hit;
+            bool found = bvh.Raycast(origin, dir, 1000.0f, hit);
+            REQUIRE(found == (expected != std::numeric_limits<float>::max()));
+            if (found)
+            {
+                REQUIRE(hit.distance == Catch::Approx(expected).margin(1e-3));
+            }
+        }
+    }
+}
+
+TEST_CASE("SceneBVH refit follows moved boxes", "[SceneBVH]")
+{
+    auto boxes = MakeCity(2000, 3);
+
+    SceneBVH bvh;
+    bvh.Build(boxes);
+
+    // move every 10th box somewhere else entirely
+    glm::vec3 target(1000.0f, 0.0f, 1000.0f);
+    for (size_t i = 0; i < boxes.size(); i += 10)
+    {
+        glm::vec3 offset = target - boxes[i].min;
+        boxes[i].min += offset;
+        boxes[i].max += offset;
+    }
+    bvh.Refit(boxes);
+
+    const AABB& root = bvh.GetNodes()[0].bounds;
+    REQUIRE(root.max.x >= 1000.0f);
+
+    std::vector<uint32_t> hits;
+    bvh.QueryPoint(target + glm::vec3(0.1f), hits);
+    REQUIRE(hits.size() == (boxes.size() + 9) / 10);
+    REQUIRE(bvh.AnyContainsPoint(target + glm::vec3(0.1f)));
+}
+
+TEST_CASE("SceneBVH handles empty and coincident input", "[SceneBVH]")
+{
+    SceneBVH bvh;
+    bvh.Build({});
+    REQUIRE(bvh.Empty());
+    REQUIRE_FALSE(bvh.AnyContainsPoint(glm::vec3(0.0f)));
+
+    // identical centroids can't be split, they end up in one leaf
+    std::vector<AABB> same(100, { glm::vec3(-1.0f), glm::vec3(1.0f) });
+    bvh.Build(same);
+    std::vector<uint32_t> hits;
+    bvh.QueryPoint(glm::vec3(0.5f), hits);
+    REQUIRE(hits.size() == same.size());
+}
+
+TEST_CASE("SceneBVH probe generation benchmark", "[SceneBVH][!benchmark]")
+{
+    // submesh bounds are local boxes under a node transform, the old path transformed all 8 corners per probe
+    auto localBoxes = MakeCity(20000, 4);
+    std::vector<glm::mat4> transforms(localBoxes.size());
+    std::vector<AABB> worldBoxes(localBoxes.size());
+    for (size_t i = 0; i < localBoxes.size(); ++i)
+    {
+        glm::vec3 centre = (localBoxes[i].min + localBoxes[i].max) * 0.5f;
+        transforms[i] = glm::translate(glm::mat4(1.0f), centre);
+        localBoxes[i].min -= centre;
+        localBoxes[i].max -= centre;
+        worldBoxes[i] = TransformAABB(localBoxes[i], transforms[i]);
+    }
+
+    auto probes = MakeProbeGrid();
+
+    BENCHMARK("Linear scan with AABB::ContainsPoint (700 probes, 20k submeshes)")
+    {
+        int disabled = 0;
+        for (const auto& probe : probes)
+        {
+            for (size_t i = 0; i < localBoxes.size(); ++i)
+            {
+                if (localBoxes[i].ContainsPoint(probe, transforms[i]))
+                {
+                    disabled++;
+                    break;
+                }
+            }
+        }
+        return disabled;
+    };
+
+    BENCHMARK("SceneBVH build and query (700 probes, 20k submeshes)")
+    {
+        SceneBVH bvh;
+        bvh.Build(worldBoxes);
+
+        int disabled = 0;
+        for (const auto& probe : probes)
+        {
+            disabled += bvh.AnyContainsPoint(probe) ? 1 : 0;
+        }
+        return disabled;
+    };
+
+    SceneBVH bvh;
+    bvh.Build(worldBoxes);
+
+    BENCHMARK("SceneBVH refit (20k submeshes)")
+    {
+        bvh.Refit(worldBoxes);
+        return bvh.GetNodes()[0].bounds.max.x;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,447 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "SceneRegistry.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    std::shared_ptr<Node> MakeMeshNode(const std::string& name, std::vector<uint32_t> submeshFlags, uint32_t jointCount = 0)
+    {
+        auto node = std::make_shared<Node>(name, NodeTag::Mesh);
+        node->mesh = std::make_shared<Mesh>(name);
+        node->mesh->node = node.get();
+
+        uint32_t attribKey = 1;
+        for (uint32_t flags : submeshFlags)
+        {
+            SubMesh submesh;
+            submesh.flags = flags;
+            submesh.attribKey = attribKey++;
+            submesh.materialHandle = 7;
+            submesh.aabb = { glm::vec3(-1.0f), glm::vec3(1.0f) };
+            node->mesh->AddSubmesh(submesh);
+        }
+
+        if (jointCount > 0)
+        {
+            auto skeleton = std::make_shared<Skeleton>();
+            skeleton->joints.resize(jointCount);
+            node->mesh->SetSkeleton(skeleton);
+        }
+        return node;
+    }
+
+    // Static props under a root, like a loaded level
+    std::shared_ptr<Node> MakeLevel(int propCount)
+    {
+        auto root = std::make_shared<Node>("SceneRoot", NodeTag::SceneRoot);
+        for (int i = 0; i < propCount; ++i)
+        {
+            auto prop = MakeMeshNode("Prop" + std::to_string(i), { SubmeshFlags::STATIC });
+            root->AddChild(prop);
+        }
+        return root;
+    }
+
+    // No two registered items of a space may share a per draw slot
+    void RequireUniqueSlots(const SceneRegistry& registry, std::initializer_list<SceneBucket> buckets)
+    {
+        std::set<uint32_t> used;
+        for (SceneBucket bucket : buckets)
+        {
+            for (SceneItemID id : registry.GetBucketItems(bucket))
+            {
+                auto& item = registry.GetItem(id);
+                for (uint32_t i = 0; i < item.slotCount; ++i)
+                {
+                    REQUIRE(used.insert(item.slot + i).second);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("SlotAllocator reuses freed slots before growing", "[SceneRegistry]")
+{
+    SlotAllocator slots;
+    uint32_t a = slots.Allocate();
+    uint32_t b = slots.Allocate();
+    uint32_t c = slots.Allocate(4);
+    REQUIRE(a == 0);
+    REQUIRE(b == 1);
+    REQUIRE(c == 2);
+    REQUIRE(slots.Capacity() == 6);
+
+    slots.Free(b);
+    REQUIRE(slots.Allocate() == b);
+    REQUIRE(slots.Capacity() == 6);
+
+    // a range only fits where there is room for all of it
+    slots.Free(c, 4);
+    REQUIRE(slots.Allocate(5) == 6);
+    uint32_t d = slots.Allocate(3);
+    REQUIRE(d >= c);
+    REQUIRE(d + 3 <= c + 4);
+    REQUIRE(slots.LiveCount() == 2 + 5 + 3);
+
+    REQUIRE(slots.Allocate(0) == SlotAllocator::InvalidSlot);
+}
+
+TEST_CASE("SceneRegistry buckets submeshes like the full rebuild", "[SceneRegistry]")
+{
+    auto root = std::make_shared<Node>("SceneRoot", NodeTag::SceneRoot);
+    auto level = MakeMeshNode("Level", { SubmeshFlags::STATIC, SubmeshFlags::STATIC | SubmeshFlags::USES_TRANSPARENCY });
+    auto door = MakeMeshNode("Door", { SubmeshFlags::ANIMATED });
+    auto hero = MakeMeshNode("Hero", { SubmeshFlags::SKINNED | SubmeshFlags::ANIMATED, SubmeshFlags::SKINNED | SubmeshFlags::ANIMATED }, 20);
+    root->AddChild(level);
+    root->AddChild(door);
+    level->AddChild(hero);
+
+    SceneRegistry registry;
+    registry.AddSubtree(root.get());
+
+    REQUIRE(registry.GetSubmeshes().size() == 5);
+    REQUIRE(registry.GetNonInstancedStatic().size() == 1);
+    REQUIRE(registry.GetTransparent().size() == 1);
+    REQUIRE(registry.GetRigidAnimated().size() == 1);
+    REQUIRE(registry.GetNonInstancedDynamic().size() == 2);
+
+    RequireUniqueSlots(registry, { SceneBucket::Static, SceneBucket::RigidAnimated, SceneBucket::InstancedStatic });
+    RequireUniqueSlots(registry, { SceneBucket::Skinned, SceneBucket::InstancedSkinned });
+
+    // each skinned submesh has its own joint range
+    auto& skinned = registry.GetBucketItems(SceneBucket::Skinned);
+    auto& first = registry.GetItem(skinned[0]);
+    auto& second = registry.GetItem(skinned[1]);
+    REQUIRE(first.jointCount == 20);
+    REQUIRE((first.jointSlot + first.jointCount <= second.jointSlot || second.jointSlot + second.jointCount <= first.jointSlot));
+    REQUIRE(registry.GetJointSlots().Capacity() == 40);
+
+    // the first pass hands every drawable submesh to the renderer
+    SceneChanges changes;
+    registry.TakeChanges(changes);
+    REQUIRE(changes.added.size() == 5);
+    REQUIRE(changes.removed.empty());
+    REQUIRE(registry.GetChanges().Empty());
+}
+
+TEST_CASE("SceneRegistry instanced submeshes are drawn once per group", "[SceneRegistry]")
+{
+    auto instances = std::make_shared<std::vector<Node*>>();
+    std::vector<std::shared_ptr<Node>> instanceNodes;
+    for (int i = 0; i < 8; ++i)
+    {
+        instanceNodes.push_back(std::make_shared<Node>("Instance" + std::to_string(i), NodeTag::Default));
+        instances->push_back(instanceNodes.back().get());
+    }
+
+    auto root = std::make_shared<Node>("SceneRoot", NodeTag::SceneRoot);
+    auto treeA = MakeMeshNode("Tree", { SubmeshFlags::STATIC | SubmeshFlags::INSTANCED });
+    auto treeB = MakeMeshNode("Tree", { SubmeshFlags::STATIC | SubmeshFlags::INSTANCED });
+    treeA->mesh->GetSubmesh(0).instanceTransforms = instances;
+    treeB->mesh->GetSubmesh(0).instanceTransforms = instances;
+    root->AddChild(treeA);
+    root->AddChild(treeB);
+
+    SceneRegistry registry;
+    registry.AddSubtree(root.get());
+
+    REQUIRE(registry.GetInstancedStatic().size() == 1);
+    auto& owners = registry.GetBucketItems(SceneBucket::InstancedStatic);
+    REQUIRE(owners.size() == 1);
+    REQUIRE(registry.GetItem(owners[0]).slotCount == 8);
+    REQUIRE(registry.GetSlots(PerDrawSpace::Static).Capacity() == 8);
+}
+
+TEST_CASE("SceneRegistry instances added after placement grow the group", "[SceneRegistry]")
+{
+    auto root = std::make_shared<Node>("SceneRoot", NodeTag::SceneRoot);
+    auto tree = MakeMeshNode("Tree", { SubmeshFlags::STATIC });
+    root->AddChild(tree);
+
+    SceneRegistry registry;
+    registry.AddSubtree(root.get());
+    SceneChanges changes;
+    registry.TakeChanges(changes);
+    REQUIRE(registry.GetBucketItems(SceneBucket::Static).size() == 1);
+
+    // the mesh goes from one node to two, like MakeInstanceOf
+    auto addInstance = [&](const std::string& name)
+        {
+            auto& submesh = tree->mesh->GetSubmesh(0);
+            if (submesh.instanceTransforms == nullptr)
+            {
+                submesh.flags |= SubmeshFlags::INSTANCED;
+                submesh.instanceTransforms = std::make_shared<std::vector<Node*>>();
+                submesh.instanceTransforms->push_back(tree.get());
+            }
+            auto node = std::make_shared<Node>(name, NodeTag::Mesh);
+            node->mesh = tree->mesh;
+            submesh.instanceTransforms->push_back(node.get());
+            root->AddChild(node);
+            registry.AddSubtree(node.get());
+            return node;
+        };
+
+    auto second = addInstance("Tree2");
+    // the first node now draws as part of the group, not on its own as well
+    REQUIRE(registry.GetBucketItems(SceneBucket::Static).empty());
+    REQUIRE(registry.GetNonInstancedStatic().empty());
+    auto& owners = registry.GetBucketItems(SceneBucket::InstancedStatic);
+    REQUIRE(owners.size() == 1);
+    REQUIRE(registry.GetItem(owners[0]).slotCount == 2);
+    REQUIRE(registry.GetBucketItems(SceneBucket::None).size() == 1);
+
+    registry.TakeChanges(changes);
+    REQUIRE(changes.removed.size() == 1);
+    REQUIRE(changes.added.size() == 1);
+    REQUIRE(changes.added[0] == owners[0]);
+
+    // later spawns re-place the owner with a slot for every instance
+    std::vector<std::shared_ptr<Node>> spawned;
+    for (int i = 0; i < 10; ++i)
+        spawned.push_back(addInstance("Spawn" + std::to_string(i)));
+
+    REQUIRE(owners.size() == 1);
+    REQUIRE(registry.GetItem(owners[0]).slotCount == 12);
+    RequireUniqueSlots(registry, { SceneBucket::Static, SceneBucket::RigidAnimated, SceneBucket::InstancedStatic });
+
+    registry.TakeChanges(changes);
+    REQUIRE(changes.added.size() == 1);
+    REQUIRE(registry.GetItem(changes.added[0]).slotCount == 12);
+    REQUIRE(changes.removed.size() == 1);
+}
+
+TEST_CASE("SceneRegistry removing instances shrinks or hands over the group", "[SceneRegistry]")
+{
+    auto root = std::make_shared<Node>("SceneRoot", NodeTag::SceneRoot);
+    auto first = MakeMeshNode("Rock", { SubmeshFlags::STATIC | SubmeshFlags::INSTANCED });
+    auto instances = std::make_shared<std::vector<Node*>>();
+    first->mesh->GetSubmesh(0).instanceTransforms = instances;
+
+    std::vector<std::shared_ptr<Node>> nodes = { first };
+    for (int i = 1; i < 4; ++i)
+    {
+        auto node = std::make_shared<Node>("Rock" + std::to_string(i), NodeTag::Mesh);
+        node->mesh = first->mesh;
+        nodes.push_back(node);
+    }
+    for (auto& node : nodes)
+    {
+        instances->push_back(node.get());
+        root->AddChild(node);
+    }
+    first->mesh->GetSubmesh(0).command.instanceCount = 4;
+
+    SceneRegistry registry;
+    registry.AddSubtree(root.get());
+    SceneChanges changes;
+    registry.TakeChanges(changes);
+
+    auto& owners = registry.GetBucketItems(SceneBucket::InstancedStatic);
+    REQUIRE(owners.size() == 1);
+    REQUIRE(registry.GetItem(owners[0]).slotCount == 4);
+    REQUIRE(registry.GetBucketItems(SceneBucket::None).size() == 3);
+
+    auto contains = [&instances](const Node* node) { return std::find(instances->begin(), instances->end(), node) != instances->end(); };
+    // the mesh's node stands in for instances without a controller, it has to stay one of them
+    auto meshNodeValid = [&]() { return instances->empty() ? first->mesh->node == nullptr : contains(first->mesh->node); };
+
+    // an instance that isn't the owner leaves, the owner draws one fewer
+    Node* owner = registry.GetItem(owners[0]).node;
+    Node* leaving = owner == first.get() ? nodes[1].get() : first.get();
+    registry.RemoveSubtree(leaving);
+    REQUIRE_FALSE(contains(leaving));
+    REQUIRE(meshNodeValid());
+    REQUIRE(first->mesh->GetSubmesh(0).command.instanceCount == 3);
+    REQUIRE(owners.size() == 1);
+    REQUIRE(registry.GetItem(owners[0]).node == owner);
+    REQUIRE(registry.GetItem(owners[0]).slotCount == 3);
+    REQUIRE(registry.GetBucketItems(SceneBucket::None).size() == 2);
+    REQUIRE(registry.GetSlots(PerDrawSpace::Static).LiveCount() == 3);
+
+    registry.TakeChanges(changes);
+    REQUIRE(changes.removed.size() == 1);
+    REQUIRE(changes.added.size() == 1);
+    REQUIRE(registry.GetItem(changes.added[0]).slotCount == 3);
+
+    // the owner leaves, the next instance owns the group and nothing drops out
+    registry.RemoveSubtree(owner);
+    REQUIRE_FALSE(contains(owner));
+    REQUIRE(meshNodeValid());
+    REQUIRE(registry.GetInstancedStatic().size() == 1);
+    REQUIRE(owners.size() == 1);
+    REQUIRE(registry.GetItem(owners[0]).node != owner);
+    REQUIRE(contains(registry.GetItem(owners[0]).node));
+    REQUIRE(registry.GetItem(owners[0]).slotCount == 2);
+    REQUIRE(registry.GetBucketItems(SceneBucket::None).size() == 1);
+    REQUIRE(registry.GetSlots(PerDrawSpace::Static).LiveCount() == 2);
+
+    registry.TakeChanges(changes);
+    REQUIRE(changes.removed.size() == 1);
+    REQUIRE(changes.removed[0].node == owner);
+    REQUIRE(changes.added.size() == 1);
+
+    // and the last two go without leaving anything behind
+    std::vector<Node*> remaining(instances->begin(), instances->end());
+    for (Node* node : remaining)
+    {
+        registry.RemoveSubtree(node);
+        REQUIRE(meshNodeValid());
+    }
+    REQUIRE(instances->empty());
+    REQUIRE(owners.empty());
+    REQUIRE(registry.GetInstancedStatic().empty());
+    REQUIRE(registry.GetBucketItems(SceneBucket::None).empty());
+    REQUIRE(registry.GetSlots(PerDrawSpace::Static).LiveCount() == 0);
+}
+
+TEST_CASE("SceneRegistry spawning only reports the new submeshes", "[SceneRegistry]")
+{
+    auto root = MakeLevel(500);
+    SceneRegistry registry;
+    registry.AddSubtree(root.get());
+
+    SceneChanges changes;
+    registry.TakeChanges(changes);
+    REQUIRE(changes.added.size() == 500);
+
+    std::vector<std::shared_ptr<Node>> spawned;
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto node = MakeMeshNode("Spawn" + std::to_string(i), { SubmeshFlags::STATIC });
+        root->AddChild(node);
+        registry.AddSubtree(node.get());
+        spawned.push_back(node);
+    }
+
+    registry.TakeChanges(changes);
+    REQUIRE(changes.added.size() == 1000);
+    REQUIRE(changes.removed.empty());
+    REQUIRE(changes.dirty.empty());
+
+    // the level keeps its slots, the spawns were appended after them
+    for (SceneItemID id : changes.added)
+    {
+        REQUIRE(registry.GetItem(id).slot >= 500);
+    }
+    REQUIRE(registry.GetSlots(PerDrawSpace::Static).Capacity() == 1500);
+
+    // despawn half, their slots are reused by the next wave instead of growing the buffer
+    for (int i = 0; i < 1000; i += 2)
+    {
+        registry.RemoveSubtree(spawned[i].get());
+    }
+    registry.TakeChanges(changes);
+    REQUIRE(changes.removed.size() == 500);
+    REQUIRE(changes.added.empty());
+    REQUIRE(registry.GetNonInstancedStatic().size() == 1000);
+
+    for (int i = 0; i < 500; ++i)
+    {
+        auto node = MakeMeshNode("Wave" + std::to_string(i), { SubmeshFlags::STATIC });
+        root->AddChild(node);
+        registry.AddSubtree(node.get());
+        spawned.push_back(node);
+    }
+    registry.TakeChanges(changes);
+    REQUIRE(changes.added.size() == 500);
+    REQUIRE(registry.GetSlots(PerDrawSpace::Static).Capacity() == 1500);
+    RequireUniqueSlots(registry, { SceneBucket::Static });
+
+    // list positions stay in step with the swap removals
+    auto& items = registry.GetBucketItems(SceneBucket::Static);
+    auto& list = registry.GetNonInstancedStatic();
+    REQUIRE(items.size() == list.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        auto& item = registry.GetItem(items[i]);
+        REQUIRE(item.listIndex == i);
+        REQUIRE(list[i].second == item.node);
+        REQUIRE(registry.GetSubmeshes()[item.submeshListIndex].second == item.node);
+    }
+}
+
+TEST_CASE("SceneRegistry flag and material changes", "[SceneRegistry]")
+{
+    auto root = std::make_shared<Node>("SceneRoot", NodeTag::SceneRoot);
+    auto crate = MakeMeshNode("Crate", { SubmeshFlags::STATIC });
+    root->AddChild(crate);
+
+    SceneRegistry registry;
+    registry.AddSubtree(root.get());
+    SceneChanges changes;
+    registry.TakeChanges(changes);
+
+    // a material swap keeps the slot and only rewrites the per draw data
+    registry.SetSubmeshMaterial(crate.get(), 0, 42);
+    registry.TakeChanges(changes);
+    REQUIRE(changes.added.empty());
+    REQUIRE(changes.removed.empty());
+    REQUIRE(changes.dirty.size() == 1);
+    REQUIRE(registry.GetItem(changes.dirty[0]).submesh.materialHandle == 42);
+    REQUIRE(crate->mesh->GetSubmesh(0).materialHandle == 42);
+
+    // starting to animate moves it to the rigid bucket
+    registry.SetSubmeshFlags(crate.get(), 0, SubmeshFlags::ANIMATED);
+    registry.TakeChanges(changes);
+    REQUIRE(changes.removed.size() == 1);
+    REQUIRE(changes.removed[0].bucket == SceneBucket::Static);
+    REQUIRE(changes.added.size() == 1);
+    REQUIRE(registry.GetItem(changes.added[0]).bucket == SceneBucket::RigidAnimated);
+    REQUIRE(registry.GetNonInstancedStatic().empty());
+    REQUIRE(registry.GetRigidAnimated().size() == 1);
+
+    // added and removed before the renderer looked, nothing to do
+    auto temp = MakeMeshNode("Temp", { SubmeshFlags::STATIC });
+    root->AddChild(temp);
+    registry.AddSubtree(temp.get());
+    registry.RemoveSubtree(temp.get());
+    registry.TakeChanges(changes);
+    REQUIRE(changes.Empty());
+}
+
+TEST_CASE("SceneRegistry spawn benchmark", "[SceneRegistry][!benchmark]")
+{
+    auto root = MakeLevel(20000);
+
+    std::vector<std::shared_ptr<Node>> spawns;
+    for (int i = 0; i < 1000; ++i)
+    {
+        spawns.push_back(MakeMeshNode("Spawn" + std::to_string(i), { SubmeshFlags::STATIC }));
+    }
+
+    SceneRegistry registry;
+    registry.AddSubtree(root.get());
+
+    BENCHMARK("Full rebuild (20k props)")
+    {
+        registry.Clear();
+        registry.AddSubtree(root.get());
+        return registry.GetItemCount();
+    };
+
+    SceneChanges changes;
+    BENCHMARK("Spawn and despawn 1000 objects into 20k props")
+    {
+        for (auto& spawn : spawns)
+        {
+            registry.AddSubtree(spawn.get());
+        }
+        registry.TakeChanges(changes);
+        for (auto& spawn : spawns)
+        {
+            registry.RemoveSubtree(spawn.get());
+        }
+        registry.TakeChanges(changes);
+        return changes.removed.size();
+    };
+}
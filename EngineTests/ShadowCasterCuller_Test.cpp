@@ -0,0 +1,150 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <vector>
+
+#include "ShadowCasterCuller.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // Light straight down onto a 20x20 box around centre, built the same way as
+    // DirectionalLightShadowMap::CalculateLightSpaceMatrixForCascade (light view, then ortho around it)
+    glm::mat4 MakeCascadeMatrix(const glm::vec3& centre, float halfSize)
+    {
+        glm::vec3 lightDir(0.0f, 1.0f, 0.0f);
+        glm::mat4 lightView = glm::lookAt(centre + lightDir, centre, glm::vec3(1.0f, 0.0f, 0.0f));
+        glm::mat4 lightProj = glm::ortho(-halfSize, halfSize, -halfSize, halfSize, 0.0f, 10.0f);
+        return lightProj * lightView;
+    }
+
+    AABB MakeBox(const glm::vec3& centre, float halfSize)
+    {
+        return { centre - glm::vec3(halfSize), centre + glm::vec3(halfSize) };
+    }
+
+    DrawIndirectCommand MakeCommand(uint32_t id)
+    {
+        return { 36, 1, id * 36, 0, id };
+    }
+}
+
+TEST_CASE("ShadowCasterCuller keeps casters inside or above each cascade", "[ShadowCasterCulling]")
+{
+    // box spans y in [-9, 1] below the light at y = 1
+    std::vector<glm::mat4> cascades =
+    {
+        MakeCascadeMatrix(glm::vec3(0.0f), 10.0f),
+        MakeCascadeMatrix(glm::vec3(100.0f, 0.0f, 0.0f), 10.0f)
+    };
+
+    FrustumCuller bounds;
+    bounds.Resize(5);
+    bounds.SetWorldBounds(0, MakeBox(glm::vec3(0.0f, -2.0f, 0.0f), 1.0f));       // inside cascade 0
+    bounds.SetWorldBounds(1, MakeBox(glm::vec3(0.0f, 500.0f, 0.0f), 1.0f));      // between the light and cascade 0
+    bounds.SetWorldBounds(2, MakeBox(glm::vec3(0.0f, -50.0f, 0.0f), 1.0f));      // past the far plane of cascade 0
+    bounds.SetWorldBounds(3, MakeBox(glm::vec3(100.0f, -2.0f, 5.0f), 1.0f));     // inside cascade 1
+    bounds.SetWorldBounds(4, MakeBox(glm::vec3(50.0f, -2.0f, 0.0f), 1.0f));      // in the gap between both
+
+    ShadowCasterCuller culler;
+    culler.Cull(bounds, cascades);
+
+    REQUIRE(culler.GetCascadeCount() == 2);
+    REQUIRE(culler.GetVisibility(0) == std::vector<uint8_t>{ 1, 1, 0, 0, 0 });
+    REQUIRE(culler.GetVisibility(1) == std::vector<uint8_t>{ 0, 0, 0, 1, 0 });
+
+    REQUIRE(culler.GetStats(0).visible == 2);
+    REQUIRE(culler.GetStats(0).culled == 3);
+    REQUIRE(culler.GetStats(1).visible == 1);
+
+    SECTION("Disabling culling keeps everything")
+    {
+        culler.SetAllVisible(5, 2);
+        REQUIRE(culler.GetVisibility(1) == std::vector<uint8_t>(5, 1));
+        REQUIRE(culler.GetStats(1).culled == 0);
+    }
+}
+
+TEST_CASE("ShadowCasterCuller zeroes culled commands without reordering them", "[ShadowCasterCulling]")
+{
+    std::vector<DrawIndirectCommand> allCommands = { MakeCommand(0), MakeCommand(1), MakeCommand(2), MakeCommand(3) };
+    allCommands[3].instanceCount = 16;
+
+    // the last command is instanced and never culled
+    std::vector<uint32_t> cullSlots = { 2, 0, 1, UINT32_MAX };
+    std::vector<uint8_t> visibility = { 1, 0, 0 };
+
+    std::vector<DrawIndirectCommand> cascadeCommands;
+    uint32_t drawn = ShadowCasterCuller::BuildCascadeCommands(allCommands, cullSlots, visibility, cascadeCommands);
+
+    REQUIRE(drawn == 2);
+    REQUIRE(cascadeCommands.size() == allCommands.size());
+    REQUIRE(cascadeCommands[0].instanceCount == 0);
+    REQUIRE(cascadeCommands[1].instanceCount == 1);
+    REQUIRE(cascadeCommands[2].instanceCount == 0);
+    REQUIRE(cascadeCommands[3].instanceCount == 16);
+
+    for (size_t i = 0; i < allCommands.size(); ++i)
+    {
+        REQUIRE(cascadeCommands[i].count == allCommands[i].count);
+        REQUIRE(cascadeCommands[i].firstIndex == allCommands[i].firstIndex);
+        REQUIRE(cascadeCommands[i].baseInstance == allCommands[i].baseInstance);
+    }
+
+    // reusing the output buffer doesn't keep stale zeroes around
+    visibility = { 1, 1, 1 };
+    drawn = ShadowCasterCuller::BuildCascadeCommands(allCommands, cullSlots, visibility, cascadeCommands);
+    REQUIRE(drawn == 4);
+    REQUIRE(cascadeCommands[0].instanceCount == 1);
+}
+
+TEST_CASE("ShadowCasterCuller benchmark", "[ShadowCasterCulling][!benchmark]")
+{
+    constexpr size_t boxCount = 100000;
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> pos(-200.0f, 200.0f);
+
+    FrustumCuller bounds;
+    bounds.Resize(boxCount);
+    for (size_t i = 0; i < boxCount; ++i)
+    {
+        bounds.SetWorldBounds(i, MakeBox(glm::vec3(pos(rng), pos(rng) * 0.05f, pos(rng)), 1.0f));
+    }
+
+    // cascades growing away from the camera, like the log/uniform split
+    std::vector<glm::mat4> cascades =
+    {
+        MakeCascadeMatrix(glm::vec3(0.0f, 0.0f, -5.0f), 5.0f),
+        MakeCascadeMatrix(glm::vec3(0.0f, 0.0f, -15.0f), 10.0f),
+        MakeCascadeMatrix(glm::vec3(0.0f, 0.0f, -35.0f), 20.0f),
+        MakeCascadeMatrix(glm::vec3(0.0f, 0.0f, -75.0f), 40.0f)
+    };
+
+    std::vector<DrawIndirectCommand> allCommands(boxCount);
+    std::vector<uint32_t> cullSlots(boxCount);
+    for (uint32_t i = 0; i < boxCount; ++i)
+    {
+        allCommands[i] = MakeCommand(i);
+        cullSlots[i] = i;
+    }
+
+    ShadowCasterCuller culler;
+    std::vector<DrawIndirectCommand> cascadeCommands;
+
+    BENCHMARK("Cull and build 4 cascades (100k casters)")
+    {
+        culler.Cull(bounds, cascades);
+
+        uint32_t drawn = 0;
+        for (size_t cascade = 0; cascade < cascades.size(); ++cascade)
+        {
+            drawn += ShadowCasterCuller::BuildCascadeCommands(allCommands, cullSlots, culler.GetVisibility(cascade), cascadeCommands);
+        }
+        return drawn;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "SkinningEvaluator.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // A chain of joints with translation, rotation and scale channels on every joint, about the size of CesiumMan
+    struct TestCharacterData
+    {
+        Skeleton skeleton;
+        std::unique_ptr<Animation> animation;
+        std::vector<glm::mat4> inverseBindMatrices;
+    };
+
+    std::unique_ptr<TestCharacterData> MakeCharacterData(int jointCount, int keyCount)
+    {
+        auto data = std::make_unique<TestCharacterData>();
+        data->animation = std::make_unique<Animation>("Walk");
+
+        for (int joint = 0; joint < jointCount; ++joint)
+        {
+            data->skeleton.joints.push_back(Skeleton::Joint{ joint - 1, glm::mat4(1.0f) });
+            data->inverseBindMatrices.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f * joint, 0.0f)));
+
+            for (int path = 0; path < 3; ++path)
+            {
+                std::vector<float> times;
+                std::vector<glm::vec4> values;
+                for (int key = 0; key < keyCount; ++key)
+                {
+                    float t = key / 30.0f;
+                    times.push_back(t);
+                    if (path == TargetPath::ROTATION)
+                    {
+                        float angle = 0.3f * std::sin(t * 4.0f + joint);
+                        values.push_back(glm::vec4(std::sin(angle * 0.5f), 0.0f, 0.0f, std::cos(angle * 0.5f)));
+                    }
+                    else if (path == TargetPath::TRANSLATION)
+                    {
+                        values.push_back(glm::vec4(0.0f, 0.1f, 0.02f * std::cos(t + joint), 0.0f));
+                    }
+                    else
+                    {
+                        values.push_back(glm::vec4(1.0f + 0.05f * std::sin(t), 1.0f, 1.0f, 0.0f));
+                    }
+                }
+
+                AnimationSampler sampler;
+                sampler.SetTimes(std::move(times));
+                sampler.SetValues(std::move(values));
+                data->animation->AddSampler(sampler);
+                data->animation->AddChannel(AnimationChannel(static_cast<int>(data->animation->GetSamplers().size()) - 1, joint, static_cast<TargetPath>(path)));
+            }
+        }
+        data->animation->CalcDuration();
+        data->animation->PrecomputeSamplers();
+        return data;
+    }
+
+    struct TestCrowd
+    {
+        std::unique_ptr<TestCharacterData> data;
+        std::vector<std::vector<size_t>> keyframeIndices;
+        std::vector<SkinningTask> tasks;
+        std::vector<glm::mat4> palette;
+    };
+
+    // Every character plays the same clip at its own time, with its own palette slice
+    TestCrowd MakeCrowd(int characters, int jointCount = 19, int keyCount = 60)
+    {
+        TestCrowd crowd;
+        crowd.data = MakeCharacterData(jointCount, keyCount);
+        crowd.keyframeIndices.resize(characters);
+        crowd.palette.resize(static_cast<size_t>(characters) * jointCount);
+
+        float duration = crowd.data->animation->GetDuration();
+        for (int i = 0; i < characters; ++i)
+        {
+            float time = std::fmod(i * 0.037f, duration);
+            size_t key = std::min(static_cast<size_t>(time * 30.0f), static_cast<size_t>(keyCount - 1));
+            crowd.keyframeIndices[i].assign(crowd.data->animation->GetChannels().size(), key);
+
+            SkinningTask task;
+            task.animation = crowd.data->animation.get();
+            task.time = time;
+            task.keyframeIndices = &crowd.keyframeIndices[i];
+            task.skeleton = &crowd.data->skeleton;
+            task.inverseBindMatrices = &crowd.data->inverseBindMatrices;
+            task.jointSlot = static_cast<uint32_t>(i * jointCount);
+            task.jointCount = static_cast<uint32_t>(jointCount);
+            crowd.tasks.push_back(task);
+        }
+        return crowd;
+    }
+
+    // The original per mesh path, allocating as it goes
+    std::vector<glm::mat4> EvaluateSerial(TestCrowd& crowd)
+    {
+        std::vector<glm::mat4> palette(crowd.palette.size());
+        for (auto& task : crowd.tasks)
+        {
+            std::vector<glm::mat4> nodeTransforms(task.skeleton->joints.size(), glm::mat4(1.0f));
+            AnimHelpers::EvaluateAnimation(*task.animation, task.time, nodeTransforms, *task.keyframeIndices);
+
+            std::vector<glm::mat4> globalTransforms;
+            AnimHelpers::ComputeGlobalTransforms(*task.skeleton, nodeTransforms, globalTransforms);
+
+            std::vector<glm::mat4> jointMatrices;
+            AnimHelpers::ComputeJointMatrices(globalTransforms, *task.inverseBindMatrices, jointMatrices);
+            std::copy(jointMatrices.begin(), jointMatrices.end(), palette.begin() + task.jointSlot);
+        }
+        return palette;
+    }
+
+    bool SameMatrix(const glm::mat4& a, const glm::mat4& b)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                if (std::abs(a[c][r] - b[c][r]) > 1e-5f) return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE("SkinningEvaluator matches the serial evaluation", "[SkinningEvaluator]")
+{
+    TestCrowd crowd = MakeCrowd(97);
+    auto expected = EvaluateSerial(crowd);
+
+    JobSystem jobs(3);
+    SkinningEvaluator evaluator;
+    evaluator.Evaluate(crowd.tasks, crowd.palette, jobs, 4);
+
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        REQUIRE(SameMatrix(crowd.palette[i], expected[i]));
+    }
+
+    // a second frame reuses the scratch and gives the same answer
+    std::fill(crowd.palette.begin(), crowd.palette.end(), glm::mat4(0.0f));
+    evaluator.Evaluate(crowd.tasks, crowd.palette, jobs, 4);
+    REQUIRE(SameMatrix(crowd.palette.back(), expected.back()));
+}
+
+TEST_CASE("SkinningEvaluator skips tasks without a palette slice", "[SkinningEvaluator]")
+{
+    TestCrowd crowd = MakeCrowd(4);
+    crowd.tasks[1].animation = nullptr;
+    crowd.tasks[3].jointSlot = static_cast<uint32_t>(crowd.palette.size()); // past the end
+
+    JobSystem jobs(1);
+    SkinningEvaluator evaluator;
+    std::fill(crowd.palette.begin(), crowd.palette.end(), glm::mat4(0.0f));
+    evaluator.Evaluate(crowd.tasks, crowd.palette, jobs);
+
+    uint32_t jointCount = crowd.tasks[0].jointCount;
+    REQUIRE_FALSE(SameMatrix(crowd.palette[0], glm::mat4(0.0f)));
+    REQUIRE(SameMatrix(crowd.palette[jointCount], glm::mat4(0.0f)));
+}
+
+TEST_CASE("SkinningEvaluator characters per millisecond", "[SkinningEvaluator][!benchmark]")
+{
+    // 500 instanced CesiumMan sized characters
+    constexpr int Characters = 500;
+    TestCrowd crowd = MakeCrowd(Characters);
+
+    BENCHMARK("Serial evaluation, allocating (500 characters)")
+    {
+        return EvaluateSerial(crowd).size();
+    };
+
+    unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts = { 1, 2, 4, 8 };
+    threadCounts.erase(std::remove_if(threadCounts.begin(), threadCounts.end(), [&](unsigned t) { return t > hardwareThreads; }), threadCounts.end());
+    if (std::find(threadCounts.begin(), threadCounts.end(), hardwareThreads) == threadCounts.end()) threadCounts.push_back(hardwareThreads);
+
+    for (unsigned threads : threadCounts)
+    {
+        JobSystem jobs(threads - 1);
+        SkinningEvaluator evaluator;
+        evaluator.Evaluate(crowd.tasks, crowd.palette, jobs); // warm the scratch
+
+        BENCHMARK("SkinningEvaluator (500 characters, " + std::to_string(threads) + " threads)")
+        {
+            evaluator.Evaluate(crowd.tasks, crowd.palette, jobs);
+            return crowd.palette[0][3][1];
+        };
+
+        constexpr int Frames = 200;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < Frames; ++frame)
+        {
+            evaluator.Evaluate(crowd.tasks, crowd.palette, jobs);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << threads << " threads: " << (Characters * Frames) / ms << " characters/ms" << std::endl;
+    }
+}
@@ -0,0 +1,250 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include "JobSystem.h"
+#include "TextureCache.h"
+#include "TextureCompressor.h"
+#include "TextureCooker.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // Smooth gradients with a little noise and a few hard edges, roughly what material textures hold.
+    // Alpha varies on its own when it isn't opaque
+    std::vector<uint8_t> MakeImage(uint32_t width, uint32_t height, uint32_t seed, bool opaque = true)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> noise(-2, 2);
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float u = x / float(width), v = y / float(height);
+                bool stripe = ((x / 24) + (y / 40)) % 5 == 0;
+                int values[4] = {
+                    int(255 * (0.5f + 0.5f * std::sin(u * 6.0f + v * 2.0f))),
+                    int(255 * v),
+                    stripe ? 40 : int(255 * (1.0f - u) * 0.8f),
+                    opaque ? 255 : int(255 * (0.6f + 0.4f * std::cos(v * 5.0f))) + noise(rng)
+                };
+                for (int c = 0; c < 3; ++c) values[c] += noise(rng);
+                for (int c = 0; c < 4; ++c)
+                    rgba[(static_cast<size_t>(y) * width + x) * 4 + c] = static_cast<uint8_t>(std::clamp(values[c], 0, 255));
+            }
+        }
+        return rgba;
+    }
+
+    // Over the first channels of each pixel only
+    double PSNR(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, int channels)
+    {
+        double squared = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < a.size(); i += 4)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                double d = double(a[i + c]) - double(b[i + c]);
+                squared += d * d;
+                ++count;
+            }
+        }
+        if (squared == 0.0) return 99.0;
+        return 10.0 * std::log10(255.0 * 255.0 / (squared / count));
+    }
+
+    std::vector<uint8_t> RoundTrip(BlockFormat format, const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height)
+    {
+        std::vector<std::byte> blocks(TextureCompressor::CompressedSize(format, width, height));
+        TextureCompressor::Compress(format, rgba.data(), width, height, blocks.data());
+        std::vector<uint8_t> decoded(rgba.size());
+        TextureCompressor::Decompress(format, blocks.data(), width, height, decoded.data());
+        return decoded;
+    }
+}
+
+TEST_CASE("Every block format stays close to its source", "[TextureCompressor]")
+{
+    const uint32_t width = 128, height = 96;
+    auto image = MakeImage(width, height, 1);
+
+    double bc1 = PSNR(image, RoundTrip(BlockFormat::BC1, image, width, height), 3);
+    double bc4 = PSNR(image, RoundTrip(BlockFormat::BC4, image, width, height), 1);
+    double bc5 = PSNR(image, RoundTrip(BlockFormat::BC5, image, width, height), 2);
+    double bc7 = PSNR(image, RoundTrip(BlockFormat::BC7, image, width, height), 3);
+
+    INFO("BC1 " << bc1 << " BC4 " << bc4 << " BC5 " << bc5 << " BC7 " << bc7);
+    REQUIRE(bc1 > 37.0);
+    REQUIRE(bc4 > 45.0);
+    REQUIRE(bc5 > 45.0);
+    REQUIRE(bc7 > 40.0);
+    // BC7 spends twice the bits of BC1 and has to show for it
+    REQUIRE(bc7 > bc1 + 1.5);
+}
+
+TEST_CASE("Formats with alpha keep it", "[TextureCompressor]")
+{
+    const uint32_t width = 128, height = 96;
+    auto image = MakeImage(width, height, 6, false);
+
+    double bc3 = PSNR(image, RoundTrip(BlockFormat::BC3, image, width, height), 4);
+    double bc7 = PSNR(image, RoundTrip(BlockFormat::BC7, image, width, height), 4);
+
+    INFO("BC3 " << bc3 << " BC7 " << bc7);
+    REQUIRE(bc3 > 38.0);
+    REQUIRE(bc7 > 38.0);
+}
+
+TEST_CASE("Solid blocks are exact", "[TextureCompressor]")
+{
+    // values that land exactly on the 565 grid and on the odd values of a BC7 p-bit of 1
+    std::vector<uint8_t> image(16 * 4);
+    for (size_t i = 0; i < image.size(); i += 4)
+    {
+        image[i + 0] = 255;
+        image[i + 1] = 195;
+        image[i + 2] = 33;
+        image[i + 3] = 255;
+    }
+
+    REQUIRE(RoundTrip(BlockFormat::BC1, image, 4, 4) == image);
+    REQUIRE(RoundTrip(BlockFormat::BC7, image, 4, 4) == image);
+    REQUIRE(PSNR(image, RoundTrip(BlockFormat::BC4, image, 4, 4), 1) == 99.0);
+}
+
+TEST_CASE("Sizes that aren't a multiple of four cover the edge", "[TextureCompressor]")
+{
+    // cut from a larger image so the content is as smooth as in the other cases
+    const uint32_t width = 37, height = 13;
+    auto source = MakeImage(128, 96, 2);
+    std::vector<uint8_t> image;
+    for (uint32_t y = 0; y < height; ++y)
+        image.insert(image.end(), source.begin() + y * 128 * 4, source.begin() + (y * 128 + width) * 4);
+
+    REQUIRE(TextureCompressor::CompressedSize(BlockFormat::BC7, width, height) == 10 * 4 * 16);
+    REQUIRE(TextureCompressor::CompressedSize(BlockFormat::BC1, 1, 1) == 8);
+    REQUIRE(PSNR(image, RoundTrip(BlockFormat::BC7, image, width, height), 3) > 40.0);
+}
+
+TEST_CASE("Compressing on the job system gives the same blocks", "[TextureCompressor]")
+{
+    const uint32_t width = 256, height = 64;
+    auto image = MakeImage(width, height, 3);
+    JobSystem jobs(3);
+
+    for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC5, BlockFormat::BC7 })
+    {
+        std::vector<std::byte> serial(TextureCompressor::CompressedSize(format, width, height));
+        std::vector<std::byte> parallel(serial.size());
+        TextureCompressor::Compress(format, image.data(), width, height, serial.data());
+        TextureCompressor::Compress(format, image.data(), width, height, parallel.data(), &jobs);
+        REQUIRE(serial == parallel);
+    }
+}
+
+TEST_CASE("Cooking picks the format for the slot and builds every mip", "[TextureCooker]")
+{
+    const uint32_t width = 64, height = 16;
+    auto rgba = MakeImage(width, height, 4, false);
+    std::vector<uint8_t> rgb;
+    for (size_t i = 0; i < rgba.size(); i += 4) rgb.insert(rgb.end(), { rgba[i], rgba[i + 1], rgba[i + 2] });
+
+    TextureCookSettings settings;
+    auto baseColor = TextureCooker::Cook(rgb.data(), width, height, 3, TextureUsage::BaseColor, settings);
+    REQUIRE(baseColor.format == BlockFormat::BC7);
+    REQUIRE(baseColor.srgb);
+    REQUIRE(baseColor.levels.size() == 7);
+    REQUIRE(baseColor.levels.back().width == 1);
+    REQUIRE(baseColor.levels.back().height == 1);
+    REQUIRE(baseColor.levels[2].width == 16);
+    REQUIRE(baseColor.levels[2].height == 4);
+    REQUIRE(baseColor.levels[1].offset == baseColor.levels[0].size);
+    REQUIRE(baseColor.SizeInBytes() == baseColor.blocks.size());
+
+    REQUIRE(TextureCooker::Cook(rgb.data(), width, height, 3, TextureUsage::Normal, settings).format == BlockFormat::BC5);
+    REQUIRE(TextureCooker::Cook(rgb.data(), width, height, 3, TextureUsage::Occlusion, settings).format == BlockFormat::BC4);
+    REQUIRE_FALSE(TextureCooker::Cook(rgb.data(), width, height, 3, TextureUsage::MetallicRoughness, settings).srgb);
+
+    settings.highQuality = false;
+    REQUIRE(TextureCooker::Cook(rgb.data(), width, height, 3, TextureUsage::BaseColor, settings).format == BlockFormat::BC1);
+    REQUIRE(TextureCooker::Cook(rgba.data(), width, height, 4, TextureUsage::BaseColor, settings).format == BlockFormat::BC3);
+}
+
+TEST_CASE("sRGB mips are filtered in linear light", "[TextureCooker]")
+{
+    // black and white texels average to half the light, which is 188 in sRGB, not 128
+    std::vector<uint8_t> checker(4 * 4 * 4);
+    for (int i = 0; i < 16; ++i)
+    {
+        uint8_t v = ((i % 4) + (i / 4)) % 2 == 0 ? 255 : 0;
+        checker[i * 4 + 0] = checker[i * 4 + 1] = checker[i * 4 + 2] = v;
+        checker[i * 4 + 3] = 255;
+    }
+
+    auto srgb = TextureCooker::Downsample(checker, 4, 4, true, false);
+    auto linear = TextureCooker::Downsample(checker, 4, 4, false, false);
+    REQUIRE(srgb.size() == 2 * 2 * 4);
+    REQUIRE(srgb[0] == 188);
+    REQUIRE(linear[0] == 128);
+    REQUIRE(srgb[3] == 255);
+}
+
+TEST_CASE("Normal map mips stay unit length", "[TextureCooker]")
+{
+    // normals tilted either way along x, the average points straight up instead of shrinking
+    std::vector<uint8_t> normals(2 * 2 * 4);
+    float tilt = std::sqrt(0.5f);
+    for (int i = 0; i < 4; ++i)
+    {
+        float x = (i % 2 == 0) ? tilt : -tilt;
+        normals[i * 4 + 0] = static_cast<uint8_t>(std::lround((x * 0.5f + 0.5f) * 255.0f));
+        normals[i * 4 + 1] = 128;
+        normals[i * 4 + 2] = static_cast<uint8_t>(std::lround((tilt * 0.5f + 0.5f) * 255.0f));
+        normals[i * 4 + 3] = 255;
+    }
+
+    auto mip = TextureCooker::Downsample(normals, 2, 2, false, true);
+    float n[3];
+    for (int c = 0; c < 3; ++c) n[c] = mip[c] / 255.0f * 2.0f - 1.0f;
+    REQUIRE(std::abs(std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) - 1.0f) < 0.02f);
+    REQUIRE(mip[2] == 255);
+}
+
+TEST_CASE("Cooked textures round trip through the cache", "[TextureCache]")
+{
+    const uint32_t width = 32, height = 32;
+    auto rgba = MakeImage(width, height, 5);
+    TextureCookSettings settings;
+    auto cooked = TextureCooker::Cook(rgba.data(), width, height, 4, TextureUsage::BaseColor, settings);
+
+    uint64_t hash = TextureCache::Hash(1234, 0, TextureUsage::BaseColor, settings);
+    REQUIRE(hash != TextureCache::Hash(1234, 1, TextureUsage::BaseColor, settings));
+    REQUIRE(hash != TextureCache::Hash(1234, 0, TextureUsage::Emissive, settings));
+    REQUIRE(hash != TextureCache::Hash(4321, 0, TextureUsage::BaseColor, settings));
+
+    auto folder = std::filesystem::temp_directory_path();
+    auto path = TextureCache::CachePath(folder.string(), hash);
+    REQUIRE(TextureCache::Write(path, hash, cooked));
+
+    TextureCache cache;
+    REQUIRE_FALSE(cache.Open(path, hash + 1));
+    REQUIRE(cache.Open(path, hash));
+
+    const auto& image = cache.GetImage();
+    REQUIRE(image.mapped != nullptr);
+    REQUIRE(image.format == cooked.format);
+    REQUIRE(image.srgb == cooked.srgb);
+    REQUIRE(image.levels.size() == cooked.levels.size());
+    REQUIRE(reinterpret_cast<uintptr_t>(image.Data()) % 16 == 0);
+    REQUIRE(std::memcmp(image.Data(), cooked.blocks.data(), cooked.blocks.size()) == 0);
+
+    cache.Close();
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,280 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ImageConversion.h"
+#include "JobSystem.h"
+#include "TextureReader.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    std::string TempPath(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    // Binary PPM, RGB with every channel of every pixel different
+    std::string WritePPM(const char* name, int width, int height)
+    {
+        auto path = TempPath(name);
+        std::ofstream file(path, std::ios::binary);
+        file << "P6\n" << width << " " << height << "\n255\n";
+        for (int i = 0; i < width * height * 3; ++i)
+            file.put(static_cast<char>(i * 5 + 3));
+        return path;
+    }
+
+    uint8_t PPMValue(int width, int x, int y, int c)
+    {
+        return static_cast<uint8_t>((y * width + x) * 3 * 5 + c * 5 + 3);
+    }
+
+    // Radiance file without run length encoding, which stb reads for widths below 8. The values
+    // are powers of two so they come back exactly
+    float HDRValue(int x, int y, int c)
+    {
+        return std::ldexp(1.0f, x - y - c);
+    }
+
+    std::string WriteHDR(const char* name, int width, int height)
+    {
+        auto path = TempPath(name);
+        std::ofstream file(path, std::ios::binary);
+        file << "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " << height << " +X " << width << "\n";
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                float maxValue = std::max({ HDRValue(x, y, 0), HDRValue(x, y, 1), HDRValue(x, y, 2) });
+                int exponent;
+                float scale = std::frexp(maxValue, &exponent) * 256.0f / maxValue;
+                for (int c = 0; c < 3; ++c)
+                    file.put(static_cast<char>(static_cast<int>(HDRValue(x, y, c) * scale)));
+                file.put(static_cast<char>(exponent + 128));
+            }
+        }
+        return path;
+    }
+
+    std::filesystem::path FindHDRI()
+    {
+        for (const char* path : { "../Assets/HDRI", "Assets/HDRI", "../../Assets/HDRI" })
+        {
+            if (std::filesystem::exists(path))
+                return path;
+        }
+        return {};
+    }
+}
+
+TEST_CASE("Batch loads convert into the caller's buffers", "[TextureReader]")
+{
+    const int width = 7, height = 3;
+    auto path = WritePPM("reader_rgb.ppm", width, height);
+
+    // RGBA bytes flipped, two rows of padding apart
+    const size_t pitch = width * 4 + 2;
+    std::vector<uint8_t> rgba(pitch * height, 0);
+    // linear floats and halves of the same file
+    std::vector<float> linear(width * height * 3);
+    std::vector<uint16_t> halves(width * height * 4);
+
+    std::vector<ImageLoadRequest> requests(3);
+    requests[0].path = path;
+    requests[0].destination = rgba.data();
+    requests[0].destinationSize = rgba.size();
+    requests[0].rowPitch = pitch;
+    requests[0].channels = 4;
+    requests[0].flipVertically = true;
+
+    requests[1].path = path;
+    requests[1].destination = linear.data();
+    requests[1].destinationSize = linear.size() * sizeof(float);
+    requests[1].type = PixelType::Float;
+    requests[1].srgbToLinear = true;
+
+    requests[2].path = path;
+    requests[2].destination = halves.data();
+    requests[2].destinationSize = halves.size() * sizeof(uint16_t);
+    requests[2].type = PixelType::Half;
+    requests[2].channels = 4;
+
+    JobSystem jobs(2);
+    REQUIRE(TextureReader::LoadImages(requests, jobs));
+    for (const auto& request : requests)
+    {
+        REQUIRE(request.loaded);
+        REQUIRE(request.info.width == width);
+        REQUIRE(request.info.height == height);
+        REQUIRE(request.info.channels == 3);
+        REQUIRE_FALSE(request.info.isHDR);
+    }
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const uint8_t* flipped = &rgba[(height - 1 - y) * pitch + x * 4];
+            for (int c = 0; c < 3; ++c)
+            {
+                uint8_t value = PPMValue(width, x, y, c);
+                REQUIRE(flipped[c] == value);
+
+                float expected;
+                ImageConversion::SRGBToLinear(&value, &expected, 1, 1);
+                REQUIRE(linear[(y * width + x) * 3 + c] == expected);
+                REQUIRE(halves[(y * width + x) * 4 + c] == ImageConversion::FloatToHalf(value / 255.0f));
+            }
+            REQUIRE(flipped[3] == 255);
+            REQUIRE(halves[(y * width + x) * 4 + 3] == 0x3C00);
+        }
+        // the padding is left alone
+        REQUIRE(rgba[(height - 1 - y) * pitch + width * 4] == 0);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Batch loads refuse what doesn't fit", "[TextureReader]")
+{
+    auto path = WritePPM("reader_small.ppm", 4, 4);
+    std::vector<uint8_t> buffer(4 * 4 * 3 - 1);
+
+    std::vector<ImageLoadRequest> requests(2);
+    requests[0].path = path;
+    requests[0].destination = buffer.data();
+    requests[0].destinationSize = buffer.size();
+    requests[1].path = TempPath("reader_missing.ppm");
+    requests[1].destination = buffer.data();
+    requests[1].destinationSize = buffer.size();
+
+    JobSystem jobs(0);
+    REQUIRE_FALSE(TextureReader::LoadImages(requests, jobs));
+    REQUIRE_FALSE(requests[0].loaded);
+    REQUIRE(requests[0].info.width == 4);
+    REQUIRE_FALSE(requests[1].loaded);
+
+    ImageInfo info;
+    REQUIRE(TextureReader::GetImageInfo(path, info));
+    REQUIRE(info.channels == 3);
+    REQUIRE(TextureReader::PixelSize(PixelType::Half, info.channels) == 6);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("HDR files load into ImageData and reuse its buffers", "[TextureReader]")
+{
+    const int width = 5, height = 4;
+    auto path = WriteHDR("reader_sky.hdr", width, height);
+    auto ldrPath = WritePPM("reader_ldr.ppm", 3, 2);
+
+    // LoadTexture leaves stb flipping HDR files, batch loads only flip when asked
+    ImageData flippedByStb;
+    TextureReader::LoadTexture(path, flippedByStb);
+    REQUIRE(flippedByStb.hdrData[0] == HDRValue(0, height - 1, 0));
+
+    std::vector<ImageData> images;
+    JobSystem jobs(2);
+    REQUIRE(TextureReader::LoadImages({ path, ldrPath }, images, jobs));
+    REQUIRE(images.size() == 2);
+    REQUIRE(images[0].isHDR);
+    REQUIRE(images[0].channels == 3);
+    REQUIRE_FALSE(images[1].isHDR);
+    REQUIRE(images[1].data.size() == 3 * 2 * 3);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            for (int c = 0; c < 3; ++c)
+                REQUIRE(images[0].hdrData[(y * width + x) * 3 + c] == HDRValue(x, y, c));
+
+    const float* hdrBuffer = images[0].hdrData.data();
+    REQUIRE(TextureReader::LoadImages({ path, ldrPath }, images, jobs, 0, true));
+    REQUIRE(images[0].hdrData.data() == hdrBuffer);
+    REQUIRE(images[0].hdrData[0] == HDRValue(0, height - 1, 0));
+
+    // RGB floats to RGBA halves
+    std::vector<uint16_t> halves(width * height * 4);
+    std::vector<ImageLoadRequest> requests(1);
+    requests[0].path = path;
+    requests[0].destination = halves.data();
+    requests[0].destinationSize = halves.size() * sizeof(uint16_t);
+    requests[0].type = PixelType::Half;
+    requests[0].channels = 4;
+    REQUIRE(TextureReader::LoadImages(requests, jobs));
+    REQUIRE(requests[0].info.isHDR);
+    REQUIRE(ImageConversion::HalfToFloat(halves[(1 * width + 3) * 4 + 2]) == HDRValue(3, 1, 2));
+    REQUIRE(halves[(1 * width + 3) * 4 + 3] == 0x3C00);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(ldrPath);
+}
+
+TEST_CASE("TextureReader load time over the HDRI folder", "[TextureReader][!benchmark]")
+{
+    auto hdri = FindHDRI();
+    if (hdri.empty())
+    {
+        WARN("HDRI folder not found, skipping");
+        return;
+    }
+
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(hdri))
+    {
+        if (entry.path().extension() == ".hdr")
+            files.push_back(entry.path().string());
+    }
+
+    // what LoadCubeMapHDR used to do, one face after another on the loading thread
+    BENCHMARK("Load HDRI, one file at a time")
+    {
+        size_t floats = 0;
+        for (const auto& file : files)
+        {
+            ImageData image;
+            TextureReader::LoadTexture(file, image);
+            floats += image.hdrData.size();
+        }
+        return floats;
+    };
+
+    std::vector<ImageData> images;
+    BENCHMARK("Load HDRI, job system")
+    {
+        TextureReader::LoadImages(files, images, JobSystem::Global());
+        return images.size();
+    };
+
+    // every file as RGBA halves in one buffer, ready for a texture array upload
+    std::vector<ImageLoadRequest> requests(files.size());
+    size_t total = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        ImageInfo info;
+        TextureReader::GetImageInfo(files[i], info);
+        requests[i].path = files[i];
+        requests[i].type = PixelType::Half;
+        requests[i].channels = 4;
+        requests[i].destinationSize = static_cast<size_t>(info.width) * info.height * TextureReader::PixelSize(PixelType::Half, 4);
+        total += requests[i].destinationSize;
+    }
+    std::vector<std::byte> halves(total);
+    size_t offset = 0;
+    for (auto& request : requests)
+    {
+        request.destination = halves.data() + offset;
+        offset += request.destinationSize;
+    }
+
+    BENCHMARK("Load HDRI as RGBA halves, job system")
+    {
+        return TextureReader::LoadImages(requests, JobSystem::Global());
+    };
+}
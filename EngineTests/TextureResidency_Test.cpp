@@ -0,0 +1,218 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <cmath>
+#include <vector>
+
+#include "TextureResidency.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // RGBA8 chain, a 1024 texture is 11 levels
+    std::vector<uint64_t> LevelBytes(uint32_t size)
+    {
+        std::vector<uint64_t> levels;
+        for (uint32_t s = size; ; s >>= 1)
+        {
+            levels.push_back(static_cast<uint64_t>(s) * s * 4);
+            if (s == 1) break;
+        }
+        return levels;
+    }
+
+    uint64_t BytesFrom(uint32_t size, uint32_t mip)
+    {
+        auto levels = LevelBytes(size);
+        uint64_t bytes = 0;
+        for (size_t i = mip; i < levels.size(); ++i) bytes += levels[i];
+        return bytes;
+    }
+
+    void Frame(TextureResidency& residency, const std::vector<std::pair<uint32_t, uint32_t>>& requests,
+        std::vector<ResidencyChange>& loads, std::vector<ResidencyChange>& evictions, bool completeLoads = true)
+    {
+        residency.BeginFrame();
+        for (auto [texture, mip] : requests)
+            residency.Request(texture, mip);
+        residency.Update(loads, evictions);
+        if (completeLoads)
+        {
+            for (const auto& load : loads)
+                residency.CompleteLoad(load.texture, true);
+        }
+    }
+}
+
+TEST_CASE("Textures start with their tail and load what is asked for", "[TextureResidency]")
+{
+    TextureResidency residency(64ull << 20, 64);
+    uint32_t texture = residency.Add(1024, 1024, LevelBytes(1024));
+
+    // 64x64 is mip 4
+    REQUIRE(residency.GetTailMip(texture) == 4);
+    REQUIRE(residency.GetResidentMip(texture) == 4);
+    REQUIRE(residency.GetUsedBytes() == BytesFrom(1024, 4));
+
+    std::vector<ResidencyChange> loads, evictions;
+    Frame(residency, { { texture, 1 }, { texture, 2 } }, loads, evictions, false);
+    REQUIRE(loads.size() == 1);
+    REQUIRE(loads[0].texture == texture);
+    REQUIRE(loads[0].fromMip == 4);
+    REQUIRE(loads[0].toMip == 1);
+    REQUIRE(evictions.empty());
+    // the load counts from the start and isn't started twice
+    REQUIRE(residency.IsLoading(texture));
+    REQUIRE(residency.GetUsedBytes() == BytesFrom(1024, 1));
+    Frame(residency, { { texture, 0 } }, loads, evictions, false);
+    REQUIRE(loads.empty());
+
+    residency.CompleteLoad(texture, true);
+    REQUIRE(residency.GetResidentMip(texture) == 1);
+    REQUIRE_FALSE(residency.IsLoading(texture));
+
+    // nothing is dropped while the budget holds, even when it's no longer needed
+    Frame(residency, {}, loads, evictions);
+    REQUIRE(loads.empty());
+    REQUIRE(evictions.empty());
+    REQUIRE(residency.GetResidentMip(texture) == 1);
+    REQUIRE(residency.GetRequestedMip(texture) == 4);
+}
+
+TEST_CASE("Loads over budget evict the least recently used textures", "[TextureResidency]")
+{
+    // room for two full 512 chains and the tails
+    uint64_t budget = 2 * BytesFrom(512, 0) + 2 * BytesFrom(512, 3);
+    TextureResidency residency(budget, 64);
+    uint32_t a = residency.Add(512, 512, LevelBytes(512));
+    uint32_t b = residency.Add(512, 512, LevelBytes(512));
+    uint32_t c = residency.Add(512, 512, LevelBytes(512));
+
+    std::vector<ResidencyChange> loads, evictions;
+    Frame(residency, { { a, 0 } }, loads, evictions);
+    Frame(residency, { { b, 0 } }, loads, evictions);
+    REQUIRE(residency.GetResidentMip(a) == 0);
+    REQUIRE(residency.GetResidentMip(b) == 0);
+
+    // a was last used first, so it goes back to its tail for c
+    Frame(residency, { { c, 0 } }, loads, evictions);
+    REQUIRE(evictions.size() == 1);
+    REQUIRE(evictions[0].texture == a);
+    REQUIRE(evictions[0].fromMip == 0);
+    REQUIRE(evictions[0].toMip == 3);
+    REQUIRE(loads.size() == 1);
+    REQUIRE(loads[0].texture == c);
+    REQUIRE(residency.GetResidentMip(a) == 3);
+    REQUIRE(residency.GetResidentMip(c) == 0);
+    REQUIRE(residency.GetUsedBytes() <= budget);
+
+    // textures asked for this frame are only trimmed to what they need
+    Frame(residency, { { a, 0 }, { b, 2 }, { c, 2 } }, loads, evictions);
+    REQUIRE(loads.size() == 1);
+    REQUIRE(loads[0].texture == a);
+    REQUIRE(loads[0].toMip == 0);
+    // one trim doesn't free a full chain, both go
+    REQUIRE(evictions.size() == 2);
+    REQUIRE(evictions[0].toMip == 2);
+    REQUIRE(evictions[1].toMip == 2);
+    REQUIRE(residency.GetResidentMip(b) == 2);
+    REQUIRE(residency.GetResidentMip(c) == 2);
+    REQUIRE(residency.GetUsedBytes() <= budget);
+}
+
+TEST_CASE("A load that can't fit loads as much as does", "[TextureResidency]")
+{
+    uint64_t budget = BytesFrom(1024, 2);
+    TextureResidency residency(budget, 64);
+    uint32_t texture = residency.Add(1024, 1024, LevelBytes(1024));
+
+    std::vector<ResidencyChange> loads, evictions;
+    Frame(residency, { { texture, 0 } }, loads, evictions);
+    REQUIRE(loads.size() == 1);
+    REQUIRE(loads[0].toMip == 2);
+    REQUIRE(residency.GetUsedBytes() == budget);
+
+    // and nothing more until the budget grows
+    Frame(residency, { { texture, 0 } }, loads, evictions);
+    REQUIRE(loads.empty());
+    residency.SetBudget(BytesFrom(1024, 0));
+    Frame(residency, { { texture, 0 } }, loads, evictions);
+    REQUIRE(loads.size() == 1);
+    REQUIRE(loads[0].fromMip == 2);
+    REQUIRE(loads[0].toMip == 0);
+
+    // a smaller budget evicts without anything loading
+    residency.SetBudget(BytesFrom(1024, 3));
+    Frame(residency, {}, loads, evictions);
+    REQUIRE(evictions.size() == 1);
+    REQUIRE(evictions[0].toMip == 4);
+    REQUIRE(residency.GetUsedBytes() <= residency.GetBudget());
+}
+
+TEST_CASE("The worst off textures load first, a few a frame", "[TextureResidency]")
+{
+    TextureResidency residency(1ull << 30, 64);
+    std::vector<uint32_t> textures;
+    for (int i = 0; i < 6; ++i)
+        textures.push_back(residency.Add(1024, 1024, LevelBytes(1024)));
+
+    residency.BeginFrame();
+    for (uint32_t i = 0; i < textures.size(); ++i)
+        residency.Request(textures[i], i % 4);
+
+    std::vector<ResidencyChange> loads, evictions;
+    residency.Update(loads, evictions, 3);
+    REQUIRE(loads.size() == 3);
+    REQUIRE(loads[0].toMip == 0);
+    REQUIRE(loads[1].toMip == 0);
+    REQUIRE(loads[2].toMip == 1);
+}
+
+TEST_CASE("Failed and removed textures give their bytes back", "[TextureResidency]")
+{
+    TextureResidency residency(1ull << 30, 64);
+    uint32_t failing = residency.Add(256, 256, LevelBytes(256));
+    uint32_t removed = residency.Add(256, 256, LevelBytes(256));
+    uint64_t tails = residency.GetUsedBytes();
+
+    std::vector<ResidencyChange> loads, evictions;
+    Frame(residency, { { failing, 0 }, { removed, 0 } }, loads, evictions, false);
+    REQUIRE(loads.size() == 2);
+
+    residency.CompleteLoad(failing, false);
+    REQUIRE(residency.GetResidentMip(failing) == 2);
+    REQUIRE_FALSE(residency.IsLoading(failing));
+
+    // the id isn't reused while its load is out
+    residency.Remove(removed);
+    REQUIRE(residency.GetUsedBytes() == tails - BytesFrom(256, 2));
+    uint32_t added = residency.Add(256, 256, LevelBytes(256));
+    REQUIRE(added != removed);
+    residency.CompleteLoad(removed, true);
+    REQUIRE(residency.GetUsedBytes() == tails);
+    REQUIRE(residency.Add(256, 256, LevelBytes(256)) == removed);
+
+    // a failed texture isn't tried again
+    Frame(residency, { { failing, 0 } }, loads, evictions);
+    REQUIRE(loads.empty());
+}
+
+TEST_CASE("Screen size picks the mip", "[TextureResidency]")
+{
+    REQUIRE(TextureResidency::RequiredMip(1024, 1024, 11, 2000.0f) == 0);
+    REQUIRE(TextureResidency::RequiredMip(1024, 1024, 11, 1024.0f) == 0);
+    REQUIRE(TextureResidency::RequiredMip(1024, 1024, 11, 1000.0f) == 0);
+    REQUIRE(TextureResidency::RequiredMip(1024, 1024, 11, 512.0f) == 1);
+    REQUIRE(TextureResidency::RequiredMip(1024, 256, 11, 300.0f) == 1);
+    REQUIRE(TextureResidency::RequiredMip(1024, 1024, 11, 1.0f) == 10);
+    REQUIRE(TextureResidency::RequiredMip(1024, 1024, 11, 0.01f) == 10);
+    REQUIRE(TextureResidency::RequiredMip(1024, 1024, 11, 0.0f) == 10);
+
+    // a unit sphere 10 away with a 90 degree fov on 1000 rows covers 100 of them
+    float fov = 3.14159265f * 0.5f;
+    REQUIRE(TextureResidency::ScreenSize(1.0f, 10.0f, fov, 1000.0f) == Catch::Approx(100.0f).epsilon(1e-4));
+    REQUIRE(TextureResidency::ScreenSize(1.0f, 20.0f, fov, 1000.0f) == Catch::Approx(50.0f).epsilon(1e-4));
+    // from inside it counts as touching it
+    REQUIRE(TextureResidency::ScreenSize(1.0f, 0.5f, fov, 1000.0f) == Catch::Approx(1000.0f).epsilon(1e-4));
+}
@@ -0,0 +1,206 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "TransformHierarchy.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // Mirrors the previous pointer based Node::UpdateTransforms so the flat path can be checked and timed against it
+    struct RecursiveNode
+    {
+        glm::vec3 translation{ 0.0f };
+        glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+        glm::vec3 scale{ 1.0f };
+        glm::mat4 globalTransform{ 1.0f };
+        std::vector<RecursiveNode*> children;
+
+        glm::mat4 GetLocalTransform() const
+        {
+            glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), translation);
+            glm::mat4 rotationMatrix = glm::toMat4(rotation);
+            glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), scale);
+            return translationMatrix * rotationMatrix * scaleMatrix;
+        }
+
+        void UpdateTransforms(const glm::mat4& parentTransform = glm::mat4(1.0f))
+        {
+            globalTransform = parentTransform * GetLocalTransform();
+            for (auto& child : children)
+            {
+                child->UpdateTransforms(globalTransform);
+            }
+        }
+    };
+
+    struct TestScene
+    {
+        std::vector<std::unique_ptr<RecursiveNode>> nodes;
+        std::vector<TransformHandle> handles;
+        TransformHierarchy hierarchy;
+    };
+
+    // Random tree where every node parents to an earlier one, which keeps creation order parent-before-child
+    void BuildScene(TestScene& scene, size_t count, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(-2.0f, 2.0f);
+        std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+        std::uniform_real_distribution<float> scl(0.9f, 1.1f);
+
+        scene.nodes.reserve(count);
+        scene.handles.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto node = std::make_unique<RecursiveNode>();
+            node->translation = glm::vec3(pos(rng), pos(rng), pos(rng));
+            node->rotation = glm::angleAxis(angle(rng), glm::normalize(glm::vec3(pos(rng), pos(rng), pos(rng)) + glm::vec3(0.01f)));
+            node->scale = glm::vec3(scl(rng));
+
+            TransformHandle handle = scene.hierarchy.Create();
+            scene.hierarchy.SetTRS(handle, node->translation, node->rotation, node->scale);
+
+            if (i > 0)
+            {
+                size_t parent = std::uniform_int_distribution<size_t>(0, i - 1)(rng);
+                scene.nodes[parent]->children.push_back(node.get());
+                scene.hierarchy.SetParent(handle, scene.handles[parent]);
+            }
+
+            scene.nodes.push_back(std::move(node));
+            scene.handles.push_back(handle);
+        }
+    }
+
+    bool MatricesMatch(const glm::mat4& a, const glm::mat4& b, float tolerance)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 4; ++r)
+            {
+                float scale = std::max(1.0f, std::abs(b[c][r]));
+                if (std::abs(a[c][r] - b[c][r]) > tolerance * scale) return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE("TransformHierarchy matches the recursive node update", "[TransformHierarchy]")
+{
+    TestScene scene;
+    BuildScene(scene, 2000, 7);
+
+    scene.nodes[0]->UpdateTransforms();
+    scene.hierarchy.Update();
+
+    for (size_t i = 0; i < scene.nodes.size(); ++i)
+    {
+        REQUIRE(MatricesMatch(scene.hierarchy.GetWorldTransform(scene.handles[i]), scene.nodes[i]->globalTransform, 1e-3f));
+    }
+
+    SECTION("Editing a node only touches its subtree and still matches")
+    {
+        scene.nodes[10]->translation = glm::vec3(5.0f, 0.0f, -3.0f);
+        scene.hierarchy.SetTranslation(scene.handles[10], scene.nodes[10]->translation);
+        REQUIRE(scene.hierarchy.HasPendingUpdates());
+
+        scene.nodes[0]->UpdateTransforms();
+        scene.hierarchy.Update();
+        REQUIRE_FALSE(scene.hierarchy.HasPendingUpdates());
+
+        for (size_t i = 0; i < scene.nodes.size(); ++i)
+        {
+            REQUIRE(MatricesMatch(scene.hierarchy.GetWorldTransform(scene.handles[i]), scene.nodes[i]->globalTransform, 1e-3f));
+        }
+    }
+}
+
+TEST_CASE("TransformHierarchy re-sorts when a parent is created after its child", "[TransformHierarchy]")
+{
+    TransformHierarchy hierarchy;
+
+    TransformHandle child = hierarchy.Create();
+    TransformHandle grandChild = hierarchy.Create();
+    TransformHandle parent = hierarchy.Create();
+
+    hierarchy.SetParent(grandChild, child);
+    hierarchy.SetParent(child, parent);
+
+    hierarchy.SetTranslation(parent, glm::vec3(1.0f, 0.0f, 0.0f));
+    hierarchy.SetTranslation(child, glm::vec3(0.0f, 2.0f, 0.0f));
+    hierarchy.SetTranslation(grandChild, glm::vec3(0.0f, 0.0f, 3.0f));
+    hierarchy.Update();
+
+    glm::vec3 worldPos = glm::vec3(hierarchy.GetWorldTransform(grandChild)[3]);
+    REQUIRE(worldPos.x == Catch::Approx(1.0f));
+    REQUIRE(worldPos.y == Catch::Approx(2.0f));
+    REQUIRE(worldPos.z == Catch::Approx(3.0f));
+    REQUIRE(hierarchy.GetParent(child) == parent);
+}
+
+TEST_CASE("TransformHierarchy detaches children of destroyed transforms", "[TransformHierarchy]")
+{
+    TransformHierarchy hierarchy;
+
+    TransformHandle parent = hierarchy.Create();
+    TransformHandle child = hierarchy.Create();
+    hierarchy.SetParent(child, parent);
+    hierarchy.SetTranslation(parent, glm::vec3(10.0f, 0.0f, 0.0f));
+    hierarchy.SetTranslation(child, glm::vec3(1.0f, 0.0f, 0.0f));
+    REQUIRE(hierarchy.GetWorldTransform(child)[3].x == Catch::Approx(11.0f));
+
+    hierarchy.Destroy(parent);
+    hierarchy.Update();
+
+    REQUIRE(hierarchy.Size() == 1);
+    REQUIRE(hierarchy.GetParent(child) == InvalidTransformHandle);
+    REQUIRE(hierarchy.GetWorldTransform(child)[3].x == Catch::Approx(1.0f));
+
+    // The freed handle is recycled once compacted
+    REQUIRE(hierarchy.Create() == parent);
+}
+
+TEST_CASE("TransformHierarchy benchmark against recursive update", "[TransformHierarchy][!benchmark]")
+{
+    constexpr size_t nodeCount = 100000;
+
+    TestScene scene;
+    BuildScene(scene, nodeCount, 42);
+    scene.hierarchy.Update();
+
+    BENCHMARK("Recursive Node::UpdateTransforms (100k nodes)")
+    {
+        scene.nodes[0]->UpdateTransforms();
+        return scene.nodes.back()->globalTransform[3].x;
+    };
+
+    BENCHMARK("Flat update, everything dirty (100k nodes)")
+    {
+        scene.hierarchy.MarkDirty(scene.handles[0]);
+        scene.hierarchy.Update();
+        return scene.hierarchy.GetWorldTransforms().back()[3].x;
+    };
+
+    BENCHMARK("Flat update, 1% of nodes animated (100k nodes)")
+    {
+        for (size_t i = nodeCount - nodeCount / 100; i < nodeCount; ++i)
+        {
+            scene.hierarchy.MarkDirty(scene.handles[i]);
+        }
+        scene.hierarchy.Update();
+        return scene.hierarchy.GetWorldTransforms().back()[3].x;
+    };
+}
\ No newline at end of file
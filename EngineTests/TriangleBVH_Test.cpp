@@ -0,0 +1,271 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "TriangleBVH.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    // Same layout as the v0/v1/v2 part of TriWithEmisison
+    struct TestTriangle
+    {
+        glm::vec3 v0;
+        glm::vec3 v1;
+        glm::vec3 v2;
+    };
+
+    void AddQuad(std::vector<TestTriangle>& tris, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d)
+    {
+        tris.push_back({ a, b, c });
+        tris.push_back({ a, c, d });
+    }
+
+    void AddBox(std::vector<TestTriangle>& tris, const glm::vec3& mn, const glm::vec3& mx)
+    {
+        glm::vec3 p[8] =
+        {
+            { mn.x, mn.y, mn.z }, { mx.x, mn.y, mn.z }, { mx.x, mx.y, mn.z }, { mn.x, mx.y, mn.z },
+            { mn.x, mn.y, mx.z }, { mx.x, mn.y, mx.z }, { mx.x, mx.y, mx.z }, { mn.x, mx.y, mx.z }
+        };
+        AddQuad(tris, p[0], p[1], p[2], p[3]);
+        AddQuad(tris, p[5], p[4], p[7], p[6]);
+        AddQuad(tris, p[4], p[0], p[3], p[7]);
+        AddQuad(tris, p[1], p[5], p[6], p[2]);
+        AddQuad(tris, p[3], p[2], p[6], p[7]);
+        AddQuad(tris, p[4], p[5], p[1], p[0]);
+    }
+
+    // Ground plane with a grid of buildings, 12 triangles per box
+    std::vector<TestTriangle> MakeCity(int buildingsPerSide, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> height(2.0f, 30.0f);
+        std::uniform_real_distribution<float> size(1.0f, 4.0f);
+
+        std::vector<TestTriangle> tris;
+        float half = buildingsPerSide * 5.0f;
+        AddQuad(tris, { -half, 0.0f, -half }, { -half, 0.0f, half }, { half, 0.0f, half }, { half, 0.0f, -half });
+
+        for (int z = 0; z < buildingsPerSide; ++z)
+        {
+            for (int x = 0; x < buildingsPerSide; ++x)
+            {
+                glm::vec3 centre(x * 10.0f - half + 5.0f, 0.0f, z * 10.0f - half + 5.0f);
+                glm::vec3 e(size(rng), height(rng), size(rng));
+                AddBox(tris, centre - glm::vec3(e.x, 0.0f, e.z), centre + e);
+            }
+        }
+        return tris;
+    }
+
+    // Probe style rays, spherical directions from points scattered above the ground
+    std::vector<BVHRay> MakeProbeRays(size_t count, float extent, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(-extent, extent);
+        std::uniform_real_distribution<float> height(0.5f, 20.0f);
+        std::normal_distribution<float> dir(0.0f, 1.0f);
+
+        std::vector<BVHRay> rays(count);
+        for (auto& ray : rays)
+        {
+            ray.origin = glm::vec3(pos(rng), height(rng), pos(rng));
+            ray.direction = glm::normalize(glm::vec3(dir(rng), dir(rng), dir(rng)) + glm::vec3(1e-4f));
+            ray.maxDistance = 100.0f;
+        }
+        return rays;
+    }
+
+    float BruteForceClosest(const std::vector<TestTriangle>& tris, const BVHRay& ray)
+    {
+        float closest = ray.maxDistance;
+        bool found = false;
+        for (const auto& tri : tris)
+        {
+            glm::vec3 e1 = tri.v1 - tri.v0;
+            glm::vec3 e2 = tri.v2 - tri.v0;
+            glm::vec3 pvec = glm::cross(ray.direction, e2);
+            float det = glm::dot(e1, pvec);
+            if (std::abs(det) < 1e-12f) continue;
+            float invDet = 1.0f / det;
+            glm::vec3 tvec = ray.origin - tri.v0;
+            float u = glm::dot(tvec, pvec) * invDet;
+            if (u < 0.0f || u > 1.0f) continue;
+            glm::vec3 qvec = glm::cross(tvec, e1);
+            float v = glm::dot(ray.direction, qvec) * invDet;
+            if (v < 0.0f || u + v > 1.0f) continue;
+            float t = glm::dot(e2, qvec) * invDet;
+            if (t > 0.0f && t < closest)
+            {
+                closest = t;
+                found = true;
+            }
+        }
+        return found ? closest : -1.0f;
+    }
+}
+
+TEST_CASE("TriangleBVH closest hit matches brute force", "[TriangleBVH]")
+{
+    auto tris = MakeCity(12, 1);
+    auto rays = MakeProbeRays(2000, 60.0f, 2);
+
+    TriangleBVH bvh;
+    bvh.Build(tris, 1);
+    REQUIRE(bvh.GetTriangleCount() == tris.size());
+
+    for (const auto& ray : rays)
+    {
+        float expected = BruteForceClosest(tris, ray);
+
+        TriangleHit hit;
+        bool found = bvh.Intersect(ray, hit);
+        REQUIRE(found == (expected >= 0.0f));
+        if (found)
+        {
+            REQUIRE(hit.distance == Catch::Approx(expected).margin(1e-4));
+
+            // the reported triangle and barycentrics reproduce the hit point
+            const auto& tri = tris[hit.triangle];
+            glm::vec3 point = tri.v0 + (tri.v1 - tri.v0) * hit.u + (tri.v2 - tri.v0) * hit.v;
+            glm::vec3 along = ray.origin + ray.direction * hit.distance;
+            REQUIRE(glm::length(point - along) < 1e-3f);
+        }
+        REQUIRE(bvh.Occluded(ray) == found);
+    }
+}
+
+TEST_CASE("TriangleBVH packets match single rays", "[TriangleBVH]")
+{
+    auto tris = MakeCity(16, 3);
+    // not a multiple of 4, the batch call finishes the tail with single rays
+    auto rays = MakeProbeRays(4003, 80.0f, 4);
+
+    TriangleBVH bvh;
+    bvh.Build(tris);
+
+    std::vector<TriangleHit> packetHits;
+    bvh.IntersectRays(rays, packetHits);
+
+    for (size_t i = 0; i < rays.size(); ++i)
+    {
+        TriangleHit hit;
+        bool found = bvh.Intersect(rays[i], hit);
+        REQUIRE(packetHits[i].IsHit() == found);
+        if (found)
+        {
+            REQUIRE(packetHits[i].distance == Catch::Approx(hit.distance).margin(1e-4));
+        }
+    }
+
+    for (size_t i = 0; i + 4 <= rays.size(); i += 4)
+    {
+        bool occluded[4];
+        bvh.Occluded4(&rays[i], occluded);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            REQUIRE(occluded[lane] == packetHits[i + lane].IsHit());
+        }
+    }
+}
+
+TEST_CASE("TriangleBVH multithreaded build gives the same answers", "[TriangleBVH]")
+{
+    auto tris = MakeCity(40, 5);
+    auto rays = MakeProbeRays(1000, 200.0f, 6);
+
+    TriangleBVH serial, parallel;
+    serial.Build(tris, 1);
+    parallel.Build(tris, 8);
+
+    // node ranges must cover every triangle exactly once
+    size_t leafTriangles = 0;
+    for (const auto& node : parallel.GetBVH().GetNodes())
+    {
+        if (node.IsLeaf()) leafTriangles += node.count;
+    }
+    REQUIRE(leafTriangles == tris.size());
+
+    for (const auto& ray : rays)
+    {
+        TriangleHit a, b;
+        REQUIRE(serial.Intersect(ray, a) == parallel.Intersect(ray, b));
+        if (a.IsHit())
+        {
+            REQUIRE(a.distance == Catch::Approx(b.distance).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE("TriangleBVH benchmark", "[TriangleBVH][!benchmark]")
+{
+    // ~120k triangles, about the size of a small city block export
+    auto tris = MakeCity(100, 7);
+    constexpr size_t rayCount = 1 << 16;
+    auto rays = MakeProbeRays(rayCount, 500.0f, 8);
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    BENCHMARK("Build, 1 thread (120k triangles)")
+    {
+        TriangleBVH bvh;
+        bvh.Build(tris, 1);
+        return bvh.GetTriangleCount();
+    };
+
+    BENCHMARK("Build, all threads (120k triangles)")
+    {
+        TriangleBVH bvh;
+        bvh.Build(tris, threads);
+        return bvh.GetTriangleCount();
+    };
+
+    TriangleBVH bvh;
+    bvh.Build(tris);
+    std::vector<TriangleHit> hits(rays.size());
+
+    BENCHMARK("Closest hit, single rays (64k rays)")
+    {
+        int found = 0;
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            found += bvh.Intersect(rays[i], hits[i]) ? 1 : 0;
+        }
+        return found;
+    };
+
+    BENCHMARK("Closest hit, 4 ray packets (64k rays)")
+    {
+        bvh.IntersectRays(rays, hits);
+        return hits[0].distance;
+    };
+
+    BENCHMARK("Any hit, 4 ray packets (64k rays)")
+    {
+        int found = 0;
+        bool occluded[4];
+        for (size_t i = 0; i < rays.size(); i += 4)
+        {
+            bvh.Occluded4(&rays[i], occluded);
+            found += occluded[0] + occluded[1] + occluded[2] + occluded[3];
+        }
+        return found;
+    };
+
+    // everything above runs on one core, so this is the per core figure
+    auto start = std::chrono::high_resolution_clock::now();
+    bvh.IntersectRays(rays, hits);
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "TriangleBVH closest hit: " << static_cast<uint64_t>(rayCount / seconds) << " rays/sec/core" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "VertexQuantization.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    const VertexAttribKey StaticKey =
+        static_cast<VertexAttribKey>(AttributeType::POSITION) | static_cast<VertexAttribKey>(AttributeType::NORMAL) |
+        static_cast<VertexAttribKey>(AttributeType::TEX_COORD_0) | static_cast<VertexAttribKey>(AttributeType::TANGENT);
+
+    // Directions spread evenly over the sphere plus the axes and octant diagonals, where the
+    // octahedral fold is
+    std::vector<glm::vec3> TestDirections()
+    {
+        std::vector<glm::vec3> directions;
+        const int count = 4096;
+        const float goldenAngle = 2.39996323f;
+        for (int i = 0; i < count; ++i)
+        {
+            float z = 1.0f - 2.0f * (i + 0.5f) / count;
+            float r = std::sqrt(1.0f - z * z);
+            float phi = goldenAngle * i;
+            directions.push_back(glm::vec3(r * std::cos(phi), r * std::sin(phi), z));
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            glm::vec3 d(0.0f);
+            d[axis] = 1.0f;
+            directions.push_back(d);
+            directions.push_back(-d);
+        }
+        for (int octant = 0; octant < 8; ++octant)
+        {
+            glm::vec3 d((octant & 1) ? -1.0f : 1.0f, (octant & 2) ? -1.0f : 1.0f, (octant & 4) ? -1.0f : 1.0f);
+            directions.push_back(glm::normalize(d));
+        }
+        return directions;
+    }
+
+    // atan2 of the cross and dot products, acos of a float dot can't resolve angles this small
+    float AngleBetween(const glm::vec3& a, const glm::vec3& b)
+    {
+        double cx = double(a.y) * b.z - double(a.z) * b.y;
+        double cy = double(a.z) * b.x - double(a.x) * b.z;
+        double cz = double(a.x) * b.y - double(a.y) * b.x;
+        double dot = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+        return static_cast<float>(std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot));
+    }
+
+    uint32_t ReadWord(const std::byte* data)
+    {
+        uint32_t word;
+        std::memcpy(&word, data, sizeof(word));
+        return word;
+    }
+}
+
+TEST_CASE("Compact keys are smaller and only change the attributes they encode", "[VertexQuantization]")
+{
+    VertexAttribKey compactKey = StaticKey | CompactVertexFormat;
+
+    REQUIRE(IsCompactVertexFormat(compactKey));
+    REQUIRE_FALSE(IsCompactVertexFormat(StaticKey));
+    REQUIRE(CalculateStrideInBytes(StaticKey) == 48);
+    REQUIRE(CalculateStrideInBytes(compactKey) == 24);
+
+    // the format bit isn't an attribute and the position stays float for the CPU side readers
+    REQUIRE_FALSE(HasVertexAttribKey(compactKey, AttributeType::JOINT_0));
+    REQUIRE(GetVertexAttribFormat(compactKey, AttributeType::POSITION).SizeInBytes() == 12);
+    REQUIRE(GetVertexAttribFormat(compactKey, AttributeType::NORMAL).type == VertexComponentType::Short);
+    REQUIRE(GetVertexAttribFormat(compactKey, AttributeType::NORMAL).normalized);
+    REQUIRE(GetVertexAttribFormat(compactKey, AttributeType::TEX_COORD_0).type == VertexComponentType::HalfFloat);
+}
+
+TEST_CASE("Octahedral normals round trip within a hundredth of a degree", "[VertexQuantization]")
+{
+    float worst = 0.0f;
+    for (const auto& n : TestDirections())
+    {
+        glm::vec3 decoded = VertexQuantization::UnpackNormal(VertexQuantization::PackNormal(n));
+        REQUIRE(std::abs(glm::length(decoded) - 1.0f) < 1e-5f);
+        worst = std::max(worst, AngleBetween(n, decoded));
+    }
+
+    // 16 bits a coordinate resolves roughly 0.005 degrees
+    REQUIRE(worst < glm::radians(0.01f));
+}
+
+TEST_CASE("Compact tangents keep their handedness", "[VertexQuantization]")
+{
+    float worst = 0.0f;
+    for (const auto& t : TestDirections())
+    {
+        for (float w : { 1.0f, -1.0f })
+        {
+            glm::vec4 decoded = VertexQuantization::UnpackTangent(VertexQuantization::PackTangent(glm::vec4(t, w)));
+            REQUIRE(decoded.w == w);
+            worst = std::max(worst, AngleBetween(t, glm::vec3(decoded)));
+        }
+    }
+
+    // the handedness bit costs the second coordinate one step
+    REQUIRE(worst < glm::radians(0.02f));
+}
+
+TEST_CASE("Half float texture coordinates stay within half a step", "[VertexQuantization]")
+{
+    for (int i = 0; i <= 1024; ++i)
+    {
+        float u = i / 1024.0f;
+        glm::vec2 uv(u, 1.0f - u * 0.7f);
+        glm::vec2 decoded = VertexQuantization::UnpackTexCoord(VertexQuantization::PackTexCoord(uv));
+
+        // 11 significant bits, below 1 a step is at most 2^-11
+        REQUIRE(std::abs(decoded.x - uv.x) <= 0.5f / 2048.0f);
+        REQUIRE(std::abs(decoded.y - uv.y) <= 0.5f / 2048.0f);
+    }
+
+    // tiling uvs outside [0, 1] keep the same relative precision
+    glm::vec2 tiled(-7.3f, 12.85f);
+    glm::vec2 decoded = VertexQuantization::UnpackTexCoord(VertexQuantization::PackTexCoord(tiled));
+    REQUIRE(std::abs(decoded.x - tiled.x) <= std::abs(tiled.x) / 2048.0f);
+    REQUIRE(std::abs(decoded.y - tiled.y) <= std::abs(tiled.y) / 2048.0f);
+}
+
+TEST_CASE("Compact interleaving matches the float attributes it came from", "[VertexQuantization]")
+{
+    std::vector<float> positions, normals, texCoords, texCoords2, tangents;
+    auto directions = TestDirections();
+    for (size_t i = 0; i < directions.size(); ++i)
+    {
+        const glm::vec3& n = directions[i];
+        positions.insert(positions.end(), { n.x * 10.0f + 0.1f, n.y * -3.0f, n.z * 123.456f });
+        normals.insert(normals.end(), { n.x, n.y, n.z });
+        texCoords.insert(texCoords.end(), { (i % 97) / 96.0f, (i % 13) / 12.0f });
+
+        glm::vec3 t = glm::normalize(glm::cross(n, std::abs(n.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f)));
+        tangents.insert(tangents.end(), { t.x, t.y, t.z, (i & 1) ? -1.0f : 1.0f });
+    }
+
+    std::vector<std::byte> vertexData;
+    VertexQuantization::InterleaveCompact(positions, normals, texCoords, texCoords2, tangents, vertexData);
+
+    uint32_t stride = CalculateStrideInBytes(StaticKey | CompactVertexFormat);
+    size_t vertexCount = directions.size();
+    REQUIRE(vertexData.size() == vertexCount * stride);
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const std::byte* vertex = vertexData.data() + i * stride;
+
+        // positions are copied as they are
+        REQUIRE(std::memcmp(vertex, &positions[i * 3], sizeof(float) * 3) == 0);
+
+        glm::vec3 normal = VertexQuantization::UnpackNormal(ReadWord(vertex + 12));
+        REQUIRE(AngleBetween(normal, glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2])) < glm::radians(0.01f));
+
+        glm::vec2 uv = VertexQuantization::UnpackTexCoord(ReadWord(vertex + 16));
+        REQUIRE(std::abs(uv.x - texCoords[i * 2]) <= 0.5f / 2048.0f);
+        REQUIRE(std::abs(uv.y - texCoords[i * 2 + 1]) <= 0.5f / 2048.0f);
+
+        glm::vec4 tangent = VertexQuantization::UnpackTangent(ReadWord(vertex + 20));
+        REQUIRE(tangent.w == tangents[i * 4 + 3]);
+        REQUIRE(AngleBetween(glm::vec3(tangent), glm::vec3(tangents[i * 4], tangents[i * 4 + 1], tangents[i * 4 + 2])) < glm::radians(0.02f));
+    }
+}
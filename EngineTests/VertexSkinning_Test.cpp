@@ -0,0 +1,164 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "VertexSkinning.h"
+
+using namespace JLEngine;
+
+namespace
+{
+    const VertexAttribKey SkinnedKey =
+        static_cast<VertexAttribKey>(AttributeType::POSITION) | static_cast<VertexAttribKey>(AttributeType::NORMAL) |
+        static_cast<VertexAttribKey>(AttributeType::TEX_COORD_0) | static_cast<VertexAttribKey>(AttributeType::TANGENT) |
+        static_cast<VertexAttribKey>(AttributeType::JOINT_0) | static_cast<VertexAttribKey>(AttributeType::WEIGHT_0);
+
+    struct TestVertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+        glm::vec4 tangent;
+        uint16_t joints[4];
+        glm::vec4 weights;
+    };
+
+    // interleaved the way the skinned VAO stores it
+    void AppendVertex(std::vector<std::byte>& data, const SkinnedVertexLayout& layout, const TestVertex& vertex)
+    {
+        size_t base = data.size();
+        data.resize(base + layout.stride);
+        std::byte* out = data.data() + base;
+        std::memcpy(out + layout.position, &vertex.position, sizeof(glm::vec3));
+        std::memcpy(out + layout.normal, &vertex.normal, sizeof(glm::vec3));
+        std::memcpy(out + layout.texCoord, &vertex.texCoord, sizeof(glm::vec2));
+        std::memcpy(out + layout.tangent, &vertex.tangent, sizeof(glm::vec4));
+        std::memcpy(out + layout.joints, vertex.joints, sizeof(vertex.joints));
+        std::memcpy(out + layout.weights, &vertex.weights, sizeof(glm::vec4));
+    }
+
+    bool Near(const float* a, glm::vec3 b, float epsilon = 1e-5f)
+    {
+        return std::abs(a[0] - b.x) < epsilon && std::abs(a[1] - b.y) < epsilon && std::abs(a[2] - b.z) < epsilon;
+    }
+}
+
+TEST_CASE("SkinnedVertexLayout follows the vertex array attribute order", "[VertexSkinning]")
+{
+    auto layout = SkinnedVertexLayout::FromAttribKey(SkinnedKey);
+    REQUIRE(layout.position == 0);
+    REQUIRE(layout.normal == 12);
+    REQUIRE(layout.texCoord == 24);
+    REQUIRE(layout.tangent == 32);
+    REQUIRE(layout.joints == 48);
+    REQUIRE(layout.weights == 56);
+    REQUIRE(layout.stride == 72);
+    REQUIRE(layout.CanSkin());
+
+    // colours sit between the uvs and the tangent
+    auto withColour = SkinnedVertexLayout::FromAttribKey(SkinnedKey | static_cast<VertexAttribKey>(AttributeType::COLOUR));
+    REQUIRE(withColour.tangent == 48);
+    REQUIRE(withColour.stride == 88);
+
+    auto rigid = SkinnedVertexLayout::FromAttribKey(VertexSkinning::PreskinnedAttribKey);
+    REQUIRE(rigid.stride == sizeof(PreskinnedVertex));
+    REQUIRE_FALSE(rigid.CanSkin());
+}
+
+TEST_CASE("VertexSkinning matches hand skinned vertices", "[VertexSkinning]")
+{
+    auto layout = SkinnedVertexLayout::FromAttribKey(SkinnedKey);
+
+    std::vector<glm::mat4> palette =
+    {
+        glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+        glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 2.0f, 0.0f)),
+        glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 1.0f, 1.0f)),
+    };
+
+    glm::vec3 diagonal = glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f));
+    std::vector<std::byte> source;
+    // one joint, translated
+    AppendVertex(source, layout, { glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.25f, 0.75f), glm::vec4(1.0f, 0.0f, 0.0f, -1.0f), { 0, 0, 0, 0 }, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f) });
+    // half and half of two translations
+    AppendVertex(source, layout, { glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), { 0, 1, 0, 0 }, glm::vec4(0.5f, 0.5f, 0.0f, 0.0f) });
+    // non uniform scale, the normal needs the inverse transpose
+    AppendVertex(source, layout, { glm::vec3(1.0f, 1.0f, 0.0f), diagonal, glm::vec2(0.0f), glm::vec4(diagonal, 1.0f), { 2, 0, 0, 0 }, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f) });
+    // weights that don't sum to one are normalized
+    AppendVertex(source, layout, { glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), { 0, 1, 0, 0 }, glm::vec4(0.25f, 0.25f, 0.0f, 0.0f) });
+    // no weight keeps the bind pose
+    AppendVertex(source, layout, { glm::vec3(3.0f, 4.0f, 5.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), { 1, 1, 1, 1 }, glm::vec4(0.0f) });
+
+    std::vector<PreskinnedVertex> skinned(5);
+    VertexSkinning::SkinVertices(source.data(), layout, 5, palette.data(), skinned.data());
+
+    REQUIRE(Near(skinned[0].position, glm::vec3(1.0f, 1.0f, 0.0f)));
+    REQUIRE(Near(skinned[0].normal, glm::vec3(0.0f, 1.0f, 0.0f)));
+    REQUIRE(skinned[0].texCoord[0] == 0.25f);
+    REQUIRE(skinned[0].texCoord[1] == 0.75f);
+    REQUIRE(skinned[0].tangent[3] == -1.0f);
+
+    REQUIRE(Near(skinned[1].position, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+    REQUIRE(Near(skinned[2].position, glm::vec3(2.0f, 1.0f, 0.0f)));
+    REQUIRE(Near(skinned[2].normal, glm::normalize(glm::vec3(0.5f, 1.0f, 0.0f))));
+    REQUIRE(Near(skinned[2].tangent, glm::normalize(glm::vec3(0.5f, 1.0f, 0.0f))));
+
+    REQUIRE(Near(skinned[3].position, glm::vec3(0.0f, 1.0f, 0.0f)));
+    REQUIRE(Near(skinned[4].position, glm::vec3(3.0f, 4.0f, 5.0f)));
+}
+
+TEST_CASE("VertexSkinning fills in attributes the mesh doesn't have", "[VertexSkinning]")
+{
+    VertexAttribKey key = static_cast<VertexAttribKey>(AttributeType::POSITION) |
+        static_cast<VertexAttribKey>(AttributeType::JOINT_0) | static_cast<VertexAttribKey>(AttributeType::WEIGHT_0);
+    auto layout = SkinnedVertexLayout::FromAttribKey(key);
+    REQUIRE(layout.CanSkin());
+    REQUIRE(layout.normal == SkinnedVertexLayout::NoAttribute);
+
+    std::vector<std::byte> source(layout.stride);
+    glm::vec3 position(1.0f, 2.0f, 3.0f);
+    uint16_t joints[4] = { 0, 0, 0, 0 };
+    glm::vec4 weights(1.0f, 0.0f, 0.0f, 0.0f);
+    std::memcpy(source.data() + layout.position, &position, sizeof(position));
+    std::memcpy(source.data() + layout.joints, joints, sizeof(joints));
+    std::memcpy(source.data() + layout.weights, &weights, sizeof(weights));
+
+    glm::mat4 palette = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    PreskinnedVertex skinned{};
+    VertexSkinning::SkinVertices(source.data(), layout, 1, &palette, &skinned);
+
+    REQUIRE(Near(skinned.position, glm::vec3(1.0f, 2.0f, 4.0f)));
+    REQUIRE(Near(skinned.normal, glm::vec3(0.0f, 0.0f, 1.0f)));
+    REQUIRE(skinned.texCoord[0] == 0.0f);
+    REQUIRE(skinned.tangent[3] == 1.0f);
+}
+
+TEST_CASE("VertexSkinning CPU reference cost", "[VertexSkinning][!benchmark]")
+{
+    auto layout = SkinnedVertexLayout::FromAttribKey(SkinnedKey);
+    std::vector<glm::mat4> palette(19);
+    for (size_t i = 0; i < palette.size(); ++i)
+        palette[i] = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f * i, 0.0f));
+
+    std::vector<std::byte> source;
+    for (uint16_t v = 0; v < 10000; ++v)
+    {
+        uint16_t joint = v % 18;
+        AppendVertex(source, layout, { glm::vec3(0.001f * v, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f),
+            glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), { joint, static_cast<uint16_t>(joint + 1), 0, 0 }, glm::vec4(0.7f, 0.3f, 0.0f, 0.0f) });
+    }
+
+    // what the G-buffer pass and every shadow cascade used to redo per vertex, now done once per frame
+    std::vector<PreskinnedVertex> skinned(10000);
+    BENCHMARK("Skin 10k vertices")
+    {
+        VertexSkinning::SkinVertices(source.data(), layout, 10000, palette.data(), skinned.data());
+        return skinned[0].position[0];
+    };
+}